@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+ * @file BenchVm.h
+ * @brief Minimal Squirrel VM fixture shared by the script microbenchmarks.
+ */
+
+#include "script/VmAllocator.h"
+#include <cstring>
+#include <squirrel.h>
+#include <sqstdmath.h>
+
+namespace arcanee::bench {
+
+/**
+ * @brief Bare VM with its own arena, no VFS and no ARCANEE API.
+ */
+class BenchVm {
+public:
+  BenchVm() : m_scope(&m_allocator) {
+    m_vm = sq_open(1024);
+    sq_pushroottable(m_vm);
+    sqstd_register_mathlib(m_vm);
+    sq_pop(m_vm, 1);
+  }
+
+  ~BenchVm() { sq_close(m_vm); }
+
+  BenchVm(const BenchVm &) = delete;
+  BenchVm &operator=(const BenchVm &) = delete;
+
+  HSQUIRRELVM vm() const { return m_vm; }
+
+  /// Compile and run a snippet in the root table. Returns false on error.
+  bool run(const char *source) {
+    if (SQ_FAILED(sq_compilebuffer(m_vm, source,
+                                   static_cast<SQInteger>(std::strlen(source)),
+                                   "bench", SQTrue))) {
+      return false;
+    }
+    sq_pushroottable(m_vm);
+    SQRESULT res = sq_call(m_vm, 1, SQFalse, SQTrue);
+    sq_pop(m_vm, 1);
+    return SQ_SUCCEEDED(res);
+  }
+
+private:
+  script::VmAllocator m_allocator;
+  script::VmAllocator::Scope m_scope;
+  HSQUIRRELVM m_vm = nullptr;
+};
+
+} // namespace arcanee::bench
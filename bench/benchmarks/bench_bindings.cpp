@@ -0,0 +1,103 @@
+/**
+ * @file bench_bindings.cpp
+ * @brief Per-call cost of generated (NativeCall) vs hand-written bindings.
+ *
+ * Metric: ns per script->native call, measured over a script loop of 1000
+ * calls so VM dispatch is included the way a cartridge would pay it.
+ *
+ * - HandWritten: sq_getfloat per argument, no arity or type checks (the
+ *                pre-generator gfx.* style).
+ * - Generated:   NativeCall<&fn>, with arity and type validation.
+ * - Empty:       lower bound, a native that reads nothing.
+ */
+
+#include "BenchVm.h"
+#include "script/BindingUtils.h"
+#include <benchmark/benchmark.h>
+#include <string>
+
+using arcanee::bench::BenchVm;
+using namespace arcanee::script;
+
+namespace {
+
+SQFloat g_sink = 0;
+
+SQInteger hand_rect(HSQUIRRELVM vm) {
+  SQFloat x, y, w, h;
+  sq_getfloat(vm, 2, &x);
+  sq_getfloat(vm, 3, &y);
+  sq_getfloat(vm, 4, &w);
+  sq_getfloat(vm, 5, &h);
+  g_sink += x + y + w + h;
+  return 0;
+}
+
+SQInteger hand_btn(HSQUIRRELVM vm) {
+  SQInteger code;
+  if (SQ_FAILED(sq_getinteger(vm, 2, &code)))
+    return sq_throwerror(vm, "Invalid argument");
+  sq_pushbool(vm, (code & 1) ? SQTrue : SQFalse);
+  return 1;
+}
+
+void gen_rect(SQFloat x, SQFloat y, SQFloat w, SQFloat h) {
+  g_sink += x + y + w + h;
+}
+
+bool gen_btn(SQInteger code) { return (code & 1) != 0; }
+
+SQInteger empty_fn(HSQUIRRELVM) { return 0; }
+
+constexpr NativeFunction kBenchFunctions[] = {
+    {"handRect", hand_rect},
+    {"handBtn", hand_btn},
+    {"genRect", NativeCall<gen_rect>},
+    {"genBtn", NativeCall<gen_btn>},
+    {"empty", empty_fn},
+};
+
+void runLoop(benchmark::State &state, const char *body) {
+  BenchVm bvm;
+  BindTable(bvm.vm(), "b", kBenchFunctions);
+  std::string src = "function bench() { for (local i = 0; i < 1000; i++) { ";
+  src += body;
+  src += " } }\nbench();";
+  if (!bvm.run(src.c_str())) {
+    state.SkipWithError("script failed");
+    return;
+  }
+
+  for (auto _ : state) {
+    bvm.run("bench();");
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+  benchmark::DoNotOptimize(g_sink);
+}
+
+void BM_Binding_Rect_HandWritten(benchmark::State &state) {
+  runLoop(state, "b.handRect(i, 2.0, 3.0, 4.0);");
+}
+BENCHMARK(BM_Binding_Rect_HandWritten);
+
+void BM_Binding_Rect_Generated(benchmark::State &state) {
+  runLoop(state, "b.genRect(i, 2.0, 3.0, 4.0);");
+}
+BENCHMARK(BM_Binding_Rect_Generated);
+
+void BM_Binding_Btn_HandWritten(benchmark::State &state) {
+  runLoop(state, "b.handBtn(i);");
+}
+BENCHMARK(BM_Binding_Btn_HandWritten);
+
+void BM_Binding_Btn_Generated(benchmark::State &state) {
+  runLoop(state, "b.genBtn(i);");
+}
+BENCHMARK(BM_Binding_Btn_Generated);
+
+void BM_Binding_Empty(benchmark::State &state) {
+  runLoop(state, "b.empty();");
+}
+BENCHMARK(BM_Binding_Empty);
+
+} // namespace
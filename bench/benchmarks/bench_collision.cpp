@@ -0,0 +1,49 @@
+/**
+ * @file bench_collision.cpp
+ * @brief Cost of one broadphase tick: move every body, rebuild the grid and
+ * collect the colliding pairs.
+ *
+ * Metric: ns per body (items = bodies). N 8x8 bodies drift through a square
+ * world sized for about four bodies per 64-unit cell, so a typical tick
+ * reports a few pairs per body.
+ */
+
+#include "common/Random.h"
+#include "physics/CollisionWorld.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+void BM_CollisionTick(benchmark::State &state) {
+  const size_t n = static_cast<size_t>(state.range(0));
+  const float side = std::sqrt(static_cast<float>(n) / 4.0f) * 64.0f;
+
+  arcanee::Xorshift128Plus rng(42);
+  std::vector<float> rects(n * 4);
+  std::vector<float> vel(n * 2);
+  for (size_t i = 0; i < n; ++i) {
+    rects[4 * i] = static_cast<float>(rng.randFloat()) * side;
+    rects[4 * i + 1] = static_cast<float>(rng.randFloat()) * side;
+    rects[4 * i + 2] = 8.0f;
+    rects[4 * i + 3] = 8.0f;
+    vel[2 * i] = static_cast<float>(rng.randFloat()) * 4.0f - 2.0f;
+    vel[2 * i + 1] = static_cast<float>(rng.randFloat()) * 4.0f - 2.0f;
+  }
+
+  arcanee::physics::CollisionWorld world(64.0f);
+  for (auto _ : state) {
+    for (size_t i = 0; i < n; ++i) {
+      rects[4 * i] = std::fmod(rects[4 * i] + vel[2 * i] + side, side);
+      rects[4 * i + 1] =
+          std::fmod(rects[4 * i + 1] + vel[2 * i + 1] + side, side);
+    }
+    world.update(rects.data(), static_cast<arcanee::u32>(n));
+    benchmark::DoNotOptimize(world.findPairs().data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CollisionTick)->Arg(1000)->Arg(10000);
+
+} // namespace
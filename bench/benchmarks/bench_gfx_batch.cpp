@@ -0,0 +1,134 @@
+/**
+ * @file bench_gfx_batch.cpp
+ * @brief Cost of drawing N particles per frame: one gfx call per particle vs
+ * one batched call.
+ *
+ * Metric: ns per frame (items = particles). Every variant produces the same
+ * picture: N opaque 2x2 rects of one color.
+ *
+ * Script side (no canvas bound, so this is VM + binding cost only):
+ * - Script_PerCall:     gfx.fillRect per particle
+ * - Script_ArrayBatch:  particle positions written into a flat array, then
+ *                       gfx.fillRects(array) once
+ *
+ * Raster side (ThorVG software canvas, what Canvas2D pushes per frame):
+ * - Raster_ShapePerRect: one tvg::Shape per rect (pre-batch Canvas2D)
+ * - Raster_MergedShape:  one shape holding every rect (Canvas2D::fillRects
+ *                        fast path for an opaque single-color run)
+ */
+
+#include "BenchVm.h"
+#include "script/api/GfxBinding.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <thorvg.h>
+#include <vector>
+
+using arcanee::bench::BenchVm;
+
+namespace {
+
+constexpr int kWidth = 640;
+constexpr int kHeight = 360;
+
+void setupParticles(BenchVm &bvm, int64_t count) {
+  arcanee::script::registerGfxBinding(bvm.vm());
+  std::string src = "N <- " + std::to_string(count) +
+                    ";\n"
+                    "xs <- array(N, 0.0); ys <- array(N, 0.0);\n"
+                    "rects <- array(N * 4, 2.0);\n"
+                    "for (local i = 0; i < N; i++) { xs[i] = (i * 7) % 640; "
+                    "ys[i] = (i * 13) % 360; }\n";
+  bvm.run(src.c_str());
+}
+
+void BM_GfxBatch_Script_PerCall(benchmark::State &state) {
+  BenchVm bvm;
+  setupParticles(bvm, state.range(0));
+  bvm.run("function frame() { for (local i = 0; i < N; i++) "
+          "gfx.fillRect(xs[i], ys[i], 2, 2); }");
+
+  for (auto _ : state) {
+    bvm.run("frame();");
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GfxBatch_Script_PerCall)->Arg(1000)->Arg(10000);
+
+void BM_GfxBatch_Script_ArrayBatch(benchmark::State &state) {
+  BenchVm bvm;
+  setupParticles(bvm, state.range(0));
+  bvm.run("function frame() { for (local i = 0, j = 0; i < N; i++, j += 4) "
+          "{ rects[j] = xs[i]; rects[j + 1] = ys[i]; } gfx.fillRects(rects); "
+          "}");
+
+  for (auto _ : state) {
+    bvm.run("frame();");
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GfxBatch_Script_ArrayBatch)->Arg(1000)->Arg(10000);
+
+class TvgCanvas {
+public:
+  TvgCanvas() : m_buffer(kWidth * kHeight) {
+    tvg::Initializer::init(tvg::CanvasEngine::Sw, 0);
+    m_canvas = tvg::SwCanvas::gen();
+    m_canvas->target(m_buffer.data(), kWidth, kWidth, kHeight,
+                     tvg::SwCanvas::ARGB8888);
+  }
+  ~TvgCanvas() {
+    m_canvas.reset();
+    tvg::Initializer::term(tvg::CanvasEngine::Sw);
+  }
+
+  tvg::SwCanvas &canvas() { return *m_canvas; }
+
+  void present() {
+    m_canvas->draw();
+    m_canvas->sync();
+    m_canvas->clear(true);
+  }
+
+private:
+  std::vector<uint32_t> m_buffer;
+  std::unique_ptr<tvg::SwCanvas> m_canvas;
+};
+
+void BM_GfxBatch_Raster_ShapePerRect(benchmark::State &state) {
+  TvgCanvas tvg;
+  const int64_t n = state.range(0);
+
+  for (auto _ : state) {
+    for (int64_t i = 0; i < n; ++i) {
+      auto shape = tvg::Shape::gen();
+      shape->appendRect(static_cast<float>((i * 7) % kWidth),
+                        static_cast<float>((i * 13) % kHeight), 2, 2);
+      shape->fill(255, 255, 255, 255);
+      tvg.canvas().push(std::move(shape));
+    }
+    tvg.present();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_GfxBatch_Raster_ShapePerRect)->Arg(1000)->Arg(10000);
+
+void BM_GfxBatch_Raster_MergedShape(benchmark::State &state) {
+  TvgCanvas tvg;
+  const int64_t n = state.range(0);
+
+  for (auto _ : state) {
+    auto shape = tvg::Shape::gen();
+    for (int64_t i = 0; i < n; ++i) {
+      shape->appendRect(static_cast<float>((i * 7) % kWidth),
+                        static_cast<float>((i * 13) % kHeight), 2, 2);
+    }
+    shape->fill(255, 255, 255, 255);
+    tvg.canvas().push(std::move(shape));
+    tvg.present();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_GfxBatch_Raster_MergedShape)->Arg(1000)->Arg(10000);
+
+} // namespace
@@ -0,0 +1,39 @@
+/**
+ * @file bench_heap_hash.cpp
+ * @brief Cost of hashing the reachable script heap (the per-tick
+ * determinism check).
+ *
+ * Metric: ns per hash (items = entities). The heap holds N entity tables
+ * with a few scalar fields and a shared "kind" table, plus a Float32Buffer
+ * of 4*N floats, which is the shape a typical cartridge keeps.
+ */
+
+#include "BenchVm.h"
+#include "script/HeapHash.h"
+#include "script/api/BufferBinding.h"
+#include <benchmark/benchmark.h>
+#include <string>
+
+using arcanee::bench::BenchVm;
+
+namespace {
+
+void BM_HeapHash(benchmark::State &state) {
+  BenchVm bvm;
+  arcanee::script::registerBufferBinding(bvm.vm());
+  std::string src = "N <- " + std::to_string(state.range(0)) + ";";
+  bvm.run(src.c_str());
+  bvm.run("kinds <- [{name = \"ship\", hp = 10}, {name = \"rock\", hp = 3}];\n"
+          "entities <- [];\n"
+          "for (local i = 0; i < N; i++) entities.append({x = i * 0.5, "
+          "y = 0.0, hp = 3, alive = true, kind = kinds[i % 2]});\n"
+          "particles <- buf.float32(N * 4);");
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(arcanee::script::hashVmHeap(bvm.vm()));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HeapHash)->Arg(1000)->Arg(10000);
+
+} // namespace
@@ -0,0 +1,178 @@
+/**
+ * @file bench_json.cpp
+ * @brief JSON parse and stringify throughput: native JsonCodec vs a JSON
+ * parser written in script, the way cartridges parse level data today.
+ *
+ * Metric: bytes of JSON text per second. The document is a level-like
+ * array of N objects (ids, coordinates, flags, names and dialog lines,
+ * some with escapes), about 200 bytes each.
+ *
+ * - Native: parseJson / writeJson on the VM stack.
+ * - Script: a recursive-descent parser in Squirrel reading one character
+ *           at a time (strings, numbers, literals, arrays, objects).
+ */
+
+#include "BenchVm.h"
+#include "script/JsonCodec.h"
+#include <benchmark/benchmark.h>
+#include <string>
+
+using arcanee::bench::BenchVm;
+using arcanee::script::JsonWriteOptions;
+using arcanee::script::parseJson;
+using arcanee::script::writeJson;
+
+namespace {
+
+std::string makeDocument(int n) {
+  std::string doc = "[";
+  for (int i = 0; i < n; ++i) {
+    if (i != 0)
+      doc += ",\n";
+    doc += "{\"id\": " + std::to_string(i) +
+           ", \"x\": " + std::to_string(i * 0.5) +
+           ", \"y\": " + std::to_string(i % 97) +
+           ", \"solid\": " + (i % 3 ? "true" : "false") +
+           ", \"name\": \"npc_" + std::to_string(i % 50) +
+           "\", \"line\": \"Welcome, traveller! The road north is "
+           "closed until the \\\"bridge\\\" is repaired.\", "
+           "\"tags\": [\"town\", \"quest\", null]}";
+  }
+  doc += "]";
+  return doc;
+}
+
+constexpr const char *kScriptParser = R"(
+class ScriptJson {
+  s = null; i = 0;
+  function parse(text) { s = text; i = 0; return value(); }
+  function space() {
+    while (i < s.len()) {
+      local c = s[i];
+      if (c != ' ' && c != '\n' && c != '\r' && c != '\t') break;
+      ++i;
+    }
+  }
+  function value() {
+    space();
+    local c = s[i];
+    if (c == '{') return object();
+    if (c == '[') return array();
+    if (c == '"') return str();
+    if (c == 't') { i += 4; return true; }
+    if (c == 'f') { i += 5; return false; }
+    if (c == 'n') { i += 4; return null; }
+    return number();
+  }
+  function object() {
+    local t = {};
+    ++i; space();
+    if (s[i] == '}') { ++i; return t; }
+    while (true) {
+      space();
+      local k = str();
+      space(); ++i; // :
+      t[k] <- value();
+      space();
+      if (s[i++] == '}') return t;
+    }
+  }
+  function array() {
+    local a = [];
+    ++i; space();
+    if (s[i] == ']') { ++i; return a; }
+    while (true) {
+      a.append(value());
+      space();
+      if (s[i++] == ']') return a;
+    }
+  }
+  function str() {
+    local out = "";
+    ++i;
+    while (true) {
+      local c = s[i++];
+      if (c == '"') return out;
+      if (c == '\\') {
+        c = s[i++];
+        if (c == 'n') c = '\n';
+        else if (c == 't') c = '\t';
+      }
+      out += c.tochar();
+    }
+  }
+  function number() {
+    local start = i, isFloat = false;
+    while (i < s.len()) {
+      local c = s[i];
+      if (c == '.' || c == 'e' || c == 'E') isFloat = true;
+      else if (c != '-' && c != '+' && (c < '0' || c > '9')) break;
+      ++i;
+    }
+    local t = s.slice(start, i);
+    return isFloat ? t.tofloat() : t.tointeger();
+  }
+}
+scriptJson <- ScriptJson();
+)";
+
+void BM_JsonParseNative(benchmark::State &state) {
+  BenchVm bvm;
+  std::string doc = makeDocument(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    SQInteger top = sq_gettop(bvm.vm());
+    if (!parseJson(bvm.vm(), doc.data(), doc.size()).ok()) {
+      state.SkipWithError("parse failed");
+      return;
+    }
+    sq_settop(bvm.vm(), top);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(doc.size()));
+}
+BENCHMARK(BM_JsonParseNative)->Arg(1000)->Arg(10000);
+
+void BM_JsonStringifyNative(benchmark::State &state) {
+  BenchVm bvm;
+  std::string doc = makeDocument(static_cast<int>(state.range(0)));
+  if (!parseJson(bvm.vm(), doc.data(), doc.size()).ok()) {
+    state.SkipWithError("parse failed");
+    return;
+  }
+  std::string out;
+  for (auto _ : state) {
+    out.clear();
+    writeJson(bvm.vm(), -1, JsonWriteOptions(), out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(out.size()));
+}
+BENCHMARK(BM_JsonStringifyNative)->Arg(1000)->Arg(10000);
+
+void BM_JsonParseScript(benchmark::State &state) {
+  BenchVm bvm;
+  std::string doc = makeDocument(static_cast<int>(state.range(0)));
+  if (!bvm.run(kScriptParser)) {
+    state.SkipWithError("script failed");
+    return;
+  }
+  // The document as a root string, so the loop only measures parsing
+  sq_pushroottable(bvm.vm());
+  sq_pushstring(bvm.vm(), "doc", -1);
+  sq_pushstring(bvm.vm(), doc.data(), static_cast<SQInteger>(doc.size()));
+  sq_newslot(bvm.vm(), -3, SQFalse);
+  sq_pop(bvm.vm(), 1);
+
+  for (auto _ : state) {
+    if (!bvm.run("scriptJson.parse(doc);")) {
+      state.SkipWithError("script failed");
+      return;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(doc.size()));
+}
+BENCHMARK(BM_JsonParseScript)->Arg(1000);
+
+} // namespace
@@ -0,0 +1,97 @@
+/**
+ * @file bench_math.cpp
+ * @brief Cost of a per-entity vector update loop: script tables vs native
+ * math values vs one bulk call.
+ *
+ * Metric: ns per tick (items = entities). Every variant computes
+ * pos += vel * dt for N 2D entities.
+ *
+ * - ScriptTable:  vec2 as {x, y} tables, `p = add(p, scale(v, dt))`
+ *                 (what cartridges write today; two tables per entity)
+ * - NativeOps:    math.vec2 values, `p = p + v * dt` (two userdata)
+ * - NativeInPlace: p.addScaledIn(v, dt), no allocation
+ * - Bulk:         positions/velocities in Float32Buffers,
+ *                 math.addScaled(pos, vel, dt) once per tick
+ */
+
+#include "BenchVm.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/MathBinding.h"
+#include <benchmark/benchmark.h>
+#include <string>
+
+using arcanee::bench::BenchVm;
+
+namespace {
+
+void setup(BenchVm &bvm, int64_t count) {
+  arcanee::script::registerBufferBinding(bvm.vm());
+  arcanee::script::registerMathBinding(bvm.vm());
+  std::string src = "N <- " + std::to_string(count) + "; dt <- 0.016;";
+  bvm.run(src.c_str());
+}
+
+void BM_Math_ScriptTable(benchmark::State &state) {
+  BenchVm bvm;
+  setup(bvm, state.range(0));
+  bvm.run("function add(a, b) { return {x = a.x + b.x, y = a.y + b.y}; }\n"
+          "function scale(a, s) { return {x = a.x * s, y = a.y * s}; }\n"
+          "pos <- []; vel <- [];\n"
+          "for (local i = 0; i < N; i++) { pos.append({x = i, y = 0.0}); "
+          "vel.append({x = 1.0, y = 2.0}); }\n"
+          "function tick() { for (local i = 0; i < N; i++) "
+          "pos[i] = add(pos[i], scale(vel[i], dt)); }");
+
+  for (auto _ : state) {
+    bvm.run("tick();");
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Math_ScriptTable)->Arg(1000)->Arg(10000);
+
+void BM_Math_NativeOps(benchmark::State &state) {
+  BenchVm bvm;
+  setup(bvm, state.range(0));
+  bvm.run("pos <- []; vel <- [];\n"
+          "for (local i = 0; i < N; i++) { pos.append(math.vec2(i, 0)); "
+          "vel.append(math.vec2(1, 2)); }\n"
+          "function tick() { for (local i = 0; i < N; i++) "
+          "pos[i] = pos[i] + vel[i] * dt; }");
+
+  for (auto _ : state) {
+    bvm.run("tick();");
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Math_NativeOps)->Arg(1000)->Arg(10000);
+
+void BM_Math_NativeInPlace(benchmark::State &state) {
+  BenchVm bvm;
+  setup(bvm, state.range(0));
+  bvm.run("pos <- []; vel <- [];\n"
+          "for (local i = 0; i < N; i++) { pos.append(math.vec2(i, 0)); "
+          "vel.append(math.vec2(1, 2)); }\n"
+          "function tick() { for (local i = 0; i < N; i++) "
+          "pos[i].addScaledIn(vel[i], dt); }");
+
+  for (auto _ : state) {
+    bvm.run("tick();");
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Math_NativeInPlace)->Arg(1000)->Arg(10000);
+
+void BM_Math_Bulk(benchmark::State &state) {
+  BenchVm bvm;
+  setup(bvm, state.range(0));
+  bvm.run("pos <- buf.float32(N * 2); vel <- buf.float32(N * 2).fill(1.5);\n"
+          "function tick() { math.addScaled(pos, vel, dt); }");
+
+  for (auto _ : state) {
+    bvm.run("tick();");
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Math_Bulk)->Arg(1000)->Arg(10000);
+
+} // namespace
@@ -0,0 +1,49 @@
+/**
+ * @file bench_noise.cpp
+ * @brief Cost of filling a 256 x 256 block with each noise kernel (one and
+ * four octaves), and of bulk random fills.
+ *
+ * Metric: ns per sample (items = samples written).
+ */
+
+#include "procgen/BulkRandom.h"
+#include "procgen/Noise.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using arcanee::f32;
+using arcanee::u32;
+using arcanee::procgen::NoiseParams;
+using arcanee::procgen::NoiseType;
+
+namespace {
+
+constexpr u32 kSize = 256;
+
+void BM_NoiseFill(benchmark::State &state) {
+  NoiseParams p;
+  p.type = static_cast<NoiseType>(state.range(0));
+  p.octaves = static_cast<u32>(state.range(1));
+  std::vector<f32> out(kSize * kSize);
+  for (auto _ : state) {
+    arcanee::procgen::fillNoise(p, 0.0f, 0.0f, kSize, kSize, out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kSize * kSize);
+}
+BENCHMARK(BM_NoiseFill)
+    ->ArgNames({"type", "octaves"})
+    ->ArgsProduct({{0, 1, 2, 3}, {1, 4}});
+
+void BM_RandomFillFloat(benchmark::State &state) {
+  arcanee::procgen::Xorshift128PlusX4 rng(1);
+  std::vector<f32> out(kSize * kSize);
+  for (auto _ : state) {
+    rng.fillFloat(out.data(), out.size());
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kSize * kSize);
+}
+BENCHMARK(BM_RandomFillFloat);
+
+} // namespace
@@ -0,0 +1,62 @@
+/**
+ * @file bench_pathfinding.cpp
+ * @brief Cost of grid searches on large maps: one corner-to-corner A* path,
+ * and one flow field over the whole grid.
+ *
+ * Metric: ns per cell (items = grid cells). Grids are N x N with costs 1-4
+ * and about 15% of the cells walled off, from a fixed seed; the corners are
+ * kept open.
+ */
+
+#include "common/Random.h"
+#include "nav/Pathfinder.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using arcanee::u32;
+using arcanee::u8;
+using arcanee::nav::Pathfinder;
+
+namespace {
+
+u32 flowGoal(u32 n) { return n * n / 2 + n / 2; }
+
+void buildGrid(Pathfinder &pf, u32 n) {
+  arcanee::Xorshift128Plus rng(7);
+  pf.resetGrid(n, n);
+  std::vector<u8> costs(static_cast<size_t>(n) * n);
+  for (u8 &c : costs) {
+    c = rng.randRange(0, 99) < 15 ? 0 : static_cast<u8>(rng.randRange(1, 4));
+  }
+  costs.front() = 1;
+  costs.back() = 1;
+  costs[flowGoal(n)] = 1;
+  pf.grid().setCosts(costs.data());
+}
+
+void BM_PathfindAStar(benchmark::State &state) {
+  const u32 n = static_cast<u32>(state.range(0));
+  Pathfinder pf;
+  buildGrid(pf, n);
+  std::vector<u32> path;
+  u32 cost = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pf.findPath(0, n * n - 1, path, cost));
+  }
+  state.SetItemsProcessed(state.iterations() * n * n);
+}
+BENCHMARK(BM_PathfindAStar)->Arg(256)->Arg(1024);
+
+void BM_FlowField(benchmark::State &state) {
+  const u32 n = static_cast<u32>(state.range(0));
+  Pathfinder pf;
+  buildGrid(pf, n);
+  std::vector<u8> dirs(static_cast<size_t>(n) * n);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pf.flowField(flowGoal(n), dirs.data()));
+  }
+  state.SetItemsProcessed(state.iterations() * n * n);
+}
+BENCHMARK(BM_FlowField)->Arg(256)->Arg(1024);
+
+} // namespace
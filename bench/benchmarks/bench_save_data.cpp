@@ -0,0 +1,141 @@
+/**
+ * @file bench_save_data.cpp
+ * @brief Save and load of a multi-MB game state: hand-written text in
+ * script vs serial.* binary blobs.
+ *
+ * Metric: time per save or load of N entities (items = entities); the
+ * blob or text size is reported as the "bytes" counter.
+ *
+ * - Text:   the pattern cartridges use today: one formatted line per entity,
+ *           parsed back with split() and tointeger()/tofloat(). The lines
+ *           stay in an array, so the cost of joining them into one string
+ *           for fs.write is not counted and the text numbers are a lower
+ *           bound.
+ * - Binary: serial.encode / serial.decode, stored and zstd level 3.
+ */
+
+#include "BenchVm.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/SerialBinding.h"
+#include <benchmark/benchmark.h>
+#include <sqstdstring.h>
+#include <string>
+
+using arcanee::bench::BenchVm;
+
+namespace {
+
+constexpr const char *kState =
+    "function makeState(n) {"
+    "  local s = {version = 3, entities = []};"
+    "  for (local i = 0; i < n; ++i) {"
+    "    s.entities.append({id = i, x = i * 0.5, y = i * 0.25,"
+    "                       hp = 100 - i % 100, name = \"goblin\" + i % 32});"
+    "  }"
+    "  return s;"
+    "}"
+    "function saveText(s) {"
+    "  local lines = [\"\" + s.version];"
+    "  foreach (e in s.entities)"
+    "    lines.append(format(\"%d,%f,%f,%d,%s\", e.id, e.x, e.y, e.hp,"
+    "                        e.name));"
+    "  return lines;"
+    "}"
+    "function textBytes(lines) {"
+    "  local n = 0;"
+    "  foreach (l in lines) n += l.len() + 1;"
+    "  return n;"
+    "}"
+    "function loadText(lines) {"
+    "  local s = {version = lines[0].tointeger(), entities = []};"
+    "  for (local i = 1; i < lines.len(); ++i) {"
+    "    local f = split(lines[i], \",\");"
+    "    s.entities.append({id = f[0].tointeger(), x = f[1].tofloat(),"
+    "                       y = f[2].tofloat(), hp = f[3].tointeger(),"
+    "                       name = f[4]});"
+    "  }"
+    "  return s;"
+    "}";
+
+class SaveBench {
+public:
+  explicit SaveBench(benchmark::State &state) {
+    arcanee::script::registerBufferBinding(m_vm.vm());
+    arcanee::script::registerSerialBinding(m_vm.vm());
+    sq_pushroottable(m_vm.vm());
+    sqstd_register_stringlib(m_vm.vm());
+    sq_pop(m_vm.vm(), 1);
+    std::string src = kState;
+    src += "state <- makeState(" + std::to_string(state.range(0)) + ");";
+    if (!m_vm.run(src.c_str()))
+      state.SkipWithError("script failed");
+  }
+
+  // Runs @p body once per iteration; it leaves its byte count in "bytes"
+  void loop(benchmark::State &state, const std::string &setup,
+            const std::string &body) {
+    if (!m_vm.run(setup.c_str()) || !m_vm.run(body.c_str())) {
+      state.SkipWithError("script failed");
+      return;
+    }
+    for (auto _ : state)
+      m_vm.run(body.c_str());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["bytes"] = static_cast<double>(readBytes());
+  }
+
+private:
+  SQInteger readBytes() {
+    HSQUIRRELVM vm = m_vm.vm();
+    SQInteger n = 0;
+    sq_pushroottable(vm);
+    sq_pushstring(vm, "bytes", -1);
+    if (SQ_SUCCEEDED(sq_get(vm, -2))) {
+      sq_getinteger(vm, -1, &n);
+      sq_pop(vm, 1);
+    }
+    sq_pop(vm, 1);
+    return n;
+  }
+
+  BenchVm m_vm;
+};
+
+void BM_SaveText(benchmark::State &state) {
+  SaveBench(state).loop(state, "",
+                        "bytes <- textBytes(saveText(state));");
+}
+BENCHMARK(BM_SaveText)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+void BM_LoadText(benchmark::State &state) {
+  SaveBench(state).loop(state, "lines <- saveText(state);",
+                        "loadText(lines); bytes <- textBytes(lines);");
+}
+BENCHMARK(BM_LoadText)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+void BM_SaveBinary(benchmark::State &state) {
+  SaveBench(state).loop(state, "",
+                        "bytes <- serial.encode(state).len();");
+}
+BENCHMARK(BM_SaveBinary)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+void BM_LoadBinary(benchmark::State &state) {
+  SaveBench(state).loop(state, "blob <- serial.encode(state);",
+                        "serial.decode(blob); bytes <- blob.len();");
+}
+BENCHMARK(BM_LoadBinary)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+void BM_SaveBinaryZstd(benchmark::State &state) {
+  SaveBench(state).loop(
+      state, "", "bytes <- serial.encode(state, {compress = true}).len();");
+}
+BENCHMARK(BM_SaveBinaryZstd)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+void BM_LoadBinaryZstd(benchmark::State &state) {
+  SaveBench(state).loop(state,
+                        "blob <- serial.encode(state, {compress = true});",
+                        "serial.decode(blob); bytes <- blob.len();");
+}
+BENCHMARK(BM_LoadBinaryZstd)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,162 @@
+/**
+ * @file bench_script_calls.cpp
+ * @brief Per-tick cost of invoking the cartridge update(dt) and draw(alpha)
+ * entry points.
+ *
+ * Metric: ns per call (budget: entry dispatch must stay well under 1 us so
+ * it is negligible against the 16.6 ms frame).
+ *
+ * Baselines, on the engine's VM without its scopes:
+ * - EntryCall_ByName:  the pre-cache dispatch (pushstring + sq_get).
+ * - EntryCall_Cached:  calling a held closure; the dispatch lower bound.
+ *
+ * The real entry paths (arena reset, allocator and watchdog scopes, entry
+ * point cache, call):
+ * - CallUpdate_Locals: update() writes no root slot, so the cached closure
+ *                      is called without a root table lookup.
+ * - CallUpdate_Global: update() bumps a root global every tick, which moves
+ *                      the root table's write version and costs one lookup
+ *                      before the next call.
+ * - CallDraw:          the draw() path, with no root slot writes.
+ *
+ * The range argument is the number of extra globals in the root table.
+ */
+
+#include "script/ScriptEngine.h"
+#include "vfs/Vfs.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace fs = std::filesystem;
+using arcanee::script::ScriptEngine;
+
+namespace {
+
+/// A cartridge directory holding one main.nut, run by a real ScriptEngine.
+class BenchEngine {
+public:
+  BenchEngine(const std::string &entries, int64_t extraGlobals) {
+    m_dir = fs::temp_directory_path() / "arcanee_bench_script_calls";
+    fs::create_directories(m_dir);
+    {
+      std::ofstream out(m_dir / "main.nut");
+      for (int64_t i = 0; i < extraGlobals; ++i)
+        out << "g_value" << i << " <- " << i << ";\n";
+      out << "counter <- 0;\n" << entries << "\n";
+    }
+
+    arcanee::vfs::VfsConfig config;
+    config.cartridgePath = m_dir.string();
+    m_vfs = arcanee::vfs::createVfs();
+    m_ok = m_vfs->init(config) && m_engine.initialize(m_vfs.get()) &&
+           m_engine.executeScript("cart:/main.nut");
+  }
+
+  ~BenchEngine() {
+    m_engine.shutdown();
+    fs::remove_all(m_dir);
+  }
+
+  bool ok() const { return m_ok; }
+  ScriptEngine &engine() { return m_engine; }
+
+private:
+  fs::path m_dir;
+  std::unique_ptr<arcanee::vfs::IVfs> m_vfs;
+  ScriptEngine m_engine;
+  bool m_ok = false;
+};
+
+constexpr const char *kLocals = "function update(dt) { local t = dt * 2; }"
+                                "function draw(alpha) { local a = alpha; }";
+constexpr const char *kGlobal = "function update(dt) { counter++; }"
+                                "function draw(alpha) { local a = alpha; }";
+
+void BM_EntryCall_ByName(benchmark::State &state) {
+  BenchEngine bench(kLocals, state.range(0));
+  if (!bench.ok()) {
+    state.SkipWithError("script failed");
+    return;
+  }
+  HSQUIRRELVM vm = bench.engine().getVm();
+  for (auto _ : state) {
+    sq_pushroottable(vm);
+    sq_pushstring(vm, "update", -1);
+    sq_get(vm, -2);
+    sq_pushroottable(vm);
+    sq_pushfloat(vm, 1.0f / 60.0f);
+    sq_call(vm, 2, SQFalse, SQTrue);
+    sq_pop(vm, 2);
+  }
+}
+BENCHMARK(BM_EntryCall_ByName)->Arg(0)->Arg(256);
+
+void BM_EntryCall_Cached(benchmark::State &state) {
+  BenchEngine bench(kLocals, state.range(0));
+  if (!bench.ok()) {
+    state.SkipWithError("script failed");
+    return;
+  }
+  HSQUIRRELVM vm = bench.engine().getVm();
+  HSQOBJECT closure;
+  sq_pushroottable(vm);
+  sq_pushstring(vm, "update", -1);
+  sq_get(vm, -2);
+  sq_getstackobj(vm, -1, &closure);
+  sq_addref(vm, &closure);
+  sq_pop(vm, 2);
+
+  for (auto _ : state) {
+    sq_pushobject(vm, closure);
+    sq_pushroottable(vm);
+    sq_pushfloat(vm, 1.0f / 60.0f);
+    sq_call(vm, 2, SQFalse, SQTrue);
+    sq_pop(vm, 1);
+  }
+  sq_release(vm, &closure);
+}
+BENCHMARK(BM_EntryCall_Cached)->Arg(0)->Arg(256);
+
+void runUpdates(benchmark::State &state, const char *entries) {
+  BenchEngine bench(entries, state.range(0));
+  if (!bench.ok()) {
+    state.SkipWithError("script failed");
+    return;
+  }
+  for (auto _ : state) {
+    if (!bench.engine().callUpdate(1.0 / 60.0)) {
+      state.SkipWithError("update failed");
+      break;
+    }
+  }
+}
+
+void BM_CallUpdate_Locals(benchmark::State &state) {
+  runUpdates(state, kLocals);
+}
+BENCHMARK(BM_CallUpdate_Locals)->Arg(0)->Arg(256);
+
+void BM_CallUpdate_Global(benchmark::State &state) {
+  runUpdates(state, kGlobal);
+}
+BENCHMARK(BM_CallUpdate_Global)->Arg(0)->Arg(256);
+
+void BM_CallDraw(benchmark::State &state) {
+  BenchEngine bench(kLocals, state.range(0));
+  if (!bench.ok()) {
+    state.SkipWithError("script failed");
+    return;
+  }
+  for (auto _ : state) {
+    if (!bench.engine().callDraw(1.0)) {
+      state.SkipWithError("draw failed");
+      break;
+    }
+  }
+}
+BENCHMARK(BM_CallDraw)->Arg(0)->Arg(256);
+
+} // namespace
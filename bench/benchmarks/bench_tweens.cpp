@@ -0,0 +1,132 @@
+/**
+ * @file bench_tweens.cpp
+ * @brief Cost of a fixed tick of tweens: native TweenSystem vs the per-frame
+ * script loop UI-heavy cartridges run today.
+ *
+ * Metric: ns per tween (items = live tweens). Every tween runs a one second
+ * yoyo loop with one of four easings, writing a Float32 array slot, and
+ * sprite targets are measured separately since each write goes through a
+ * handle lookup.
+ *
+ * - Native: TweenSystem::step over float and sprite targets.
+ * - Script: an array of tween tables stepped in a Squirrel loop, the easing
+ *           picked by name.
+ */
+
+#include "BenchVm.h"
+#include "anim/TweenSystem.h"
+#include "render/SpriteStore.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+using arcanee::anim::Ease;
+using arcanee::anim::TweenSpec;
+using arcanee::anim::TweenSystem;
+using arcanee::anim::TweenTarget;
+using arcanee::bench::BenchVm;
+
+namespace {
+
+constexpr Ease kEases[] = {Ease::Linear, Ease::QuadOut, Ease::SineInOut,
+                           Ease::BackOut};
+
+TweenSpec loopSpec(arcanee::u32 i) {
+  TweenSpec spec;
+  spec.from = static_cast<float>(i % 100);
+  spec.to = spec.from + 50.0f;
+  spec.duration = 1.0f;
+  spec.ease = kEases[i % 4];
+  spec.repeat = -1;
+  spec.yoyo = true;
+  return spec;
+}
+
+void BM_TweenStepFloats(benchmark::State &state) {
+  const auto n = static_cast<arcanee::u32>(state.range(0));
+  std::vector<float> values(n);
+  TweenSystem tweens;
+  for (arcanee::u32 i = 0; i < n; ++i) {
+    TweenTarget target;
+    target.value = &values[i];
+    tweens.start(target, loopSpec(i));
+  }
+  for (auto _ : state) {
+    tweens.step(1.0f / 60.0f, nullptr);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TweenStepFloats)->Arg(1000)->Arg(100000);
+
+void BM_TweenStepSprites(benchmark::State &state) {
+  const auto n = static_cast<arcanee::u32>(state.range(0));
+  arcanee::render::SpriteStore sprites;
+  arcanee::render::SpriteSheet sheet;
+  sheet.frameW = sheet.frameH = 16;
+  arcanee::render::SpriteState s;
+  s.sheet = sprites.defineSheet(sheet);
+  TweenSystem tweens;
+  for (arcanee::u32 i = 0; i < n; ++i) {
+    TweenTarget target;
+    target.sprite = sprites.create(s);
+    target.property = i & 1 ? arcanee::render::SpriteProperty::Alpha
+                            : arcanee::render::SpriteProperty::X;
+    tweens.start(target, loopSpec(i));
+  }
+  for (auto _ : state) {
+    tweens.step(1.0f / 60.0f, &sprites);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TweenStepSprites)->Arg(1000)->Arg(100000);
+
+constexpr const char *kScriptTweens = R"(
+eases <- {
+  linear = @(t) t,
+  quadOut = @(t) 1 - (1 - t) * (1 - t),
+  sineInOut = @(t) 0.5 - 0.5 * cos(t * PI),
+  backOut = function(t) {
+    local u = 1 - t;
+    return 1 - u * u * (2.70158 * u - 1.70158);
+  }
+}
+names <- ["linear", "quadOut", "sineInOut", "backOut"];
+values <- array(count, 0.0);
+list <- [];
+for (local i = 0; i < count; ++i) {
+  local from = (i % 100).tofloat();
+  list.append({from = from, to = from + 50, duration = 1.0, t = 0.0,
+               ease = names[i % 4], slot = i});
+}
+function stepTweens(dt) {
+  foreach (tw in list) {
+    tw.t += dt;
+    if (tw.t >= 2 * tw.duration) tw.t -= 2 * tw.duration;
+    local p = tw.t / tw.duration;
+    if (p > 1) p = 2 - p;
+    values[tw.slot] = tw.from + (tw.to - tw.from) * eases[tw.ease](p);
+  }
+}
+)";
+
+void BM_TweenStepScript(benchmark::State &state) {
+  BenchVm bvm;
+  const std::string setup =
+      "count <- " + std::to_string(state.range(0)) + ";" + kScriptTweens;
+  if (!bvm.run(setup.c_str())) {
+    state.SkipWithError("script failed");
+    return;
+  }
+  for (auto _ : state) {
+    if (!bvm.run("stepTweens(1.0 / 60);")) {
+      state.SkipWithError("script failed");
+      return;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TweenStepScript)->Arg(1000);
+
+} // namespace
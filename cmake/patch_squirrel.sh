@@ -13,3 +13,295 @@ sed -i '/^  install(EXPORT/,/    )/s/^/#/' CMakeLists.txt
 find . -name "CMakeLists.txt" -exec sed -i 's/-gstabs//g' {} +
 
 
+# ----------------------------------------------------------------------------
+# Cooperative interrupt (used by the ARCANEE hang watchdog)
+#
+# Adds sq_setthreadinterrupt(word, hook, user): while *word is non-zero the VM
+# calls hook(v, user) at every backward jump and every script call; the hook
+# may raise an error (sq_throwerror) to unwind the script. With no word
+# installed the cost is one thread-local load per loop iteration/call.
+# ----------------------------------------------------------------------------
+if ! grep -q "sq_setthreadinterrupt" include/squirrel.h; then
+    sed -i 's/^SQUIRREL_API void sq_setnativedebughook(HSQUIRRELVM v,SQDEBUGHOOK hook);/&\
+typedef SQRESULT (*SQINTERRUPTHOOK)(HSQUIRRELVM v,SQUserPointer user);\
+SQUIRREL_API void sq_setthreadinterrupt(volatile SQInteger *word,SQINTERRUPTHOOK hook,SQUserPointer user);/' include/squirrel.h
+
+    sed -i 's/^#include "sqvm.h"/&\
+\
+struct SQInterruptState { volatile SQInteger *word; SQINTERRUPTHOOK hook; SQUserPointer user; };\
+static thread_local SQInterruptState _sq_interrupt = { NULL, NULL, NULL };\
+void sq_setthreadinterrupt(volatile SQInteger *word,SQINTERRUPTHOOK hook,SQUserPointer user)\
+{\
+    _sq_interrupt.word = word; _sq_interrupt.hook = hook; _sq_interrupt.user = user;\
+}\
+#define SQ_INTERRUPT_PENDING() (_sq_interrupt.word \&\& *_sq_interrupt.word)\
+static bool _sq_dispatchinterrupt(SQVM *v)\
+{\
+    return !_sq_interrupt.hook || SQ_SUCCEEDED(_sq_interrupt.hook(v, _sq_interrupt.user));\
+}/' squirrel/sqvm.cpp
+
+    # Poll on backward jumps (loops)
+    sed -i 's/case _OP_JMP:[[:space:]]*ci->_ip[[:space:]]*+=[[:space:]]*(sarg1);[[:space:]]*continue;/case _OP_JMP: if(sarg1 < 0 \&\& SQ_INTERRUPT_PENDING() \&\& !_sq_dispatchinterrupt(this)) { SQ_THROW(); } ci->_ip += (sarg1); continue;/' squirrel/sqvm.cpp
+
+    # Poll on script calls (recursion)
+    sed -z -i 's/\(bool SQVM::StartCall([^)]*)[[:space:]]*{\)/\1\n    if(SQ_INTERRUPT_PENDING() \&\& !_sq_dispatchinterrupt(this)) return false;/' squirrel/sqvm.cpp
+
+    # Fail loudly if upstream changed under us
+    if ! grep -q "SQINTERRUPTHOOK" include/squirrel.h ||
+       [ "$(grep -c "_sq_dispatchinterrupt(this)" squirrel/sqvm.cpp)" -ne 2 ]; then
+        echo "patch_squirrel.sh: failed to apply interrupt patch" >&2
+        exit 1
+    fi
+fi
+
+# ----------------------------------------------------------------------------
+# Budgeted cycle collection (used by the ARCANEE idle-time GC)
+#
+# sq_gctrackedcount(v, limit) counts GC-tracked objects (tables, arrays,
+# closures, instances, ...), stopping once it passes limit (< 0: no limit).
+# sq_collectgarbagebudget(v, maxobjects) runs sq_collectgarbage only if at
+# most maxobjects are tracked, else returns SQ_GC_OVERBUDGET without
+# collecting. The collector is stop-the-world and its cost grows with the
+# tracked set, so the count is what a caller budgets against.
+# ----------------------------------------------------------------------------
+if ! grep -q "sq_collectgarbagebudget" include/squirrel.h; then
+    sed -i 's/^SQUIRREL_API SQInteger sq_collectgarbage(HSQUIRRELVM v);/&\
+#define SQ_GC_OVERBUDGET (-2)\
+SQUIRREL_API SQInteger sq_gctrackedcount(HSQUIRRELVM v,SQInteger limit);\
+SQUIRREL_API SQInteger sq_collectgarbagebudget(HSQUIRRELVM v,SQInteger maxobjects);/' include/squirrel.h
+
+    cat >> squirrel/sqapi.cpp <<'SQEOF'
+
+SQInteger sq_gctrackedcount(HSQUIRRELVM v,SQInteger limit)
+{
+#ifndef NO_GARBAGE_COLLECTOR
+    SQInteger n = 0;
+    for(SQCollectable *c = _ss(v)->_gc_chain; c && (limit < 0 || n <= limit); c = c->_next) n++;
+    return n;
+#else
+    (void)v; (void)limit;
+    return -1;
+#endif
+}
+
+SQInteger sq_collectgarbagebudget(HSQUIRRELVM v,SQInteger maxobjects)
+{
+#ifndef NO_GARBAGE_COLLECTOR
+    if(maxobjects >= 0 && sq_gctrackedcount(v, maxobjects) > maxobjects) return SQ_GC_OVERBUDGET;
+#endif
+    return sq_collectgarbage(v);
+}
+SQEOF
+
+    if ! grep -q "SQ_GC_OVERBUDGET" include/squirrel.h; then
+        echo "patch_squirrel.sh: failed to apply GC budget patch" >&2
+        exit 1
+    fi
+fi
+
+# ----------------------------------------------------------------------------
+# Closure state access (used by the ARCANEE VM snapshots)
+#
+# The stock API can serialize a closure only if it binds no free variables and
+# cannot rebuild one that does. These expose exactly what a snapshot needs:
+#   sq_getclosurecode(v, idx)          function prototype identity (or NULL)
+#   sq_writeclosurecode(v, idx, w, up) sq_writeclosure without the free
+#                                      variable check; read with sq_readclosure
+#   sq_newclosurelike(v, idx)          push a closure sharing idx's code, with
+#                                      its free variables unbound
+#   sq_getfreevariablecell(v, idx, n)  identity of the cell behind free var n;
+#                                      closures capturing one local share it
+#   sq_newfreevariablecell(v, idx, n)  bind free var n to a new closed cell
+#                                      holding the popped value
+#   sq_sharefreevariablecell(v, idx, n, src, srcn)
+#                                      bind free var n to src's cell srcn
+#   sq_getdefaultparamcount/sq_getdefaultparam/sq_setdefaultparam
+#                                      default parameter values, which are
+#                                      evaluated when the closure is created
+#   sq_getclassmetamethod(v, idx, name) push a class's metamethod (or null);
+#                                      metamethods are not iterable members
+# A closure fresh from sq_readclosure/sq_newclosurelike must have every free
+# variable bound before it is called.
+# ----------------------------------------------------------------------------
+if ! grep -q "sq_newclosurelike" include/squirrel.h; then
+    sed -i 's/^SQUIRREL_API SQRESULT sq_writeclosure(HSQUIRRELVM vm,SQWRITEFUNC writef,SQUserPointer up);/&\
+SQUIRREL_API SQUserPointer sq_getclosurecode(HSQUIRRELVM v,SQInteger idx);\
+SQUIRREL_API SQRESULT sq_writeclosurecode(HSQUIRRELVM v,SQInteger idx,SQWRITEFUNC w,SQUserPointer up);\
+SQUIRREL_API SQRESULT sq_newclosurelike(HSQUIRRELVM v,SQInteger idx);\
+SQUIRREL_API SQUserPointer sq_getfreevariablecell(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger nval);\
+SQUIRREL_API SQRESULT sq_newfreevariablecell(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger nval);\
+SQUIRREL_API SQRESULT sq_sharefreevariablecell(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger nval,SQInteger srcidx,SQUnsignedInteger srcnval);\
+SQUIRREL_API SQInteger sq_getdefaultparamcount(HSQUIRRELVM v,SQInteger idx);\
+SQUIRREL_API SQRESULT sq_getdefaultparam(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger n);\
+SQUIRREL_API SQRESULT sq_setdefaultparam(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger n);\
+SQUIRREL_API SQRESULT sq_getclassmetamethod(HSQUIRRELVM v,SQInteger idx,const SQChar *name);/' include/squirrel.h
+
+    cat >> squirrel/sqapi.cpp <<'SQEOF'
+
+static SQClosure *_sq_scriptclosure(HSQUIRRELVM v,SQInteger idx)
+{
+    SQObjectPtr &o = stack_get(v,idx);
+    return o._type == OT_CLOSURE ? _closure(o) : NULL;
+}
+
+static bool _sq_hasfreevariable(SQClosure *c,SQUnsignedInteger nval)
+{
+    return c && nval < (SQUnsignedInteger)c->_function->_noutervalues;
+}
+
+SQUserPointer sq_getclosurecode(HSQUIRRELVM v,SQInteger idx)
+{
+    SQClosure *c = _sq_scriptclosure(v,idx);
+    return c ? (SQUserPointer)c->_function : NULL;
+}
+
+SQRESULT sq_writeclosurecode(HSQUIRRELVM v,SQInteger idx,SQWRITEFUNC w,SQUserPointer up)
+{
+    SQClosure *c = _sq_scriptclosure(v,idx);
+    if(!c) return sq_throwerror(v,_SC("closure expected"));
+    unsigned short tag = SQ_BYTECODE_STREAM_TAG;
+    if(w(up,&tag,2) != 2)
+        return sq_throwerror(v,_SC("io error"));
+    if(!c->Save(v,up,w))
+        return SQ_ERROR;
+    return SQ_OK;
+}
+
+SQRESULT sq_newclosurelike(HSQUIRRELVM v,SQInteger idx)
+{
+    SQClosure *c = _sq_scriptclosure(v,idx);
+    if(!c) return sq_throwerror(v,_SC("closure expected"));
+    v->Push(SQObjectPtr(SQClosure::Create(_ss(v),c->_function,c->_root)));
+    return SQ_OK;
+}
+
+SQUserPointer sq_getfreevariablecell(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger nval)
+{
+    SQClosure *c = _sq_scriptclosure(v,idx);
+    if(!_sq_hasfreevariable(c,nval) || c->_outervalues[nval]._type != OT_OUTER)
+        return NULL;
+    return (SQUserPointer)_outer(c->_outervalues[nval]);
+}
+
+SQRESULT sq_newfreevariablecell(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger nval)
+{
+    SQClosure *c = _sq_scriptclosure(v,idx);
+    if(!_sq_hasfreevariable(c,nval))
+        return sq_throwerror(v,_SC("invalid free variable index"));
+    SQOuter *cell = SQOuter::Create(_ss(v),NULL);
+    cell->_value = v->GetUp(-1);
+    cell->_valptr = &cell->_value;
+    c->_outervalues[nval] = SQObjectPtr(cell);
+    v->Pop();
+    return SQ_OK;
+}
+
+SQRESULT sq_sharefreevariablecell(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger nval,SQInteger srcidx,SQUnsignedInteger srcnval)
+{
+    SQClosure *c = _sq_scriptclosure(v,idx);
+    SQClosure *src = _sq_scriptclosure(v,srcidx);
+    if(!_sq_hasfreevariable(c,nval) || !_sq_hasfreevariable(src,srcnval) ||
+       src->_outervalues[srcnval]._type != OT_OUTER)
+        return sq_throwerror(v,_SC("invalid free variable index"));
+    c->_outervalues[nval] = src->_outervalues[srcnval];
+    return SQ_OK;
+}
+
+SQInteger sq_getdefaultparamcount(HSQUIRRELVM v,SQInteger idx)
+{
+    SQClosure *c = _sq_scriptclosure(v,idx);
+    return c ? c->_function->_ndefaultparams : -1;
+}
+
+SQRESULT sq_getdefaultparam(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger n)
+{
+    SQClosure *c = _sq_scriptclosure(v,idx);
+    if(!c || n >= (SQUnsignedInteger)c->_function->_ndefaultparams)
+        return sq_throwerror(v,_SC("invalid default parameter index"));
+    v->Push(c->_defaultparams[n]);
+    return SQ_OK;
+}
+
+SQRESULT sq_setdefaultparam(HSQUIRRELVM v,SQInteger idx,SQUnsignedInteger n)
+{
+    SQClosure *c = _sq_scriptclosure(v,idx);
+    if(!c || n >= (SQUnsignedInteger)c->_function->_ndefaultparams)
+        return sq_throwerror(v,_SC("invalid default parameter index"));
+    c->_defaultparams[n] = v->GetUp(-1);
+    v->Pop();
+    return SQ_OK;
+}
+
+SQRESULT sq_getclassmetamethod(HSQUIRRELVM v,SQInteger idx,const SQChar *name)
+{
+    SQObjectPtr &o = stack_get(v,idx);
+    if(o._type != OT_CLASS)
+        return sq_throwerror(v,_SC("class expected"));
+    SQInteger mm = _ss(v)->GetMetaMethodIdxByName(SQObjectPtr(SQString::Create(_ss(v),name,-1)));
+    if(mm == -1)
+        return sq_throwerror(v,_SC("not a metamethod"));
+    v->Push(_class(o)->_metamethods[mm]);
+    return SQ_OK;
+}
+SQEOF
+
+    if ! grep -q "sq_newclosurelike" include/squirrel.h; then
+        echo "patch_squirrel.sh: failed to apply closure state patch" >&2
+        exit 1
+    fi
+fi
+
+# ----------------------------------------------------------------------------
+# Table write version (used by the ARCANEE entry point cache)
+#
+# Every table counts writes to its slots (new slot, set, remove, clear);
+# sq_gettableversion(o) returns the count of the table o refers to, or 0 for
+# any other type. A host holding a value it read from a table can tell with
+# one load whether the table may have changed since. Failed sets are counted
+# too, which only makes the check conservative.
+# ----------------------------------------------------------------------------
+if ! grep -q "sq_gettableversion" include/squirrel.h; then
+    sed -i 's/^SQUIRREL_API SQRESULT sq_rawset(HSQUIRRELVM v,SQInteger idx);/&\
+SQUIRREL_API SQUnsignedInteger sq_gettableversion(const HSQOBJECT *o);/' include/squirrel.h
+
+    sed -i 's/^\([[:space:]]*\)SQInteger _usednodes;/&\
+public:\
+\1SQUnsignedInteger _version = 0;\
+private:/' squirrel/sqtable.h
+
+    for fn in 'bool SQTable::Set' 'bool SQTable::NewSlot' 'void SQTable::Remove' 'void SQTable::Clear'; do
+        sed -z -i "s/\($fn([^)]*)[[:space:]]*{\)/\1\n    _version++;/" squirrel/sqtable.cpp
+    done
+
+    cat >> squirrel/sqapi.cpp <<'SQEOF'
+
+SQUnsignedInteger sq_gettableversion(const HSQOBJECT *o)
+{
+    return sq_type(*o) == OT_TABLE ? _table(*o)->_version : 0;
+}
+SQEOF
+
+    if ! grep -q "sq_gettableversion" include/squirrel.h ||
+       ! grep -q "_version = 0;" squirrel/sqtable.h ||
+       [ "$(grep -c "_version++;" squirrel/sqtable.cpp)" -ne 4 ]; then
+        echo "patch_squirrel.sh: failed to apply table version patch" >&2
+        exit 1
+    fi
+fi
+
+# ----------------------------------------------------------------------------
+# Patch level (used by the ARCANEE bytecode cache key)
+#
+# Bump whenever a patch above changes the VM, so host-side caches keyed on
+# SQUIRREL_VERSION_NUMBER + SQ_ARCANEE_PATCH_LEVEL drop entries written by a
+# differently patched VM. Rewritten on every run, unlike the guarded patches.
+# ----------------------------------------------------------------------------
+SQ_ARCANEE_PATCH_LEVEL=4
+sed -i '/^#define SQ_ARCANEE_PATCH_LEVEL /d' include/squirrel.h
+sed -i "s/^#define SQUIRREL_VERSION_NUMBER.*/&\\
+#define SQ_ARCANEE_PATCH_LEVEL $SQ_ARCANEE_PATCH_LEVEL/" include/squirrel.h
+
+if ! grep -q "^#define SQ_ARCANEE_PATCH_LEVEL $SQ_ARCANEE_PATCH_LEVEL\$" include/squirrel.h; then
+    echo "patch_squirrel.sh: failed to set the patch level" >&2
+    exit 1
+fi
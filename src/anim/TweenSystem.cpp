@@ -0,0 +1,281 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file TweenSystem.cpp
+ */
+
+#include "TweenSystem.h"
+#include <cmath>
+
+namespace arcanee::anim {
+
+namespace {
+
+constexpr u32 kGenerationMask = (1u << (32 - TweenSystem::kSlotBits)) - 1;
+constexpr f32 kPi = 3.14159265358979f;
+constexpr f32 kBack = 1.70158f;
+constexpr f32 kBackInOut = kBack * 1.525f;
+
+enum : u8 { kIdle, kWrite, kDone, kLost };
+
+u32 makeHandle(u32 slot, u32 generation) {
+  return (generation << TweenSystem::kSlotBits) | (slot + 1);
+}
+
+// Invalidates every handle to the slot. False once the generation is used
+// up: wrapping it would revive handles issued long ago.
+bool nextGeneration(u16 &generation) {
+  if (generation == kGenerationMask)
+    return false;
+  ++generation;
+  return true;
+}
+
+template <typename... Arrays> void removeSwap(u32 i, Arrays &...arrays) {
+  ((arrays[i] = arrays.back(), arrays.pop_back()), ...);
+}
+
+template <typename... Arrays> void clearAll(Arrays &...arrays) {
+  (arrays.clear(), ...);
+}
+
+f32 bounceOut(f32 t) {
+  constexpr f32 n = 7.5625f;
+  constexpr f32 d = 2.75f;
+  if (t < 1.0f / d)
+    return n * t * t;
+  if (t < 2.0f / d) {
+    t -= 1.5f / d;
+    return n * t * t + 0.75f;
+  }
+  if (t < 2.5f / d) {
+    t -= 2.25f / d;
+    return n * t * t + 0.9375f;
+  }
+  t -= 2.625f / d;
+  return n * t * t + 0.984375f;
+}
+
+} // namespace
+
+f32 evaluateEase(Ease ease, f32 t) {
+  const f32 u = 1.0f - t;
+  switch (ease) {
+  case Ease::Linear:
+    return t;
+  case Ease::QuadIn:
+    return t * t;
+  case Ease::QuadOut:
+    return 1.0f - u * u;
+  case Ease::QuadInOut:
+    return t < 0.5f ? 2.0f * t * t : 1.0f - 2.0f * u * u;
+  case Ease::CubicIn:
+    return t * t * t;
+  case Ease::CubicOut:
+    return 1.0f - u * u * u;
+  case Ease::CubicInOut:
+    return t < 0.5f ? 4.0f * t * t * t : 1.0f - 4.0f * u * u * u;
+  case Ease::SineIn:
+    return 1.0f - std::cos(t * kPi * 0.5f);
+  case Ease::SineOut:
+    return std::sin(t * kPi * 0.5f);
+  case Ease::SineInOut:
+    return 0.5f - 0.5f * std::cos(t * kPi);
+  case Ease::ExpoIn:
+    return t <= 0.0f ? 0.0f : std::exp2(10.0f * t - 10.0f);
+  case Ease::ExpoOut:
+    return t >= 1.0f ? 1.0f : 1.0f - std::exp2(-10.0f * t);
+  case Ease::ExpoInOut:
+    if (t <= 0.0f || t >= 1.0f)
+      return t <= 0.0f ? 0.0f : 1.0f;
+    return t < 0.5f ? 0.5f * std::exp2(20.0f * t - 10.0f)
+                    : 1.0f - 0.5f * std::exp2(10.0f - 20.0f * t);
+  case Ease::BackIn:
+    return t * t * ((kBack + 1.0f) * t - kBack);
+  case Ease::BackOut:
+    return 1.0f - u * u * ((kBack + 1.0f) * u - kBack);
+  case Ease::BackInOut: {
+    const f32 s = t < 0.5f ? 2.0f * t : 2.0f * u;
+    const f32 half = 0.5f * s * s * ((kBackInOut + 1.0f) * s - kBackInOut);
+    return t < 0.5f ? half : 1.0f - half;
+  }
+  case Ease::ElasticOut:
+    if (t <= 0.0f || t >= 1.0f)
+      return t <= 0.0f ? 0.0f : 1.0f;
+    return std::exp2(-10.0f * t) *
+               std::sin((10.0f * t - 0.75f) * (2.0f * kPi / 3.0f)) +
+           1.0f;
+  case Ease::BounceOut:
+    return bounceOut(t);
+  }
+  return t;
+}
+
+u32 TweenSystem::start(const TweenTarget &target, const TweenSpec &spec) {
+  if (!target.value && target.sprite == 0)
+    return 0;
+
+  u32 slot;
+  if (!m_freeSlots.empty()) {
+    slot = m_freeSlots.front();
+    m_freeSlots.pop_front();
+  } else if (m_denseOf.size() < kMaxTweens) {
+    slot = static_cast<u32>(m_denseOf.size());
+    m_denseOf.push_back(kNone);
+    m_generation.push_back(1);
+  } else {
+    return 0;
+  }
+
+  m_denseOf[slot] = count();
+  m_slotOf.push_back(slot);
+  m_value.push_back(target.value);
+  m_sprite.push_back(target.value ? 0 : target.sprite);
+  m_property.push_back(target.property);
+  m_from.push_back(spec.from);
+  m_to.push_back(spec.to);
+  m_duration.push_back(spec.duration > 0.0f ? spec.duration : 0.0f);
+  m_elapsed.push_back(spec.delay > 0.0f ? -spec.delay : 0.0f);
+  m_ease.push_back(spec.ease);
+  m_repeat.push_back(spec.repeat < 0 ? -1 : spec.repeat);
+  m_yoyo.push_back(spec.yoyo ? 1 : 0);
+  m_fromCurrent.push_back(spec.fromCurrent ? 1 : 0);
+  return makeHandle(slot, m_generation[slot]);
+}
+
+bool TweenSystem::cancel(u32 handle) {
+  u32 i = denseIndex(handle);
+  if (i == kNone)
+    return false;
+  remove(i);
+  return true;
+}
+
+bool TweenSystem::alive(u32 handle) const {
+  return denseIndex(handle) != kNone;
+}
+
+void TweenSystem::clear() {
+  // Retire the slots instead of forgetting them, so handles issued before
+  // the clear stay invalid afterwards
+  for (u32 slot : m_slotOf)
+    releaseSlot(slot);
+  clearAll(m_finished);
+  clearAll(m_slotOf, m_value, m_sprite, m_property, m_from, m_to,
+           m_duration, m_elapsed, m_ease, m_repeat, m_yoyo, m_fromCurrent,
+           m_current, m_state);
+}
+
+u32 TweenSystem::denseIndex(u32 handle) const {
+  u32 slot = (handle & kMaxTweens) - 1;
+  if (slot >= m_denseOf.size() ||
+      m_generation[slot] != handle >> kSlotBits) {
+    return kNone;
+  }
+  return m_denseOf[slot];
+}
+
+void TweenSystem::remove(u32 i) {
+  u32 slot = m_slotOf[i];
+  m_denseOf[m_slotOf.back()] = i;
+  removeSwap(i, m_slotOf, m_value, m_sprite, m_property, m_from, m_to,
+             m_duration, m_elapsed, m_ease, m_repeat, m_yoyo, m_fromCurrent);
+  releaseSlot(slot);
+}
+
+void TweenSystem::releaseSlot(u32 slot) {
+  m_denseOf[slot] = kNone;
+  // Oldest first, as in SpriteStore; a used-up slot is never reused
+  if (nextGeneration(m_generation[slot]))
+    m_freeSlots.push_back(slot);
+}
+
+void TweenSystem::step(f32 dt, render::SpriteStore *sprites) {
+  const u32 n = count();
+  m_current.resize(n);
+  m_state.resize(n);
+
+  // Evaluate every curve
+  for (u32 i = 0; i < n; ++i) {
+    f32 e = m_elapsed[i] + dt;
+    if (e < 0.0f) {
+      m_elapsed[i] = e;
+      m_state[i] = kIdle;
+      continue;
+    }
+    if (m_fromCurrent[i]) {
+      bool read = m_value[i] != nullptr;
+      if (read)
+        m_from[i] = *m_value[i];
+      else
+        read = sprites && sprites->getProperty(m_sprite[i], m_property[i],
+                                               m_from[i]);
+      if (!read) {
+        m_state[i] = kLost;
+        continue;
+      }
+      m_fromCurrent[i] = 0;
+    }
+
+    const f32 d = m_duration[i];
+    const i32 repeat = m_repeat[i];
+    f32 t = 1.0f;
+    i64 run = repeat < 0 ? 0 : repeat;
+    bool done = repeat >= 0;
+    if (d > 0.0f) {
+      if (repeat < 0) {
+        // Wrap so the timer keeps its precision on endless tweens
+        const f32 period = m_yoyo[i] ? 2.0f * d : d;
+        if (e >= period)
+          e = std::fmod(e, period);
+      }
+      const i64 at = static_cast<i64>(e / d);
+      if (repeat < 0 || at <= repeat) {
+        run = at;
+        t = (e - static_cast<f32>(at) * d) / d;
+        done = false;
+      }
+    }
+    if (m_yoyo[i] && (run & 1))
+      t = 1.0f - t;
+
+    m_elapsed[i] = e;
+    m_current[i] =
+        m_from[i] + (m_to[i] - m_from[i]) * evaluateEase(m_ease[i], t);
+    m_state[i] = done ? kDone : kWrite;
+  }
+
+  // Write every target
+  for (u32 i = 0; i < n; ++i) {
+    if (m_state[i] != kWrite && m_state[i] != kDone)
+      continue;
+    if (m_value[i]) {
+      *m_value[i] = m_current[i];
+    } else if (!sprites || !sprites->setProperty(m_sprite[i], m_property[i],
+                                                 m_current[i])) {
+      m_state[i] = kLost;
+    }
+  }
+
+  // Queue the ended tweens, then drop them from the back so the swaps only
+  // move tweens already visited
+  for (u32 i = 0; i < n; ++i) {
+    if (m_state[i] == kDone || m_state[i] == kLost) {
+      m_finished.push_back(
+          {makeHandle(m_slotOf[i], m_generation[m_slotOf[i]]),
+           m_state[i] == kDone});
+    }
+  }
+  for (u32 i = n; i-- > 0;) {
+    if (m_state[i] == kDone || m_state[i] == kLost)
+      remove(i);
+  }
+}
+
+} // namespace arcanee::anim
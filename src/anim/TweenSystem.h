@@ -0,0 +1,144 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file TweenSystem.h
+ * @brief Native tweens of float targets, evaluated in bulk on the fixed tick.
+ */
+
+#include "common/Types.h"
+#include "render/SpriteStore.h"
+#include <deque>
+#include <vector>
+
+namespace arcanee::anim {
+
+/**
+ * @brief Easing curves: t in [0, 1] to eased progress (Back, Elastic and
+ * Bounce leave [0, 1] in between, but all start at 0 and end at 1).
+ */
+enum class Ease : u8 {
+  Linear,
+  QuadIn,
+  QuadOut,
+  QuadInOut,
+  CubicIn,
+  CubicOut,
+  CubicInOut,
+  SineIn,
+  SineOut,
+  SineInOut,
+  ExpoIn,
+  ExpoOut,
+  ExpoInOut,
+  BackIn,
+  BackOut,
+  BackInOut,
+  ElasticOut,
+  BounceOut,
+};
+
+f32 evaluateEase(Ease ease, f32 t);
+
+/**
+ * @brief What a tween writes: a float in memory, or a property of a sprite.
+ *
+ * A float target must stay valid until the tween ends; the caller keeps its
+ * owner alive. A sprite target is looked up through its handle every tick,
+ * and the tween ends (not completed) once the sprite is freed.
+ */
+struct TweenTarget {
+  f32 *value = nullptr; ///< Used if set
+  u32 sprite = 0;       ///< Otherwise a SpriteStore handle
+  render::SpriteProperty property = render::SpriteProperty::X;
+};
+
+struct TweenSpec {
+  f32 from = 0.0f;
+  f32 to = 0.0f;
+  f32 duration = 0.0f; ///< Seconds per run; 0 jumps straight to the end
+  f32 delay = 0.0f;    ///< Seconds before the first run
+  Ease ease = Ease::Linear;
+  i32 repeat = 0;           ///< Runs after the first; -1 repeats forever
+  bool yoyo = false;        ///< Every other run goes from to back to from
+  bool fromCurrent = false; ///< Ignore from; read the target when it starts
+};
+
+/**
+ * @brief Owns every tween of a cartridge.
+ *
+ * Tweens are packed into dense structure-of-arrays storage like SpriteStore
+ * (a removal moves the last tween into the hole) and carry slot+generation
+ * handles that are never reissued. step() advances all of them in straight loops: evaluate every
+ * curve, then write every target, then drop the tweens that ended. Nothing
+ * calls back into script here; ended tweens are queued in finished() for
+ * the owner to act on, so script cost scales with tweens started and
+ * finished, not with tweens alive.
+ */
+class TweenSystem {
+public:
+  static constexpr u32 kSlotBits = 20;
+  static constexpr u32 kMaxTweens = (1u << kSlotBits) - 1;
+
+  struct Finished {
+    u32 handle;
+    bool completed; ///< False if the target went away first
+  };
+
+  /// @return Handle (never 0), or 0 if the target is unset or the system is
+  /// full.
+  u32 start(const TweenTarget &target, const TweenSpec &spec);
+  /// Stop without queueing it as finished.
+  bool cancel(u32 handle);
+  bool alive(u32 handle) const;
+  /// Stop every tween and drop the finished queue.
+  void clear();
+
+  u32 count() const { return static_cast<u32>(m_slotOf.size()); }
+
+  /// Advance every tween by @p dt seconds and write its target.
+  void step(f32 dt, render::SpriteStore *sprites);
+
+  /// Tweens that ended in step(), oldest first; the owner empties it.
+  std::vector<Finished> &finished() { return m_finished; }
+
+private:
+  static constexpr u32 kNone = 0xFFFFFFFFu;
+
+  u32 denseIndex(u32 handle) const;
+  void remove(u32 i);
+  void releaseSlot(u32 slot);
+
+  // Slots: stable per tween, reused through the free list
+  std::vector<u32> m_denseOf;
+  std::vector<u16> m_generation;
+  std::deque<u32> m_freeSlots;
+
+  // Dense storage, [0, count())
+  std::vector<u32> m_slotOf;
+  std::vector<f32 *> m_value;
+  std::vector<u32> m_sprite;
+  std::vector<render::SpriteProperty> m_property;
+  std::vector<f32> m_from, m_to;
+  std::vector<f32> m_duration;
+  std::vector<f32> m_elapsed; // Negative while delayed
+  std::vector<Ease> m_ease;
+  std::vector<i32> m_repeat;
+  std::vector<u8> m_yoyo;
+  std::vector<u8> m_fromCurrent; // Cleared once the start value is read
+
+  // Per step, [0, count())
+  std::vector<f32> m_current;
+  std::vector<u8> m_state;
+
+  std::vector<Finished> m_finished;
+};
+
+} // namespace arcanee::anim
@@ -21,6 +21,8 @@
 #include <SDL2/SDL.h>
 #include <algorithm>
 #include <cmath>
+#include <filesystem>
+#include <fstream>
 
 namespace arcanee::app {
 // ============================================================================
@@ -32,6 +34,11 @@ constexpr double kDtFixed = 1.0 / kTickHz;
 constexpr int kMaxUpdatesPerFrame = 4;
 constexpr double kMaxFrameTime = 0.25; // [REQ-30] Latency protection
 
+// Script GC: time kept back for present, and the fixed cadence used when
+// there is no frame clock (headless runs must stay deterministic)
+constexpr double kGcPresentReserve = 0.002;
+constexpr int kHeadlessGcInterval = 60;
+
 // ============================================================================
 // Implementation [REQ-01] Core Baseline
 // ============================================================================
@@ -45,6 +52,11 @@ Runtime::Runtime(const Config &config) : m_isHeadless(false) {
 
   initSubsystems();
 
+  if (!config.profileOutPath.empty() && m_scriptEngine) {
+    m_profileOutPath = config.profileOutPath;
+    m_scriptEngine->startProfiler();
+  }
+
   // Load cartridge
   if (!config.cartridgePath.empty()) {
     if (!loadCartridge(config.cartridgePath)) {
@@ -55,11 +67,48 @@ Runtime::Runtime(const Config &config) : m_isHeadless(false) {
 }
 
 Runtime::~Runtime() {
+  writeProfile();
   script::setAudioVfs(nullptr); // Added
   audio::setAudioManager(nullptr);
   shutdownSubsystems();
 }
 
+void Runtime::writeProfile() {
+  if (m_profileOutPath.empty() || !m_scriptEngine)
+    return;
+  m_scriptEngine->stopProfiler();
+  const auto &profiler = m_scriptEngine->getProfiler();
+
+  std::string collapsedPath = m_profileOutPath + ".collapsed";
+  std::ofstream collapsed(collapsedPath);
+  if (collapsed) {
+    profiler.writeCollapsed(collapsed);
+    LOG_INFO("Profile: wrote %s", collapsedPath.c_str());
+  } else {
+    LOG_ERROR("Profile: cannot write %s", collapsedPath.c_str());
+  }
+
+  std::string tracePath = m_profileOutPath + ".trace.json";
+  std::ofstream trace(tracePath);
+  if (trace) {
+    profiler.writeChromeTrace(trace);
+    LOG_INFO("Profile: wrote %s", tracePath.c_str());
+  } else {
+    LOG_ERROR("Profile: cannot write %s", tracePath.c_str());
+  }
+
+  auto functions = profiler.getFunctionStats();
+  u64 samples = profiler.getStats().samples;
+  for (size_t i = 0; i < functions.size() && i < 10; ++i) {
+    const auto &f = functions[i];
+    LOG_INFO("Profile: %5.1f%% self %5.1f%% total  %s (%s:%d)",
+             samples ? 100.0 * f.selfSamples / samples : 0.0,
+             samples ? 100.0 * f.totalSamples / samples : 0.0,
+             f.function.c_str(), f.source.c_str(), f.line);
+  }
+  m_profileOutPath.clear();
+}
+
 void Runtime::initSubsystems() {
   LOG_INFO("Runtime: Initializing subsystems");
 
@@ -269,6 +318,7 @@ int Runtime::run() {
 
   while (m_isRunning && !m_window->shouldClose()) {
     // 1. Timing
+    m_frameStart = platform::Time::now();
     double frameTime = frameTimer.lap();
     if (frameTime > kMaxFrameTime)
       frameTime = kMaxFrameTime;
@@ -285,6 +335,11 @@ int Runtime::run() {
     if (m_pendingStart) {
       startCartridge();
     }
+    if (m_pendingRestart) {
+      restartCartridge();
+    } else if (m_pendingReload) {
+      reloadModules();
+    }
 
     // Benchmark Check
     if (m_isBenchmark) {
@@ -351,14 +406,16 @@ int Runtime::runHeadless(int ticks) {
     if (m_inputManager)
       m_inputManager->update();
     update(kDtFixed);
+    // Counted across calls so runHeadless(1) x N collects like runHeadless(N)
+    if (m_scriptEngine && ++m_headlessTicks % kHeadlessGcInterval == 0)
+      m_scriptEngine->collectGarbage();
   }
   return 0;
 }
 
 u64 Runtime::getSimStateHash() const {
-  // Simplistic hash: Tick Count + Input State
-  // Ideally this hashes VM memory (stack/heap).
-  u64 hash = 0;
+  // Script heap + input state
+  u64 hash = m_scriptEngine ? m_scriptEngine->hashHeap() : 0;
   if (m_inputManager) {
     const auto &snap = m_inputManager->getCurrentSnapshot();
     // Hash some key inputs
@@ -476,12 +533,41 @@ void Runtime::draw(f64 alpha) {
     m_workbench->render(m_renderDevice.get());
   }
 
-  // 6. Present swapchain
+  // 6. Collect script garbage before present blocks on vsync
+  collectIdleGarbage();
+
+  // 7. Present swapchain
   if (m_renderDevice) {
     m_renderDevice->present();
   }
 }
 
+void Runtime::collectIdleGarbage() {
+  if (!m_scriptEngine || !m_cartridge)
+    return;
+
+  // Whatever the tick has left after update and draw
+  f64 budget = kDtFixed - (platform::Time::now() - m_frameStart) -
+               kGcPresentReserve;
+  m_scriptEngine->collectIdleGarbage(budget);
+
+  // Once a second, summarize what the collector did
+  if (++m_gcReportFrames < static_cast<u64>(kTickHz))
+    return;
+  m_gcReportFrames = 0;
+  const auto &gc = m_scriptEngine->getGcStats();
+  if (gc.collections == m_gcReportedCollections)
+    return;
+  m_gcReportedCollections = gc.collections;
+  LOG_DEBUG("Script GC: last %.3fms, %llu freed, %llu tracked, %.2f MB heap "
+            "(%llu collections, %llu forced, %llu deferred)",
+            gc.lastSec * 1000.0, (unsigned long long)gc.lastFreed,
+            (unsigned long long)gc.trackedObjects,
+            gc.heapBytes / (1024.0 * 1024.0),
+            (unsigned long long)gc.collections,
+            (unsigned long long)gc.forced, (unsigned long long)gc.deferred);
+}
+
 // ----------------------------------------------------------------------------
 // Cartridge Loading
 // ----------------------------------------------------------------------------
@@ -565,6 +651,50 @@ bool Runtime::stopCartridge() {
   return res;
 }
 
+bool Runtime::reloadModules() {
+  m_pendingReload = false;
+  if (!isCartridgeLoaded())
+    return false;
+
+  script::ScriptEngine::ReloadStats stats;
+  Status status = m_scriptEngine->reloadModules(&stats);
+  LOG_INFO("Runtime: Reloaded %u of %u modules (%u failed) in %.2fms",
+           stats.reloaded, stats.checked, stats.failed,
+           stats.seconds * 1000.0);
+  return status.ok();
+}
+
+bool Runtime::restartCartridge() {
+  m_pendingRestart = false;
+  m_pendingReload = false;
+  bool wasRunning = isCartridgeRunning();
+  if (!stopCartridge())
+    return false;
+  return !wasRunning || startCartridge();
+}
+
+void Runtime::scheduleScriptReload(const std::string &hostPath) {
+  if (!isCartridgeLoaded() || m_currentCartridgePath.empty())
+    return;
+
+  namespace fs = std::filesystem;
+  std::error_code fileEc, cartEc;
+  fs::path file = fs::weakly_canonical(hostPath, fileEc);
+  fs::path cart = fs::weakly_canonical(m_currentCartridgePath, cartEc);
+  fs::path rel = file.lexically_relative(cart);
+  if (fileEc || cartEc || rel.empty() || *rel.begin() == "..")
+    return; // Not part of this cartridge
+
+  std::string vfsPath = "cart:/" + rel.generic_string();
+  if (m_scriptEngine->isModuleLoaded(vfsPath)) {
+    m_pendingReload = true;
+  } else {
+    LOG_INFO("Runtime: %s is not a loaded module, restarting cartridge",
+             vfsPath.c_str());
+    m_pendingRestart = true;
+  }
+}
+
 bool Runtime::isCartridgeLoaded() const {
   if (!m_cartridge)
     return false;
@@ -44,6 +44,7 @@ public:
     std::string cartridgePath;
     bool enableBenchmark = false;
     int benchmarkFrames = 600;
+    std::string profileOutPath; // Non-empty: sample scripts, write on exit
   };
 
   explicit Runtime(const Config &config);
@@ -61,6 +62,12 @@ public:
   void scheduleStartCartridge(); // Schedule start for next main loop iteration
                                  // (safe for UI callbacks)
   bool stopCartridge();          // Stop execution and reload (reset)
+  bool reloadModules();          // Re-run changed modules, keeping state
+  bool restartCartridge();       // Reload, and start again if it was running
+  // At the next safe point: reloadModules() if @p hostPath is a loaded
+  // module of the cartridge, restartCartridge() if it is any other file of
+  // it (the main script, files not required yet)
+  void scheduleScriptReload(const std::string &hostPath);
   bool isCartridgeLoaded() const;
   bool isCartridgeRunning() const;
 
@@ -97,7 +104,18 @@ private:
   bool m_isBenchmark = false;
   bool m_isPaused = false;
   bool m_pendingStart = false;
+  bool m_pendingReload = false;
+  bool m_pendingRestart = false;
   int m_benchmarkFrames = 0;
+  std::string m_profileOutPath;
+  void writeProfile();
+
+  // Script cycle collection in the idle part of each frame
+  f64 m_frameStart = 0.0;
+  u64 m_gcReportFrames = 0;
+  u64 m_gcReportedCollections = 0;
+  u64 m_headlessTicks = 0;
+  void collectIdleGarbage();
 
   // Subsystems
   std::unique_ptr<platform::Window> m_window;
@@ -157,6 +157,12 @@ bool Workbench::initialize(render::RenderDevice *device,
   m_uiShell->SetStopCartridgeFn(
       [this]() { return m_runtime && m_runtime->stopCartridge(); });
 
+  m_uiShell->SetReloadModulesFn([this](const std::string &path) {
+    if (m_runtime) {
+      m_runtime->scheduleScriptReload(path);
+    }
+  });
+
   m_uiShell->SetClearPreviewFn([this]() {
     if (m_runtime && m_runtime->getCanvas2D()) {
       m_runtime->getCanvas2D()->beginFrame();
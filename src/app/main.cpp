@@ -58,6 +58,10 @@ int main(int argc, char *argv[]) {
         config.enableBenchmark = true;
         config.benchmarkFrames = 100;
         LOG_INFO("Arg: Benchmark enabled (100 frames)");
+      } else if (arg == "--profile" && i + 1 < argc) {
+        config.profileOutPath = argv[++i];
+        LOG_INFO("Arg: Script profile -> %s.{collapsed,trace.json}",
+                 config.profileOutPath.c_str());
       } else {
         config.cartridgePath = arg;
         cartPathSet = true;
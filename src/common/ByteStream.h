@@ -0,0 +1,150 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include "Types.h"
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace arcanee {
+
+// Little-endian binary encoding shared by the host-side blob formats.
+// Counts and ids are LEB128 varints; signed integers are zigzag varints.
+class ByteWriter {
+public:
+  explicit ByteWriter(std::vector<u8> &out) : m_out(out) {}
+
+  void writeU8(u8 v) { m_out.push_back(v); }
+
+  void writeU32(u32 v) {
+    for (int i = 0; i < 4; ++i)
+      m_out.push_back(static_cast<u8>(v >> (8 * i)));
+  }
+
+  void writeU64(u64 v) {
+    for (int i = 0; i < 8; ++i)
+      m_out.push_back(static_cast<u8>(v >> (8 * i)));
+  }
+
+  void writeF64(f64 v) {
+    u64 bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    writeU64(bits);
+  }
+
+  void writeVarint(u64 v) {
+    while (v >= 0x80) {
+      m_out.push_back(static_cast<u8>(v | 0x80));
+      v >>= 7;
+    }
+    m_out.push_back(static_cast<u8>(v));
+  }
+
+  void writeSigned(i64 v) {
+    writeVarint((static_cast<u64>(v) << 1) ^ static_cast<u64>(v >> 63));
+  }
+
+  void writeBytes(const void *data, size_t size) {
+    const u8 *p = static_cast<const u8 *>(data);
+    m_out.insert(m_out.end(), p, p + size);
+  }
+
+  size_t size() const { return m_out.size(); }
+
+private:
+  std::vector<u8> &m_out;
+};
+
+// Reads what ByteWriter wrote. Running past the end (or an overlong varint)
+// latches ok() to false and yields zeros, so callers check once at the end.
+class ByteReader {
+public:
+  ByteReader(const u8 *data, size_t size) : m_data(data), m_size(size) {}
+
+  bool ok() const { return m_ok; }
+  size_t remaining() const { return m_size - m_pos; }
+
+  u8 readU8() {
+    if (!need(1))
+      return 0;
+    return m_data[m_pos++];
+  }
+
+  u32 readU32() {
+    if (!need(4))
+      return 0;
+    u32 v = 0;
+    for (int i = 0; i < 4; ++i)
+      v |= static_cast<u32>(m_data[m_pos++]) << (8 * i);
+    return v;
+  }
+
+  u64 readU64() {
+    if (!need(8))
+      return 0;
+    u64 v = 0;
+    for (int i = 0; i < 8; ++i)
+      v |= static_cast<u64>(m_data[m_pos++]) << (8 * i);
+    return v;
+  }
+
+  f64 readF64() {
+    u64 bits = readU64();
+    f64 v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+
+  u64 readVarint() {
+    u64 v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (!need(1))
+        return 0;
+      u8 b = m_data[m_pos++];
+      v |= static_cast<u64>(b & 0x7f) << shift;
+      if (!(b & 0x80))
+        return v;
+    }
+    m_ok = false;
+    return 0;
+  }
+
+  i64 readSigned() {
+    u64 v = readVarint();
+    return static_cast<i64>((v >> 1) ^ (~(v & 1) + 1));
+  }
+
+  /// Pointer to the next @p size bytes (consumed), or null past the end.
+  const u8 *readBytes(size_t size) {
+    if (!need(size))
+      return nullptr;
+    const u8 *p = m_data + m_pos;
+    m_pos += size;
+    return p;
+  }
+
+private:
+  bool need(size_t n) {
+    if (!m_ok || n > m_size - m_pos) {
+      m_ok = false;
+      return false;
+    }
+    return true;
+  }
+
+  const u8 *m_data;
+  size_t m_size;
+  size_t m_pos = 0;
+  bool m_ok = true;
+};
+
+} // namespace arcanee
@@ -0,0 +1,151 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include "Types.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace arcanee {
+
+// Bump allocator for per-frame temporaries (binding scratch, ThorVG inputs).
+// Nothing is freed individually: a Scope rewinds to where it started, and
+// reset() at the start of a frame makes the whole arena reusable. When a
+// frame outgrows the arena, extra blocks are chained on; reset() then folds
+// them into a single block, so a steady workload stops touching the heap
+// after its first frames. Not thread-safe; only trivially destructible
+// objects may live in it.
+class FrameArena {
+public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  struct Stats {
+    size_t capacity = 0;     ///< Bytes reserved from the heap
+    size_t used = 0;         ///< Bytes handed out since the last reset
+    size_t peak = 0;         ///< High-water mark of used
+    u64 heapAllocations = 0; ///< Blocks ever reserved
+  };
+
+  explicit FrameArena(size_t blockSize = kDefaultBlockSize)
+      : m_blockSize(blockSize) {}
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  void *allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+    for (;;) {
+      if (m_block < m_blocks.size()) {
+        Block &block = m_blocks[m_block];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        size_t start = ((base + m_offset + align - 1) & ~(align - 1)) - base;
+        if (start + size <= block.size) {
+          m_offset = start + size;
+          m_stats.used = m_usedBefore + m_offset;
+          m_stats.peak = std::max(m_stats.peak, m_stats.used);
+          return block.data.get() + start;
+        }
+        m_usedBefore += block.size;
+        m_block++;
+        m_offset = 0;
+        continue;
+      }
+      addBlock(std::max(m_blockSize, size + align));
+    }
+  }
+
+  template <typename T> T *allocArray(size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "arena memory is released without running destructors");
+    return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+  }
+
+  // Copy of @p s with a terminating NUL, valid until the next rewind/reset
+  std::string_view copyString(std::string_view s) {
+    char *p = allocArray<char>(s.size() + 1);
+    std::memcpy(p, s.data(), s.size());
+    p[s.size()] = '\0';
+    return std::string_view(p, s.size());
+  }
+
+  // Make every byte reusable. Blocks chained on during the last frame are
+  // merged so the next frame of the same size fits in one block.
+  void reset() {
+    if (m_blocks.size() > 1) {
+      size_t total = m_stats.capacity;
+      m_blocks.clear();
+      m_stats.capacity = 0;
+      addBlock(total);
+    }
+    m_block = 0;
+    m_offset = 0;
+    m_usedBefore = 0;
+    m_stats.used = 0;
+  }
+
+  struct Marker {
+    size_t block = 0;
+    size_t offset = 0;
+    size_t usedBefore = 0;
+  };
+
+  Marker mark() const { return {m_block, m_offset, m_usedBefore}; }
+
+  void rewind(const Marker &marker) {
+    m_block = marker.block;
+    m_offset = marker.offset;
+    m_usedBefore = marker.usedBefore;
+    m_stats.used = m_usedBefore + m_offset;
+  }
+
+  // Temporaries of one call: everything allocated in the scope is given
+  // back when it ends
+  class Scope {
+  public:
+    explicit Scope(FrameArena &arena) : m_arena(arena), m_mark(arena.mark()) {}
+    ~Scope() { m_arena.rewind(m_mark); }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    FrameArena &m_arena;
+    Marker m_mark;
+  };
+
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  struct Block {
+    std::unique_ptr<u8[]> data;
+    size_t size = 0;
+  };
+
+  void addBlock(size_t size) {
+    m_blocks.push_back({std::make_unique<u8[]>(size), size});
+    m_stats.capacity += size;
+    m_stats.heapAllocations++;
+  }
+
+  size_t m_blockSize;
+  std::vector<Block> m_blocks;
+  size_t m_block = 0;      // Block being bumped
+  size_t m_offset = 0;     // Bytes used in m_blocks[m_block]
+  size_t m_usedBefore = 0; // Capacity of the blocks before m_block
+  Stats m_stats;
+};
+
+} // namespace arcanee
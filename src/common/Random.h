@@ -60,6 +60,28 @@ public:
     return min + static_cast<i32>(next() % range);
   }
 
+  // Advance by 2^64 calls to next(), giving a stream that never overlaps
+  // this one for 2^64 values. Used to split one seed into parallel streams.
+  void jump() {
+    static constexpr u64 kJump[2] = {0x8a5cd789635d2dffULL,
+                                     0x121fd2155c472f96ULL};
+    u64 s0 = 0;
+    u64 s1 = 0;
+    for (u64 word : kJump) {
+      for (int b = 0; b < 64; ++b) {
+        if (word & (1ULL << b)) {
+          s0 ^= m_state[0];
+          s1 ^= m_state[1];
+        }
+        next();
+      }
+    }
+    m_state[0] = s0;
+    m_state[1] = s1;
+  }
+
+  u64 state(int word) const { return m_state[word]; }
+
 private:
   u64 m_state[2];
 
@@ -109,6 +109,14 @@ UIShell::UIShell(MainThreadQueue &queue) : m_queue(queue) {
     if (m_configSystem) {
       m_configSystem->OnIdeSavedFile(path);
     }
+    // Scripts of a loaded cartridge reload in place, or restart it when they
+    // are not loaded modules (the main script)
+    bool isScript = path.size() >= 4 &&
+                    path.compare(path.size() - 4, 4, ".nut") == 0;
+    if (isScript && m_reloadModulesFn && m_isCartridgeLoadedFn &&
+        m_isCartridgeLoadedFn()) {
+      m_reloadModulesFn(path);
+    }
   });
 }
 
@@ -109,6 +109,7 @@ private:
   std::function<bool(const std::string &)> m_loadCartridgeFn;
   std::function<bool()> m_startCartridgeFn;
   std::function<bool()> m_stopCartridgeFn;
+  std::function<void(const std::string &)> m_reloadModulesFn;
   std::function<bool()> m_isCartridgeLoadedFn;
   std::function<bool()> m_isCartridgeRunningFn;
 
@@ -138,6 +139,11 @@ public:
     m_stopCartridgeFn = std::move(fn);
   }
 
+  // Called with the path of a saved script, to hot-reload it
+  void SetReloadModulesFn(std::function<void(const std::string &)> fn) {
+    m_reloadModulesFn = std::move(fn);
+  }
+
   void SetIsCartridgeLoadedFn(std::function<bool()> fn) {
     m_isCartridgeLoadedFn = std::move(fn);
   }
@@ -0,0 +1,99 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file NavGrid.h
+ * @brief Cost grid searched by the Pathfinder.
+ */
+
+#include "common/Types.h"
+#include <algorithm>
+#include <vector>
+
+namespace arcanee::nav {
+
+/**
+ * @brief Row-major grid of one-byte movement costs.
+ *
+ * Cost 0 blocks a cell; 1-255 is the cost of stepping into it, times 10 for
+ * a straight step and 14 for a diagonal one. Costs stay integers so every
+ * search is exact and reproducible on any platform.
+ */
+class NavGrid {
+public:
+  static constexpr u8 kBlocked = 0;
+  static constexpr u32 kMaxCells = 1u << 20; // Keeps path costs within u32
+  static constexpr u32 kStraightStep = 10;
+  static constexpr u32 kDiagonalStep = 14;
+
+  /// Resize to @p width x @p height with every cell at cost 1. False (and
+  /// unchanged) if empty or larger than kMaxCells.
+  bool resize(u32 width, u32 height) {
+    if (width == 0 || height == 0 ||
+        static_cast<u64>(width) * height > kMaxCells) {
+      return false;
+    }
+    m_width = width;
+    m_height = height;
+    m_costs.assign(static_cast<size_t>(width) * height, 1);
+    m_minCost = 1;
+    return true;
+  }
+
+  /// Copy width * height costs.
+  void setCosts(const u8 *costs) {
+    std::copy(costs, costs + m_costs.size(), m_costs.begin());
+    updateMinCost();
+  }
+
+  void setCost(u32 x, u32 y, u8 cost) {
+    if (!contains(x, y))
+      return;
+    m_costs[index(x, y)] = cost;
+    if (cost != kBlocked && cost < m_minCost)
+      m_minCost = cost;
+  }
+
+  u8 getCost(u32 x, u32 y) const {
+    return contains(x, y) ? m_costs[index(x, y)] : kBlocked;
+  }
+
+  /// Allow diagonal steps. They never cut a blocked corner.
+  void setDiagonal(bool enable) { m_diagonal = enable; }
+  bool getDiagonal() const { return m_diagonal; }
+
+  u32 width() const { return m_width; }
+  u32 height() const { return m_height; }
+  u32 cellCount() const { return static_cast<u32>(m_costs.size()); }
+  bool contains(u32 x, u32 y) const { return x < m_width && y < m_height; }
+  u32 index(u32 x, u32 y) const { return y * m_width + x; }
+  u8 cost(u32 cell) const { return m_costs[cell]; }
+  const u8 *costs() const { return m_costs.data(); }
+
+  /// Smallest passable cost; scales the heuristic so it stays admissible.
+  u32 minCost() const { return m_minCost; }
+
+private:
+  void updateMinCost() {
+    m_minCost = 255;
+    for (u8 c : m_costs) {
+      if (c != kBlocked && c < m_minCost)
+        m_minCost = c;
+    }
+  }
+
+  u32 m_width = 0;
+  u32 m_height = 0;
+  std::vector<u8> m_costs;
+  u32 m_minCost = 1;
+  bool m_diagonal = true;
+};
+
+} // namespace arcanee::nav
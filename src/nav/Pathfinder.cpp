@@ -0,0 +1,364 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file Pathfinder.cpp
+ */
+
+#include "Pathfinder.h"
+#include <algorithm>
+
+namespace arcanee::nav {
+
+// Monotone priority queue over integer keys (Dial's algorithm): a ring of
+// buckets indexed by key. Keys pushed must lie within kRing of the last key
+// popped, which holds because one step changes a key by at most the largest
+// step cost plus the largest heuristic change (2 * 255 * 14 < kRing). Keys
+// below it (a cost lowered mid-search) are taken as the current one. Each
+// bucket is LIFO, so the order depends only on the pushes.
+class BucketQueue {
+public:
+  static constexpr u32 kRing = 8192;
+
+  BucketQueue() : m_buckets(kRing) {}
+
+  void clear(u32 key) {
+    if (m_size != 0) {
+      for (auto &bucket : m_buckets)
+        bucket.clear();
+    }
+    m_size = 0;
+    m_key = key;
+  }
+
+  void push(u32 key, u32 cell) {
+    m_buckets[std::max(key, m_key) % kRing].push_back(cell);
+    m_size++;
+  }
+
+  bool empty() const { return m_size == 0; }
+
+  // Cell with the lowest key; @p key receives the key
+  u32 pop(u32 &key) {
+    while (m_buckets[m_key % kRing].empty())
+      m_key++;
+    auto &bucket = m_buckets[m_key % kRing];
+    u32 cell = bucket.back();
+    bucket.pop_back();
+    m_size--;
+    key = m_key;
+    return cell;
+  }
+
+private:
+  std::vector<std::vector<u32>> m_buckets;
+  u32 m_key = 0;
+  size_t m_size = 0;
+};
+
+namespace {
+
+u32 stepCost(const NavGrid &grid, u32 into, u32 dir) {
+  return grid.cost(into) *
+         (dir % 2 == 0 ? NavGrid::kStraightStep : NavGrid::kDiagonalStep);
+}
+
+// Calls fn(next, dir, nx, ny) for every cell one step from (x, y): on the
+// grid, not blocked, and for diagonals not cutting a blocked corner.
+// Straight steps come first so their results gate the diagonals.
+template <typename Fn>
+void forEachNeighbor(const NavGrid &grid, u32 x, u32 y, Fn &&fn) {
+  const u32 w = grid.width();
+  const u32 cell = y * w + x;
+  const u8 *costs = grid.costs();
+  bool open[8];
+  open[0] = x + 1 < w && costs[cell + 1] != NavGrid::kBlocked;
+  open[2] = y + 1 < grid.height() && costs[cell + w] != NavGrid::kBlocked;
+  open[4] = x > 0 && costs[cell - 1] != NavGrid::kBlocked;
+  open[6] = y > 0 && costs[cell - w] != NavGrid::kBlocked;
+
+  for (u32 dir = 0; dir < 8; dir += 2) {
+    if (open[dir]) {
+      u32 nx = x + static_cast<u32>(Pathfinder::kDirX[dir]);
+      u32 ny = y + static_cast<u32>(Pathfinder::kDirY[dir]);
+      fn(ny * w + nx, dir, nx, ny);
+    }
+  }
+  if (!grid.getDiagonal())
+    return;
+  for (u32 dir = 1; dir < 8; dir += 2) {
+    if (!open[dir - 1] || !open[(dir + 1) % 8])
+      continue;
+    u32 nx = x + static_cast<u32>(Pathfinder::kDirX[dir]);
+    u32 ny = y + static_cast<u32>(Pathfinder::kDirY[dir]);
+    u32 next = ny * w + nx;
+    if (costs[next] != NavGrid::kBlocked)
+      fn(next, dir, nx, ny);
+  }
+}
+
+} // namespace
+
+// One A* search whose state survives between step() calls. Buffers are
+// reused across searches; a generation stamp marks which entries are current.
+class Pathfinder::Search {
+public:
+  enum class State : u8 { Searching, Found, NoPath };
+
+  void begin(const NavGrid &grid, u32 start, u32 goal) {
+    m_goal = goal;
+    m_path.clear();
+    m_cost = 0;
+    m_state = State::NoPath;
+
+    u32 cells = grid.cellCount();
+    if (m_stamp.size() != cells || ++m_gen == 0) {
+      m_g.assign(cells, 0);
+      m_parent.assign(cells, kNoCell);
+      m_stamp.assign(cells, 0);
+      m_closed.assign(cells, 0);
+      m_gen = 1;
+    }
+    if (start >= cells || goal >= cells || grid.cost(start) == 0 ||
+        grid.cost(goal) == 0) {
+      return;
+    }
+    m_goalX = goal % grid.width();
+    m_goalY = goal / grid.width();
+    m_hScale = grid.minCost();
+    visit(start, 0, kNoCell);
+    u32 h = heuristic(grid, start % grid.width(), start / grid.width());
+    m_open.clear(h);
+    m_open.push(h, start);
+    m_state = State::Searching;
+  }
+
+  // Expand up to @p budget nodes. @return Nodes expanded.
+  u32 step(const NavGrid &grid, u32 budget) {
+    u32 expanded = 0;
+    while (m_state == State::Searching && expanded < budget) {
+      if (m_open.empty()) {
+        m_state = State::NoPath;
+        break;
+      }
+      u32 f;
+      u32 cell = m_open.pop(f);
+      if (m_closed[cell] == m_gen)
+        continue; // Stale entry; the cell was reached more cheaply
+      m_closed[cell] = m_gen;
+      expanded++;
+
+      if (cell == m_goal) {
+        m_state = State::Found;
+        m_cost = m_g[cell];
+        buildPath();
+        break;
+      }
+      const u32 gCell = m_g[cell];
+      forEachNeighbor(grid, cell % grid.width(), cell / grid.width(),
+                      [&](u32 next, u32 dir, u32 nx, u32 ny) {
+                        if (m_closed[next] == m_gen)
+                          return;
+                        u32 g = gCell + stepCost(grid, next, dir);
+                        if (m_stamp[next] == m_gen && g >= m_g[next])
+                          return;
+                        visit(next, g, cell);
+                        u32 h = heuristic(grid, nx, ny);
+                        m_open.push(g + h, next);
+                      });
+    }
+    return expanded;
+  }
+
+  State state() const { return m_state; }
+  u32 cost() const { return m_cost; }
+  std::vector<u32> &path() { return m_path; }
+
+private:
+  void visit(u32 cell, u32 g, u32 parent) {
+    m_g[cell] = g;
+    m_parent[cell] = parent;
+    m_stamp[cell] = m_gen;
+  }
+
+  // Octile distance at the cheapest passable cost when the search began:
+  // never overestimates unless costs are lowered mid-search
+  u32 heuristic(const NavGrid &grid, u32 x, u32 y) const {
+    u32 dx = x > m_goalX ? x - m_goalX : m_goalX - x;
+    u32 dy = y > m_goalY ? y - m_goalY : m_goalY - y;
+    u32 steps;
+    if (grid.getDiagonal()) {
+      u32 diag = std::min(dx, dy);
+      steps = NavGrid::kDiagonalStep * diag +
+              NavGrid::kStraightStep * (std::max(dx, dy) - diag);
+    } else {
+      steps = NavGrid::kStraightStep * (dx + dy);
+    }
+    return steps * m_hScale;
+  }
+
+  void buildPath() {
+    for (u32 cell = m_goal; cell != kNoCell; cell = m_parent[cell])
+      m_path.push_back(cell);
+    std::reverse(m_path.begin(), m_path.end());
+  }
+
+  u32 m_goal = 0;
+  u32 m_goalX = 0;
+  u32 m_goalY = 0;
+  u32 m_hScale = 1;
+  State m_state = State::NoPath;
+  u32 m_cost = 0;
+  std::vector<u32> m_path;
+
+  BucketQueue m_open;
+  std::vector<u32> m_g;
+  std::vector<u32> m_parent;
+  std::vector<u32> m_stamp;  // m_g/m_parent are current where == m_gen
+  std::vector<u32> m_closed; // Expanded where == m_gen
+  u32 m_gen = 0;
+};
+
+Pathfinder::Pathfinder()
+    : m_sync(std::make_unique<Search>()), m_async(std::make_unique<Search>()),
+      m_flowOpen(std::make_unique<BucketQueue>()) {}
+
+Pathfinder::~Pathfinder() = default;
+
+bool Pathfinder::resetGrid(u32 width, u32 height) {
+  clear();
+  return m_grid.resize(width, height);
+}
+
+bool Pathfinder::findPath(u32 start, u32 goal, std::vector<u32> &path,
+                          u32 &cost) {
+  m_sync->begin(m_grid, start, goal);
+  m_sync->step(m_grid, kUnreachable);
+  if (m_sync->state() != Search::State::Found)
+    return false;
+  path.swap(m_sync->path());
+  cost = m_sync->cost();
+  return true;
+}
+
+u32 Pathfinder::request(u32 start, u32 goal) {
+  u32 id = m_nextId++;
+  if (m_nextId == 0)
+    m_nextId = 1;
+  m_queue.push_back({id, start, goal});
+  return id;
+}
+
+void Pathfinder::step() {
+  u32 budget = m_stepBudget;
+  m_stats.expansions = 0;
+  while (!m_queue.empty()) {
+    if (!m_asyncStarted) {
+      const Request &front = m_queue.front();
+      m_async->begin(m_grid, front.start, front.goal);
+      m_asyncStarted = true;
+    }
+    u32 used = m_async->step(m_grid, budget);
+    m_stats.expansions += used;
+    budget -= used;
+
+    Search::State state = m_async->state();
+    if (state == Search::State::Searching)
+      break; // Out of budget; continue next tick
+    finishFront(state == Search::State::Found);
+    if (budget == 0)
+      break;
+  }
+}
+
+void Pathfinder::finishFront(bool found) {
+  Finished &done = m_finished[m_queue.front().id];
+  done.found = found;
+  done.cost = found ? m_async->cost() : 0;
+  if (found)
+    done.path.swap(m_async->path());
+  m_queue.pop_front();
+  m_asyncStarted = false;
+  m_stats.completed++;
+}
+
+Pathfinder::Status Pathfinder::poll(u32 id, std::vector<u32> &path,
+                                    u32 &cost) {
+  auto it = m_finished.find(id);
+  if (it == m_finished.end()) {
+    for (const Request &r : m_queue) {
+      if (r.id == id)
+        return Status::Pending;
+    }
+    return Status::Unknown;
+  }
+  Status status = it->second.found ? Status::Found : Status::NoPath;
+  path.swap(it->second.path);
+  cost = it->second.cost;
+  m_finished.erase(it);
+  return status;
+}
+
+bool Pathfinder::cancel(u32 id) {
+  if (m_finished.erase(id) > 0)
+    return true;
+  for (auto it = m_queue.begin(); it != m_queue.end(); ++it) {
+    if (it->id != id)
+      continue;
+    if (it == m_queue.begin())
+      m_asyncStarted = false;
+    m_queue.erase(it);
+    return true;
+  }
+  return false;
+}
+
+void Pathfinder::clear() {
+  m_queue.clear();
+  m_finished.clear();
+  m_asyncStarted = false;
+}
+
+bool Pathfinder::flowField(u32 goal, u8 *dirs, u32 *dist) {
+  const u32 cells = m_grid.cellCount();
+  if (goal >= cells || m_grid.cost(goal) == NavGrid::kBlocked)
+    return false;
+
+  // Dijkstra outward from the goal over reversed steps: reaching cell a from
+  // b costs what stepping from a into b would
+  m_flowDist.assign(cells, kUnreachable);
+  std::fill(dirs, dirs + cells, 0);
+  BucketQueue &open = *m_flowOpen;
+  open.clear(0);
+  m_flowDist[goal] = 0;
+  open.push(0, goal);
+
+  while (!open.empty()) {
+    u32 dist;
+    u32 cell = open.pop(dist);
+    if (dist != m_flowDist[cell])
+      continue; // Stale entry
+    const u32 step[2] = {m_grid.cost(cell) * NavGrid::kStraightStep,
+                         m_grid.cost(cell) * NavGrid::kDiagonalStep};
+    forEachNeighbor(m_grid, cell % m_grid.width(), cell / m_grid.width(),
+                    [&](u32 from, u32 dir, u32, u32) {
+                      u32 d = dist + step[dir % 2];
+                      if (d >= m_flowDist[from])
+                        return;
+                      m_flowDist[from] = d;
+                      dirs[from] = static_cast<u8>((dir + 4) % 8 + 1);
+                      open.push(d, from);
+                    });
+  }
+
+  if (dist)
+    std::copy(m_flowDist.begin(), m_flowDist.end(), dist);
+  return true;
+}
+
+} // namespace arcanee::nav
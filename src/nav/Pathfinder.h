@@ -0,0 +1,146 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file Pathfinder.h
+ * @brief A* paths, incremental path requests and flow fields on a NavGrid.
+ */
+
+#include "NavGrid.h"
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace arcanee::nav {
+
+class BucketQueue;
+
+/**
+ * @brief Searches over one NavGrid.
+ *
+ * findPath() runs A* to completion. request() queues a search that step()
+ * advances by a fixed number of node expansions per tick, oldest request
+ * first, so long searches spread over several ticks. flowField() runs
+ * Dijkstra from a goal over the whole grid and gives every cell the step
+ * toward it, for many agents sharing one destination.
+ *
+ * Costs are integers and the open list is a bucket queue whose order
+ * depends only on the grid and the calls made, so a given grid and sequence
+ * of calls always produces the same paths.
+ */
+class Pathfinder {
+public:
+  enum class Status : u8 { Unknown, Pending, Found, NoPath };
+
+  static constexpr u32 kNoCell = 0xFFFFFFFFu;
+  static constexpr u32 kUnreachable = 0xFFFFFFFFu;
+  static constexpr u32 kDefaultStepBudget = 20000;
+
+  /// Directions clockwise from east (y grows down). Even ones are straight.
+  /// Flow field codes are 1 + the index; 0 means no step.
+  static constexpr i32 kDirX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+  static constexpr i32 kDirY[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+  struct Stats {
+    u64 expansions = 0; ///< Nodes expanded by the last step()
+    u64 completed = 0;  ///< Requests finished since creation
+  };
+
+  Pathfinder();
+  ~Pathfinder();
+
+  Pathfinder(const Pathfinder &) = delete;
+  Pathfinder &operator=(const Pathfinder &) = delete;
+
+  /// Costs and options may change at any time; running searches see the
+  /// change from their next expansion. Resize through resetGrid().
+  NavGrid &grid() { return m_grid; }
+  const NavGrid &grid() const { return m_grid; }
+
+  /// Resize the grid (every cost 1) and drop every request.
+  bool resetGrid(u32 width, u32 height);
+
+  /**
+   * @brief Complete A* search from cell @p start to cell @p goal.
+   * @param path Cells from start to goal inclusive.
+   * @param cost Sum of step costs (10 per straight step at cost 1).
+   * @return False if either cell is blocked or no path exists.
+   */
+  bool findPath(u32 start, u32 goal, std::vector<u32> &path, u32 &cost);
+
+  /// Queue a search. @return Request id (never 0).
+  u32 request(u32 start, u32 goal);
+
+  /// Spend up to the step budget on queued requests.
+  void step();
+  void setStepBudget(u32 expansions) { m_stepBudget = expansions; }
+  u32 getStepBudget() const { return m_stepBudget; }
+
+  /**
+   * @brief Check a request. Found and NoPath hand over the result and
+   * forget the request; Pending and Unknown leave @p path untouched.
+   */
+  Status poll(u32 id, std::vector<u32> &path, u32 &cost);
+  bool cancel(u32 id);
+  /// Drop every request. Ids are never reissued; the grid is kept.
+  void clear();
+
+  /// Requests still searching.
+  u32 pending() const { return static_cast<u32>(m_queue.size()); }
+  /// Requests searching or waiting for poll().
+  u32 outstanding() const {
+    return static_cast<u32>(m_queue.size() + m_finished.size());
+  }
+
+  /**
+   * @brief Fill @p dirs with each cell's flow code toward @p goal.
+   * @param dist Optional cost to the goal per cell, kUnreachable if none.
+   * @return False if @p goal is out of range or blocked.
+   */
+  bool flowField(u32 goal, u8 *dirs, u32 *dist = nullptr);
+
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  class Search;
+
+  struct Request {
+    u32 id;
+    u32 start;
+    u32 goal;
+  };
+
+  struct Finished {
+    bool found;
+    u32 cost;
+    std::vector<u32> path;
+  };
+
+  void finishFront(bool found);
+
+  NavGrid m_grid;
+  u32 m_stepBudget = kDefaultStepBudget;
+  u32 m_nextId = 1;
+
+  std::unique_ptr<Search> m_sync;  // findPath()
+  std::unique_ptr<Search> m_async; // Front of m_queue, once started
+  bool m_asyncStarted = false;
+  std::deque<Request> m_queue;
+  std::map<u32, Finished> m_finished;
+
+  // flowField() scratch
+  std::vector<u32> m_flowDist;
+  std::unique_ptr<BucketQueue> m_flowOpen;
+
+  Stats m_stats;
+};
+
+} // namespace arcanee::nav
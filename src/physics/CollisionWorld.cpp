@@ -0,0 +1,255 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file CollisionWorld.cpp
+ */
+
+#include "CollisionWorld.h"
+#include <algorithm>
+#include <cmath>
+
+namespace arcanee::physics {
+
+namespace {
+
+// Cell coordinates are clamped so spans and products stay in range
+constexpr f32 kCellLimit = static_cast<f32>(1 << 29);
+
+constexpr u8 kInactive = 0;
+constexpr u8 kInGrid = 1;
+constexpr u8 kOversized = 2;
+
+u32 nextPowerOfTwo(u32 v) {
+  u32 p = 16;
+  while (p < v)
+    p <<= 1;
+  return p;
+}
+
+} // namespace
+
+CollisionWorld::CollisionWorld(f32 cellSize)
+    : m_cellSize(64.0f), m_invCellSize(1.0f / 64.0f) {
+  setCellSize(cellSize);
+  clear(); // Empty grid
+}
+
+void CollisionWorld::setCellSize(f32 size) {
+  if (std::isfinite(size) && size > 0.0f) {
+    m_cellSize = size;
+    m_invCellSize = 1.0f / size;
+  }
+}
+
+i32 CollisionWorld::cellOf(f32 v) const {
+  f32 c = std::floor(v * m_invCellSize);
+  return static_cast<i32>(std::clamp(c, -kCellLimit, kCellLimit));
+}
+
+u32 CollisionWorld::bucketOf(i32 cx, i32 cy) const {
+  u32 h = static_cast<u32>(cx) * 0x9E3779B1u ^
+          static_cast<u32>(cy) * 0x85EBCA77u;
+  h ^= h >> 15;
+  return h & m_bucketMask;
+}
+
+void CollisionWorld::update(const f32 *rects, u32 count, const u32 *layers,
+                            const u32 *masks) {
+  m_stats = Stats();
+  m_stats.bodies = count;
+  m_minX.resize(count);
+  m_minY.resize(count);
+  m_maxX.resize(count);
+  m_maxY.resize(count);
+  m_layer.resize(count);
+  m_mask.resize(count);
+  m_active.resize(count);
+  m_cellX0.resize(count);
+  m_cellY0.resize(count);
+  m_cellX1.resize(count);
+  m_cellY1.resize(count);
+  m_stamp.assign(count, 0);
+  m_queryStamp = 0;
+  m_oversized.clear();
+
+  // Bounds, cell ranges and the number of grid entries
+  u32 entries = 0;
+  for (u32 i = 0; i < count; ++i) {
+    const f32 *r = rects + 4 * static_cast<size_t>(i);
+    m_minX[i] = r[0];
+    m_minY[i] = r[1];
+    m_maxX[i] = r[0] + r[2];
+    m_maxY[i] = r[1] + r[3];
+    m_layer[i] = layers ? layers[i] : kDefaultLayer;
+    m_mask[i] = masks ? masks[i] : kAllLayers;
+
+    bool valid = std::isfinite(m_minX[i]) && std::isfinite(m_minY[i]) &&
+                 std::isfinite(m_maxX[i]) && std::isfinite(m_maxY[i]) &&
+                 r[2] >= 0.0f && r[3] >= 0.0f;
+    if (!valid) {
+      m_active[i] = kInactive;
+      continue;
+    }
+    m_cellX0[i] = cellOf(m_minX[i]);
+    m_cellY0[i] = cellOf(m_minY[i]);
+    m_cellX1[i] = cellOf(m_maxX[i]);
+    m_cellY1[i] = cellOf(m_maxY[i]);
+    i32 spanX = m_cellX1[i] - m_cellX0[i] + 1;
+    i32 spanY = m_cellY1[i] - m_cellY0[i] + 1;
+    if (spanX > kMaxCellSpan || spanY > kMaxCellSpan) {
+      m_active[i] = kOversized;
+      m_oversized.push_back(i);
+      continue;
+    }
+    m_active[i] = kInGrid;
+    entries += static_cast<u32>(spanX * spanY);
+  }
+  m_stats.cellEntries = entries;
+  m_stats.oversized = static_cast<u32>(m_oversized.size());
+
+  // Counting sort into buckets: count, prefix-sum to bucket ends, then fill
+  // backwards so each bucket lists its bodies in ascending order
+  u32 buckets = nextPowerOfTwo(entries);
+  m_bucketMask = buckets - 1;
+  m_bucketStart.assign(buckets + 1, 0);
+  for (u32 i = 0; i < count; ++i) {
+    if (m_active[i] != kInGrid)
+      continue;
+    for (i32 cy = m_cellY0[i]; cy <= m_cellY1[i]; ++cy) {
+      for (i32 cx = m_cellX0[i]; cx <= m_cellX1[i]; ++cx)
+        m_bucketStart[bucketOf(cx, cy)]++;
+    }
+  }
+  u32 sum = 0;
+  for (u32 b = 0; b < buckets; ++b) {
+    sum += m_bucketStart[b];
+    m_bucketStart[b] = sum;
+  }
+  m_bucketStart[buckets] = entries;
+
+  m_entries.resize(entries);
+  for (u32 i = count; i-- > 0;) {
+    if (m_active[i] != kInGrid)
+      continue;
+    for (i32 cy = m_cellY0[i]; cy <= m_cellY1[i]; ++cy) {
+      for (i32 cx = m_cellX0[i]; cx <= m_cellX1[i]; ++cx)
+        m_entries[--m_bucketStart[bucketOf(cx, cy)]] = {i, cx, cy};
+    }
+  }
+}
+
+const std::vector<u32> &CollisionWorld::findPairs() {
+  m_pairKeys.clear();
+  u64 tests = 0;
+
+  u32 buckets = m_bucketMask + 1;
+  for (u32 bucket = 0; bucket < buckets; ++bucket) {
+    u32 end = m_bucketStart[bucket + 1];
+    for (u32 i = m_bucketStart[bucket]; i < end; ++i) {
+      const Entry &ea = m_entries[i];
+      for (u32 j = i + 1; j < end; ++j) {
+        const Entry &eb = m_entries[j];
+        if (eb.cx != ea.cx || eb.cy != ea.cy)
+          continue; // Another cell hashed to this bucket
+        u32 a = ea.body;
+        u32 b = eb.body;
+        tests++;
+        if (!overlaps(a, b) || !accepts(a, b))
+          continue;
+        // Report from the cell holding the overlap's top-left corner only
+        if (cellOf(std::max(m_minX[a], m_minX[b])) != ea.cx ||
+            cellOf(std::max(m_minY[a], m_minY[b])) != ea.cy) {
+          continue;
+        }
+        m_pairKeys.push_back(static_cast<u64>(a) << 32 | b);
+      }
+    }
+  }
+
+  for (u32 o : m_oversized) {
+    for (u32 k = 0; k < size(); ++k) {
+      if (k == o || m_active[k] == kInactive ||
+          (m_active[k] == kOversized && k < o)) {
+        continue;
+      }
+      tests++;
+      if (overlaps(o, k) && accepts(o, k)) {
+        u32 a = std::min(o, k);
+        u32 b = std::max(o, k);
+        m_pairKeys.push_back(static_cast<u64>(a) << 32 | b);
+      }
+    }
+  }
+  m_stats.pairTests = tests;
+
+  std::sort(m_pairKeys.begin(), m_pairKeys.end());
+  m_pairs.resize(m_pairKeys.size() * 2);
+  for (size_t i = 0; i < m_pairKeys.size(); ++i) {
+    m_pairs[2 * i] = static_cast<u32>(m_pairKeys[i] >> 32);
+    m_pairs[2 * i + 1] = static_cast<u32>(m_pairKeys[i]);
+  }
+  return m_pairs;
+}
+
+const std::vector<u32> &CollisionWorld::query(f32 x, f32 y, f32 w, f32 h,
+                                              u32 mask) {
+  m_hits.clear();
+  f32 maxX = x + w;
+  f32 maxY = y + h;
+  if (!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(maxX) ||
+      !std::isfinite(maxY) || w < 0.0f || h < 0.0f) {
+    return m_hits;
+  }
+
+  auto test = [&](u32 k) {
+    if (m_minX[k] < maxX && x < m_maxX[k] && m_minY[k] < maxY &&
+        y < m_maxY[k] && (m_layer[k] & mask) != 0) {
+      m_hits.push_back(k);
+    }
+  };
+
+  i32 cx0 = cellOf(x);
+  i32 cy0 = cellOf(y);
+  i32 cx1 = cellOf(maxX);
+  i32 cy1 = cellOf(maxY);
+  u64 cells =
+      static_cast<u64>(cx1 - cx0 + 1) * static_cast<u64>(cy1 - cy0 + 1);
+  if (cells > m_entries.size()) {
+    // Walking the cells would cost more than testing every body
+    for (u32 k = 0; k < size(); ++k) {
+      if (m_active[k] != kInactive)
+        test(k);
+    }
+    return m_hits;
+  }
+
+  if (++m_queryStamp == 0) {
+    std::fill(m_stamp.begin(), m_stamp.end(), 0);
+    m_queryStamp = 1;
+  }
+  for (i32 cy = cy0; cy <= cy1; ++cy) {
+    for (i32 cx = cx0; cx <= cx1; ++cx) {
+      u32 bucket = bucketOf(cx, cy);
+      for (u32 i = m_bucketStart[bucket]; i < m_bucketStart[bucket + 1];
+           ++i) {
+        const Entry &e = m_entries[i];
+        if (e.cx != cx || e.cy != cy || m_stamp[e.body] == m_queryStamp)
+          continue;
+        m_stamp[e.body] = m_queryStamp;
+        test(e.body);
+      }
+    }
+  }
+  for (u32 o : m_oversized)
+    test(o);
+  std::sort(m_hits.begin(), m_hits.end());
+  return m_hits;
+}
+
+} // namespace arcanee::physics
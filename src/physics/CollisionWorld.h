@@ -0,0 +1,129 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file CollisionWorld.h
+ * @brief Broadphase overlap tests for script-side bodies.
+ */
+
+#include "common/Types.h"
+#include <vector>
+
+namespace arcanee::physics {
+
+/**
+ * @brief Axis-aligned boxes binned into a uniform spatial hash.
+ *
+ * Bodies are replaced in bulk every tick (a body's id is its position in the
+ * input) and kept as structure-of-arrays. update() bins each body into the
+ * cells it covers with a counting sort keyed by hashed cell, so the grid is
+ * rebuilt without per-cell allocations. Only bodies sharing a cell are
+ * tested; a pair sharing several cells is reported from the one holding the
+ * top-left corner of their overlap, so no deduplication pass is needed.
+ * Bodies spanning more than kMaxCellSpan cells on an axis skip the grid and
+ * are tested against everything.
+ *
+ * Two bodies collide when their boxes overlap (touching edges do not count)
+ * and each one's layer bits intersect the other's mask. A body with a
+ * negative or non-finite size is inactive. Results are sorted by id, so they
+ * depend only on the input, never on the hash layout.
+ */
+class CollisionWorld {
+public:
+  static constexpr u32 kDefaultLayer = 1;
+  static constexpr u32 kAllLayers = 0xFFFFFFFFu;
+  static constexpr i32 kMaxCellSpan = 16;
+
+  struct Stats {
+    u32 bodies = 0;      ///< Bodies in the last update(), active or not
+    u32 cellEntries = 0; ///< Body/cell memberships in the grid
+    u32 oversized = 0;   ///< Bodies kept out of the grid
+    u64 pairTests = 0;   ///< Box tests in the last pairs()
+  };
+
+  explicit CollisionWorld(f32 cellSize = 64.0f);
+
+  /// Cell edge in world units; around the size of a typical body works best.
+  /// Takes effect at the next update().
+  void setCellSize(f32 size);
+  f32 getCellSize() const { return m_cellSize; }
+
+  /**
+   * @brief Replace every body.
+   * @param rects x, y, w, h per body.
+   * @param layers Layer bits per body, or null for kDefaultLayer.
+   * @param masks Mask bits per body, or null for kAllLayers.
+   */
+  void update(const f32 *rects, u32 count, const u32 *layers = nullptr,
+              const u32 *masks = nullptr);
+
+  /// Drop every body.
+  void clear() { update(nullptr, 0); }
+
+  /**
+   * @brief Colliding pairs as a, b with a < b, sorted.
+   *
+   * The result lives in the world and is overwritten by the next call.
+   */
+  const std::vector<u32> &findPairs();
+
+  /**
+   * @brief Active bodies overlapping a box whose layer intersects @p mask,
+   * in ascending order. Overwritten by the next call.
+   */
+  const std::vector<u32> &query(f32 x, f32 y, f32 w, f32 h,
+                                u32 mask = kAllLayers);
+
+  u32 size() const { return static_cast<u32>(m_minX.size()); }
+  const Stats &getStats() const { return m_stats; }
+
+private:
+  struct Entry {
+    u32 body;
+    i32 cx;
+    i32 cy;
+  };
+
+  i32 cellOf(f32 v) const;
+  u32 bucketOf(i32 cx, i32 cy) const;
+  bool overlaps(u32 a, u32 b) const {
+    return m_minX[a] < m_maxX[b] && m_minX[b] < m_maxX[a] &&
+           m_minY[a] < m_maxY[b] && m_minY[b] < m_maxY[a];
+  }
+  bool accepts(u32 a, u32 b) const {
+    return (m_layer[a] & m_mask[b]) != 0 && (m_layer[b] & m_mask[a]) != 0;
+  }
+
+  f32 m_cellSize;
+  f32 m_invCellSize;
+
+  // Bodies (SoA); inactive ones have m_active 0
+  std::vector<f32> m_minX, m_minY, m_maxX, m_maxY;
+  std::vector<u32> m_layer, m_mask;
+  std::vector<u8> m_active;
+  std::vector<i32> m_cellX0, m_cellY0, m_cellX1, m_cellY1;
+
+  // Grid: entries of bucket b are m_entries[m_bucketStart[b]..[b + 1])
+  std::vector<u32> m_bucketStart;
+  std::vector<Entry> m_entries;
+  u32 m_bucketMask = 0;
+  std::vector<u32> m_oversized;
+
+  // Scratch reused across calls
+  std::vector<u64> m_pairKeys;
+  std::vector<u32> m_pairs;
+  std::vector<u32> m_hits;
+  std::vector<u32> m_stamp; // Per body: last query that reported it
+  u32 m_queryStamp = 0;
+
+  Stats m_stats;
+};
+
+} // namespace arcanee::physics
@@ -0,0 +1,148 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file BulkRandom.cpp
+ */
+
+#include "BulkRandom.h"
+#include "common/Random.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARCANEE_BULK_RANDOM_SSE2 1
+#endif
+
+namespace arcanee::procgen {
+
+namespace {
+
+constexpr size_t kChunk = 256;
+
+// One Xorshift128+ step of a single lane (Chapter 1 §1.6.2)
+u64 stepLane(u64 &state0, u64 &state1) {
+  u64 s1 = state0;
+  u64 s0 = state1;
+  state0 = s0;
+  s1 ^= s1 << 23;
+  state1 = s1 ^ s0 ^ (s1 >> 18) ^ (s0 >> 5);
+  return state1 + s0;
+}
+
+#ifdef ARCANEE_BULK_RANDOM_SSE2
+// The same step for two lanes
+__m128i stepLanes(__m128i &state0, __m128i &state1) {
+  __m128i s1 = state0;
+  __m128i s0 = state1;
+  state0 = s0;
+  s1 = _mm_xor_si128(s1, _mm_slli_epi64(s1, 23));
+  state1 = _mm_xor_si128(_mm_xor_si128(s1, s0),
+                         _mm_xor_si128(_mm_srli_epi64(s1, 18),
+                                       _mm_srli_epi64(s0, 5)));
+  return _mm_add_epi64(state1, s0);
+}
+#endif
+
+} // namespace
+
+void Xorshift128PlusX4::setSeed(u64 seed) {
+  Xorshift128Plus rng(seed);
+  for (u32 k = 0; k < kLanes; ++k) {
+    m_s0[k] = rng.state(0);
+    m_s1[k] = rng.state(1);
+    rng.jump();
+  }
+  m_spareStart = kLanes;
+}
+
+void Xorshift128PlusX4::nextGroup(u64 out[kLanes]) {
+  for (u32 k = 0; k < kLanes; ++k)
+    out[k] = stepLane(m_s0[k], m_s1[k]);
+}
+
+void Xorshift128PlusX4::fill(u64 *out, size_t count) {
+  while (count > 0 && m_spareStart < kLanes) {
+    *out++ = m_spare[m_spareStart++];
+    count--;
+  }
+
+  size_t i = 0;
+#ifdef ARCANEE_BULK_RANDOM_SSE2
+  auto *s0 = reinterpret_cast<__m128i *>(m_s0);
+  auto *s1 = reinterpret_cast<__m128i *>(m_s1);
+  // Lanes 0-1 in a, lanes 2-3 in b
+  __m128i a0 = _mm_loadu_si128(s0), b0 = _mm_loadu_si128(s0 + 1);
+  __m128i a1 = _mm_loadu_si128(s1), b1 = _mm_loadu_si128(s1 + 1);
+  for (; i + kLanes <= count; i += kLanes) {
+    auto *dst = reinterpret_cast<__m128i *>(out + i);
+    _mm_storeu_si128(dst, stepLanes(a0, a1));
+    _mm_storeu_si128(dst + 1, stepLanes(b0, b1));
+  }
+  _mm_storeu_si128(s0, a0);
+  _mm_storeu_si128(s0 + 1, b0);
+  _mm_storeu_si128(s1, a1);
+  _mm_storeu_si128(s1 + 1, b1);
+#else
+  for (; i + kLanes <= count; i += kLanes)
+    nextGroup(out + i);
+#endif
+
+  if (i < count) {
+    nextGroup(m_spare);
+    m_spareStart = 0;
+    while (i < count)
+      out[i++] = m_spare[m_spareStart++];
+  }
+}
+
+void Xorshift128PlusX4::fillFloat(f32 *out, size_t count, f32 lo, f32 hi) {
+  u64 raw[kChunk];
+  const f32 span = hi - lo;
+  for (size_t done = 0; done < count;) {
+    size_t n = std::min(kChunk, count - done);
+    fill(raw, n);
+    for (size_t i = 0; i < n; ++i) {
+      f32 unit = static_cast<f32>(raw[i] >> 40) * (1.0f / 16777216.0f);
+      out[done + i] = lo + span * unit;
+    }
+    done += n;
+  }
+}
+
+void Xorshift128PlusX4::fillInt(i32 *out, size_t count, i32 lo, i32 hi) {
+  if (lo > hi)
+    std::swap(lo, hi);
+  u64 raw[kChunk];
+  const u64 range = static_cast<u64>(static_cast<i64>(hi) - lo) + 1;
+  for (size_t done = 0; done < count;) {
+    size_t n = std::min(kChunk, count - done);
+    fill(raw, n);
+    for (size_t i = 0; i < n; ++i) {
+      u64 offset = ((raw[i] >> 32) * range) >> 32;
+      out[done + i] = static_cast<i32>(static_cast<i64>(lo) +
+                                       static_cast<i64>(offset));
+    }
+    done += n;
+  }
+}
+
+void Xorshift128PlusX4::fillBytes(u8 *out, size_t count) {
+  u64 raw[kChunk];
+  for (size_t done = 0; done < count;) {
+    size_t bytes = std::min(kChunk * 8, count - done);
+    size_t n = (bytes + 7) / 8;
+    fill(raw, n);
+    for (size_t b = 0; b < bytes; ++b)
+      out[done + b] = static_cast<u8>(raw[b / 8] >> (8 * (b % 8)));
+    done += bytes;
+  }
+}
+
+} // namespace arcanee::procgen
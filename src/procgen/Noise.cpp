@@ -0,0 +1,413 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file Noise.cpp
+ */
+
+#include "Noise.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARCANEE_NOISE_SSE2 1
+#endif
+
+namespace arcanee::procgen {
+
+namespace {
+
+// Each kernel is written once against an Ops type: ScalarOps works on one
+// sample, SseOps on four. Both run the same operations in the same order,
+// so the two paths give bit-identical results.
+
+struct ScalarOps {
+  using F = f32;
+  using I = u32;
+  using M = bool;
+
+  static F set(f32 v) { return v; }
+  static I seti(u32 v) { return v; }
+  static F add(F a, F b) { return a + b; }
+  static F sub(F a, F b) { return a - b; }
+  static F mul(F a, F b) { return a * b; }
+  // Operand order matches minps/maxps
+  static F min(F a, F b) { return a < b ? a : b; }
+  static F max(F a, F b) { return a > b ? a : b; }
+  static F sqrt(F a) { return std::sqrt(a); }
+  static I iadd(I a, I b) { return a + b; }
+  static I imul(I a, I b) { return a * b; }
+  static I ixor(I a, I b) { return a ^ b; }
+  static I iand(I a, I b) { return a & b; }
+  template <int N> static I srl(I a) { return a >> N; }
+  static M lt(F a, F b) { return a < b; }
+  static M bit(I a, u32 mask) { return (a & mask) != 0; }
+  static F select(M m, F a, F b) { return m ? a : b; }
+  static I selecti(M m, I a, I b) { return m ? a : b; }
+  static F toF(I a) { return static_cast<f32>(static_cast<i32>(a)); }
+  // Truncate, then step down for negative fractions (as the SSE path does)
+  static I floorI(F a) {
+    i32 t = static_cast<i32>(a);
+    if (static_cast<f32>(t) > a)
+      t -= 1;
+    return static_cast<u32>(t);
+  }
+};
+
+#ifdef ARCANEE_NOISE_SSE2
+struct SseOps {
+  using F = __m128;
+  using I = __m128i;
+  using M = __m128;
+
+  static F set(f32 v) { return _mm_set1_ps(v); }
+  static I seti(u32 v) { return _mm_set1_epi32(static_cast<i32>(v)); }
+  static F add(F a, F b) { return _mm_add_ps(a, b); }
+  static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+  static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+  static F min(F a, F b) { return _mm_min_ps(a, b); }
+  static F max(F a, F b) { return _mm_max_ps(a, b); }
+  static F sqrt(F a) { return _mm_sqrt_ps(a); }
+  static I iadd(I a, I b) { return _mm_add_epi32(a, b); }
+  // SSE2 has no 32-bit low multiply; combine two 32x32->64 multiplies
+  static I imul(I a, I b) {
+    I even = _mm_mul_epu32(a, b);
+    I odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+  }
+  static I ixor(I a, I b) { return _mm_xor_si128(a, b); }
+  static I iand(I a, I b) { return _mm_and_si128(a, b); }
+  template <int N> static I srl(I a) { return _mm_srli_epi32(a, N); }
+  static M lt(F a, F b) { return _mm_cmplt_ps(a, b); }
+  static M bit(I a, u32 mask) {
+    I m = seti(mask);
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(a, m), m));
+  }
+  static F select(M m, F a, F b) {
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+  }
+  static I selecti(M m, I a, I b) {
+    I mi = _mm_castps_si128(m);
+    return _mm_or_si128(_mm_and_si128(mi, a), _mm_andnot_si128(mi, b));
+  }
+  static F toF(I a) { return _mm_cvtepi32_ps(a); }
+  static I floorI(F a) {
+    I t = _mm_cvttps_epi32(a);
+    // All-ones (-1) where truncation rounded up
+    I up = _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(t), a));
+    return _mm_add_epi32(t, up);
+  }
+};
+#endif
+
+// Keeps floorI() within i32 range
+constexpr f32 kCoordLimit = 1073741824.0f;
+
+constexpr f32 kSqrt2 = 1.41421356f;
+// Scale each kernel's peak to about 1; the result is then clamped
+constexpr f32 kPerlinScale = 1.0f;
+constexpr f32 kSimplexScale = 70.0f;
+constexpr f32 kSimplexF2 = 0.36602540f; // (sqrt(3) - 1) / 2
+constexpr f32 kSimplexG2 = 0.21132487f; // (3 - sqrt(3)) / 6
+
+// Lattice point hash (lowbias32 finalizer)
+template <class S>
+typename S::I hash(typename S::I x, typename S::I y, typename S::I seed) {
+  using I = typename S::I;
+  I h = S::ixor(seed, S::ixor(S::imul(x, S::seti(0x27D4EB2Du)),
+                              S::imul(y, S::seti(0x165667B1u))));
+  h = S::ixor(h, S::template srl<16>(h));
+  h = S::imul(h, S::seti(0x7FEB352Du));
+  h = S::ixor(h, S::template srl<15>(h));
+  h = S::imul(h, S::seti(0x846CA68Bu));
+  return S::ixor(h, S::template srl<16>(h));
+}
+
+// 6t^5 - 15t^4 + 10t^3
+template <class S> typename S::F fade(typename S::F t) {
+  auto poly = S::add(S::mul(t, S::sub(S::mul(t, S::set(6.0f)),
+                                      S::set(15.0f))),
+                     S::set(10.0f));
+  return S::mul(S::mul(S::mul(t, t), t), poly);
+}
+
+template <class S>
+typename S::F lerp(typename S::F a, typename S::F b, typename S::F t) {
+  return S::add(a, S::mul(S::sub(b, a), t));
+}
+
+template <class S>
+typename S::F clampUnit(typename S::F v) {
+  return S::min(S::max(v, S::set(-1.0f)), S::set(1.0f));
+}
+
+// Dot product with one of eight gradients of length sqrt(2): the four
+// diagonals and the four axes
+template <class S>
+typename S::F grad(typename S::I h, typename S::F dx, typename S::F dy) {
+  using F = typename S::F;
+  F a = S::select(S::bit(h, 1), S::sub(S::set(0.0f), dx), dx);
+  F b = S::select(S::bit(h, 2), S::sub(S::set(0.0f), dy), dy);
+  F axis = S::mul(S::select(S::bit(h, 4), a, b), S::set(kSqrt2));
+  return S::select(S::bit(h, 8), axis, S::add(a, b));
+}
+
+// Random lattice value in [-1, 1)
+template <class S> typename S::F latticeValue(typename S::I h) {
+  return S::sub(S::mul(S::toF(S::template srl<8>(h)),
+                       S::set(1.0f / 8388608.0f)),
+                S::set(1.0f));
+}
+
+struct ValueNoise {
+  template <class S>
+  static typename S::F eval(typename S::F x, typename S::F y,
+                            typename S::I seed) {
+    using F = typename S::F;
+    using I = typename S::I;
+    I ix = S::floorI(x);
+    I iy = S::floorI(y);
+    I ix1 = S::iadd(ix, S::seti(1));
+    I iy1 = S::iadd(iy, S::seti(1));
+    F u = fade<S>(S::sub(x, S::toF(ix)));
+    F v = fade<S>(S::sub(y, S::toF(iy)));
+    F v00 = latticeValue<S>(hash<S>(ix, iy, seed));
+    F v10 = latticeValue<S>(hash<S>(ix1, iy, seed));
+    F v01 = latticeValue<S>(hash<S>(ix, iy1, seed));
+    F v11 = latticeValue<S>(hash<S>(ix1, iy1, seed));
+    return lerp<S>(lerp<S>(v00, v10, u), lerp<S>(v01, v11, u), v);
+  }
+};
+
+struct PerlinNoise {
+  template <class S>
+  static typename S::F eval(typename S::F x, typename S::F y,
+                            typename S::I seed) {
+    using F = typename S::F;
+    using I = typename S::I;
+    I ix = S::floorI(x);
+    I iy = S::floorI(y);
+    I ix1 = S::iadd(ix, S::seti(1));
+    I iy1 = S::iadd(iy, S::seti(1));
+    F fx = S::sub(x, S::toF(ix));
+    F fy = S::sub(y, S::toF(iy));
+    F fx1 = S::sub(fx, S::set(1.0f));
+    F fy1 = S::sub(fy, S::set(1.0f));
+    F n00 = grad<S>(hash<S>(ix, iy, seed), fx, fy);
+    F n10 = grad<S>(hash<S>(ix1, iy, seed), fx1, fy);
+    F n01 = grad<S>(hash<S>(ix, iy1, seed), fx, fy1);
+    F n11 = grad<S>(hash<S>(ix1, iy1, seed), fx1, fy1);
+    F u = fade<S>(fx);
+    F v = fade<S>(fy);
+    F n = lerp<S>(lerp<S>(n00, n10, u), lerp<S>(n01, n11, u), v);
+    return clampUnit<S>(S::mul(n, S::set(kPerlinScale)));
+  }
+};
+
+struct SimplexNoise {
+  // (0.5 - d^2)^4 * grad, or 0 outside the corner's radius
+  template <class S>
+  static typename S::F corner(typename S::I h, typename S::F dx,
+                              typename S::F dy) {
+    using F = typename S::F;
+    F t = S::sub(S::set(0.5f), S::add(S::mul(dx, dx), S::mul(dy, dy)));
+    t = S::max(t, S::set(0.0f));
+    t = S::mul(t, t);
+    return S::mul(S::mul(t, t), grad<S>(h, dx, dy));
+  }
+
+  template <class S>
+  static typename S::F eval(typename S::F x, typename S::F y,
+                            typename S::I seed) {
+    using F = typename S::F;
+    using I = typename S::I;
+    // Skew onto the triangle lattice and find the containing simplex
+    F s = S::mul(S::add(x, y), S::set(kSimplexF2));
+    I i = S::floorI(S::add(x, s));
+    I j = S::floorI(S::add(y, s));
+    F fi = S::toF(i);
+    F fj = S::toF(j);
+    F t = S::mul(S::add(fi, fj), S::set(kSimplexG2));
+    F x0 = S::sub(x, S::sub(fi, t));
+    F y0 = S::sub(y, S::sub(fj, t));
+
+    // Lower triangle (x0 > y0) steps in x first, the upper one in y
+    auto lower = S::lt(y0, x0);
+    F i1 = S::select(lower, S::set(1.0f), S::set(0.0f));
+    F j1 = S::sub(S::set(1.0f), i1);
+    I ii1 = S::selecti(lower, S::seti(1), S::seti(0));
+    I jj1 = S::selecti(lower, S::seti(0), S::seti(1));
+
+    F x1 = S::add(S::sub(x0, i1), S::set(kSimplexG2));
+    F y1 = S::add(S::sub(y0, j1), S::set(kSimplexG2));
+    F x2 = S::add(S::sub(x0, S::set(1.0f)), S::set(2.0f * kSimplexG2));
+    F y2 = S::add(S::sub(y0, S::set(1.0f)), S::set(2.0f * kSimplexG2));
+
+    I one = S::seti(1);
+    F n = corner<S>(hash<S>(i, j, seed), x0, y0);
+    n = S::add(n, corner<S>(hash<S>(S::iadd(i, ii1), S::iadd(j, jj1), seed),
+                            x1, y1));
+    n = S::add(n, corner<S>(hash<S>(S::iadd(i, one), S::iadd(j, one), seed),
+                            x2, y2));
+    return clampUnit<S>(S::mul(n, S::set(kSimplexScale)));
+  }
+};
+
+// Worley F1: distance to the nearest of one jittered point per cell
+struct CellularNoise {
+  template <class S>
+  static typename S::F eval(typename S::F x, typename S::F y,
+                            typename S::I seed) {
+    using F = typename S::F;
+    using I = typename S::I;
+    I ix = S::floorI(x);
+    I iy = S::floorI(y);
+    F fx = S::sub(x, S::toF(ix));
+    F fy = S::sub(y, S::toF(iy));
+    const F unit = S::set(1.0f / 65536.0f);
+    F best = S::set(8.0f);
+    for (i32 dj = -1; dj <= 1; ++dj) {
+      for (i32 di = -1; di <= 1; ++di) {
+        I h = hash<S>(S::iadd(ix, S::seti(static_cast<u32>(di))),
+                      S::iadd(iy, S::seti(static_cast<u32>(dj))), seed);
+        F jx = S::mul(S::toF(S::iand(h, S::seti(0xFFFFu))), unit);
+        F jy = S::mul(S::toF(S::template srl<16>(h)), unit);
+        F dx = S::sub(S::add(S::set(static_cast<f32>(di)), jx), fx);
+        F dy = S::sub(S::add(S::set(static_cast<f32>(dj)), jy), fy);
+        best = S::min(best, S::add(S::mul(dx, dx), S::mul(dy, dy)));
+      }
+    }
+    return S::min(S::sqrt(best), S::set(1.0f));
+  }
+};
+
+// Per-octave frequency, amplitude and seed, resolved once per call
+struct Octaves {
+  u32 count = 1;
+  f32 frequency[kMaxOctaves];
+  f32 amplitude[kMaxOctaves];
+  u32 seed[kMaxOctaves];
+  f32 norm = 1.0f;
+};
+
+Octaves planOctaves(const NoiseParams &params) {
+  Octaves o;
+  o.count = std::clamp(params.octaves, 1u, kMaxOctaves);
+  f32 freq = params.frequency;
+  f32 amp = 1.0f;
+  f32 total = 0.0f;
+  for (u32 k = 0; k < o.count; ++k) {
+    o.frequency[k] = freq;
+    o.amplitude[k] = amp;
+    o.seed[k] = params.seed + k * 0x9E3779B9u;
+    total += std::fabs(amp);
+    freq *= params.lacunarity;
+    amp *= params.gain;
+  }
+  o.norm = 1.0f / total; // total >= 1: the first amplitude is 1
+  return o;
+}
+
+template <class Kernel, class S>
+typename S::F fbm(const Octaves &o, typename S::F x, typename S::F y) {
+  using F = typename S::F;
+  const F lo = S::set(-kCoordLimit);
+  const F hi = S::set(kCoordLimit);
+  F sum = S::set(0.0f);
+  for (u32 k = 0; k < o.count; ++k) {
+    const F freq = S::set(o.frequency[k]);
+    F px = S::min(S::max(S::mul(x, freq), lo), hi);
+    F py = S::min(S::max(S::mul(y, freq), lo), hi);
+    F n = Kernel::template eval<S>(px, py, S::seti(o.seed[k]));
+    sum = S::add(sum, S::mul(n, S::set(o.amplitude[k])));
+  }
+  return S::mul(sum, S::set(o.norm));
+}
+
+template <class Kernel>
+void fillRows(const Octaves &o, f32 x, f32 y, u32 width, u32 height,
+              f32 *out) {
+  for (u32 j = 0; j < height; ++j) {
+    const f32 py = y + static_cast<f32>(j);
+    f32 *row = out + static_cast<size_t>(j) * width;
+    u32 i = 0;
+#ifdef ARCANEE_NOISE_SSE2
+    const __m128 x4 = _mm_set1_ps(x);
+    const __m128 y4 = _mm_set1_ps(py);
+    __m128i lane = _mm_setr_epi32(0, 1, 2, 3);
+    for (; i + 4 <= width; i += 4) {
+      __m128 px = _mm_add_ps(x4, _mm_cvtepi32_ps(lane));
+      _mm_storeu_ps(row + i, fbm<Kernel, SseOps>(o, px, y4));
+      lane = _mm_add_epi32(lane, _mm_set1_epi32(4));
+    }
+#endif
+    for (; i < width; ++i)
+      row[i] = fbm<Kernel, ScalarOps>(o, x + static_cast<f32>(i), py);
+  }
+}
+
+template <typename T>
+void classifyInto(const f32 *values, u32 count, const f32 *thresholds,
+                  u32 thresholdCount, T *out) {
+  const f32 *end = thresholds + thresholdCount;
+  for (u32 i = 0; i < count; ++i) {
+    out[i] = static_cast<T>(std::upper_bound(thresholds, end, values[i]) -
+                            thresholds);
+  }
+}
+
+} // namespace
+
+f32 sampleNoise(const NoiseParams &params, f32 x, f32 y) {
+  const Octaves o = planOctaves(params);
+  switch (params.type) {
+  case NoiseType::Value:
+    return fbm<ValueNoise, ScalarOps>(o, x, y);
+  case NoiseType::Perlin:
+    return fbm<PerlinNoise, ScalarOps>(o, x, y);
+  case NoiseType::Simplex:
+    return fbm<SimplexNoise, ScalarOps>(o, x, y);
+  case NoiseType::Cellular:
+    return fbm<CellularNoise, ScalarOps>(o, x, y);
+  }
+  return 0.0f;
+}
+
+void fillNoise(const NoiseParams &params, f32 x, f32 y, u32 width, u32 height,
+               f32 *out) {
+  const Octaves o = planOctaves(params);
+  switch (params.type) {
+  case NoiseType::Value:
+    fillRows<ValueNoise>(o, x, y, width, height, out);
+    break;
+  case NoiseType::Perlin:
+    fillRows<PerlinNoise>(o, x, y, width, height, out);
+    break;
+  case NoiseType::Simplex:
+    fillRows<SimplexNoise>(o, x, y, width, height, out);
+    break;
+  case NoiseType::Cellular:
+    fillRows<CellularNoise>(o, x, y, width, height, out);
+    break;
+  }
+}
+
+void classify(const f32 *values, u32 count, const f32 *thresholds,
+              u32 thresholdCount, u8 *out) {
+  classifyInto(values, count, thresholds, thresholdCount, out);
+}
+
+void classify(const f32 *values, u32 count, const f32 *thresholds,
+              u32 thresholdCount, i32 *out) {
+  classifyInto(values, count, thresholds, thresholdCount, out);
+}
+
+} // namespace arcanee::procgen
@@ -0,0 +1,64 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file Noise.h
+ * @brief Deterministic 2D noise kernels for procedural generation.
+ */
+
+#include "common/Types.h"
+
+namespace arcanee::procgen {
+
+enum class NoiseType : u8 { Value, Perlin, Simplex, Cellular };
+
+/**
+ * @brief Noise settings. More than one octave sums layers of rising
+ * frequency and falling amplitude (fBm), scaled back to one layer's range.
+ */
+struct NoiseParams {
+  NoiseType type = NoiseType::Perlin;
+  u32 seed = 0;
+  f32 frequency = 1.0f / 16.0f; ///< Lattice cells per unit
+  u32 octaves = 1;              ///< Clamped to [1, kMaxOctaves]
+  f32 lacunarity = 2.0f;        ///< Frequency ratio between octaves
+  f32 gain = 0.5f;              ///< Amplitude ratio between octaves
+};
+
+constexpr u32 kMaxOctaves = 16;
+
+/**
+ * @brief Noise at (@p x, @p y). Value, Perlin and Simplex noise lie in
+ * [-1, 1]; Cellular is the distance to the nearest feature point, in [0, 1].
+ *
+ * Lattice hashing is integer arithmetic and every float operation is plain
+ * IEEE add, multiply, min, max or sqrt, so results are bit-exact across runs
+ * and agree between the SIMD and scalar paths.
+ */
+f32 sampleNoise(const NoiseParams &params, f32 x, f32 y);
+
+/**
+ * @brief Fill a @p width x @p height row-major block:
+ * out[j * width + i] = sampleNoise(params, x + i, y + j).
+ * Four samples per instruction on SSE2 targets.
+ */
+void fillNoise(const NoiseParams &params, f32 x, f32 y, u32 width, u32 height,
+               f32 *out);
+
+/**
+ * @brief Quantize values into classes, e.g. tile indices: out[i] is how
+ * many of the ascending @p thresholds are <= values[i].
+ */
+void classify(const f32 *values, u32 count, const f32 *thresholds,
+              u32 thresholdCount, u8 *out);
+void classify(const f32 *values, u32 count, const f32 *thresholds,
+              u32 thresholdCount, i32 *out);
+
+} // namespace arcanee::procgen
@@ -60,6 +60,56 @@ static void colorToRGBA(u32 color, u8 &r, u8 &g, u8 &b, u8 &a) {
   b = color & 0xFF;
 }
 
+// Stroke color, width, cap and join from the current state
+static void applyStroke(tvg::Shape &shape, const CanvasState &state, u8 r, u8 g,
+                        u8 b, u8 a) {
+  shape.stroke(r, g, b, a);
+  shape.stroke(state.lineWidth);
+
+  // Set stroke cap
+  tvg::StrokeCap cap = tvg::StrokeCap::Butt;
+  switch (state.lineCap) {
+  case LineCap::Round:
+    cap = tvg::StrokeCap::Round;
+    break;
+  case LineCap::Square:
+    cap = tvg::StrokeCap::Square;
+    break;
+  default:
+    break;
+  }
+  shape.stroke(cap);
+
+  // Set stroke join
+  tvg::StrokeJoin join = tvg::StrokeJoin::Miter;
+  switch (state.lineJoin) {
+  case LineJoin::Round:
+    join = tvg::StrokeJoin::Round;
+    break;
+  case LineJoin::Bevel:
+    join = tvg::StrokeJoin::Bevel;
+    break;
+  default:
+    break;
+  }
+  shape.stroke(join);
+}
+
+// Normalized so every rect in a merged shape winds the same way; with the
+// non-zero fill rule a flipped rect would punch a hole in its neighbours
+static void appendRectNormalized(tvg::Shape &shape, const f32 *rect) {
+  f32 x = rect[0], y = rect[1], w = rect[2], h = rect[3];
+  if (w < 0) {
+    x += w;
+    w = -w;
+  }
+  if (h < 0) {
+    y += h;
+    h = -h;
+  }
+  shape.appendRect(x, y, w, h);
+}
+
 Canvas2D::Canvas2D() : m_impl(new Impl()) {}
 
 Canvas2D::~Canvas2D() {
@@ -72,7 +122,7 @@ Canvas2D::~Canvas2D() {
   }
 }
 
-bool Canvas2D::initialize(RenderDevice &device, u32 width, u32 height) {
+bool Canvas2D::initCpuTarget(u32 width, u32 height) {
   if (tvg::Initializer::init(tvg::CanvasEngine::Sw, 0) !=
       tvg::Result::Success) {
     LOG_ERROR("Canvas2D: Failed to initialize ThorVG");
@@ -93,6 +143,16 @@ bool Canvas2D::initialize(RenderDevice &device, u32 width, u32 height) {
 
   m_impl->canvas->target(m_impl->cpuBuffer.data(), width, width, height,
                          tvg::SwCanvas::ARGB8888);
+  return true;
+}
+
+bool Canvas2D::initializeOffscreen(u32 width, u32 height) {
+  return initCpuTarget(width, height);
+}
+
+bool Canvas2D::initialize(RenderDevice &device, u32 width, u32 height) {
+  if (!initCpuTarget(width, height))
+    return false;
 
   auto *pDevice = static_cast<IRenderDevice *>(device.getDevice());
   if (!pDevice) {
@@ -170,6 +230,7 @@ void Canvas2D::beginFrame() {
     m_impl->canvas->clear(true);
   }
   m_stateStack.reset(); // Reset to default state each frame
+  m_frameArena.reset();
 }
 
 void Canvas2D::endFrame(RenderDevice &device) {
@@ -372,36 +433,7 @@ void Canvas2D::stroke() {
   colorToRGBA(state.strokeColor, r, g, b, a);
   a = static_cast<u8>(a * state.globalAlpha);
 
-  m_impl->currentPath->stroke(r, g, b, a);
-  m_impl->currentPath->stroke(state.lineWidth);
-
-  // Set stroke cap
-  tvg::StrokeCap cap = tvg::StrokeCap::Butt;
-  switch (state.lineCap) {
-  case LineCap::Round:
-    cap = tvg::StrokeCap::Round;
-    break;
-  case LineCap::Square:
-    cap = tvg::StrokeCap::Square;
-    break;
-  default:
-    break;
-  }
-  m_impl->currentPath->stroke(cap);
-
-  // Set stroke join
-  tvg::StrokeJoin join = tvg::StrokeJoin::Miter;
-  switch (state.lineJoin) {
-  case LineJoin::Round:
-    join = tvg::StrokeJoin::Round;
-    break;
-  case LineJoin::Bevel:
-    join = tvg::StrokeJoin::Bevel;
-    break;
-  default:
-    break;
-  }
-  m_impl->currentPath->stroke(join);
+  applyStroke(*m_impl->currentPath, state, r, g, b, a);
 
   m_impl->canvas->push(std::move(m_impl->currentPath));
   m_impl->currentPath = nullptr;
@@ -450,6 +482,137 @@ void Canvas2D::clearRect(f32 x, f32 y, f32 w, f32 h) {
   m_impl->canvas->push(std::move(shape));
 }
 
+// ===== Batches =====
+void Canvas2D::fillRects(const f32 *rects, u32 count, const u32 *colors) {
+  if (!m_impl || !m_impl->canvas || !rects)
+    return;
+
+  const auto &state = m_stateStack.current();
+  u32 i = 0;
+  while (i < count) {
+    u32 color = colors ? colors[i] : state.fillColor;
+    u8 r, g, b, a;
+    colorToRGBA(color, r, g, b, a);
+    a = static_cast<u8>(a * state.globalAlpha);
+
+    auto shape = tvg::Shape::gen();
+    appendRectNormalized(*shape, rects + i * 4);
+    u32 end = i + 1;
+    if (a == 255) {
+      while (end < count && (colors ? colors[end] : color) == color) {
+        appendRectNormalized(*shape, rects + end * 4);
+        ++end;
+      }
+    }
+
+    shape->fill(r, g, b, a);
+    m_impl->canvas->push(std::move(shape));
+    i = end;
+  }
+}
+
+void Canvas2D::strokeLines(const f32 *segments, u32 count) {
+  if (!m_impl || !m_impl->canvas || !segments)
+    return;
+
+  const auto &state = m_stateStack.current();
+  u8 r, g, b, a;
+  colorToRGBA(state.strokeColor, r, g, b, a);
+  a = static_cast<u8>(a * state.globalAlpha);
+
+  u32 i = 0;
+  while (i < count) {
+    auto shape = tvg::Shape::gen();
+    u32 end = (a == 255) ? count : i + 1;
+    for (; i < end; ++i) {
+      const f32 *seg = segments + i * 4;
+      shape->moveTo(seg[0], seg[1]);
+      shape->lineTo(seg[2], seg[3]);
+    }
+    applyStroke(*shape, state, r, g, b, a);
+    m_impl->canvas->push(std::move(shape));
+  }
+}
+
+void Canvas2D::drawImages(const SpriteInstance *sprites, u32 count) {
+  if (!m_impl || !m_impl->canvas || !sprites)
+    return;
+
+  const auto &state = m_stateStack.current();
+  u8 opacity = static_cast<u8>(state.globalAlpha * 255);
+
+  // Batches are usually long runs of one image; skip the map lookup for them
+  u32 lastHandle = 0;
+  tvg::Picture *source = nullptr;
+  for (u32 i = 0; i < count; ++i) {
+    const auto &sprite = sprites[i];
+    if (sprite.image != lastHandle || !source) {
+      auto it = m_impl->images.find(sprite.image);
+      source = (it != m_impl->images.end()) ? it->second.get() : nullptr;
+      lastHandle = sprite.image;
+    }
+    if (!source)
+      continue;
+
+    auto pic = tvg::cast<tvg::Picture>(source->duplicate());
+    if (!pic)
+      continue;
+    pic->translate(sprite.x, sprite.y);
+    if (state.globalAlpha < 1.0f) {
+      pic->opacity(opacity);
+    }
+    m_impl->canvas->push(std::move(pic));
+  }
+}
+
+void Canvas2D::drawImageRects(const ImageRect *rects, u32 count) {
+  if (!m_impl || !m_impl->canvas || !rects)
+    return;
+
+  const auto &state = m_stateStack.current();
+
+  u32 lastHandle = 0;
+  tvg::Picture *source = nullptr;
+  f32 imageW = 0.0f, imageH = 0.0f;
+  for (u32 i = 0; i < count; ++i) {
+    const ImageRect &r = rects[i];
+    if (r.image != lastHandle || !source) {
+      auto it = m_impl->images.find(r.image);
+      source = (it != m_impl->images.end()) ? it->second.get() : nullptr;
+      lastHandle = r.image;
+      if (source)
+        source->size(&imageW, &imageH);
+    }
+    if (!source || r.sw <= 0 || r.sh <= 0)
+      continue;
+
+    auto pic = tvg::cast<tvg::Picture>(source->duplicate());
+    if (!pic)
+      continue;
+    // Scale the whole image so the source rect spans the dest rect, then
+    // clip to the dest rect
+    f32 scaleX = r.dw / static_cast<f32>(r.sw);
+    f32 scaleY = r.dh / static_cast<f32>(r.sh);
+    pic->size(imageW * scaleX, imageH * scaleY);
+    pic->translate(r.dx - static_cast<f32>(r.sx) * scaleX,
+                   r.dy - static_cast<f32>(r.sy) * scaleY);
+    bool whole = r.sx == 0 && r.sy == 0 &&
+                 static_cast<f32>(r.sw) == imageW &&
+                 static_cast<f32>(r.sh) == imageH;
+    if (!whole) {
+      auto clip = tvg::Shape::gen();
+      const f32 dest[4] = {r.dx, r.dy, r.dw, r.dh};
+      appendRectNormalized(*clip, dest);
+      pic->composite(std::move(clip), tvg::CompositeMethod::ClipPath);
+    }
+    const f32 alpha = state.globalAlpha * r.alpha;
+    if (alpha < 1.0f) {
+      pic->opacity(static_cast<u8>(alpha * 255));
+    }
+    m_impl->canvas->push(std::move(pic));
+  }
+}
+
 // ===== GPU Interface =====
 void *Canvas2D::getShaderResourceView() {
   return m_impl ? m_impl->pSRV : nullptr;
@@ -527,36 +690,8 @@ void Canvas2D::drawImage(u32 handle, f32 x, f32 y) {
 
 void Canvas2D::drawImageRect(u32 handle, i32 sx, i32 sy, i32 sw, i32 sh, f32 dx,
                              f32 dy, f32 dw, f32 dh) {
-  if (!m_impl || !m_impl->canvas)
-    return;
-
-  auto it = m_impl->images.find(handle);
-  if (it == m_impl->images.end())
-    return;
-
-  // Clone and scale
-  auto pic = tvg::cast<tvg::Picture>(it->second->duplicate());
-  if (!pic)
-    return;
-
-  // Set viewport for source rect (ThorVG doesn't directly support this)
-  // For v0.1, we scale the whole image to dest rect
-  (void)sx;
-  (void)sy;
-  (void)sw;
-  (void)sh; // TODO: implement source rect
-
-  float origW, origH;
-  pic->size(&origW, &origH);
-  pic->size(dw, dh);
-  pic->translate(dx, dy);
-
-  const auto &state = m_stateStack.current();
-  if (state.globalAlpha < 1.0f) {
-    pic->opacity(static_cast<u8>(state.globalAlpha * 255));
-  }
-
-  m_impl->canvas->push(std::move(pic));
+  const ImageRect rect = {handle, sx, sy, sw, sh, dx, dy, dw, dh};
+  drawImageRects(&rect, 1);
 }
 
 // ===== Text (§6.3.8) =====
@@ -681,8 +816,9 @@ bool Canvas2D::paintSetStops(u32 handle, const f32 *offsets, const u32 *colors,
   if (it == m_impl->paints.end())
     return false;
 
-  // Build ThorVG color stops
-  std::vector<tvg::Fill::ColorStop> stops(count);
+  // Build ThorVG color stops (copied by colorStops())
+  FrameArena::Scope scratch(m_frameArena);
+  auto *stops = m_frameArena.allocArray<tvg::Fill::ColorStop>(count);
   for (u32 i = 0; i < count; ++i) {
     u8 r, g, b, a;
     colorToRGBA(colors[i], r, g, b, a);
@@ -693,7 +829,7 @@ bool Canvas2D::paintSetStops(u32 handle, const f32 *offsets, const u32 *colors,
     stops[i].a = a;
   }
 
-  it->second->colorStops(stops.data(), count);
+  it->second->colorStops(stops, count);
   return true;
 }
 
@@ -720,26 +856,27 @@ void Canvas2D::setStrokePaint(u32 handle) {
 }
 
 // ===== Blend Modes (§6.3.2) =====
-bool Canvas2D::setBlend(const char *mode) {
-  if (!mode)
-    return false;
+bool Canvas2D::parseBlendMode(std::string_view name, BlendMode &out) {
+  static constexpr struct {
+    std::string_view name;
+    BlendMode mode;
+  } kModes[] = {
+      {"normal", BlendMode::Normal},   {"multiply", BlendMode::Multiply},
+      {"screen", BlendMode::Screen},   {"overlay", BlendMode::Overlay},
+      {"darken", BlendMode::Darken},   {"lighten", BlendMode::Lighten},
+  };
+  for (const auto &entry : kModes) {
+    if (entry.name == name) {
+      out = entry.mode;
+      return true;
+    }
+  }
+  return false;
+}
 
-  std::string m(mode);
-  BlendMode blend = BlendMode::Normal;
-
-  if (m == "normal")
-    blend = BlendMode::Normal;
-  else if (m == "multiply")
-    blend = BlendMode::Multiply;
-  else if (m == "screen")
-    blend = BlendMode::Screen;
-  else if (m == "overlay")
-    blend = BlendMode::Overlay;
-  else if (m == "darken")
-    blend = BlendMode::Darken;
-  else if (m == "lighten")
-    blend = BlendMode::Lighten;
-  else
+bool Canvas2D::setBlend(std::string_view mode) {
+  BlendMode blend;
+  if (!parseBlendMode(mode, blend))
     return false; // unsupported mode
 
   m_stateStack.current().blendMode = blend;
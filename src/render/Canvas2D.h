@@ -1,7 +1,9 @@
 #pragma once
 
 #include "CanvasState.h"
+#include "common/FrameArena.h"
 #include "common/Types.h"
+#include <string_view>
 
 namespace arcanee::render {
 
@@ -26,6 +28,8 @@ public:
 
   // ===== Lifecycle =====
   bool initialize(RenderDevice &device, u32 width, u32 height);
+  /// Render into a CPU buffer only, with no GPU texture (tests and tools).
+  bool initializeOffscreen(u32 width, u32 height);
   bool resize(RenderDevice &device, u32 width, u32 height);
   void beginFrame();
   void endFrame(RenderDevice &device);
@@ -75,6 +79,33 @@ public:
   void strokeRect(f32 x, f32 y, f32 w, f32 h);
   void clearRect(f32 x, f32 y, f32 w, f32 h);
 
+  // ===== Batches =====
+  // One call per batch instead of per primitive. Runs of opaque primitives
+  // with the same color share one shape; translucent ones stay separate so
+  // overlaps still blend per primitive, keeping output identical.
+
+  /// @param rects x,y,w,h per rect. @param colors Per-rect ARGB, or null for
+  /// the current fill color.
+  void fillRects(const f32 *rects, u32 count, const u32 *colors = nullptr);
+  /// @param segments x0,y0,x1,y1 per segment, stroked with the current style.
+  void strokeLines(const f32 *segments, u32 count);
+
+  struct SpriteInstance {
+    u32 image;
+    f32 x;
+    f32 y;
+  };
+  void drawImages(const SpriteInstance *sprites, u32 count);
+
+  /// Source rect (pixels of the image) drawn scaled into a dest rect.
+  struct ImageRect {
+    u32 image;
+    i32 sx, sy, sw, sh;
+    f32 dx, dy, dw, dh;
+    f32 alpha = 1.0f; ///< Times the global alpha
+  };
+  void drawImageRects(const ImageRect *rects, u32 count);
+
   // ===== Images (§6.3.6) =====
   u32 loadImage(const char *path);
   void freeImage(u32 handle);
@@ -102,19 +133,26 @@ public:
   void setStrokePaint(u32 handle);
 
   // ===== Blend Modes (§6.3.2) =====
-  bool setBlend(const char *mode);
+  bool setBlend(std::string_view mode);
+  /// Maps "normal", "multiply", ... to a BlendMode; false if unknown.
+  static bool parseBlendMode(std::string_view name, BlendMode &out);
 
   // ===== GPU Interface =====
   void *getShaderResourceView();
   bool isValid() const;
 
 private:
+  bool initCpuTarget(u32 width, u32 height);
+
   struct Impl;
   Impl *m_impl = nullptr;
 
   u32 m_width = 0;
   u32 m_height = 0;
   CanvasStateStack m_stateStack;
+
+  // Temporaries handed to ThorVG; reset by beginFrame()
+  FrameArena m_frameArena;
 };
 
 } // namespace arcanee::render
@@ -0,0 +1,239 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file ParticleSystem.cpp
+ */
+
+#include "ParticleSystem.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) ||                                     \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define ARCANEE_PARTICLES_SSE 1
+#endif
+
+namespace arcanee::render {
+
+namespace {
+
+constexpr f32 kMinLife = 1.0f / 1000.0f;
+
+f32 lerp(f32 a, f32 b, f32 t) { return a + (b - a) * t; }
+
+f32 uniform(Xorshift128Plus &rng, f32 lo, f32 hi) {
+  return lerp(lo, hi, static_cast<f32>(rng.randFloat()));
+}
+
+// Per-channel ARGB blend with 8-bit weights, two channels per multiply
+u32 lerpColor(u32 a, u32 b, f32 t) {
+  const u32 wb = static_cast<u32>(t * 256.0f + 0.5f);
+  const u32 wa = 256 - wb;
+  const u32 aRB = a & 0x00FF00FFu;
+  const u32 aAG = (a >> 8) & 0x00FF00FFu;
+  const u32 bRB = b & 0x00FF00FFu;
+  const u32 bAG = (b >> 8) & 0x00FF00FFu;
+  u32 rb = aRB * wa + bRB * wb + 0x00800080u;
+  u32 ag = aAG * wa + bAG * wb + 0x00800080u;
+  return ((rb >> 8) & 0x00FF00FFu) | (ag & 0xFF00FF00u);
+}
+
+// vel = (vel + accel) * damp; pos += vel * dt
+void integrateAxis(f32 *pos, f32 *vel, u32 n, f32 accel, f32 damp, f32 dt) {
+  u32 i = 0;
+#ifdef ARCANEE_PARTICLES_SSE
+  const __m128 a4 = _mm_set1_ps(accel);
+  const __m128 d4 = _mm_set1_ps(damp);
+  const __m128 dt4 = _mm_set1_ps(dt);
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(vel + i), a4), d4);
+    _mm_storeu_ps(vel + i, v);
+    _mm_storeu_ps(pos + i,
+                  _mm_add_ps(_mm_loadu_ps(pos + i), _mm_mul_ps(v, dt4)));
+  }
+#endif
+  for (; i < n; ++i) {
+    vel[i] = (vel[i] + accel) * damp;
+    pos[i] += vel[i] * dt;
+  }
+}
+
+// age += rate * dt
+void advanceAge(f32 *age, const f32 *rate, u32 n, f32 dt) {
+  u32 i = 0;
+#ifdef ARCANEE_PARTICLES_SSE
+  const __m128 dt4 = _mm_set1_ps(dt);
+  for (; i + 4 <= n; i += 4) {
+    _mm_storeu_ps(age + i, _mm_add_ps(_mm_loadu_ps(age + i),
+                                      _mm_mul_ps(_mm_loadu_ps(rate + i), dt4)));
+  }
+#endif
+  for (; i < n; ++i)
+    age[i] += rate[i] * dt;
+}
+
+} // namespace
+
+u32 ParticleSystem::createEmitter(const EmitterParams &params, u64 seed) {
+  u32 handle = m_nextHandle++;
+  if (m_nextHandle == 0)
+    m_nextHandle = 1;
+  Emitter &e = m_emitters[handle];
+  e.params = params;
+  e.rng.setSeed(seed != 0 ? seed : handle);
+  resize(e);
+  return handle;
+}
+
+bool ParticleSystem::destroyEmitter(u32 handle) {
+  return m_emitters.erase(handle) > 0;
+}
+
+void ParticleSystem::clear() {
+  // m_nextHandle keeps counting so old handles stay unknown
+  m_emitters.clear();
+}
+
+const EmitterParams *ParticleSystem::getParams(u32 handle) const {
+  auto it = m_emitters.find(handle);
+  return it != m_emitters.end() ? &it->second.params : nullptr;
+}
+
+bool ParticleSystem::setParams(u32 handle, const EmitterParams &params) {
+  auto it = m_emitters.find(handle);
+  if (it == m_emitters.end())
+    return false;
+  it->second.params = params;
+  resize(it->second);
+  return true;
+}
+
+u32 ParticleSystem::burst(u32 handle, u32 count) {
+  auto it = m_emitters.find(handle);
+  return it != m_emitters.end() ? spawn(it->second, count) : 0;
+}
+
+void ParticleSystem::step(f32 dt) {
+  if (!(dt > 0.0f))
+    return;
+  for (auto &[handle, e] : m_emitters) {
+    integrate(e, dt);
+    expire(e);
+
+    f32 owed = e.spawnCarry + std::max(e.params.rate, 0.0f) * dt;
+    f32 whole = std::floor(owed);
+    e.spawnCarry = owed - whole;
+    spawn(e, static_cast<u32>(std::min(whole, 1.0e9f)));
+  }
+}
+
+void ParticleSystem::resize(Emitter &e) {
+  u32 cap = std::min(e.params.maxParticles, kMaxParticlesPerEmitter);
+  e.params.maxParticles = cap;
+  e.count = std::min(e.count, cap);
+  e.px.resize(cap);
+  e.py.resize(cap);
+  e.vx.resize(cap);
+  e.vy.resize(cap);
+  e.age.resize(cap);
+  e.ageRate.resize(cap);
+}
+
+u32 ParticleSystem::spawn(Emitter &e, u32 count) {
+  const EmitterParams &p = e.params;
+  count = std::min(count, p.maxParticles - e.count);
+  for (u32 n = 0; n < count; ++n) {
+    u32 i = e.count++;
+    e.px[i] = p.x + static_cast<f32>(e.rng.randFloat()) * p.w;
+    e.py[i] = p.y + static_cast<f32>(e.rng.randFloat()) * p.h;
+    f32 dir = p.angle + (static_cast<f32>(e.rng.randFloat()) - 0.5f) * p.spread;
+    f32 speed = uniform(e.rng, p.speedMin, p.speedMax);
+    e.vx[i] = std::cos(dir) * speed;
+    e.vy[i] = std::sin(dir) * speed;
+    e.age[i] = 0.0f;
+    e.ageRate[i] = 1.0f / std::max(uniform(e.rng, p.lifeMin, p.lifeMax),
+                                   kMinLife);
+  }
+  return count;
+}
+
+void ParticleSystem::integrate(Emitter &e, f32 dt) {
+  // Four particles per instruction on SSE targets; the scalar path gives the
+  // same results lane for lane
+  const u32 n = e.count;
+  const f32 damp = std::max(1.0f - e.params.drag * dt, 0.0f);
+  integrateAxis(e.px.data(), e.vx.data(), n, e.params.gravityX * dt, damp, dt);
+  integrateAxis(e.py.data(), e.vy.data(), n, e.params.gravityY * dt, damp, dt);
+  advanceAge(e.age.data(), e.ageRate.data(), n, dt);
+}
+
+void ParticleSystem::expire(Emitter &e) {
+  // Stable, so the survivors keep their oldest-first order
+  u32 alive = 0;
+  for (u32 i = 0; i < e.count; ++i) {
+    if (e.age[i] >= 1.0f)
+      continue;
+    if (alive != i) {
+      e.px[alive] = e.px[i];
+      e.py[alive] = e.py[i];
+      e.vx[alive] = e.vx[i];
+      e.vy[alive] = e.vy[i];
+      e.age[alive] = e.age[i];
+      e.ageRate[alive] = e.ageRate[i];
+    }
+    alive++;
+  }
+  e.count = alive;
+}
+
+u32 ParticleSystem::writeInstances(u32 handle, f32 *rects,
+                                   u32 *colors) const {
+  auto it = m_emitters.find(handle);
+  if (it == m_emitters.end())
+    return 0;
+  const Emitter &e = it->second;
+  const EmitterParams &p = e.params;
+  const bool fixedColor = p.colorStart == p.colorEnd;
+
+  for (u32 i = 0; i < e.count; ++i) {
+    f32 t = e.age[i];
+    f32 size = lerp(p.sizeStart, p.sizeEnd, t);
+    f32 *r = rects + 4 * static_cast<size_t>(i);
+    r[0] = e.px[i] - size * 0.5f;
+    r[1] = e.py[i] - size * 0.5f;
+    r[2] = size;
+    r[3] = size;
+    colors[i] = fixedColor ? p.colorStart
+                           : lerpColor(p.colorStart, p.colorEnd, t);
+  }
+  return e.count;
+}
+
+u32 ParticleSystem::count(u32 handle) const {
+  auto it = m_emitters.find(handle);
+  return it != m_emitters.end() ? it->second.count : 0;
+}
+
+u32 ParticleSystem::totalCount() const {
+  u32 total = 0;
+  for (const auto &[handle, e] : m_emitters)
+    total += e.count;
+  return total;
+}
+
+std::vector<u32> ParticleSystem::handles() const {
+  std::vector<u32> out;
+  out.reserve(m_emitters.size());
+  for (const auto &[handle, e] : m_emitters)
+    out.push_back(handle);
+  return out;
+}
+
+} // namespace arcanee::render
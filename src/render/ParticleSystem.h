@@ -0,0 +1,118 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file ParticleSystem.h
+ * @brief Native particle emitters, simulated on the fixed tick.
+ */
+
+#include "common/Random.h"
+#include "common/Types.h"
+#include <map>
+#include <vector>
+
+namespace arcanee::render {
+
+/**
+ * @brief Emitter settings. Angles are in radians; rates and drag are per
+ * second. Colors are ARGB, interpolated per channel over a particle's life.
+ */
+struct EmitterParams {
+  f32 x = 0.0f; ///< Spawn box
+  f32 y = 0.0f;
+  f32 w = 0.0f;
+  f32 h = 0.0f;
+  f32 rate = 0.0f; ///< Particles spawned per second
+  f32 lifeMin = 1.0f;
+  f32 lifeMax = 1.0f;
+  f32 speedMin = 0.0f;
+  f32 speedMax = 0.0f;
+  f32 angle = 0.0f;        ///< Launch direction
+  f32 spread = 6.2831853f; ///< Direction range centered on angle
+  f32 gravityX = 0.0f;
+  f32 gravityY = 0.0f;
+  f32 drag = 0.0f; ///< Fraction of velocity lost per second
+  f32 sizeStart = 2.0f;
+  f32 sizeEnd = 2.0f;
+  u32 colorStart = 0xFFFFFFFFu;
+  u32 colorEnd = 0x00FFFFFFu;
+  u32 maxParticles = 1024;
+};
+
+/**
+ * @brief Owns every emitter of a cartridge.
+ *
+ * Particles are stored as structure-of-arrays per emitter and never touch
+ * the script heap. step() integrates them with branch-free loops over the
+ * arrays, which the compiler vectorizes, then drops expired ones with a
+ * stable compaction so the draw order stays oldest first. Spawning draws
+ * from a per-emitter Xorshift128+ seeded at creation, so a given sequence of
+ * calls and ticks always produces the same particles.
+ */
+class ParticleSystem {
+public:
+  static constexpr u32 kMaxParticlesPerEmitter = 262144;
+
+  /// @param seed Spawn RNG seed; 0 seeds from the handle.
+  /// @return Emitter handle (never 0).
+  u32 createEmitter(const EmitterParams &params, u64 seed = 0);
+  bool destroyEmitter(u32 handle);
+  /// Destroy every emitter. Handles are never reissued.
+  void clear();
+
+  /// Current settings, or null for an unknown handle.
+  const EmitterParams *getParams(u32 handle) const;
+  /// Replace the settings. Lowering maxParticles drops the newest particles.
+  bool setParams(u32 handle, const EmitterParams &params);
+
+  /// Spawn up to @p count particles now. @return Particles spawned.
+  u32 burst(u32 handle, u32 count);
+
+  /// Advance every emitter by @p dt seconds: move, age, expire, then spawn.
+  void step(f32 dt);
+
+  /**
+   * @brief Fill draw data for one emitter, oldest particle first.
+   * @param rects x, y, w, h per particle; room for count(handle) entries.
+   * @param colors ARGB per particle.
+   * @return Particles written.
+   */
+  u32 writeInstances(u32 handle, f32 *rects, u32 *colors) const;
+
+  u32 count(u32 handle) const;
+  u32 totalCount() const;
+  u32 emitterCount() const { return static_cast<u32>(m_emitters.size()); }
+
+  /// Handles in creation order.
+  std::vector<u32> handles() const;
+
+private:
+  struct Emitter {
+    EmitterParams params;
+    Xorshift128Plus rng;
+    f32 spawnCarry = 0.0f; // Fraction of a particle owed by rate
+    u32 count = 0;
+    // Particles [0, count); sized to params.maxParticles
+    std::vector<f32> px, py, vx, vy;
+    std::vector<f32> age;     // 0 at spawn, 1 at death
+    std::vector<f32> ageRate; // 1 / lifetime
+  };
+
+  static void resize(Emitter &e);
+  static u32 spawn(Emitter &e, u32 count);
+  static void integrate(Emitter &e, f32 dt);
+  static void expire(Emitter &e);
+
+  // Ordered so step() and handles() visit emitters in creation order
+  std::map<u32, Emitter> m_emitters;
+  u32 m_nextHandle = 1;
+};
+
+} // namespace arcanee::render
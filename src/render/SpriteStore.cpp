@@ -0,0 +1,355 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file SpriteStore.cpp
+ */
+
+#include "SpriteStore.h"
+#include <algorithm>
+#include <cmath>
+
+namespace arcanee::render {
+
+namespace {
+
+constexpr u32 kGenerationMask = (1u << (32 - SpriteStore::kSlotBits)) - 1;
+
+u32 makeHandle(u32 slot, u32 generation) {
+  return (generation << SpriteStore::kSlotBits) | (slot + 1);
+}
+
+// Invalidates every handle to the slot. False once the generation is used
+// up: wrapping it would revive handles issued long ago.
+bool nextGeneration(u16 &generation) {
+  if (generation == kGenerationMask)
+    return false;
+  ++generation;
+  return true;
+}
+
+// Moves the last element of every array into index @p i and shrinks them
+template <typename... Arrays> void removeSwap(u32 i, Arrays &...arrays) {
+  ((arrays[i] = arrays.back(), arrays.pop_back()), ...);
+}
+
+template <typename... Arrays> void clearAll(Arrays &...arrays) {
+  (arrays.clear(), ...);
+}
+
+} // namespace
+
+u32 SpriteStore::defineSheet(const SpriteSheet &sheet) {
+  if (sheet.frameW == 0 || sheet.frameH == 0)
+    return 0;
+  m_sheets.push_back(sheet);
+  m_sheets.back().columns = std::max(sheet.columns, 1u);
+  return m_sheetBase + static_cast<u32>(m_sheets.size());
+}
+
+const SpriteSheet *SpriteStore::getSheet(u32 id) const {
+  return id > m_sheetBase && id - m_sheetBase <= m_sheets.size()
+             ? &m_sheets[id - m_sheetBase - 1]
+             : nullptr;
+}
+
+u32 SpriteStore::create(const SpriteState &state) {
+  if (!getSheet(state.sheet))
+    return 0;
+
+  u32 slot;
+  if (!m_freeSlots.empty()) {
+    slot = m_freeSlots.front();
+    m_freeSlots.pop_front();
+  } else if (m_denseOf.size() < kMaxSprites) {
+    slot = static_cast<u32>(m_denseOf.size());
+    m_denseOf.push_back(kNone);
+    m_generation.push_back(1);
+  } else {
+    return 0;
+  }
+
+  m_denseOf[slot] = count();
+  m_slotOf.push_back(slot);
+  m_x.push_back(0.0f);
+  m_y.push_back(0.0f);
+  m_vx.push_back(0.0f);
+  m_vy.push_back(0.0f);
+  m_ax.push_back(0.0f);
+  m_ay.push_back(0.0f);
+  m_layer.push_back(0);
+  m_sheet.push_back(0);
+  m_frame.push_back(0);
+  m_scale.push_back(1.0f);
+  m_alpha.push_back(1.0f);
+  m_visible.push_back(1);
+  m_animFirst.push_back(0);
+  m_animCount.push_back(0);
+  m_animFps.push_back(0.0f);
+  m_animTime.push_back(0.0f);
+  m_animLoop.push_back(0);
+
+  u32 handle = makeHandle(slot, m_generation[slot]);
+  setState(handle, state);
+  m_orderDirty = true;
+  return handle;
+}
+
+bool SpriteStore::destroy(u32 handle) {
+  u32 i = denseIndex(handle);
+  if (i == kNone)
+    return false;
+
+  u32 slot = m_slotOf[i];
+  m_denseOf[m_slotOf.back()] = i;
+  removeSwap(i, m_slotOf, m_x, m_y, m_vx, m_vy, m_ax, m_ay, m_layer, m_sheet,
+             m_frame, m_scale, m_alpha, m_visible, m_animFirst, m_animCount,
+             m_animFps, m_animTime, m_animLoop);
+
+  releaseSlot(slot);
+  m_orderDirty = true;
+  return true;
+}
+
+bool SpriteStore::alive(u32 handle) const {
+  return denseIndex(handle) != kNone;
+}
+
+void SpriteStore::clear() {
+  // Retire the slots instead of forgetting them, so handles and sheet ids
+  // issued before the clear stay invalid afterwards
+  for (u32 slot : m_slotOf)
+    releaseSlot(slot);
+  m_sheetBase += static_cast<u32>(m_sheets.size());
+  clearAll(m_sheets, m_order);
+  clearAll(m_slotOf, m_x, m_y, m_vx, m_vy, m_ax, m_ay, m_layer, m_sheet,
+           m_frame, m_scale, m_alpha, m_visible, m_animFirst, m_animCount,
+           m_animFps, m_animTime, m_animLoop);
+  m_orderDirty = false;
+}
+
+void SpriteStore::releaseSlot(u32 slot) {
+  m_denseOf[slot] = kNone;
+  // Oldest first, so a slot's generations run out as late as possible; a
+  // slot whose generations have run out is never reused
+  if (nextGeneration(m_generation[slot]))
+    m_freeSlots.push_back(slot);
+}
+
+u32 SpriteStore::denseIndex(u32 handle) const {
+  u32 slot = (handle & kMaxSprites) - 1;
+  if (slot >= m_denseOf.size() ||
+      m_generation[slot] != handle >> kSlotBits) {
+    return kNone;
+  }
+  return m_denseOf[slot];
+}
+
+bool SpriteStore::getState(u32 handle, SpriteState &out) const {
+  u32 i = denseIndex(handle);
+  if (i == kNone)
+    return false;
+  out.sheet = m_sheet[i];
+  out.x = m_x[i];
+  out.y = m_y[i];
+  out.vx = m_vx[i];
+  out.vy = m_vy[i];
+  out.ax = m_ax[i];
+  out.ay = m_ay[i];
+  out.layer = m_layer[i];
+  out.frame = m_frame[i];
+  out.scale = m_scale[i];
+  out.alpha = m_alpha[i];
+  out.visible = m_visible[i] != 0;
+  return true;
+}
+
+bool SpriteStore::setState(u32 handle, const SpriteState &state) {
+  u32 i = denseIndex(handle);
+  if (i == kNone || !getSheet(state.sheet))
+    return false;
+  if (state.layer != m_layer[i] || state.sheet != m_sheet[i])
+    m_orderDirty = true;
+  if (state.frame != m_frame[i])
+    m_animCount[i] = 0;
+  m_sheet[i] = state.sheet;
+  m_x[i] = state.x;
+  m_y[i] = state.y;
+  m_vx[i] = state.vx;
+  m_vy[i] = state.vy;
+  m_ax[i] = state.ax;
+  m_ay[i] = state.ay;
+  m_layer[i] = state.layer;
+  m_frame[i] = state.frame;
+  m_scale[i] = state.scale;
+  m_alpha[i] = state.alpha;
+  m_visible[i] = state.visible ? 1 : 0;
+  return true;
+}
+
+bool SpriteStore::setPosition(u32 handle, f32 x, f32 y) {
+  u32 i = denseIndex(handle);
+  if (i == kNone)
+    return false;
+  m_x[i] = x;
+  m_y[i] = y;
+  return true;
+}
+
+bool SpriteStore::setVelocity(u32 handle, f32 vx, f32 vy) {
+  u32 i = denseIndex(handle);
+  if (i == kNone)
+    return false;
+  m_vx[i] = vx;
+  m_vy[i] = vy;
+  return true;
+}
+
+bool SpriteStore::getProperty(u32 handle, SpriteProperty property,
+                              f32 &out) const {
+  u32 i = denseIndex(handle);
+  if (i == kNone)
+    return false;
+  switch (property) {
+  case SpriteProperty::X:
+    out = m_x[i];
+    break;
+  case SpriteProperty::Y:
+    out = m_y[i];
+    break;
+  case SpriteProperty::Scale:
+    out = m_scale[i];
+    break;
+  case SpriteProperty::Alpha:
+    out = m_alpha[i];
+    break;
+  }
+  return true;
+}
+
+bool SpriteStore::setProperty(u32 handle, SpriteProperty property, f32 value) {
+  u32 i = denseIndex(handle);
+  if (i == kNone)
+    return false;
+  switch (property) {
+  case SpriteProperty::X:
+    m_x[i] = value;
+    break;
+  case SpriteProperty::Y:
+    m_y[i] = value;
+    break;
+  case SpriteProperty::Scale:
+    m_scale[i] = value;
+    break;
+  case SpriteProperty::Alpha:
+    m_alpha[i] = value;
+    break;
+  }
+  return true;
+}
+
+bool SpriteStore::play(u32 handle, u32 first, u32 count, f32 fps, bool loop) {
+  u32 i = denseIndex(handle);
+  if (i == kNone)
+    return false;
+  m_frame[i] = first;
+  m_animFirst[i] = first;
+  m_animCount[i] = fps > 0.0f ? count : 0;
+  m_animFps[i] = fps;
+  m_animTime[i] = 0.0f;
+  m_animLoop[i] = loop ? 1 : 0;
+  return true;
+}
+
+bool SpriteStore::playing(u32 handle) const {
+  u32 i = denseIndex(handle);
+  return i != kNone && m_animCount[i] != 0;
+}
+
+void SpriteStore::step(f32 dt) {
+  const u32 n = count();
+  // Semi-implicit Euler: velocity first, then position
+  f32 *x = m_x.data(), *y = m_y.data();
+  f32 *vx = m_vx.data(), *vy = m_vy.data();
+  const f32 *ax = m_ax.data(), *ay = m_ay.data();
+  for (u32 i = 0; i < n; ++i) {
+    vx[i] += ax[i] * dt;
+    vy[i] += ay[i] * dt;
+    x[i] += vx[i] * dt;
+    y[i] += vy[i] * dt;
+  }
+
+  for (u32 i = 0; i < n; ++i) {
+    const u32 frames = m_animCount[i];
+    if (frames == 0)
+      continue;
+    f32 t = m_animTime[i] + dt;
+    const f32 length = static_cast<f32>(frames) / m_animFps[i];
+    u32 index;
+    if (m_animLoop[i]) {
+      // Wrap so the timer keeps its precision on long loops
+      if (t >= length)
+        t = std::fmod(t, length);
+      index = std::min(static_cast<u32>(t * m_animFps[i]), frames - 1);
+    } else if (t >= length) {
+      index = frames - 1;
+      m_animCount[i] = 0;
+    } else {
+      index = std::min(static_cast<u32>(t * m_animFps[i]), frames - 1);
+    }
+    m_animTime[i] = t;
+    m_frame[i] = m_animFirst[i] + index;
+  }
+}
+
+void SpriteStore::sortOrder() {
+  m_order.resize(count());
+  for (u32 i = 0; i < count(); ++i)
+    m_order[i] = m_slotOf[i];
+  std::sort(m_order.begin(), m_order.end(), [this](u32 a, u32 b) {
+    u32 ia = m_denseOf[a], ib = m_denseOf[b];
+    if (m_layer[ia] != m_layer[ib])
+      return m_layer[ia] < m_layer[ib];
+    u32 imageA = getSheet(m_sheet[ia])->image;
+    u32 imageB = getSheet(m_sheet[ib])->image;
+    if (imageA != imageB)
+      return imageA < imageB;
+    return a < b;
+  });
+  m_orderDirty = false;
+}
+
+u32 SpriteStore::writeDrawList(Canvas2D::ImageRect *out) {
+  if (m_orderDirty)
+    sortOrder();
+
+  u32 written = 0;
+  for (u32 slot : m_order) {
+    const u32 i = m_denseOf[slot];
+    if (!m_visible[i] || m_alpha[i] <= 0.0f)
+      continue;
+    const SpriteSheet &sheet = *getSheet(m_sheet[i]);
+    const u32 col = m_frame[i] % sheet.columns;
+    const u32 row = m_frame[i] / sheet.columns;
+    Canvas2D::ImageRect &r = out[written++];
+    r.image = sheet.image;
+    r.sx = static_cast<i32>(col * sheet.frameW);
+    r.sy = static_cast<i32>(row * sheet.frameH);
+    r.sw = static_cast<i32>(sheet.frameW);
+    r.sh = static_cast<i32>(sheet.frameH);
+    const f32 scale = m_scale[i];
+    r.dx = m_x[i] - sheet.originX * scale;
+    r.dy = m_y[i] - sheet.originY * scale;
+    r.dw = static_cast<f32>(sheet.frameW) * scale;
+    r.dh = static_cast<f32>(sheet.frameH) * scale;
+    r.alpha = std::min(m_alpha[i], 1.0f);
+  }
+  return written;
+}
+
+} // namespace arcanee::render
@@ -0,0 +1,151 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file SpriteStore.h
+ * @brief Native sprites with kinematics and sheet animation on the fixed tick.
+ */
+
+#include "Canvas2D.h"
+#include "common/Types.h"
+#include <deque>
+#include <vector>
+
+namespace arcanee::render {
+
+/**
+ * @brief Frames of an image: a grid of frameW x frameH cells, numbered
+ * row-major from the top left. The origin is the point of a frame placed at
+ * the sprite's position.
+ */
+struct SpriteSheet {
+  u32 image = 0;
+  u32 frameW = 0;
+  u32 frameH = 0;
+  u32 columns = 1;
+  f32 originX = 0.0f;
+  f32 originY = 0.0f;
+};
+
+/**
+ * @brief Per-sprite settings, as read and written by script.
+ */
+struct SpriteState {
+  u32 sheet = 0;
+  f32 x = 0.0f;
+  f32 y = 0.0f;
+  f32 vx = 0.0f; ///< Units per second
+  f32 vy = 0.0f;
+  f32 ax = 0.0f; ///< Units per second squared
+  f32 ay = 0.0f;
+  i32 layer = 0; ///< Lower layers draw first
+  u32 frame = 0;
+  f32 scale = 1.0f; ///< Of the frame, about the origin
+  f32 alpha = 1.0f; ///< Opacity, 0 to 1
+  bool visible = true;
+};
+
+/**
+ * @brief A single float property, for writers that only know a handle (e.g.
+ * tweens).
+ */
+enum class SpriteProperty : u8 { X, Y, Scale, Alpha };
+
+/**
+ * @brief Owns every sprite of a cartridge.
+ *
+ * Live sprites are packed into dense structure-of-arrays storage (a removal
+ * moves the last sprite into the hole), so step() runs straight loops over
+ * them. Handles carry a slot and a generation, so a handle to a freed sprite
+ * stays invalid after its slot is reused. Freed slots are reused oldest
+ * first, and a slot is retired once its generations run out. The draw order (layer, then image,
+ * then slot) is re-sorted only when a sprite is created, freed or changes
+ * layer or sheet.
+ */
+class SpriteStore {
+public:
+  static constexpr u32 kSlotBits = 20;
+  static constexpr u32 kMaxSprites = (1u << kSlotBits) - 1;
+
+  /// @return Sheet id (never 0), or 0 if the sheet has no frame size.
+  u32 defineSheet(const SpriteSheet &sheet);
+  const SpriteSheet *getSheet(u32 id) const;
+
+  /// @return Handle (never 0), or 0 if the sheet is unknown or the store is
+  /// full.
+  u32 create(const SpriteState &state);
+  bool destroy(u32 handle);
+  bool alive(u32 handle) const;
+  /// Free every sprite and sheet. Handles and sheet ids are never reissued.
+  void clear();
+
+  bool getState(u32 handle, SpriteState &out) const;
+  /// Replace the settings. Setting a frame stops the animation.
+  bool setState(u32 handle, const SpriteState &state);
+  bool setPosition(u32 handle, f32 x, f32 y);
+  bool setVelocity(u32 handle, f32 vx, f32 vy);
+  bool getProperty(u32 handle, SpriteProperty property, f32 &out) const;
+  bool setProperty(u32 handle, SpriteProperty property, f32 value);
+
+  /**
+   * @brief Step through frames [first, first + count) at @p fps from now.
+   * A one-shot animation stops on its last frame.
+   */
+  bool play(u32 handle, u32 first, u32 count, f32 fps, bool loop);
+  bool playing(u32 handle) const;
+
+  /// Advance every sprite by @p dt seconds: accelerate, move, animate.
+  void step(f32 dt);
+
+  u32 count() const { return static_cast<u32>(m_slotOf.size()); }
+  u32 sheetCount() const { return static_cast<u32>(m_sheets.size()); }
+
+  /**
+   * @brief Fill draw data for visible sprites in draw order.
+   * @param out Room for count() entries.
+   * @return Entries written.
+   */
+  u32 writeDrawList(Canvas2D::ImageRect *out);
+
+private:
+  static constexpr u32 kNone = 0xFFFFFFFFu;
+
+  u32 denseIndex(u32 handle) const;
+  void releaseSlot(u32 slot);
+  void sortOrder();
+
+  std::vector<SpriteSheet> m_sheets; // Id - m_sheetBase - 1
+  u32 m_sheetBase = 0;               // Sheets dropped by clear()
+
+  // Slots: stable per sprite, reused through the free list
+  std::vector<u32> m_denseOf;
+  std::vector<u16> m_generation;
+  std::deque<u32> m_freeSlots;
+
+  // Dense storage, [0, count())
+  std::vector<u32> m_slotOf;
+  std::vector<f32> m_x, m_y, m_vx, m_vy, m_ax, m_ay;
+  std::vector<i32> m_layer;
+  std::vector<u32> m_sheet;
+  std::vector<u32> m_frame;
+  std::vector<f32> m_scale;
+  std::vector<f32> m_alpha;
+  std::vector<u8> m_visible;
+  std::vector<u32> m_animFirst;
+  std::vector<u32> m_animCount; // 0 when not playing
+  std::vector<f32> m_animFps;
+  std::vector<f32> m_animTime;
+  std::vector<u8> m_animLoop;
+
+  std::vector<u32> m_order; // Slots in draw order
+  bool m_orderDirty = false;
+};
+
+} // namespace arcanee::render
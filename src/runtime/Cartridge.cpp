@@ -11,12 +11,23 @@
  */
 
 #include "Cartridge.h"
+#include "Manifest.h"
 #include "common/Assert.h"
 #include "common/Log.h"
 #include "platform/Time.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <xxhash.h>
 
 namespace arcanee::runtime {
 
+namespace {
+// Time task.spawn() work may use after each update()
+constexpr double kTaskBudgetSec = 0.004;
+} // namespace
+
 const char *cartridgeStateToString(CartridgeState state) {
   switch (state) {
   case CartridgeState::Unloaded:
@@ -89,6 +100,74 @@ void getCbufDimensions(CartridgeConfig::Display::Aspect aspect,
 // Cartridge Implementation
 // ============================================================================
 
+namespace {
+
+// Per-user cache root. Never the shared temp dir: cache entries are loaded
+// with sq_readclosure, so a directory other users can write to would let
+// them run code in this process.
+std::filesystem::path userCacheDir() {
+#if defined(_WIN32)
+  const char *base = std::getenv("LOCALAPPDATA");
+  if (base && *base)
+    return std::filesystem::path(base) / "arcanee";
+#elif defined(__APPLE__)
+  const char *home = std::getenv("HOME");
+  if (home && *home)
+    return std::filesystem::path(home) / "Library" / "Caches" / "arcanee";
+#else
+  // XDG: a relative XDG_CACHE_HOME is invalid and must be ignored
+  const char *xdg = std::getenv("XDG_CACHE_HOME");
+  if (xdg && xdg[0] == '/')
+    return std::filesystem::path(xdg) / "arcanee";
+  const char *home = std::getenv("HOME");
+  if (home && *home)
+    return std::filesystem::path(home) / ".cache" / "arcanee";
+#endif
+  return {};
+}
+
+// Per-cartridge directory for compiled bytecode; empty disables the cache
+std::string bytecodeCacheDirFor(const std::string &fsPath) {
+  std::filesystem::path base = userCacheDir();
+  if (base.empty())
+    return {};
+
+  char name[20];
+  std::snprintf(name, sizeof(name), "%016llx",
+                (unsigned long long)XXH64(fsPath.data(), fsPath.size(), 0));
+  return (base / "bytecode" / name).string();
+}
+
+// The manifest's enums list the same values in the same order
+void applyManifest(const Manifest &manifest, CartridgeConfig &config) {
+  using Display = CartridgeConfig::Display;
+  config.id = manifest.id;
+  config.title = manifest.title;
+  config.version = manifest.version;
+  config.apiVersion = manifest.apiVersion;
+  config.entry = manifest.entry;
+
+  config.display.aspect = static_cast<Display::Aspect>(manifest.display.aspect);
+  config.display.preset = static_cast<Display::Preset>(manifest.display.preset);
+  config.display.scaling =
+      static_cast<Display::Scaling>(manifest.display.scaling);
+  config.display.allowUserOverride = manifest.display.allowUserOverride;
+
+  config.permissions.saveStorage = manifest.permissions.saveStorage;
+  config.permissions.audio = manifest.permissions.audio;
+  config.permissions.net = manifest.permissions.net;
+  config.permissions.native = manifest.permissions.native;
+
+  config.caps.cpuMsPerUpdate = manifest.caps.cpuMsPerUpdate;
+  config.caps.vmMemoryMb = manifest.caps.vmMemoryMb;
+  config.caps.maxDrawCalls = manifest.caps.maxDrawCalls;
+  config.caps.maxCanvasPixels = manifest.caps.maxCanvasPixels;
+  config.caps.audioChannels = manifest.caps.audioChannels;
+  config.caps.jobWorkers = manifest.caps.jobWorkers;
+}
+
+} // namespace
+
 Cartridge::Cartridge(vfs::IVfs *vfs, script::ScriptEngine *engine)
     : m_vfs(vfs), m_scriptEngine(engine) {
   ARCANEE_ASSERT(m_vfs != nullptr, "VFS cannot be null");
@@ -120,12 +199,37 @@ bool Cartridge::load(const std::string &fsPath) {
     return false;
   }
 
-  // TODO: Read manifest.toml here to populate m_config
-  // For now we assume defaults and entry point "main.nut"
+  // Chapter 3 §3.4: an invalid manifest refuses the cartridge. Development
+  // directories without one run with the defaults and "main.nut".
+  m_config = CartridgeConfig();
+  if (auto text = m_vfs->readText("cart:/cartridge.toml")) {
+    ManifestResult parsed = parseManifest(*text);
+    if (auto *error = std::get_if<ManifestError>(&parsed)) {
+      LOG_ERROR("cartridge.toml:%d: %s", error->line, error->message.c_str());
+      transition(CartridgeState::Faulted);
+      return false;
+    }
+    const Manifest &manifest = std::get<Manifest>(parsed);
+    if (auto invalid = validateManifest(manifest)) {
+      LOG_ERROR("cartridge.toml: %s", invalid->c_str());
+      transition(CartridgeState::Faulted);
+      return false;
+    }
+    applyManifest(manifest, m_config);
+  } else {
+    LOG_WARN("No cartridge.toml; using default settings");
+  }
 
   // 2. Initialize ScriptEngine with the VFS reference (but don't execute yet)
   script::ScriptEngine::ScriptConfig scriptConfig;
   scriptConfig.debugInfo = true; // Enable debug info by default
+  // §12.4.3: caps.vmMemoryMb is the soft cap, the hard cap is twice that
+  u64 vmMemoryBytes = static_cast<u64>(m_config.caps.vmMemoryMb) * 1024 * 1024;
+  scriptConfig.memorySoftCapBytes = vmMemoryBytes;
+  scriptConfig.memoryHardCapBytes = vmMemoryBytes * 2;
+  scriptConfig.bytecodeCacheDir = bytecodeCacheDirFor(fsPath);
+  scriptConfig.jobWorkers =
+      static_cast<u32>(std::max(m_config.caps.jobWorkers, 1));
   if (!m_scriptEngine->initialize(m_vfs, scriptConfig)) {
     LOG_ERROR("Failed to initialize ScriptEngine");
     transition(CartridgeState::Faulted);
@@ -147,6 +251,7 @@ bool Cartridge::start() {
   // 1. Compile/Execute entry script
   std::string entryPath = "cart:/" + m_config.entry;
   LOG_INFO("Executing entry script: %s", entryPath.c_str());
+  double startTime = platform::Time::now();
 
   if (!m_scriptEngine->executeScript(entryPath)) {
     LOG_ERROR("Failed to execute entry script");
@@ -156,6 +261,20 @@ bool Cartridge::start() {
 
   // 2. Call init() if exists
   m_scriptEngine->callInit();
+  if (m_scriptEngine->hasMemoryFault() || m_scriptEngine->hasHangFault()) {
+    LOG_ERROR("Cartridge faulted during init()");
+    transition(CartridgeState::Faulted);
+    return false;
+  }
+
+  // Startup cost: cold when anything had to be compiled from source
+  auto cacheStats = m_scriptEngine->getBytecodeCacheStats();
+  LOG_INFO("Scripts ready in %.2fms (%s start: %u cached in %.2fms, %u "
+           "compiled in %.2fms)",
+           (platform::Time::now() - startTime) * 1000.0,
+           cacheStats.misses > 0 ? "cold" : "warm", cacheStats.hits,
+           cacheStats.loadSec * 1000.0, cacheStats.misses,
+           cacheStats.compileSec * 1000.0);
 
   transition(CartridgeState::Running);
   LOG_INFO("Cartridge started and running");
@@ -187,6 +306,11 @@ void Cartridge::update(double dt) {
       LOG_WARN("Performance Warning: update() took %.2fms (Budget: 16.00ms)",
                elapsed * 1000.0);
     }
+    m_scriptEngine->stepServices(dt);
+    m_scriptEngine->runTasks(kTaskBudgetSec);
+    if (m_scriptEngine->hasMemoryFault() || m_scriptEngine->hasHangFault()) {
+      transition(CartridgeState::Faulted);
+    }
   }
 }
 
@@ -196,6 +320,9 @@ void Cartridge::draw(double alpha) {
        m_state == CartridgeState::Paused) &&
       !m_scriptEngine->isPaused()) {
     m_scriptEngine->callDraw(alpha);
+    if (m_scriptEngine->hasMemoryFault() || m_scriptEngine->hasHangFault()) {
+      transition(CartridgeState::Faulted);
+    }
   }
 }
 
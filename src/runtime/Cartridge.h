@@ -67,6 +67,7 @@ struct CartridgeConfig {
     int maxDrawCalls = 20000;
     int maxCanvasPixels = 16777216;
     int audioChannels = 32;
+    int jobWorkers = 2;
   } caps;
 };
 
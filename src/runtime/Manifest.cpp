@@ -499,6 +499,8 @@ ManifestResult parseManifest(const std::string &content) {
       static_cast<int>(parser.getInt("caps", "max_canvas_pixels", 16777216));
   manifest.caps.audioChannels =
       static_cast<int>(parser.getInt("caps", "audio_channels", 32));
+  manifest.caps.jobWorkers =
+      static_cast<int>(parser.getInt("caps", "job_workers", 2));
 
   return manifest;
 }
@@ -90,6 +90,7 @@ struct Caps {
   int maxDrawCalls = 20000;
   int maxCanvasPixels = 16777216;
   int audioChannels = 32;
+  int jobWorkers = 2;
 };
 
 /**
@@ -1,16 +1,57 @@
 #include "BindingHelpers.h"
 #include "common/Log.h"
+#include <cstdio>
 #include <squirrel.h>
 #include <string>
 
 namespace arcanee::script {
 
-// Thread-local storage for the last error message
+// Thread-local storage for the last error message (assigned in place, so
+// its capacity is reused)
 static thread_local std::string g_lastError;
 
-void setLastError(HSQUIRRELVM, const std::string &msg) {
-  g_lastError = msg;
-  LOG_WARN("Script Error: %s", msg.c_str());
+void setLastError(HSQUIRRELVM, std::string_view msg) {
+  g_lastError.assign(msg);
+  LOG_WARN("Script Error: %s", g_lastError.c_str());
+}
+
+FrameArena &bindingArena() {
+  static thread_local FrameArena arena;
+  return arena;
+}
+
+static const SQChar *currentFunctionName(HSQUIRRELVM vm) {
+  SQStackInfos si;
+  if (SQ_SUCCEEDED(sq_stackinfos(vm, 0, &si)) && si.funcname)
+    return si.funcname;
+  return "native";
+}
+
+SQInteger bindingArityError(HSQUIRRELVM vm, SQInteger minArgs,
+                            SQInteger maxArgs) {
+  char msg[256];
+  long long got = static_cast<long long>(sq_gettop(vm) - 1);
+  if (minArgs == maxArgs) {
+    snprintf(msg, sizeof(msg), "%s: Expected %lld arguments, got %lld",
+             currentFunctionName(vm), static_cast<long long>(minArgs), got);
+  } else {
+    snprintf(msg, sizeof(msg), "%s: Expected %lld to %lld arguments, got %lld",
+             currentFunctionName(vm), static_cast<long long>(minArgs),
+             static_cast<long long>(maxArgs), got);
+  }
+  setLastError(vm, msg);
+  sq_pushnull(vm);
+  return 1;
+}
+
+SQInteger bindingTypeError(HSQUIRRELVM vm, SQInteger arg,
+                           const char *expected) {
+  char msg[256];
+  snprintf(msg, sizeof(msg), "%s: arg %lld must be %s",
+           currentFunctionName(vm), static_cast<long long>(arg), expected);
+  setLastError(vm, msg);
+  sq_pushnull(vm);
+  return 1;
 }
 
 SQInteger sys_getLastError(HSQUIRRELVM vm) {
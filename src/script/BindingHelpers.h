@@ -1,18 +1,31 @@
 #pragma once
 
+#include "common/FrameArena.h"
 #include "common/Status.h"
 #include <squirrel.h>
 #include <string>
+#include <string_view>
 
 namespace arcanee::script {
 
 // Helper to set last error in the VM/Runtime context
-void setLastError(HSQUIRRELVM vm, const std::string &msg);
+void setLastError(HSQUIRRELVM vm, std::string_view msg);
+
+// Scratch memory for binding temporaries on this thread. Natives open a
+// FrameArena::Scope around what they allocate; ScriptEngine resets the arena
+// before each update()/draw().
+FrameArena &bindingArena();
 
 // Native bindings for sys.getLastError / sys.clearLastError
 SQInteger sys_getLastError(HSQUIRRELVM vm);
 SQInteger sys_clearLastError(HSQUIRRELVM vm);
 
+// Failure paths of generated bindings (BindingUtils.h NativeCall): set the
+// last error, prefixed with the native closure's name, and push null.
+SQInteger bindingArityError(HSQUIRRELVM vm, SQInteger minArgs,
+                            SQInteger maxArgs);
+SQInteger bindingTypeError(HSQUIRRELVM vm, SQInteger arg, const char *expected);
+
 // --- Argument Checking Helpers ---
 
 // Check argument count (exact)
@@ -1,7 +1,14 @@
 #pragma once
 
+#include "BindingHelpers.h"
+#include <array>
+#include <cstddef>
+#include <optional>
 #include <squirrel.h>
 #include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace arcanee::script {
 
@@ -99,4 +106,224 @@ inline SQRESULT GetArg<bool>(HSQUIRRELVM vm, SQInteger idx, bool &out) {
   return SQ_OK;
 }
 
+// ===== Generated bindings =====
+//
+// NativeCall<&fn> turns a plain C++ function into an SQFUNCTION. Argument
+// count, types and conversions are deduced from fn's signature:
+//
+//   integral   number (float truncates), or bool
+//   floating   number
+//   bool       bool
+//   const SQChar *  string, valid for the duration of the call
+//   std::optional<T>  trailing optional argument; absent or null -> nullopt
+//
+// A leading HSQUIRRELVM parameter receives the calling VM and does not count
+// as a script argument. Returns are pushed the same way (void pushes nothing).
+// Arity or type mismatches follow §4.7.2: the wrapper sets sys.getLastError()
+// with the qualified function name and returns null without calling fn.
+
+namespace detail {
+
+template <typename T, typename Enable = void> struct ArgTraits;
+
+template <typename T>
+struct ArgTraits<T, std::enable_if_t<std::is_integral_v<T> &&
+                                     !std::is_same_v<T, bool>>> {
+  static constexpr const char *kExpected = "a number";
+  static bool get(HSQUIRRELVM vm, SQInteger idx, T &out) {
+    SQInteger val;
+    if (SQ_FAILED(sq_getinteger(vm, idx, &val)))
+      return false;
+    out = static_cast<T>(val);
+    return true;
+  }
+  static void push(HSQUIRRELVM vm, T val) {
+    sq_pushinteger(vm, static_cast<SQInteger>(val));
+  }
+};
+
+template <typename T>
+struct ArgTraits<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+  static constexpr const char *kExpected = "a number";
+  static bool get(HSQUIRRELVM vm, SQInteger idx, T &out) {
+    SQFloat val;
+    if (SQ_FAILED(sq_getfloat(vm, idx, &val)))
+      return false;
+    out = static_cast<T>(val);
+    return true;
+  }
+  static void push(HSQUIRRELVM vm, T val) {
+    sq_pushfloat(vm, static_cast<SQFloat>(val));
+  }
+};
+
+template <> struct ArgTraits<bool> {
+  static constexpr const char *kExpected = "a boolean";
+  static bool get(HSQUIRRELVM vm, SQInteger idx, bool &out) {
+    SQBool val;
+    if (SQ_FAILED(sq_getbool(vm, idx, &val)))
+      return false;
+    out = (val != SQFalse);
+    return true;
+  }
+  static void push(HSQUIRRELVM vm, bool val) {
+    sq_pushbool(vm, val ? SQTrue : SQFalse);
+  }
+};
+
+template <> struct ArgTraits<const SQChar *> {
+  static constexpr const char *kExpected = "a string";
+  static bool get(HSQUIRRELVM vm, SQInteger idx, const SQChar *&out) {
+    return SQ_SUCCEEDED(sq_getstring(vm, idx, &out));
+  }
+  static void push(HSQUIRRELVM vm, const SQChar *val) {
+    if (val)
+      sq_pushstring(vm, val, -1);
+    else
+      sq_pushnull(vm);
+  }
+};
+
+template <typename T> struct IsOptional : std::false_type {
+  using Type = T;
+};
+template <typename T> struct IsOptional<std::optional<T>> : std::true_type {
+  using Type = T;
+};
+
+template <typename T>
+bool readArg(HSQUIRRELVM vm, SQInteger idx, SQInteger top, T &out) {
+  if constexpr (IsOptional<T>::value) {
+    if (idx > top || sq_gettype(vm, idx) == OT_NULL) {
+      out.reset();
+      return true;
+    }
+    typename IsOptional<T>::Type val{};
+    if (!ArgTraits<typename IsOptional<T>::Type>::get(vm, idx, val))
+      return false;
+    out = val;
+    return true;
+  } else {
+    return ArgTraits<T>::get(vm, idx, out);
+  }
+}
+
+template <typename F> SQInteger invokeAndPush(HSQUIRRELVM vm, F &&f) {
+  using R = decltype(f());
+  if constexpr (std::is_void_v<R>) {
+    f();
+    return 0;
+  } else {
+    ArgTraits<std::decay_t<R>>::push(vm, f());
+    return 1;
+  }
+}
+
+template <typename... Args> struct ArgList {
+  static constexpr SQInteger kMax = sizeof...(Args);
+
+  static constexpr SQInteger requiredCount() {
+    constexpr bool optional[] = {false, IsOptional<Args>::value...};
+    SQInteger n = 0;
+    while (n < kMax && !optional[n + 1])
+      ++n;
+    return n;
+  }
+  static constexpr SQInteger kMin = requiredCount();
+  static_assert(kMax - kMin == (0 + ... + SQInteger(IsOptional<Args>::value)),
+                "std::optional arguments must be trailing");
+
+  template <typename F, size_t... I>
+  static SQInteger call(HSQUIRRELVM vm, F &&f, std::index_sequence<I...>) {
+    static constexpr std::array<const char *, sizeof...(Args)> kExpected = {
+        ArgTraits<typename IsOptional<Args>::Type>::kExpected...};
+
+    SQInteger top = sq_gettop(vm);
+    SQInteger argc = top - 1; // Slot 1 is 'this'
+    if (argc < kMin || argc > kMax)
+      return bindingArityError(vm, kMin, kMax);
+
+    std::tuple<Args...> args;
+    size_t bad = 0;
+    (void)((readArg(vm, SQInteger(I) + 2, top, std::get<I>(args)) ||
+            (bad = I + 1, false)) &&
+           ...);
+    if (bad)
+      return bindingTypeError(vm, SQInteger(bad), kExpected[bad - 1]);
+
+    return f(std::get<I>(args)...);
+  }
+};
+
+template <auto Fn, typename Sig = decltype(Fn)> struct Invoker;
+
+template <auto Fn, typename R, typename... Args>
+struct Invoker<Fn, R (*)(Args...)> {
+  static SQInteger call(HSQUIRRELVM vm) {
+    return ArgList<Args...>::call(
+        vm,
+        [vm](Args... args) {
+          return invokeAndPush(vm, [&] { return Fn(args...); });
+        },
+        std::index_sequence_for<Args...>{});
+  }
+};
+
+template <auto Fn, typename R, typename... Args>
+struct Invoker<Fn, R (*)(HSQUIRRELVM, Args...)> {
+  static SQInteger call(HSQUIRRELVM vm) {
+    return ArgList<Args...>::call(
+        vm,
+        [vm](Args... args) {
+          return invokeAndPush(vm, [&] { return Fn(vm, args...); });
+        },
+        std::index_sequence_for<Args...>{});
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief SQFUNCTION generated from a C++ function signature (see above).
+ */
+template <auto Fn> SQInteger NativeCall(HSQUIRRELVM vm) {
+  return detail::Invoker<Fn>::call(vm);
+}
+
+/**
+ * @brief One entry of a binding table: either NativeCall<&fn> or a
+ * hand-written SQFUNCTION for calls that build arrays/tables.
+ */
+struct NativeFunction {
+  const SQChar *name;
+  SQFUNCTION func;
+};
+
+/**
+ * @brief Create root.<tableName> and fill it from a static function list.
+ * Closures are named "<tableName>.<name>" for error messages and stack traces.
+ */
+template <size_t N>
+void BindTable(HSQUIRRELVM vm, const SQChar *tableName,
+               const NativeFunction (&functions)[N]) {
+  sq_pushroottable(vm);
+  sq_pushstring(vm, tableName, -1);
+  sq_newtable(vm);
+
+  std::string qualified(tableName);
+  qualified += '.';
+  const size_t prefix = qualified.size();
+  for (const auto &fn : functions) {
+    qualified.resize(prefix);
+    qualified += fn.name;
+    sq_pushstring(vm, fn.name, -1);
+    sq_newclosure(vm, fn.func, 0);
+    sq_setnativeclosurename(vm, -1, qualified.c_str());
+    sq_newslot(vm, -3, SQFalse);
+  }
+
+  sq_newslot(vm, -3, SQFalse);
+  sq_pop(vm, 1); // root
+}
+
 } // namespace arcanee::script
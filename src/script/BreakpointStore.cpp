@@ -1,84 +1,109 @@
 #include "BreakpointStore.h"
 #include "common/Log.h"
 #include <algorithm>
+#include <cstring>
 
 namespace arcanee::script {
 
+namespace {
+
+std::string fileNamePart(const std::string &path) {
+  size_t sep = path.find_last_of("/\\");
+  return (sep == std::string::npos) ? path : path.substr(sep + 1);
+}
+
+} // namespace
+
 void BreakpointStore::add(const std::string &file, int line) {
-  if (hasBreakpoint(file, line))
-    return;
+  for (const auto &bp : m_linear) {
+    if (bp.file == file && bp.line == line)
+      return;
+  }
 
-  m_lookup[file].insert(line);
   m_linear.push_back({file, line, true});
+  rebuildAll();
   LOG_INFO("Breakpoint added: %s:%d [Store=%p]", file.c_str(), line, this);
 }
 
 void BreakpointStore::remove(const std::string &file, int line) {
-  if (m_lookup.find(file) != m_lookup.end()) {
-    m_lookup[file].erase(line);
-    if (m_lookup[file].empty()) {
-      m_lookup.erase(file);
-    }
-  }
-
   // Remove from linear view
   m_linear.erase(std::remove_if(m_linear.begin(), m_linear.end(),
                                 [&](const DebugBreakpoint &bp) {
                                   return bp.file == file && bp.line == line;
                                 }),
                  m_linear.end());
+  rebuildAll();
   LOG_INFO("Breakpoint removed: %s:%d", file.c_str(), line);
 }
 
 void BreakpointStore::clear() {
-  m_lookup.clear();
   m_linear.clear();
+  rebuildAll();
 }
 
-bool BreakpointStore::hasBreakpoint(const std::string &file, int line) const {
-  // 1. Exact Match (Fast)
-  auto it = m_lookup.find(file);
-  if (it != m_lookup.end()) {
-    return it->second.count(line) > 0;
+BreakpointStore::FileId BreakpointStore::intern(const char *sourceName) {
+  if (!sourceName)
+    sourceName = "";
+
+  // The VM hands out the same pointer for every event in a function; the
+  // compare guards against a freed source string's address being reused.
+  if (sourceName == m_lastSource &&
+      std::strcmp(sourceName, m_files[m_lastId].name.c_str()) == 0) {
+    return m_lastId;
+  }
+
+  std::string name(sourceName);
+  auto it = m_fileIds.find(name);
+  FileId id;
+  if (it != m_fileIds.end()) {
+    id = it->second;
+  } else {
+    id = static_cast<FileId>(m_files.size());
+    m_files.push_back({name, {}});
+    rebuildLines(m_files.back());
+    m_fileIds.emplace(std::move(name), id);
   }
 
-  // 2. Linear Scan Fallback (Robust VFS/Absolute matching)
-  // This handles cases where BP is set on "/abs/path/main.nut" but VM reports
-  // "cart:/main.nut"
+  m_lastSource = sourceName;
+  m_lastId = id;
+  return id;
+}
+
+void BreakpointStore::rebuildLines(SourceFile &file) const {
+  file.lines.clear();
+
+  // Exact path matches win. Otherwise fall back to the filename part, which
+  // handles breakpoints set on "/abs/path/main.nut" while the VM reports
+  // "cart:/main.nut". In this project structure a filename match is usually
+  // sufficient and safe enough.
+  bool exact = std::any_of(
+      m_linear.begin(), m_linear.end(),
+      [&](const DebugBreakpoint &bp) { return bp.file == file.name; });
+  std::string shortName = exact ? std::string() : fileNamePart(file.name);
+
   for (const auto &bp : m_linear) {
-    if (bp.line != line || !bp.enabled)
+    if (!bp.enabled || bp.line < 0)
+      continue;
+    bool match =
+        exact ? bp.file == file.name : fileNamePart(bp.file) == shortName;
+    if (!match)
       continue;
 
-    // Check 2a: Suffix match (e.g. "main.nut" matches "/path/to/main.nut")
-    // If one contains the other
-    bool match = false;
-
-    // Check if filename part matches
-    size_t sep1 = file.find_last_of("/\\");
-    std::string fn1 =
-        (sep1 == std::string::npos) ? file : file.substr(sep1 + 1);
-
-    size_t sep2 = bp.file.find_last_of("/\\");
-    std::string fn2 =
-        (sep2 == std::string::npos) ? bp.file : bp.file.substr(sep2 + 1);
-
-    if (fn1 == fn2) {
-      // Filenames match. Now ensure we aren't matching "a/foo.nut" with
-      // "b/foo.nut" if enough context exists. For now, in this project
-      // structure, filename match is usually sufficient and safe enough.
-      return true;
-    }
+    size_t word = static_cast<size_t>(bp.line) >> 6;
+    if (word >= file.lines.size())
+      file.lines.resize(word + 1, 0);
+    file.lines[word] |= u64(1) << (static_cast<u32>(bp.line) & 63);
   }
+}
 
-  return false;
+void BreakpointStore::rebuildAll() {
+  for (auto &file : m_files) {
+    rebuildLines(file);
+  }
 }
 
 const std::vector<DebugBreakpoint> &BreakpointStore::getAll() const {
   return m_linear;
 }
 
-void BreakpointStore::rebuildLinear() {
-  // Not used yet, we keep sync in add/remove
-}
-
 } // namespace arcanee::script
@@ -1,8 +1,8 @@
 #pragma once
 
+#include "common/Types.h"
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 namespace arcanee::script {
@@ -15,23 +15,47 @@ struct DebugBreakpoint {
 
 class BreakpointStore {
 public:
+  using FileId = int;
+
   void add(const std::string &file, int line);
   void remove(const std::string &file, int line);
   void clear();
 
-  bool hasBreakpoint(const std::string &file, int line) const;
+  bool empty() const { return m_linear.empty(); }
+
+  // Map a VM source name to a stable id. Called from the debug hook: repeated
+  // calls with the same source pointer hit a one-entry cache.
+  FileId intern(const char *sourceName);
+  const std::string &getFileName(FileId id) const { return m_files[id].name; }
+
+  // Bitmap test, O(1)
+  bool hasBreakpoint(FileId id, int line) const {
+    const auto &bits = m_files[id].lines;
+    size_t word = static_cast<size_t>(line) >> 6;
+    return line >= 0 && word < bits.size() &&
+           (bits[word] >> (static_cast<u32>(line) & 63)) & 1;
+  }
 
   // Returns all breakpoints (for UI/DAP enumeration)
   const std::vector<DebugBreakpoint> &getAll() const;
 
 private:
-  // Fast lookup: File -> Set of Lines
-  std::unordered_map<std::string, std::unordered_set<int>> m_lookup;
+  struct SourceFile {
+    std::string name;
+    std::vector<u64> lines; // Bit per line with an enabled breakpoint
+  };
+
+  // Interned VM source names, indexed by FileId
+  std::vector<SourceFile> m_files;
+  std::unordered_map<std::string, FileId> m_fileIds;
+  const char *m_lastSource = nullptr;
+  FileId m_lastId = -1;
 
   // Linear storage for API compatibility / iteration
   std::vector<DebugBreakpoint> m_linear;
 
-  void rebuildLinear();
+  void rebuildLines(SourceFile &file) const;
+  void rebuildAll();
 };
 
 } // namespace arcanee::script
@@ -0,0 +1,235 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file BytecodeCache.cpp
+ */
+
+#include "BytecodeCache.h"
+#include "common/Log.h"
+#include "platform/Time.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <xxhash.h>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace arcanee::script {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr u32 kCacheMagic = 0x42435241; // "ARCB"
+constexpr u32 kCacheFormat = 2;
+
+struct CacheHeader {
+  u32 magic;
+  u32 format;
+  u32 squirrelVersion;
+  u32 patchLevel; // SQ_ARCANEE_PATCH_LEVEL, see cmake/patch_squirrel.sh
+  u32 debugInfo;
+  u32 reserved;
+  u64 sourceHash;
+  u64 sourceSize;
+};
+
+struct ReadCursor {
+  const u8 *data;
+  size_t size;
+  size_t pos;
+};
+
+SQInteger readFromBuffer(SQUserPointer user, SQUserPointer dest,
+                         SQInteger size) {
+  auto *cursor = static_cast<ReadCursor *>(user);
+  size_t n = static_cast<size_t>(size);
+  if (cursor->pos + n > cursor->size) {
+    return -1;
+  }
+  std::memcpy(dest, cursor->data + cursor->pos, n);
+  cursor->pos += n;
+  return size;
+}
+
+SQInteger writeToBuffer(SQUserPointer user, SQUserPointer src, SQInteger size) {
+  auto *out = static_cast<std::vector<u8> *>(user);
+  const u8 *bytes = static_cast<const u8 *>(src);
+  out->insert(out->end(), bytes, bytes + size);
+  return size;
+}
+
+// Create @p dir (and missing parents) readable by this user only, or check
+// that the existing one is ours. sq_readclosure trusts its input, so a
+// directory someone else can write to must never be used.
+bool preparePrivateDir(const fs::path &dir, std::string &error) {
+#ifdef _WIN32
+  // Under %LOCALAPPDATA%, which is already private to the user
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  if (ec)
+    error = ec.message();
+  return !ec;
+#else
+  struct stat st;
+  fs::path partial;
+  for (const fs::path &part : dir) {
+    partial /= part;
+    if (::lstat(partial.c_str(), &st) != 0 &&
+        ::mkdir(partial.c_str(), 0700) != 0 && errno != EEXIST) {
+      error = std::strerror(errno);
+      return false;
+    }
+  }
+
+  if (::lstat(dir.c_str(), &st) != 0) {
+    error = std::strerror(errno);
+    return false;
+  }
+  if (!S_ISDIR(st.st_mode)) {
+    error = "not a directory";
+    return false;
+  }
+  if (st.st_uid != ::geteuid()) {
+    error = "owned by another user";
+    return false;
+  }
+  if ((st.st_mode & 077) != 0 && ::chmod(dir.c_str(), 0700) != 0) {
+    error = std::strerror(errno);
+    return false;
+  }
+  return true;
+#endif
+}
+
+} // namespace
+
+BytecodeCache::BytecodeCache(std::string cacheDir, bool debugInfo)
+    : m_dir(std::move(cacheDir)), m_debugInfo(debugInfo) {
+  if (m_dir.empty())
+    return;
+
+  std::string error;
+  if (!preparePrivateDir(m_dir, error)) {
+    LOG_WARN("Bytecode cache disabled, cannot use '%s': %s", m_dir.c_str(),
+             error.c_str());
+    m_dir.clear();
+  }
+}
+
+std::string BytecodeCache::entryPath(const std::string &sourceName) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.cnut",
+                (unsigned long long)XXH64(sourceName.data(),
+                                          sourceName.size(), 0));
+  return (fs::path(m_dir) / name).string();
+}
+
+SQRESULT BytecodeCache::compile(HSQUIRRELVM vm, const std::string &source,
+                                const std::string &sourceName) {
+  if (!isEnabled()) {
+    return sq_compilebuffer(vm, source.c_str(), source.size(),
+                            sourceName.c_str(), SQTrue);
+  }
+
+  u64 sourceHash = XXH64(source.data(), source.size(), 0);
+  std::string path = entryPath(sourceName);
+
+  f64 start = platform::Time::now();
+  if (load(vm, path, sourceHash, source.size())) {
+    m_stats.hits++;
+    m_stats.loadSec += platform::Time::now() - start;
+    return SQ_OK;
+  }
+
+  start = platform::Time::now();
+  SQRESULT res = sq_compilebuffer(vm, source.c_str(), source.size(),
+                                  sourceName.c_str(), SQTrue);
+  if (SQ_SUCCEEDED(res)) {
+    store(vm, path, sourceHash, source.size());
+  }
+  m_stats.misses++;
+  m_stats.compileSec += platform::Time::now() - start;
+  return res;
+}
+
+bool BytecodeCache::load(HSQUIRRELVM vm, const std::string &path,
+                         u64 sourceHash, u64 sourceSize) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return false;
+
+  std::vector<u8> data((std::istreambuf_iterator<char>(in)),
+                       std::istreambuf_iterator<char>());
+  if (data.size() < sizeof(CacheHeader))
+    return false;
+
+  CacheHeader header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != kCacheMagic || header.format != kCacheFormat ||
+      header.squirrelVersion != SQUIRREL_VERSION_NUMBER ||
+      header.patchLevel != SQ_ARCANEE_PATCH_LEVEL ||
+      header.debugInfo != (m_debugInfo ? 1u : 0u) ||
+      header.sourceHash != sourceHash || header.sourceSize != sourceSize) {
+    return false;
+  }
+
+  ReadCursor cursor{data.data(), data.size(), sizeof(CacheHeader)};
+  if (SQ_FAILED(sq_readclosure(vm, readFromBuffer, &cursor))) {
+    LOG_WARN("Discarding unreadable bytecode cache entry: %s", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void BytecodeCache::store(HSQUIRRELVM vm, const std::string &path,
+                          u64 sourceHash, u64 sourceSize) {
+  CacheHeader header{kCacheMagic,
+                     kCacheFormat,
+                     SQUIRREL_VERSION_NUMBER,
+                     SQ_ARCANEE_PATCH_LEVEL,
+                     m_debugInfo ? 1u : 0u,
+                     0,
+                     sourceHash,
+                     sourceSize};
+
+  std::vector<u8> data(sizeof(header));
+  std::memcpy(data.data(), &header, sizeof(header));
+  if (SQ_FAILED(sq_writeclosure(vm, writeToBuffer, &data))) {
+    return;
+  }
+
+  // Write-then-rename so a crash never leaves a truncated entry behind
+  std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+      return;
+    out.write(reinterpret_cast<const char *>(data.data()),
+              static_cast<std::streamsize>(data.size()));
+    if (!out)
+      return;
+  }
+
+  std::error_code ec;
+  fs::rename(tmpPath, path, ec);
+  if (ec) {
+    fs::remove(tmpPath, ec);
+  }
+}
+
+} // namespace arcanee::script
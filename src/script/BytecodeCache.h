@@ -0,0 +1,78 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file BytecodeCache.h
+ * @brief Host-side cache of compiled Squirrel closures.
+ */
+
+#include "common/Types.h"
+#include <squirrel.h>
+#include <string>
+
+namespace arcanee::script {
+
+/**
+ * @brief Persists compiled top-level closures with sq_writeclosure.
+ *
+ * One file per script path (<dir>/<xxh64(path)>.cnut). The header records
+ * the XXH64 of the source, the Squirrel version, the local VM patch level
+ * and the debug-info flag; any mismatch recompiles and overwrites the entry,
+ * so the cache never grows past one file per module. A cache that cannot be
+ * read or written is silently bypassed: the compiler is always the source
+ * of truth.
+ *
+ * Loaded bytecode is trusted, so the directory must be private: it is
+ * created 0700, and one owned by another user (or a symlink) disables the
+ * cache.
+ */
+class BytecodeCache {
+public:
+  struct Stats {
+    u32 hits = 0;       ///< Closures loaded from the cache
+    u32 misses = 0;     ///< Closures compiled from source
+    f64 loadSec = 0.0;  ///< Time spent in sq_readclosure (+ file read)
+    f64 compileSec = 0.0; ///< Time spent in sq_compilebuffer (+ store)
+  };
+
+  /**
+   * @param cacheDir Host directory; empty disables the cache.
+   * @param debugInfo Whether the VM compiles with debug info.
+   */
+  BytecodeCache(std::string cacheDir, bool debugInfo);
+
+  bool isEnabled() const { return !m_dir.empty(); }
+
+  /**
+   * @brief Push the compiled closure for @p source onto the VM stack.
+   *
+   * Loads from the cache when the entry matches, otherwise compiles with
+   * sq_compilebuffer (raising compiler errors as usual) and stores it.
+   * Leaves nothing on the stack on failure.
+   */
+  SQRESULT compile(HSQUIRRELVM vm, const std::string &source,
+                   const std::string &sourceName);
+
+  const Stats &getStats() const { return m_stats; }
+  void resetStats() { m_stats = Stats{}; }
+
+private:
+  std::string entryPath(const std::string &sourceName) const;
+  bool load(HSQUIRRELVM vm, const std::string &path, u64 sourceHash,
+            u64 sourceSize);
+  void store(HSQUIRRELVM vm, const std::string &path, u64 sourceHash,
+             u64 sourceSize);
+
+  std::string m_dir;
+  bool m_debugInfo;
+  Stats m_stats;
+};
+
+} // namespace arcanee::script
@@ -0,0 +1,322 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file HeapHash.cpp
+ */
+
+#include "HeapHash.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <xxhash.h>
+
+namespace arcanee::script {
+
+namespace {
+
+bool isReference(SQObjectType type) {
+  switch (type) {
+  case OT_TABLE:
+  case OT_ARRAY:
+  case OT_USERDATA:
+  case OT_CLOSURE:
+  case OT_NATIVECLOSURE:
+  case OT_CLASS:
+  case OT_INSTANCE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Orders scalars by type, then strings by content and the rest by their bits
+struct ScalarOrder {
+  SQObjectType type = OT_NULL;
+  u64 bits = 0;
+  const SQChar *str = nullptr;
+  size_t len = 0;
+
+  bool operator<(const ScalarOrder &o) const {
+    if (type != o.type)
+      return type < o.type;
+    if (type != OT_STRING)
+      return bits < o.bits;
+    int c = std::memcmp(str, o.str, std::min(len, o.len) * sizeof(SQChar));
+    return c != 0 ? c < 0 : len < o.len;
+  }
+};
+
+class HeapHasher {
+public:
+  explicit HeapHasher(HSQUIRRELVM vm) : m_vm(vm) {
+    m_state = XXH64_createState();
+    XXH64_reset(m_state, 0);
+  }
+
+  ~HeapHasher() { XXH64_freeState(m_state); }
+
+  HeapHasher(const HeapHasher &) = delete;
+  HeapHasher &operator=(const HeapHasher &) = delete;
+
+  u64 run(HeapHashStats &stats) {
+    HSQOBJECT root;
+    sq_pushroottable(m_vm);
+    sq_getstackobj(m_vm, -1, &root);
+    sq_pop(m_vm, 1);
+    idOf(root);
+
+    // The queue grows while we walk it; indices stay valid
+    for (size_t i = 0; i < m_queue.size(); ++i) {
+      hashObject(m_queue[i]);
+    }
+
+    flush();
+    stats.objects = m_queue.size();
+    stats.values = m_values;
+    return XXH64_digest(m_state);
+  }
+
+private:
+  // Small writes are batched; XXH64_update has a per-call cost
+  void word(u64 w) {
+    if (m_count == kBufferWords)
+      flush();
+    m_buffer[m_count++] = w;
+  }
+
+  void bytes(const void *data, size_t size) {
+    flush();
+    XXH64_update(m_state, data, size);
+  }
+
+  void flush() {
+    if (m_count) {
+      XXH64_update(m_state, m_buffer, m_count * sizeof(u64));
+      m_count = 0;
+    }
+  }
+
+  u64 idOf(const HSQOBJECT &obj) {
+    auto [it, inserted] = m_ids.try_emplace(obj._unVal.pRefCounted,
+                                            static_cast<u64>(m_queue.size()));
+    if (inserted)
+      m_queue.push_back(obj);
+    return it->second;
+  }
+
+  // Value at idx. References become their visit number unless the slot
+  // position is address-dependent (follow = false).
+  void hashValue(SQInteger idx, bool follow) {
+    HSQOBJECT obj;
+    sq_getstackobj(m_vm, idx, &obj);
+    SQObjectType type = sq_gettype(m_vm, idx);
+    word(static_cast<u64>(type));
+    m_values++;
+
+    switch (type) {
+    case OT_INTEGER:
+      word(static_cast<u64>(obj._unVal.nInteger));
+      break;
+    case OT_FLOAT: {
+      u64 bits = 0;
+      std::memcpy(&bits, &obj._unVal.fFloat, sizeof(obj._unVal.fFloat));
+      word(bits);
+      break;
+    }
+    case OT_BOOL: {
+      SQBool b = SQFalse;
+      sq_getbool(m_vm, idx, &b);
+      word(b);
+      break;
+    }
+    case OT_STRING: {
+      const SQChar *s = nullptr;
+      SQInteger len = 0;
+      sq_getstringandsize(m_vm, idx, &s, &len);
+      word(static_cast<u64>(len));
+      bytes(s, static_cast<size_t>(len) * sizeof(SQChar));
+      break;
+    }
+    default:
+      if (follow && isReference(type))
+        word(idOf(obj));
+      break;
+    }
+  }
+
+  void hashObject(const HSQOBJECT &obj) {
+    sq_pushobject(m_vm, obj);
+    word(static_cast<u64>(obj._type));
+
+    switch (obj._type) {
+    case OT_ARRAY:
+      hashElements();
+      break;
+    case OT_TABLE:
+    case OT_CLASS:
+    case OT_INSTANCE:
+      hashEntries();
+      break;
+    case OT_CLOSURE:
+    case OT_NATIVECLOSURE:
+      hashClosure();
+      break;
+    case OT_USERDATA: {
+      SQUserPointer p = nullptr;
+      sq_getuserdata(m_vm, -1, &p, nullptr);
+      SQInteger size = sq_getsize(m_vm, -1);
+      word(static_cast<u64>(size));
+      if (p && size > 0)
+        bytes(p, static_cast<size_t>(size));
+      break;
+    }
+    default:
+      break;
+    }
+    sq_pop(m_vm, 1);
+  }
+
+  // Scalar at idx; references only order by type
+  ScalarOrder orderOf(SQInteger idx) {
+    ScalarOrder order;
+    order.type = sq_gettype(m_vm, idx);
+    HSQOBJECT obj;
+    sq_getstackobj(m_vm, idx, &obj);
+    switch (order.type) {
+    case OT_INTEGER:
+      order.bits = static_cast<u64>(obj._unVal.nInteger);
+      break;
+    case OT_FLOAT:
+      std::memcpy(&order.bits, &obj._unVal.fFloat,
+                  sizeof(obj._unVal.fFloat));
+      break;
+    case OT_BOOL:
+      order.bits = sq_objtobool(&obj);
+      break;
+    case OT_STRING: {
+      SQInteger len = 0;
+      sq_getstringandsize(m_vm, idx, &order.str, &len);
+      order.len = static_cast<size_t>(len);
+      break;
+    }
+    default:
+      break;
+    }
+    return order;
+  }
+
+  // Array on top of the stack; keys are implied by the order
+  void hashElements() {
+    word(static_cast<u64>(sq_getsize(m_vm, -1)));
+    sq_pushnull(m_vm); // iterator
+    while (SQ_SUCCEEDED(sq_next(m_vm, -2))) {
+      hashValue(-1, true);
+      sq_pop(m_vm, 2);
+    }
+    sq_pop(m_vm, 1); // iterator
+  }
+
+  // Table, class or instance on top of the stack. Slot order follows the
+  // insertion and deletion history, so entries are hashed (and the objects
+  // they reach numbered) in key order instead. Entries keyed by a reference
+  // have no stable key and hash key and value by type, after the rest.
+  void hashEntries() {
+    m_entries.clear();
+    sq_pushnull(m_vm); // iterator
+    while (SQ_SUCCEEDED(sq_next(m_vm, -2))) {
+      Entry e;
+      sq_getstackobj(m_vm, -2, &e.key);
+      sq_getstackobj(m_vm, -1, &e.value);
+      e.keyOrder = orderOf(-2);
+      e.valueOrder = orderOf(-1);
+      e.stableKey = !isReference(e.keyOrder.type);
+      m_entries.push_back(e);
+      sq_pop(m_vm, 2);
+    }
+    sq_pop(m_vm, 1); // iterator
+
+    std::sort(m_entries.begin(), m_entries.end(),
+              [](const Entry &a, const Entry &b) {
+                if (a.stableKey != b.stableKey)
+                  return a.stableKey;
+                if (a.stableKey)
+                  return a.keyOrder < b.keyOrder;
+                if (a.keyOrder.type != b.keyOrder.type)
+                  return a.keyOrder.type < b.keyOrder.type;
+                return a.valueOrder < b.valueOrder;
+              });
+
+    word(static_cast<u64>(m_entries.size()));
+    for (const Entry &e : m_entries) {
+      sq_pushobject(m_vm, e.key);
+      sq_pushobject(m_vm, e.value);
+      hashValue(-2, false);
+      hashValue(-1, e.stableKey);
+      sq_pop(m_vm, 2);
+    }
+  }
+
+  // Closure on top of the stack: name, arity and captured values. The code
+  // itself is fixed by the script source.
+  void hashClosure() {
+    SQInteger nparams = 0, nfreevars = 0;
+    sq_getclosureinfo(m_vm, -1, &nparams, &nfreevars);
+    word(static_cast<u64>(nparams));
+    word(static_cast<u64>(nfreevars));
+
+    if (SQ_SUCCEEDED(sq_getclosurename(m_vm, -1))) {
+      hashValue(-1, false);
+      sq_pop(m_vm, 1);
+    }
+    for (SQInteger i = 0; i < nfreevars; ++i) {
+      if (sq_getfreevariable(m_vm, -1, static_cast<SQUnsignedInteger>(i))) {
+        hashValue(-1, true);
+        sq_pop(m_vm, 1);
+      }
+    }
+  }
+
+  struct Entry {
+    HSQOBJECT key;
+    HSQOBJECT value;
+    ScalarOrder keyOrder;
+    ScalarOrder valueOrder;
+    bool stableKey;
+  };
+
+  static constexpr size_t kBufferWords = 512;
+
+  HSQUIRRELVM m_vm;
+  XXH64_state_t *m_state;
+  u64 m_buffer[kBufferWords];
+  size_t m_count = 0;
+  u64 m_values = 0;
+  std::unordered_map<const void *, u64> m_ids;
+  std::vector<HSQOBJECT> m_queue;
+  std::vector<Entry> m_entries; // hashEntries() scratch
+};
+
+} // namespace
+
+u64 hashVmHeap(HSQUIRRELVM vm, HeapHashStats *stats) {
+  auto start = std::chrono::steady_clock::now();
+  HeapHashStats local;
+  HeapHasher hasher(vm);
+  u64 hash = hasher.run(local);
+  local.seconds =
+      std::chrono::duration<f64>(std::chrono::steady_clock::now() - start)
+          .count();
+  if (stats)
+    *stats = local;
+  return hash;
+}
+
+} // namespace arcanee::script
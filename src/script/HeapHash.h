@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file HeapHash.h
+ * @brief Deterministic hash of the script heap reachable from the root table.
+ */
+
+#include "common/Types.h"
+#include <squirrel.h>
+
+namespace arcanee::script {
+
+struct HeapHashStats {
+  u64 objects = 0; ///< Containers, closures and userdata visited
+  u64 values = 0;  ///< Slots hashed (entries, elements, free variables)
+  f64 seconds = 0.0;
+};
+
+/**
+ * @brief XXH64 over every value reachable from the root table.
+ *
+ * Objects are visited breadth-first and numbered on first sight; a reference
+ * hashes as its type and number, so shared objects and cycles are hashed
+ * once. Scalars hash by value, strings and userdata by content. Tables,
+ * classes and instances are walked in key order, not slot order, so the
+ * same contents hash the same whatever their insertion and deletion
+ * history. Entries keyed by a reference (whose slot follows its address)
+ * hash key and value by type only so that two identical runs always agree.
+ *
+ * Generators, threads and weak references hash by type. The VM must be idle.
+ */
+u64 hashVmHeap(HSQUIRRELVM vm, HeapHashStats *stats = nullptr);
+
+} // namespace arcanee::script
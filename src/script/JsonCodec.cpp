@@ -0,0 +1,656 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file JsonCodec.cpp
+ *
+ * One pass in each direction, with no intermediate document: the parser
+ * pushes values onto the VM stack as it reads them, and the writer walks
+ * the VM values directly. String bodies, which are most of the bytes in
+ * level and dialog data, are scanned sixteen bytes at a time for the
+ * characters that end a plain run (quote, backslash, control characters).
+ */
+
+#include "JsonCodec.h"
+#include "api/BufferBinding.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ARCANEE_JSON_SSE2 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace arcanee::script {
+
+namespace {
+
+constexpr int kMaxDepth = 512;
+
+#if ARCANEE_JSON_SSE2
+u32 lowestBit(u32 mask) {
+#if defined(_MSC_VER)
+  unsigned long i;
+  _BitScanForward(&i, mask);
+  return static_cast<u32>(i);
+#else
+  return static_cast<u32>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+bool isPlain(char c) {
+  return c != '"' && c != '\\' && static_cast<u8>(c) >= 0x20;
+}
+
+// First byte in [p, end) that is not plain string content, or end
+const char *scanPlain(const char *p, const char *end) {
+#if ARCANEE_JSON_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1F);
+  while (end - p >= 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    // Unsigned v <= 0x1F, as min(v, 0x1F) == v
+    __m128i hit = _mm_cmpeq_epi8(_mm_min_epu8(v, control), v);
+    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, quote));
+    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, backslash));
+    u32 mask = static_cast<u32>(_mm_movemask_epi8(hit));
+    if (mask != 0)
+      return p + lowestBit(mask);
+    p += 16;
+  }
+#endif
+  while (p < end && isPlain(*p))
+    ++p;
+  return p;
+}
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+int hexValue(char c) {
+  if (isDigit(c))
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+void appendUtf8(std::string &out, u32 cp) {
+  if (cp < 0x80) {
+    out += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    out += static_cast<char>(0xC0 | (cp >> 6));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    out += static_cast<char>(0xE0 | (cp >> 12));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | (cp >> 18));
+    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+}
+
+class Parser {
+public:
+  Parser(HSQUIRRELVM vm, const char *text, size_t size)
+      : m_vm(vm), m_begin(text), m_p(text), m_end(text + size) {}
+
+  Status run() {
+    // A UTF-8 byte order mark is tolerated
+    if (m_end - m_p >= 3 && std::memcmp(m_p, "\xEF\xBB\xBF", 3) == 0)
+      m_p += 3;
+    SQInteger top = sq_gettop(m_vm);
+    skipSpace();
+    bool ok = value(0);
+    if (ok) {
+      skipSpace();
+      if (m_p != m_end)
+        ok = fail("unexpected data after the document");
+    }
+    if (ok)
+      return Status::Ok();
+    sq_settop(m_vm, top);
+    return Status::InvalidArgument(errorMessage());
+  }
+
+private:
+  bool fail(const char *what) {
+    m_error = what;
+    return false;
+  }
+
+  std::string errorMessage() const {
+    u32 line = 1, column = 1;
+    for (const char *c = m_begin; c < m_p; ++c) {
+      if (*c == '\n') {
+        ++line;
+        column = 1;
+      } else {
+        ++column;
+      }
+    }
+    return std::string("json: ") + m_error + " at line " +
+           std::to_string(line) + ", column " + std::to_string(column);
+  }
+
+  void skipSpace() {
+    while (m_p < m_end && isSpace(*m_p))
+      ++m_p;
+  }
+
+  // Pushes exactly one value on success
+  bool value(int depth) {
+    if (m_p == m_end)
+      return fail("unexpected end of input");
+    switch (*m_p) {
+    case '{':
+    case '[':
+      if (depth >= kMaxDepth)
+        return fail("nesting too deep");
+      // Natives only get a few free stack slots; each level takes two
+      if (SQ_FAILED(sq_reservestack(m_vm, 4)))
+        return fail("out of stack");
+      return *m_p == '{' ? object(depth) : array(depth);
+    case '"':
+      return string();
+    case 't':
+      if (!literal("true", 4))
+        return false;
+      sq_pushbool(m_vm, SQTrue);
+      return true;
+    case 'f':
+      if (!literal("false", 5))
+        return false;
+      sq_pushbool(m_vm, SQFalse);
+      return true;
+    case 'n':
+      if (!literal("null", 4))
+        return false;
+      sq_pushnull(m_vm);
+      return true;
+    default:
+      return number();
+    }
+  }
+
+  bool literal(const char *word, size_t length) {
+    if (static_cast<size_t>(m_end - m_p) < length ||
+        std::memcmp(m_p, word, length) != 0) {
+      return fail("unexpected character");
+    }
+    m_p += length;
+    return true;
+  }
+
+  bool object(int depth) {
+    ++m_p; // {
+    sq_newtable(m_vm);
+    skipSpace();
+    if (m_p < m_end && *m_p == '}') {
+      ++m_p;
+      return true;
+    }
+    for (;;) {
+      if (m_p == m_end || *m_p != '"')
+        return fail("expected a string key");
+      if (!string())
+        return false;
+      skipSpace();
+      if (m_p == m_end || *m_p != ':')
+        return fail("expected ':'");
+      ++m_p;
+      skipSpace();
+      if (!value(depth + 1))
+        return false;
+      sq_rawset(m_vm, -3); // Duplicate keys: the last one wins
+      skipSpace();
+      if (m_p < m_end && *m_p == ',') {
+        ++m_p;
+        skipSpace();
+      } else if (m_p < m_end && *m_p == '}') {
+        ++m_p;
+        return true;
+      } else {
+        return fail("expected ',' or '}'");
+      }
+    }
+  }
+
+  bool array(int depth) {
+    ++m_p; // [
+    sq_newarray(m_vm, 0);
+    skipSpace();
+    if (m_p < m_end && *m_p == ']') {
+      ++m_p;
+      return true;
+    }
+    for (;;) {
+      if (!value(depth + 1))
+        return false;
+      sq_arrayappend(m_vm, -2);
+      skipSpace();
+      if (m_p < m_end && *m_p == ',') {
+        ++m_p;
+        skipSpace();
+      } else if (m_p < m_end && *m_p == ']') {
+        ++m_p;
+        return true;
+      } else {
+        return fail("expected ',' or ']'");
+      }
+    }
+  }
+
+  bool string() {
+    const char *start = ++m_p; // "
+    m_p = scanPlain(m_p, m_end);
+    if (m_p < m_end && *m_p == '"') {
+      // No escapes: straight from the input
+      sq_pushstring(m_vm, start, m_p - start);
+      ++m_p;
+      return true;
+    }
+
+    m_scratch.assign(start, m_p);
+    for (;;) {
+      if (m_p == m_end)
+        return fail("unterminated string");
+      char c = *m_p;
+      if (c == '"') {
+        ++m_p;
+        break;
+      }
+      if (c != '\\')
+        return fail("control character in string");
+      if (!escape())
+        return false;
+      const char *run = m_p;
+      m_p = scanPlain(m_p, m_end);
+      m_scratch.append(run, m_p);
+    }
+    sq_pushstring(m_vm, m_scratch.data(),
+                  static_cast<SQInteger>(m_scratch.size()));
+    return true;
+  }
+
+  // Decodes the escape at m_p into m_scratch
+  bool escape() {
+    if (m_end - m_p < 2)
+      return fail("unterminated string");
+    char c = m_p[1];
+    m_p += 2;
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      m_scratch += c;
+      return true;
+    case 'b':
+      m_scratch += '\b';
+      return true;
+    case 'f':
+      m_scratch += '\f';
+      return true;
+    case 'n':
+      m_scratch += '\n';
+      return true;
+    case 'r':
+      m_scratch += '\r';
+      return true;
+    case 't':
+      m_scratch += '\t';
+      return true;
+    case 'u':
+      break;
+    default:
+      m_p -= 2;
+      return fail("invalid escape");
+    }
+
+    u32 cp;
+    if (!hex4(cp))
+      return false;
+    if (cp >= 0xD800 && cp < 0xDC00) {
+      // High surrogate: a low one must follow
+      u32 low;
+      if (m_end - m_p < 2 || m_p[0] != '\\' || m_p[1] != 'u')
+        return fail("unpaired surrogate");
+      m_p += 2;
+      if (!hex4(low))
+        return false;
+      if (low < 0xDC00 || low >= 0xE000)
+        return fail("unpaired surrogate");
+      cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+    } else if (cp >= 0xDC00 && cp < 0xE000) {
+      return fail("unpaired surrogate");
+    }
+    appendUtf8(m_scratch, cp);
+    return true;
+  }
+
+  bool hex4(u32 &out) {
+    if (m_end - m_p < 4)
+      return fail("invalid \\u escape");
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+      int h = hexValue(m_p[i]);
+      if (h < 0)
+        return fail("invalid \\u escape");
+      out = out << 4 | static_cast<u32>(h);
+    }
+    m_p += 4;
+    return true;
+  }
+
+  bool number() {
+    const char *start = m_p;
+    const char *p = m_p;
+    if (p < m_end && *p == '-')
+      ++p;
+    if (p == m_end || !isDigit(*p))
+      return fail("unexpected character");
+    if (*p == '0') {
+      ++p;
+    } else {
+      while (p < m_end && isDigit(*p))
+        ++p;
+    }
+    bool integral = true;
+    if (p < m_end && *p == '.') {
+      integral = false;
+      if (++p == m_end || !isDigit(*p))
+        return fail("invalid number");
+      while (p < m_end && isDigit(*p))
+        ++p;
+    }
+    if (p < m_end && (*p == 'e' || *p == 'E')) {
+      integral = false;
+      ++p;
+      if (p < m_end && (*p == '+' || *p == '-'))
+        ++p;
+      if (p == m_end || !isDigit(*p))
+        return fail("invalid number");
+      while (p < m_end && isDigit(*p))
+        ++p;
+    }
+    m_p = p;
+
+    if (integral) {
+      i64 i;
+      auto result = std::from_chars(start, p, i);
+      if (result.ec == std::errc() &&
+          static_cast<i64>(static_cast<SQInteger>(i)) == i) {
+        sq_pushinteger(m_vm, static_cast<SQInteger>(i));
+        return true;
+      }
+      // Too large for an integer: falls back to a float
+    }
+    f64 d;
+    if (std::from_chars(start, p, d).ec != std::errc()) {
+      m_p = start;
+      return fail("number out of range");
+    }
+    sq_pushfloat(m_vm, static_cast<SQFloat>(d));
+    return true;
+  }
+
+  HSQUIRRELVM m_vm;
+  const char *m_begin;
+  const char *m_p;
+  const char *m_end;
+  const char *m_error = "";
+  std::string m_scratch; // Strings with escapes
+};
+
+class Writer {
+public:
+  Writer(HSQUIRRELVM vm, u32 indent, std::string &out)
+      : m_vm(vm), m_indent(indent), m_out(out) {}
+
+  Status value(SQInteger idx, int depth) {
+    if (depth > kMaxDepth) {
+      return Status::InvalidArgument(
+          "json: nesting too deep (is there a cycle?)");
+    }
+
+    switch (sq_gettype(m_vm, idx)) {
+    case OT_NULL:
+      m_out += "null";
+      return Status::Ok();
+    case OT_BOOL: {
+      SQBool b = SQFalse;
+      sq_getbool(m_vm, idx, &b);
+      m_out += b ? "true" : "false";
+      return Status::Ok();
+    }
+    case OT_INTEGER: {
+      SQInteger i = 0;
+      sq_getinteger(m_vm, idx, &i);
+      integer(i);
+      return Status::Ok();
+    }
+    case OT_FLOAT: {
+      SQFloat f = 0;
+      sq_getfloat(m_vm, idx, &f);
+      return real(f);
+    }
+    case OT_STRING: {
+      const SQChar *s = nullptr;
+      SQInteger len = 0;
+      sq_getstringandsize(m_vm, idx, &s, &len);
+      string(s, static_cast<size_t>(len));
+      return Status::Ok();
+    }
+    case OT_ARRAY:
+    case OT_TABLE:
+      // Natives only get a few free stack slots; each level takes three
+      if (SQ_FAILED(sq_reservestack(m_vm, 4)))
+        return Status::InvalidArgument("json: out of stack");
+      return sq_gettype(m_vm, idx) == OT_ARRAY ? array(idx, depth)
+                                               : table(idx, depth);
+    case OT_USERDATA: {
+      BufferView buf;
+      if (getBuffer(m_vm, idx, buf))
+        return buffer(buf);
+      break;
+    }
+    default:
+      break;
+    }
+    return Status::InvalidArgument("json: cannot write a " + typeName(idx));
+  }
+
+private:
+  std::string typeName(SQInteger idx) {
+    std::string name = "value";
+    const SQChar *s = nullptr;
+    if (SQ_SUCCEEDED(sq_typeof(m_vm, idx))) {
+      if (SQ_SUCCEEDED(sq_getstring(m_vm, -1, &s)))
+        name = s;
+      sq_pop(m_vm, 1);
+    }
+    return name;
+  }
+
+  void integer(i64 i) {
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), i);
+    m_out.append(buf, result.ptr);
+  }
+
+  // Float32Buffer elements are written as f32, script floats as SQFloat
+  template <typename Float> Status real(Float f) {
+    if (!std::isfinite(f))
+      return Status::InvalidArgument("json: cannot write nan or infinity");
+    // Shortest text that reads back as the same value
+    char buf[40];
+    char *end = std::to_chars(buf, buf + sizeof(buf), f).ptr;
+    m_out.append(buf, end);
+    // Keep it a float when read back
+    if (std::memchr(buf, '.', end - buf) == nullptr &&
+        std::memchr(buf, 'e', end - buf) == nullptr) {
+      m_out += ".0";
+    }
+    return Status::Ok();
+  }
+
+  void string(const char *s, size_t size) {
+    static constexpr char kHex[] = "0123456789abcdef";
+    const char *end = s + size;
+    m_out += '"';
+    for (;;) {
+      const char *run = scanPlain(s, end);
+      m_out.append(s, run);
+      if (run == end)
+        break;
+      char c = *run;
+      switch (c) {
+      case '"':
+        m_out += "\\\"";
+        break;
+      case '\\':
+        m_out += "\\\\";
+        break;
+      case '\n':
+        m_out += "\\n";
+        break;
+      case '\r':
+        m_out += "\\r";
+        break;
+      case '\t':
+        m_out += "\\t";
+        break;
+      default: {
+        char escaped[] = {'\\', 'u', '0', '0', kHex[(c >> 4) & 0xF],
+                          kHex[c & 0xF]};
+        m_out.append(escaped, sizeof(escaped));
+      }
+      }
+      s = run + 1;
+    }
+    m_out += '"';
+  }
+
+  void newline(int depth) {
+    if (m_indent == 0)
+      return;
+    m_out += '\n';
+    m_out.append(static_cast<size_t>(depth) * m_indent, ' ');
+  }
+
+  Status array(SQInteger idx, int depth) {
+    idx = idx < 0 ? sq_gettop(m_vm) + idx + 1 : idx;
+    if (sq_getsize(m_vm, idx) == 0) {
+      m_out += "[]";
+      return Status::Ok();
+    }
+    m_out += '[';
+    Status status;
+    bool first = true;
+    sq_pushnull(m_vm);
+    while (status.ok() && SQ_SUCCEEDED(sq_next(m_vm, idx))) {
+      if (!first)
+        m_out += ',';
+      first = false;
+      newline(depth + 1);
+      status = value(-1, depth + 1);
+      sq_pop(m_vm, 2);
+    }
+    sq_pop(m_vm, 1); // iterator
+    newline(depth);
+    m_out += ']';
+    return status;
+  }
+
+  Status table(SQInteger idx, int depth) {
+    idx = idx < 0 ? sq_gettop(m_vm) + idx + 1 : idx;
+    if (sq_getsize(m_vm, idx) == 0) {
+      m_out += "{}";
+      return Status::Ok();
+    }
+    m_out += '{';
+    Status status;
+    bool first = true;
+    sq_pushnull(m_vm);
+    while (status.ok() && SQ_SUCCEEDED(sq_next(m_vm, idx))) {
+      const SQChar *key = nullptr;
+      SQInteger len = 0;
+      if (SQ_FAILED(sq_getstringandsize(m_vm, -2, &key, &len))) {
+        status = Status::InvalidArgument("json: table keys must be strings");
+      } else {
+        if (!first)
+          m_out += ',';
+        first = false;
+        newline(depth + 1);
+        string(key, static_cast<size_t>(len));
+        m_out += m_indent ? ": " : ":";
+        status = value(-1, depth + 1);
+      }
+      sq_pop(m_vm, 2);
+    }
+    sq_pop(m_vm, 1); // iterator
+    newline(depth);
+    m_out += '}';
+    return status;
+  }
+
+  Status buffer(const BufferView &buf) {
+    m_out += '[';
+    for (SQInteger i = 0; i < buf.length; ++i) {
+      if (i != 0)
+        m_out += ',';
+      if (buf.type == BufferType::Float32) {
+        Status status = real(buf.floats()[i]);
+        if (!status.ok())
+          return status;
+      } else if (buf.type == BufferType::Int32) {
+        integer(buf.ints()[i]);
+      } else {
+        integer(buf.bytes()[i]);
+      }
+    }
+    m_out += ']';
+    return Status::Ok();
+  }
+
+  HSQUIRRELVM m_vm;
+  u32 m_indent;
+  std::string &m_out;
+};
+
+} // namespace
+
+Status parseJson(HSQUIRRELVM vm, const char *text, size_t size) {
+  return Parser(vm, text, size).run();
+}
+
+Status writeJson(HSQUIRRELVM vm, SQInteger idx, const JsonWriteOptions &options,
+                 std::string &out) {
+  size_t start = out.size();
+  Status status = Writer(vm, options.indent, out).value(idx, 0);
+  if (!status.ok())
+    out.resize(start);
+  return status;
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file JsonCodec.h
+ * @brief JSON text straight to and from script values.
+ */
+
+#include "common/Status.h"
+#include "common/Types.h"
+#include <squirrel.h>
+#include <string>
+
+namespace arcanee::script {
+
+struct JsonWriteOptions {
+  /// Spaces per nesting level, or 0 for compact output on one line.
+  u32 indent = 0;
+};
+
+/**
+ * @brief Parse the JSON document in [@p text, @p text + @p size) and push
+ * it onto @p vm as tables, arrays, strings, integers, floats, bools and
+ * null.
+ *
+ * Numbers without a fraction or exponent that fit an integer become
+ * integers. The text is read in place; nothing is copied besides the
+ * strings the VM keeps. Malformed input, or nesting deeper than 512 levels,
+ * fails with InvalidArgument naming the line and column, and pushes nothing.
+ */
+Status parseJson(HSQUIRRELVM vm, const char *text, size_t size);
+
+/**
+ * @brief Append the value at @p idx to @p out as JSON.
+ *
+ * Handles null, bool, integer, float, string, arrays, tables with string
+ * keys and typed buffers (as arrays of numbers). Anything else, non-finite
+ * floats and nesting deeper than 512 levels, which is how cycles surface,
+ * fail with InvalidArgument; @p out is then left as it was.
+ */
+Status writeJson(HSQUIRRELVM vm, SQInteger idx, const JsonWriteOptions &options,
+                 std::string &out);
+
+} // namespace arcanee::script
@@ -0,0 +1,125 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file SaveData.cpp
+ *
+ * Blob layout (little-endian):
+ *   magic     u32 "ARSV"
+ *   format    u32; the ValueCodec encoding the payload was written with
+ *   flags     u8; bit 0 set when the payload is a zstd frame
+ *   size      varint, bytes of the encoded value
+ *   checksum  u64 XXH64 of the encoded value
+ *   payload   the encoded value, stored or compressed
+ */
+
+#include "SaveData.h"
+#include "ValueCodec.h"
+#include "common/ByteStream.h"
+#include <algorithm>
+#include <string>
+#include <xxhash.h>
+#include <zstd.h>
+
+namespace arcanee::script {
+
+namespace {
+
+constexpr u32 kSaveMagic = 0x56535241; // "ARSV"
+constexpr u32 kSaveFormat = 1;
+constexpr u8 kFlagZstd = 1;
+
+Status dataLoss() {
+  return Status(StatusCode::DataLoss, "save data is corrupt");
+}
+
+} // namespace
+
+Status encodeSaveData(HSQUIRRELVM vm, SQInteger idx, const SaveOptions &options,
+                      std::vector<u8> &out) {
+  std::vector<u8> value;
+  Status status = encodeValue(vm, idx, value, kMaxSaveValueBytes);
+  if (!status.ok())
+    return status;
+
+  const bool compress = options.compressionLevel > 0;
+  out.clear();
+  ByteWriter w(out);
+  w.writeU32(kSaveMagic);
+  w.writeU32(kSaveFormat);
+  w.writeU8(compress ? kFlagZstd : 0);
+  w.writeVarint(value.size());
+  w.writeU64(XXH64(value.data(), value.size(), 0));
+
+  if (!compress) {
+    w.writeBytes(value.data(), value.size());
+    return Status::Ok();
+  }
+
+  size_t header = out.size();
+  out.resize(header + ZSTD_compressBound(value.size()));
+  size_t packed =
+      ZSTD_compress(out.data() + header, out.size() - header, value.data(),
+                    value.size(), std::min(options.compressionLevel, 19));
+  if (ZSTD_isError(packed)) {
+    out.clear();
+    return Status::InternalError(std::string("zstd: ") +
+                                 ZSTD_getErrorName(packed));
+  }
+  out.resize(header + packed);
+  return Status::Ok();
+}
+
+Status decodeSaveData(HSQUIRRELVM vm, const u8 *data, size_t size) {
+  ByteReader r(data, size);
+  if (r.readU32() != kSaveMagic)
+    return dataLoss();
+  u32 format = r.readU32();
+  if (r.ok() && format > kSaveFormat) {
+    return Status(StatusCode::FailedPrecondition,
+                  "save data is from a newer version (format " +
+                      std::to_string(format) + ")");
+  }
+  u8 flags = r.readU8();
+  u64 valueSize = r.readVarint();
+  u64 checksum = r.readU64();
+  if (!r.ok() || format == 0 || (flags & ~kFlagZstd) ||
+      valueSize > kMaxSaveValueBytes) {
+    return dataLoss();
+  }
+
+  const size_t payloadSize = r.remaining();
+  const u8 *payload = r.readBytes(payloadSize);
+  std::vector<u8> unpacked;
+  if (flags & kFlagZstd) {
+    // The frame must agree before the size field is trusted with a buffer
+    if (ZSTD_getFrameContentSize(payload, payloadSize) != valueSize)
+      return dataLoss();
+    unpacked.resize(static_cast<size_t>(valueSize));
+    size_t n = ZSTD_decompress(unpacked.data(), unpacked.size(), payload,
+                               payloadSize);
+    if (ZSTD_isError(n) || n != valueSize)
+      return dataLoss();
+    payload = unpacked.data();
+  } else if (payloadSize != valueSize) {
+    return dataLoss();
+  }
+  if (XXH64(payload, static_cast<size_t>(valueSize), 0) != checksum)
+    return dataLoss();
+
+  ByteReader value(payload, static_cast<size_t>(valueSize));
+  Status status = decodeValue(vm, value);
+  if (status.ok() && value.remaining() != 0) {
+    sq_pop(vm, 1);
+    return dataLoss();
+  }
+  // Only corruption is reported as such; out of stack stays what it is
+  return status.code() == StatusCode::DataLoss ? dataLoss() : status;
+}
+
+} // namespace arcanee::script
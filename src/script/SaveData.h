@@ -0,0 +1,53 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file SaveData.h
+ * @brief Versioned, checksummed blobs of script values for save files.
+ */
+
+#include "common/Status.h"
+#include "common/Types.h"
+#include "vfs/Vfs.h"
+#include <squirrel.h>
+#include <vector>
+
+namespace arcanee::script {
+
+/// Largest encoded value a save blob may hold: no more than fits in save:/.
+constexpr u64 kMaxSaveValueBytes = vfs::kDefaultSaveQuotaBytes;
+
+struct SaveOptions {
+  /// zstd level 1-19, or 0 to store the encoded value as is.
+  int compressionLevel = 0;
+};
+
+/**
+ * @brief Replace @p out with a save blob of the value at @p idx.
+ *
+ * The value is encoded with ValueCodec, so the same types are accepted and
+ * the same errors (InvalidArgument) returned. Encoding stops with
+ * ResourceExhausted once it passes kMaxSaveValueBytes.
+ */
+Status encodeSaveData(HSQUIRRELVM vm, SQInteger idx, const SaveOptions &options,
+                      std::vector<u8> &out);
+
+/**
+ * @brief Push the value stored in a save blob onto @p vm.
+ *
+ * Blobs from a newer format fail with FailedPrecondition; anything that is
+ * not an intact blob fails with DataLoss, and a VM that cannot grow its stack
+ * with ResourceExhausted. Size fields are checked against kMaxSaveValueBytes
+ * and the zstd frame header before anything is allocated. Nothing is pushed
+ * on failure.
+ */
+Status decodeSaveData(HSQUIRRELVM vm, const u8 *data, size_t size);
+
+} // namespace arcanee::script
@@ -1,10 +1,8 @@
 #include "ScriptDebugger.h"
 #include "ScriptEngine.h"
 #include "common/Log.h"
-#include "platform/Time.h"
 #include <algorithm>
 #include <chrono>
-#include <cstdio>
 #include <sqstdaux.h>
 #include <thread>
 
@@ -16,9 +14,8 @@ ScriptDebugger::~ScriptDebugger() { detach(); }
 
 void ScriptDebugger::attach(HSQUIRRELVM vm) {
   m_vm = vm;
-  if (m_enabled) {
-    sq_setnativedebughook(m_vm, debugHook);
-  }
+  m_hookInstalled = false; // Fresh VM has no hook
+  syncHook();
 }
 
 void ScriptDebugger::detach() {
@@ -26,17 +23,49 @@ void ScriptDebugger::detach() {
     sq_setnativedebughook(m_vm, nullptr);
     m_vm = nullptr;
   }
+  m_hookInstalled = false;
 }
 
 void ScriptDebugger::setEnabled(bool enabled) {
   m_enabled = enabled;
-  if (m_vm) {
-    if (enabled) {
-      sq_setnativedebughook(m_vm, debugHook);
-    } else {
-      sq_setnativedebughook(m_vm, nullptr);
-    }
-  }
+  syncHook();
+}
+
+bool ScriptDebugger::wantsHook() const {
+  if (!m_enabled)
+    return false;
+  // Idle (no breakpoints, not stepping): run at release speed
+  return !m_breakpoints.empty() ||
+         (m_action != DebugAction::None && m_action != DebugAction::Continue);
+}
+
+void ScriptDebugger::syncHook() {
+  if (!m_vm)
+    return;
+  bool want = wantsHook();
+  if (want == m_hookInstalled)
+    return;
+  // Squirrel re-enables its hook flag when the hook returns, so removing the
+  // hook from inside it would leave the VM calling a null hook closure
+  if (!want && m_hookVm)
+    return;
+  sq_setnativedebughook(m_vm, want ? debugHook : nullptr);
+  m_hookInstalled = want;
+}
+
+void ScriptDebugger::addBreakpoint(const std::string &file, int line) {
+  m_breakpoints.add(file, line);
+  syncHook();
+}
+
+void ScriptDebugger::removeBreakpoint(const std::string &file, int line) {
+  m_breakpoints.remove(file, line);
+  syncHook();
+}
+
+void ScriptDebugger::clearBreakpoints() {
+  m_breakpoints.clear();
+  syncHook();
 }
 
 void ScriptDebugger::setPaused(bool paused) { m_paused = paused; }
@@ -46,109 +75,62 @@ void ScriptDebugger::setAction(DebugAction action) {
   if (action != DebugAction::None && action != DebugAction::Continue &&
       action != DebugAction::Pause) {
     // Record depth for stepping
-    m_stepDepth = m_currentDepth;
+    m_stepDepth = m_hookVm ? stackDepth(m_hookVm) : 0;
     // Arm step - next line event will capture start location
     m_stepArmed = true;
   } else {
     m_stepArmed = false;
   }
+  syncHook();
 }
 
-void ScriptDebugger::debugHook(HSQUIRRELVM v, SQInteger type,
-                               const SQChar *sourcename, SQInteger line,
-                               const SQChar *funcname) {
-  ScriptEngine *engine = (ScriptEngine *)sq_getforeignptr(v);
-
-  // Diagnostic log for instance identity
-  if (type == 'l') {
-    LOG_INFO("debugHook engine=%p vm=%p debugger=%p file=%s line=%d type=%c",
-             engine, v, engine ? engine->getDebugger() : nullptr,
-             sourcename ? sourcename : "", (int)line, (char)type);
-  }
-
-  if (engine && engine->getDebugger()) {
-    std::string file = sourcename ? sourcename : "";
-    std::string func = funcname ? funcname : "";
-    LOG_INFO("PRE-ONHOOK: About to call onHook for %s:%d", file.c_str(),
-             (int)line);
-    engine->getDebugger()->onHook(v, type, file, (int)line, func);
-    LOG_INFO("POST-ONHOOK: Returned from onHook for %s:%d", file.c_str(),
-             (int)line);
+int ScriptDebugger::stackDepth(HSQUIRRELVM v) {
+  SQStackInfos si;
+  int depth = 0;
+  while (SQ_SUCCEEDED(sq_stackinfos(v, depth, &si))) {
+    depth++;
   }
+  return depth;
 }
 
-void ScriptDebugger::onHook(HSQUIRRELVM v, SQInteger type,
-                            const std::string &file, int line,
-                            const std::string &func) {
-  // UNCONDITIONAL entry probe
-  LOG_INFO("ONHOOK ENTRY type=%c file=%s line=%d depth=%d", (char)type,
-           file.c_str(), line, m_currentDepth);
-
-  // Track call depth on 'c' (call) and 'r' (return) events FIRST
-  // This must happen BEFORE any early returns so we maintain accurate depth
-  if (type == 'c') {
-    m_currentDepth++;
-    return;
-  }
-  if (type == 'r') {
-    m_currentDepth =
-        std::max(0, m_currentDepth - 1); // Clamp to prevent negative
-    return;
-  }
-
-  // Only line events ('l') are relevant for line breakpoints and stepping
+void ScriptDebugger::debugHook(HSQUIRRELVM v, SQInteger type,
+                               const SQChar *sourcename, SQInteger line,
+                               const SQChar * /*funcname*/) {
+  // Only line events drive breakpoints and stepping; step depth is sampled
+  // from the VM stack, so call/return events need no work
   if (type != 'l')
     return;
 
-  // Watchdog Check - SKIP if debugging is enabled!
-  if (m_engine && m_engine->m_watchdogEnabled && !m_enabled) {
-    double elapsed = platform::Time::now() - m_engine->m_executionStartTime;
-    if (elapsed > m_engine->m_watchdogTimeout) {
-      fprintf(stderr, "WATCHDOG TIMEOUT at %s:%d\n", file.c_str(), line);
-      sq_throwerror(v, "Watchdog timeout: Execution time limit exceeded");
-      return;
-    }
+  auto *engine = static_cast<ScriptEngine *>(sq_getforeignptr(v));
+  if (engine && engine->getDebugger()) {
+    engine->getDebugger()->onHook(v, sourcename, (int)line);
   }
+}
+
+void ScriptDebugger::onHook(HSQUIRRELVM v, const SQChar *sourcename,
+                            int line) {
+  BreakpointStore::FileId file = m_breakpoints.intern(sourcename);
+  m_hookVm = v;
 
   // Pause action: stop on next line event
   if (m_action == DebugAction::Pause) {
-    m_paused = true;
-    m_action = DebugAction::None;
-    if (m_onStop)
-      m_onStop(line, file, "pause");
-    // Block here until resumed - sq_suspendvm doesn't work from debug hook
-    while (m_paused && !(m_shouldExit && m_shouldExit())) {
-      if (m_uiPump)
-        m_uiPump();
-      else
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    }
-    m_paused = false; // Ensure paused is cleared on exit
+    stopAt(file, line, "pause");
+    m_hookVm = nullptr;
     return;
   }
 
   // Breakpoints are checked EVEN WHEN action == Continue
-  // Breakpoint check
   if (m_breakpoints.hasBreakpoint(file, line)) {
-    LOG_INFO("Hit breakpoint at %s:%d", file.c_str(), line);
-    m_paused = true;
-    m_action = DebugAction::None;
-    m_stepArmed = false;
-    if (m_onStop)
-      m_onStop(line, file, "breakpoint");
-    // Block here until resumed - sq_suspendvm doesn't work from debug hook
-    while (m_paused && !(m_shouldExit && m_shouldExit())) {
-      if (m_uiPump)
-        m_uiPump();
-      else
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    }
-    m_paused = false; // Ensure paused is cleared on exit
+    LOG_INFO("Hit breakpoint at %s:%d",
+             m_breakpoints.getFileName(file).c_str(), line);
+    stopAt(file, line, "breakpoint");
+    m_hookVm = nullptr;
     return;
   }
 
   // If just running (Continue), no stepping logic needed
   if (m_action == DebugAction::Continue || m_action == DebugAction::None) {
+    m_hookVm = nullptr;
     return;
   }
 
@@ -158,6 +140,7 @@ void ScriptDebugger::onHook(HSQUIRRELVM v, SQInteger type,
     m_stepStartLine = line;
     m_stepArmed = false;
     m_stepEventCount = 0; // Reset step counter
+    m_hookVm = nullptr;
     return;               // Skip first event at start location
   }
   m_stepEventCount++; // Count line events for same-line detection
@@ -173,32 +156,40 @@ void ScriptDebugger::onHook(HSQUIRRELVM v, SQInteger type,
     break;
   case DebugAction::StepOver:
     // Stop when location changed AND we're at same or shallower depth
-    shouldStop = locationChanged && (m_currentDepth <= m_stepDepth);
+    shouldStop = locationChanged && stackDepth(v) <= m_stepDepth;
     break;
   case DebugAction::StepOut:
     // Stop when depth decreased AND location changed (avoid stopping in-place)
-    shouldStop = (m_currentDepth < m_stepDepth) && locationChanged;
+    shouldStop = locationChanged && stackDepth(v) < m_stepDepth;
     break;
   default:
     break;
   }
 
   if (shouldStop) {
-    LOG_INFO("Step stop at %s:%d (action=%d, depth=%d, startDepth=%d)",
-             file.c_str(), line, (int)m_action, m_currentDepth, m_stepDepth);
-    m_paused = true;
-    m_action = DebugAction::None;
-    if (m_onStop)
-      m_onStop(line, file, "step");
-    // Block here until resumed - sq_suspendvm doesn't work from debug hook
-    while (m_paused && !(m_shouldExit && m_shouldExit())) {
-      if (m_uiPump)
-        m_uiPump();
-      else
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    }
-    m_paused = false; // Ensure paused is cleared on exit
+    LOG_INFO("Step stop at %s:%d (action=%d, startDepth=%d)",
+             m_breakpoints.getFileName(file).c_str(), line, (int)m_action,
+             m_stepDepth);
+    stopAt(file, line, "step");
+  }
+  m_hookVm = nullptr;
+}
+
+void ScriptDebugger::stopAt(BreakpointStore::FileId file, int line,
+                            const char *reason) {
+  m_paused = true;
+  m_action = DebugAction::None;
+  m_stepArmed = false;
+  if (m_onStop)
+    m_onStop(line, m_breakpoints.getFileName(file), reason);
+  // Block here until resumed - sq_suspendvm doesn't work from debug hook
+  while (m_paused && !(m_shouldExit && m_shouldExit())) {
+    if (m_uiPump)
+      m_uiPump();
+    else
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
   }
+  m_paused = false; // Ensure paused is cleared on exit
 }
 
 } // namespace arcanee::script
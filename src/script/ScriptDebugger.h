@@ -32,7 +32,15 @@ public:
   void setAction(DebugAction action);
 
   // Breakpoints
-  BreakpointStore &getBreakpoints() { return m_breakpoints; }
+  const BreakpointStore &getBreakpoints() const { return m_breakpoints; }
+  void addBreakpoint(const std::string &file, int line);
+  void removeBreakpoint(const std::string &file, int line);
+  void clearBreakpoints();
+
+  // Install or remove the native hook to match the current state. Removal is
+  // deferred while the VM is inside the hook; ScriptEngine calls this again
+  // before each entry point.
+  void syncHook();
 
   // Hook
   static void debugHook(HSQUIRRELVM v, SQInteger type, const SQChar *sourcename,
@@ -52,8 +60,10 @@ public:
   void setShouldExitCallback(ShouldExitCallback cb) { m_shouldExit = cb; }
 
 private:
-  void onHook(HSQUIRRELVM v, SQInteger type, const std::string &file, int line,
-              const std::string &func);
+  void onHook(HSQUIRRELVM v, const SQChar *sourcename, int line);
+  void stopAt(BreakpointStore::FileId file, int line, const char *reason);
+  bool wantsHook() const;
+  static int stackDepth(HSQUIRRELVM v);
 
   ScriptEngine *m_engine;
   HSQUIRRELVM m_vm = nullptr;
@@ -61,14 +71,15 @@ private:
 
   bool m_enabled = false;
   bool m_paused = false;
+  bool m_hookInstalled = false;
+  HSQUIRRELVM m_hookVm = nullptr; // VM currently inside the hook, if any
 
   // Step State
   DebugAction m_action = DebugAction::None;
-  int m_stepDepth = 0;    // Depth when step started
-  int m_currentDepth = 0; // Current call stack depth (tracked)
+  int m_stepDepth = 0; // Stack depth when step started
 
   // Step location tracking (to ignore first same-location event)
-  std::string m_stepStartFile;
+  BreakpointStore::FileId m_stepStartFile = -1;
   int m_stepStartLine = 0;
   bool m_stepArmed = false; // True after resume, waiting for location change
   int m_stepEventCount = 0; // Counter for same-line detection
@@ -12,11 +12,24 @@
 
 #include "ScriptEngine.h"
 #include "BindingHelpers.h"
+#include "HeapHash.h"
 #include "api/AudioBinding.h"
+#include "api/BufferBinding.h"
+#include "api/CollisionBinding.h"
 #include "api/FsBinding.h"
 #include "api/GfxBinding.h"
 #include "api/InputBinding.h"
+#include "api/JobBinding.h"
+#include "api/JsonBinding.h"
+#include "api/MathBinding.h"
+#include "api/NavBinding.h"
+#include "api/NoiseBinding.h"
+#include "api/ParticleBinding.h"
+#include "api/SerialBinding.h"
+#include "api/SpriteBinding.h"
 #include "api/SysBinding.h"
+#include "api/TaskBinding.h"
+#include "api/TweenBinding.h"
 #include "common/Assert.h"
 #include "common/Log.h"
 #include "platform/Time.h"
@@ -24,10 +37,12 @@
 #include <algorithm>
 #include <cstdarg>
 #include <optional>
+#include <utility>
 #include <sqstdaux.h>
 #include <sqstdblob.h>
 #include <sqstdmath.h>
 #include <sqstdstring.h>
+#include <xxhash.h>
 
 namespace arcanee::script {
 
@@ -68,6 +83,76 @@ void compilerErrorFunc(HSQUIRRELVM /*v*/, const SQChar *desc,
                        const SQChar *source, SQInteger line, SQInteger column) {
   LOG_ERROR("Script Error: %s\n  at %s:%lld:%lld", desc, source, line, column);
 }
+
+// Idle-time GC: cost guess until the first collection is measured, the
+// allocations that make a pass worthwhile, and how long one may be put off
+constexpr f64 kGcInitialSecPerObject = 100e-9;
+constexpr u64 kGcMinAllocations = 4096;
+constexpr u32 kGcMaxDeferrals = 300; // ~5 s at 60 Hz
+
+std::string lastError(HSQUIRRELVM vm) {
+  sq_getlasterror(vm);
+  const SQChar *s = nullptr;
+  std::string msg = "unknown error";
+  if (SQ_SUCCEEDED(sq_tostring(vm, -1)) &&
+      SQ_SUCCEEDED(sq_getstring(vm, -1, &s))) {
+    msg = s;
+    sq_pop(vm, 1);
+  }
+  sq_pop(vm, 1);
+  return msg;
+}
+
+bool isFunction(SQObjectType type) {
+  return type == OT_CLOSURE || type == OT_NATIVECLOSURE;
+}
+
+// Sets the methods of the class at @p from on the class at @p into (both
+// absolute). Methods may be set even after instantiation, and instances look
+// them up through their class, so live instances run the new code.
+void patchClass(HSQUIRRELVM vm, SQInteger into, SQInteger from) {
+  sq_pushnull(vm);
+  while (SQ_SUCCEEDED(sq_next(vm, from))) {
+    if (isFunction(sq_gettype(vm, -1))) {
+      sq_push(vm, -2);
+      sq_push(vm, -2);
+      sq_newslot(vm, into, SQFalse);
+    }
+    sq_pop(vm, 2);
+  }
+  sq_pop(vm, 1);
+}
+
+// Binds the slots of the table at @p from into the table at @p into (both
+// absolute). New slots are added; classes present in both are patched;
+// other existing slots are replaced if they hold functions, or always if
+// @p replaceData.
+void mergeExports(HSQUIRRELVM vm, SQInteger into, SQInteger from,
+                  bool replaceData) {
+  sq_pushnull(vm);
+  while (SQ_SUCCEEDED(sq_next(vm, from))) {
+    const SQInteger value = sq_gettop(vm);
+    const SQObjectType type = sq_gettype(vm, value);
+    bool replace = true;
+    sq_push(vm, value - 1);
+    if (SQ_SUCCEEDED(sq_rawget(vm, into))) {
+      if (type == OT_CLASS && sq_gettype(vm, -1) == OT_CLASS) {
+        patchClass(vm, sq_gettop(vm), value);
+        replace = false;
+      } else {
+        replace = replaceData || isFunction(type);
+      }
+      sq_pop(vm, 1);
+    }
+    if (replace) {
+      sq_push(vm, value - 1);
+      sq_push(vm, value);
+      sq_newslot(vm, into, SQFalse);
+    }
+    sq_pop(vm, 2);
+  }
+  sq_pop(vm, 1);
+}
 } // namespace
 
 // Custom runtime error handler to print stack trace
@@ -95,6 +180,10 @@ SQInteger runtimeErrorHandler(HSQUIRRELVM v) {
 // Debug hook moved to ScriptDebugger
 
 ScriptEngine::ScriptEngine() {
+  sq_resetobject(&m_updateEntry.key);
+  sq_resetobject(&m_updateEntry.closure);
+  sq_resetobject(&m_drawEntry.key);
+  sq_resetobject(&m_drawEntry.closure);
   m_debugger = std::make_unique<ScriptDebugger>(this);
 }
 
@@ -107,10 +196,32 @@ bool ScriptEngine::initialize(vfs::IVfs *vfs, ScriptConfig config) {
 
   ARCANEE_ASSERT(vfs != nullptr, "VFS pointer must not be null");
   m_vfs = vfs;
+  m_config = config;
+
+  // Every allocation made by this VM lands in its own arena (§12.4.3)
+  m_allocator = std::make_unique<VmAllocator>();
+  m_allocator->setCaps(config.memorySoftCapBytes, config.memoryHardCapBytes);
+  // Past the hard cap the arena raises the interrupt word, so a runaway
+  // allocation stops at its next loop or call, not when the call returns
+  if (config.memoryHardCapBytes != 0) {
+    if (!m_watchdog)
+      m_watchdog = std::make_unique<ScriptWatchdog>();
+    m_allocator->setHardCapHandler(ScriptWatchdog::onHardCap,
+                                   m_watchdog.get());
+  }
+  m_memoryFault = false;
+  m_softCapWarned = false;
+  m_hangFault = false;
+  m_gcStats = GcStats();
+  m_gcSecPerObject = 0.0;
+  m_gcAllocMark = 0;
+  m_gcDeferrals = 0;
+  VmAllocator::Scope memScope(m_allocator.get());
 
   m_vm = sq_open(1024); // Initial stack size
   if (!m_vm) {
     LOG_FATAL("Failed to create Squirrel VM");
+    m_allocator.reset();
     return false;
   }
 
@@ -123,6 +234,8 @@ bool ScriptEngine::initialize(vfs::IVfs *vfs, ScriptConfig config) {
 
   // Enable debug info for watchdog/debugging if configured
   sq_enabledebuginfo(m_vm, config.debugInfo ? SQTrue : SQFalse);
+  m_bytecodeCache =
+      std::make_unique<BytecodeCache>(config.bytecodeCacheDir, config.debugInfo);
 
   // Set print/error callbacks
   sq_setprintfunc(m_vm, printFunc, errorFunc);
@@ -144,6 +257,9 @@ bool ScriptEngine::initialize(vfs::IVfs *vfs, ScriptConfig config) {
   sq_newslot(m_vm, -3, SQFalse);
   sq_pop(m_vm, 1); // Pop root
 
+  initEntryPoint(m_updateEntry, "update");
+  initEntryPoint(m_drawEntry, "draw");
+
   // Re-attach debug hook if debugging was enabled (persisted across reloads)
   // Attach debugger if configured
   m_debugger->attach(m_vm);
@@ -168,22 +284,173 @@ bool ScriptEngine::initialize(vfs::IVfs *vfs, ScriptConfig config) {
     // m_debugger->isEnabled().
   }
 
+  m_snapshotBaseline.capture(m_vm);
+
   LOG_INFO("Squirrel VM initialized");
   return true;
 }
 
 void ScriptEngine::shutdown() {
-  if (m_vm) {
+  if (!m_vm)
+    return;
+
+  m_collision.clear();
+  m_sprites.clear();
+  m_particles.clear();
+  m_pathfinder.clear();
+  m_tweens.clear();
+  {
+    VmAllocator::Scope memScope(m_allocator.get());
+    m_tasks.clear(m_vm);
+  }
+
+  DetachedVm vm;
+  swapVm(vm);
+  closeVm(vm);
+}
+
+void ScriptEngine::swapVm(DetachedVm &other) {
+  std::swap(m_vm, other.vm);
+  std::swap(m_allocator, other.allocator);
+  std::swap(m_bytecodeCache, other.bytecodeCache);
+  std::swap(m_workerPool, other.workerPool);
+  std::swap(m_updateEntry, other.updateEntry);
+  std::swap(m_drawEntry, other.drawEntry);
+  std::swap(m_loadedModules, other.loadedModules);
+  std::swap(m_moduleOrder, other.moduleOrder);
+  std::swap(m_snapshotBaseline, other.snapshotBaseline);
+  std::swap(m_memoryFault, other.memoryFault);
+  std::swap(m_softCapWarned, other.softCapWarned);
+  std::swap(m_hangFault, other.hangFault);
+  std::swap(m_gcStats, other.gcStats);
+  std::swap(m_gcSecPerObject, other.gcSecPerObject);
+  std::swap(m_gcAllocMark, other.gcAllocMark);
+  std::swap(m_gcDeferrals, other.gcDeferrals);
+}
+
+void ScriptEngine::closeVm(DetachedVm &vm) {
+  vm.workerPool.reset(); // Joins the workers; pending jobs are dropped
+  if (!vm.vm) {
+    vm.allocator.reset();
+    return;
+  }
+
+  {
+    VmAllocator::Scope memScope(vm.allocator.get());
+
     // Release cached module objects
-    for (auto &pair : m_loadedModules) {
-      sq_release(m_vm, &pair.second);
+    for (auto &pair : vm.loadedModules) {
+      sq_release(vm.vm, &pair.second.exports);
     }
-    m_loadedModules.clear();
+    vm.loadedModules.clear();
+    vm.moduleOrder = 0;
+
+    releaseEntryPoint(vm.vm, vm.updateEntry);
+    releaseEntryPoint(vm.vm, vm.drawEntry);
+    vm.snapshotBaseline.release(vm.vm);
 
-    sq_close(m_vm);
-    m_vm = nullptr;
-    LOG_INFO("Squirrel VM shutdown");
+    sq_close(vm.vm);
+    vm.vm = nullptr;
   }
+
+  if (vm.gcStats.collections > 0) {
+    LOG_INFO("Script GC: %llu collections (%llu forced, %llu deferred), "
+             "%llu objects freed, %.2fms max",
+             (unsigned long long)vm.gcStats.collections,
+             (unsigned long long)vm.gcStats.forced,
+             (unsigned long long)vm.gcStats.deferred,
+             (unsigned long long)vm.gcStats.freedObjects,
+             vm.gcStats.maxSec * 1000.0);
+  }
+
+  const auto &stats = vm.allocator->getStats();
+  LOG_INFO("Squirrel VM shutdown (peak %.2f MB, %llu bytes leaked)",
+           stats.peakBytes / (1024.0 * 1024.0),
+           (unsigned long long)stats.bytesInUse);
+  // Drop the whole arena at once; nothing in it is reachable anymore
+  vm.allocator.reset();
+}
+
+void ScriptEngine::initEntryPoint(EntryPoint &entry, const char *name) {
+  sq_pushstring(m_vm, name, -1);
+  sq_getstackobj(m_vm, -1, &entry.key);
+  sq_addref(m_vm, &entry.key);
+  sq_pop(m_vm, 1);
+  sq_pushroottable(m_vm);
+  sq_getstackobj(m_vm, -1, &entry.root);
+  sq_addref(m_vm, &entry.root);
+  sq_pop(m_vm, 1);
+  sq_resetobject(&entry.closure);
+  bindEntryPoint(entry);
+}
+
+void ScriptEngine::releaseEntryPoint(HSQUIRRELVM vm, EntryPoint &entry) {
+  sq_release(vm, &entry.closure);
+  sq_release(vm, &entry.root);
+  sq_release(vm, &entry.key);
+  sq_resetobject(&entry.closure);
+  sq_resetobject(&entry.root);
+  sq_resetobject(&entry.key);
+}
+
+void ScriptEngine::bindEntryPoint(EntryPoint &entry) {
+  HSQOBJECT current;
+  sq_resetobject(&current);
+  sq_pushobject(m_vm, entry.root);
+  sq_pushobject(m_vm, entry.key);
+  if (SQ_SUCCEEDED(sq_rawget(m_vm, -2))) {
+    sq_getstackobj(m_vm, -1, &current);
+    sq_pop(m_vm, 1);
+  }
+  sq_pop(m_vm, 1);
+
+  if (current._type != entry.closure._type ||
+      current._unVal.pRefCounted != entry.closure._unVal.pRefCounted) {
+    sq_release(m_vm, &entry.closure);
+    entry.closure = current;
+    sq_addref(m_vm, &entry.closure);
+  }
+  entry.rootVersion = sq_gettableversion(&entry.root);
+}
+
+bool ScriptEngine::pushEntryPoint(EntryPoint &entry) {
+  // Leaves [root, closure] on the stack on success, nothing on failure
+  if (sq_gettableversion(&entry.root) != entry.rootVersion)
+    bindEntryPoint(entry);
+  if (sq_isnull(entry.closure))
+    return false;
+  sq_pushobject(m_vm, entry.root);
+  sq_pushobject(m_vm, entry.closure);
+  return true;
+}
+
+void ScriptEngine::resolveEntryPoints() {
+  bindEntryPoint(m_updateEntry);
+  bindEntryPoint(m_drawEntry);
+}
+
+bool ScriptEngine::checkMemoryCaps() {
+  if (!m_allocator)
+    return true;
+
+  if (m_allocator->isOverHardCap()) {
+    if (!m_memoryFault) {
+      LOG_ERROR("VM memory hard cap exceeded (%.2f MB > %.2f MB)",
+                m_allocator->getStats().bytesInUse / (1024.0 * 1024.0),
+                m_allocator->getHardCap() / (1024.0 * 1024.0));
+      m_memoryFault = true;
+    }
+    return false;
+  }
+
+  bool overSoft = m_allocator->isOverSoftCap();
+  if (overSoft && !m_softCapWarned) {
+    LOG_WARN("VM memory soft cap exceeded (%.2f MB > %.2f MB)",
+             m_allocator->getStats().bytesInUse / (1024.0 * 1024.0),
+             m_allocator->getSoftCap() / (1024.0 * 1024.0));
+  }
+  m_softCapWarned = overSoft;
+  return true;
 }
 
 void ScriptEngine::registerStandardLibraries() {
@@ -200,15 +467,421 @@ void ScriptEngine::registerStandardLibraries() {
 void ScriptEngine::registerArcaneeApi() {
   api::RegisterSysBinding(m_vm);
 
+  registerBufferBinding(m_vm); // buf.* (used by fs/gfx/audio/math)
+  registerMathBinding(m_vm);   // math.* value types
   api::RegisterFsBinding(m_vm);
   registerGfxBinding(m_vm);   // gfx.* table
   registerAudioBinding(m_vm); // audio.* table
   registerInputBinding(m_vm); // inp.* table
+
+  // task.* cooperative tasks, resumed by runTasks()
+  registerTaskBinding(m_vm, &m_tasks);
+
+  // jobs.* on worker VMs; module paths resolve like require()
+  WorkerPoolConfig jobConfig;
+  jobConfig.workers = m_config.jobWorkers;
+  m_workerPool = std::make_unique<WorkerPool>(
+      [this](const std::string &module) -> StatusOr<std::string> {
+        std::string path = resolvePath(module);
+        std::optional<std::string> source = m_vfs->readText(path);
+        if (!source)
+          return Status::NotFound("module not found: " + path);
+        return *source;
+      },
+      jobConfig);
+  registerJobBinding(m_vm, m_workerPool.get());
+
+  // collide.* broadphase queries
+  registerCollisionBinding(m_vm, &m_collision);
+
+  // sprites.* native sprites, moved and animated after update()
+  registerSpriteBinding(m_vm, &m_sprites);
+
+  // particles.* native emitters, stepped after update()
+  registerParticleBinding(m_vm, &m_particles);
+
+  // nav.* grid pathfinding; requests advance after update()
+  registerNavBinding(m_vm, &m_pathfinder);
+
+  // noise.* procedural noise and bulk random fills
+  registerNoiseBinding(m_vm);
+
+  // serial.* binary save data
+  registerSerialBinding(m_vm);
+
+  // json.* native JSON documents
+  registerJsonBinding(m_vm);
+
+  // tweens.* native tweens of buffer slots and sprite properties
+  registerTweenBinding(m_vm, &m_tweens, &m_sprites);
 }
 
 void ScriptEngine::setWatchdog(bool enable, f64 timeoutSec) {
   m_watchdogEnabled = enable;
   m_watchdogTimeout = timeoutSec;
+  if (enable && !m_watchdog) {
+    m_watchdog = std::make_unique<ScriptWatchdog>();
+  }
+}
+
+f64 ScriptEngine::watchdogTimeout() const {
+  // A paused debugger blocks inside the VM; never time that out
+  if (!m_watchdogEnabled || (m_debugger && m_debugger->isEnabled()))
+    return 0.0;
+  return m_watchdogTimeout;
+}
+
+void ScriptEngine::startProfiler(f64 intervalSec) {
+  if (!m_watchdog) {
+    m_watchdog = std::make_unique<ScriptWatchdog>();
+  }
+  m_profiler.start(*m_watchdog, intervalSec);
+  LOG_INFO("Script profiler started (%.2fms interval)", intervalSec * 1000.0);
+}
+
+void ScriptEngine::stopProfiler() {
+  if (!m_profiler.isRunning())
+    return;
+  m_profiler.stop();
+  const auto &stats = m_profiler.getStats();
+  LOG_INFO("Script profiler stopped: %llu samples, %.3f%% overhead",
+           (unsigned long long)stats.samples, stats.overhead() * 100.0);
+}
+
+bool ScriptEngine::canCollect() const {
+  return m_vm && !m_memoryFault && !isPaused() &&
+         sq_getvmstate(m_vm) == SQ_VMSTATE_IDLE;
+}
+
+bool ScriptEngine::collectIdleGarbage(f64 budgetSec) {
+  if (!canCollect())
+    return false;
+
+  // Cycles only form through new allocations
+  if (m_allocator->getStats().allocCount - m_gcAllocMark < kGcMinAllocations)
+    return false;
+
+  if (m_allocator->isOverSoftCap() || m_gcDeferrals >= kGcMaxDeferrals)
+    return runCollection(-1, true);
+
+  f64 secPerObject =
+      m_gcSecPerObject > 0.0 ? m_gcSecPerObject : kGcInitialSecPerObject;
+  f64 objects = std::min(budgetSec / secPerObject, 1e9);
+  if (objects >= 1.0 &&
+      runCollection(static_cast<SQInteger>(objects), false)) {
+    return true;
+  }
+  m_gcDeferrals++;
+  m_gcStats.deferred++;
+  return false;
+}
+
+bool ScriptEngine::runTasks(f64 budgetSec) {
+  if (m_tasks.size() == 0 || m_hangFault || !canCollect())
+    return true;
+
+  VmAllocator::Scope memScope(m_allocator.get());
+  ScriptWatchdog::Scope watchdogScope(m_watchdog.get(), watchdogTimeout());
+  m_tasks.run(m_vm, budgetSec);
+  checkWatchdog("task");
+  return checkMemoryCaps();
+}
+
+void ScriptEngine::stepServices(f64 dt) {
+  if (m_memoryFault || m_hangFault || isPaused())
+    return;
+  m_sprites.step(static_cast<f32>(dt));
+  // After the sprites move, so a tweened property is what gets drawn
+  m_tweens.step(static_cast<f32>(dt), &m_sprites);
+  m_particles.step(static_cast<f32>(dt));
+  m_pathfinder.step();
+
+  // onDone callbacks of the tweens that just completed
+  if (!m_tweens.finished().empty() && canCollect()) {
+    VmAllocator::Scope memScope(m_allocator.get());
+    ScriptWatchdog::Scope watchdogScope(m_watchdog.get(), watchdogTimeout());
+    finishTweens(m_vm);
+    checkWatchdog("tween callback");
+    checkMemoryCaps();
+  }
+}
+
+bool ScriptEngine::collectGarbage() {
+  return canCollect() && runCollection(-1, false);
+}
+
+u64 ScriptEngine::hashHeap() {
+  if (!canCollect())
+    return 0;
+  VmAllocator::Scope memScope(m_allocator.get());
+  return hashVmHeap(m_vm);
+}
+
+Status ScriptEngine::saveSnapshot(std::vector<u8> &out, SnapshotStats *stats) {
+  if (!canCollect()) {
+    return Status(StatusCode::FailedPrecondition,
+                  "VM is running, paused or faulted");
+  }
+  if (m_tasks.size() > 0) {
+    return Status(StatusCode::FailedPrecondition,
+                  "tasks are still running (threads cannot be saved)");
+  }
+  if (m_workerPool && m_workerPool->pending() > 0) {
+    return Status(StatusCode::FailedPrecondition,
+                  "worker jobs are still pending");
+  }
+  // Native stores live outside the heap and restoreSnapshot() empties them
+  if (m_sprites.count() > 0 || m_sprites.sheetCount() > 0) {
+    return Status(StatusCode::FailedPrecondition,
+                  "sprites or sprite sheets are still alive");
+  }
+  if (m_particles.emitterCount() > 0) {
+    return Status(StatusCode::FailedPrecondition,
+                  "particle emitters are still alive");
+  }
+  if (m_tweens.count() > 0)
+    return Status(StatusCode::FailedPrecondition, "tweens are still running");
+  if (m_pathfinder.outstanding() > 0) {
+    return Status(StatusCode::FailedPrecondition,
+                  "path requests are still outstanding");
+  }
+  if (m_collision.size() > 0) {
+    return Status(StatusCode::FailedPrecondition,
+                  "collision bodies are still set");
+  }
+  VmAllocator::Scope memScope(m_allocator.get());
+
+  SnapshotRoots roots;
+  roots.reserve(m_loadedModules.size());
+  for (const auto &pair : m_loadedModules) {
+    roots.emplace_back(pair.first, pair.second.exports);
+  }
+  return saveVmSnapshot(m_vm, m_snapshotBaseline, roots, out, stats);
+}
+
+Status ScriptEngine::restoreSnapshot(const u8 *data, size_t size,
+                                     SnapshotStats *stats) {
+  if (!m_vfs)
+    return Status(StatusCode::FailedPrecondition, "VM is not initialized");
+  if (m_pendingCall.active) {
+    return Status(StatusCode::FailedPrecondition,
+                  "VM is paused inside a call");
+  }
+
+  // Build the new VM next to the running one; the running game is only
+  // replaced once the snapshot has loaded
+  vfs::IVfs *vfs = m_vfs;
+  ScriptConfig config = m_config;
+  DetachedVm running;
+  swapVm(running);
+
+  Status status;
+  if (!initialize(vfs, config)) {
+    status = Status::InternalError("failed to create Squirrel VM");
+  } else {
+    VmAllocator::Scope memScope(m_allocator.get());
+    SnapshotRoots roots;
+    status = loadVmSnapshot(m_vm, m_snapshotBaseline, data, size, roots,
+                            stats);
+    for (auto &[name, obj] : roots) {
+      // Hash what is on disk now, so only later edits count as changes
+      std::optional<std::string> source = m_vfs->readText(name);
+      u64 hash = source ? XXH64(source->data(), source->size(), 0) : 0;
+      m_loadedModules[name] = {obj, hash, m_moduleOrder++};
+    }
+  }
+
+  if (!status.ok()) {
+    LOG_ERROR("Snapshot restore failed: %s", status.message().c_str());
+    DetachedVm failed;
+    swapVm(failed);
+    closeVm(failed);
+    swapVm(running);
+    m_debugger->attach(m_vm);
+    return status;
+  }
+
+  // Retire the old VM and all native state its handles pointed into
+  m_collision.clear();
+  m_sprites.clear();
+  m_particles.clear();
+  m_pathfinder.clear();
+  m_tweens.clear();
+  {
+    VmAllocator::Scope memScope(running.allocator.get());
+    m_tasks.clear(running.vm);
+  }
+  closeVm(running);
+
+  resolveEntryPoints();
+  checkMemoryCaps();
+  return status;
+}
+
+Status ScriptEngine::reloadModules(ReloadStats *stats) {
+  ReloadStats local;
+  ReloadStats &st = stats ? *stats : local;
+  st = ReloadStats();
+  if (!m_vfs || !canCollect() || m_hangFault) {
+    return Status(StatusCode::FailedPrecondition,
+                  "VM is running, paused or faulted");
+  }
+  f64 start = platform::Time::now();
+
+  struct Changed {
+    u32 order;
+    std::string path;
+    std::string source;
+  };
+  std::vector<Changed> changed;
+  for (const auto &[path, module] : m_loadedModules) {
+    std::optional<std::string> source = m_vfs->readText(path);
+    if (!source)
+      continue; // Gone; keep what is loaded
+    st.checked++;
+    if (XXH64(source->data(), source->size(), 0) != module.sourceHash)
+      changed.push_back({module.order, path, std::move(*source)});
+  }
+  std::sort(changed.begin(), changed.end(),
+            [](const Changed &a, const Changed &b) {
+              return a.order < b.order;
+            });
+
+  Status first;
+  {
+    VmAllocator::Scope memScope(m_allocator.get());
+    ScriptWatchdog::Scope watchdogScope(m_watchdog.get(), watchdogTimeout());
+    for (const Changed &c : changed) {
+      Status status = reloadModule(c.path, c.source);
+      if (status.ok()) {
+        st.reloaded++;
+        LOG_INFO("ScriptEngine: reloaded %s", c.path.c_str());
+      } else {
+        st.failed++;
+        LOG_ERROR("ScriptEngine: reload failed: %s",
+                  status.message().c_str());
+        if (first.ok())
+          first = status;
+      }
+      if (!checkWatchdog("module reload") || !checkMemoryCaps())
+        break;
+    }
+    resolveEntryPoints();
+  }
+  if (m_workerPool)
+    m_workerPool->reloadSources();
+
+  st.seconds = platform::Time::now() - start;
+  return first;
+}
+
+Status ScriptEngine::reloadModule(const std::string &path,
+                                  const std::string &source) {
+  LoadedModule &module = m_loadedModules[path];
+  const SQInteger top = sq_gettop(m_vm);
+
+  if (!compileSource(m_vm, source, path))
+    return Status::InvalidArgument(path + ": compile error");
+  sq_pushroottable(m_vm);
+  m_executionStack.push_back(path);
+  SQRESULT res = sq_call(m_vm, 1, SQTrue, SQTrue);
+  m_executionStack.pop_back();
+  if (SQ_FAILED(res)) {
+    Status status = Status::InternalError(path + ": " + lastError(m_vm));
+    sq_settop(m_vm, top);
+    return status;
+  }
+
+  // [closure, exports]
+  const SQInteger fresh = sq_gettop(m_vm);
+  sq_pushobject(m_vm, module.exports);
+  const SQInteger old = sq_gettop(m_vm);
+  HSQOBJECT freshObj;
+  sq_getstackobj(m_vm, fresh, &freshObj);
+  const SQObjectType type = sq_gettype(m_vm, fresh);
+  const bool same = freshObj._type == module.exports._type &&
+                    freshObj._unVal.pRefCounted ==
+                        module.exports._unVal.pRefCounted;
+
+  if (same) {
+    // The module handed back the object it exported before
+  } else if (type == OT_TABLE && sq_gettype(m_vm, old) == OT_TABLE) {
+    // Opt-in migration: onReload(old) runs on the new table, which then
+    // replaces the old one's slots wholesale
+    bool migrate = false;
+    sq_pushstring(m_vm, "onReload", -1);
+    if (SQ_SUCCEEDED(sq_rawget(m_vm, fresh))) {
+      migrate = isFunction(sq_gettype(m_vm, -1));
+      if (migrate) {
+        sq_push(m_vm, fresh);
+        sq_push(m_vm, old);
+        if (SQ_FAILED(sq_call(m_vm, 2, SQFalse, SQTrue))) {
+          Status status = Status::InternalError(path + ": onReload: " +
+                                                lastError(m_vm));
+          sq_settop(m_vm, top);
+          return status;
+        }
+      }
+      sq_pop(m_vm, 1);
+    }
+    mergeExports(m_vm, old, fresh, migrate);
+  } else if (type == OT_CLASS && sq_gettype(m_vm, old) == OT_CLASS) {
+    patchClass(m_vm, old, fresh);
+  } else {
+    // Cannot be updated in place; only later require() calls see it
+    sq_release(m_vm, &module.exports);
+    module.exports = freshObj;
+    sq_addref(m_vm, &module.exports);
+  }
+
+  module.sourceHash = XXH64(source.data(), source.size(), 0);
+  sq_settop(m_vm, top);
+  return Status::Ok();
+}
+
+bool ScriptEngine::runCollection(SQInteger maxObjects, bool forced) {
+  VmAllocator::Scope memScope(m_allocator.get());
+
+  f64 start = platform::Time::now();
+  SQInteger freed = sq_collectgarbagebudget(m_vm, maxObjects);
+  if (freed < 0)
+    return false; // Over budget (or no collector compiled in)
+  f64 sec = platform::Time::now() - start;
+
+  // Mark and sweep both walk the tracked set; refine the per-object cost
+  SQInteger tracked = sq_gctrackedcount(m_vm, -1);
+  f64 scanned = static_cast<f64>(std::max<SQInteger>(tracked + freed, 1));
+  f64 perObject = sec / scanned;
+  m_gcSecPerObject = m_gcSecPerObject > 0.0
+                         ? 0.75 * m_gcSecPerObject + 0.25 * perObject
+                         : perObject;
+
+  m_gcStats.collections++;
+  if (forced)
+    m_gcStats.forced++;
+  m_gcStats.lastFreed = static_cast<u64>(freed);
+  m_gcStats.freedObjects += static_cast<u64>(freed);
+  m_gcStats.trackedObjects = static_cast<u64>(tracked);
+  m_gcStats.heapBytes = m_allocator->getStats().bytesInUse;
+  m_gcStats.lastSec = sec;
+  m_gcStats.maxSec = std::max(m_gcStats.maxSec, sec);
+  m_gcStats.totalSec += sec;
+
+  m_gcAllocMark = m_allocator->getStats().allocCount;
+  m_gcDeferrals = 0;
+  return true;
+}
+
+bool ScriptEngine::checkWatchdog(const char *entryPoint) {
+  if (m_watchdog && m_watchdog->hasTripped()) {
+    if (!m_hangFault) {
+      LOG_ERROR("HangDetected: %s exceeded the %.0fms watchdog", entryPoint,
+                m_watchdogTimeout * 1000.0);
+      m_hangFault = true;
+    }
+    return false;
+  }
+  return true;
 }
 
 // ========== DEBUGGER IMPLEMENTATION ==========
@@ -232,6 +905,8 @@ void ScriptEngine::resumeVM() {
   if (!m_vm)
     return;
 
+  VmAllocator::Scope memScope(m_allocator.get());
+
   // Only wake up if VM is actually suspended
   if (sq_getvmstate(m_vm) == SQ_VMSTATE_SUSPENDED) {
     m_debugger->setPaused(false);
@@ -271,19 +946,19 @@ void ScriptEngine::addBreakpoint(const std::string &file, int line) {
   LOG_INFO("addBreakpoint engine=%p vm=%p debugger=%p file=%s line=%d", this,
            m_vm, m_debugger.get(), file.c_str(), line);
   if (m_debugger) {
-    m_debugger->getBreakpoints().add(file, line);
+    m_debugger->addBreakpoint(file, line);
   }
 }
 
 void ScriptEngine::removeBreakpoint(const std::string &file, int line) {
   if (m_debugger) {
-    m_debugger->getBreakpoints().remove(file, line);
+    m_debugger->removeBreakpoint(file, line);
   }
 }
 
 void ScriptEngine::clearBreakpoints() {
   if (m_debugger) {
-    m_debugger->getBreakpoints().clear();
+    m_debugger->clearBreakpoints();
   }
 }
 
@@ -292,6 +967,8 @@ std::vector<LocalVar> ScriptEngine::getLocals(int stackLevel) {
   if (!m_vm)
     return result;
 
+  VmAllocator::Scope memScope(m_allocator.get());
+
   SQUnsignedInteger idx = 0;
   const SQChar *name;
   while ((name = sq_getlocal(m_vm, stackLevel, idx)) != nullptr) {
@@ -375,6 +1052,8 @@ std::vector<StackFrame> ScriptEngine::getCallStack() {
   if (!m_vm)
     return result;
 
+  VmAllocator::Scope memScope(m_allocator.get());
+
   SQInteger level = 0;
   SQStackInfos si;
   while (SQ_SUCCEEDED(sq_stackinfos(m_vm, level, &si))) {
@@ -444,7 +1123,7 @@ SQInteger ScriptEngine::require(HSQUIRRELVM vm) {
   // Check cache
   auto it = engine->m_loadedModules.find(resolvedPath);
   if (it != engine->m_loadedModules.end()) {
-    sq_pushobject(vm, it->second);
+    sq_pushobject(vm, it->second.exports);
     return 1;
   }
 
@@ -462,8 +1141,7 @@ SQInteger ScriptEngine::require(HSQUIRRELVM vm) {
   }
 
   // Compile
-  if (SQ_FAILED(sq_compilebuffer(vm, source->c_str(), source->size(),
-                                 resolvedPath.c_str(), SQTrue))) {
+  if (!engine->compileSource(vm, *source, resolvedPath)) {
     return sq_throwerror(vm, "Module compilation failed");
   }
 
@@ -492,11 +1170,23 @@ SQInteger ScriptEngine::require(HSQUIRRELVM vm) {
   HSQOBJECT moduleObj;
   sq_getstackobj(vm, -1, &moduleObj);
   sq_addref(vm, &moduleObj);
-  engine->m_loadedModules[resolvedPath] = moduleObj;
+  engine->m_loadedModules[resolvedPath] = {
+      moduleObj, XXH64(source->data(), source->size(), 0),
+      engine->m_moduleOrder++};
 
   return 1; // Return the module object
 }
 
+bool ScriptEngine::compileSource(HSQUIRRELVM vm, const std::string &source,
+                                 const std::string &name) {
+  if (m_bytecodeCache) {
+    return SQ_SUCCEEDED(m_bytecodeCache->compile(vm, source, name));
+  }
+  // Note: sq_compilebuffer expects length in bytes (or chars).
+  return SQ_SUCCEEDED(sq_compilebuffer(vm, source.c_str(), source.size(),
+                                       name.c_str(), SQTrue));
+}
+
 std::string ScriptEngine::resolvePath(const std::string &path) {
   // If path starts with 'cart:/' or similar, it's absolute
   // Otherwise it's relative to current file on stack
@@ -535,9 +1225,12 @@ bool ScriptEngine::executeScript(const std::string &vfsPath) {
     LOG_ERROR("ScriptEngine: VFS not initialized");
     return false;
   }
+  if (m_memoryFault || m_hangFault)
+    return false;
 
-  // Set execution start time for watchdog
-  m_executionStartTime = platform::Time::now();
+  VmAllocator::Scope memScope(m_allocator.get());
+
+  ScriptWatchdog::Scope watchdogScope(m_watchdog.get(), watchdogTimeout());
 
   // Read script file as text
   std::optional<std::string> scriptSource = m_vfs->readText(vfsPath);
@@ -547,10 +1240,7 @@ bool ScriptEngine::executeScript(const std::string &vfsPath) {
   }
 
   // Compile
-  // Note: sq_compilebuffer expects length in bytes (or chars).
-  if (SQ_FAILED(sq_compilebuffer(m_vm, scriptSource->c_str(),
-                                 scriptSource->size(), vfsPath.c_str(),
-                                 SQTrue))) {
+  if (!compileSource(m_vm, *scriptSource, vfsPath)) {
     LOG_ERROR("Compilation failed: %s", vfsPath.c_str());
     return false;
   }
@@ -562,15 +1252,18 @@ bool ScriptEngine::executeScript(const std::string &vfsPath) {
   m_executionStack.push_back(vfsPath);
   SQRESULT res = sq_call(m_vm, 1, SQFalse, SQTrue);
   m_executionStack.pop_back();
+  checkWatchdog(vfsPath.c_str());
 
   if (SQ_FAILED(res)) {
     LOG_ERROR("Execution failed: %s", vfsPath.c_str());
     sq_pop(m_vm, 1); // Pop closure
+    checkMemoryCaps();
     return false;
   }
 
   sq_pop(m_vm, 1); // Pop closure
-  return true;
+  resolveEntryPoints();
+  return checkMemoryCaps();
 }
 
 const std::vector<DebugBreakpoint> &ScriptEngine::getBreakpoints() const {
@@ -582,11 +1275,12 @@ const std::vector<DebugBreakpoint> &ScriptEngine::getBreakpoints() const {
 }
 
 void ScriptEngine::callInit() {
-  if (!m_vm)
+  if (!m_vm || m_memoryFault || m_hangFault)
     return;
 
-  // Set execution start time for watchdog
-  m_executionStartTime = platform::Time::now();
+  VmAllocator::Scope memScope(m_allocator.get());
+
+  ScriptWatchdog::Scope watchdogScope(m_watchdog.get(), watchdogTimeout());
 
   sq_pushroottable(m_vm);
   sq_pushstring(m_vm, "init", -1);
@@ -594,8 +1288,8 @@ void ScriptEngine::callInit() {
     // Push root table as 'this' for the call
     sq_pushroottable(m_vm);
 
-    // ScopedWatchdog removed, logic handled by debugger hook if active
     SQRESULT res = sq_call(m_vm, 1, SQFalse, SQTrue);
+    checkWatchdog("init()");
     if (SQ_FAILED(res)) {
       LOG_ERROR("Failed to call init()");
     }
@@ -605,9 +1299,14 @@ void ScriptEngine::callInit() {
     LOG_WARN("init() function not found in script");
   }
   sq_pop(m_vm, 1); // Pop root
+  resolveEntryPoints();
+  checkMemoryCaps();
 }
 
 bool ScriptEngine::callUpdate(f64 dt) {
+  if (m_memoryFault || m_hangFault)
+    return false;
+
   // If VM is suspended from a previous call, don't start a new one
   if (m_pendingCall.active && sq_getvmstate(m_vm) == SQ_VMSTATE_SUSPENDED) {
     return true; // Still suspended
@@ -617,13 +1316,17 @@ bool ScriptEngine::callUpdate(f64 dt) {
   if (m_debugger && m_debugger->isPaused())
     return true;
 
-  // Set execution start time for watchdog
-  m_executionStartTime = platform::Time::now();
+  // Apply any hook removal deferred while the VM was inside the hook
+  m_debugger->syncHook();
 
-  sq_pushroottable(m_vm);
-  sq_pushstring(m_vm, "update", -1);
-  if (SQ_FAILED(sq_get(m_vm, -2))) {
-    sq_pop(m_vm, 1);
+  // Binding temporaries never outlive a frame
+  bindingArena().reset();
+
+  VmAllocator::Scope memScope(m_allocator.get());
+
+  ScriptWatchdog::Scope watchdogScope(m_watchdog.get(), watchdogTimeout());
+
+  if (!pushEntryPoint(m_updateEntry)) {
     return false;
   }
 
@@ -636,6 +1339,7 @@ bool ScriptEngine::callUpdate(f64 dt) {
   m_pendingCall = {true, 2, PendingCall::Type::Update};
 
   SQRESULT res = sq_call(m_vm, 2, SQFalse, SQTrue);
+  checkWatchdog("update()");
 
   // Handle Suspension
   if (sq_getvmstate(m_vm) == SQ_VMSTATE_SUSPENDED) {
@@ -646,26 +1350,30 @@ bool ScriptEngine::callUpdate(f64 dt) {
   if (SQ_FAILED(res)) {
     LOG_ERROR("Failed to call update(dt)");
     cleanupPendingCall();
+    checkMemoryCaps();
     return false;
   }
 
   cleanupPendingCall();
-  return true;
+  return checkMemoryCaps();
 }
 
 bool ScriptEngine::callDraw(f64 alpha) {
+  if (m_memoryFault || m_hangFault)
+    return false;
+
   // If VM is suspended, don't start a new call
   if (m_pendingCall.active && sq_getvmstate(m_vm) == SQ_VMSTATE_SUSPENDED) {
     return true;
   }
 
-  // Set execution start time for watchdog
-  m_executionStartTime = platform::Time::now();
+  m_debugger->syncHook();
 
-  sq_pushroottable(m_vm);
-  sq_pushstring(m_vm, "draw", -1);
-  if (SQ_FAILED(sq_get(m_vm, -2))) {
-    sq_pop(m_vm, 1);
+  VmAllocator::Scope memScope(m_allocator.get());
+
+  ScriptWatchdog::Scope watchdogScope(m_watchdog.get(), watchdogTimeout());
+
+  if (!pushEntryPoint(m_drawEntry)) {
     return false;
   }
 
@@ -676,6 +1384,7 @@ bool ScriptEngine::callDraw(f64 alpha) {
   m_pendingCall = {true, 2, PendingCall::Type::Draw};
 
   SQRESULT res = sq_call(m_vm, 2, SQFalse, SQTrue);
+  checkWatchdog("draw()");
 
   if (sq_getvmstate(m_vm) == SQ_VMSTATE_SUSPENDED) {
     return true;
@@ -684,11 +1393,12 @@ bool ScriptEngine::callDraw(f64 alpha) {
   if (SQ_FAILED(res)) {
     LOG_ERROR("Failed to call draw(alpha)");
     cleanupPendingCall();
+    checkMemoryCaps();
     return false;
   }
 
   cleanupPendingCall();
-  return true;
+  return checkMemoryCaps();
 }
 
 void ScriptEngine::terminate() {
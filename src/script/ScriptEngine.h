@@ -12,8 +12,20 @@
  * @file ScriptEngine.h
  */
 
+#include "BytecodeCache.h"
 #include "ScriptDebugger.h" // Added
+#include "ScriptProfiler.h"
+#include "ScriptWatchdog.h"
+#include "TaskScheduler.h"
+#include "VmAllocator.h"
+#include "VmSnapshot.h"
+#include "WorkerPool.h"
+#include "anim/TweenSystem.h"
 #include "common/Types.h"
+#include "nav/Pathfinder.h"
+#include "physics/CollisionWorld.h"
+#include "render/ParticleSystem.h"
+#include "render/SpriteStore.h"
 #include "vfs/Vfs.h"
 #include <functional>
 #include <memory>
@@ -56,7 +68,17 @@ public:
 
   struct ScriptConfig {
     bool debugInfo;
-    ScriptConfig() : debugInfo(true) {}
+    // VM memory caps (Chapter 12 §12.3 defaults: 64 MB soft, 128 MB hard)
+    u64 memorySoftCapBytes;
+    u64 memoryHardCapBytes;
+    // Host directory for compiled bytecode (empty disables the cache)
+    std::string bytecodeCacheDir;
+    // jobs.* worker VMs; fixed per cartridge, see WorkerPoolConfig
+    u32 jobWorkers;
+    ScriptConfig()
+        : debugInfo(true), memorySoftCapBytes(64ull * 1024 * 1024),
+          memoryHardCapBytes(128ull * 1024 * 1024),
+          jobWorkers(WorkerPoolConfig::kDefaultWorkers) {}
   };
 
   // Prevent copying
@@ -156,13 +178,213 @@ public:
    */
   void terminate();
 
+  /**
+   * @brief VM memory arena (null when no VM exists).
+   */
+  const VmAllocator *getAllocator() const { return m_allocator.get(); }
+
+  /**
+   * @brief True once the VM exceeded its hard memory cap (§12.4.3).
+   * Every subsequent entry point fails until the VM is recreated.
+   */
+  bool hasMemoryFault() const { return m_memoryFault; }
+
+  /**
+   * @brief True once an entry point overran the hang watchdog (§12.4.2).
+   */
+  bool hasHangFault() const { return m_hangFault; }
+
+  /**
+   * @brief Bytecode cache hit/miss counters and timings since initialize().
+   */
+  BytecodeCache::Stats getBytecodeCacheStats() const {
+    return m_bytecodeCache ? m_bytecodeCache->getStats()
+                           : BytecodeCache::Stats{};
+  }
+
+  /**
+   * @brief Start the sampling profiler (see ScriptProfiler).
+   * @param intervalSec Time between samples.
+   */
+  void startProfiler(f64 intervalSec = 0.001);
+  void stopProfiler();
+  const ScriptProfiler &getProfiler() const { return m_profiler; }
+
+  /**
+   * @brief Cycle collector telemetry since initialize().
+   */
+  struct GcStats {
+    u64 collections = 0;    ///< Collections run
+    u64 forced = 0;         ///< Of which ran regardless of the budget
+    u64 deferred = 0;       ///< Frames where the heap did not fit the budget
+    u64 freedObjects = 0;   ///< Objects reclaimed, all collections
+    u64 lastFreed = 0;      ///< Objects reclaimed by the last collection
+    u64 trackedObjects = 0; ///< GC-tracked objects after the last collection
+    u64 heapBytes = 0;      ///< VM bytes in use after the last collection
+    f64 lastSec = 0.0;
+    f64 maxSec = 0.0;
+    f64 totalSec = 0.0;
+  };
+
+  /**
+   * @brief Collect reference cycles if it fits in @p budgetSec.
+   *
+   * Squirrel frees acyclic garbage by refcount as soon as it dies; cycles
+   * wait for a stop-the-world collection whose cost grows with the number of
+   * GC-tracked objects. Call this between frames with the time left before
+   * present. It does nothing unless the script allocated since the last
+   * collection, and collects only if the tracked set fits the budget at the
+   * measured cost per object; over the soft memory cap, or after being
+   * deferred for too long, it collects regardless.
+   * @return True if a collection ran.
+   */
+  bool collectIdleGarbage(f64 budgetSec);
+
+  /**
+   * @brief Collect reference cycles now, ignoring the budget.
+   */
+  bool collectGarbage();
+
+  const GcStats &getGcStats() const { return m_gcStats; }
+
+  /**
+   * @brief Resume task.spawn() tasks for up to @p budgetSec.
+   *
+   * Called after update(); does nothing while the VM is running, paused or
+   * faulted. Tasks run under the hang watchdog like update() does.
+   * @return False if a task exceeded the memory cap.
+   */
+  bool runTasks(f64 budgetSec);
+
+  const TaskScheduler::Stats &getTaskStats() const {
+    return m_tasks.getStats();
+  }
+
+  /**
+   * @brief Advance native services by one fixed tick: sprites.* motion and
+   * animation, tweens.*, particles.* emitters and queued nav.* path
+   * requests, then call onDone for the tweens that completed.
+   *
+   * Called after update(); all freeze while the debugger has the VM paused
+   * or the cartridge has faulted.
+   */
+  void stepServices(f64 dt);
+
+  /**
+   * @brief Hash of every value reachable from the root table.
+   *
+   * Cheap enough to call every tick on typical carts; see hashVmHeap.
+   * @return 0 while the VM is running, paused or faulted.
+   */
+  u64 hashHeap();
+
+  /**
+   * @brief Serialize the script heap (globals, module cache, closures,
+   * classes, instances, buffers) into @p out.
+   *
+   * Fails while the VM is running, paused or faulted, and when the heap holds
+   * something that cannot be rebuilt (generators, threads, native instances).
+   *
+   * Only the script heap is saved. Tasks, worker jobs and the native stores
+   * (sprites and sheets, emitters, tweens, path requests, collision bodies)
+   * are not, and restoreSnapshot() empties them. So a save is refused with
+   * FailedPrecondition, naming the first one found, while any of them holds
+   * state; in practice a cart can only be snapshotted at a point where it
+   * has freed them, e.g. between levels. See saveVmSnapshot for what is
+   * kept. Specified in Chapter 4 §4.11.4.
+   */
+  Status saveSnapshot(std::vector<u8> &out, SnapshotStats *stats = nullptr);
+
+  /**
+   * @brief Replace the VM with a fresh one rebuilt from a saveSnapshot blob
+   * taken earlier in this process.
+   *
+   * The blob is loaded into a new VM built next to the running one, which
+   * is only retired (with its tasks, pending jobs and native service state)
+   * once the load succeeded. On failure the running VM is left untouched.
+   */
+  Status restoreSnapshot(const u8 *data, size_t size,
+                         SnapshotStats *stats = nullptr);
+
+  struct ReloadStats {
+    u32 checked = 0;  ///< Loaded modules whose source was re-read
+    u32 reloaded = 0; ///< Changed and re-run
+    u32 failed = 0;   ///< Changed but left as they were
+    f64 seconds = 0.0;
+  };
+
+  /**
+   * @brief Re-run every require()d module whose source changed since it was
+   * loaded, keeping the VM and its globals.
+   *
+   * Modules are re-run in load order, so dependencies first. The new
+   * exports are bound into the old ones in place, so every holder of the
+   * module sees the new code: a table keeps its data slots and takes the
+   * new functions and slots, and a class keeps its identity (and
+   * instances) and takes the new methods. If the new table exports
+   * onReload(old), it is called first and the whole table is taken, so the
+   * script migrates its own data. Other exports replace the cached value
+   * for later require() calls only. A module that fails to compile, run or
+   * migrate keeps its old exports. The main script is not re-run; the
+   * Runtime restarts the cartridge for files that are not loaded modules.
+   * Job modules are re-read too and start over on their next job.
+   *
+   * Fails while the VM is running, paused or faulted.
+   * @return The first module error, if any.
+   */
+  Status reloadModules(ReloadStats *stats = nullptr);
+
+  /// True if @p vfsPath was loaded by require(), i.e. reloadModules()
+  /// covers it.
+  bool isModuleLoaded(const std::string &vfsPath) const {
+    return m_loadedModules.count(vfsPath) != 0;
+  }
+
 private:
   HSQUIRRELVM m_vm = nullptr;
   vfs::IVfs *m_vfs = nullptr;
 
+  ScriptConfig m_config;
+
+  // VM memory arena; must outlive m_vm
+  std::unique_ptr<VmAllocator> m_allocator;
+  bool m_memoryFault = false;
+  bool m_softCapWarned = false;
+  bool checkMemoryCaps();
+
+  // Per-tick entry points (update/draw). The closure is held with a strong
+  // ref and called directly; it is looked up again (by a key interned once)
+  // only when the root table's write version moved, i.e. after the script
+  // wrote any root slot, and on every resolveEntryPoints().
+  struct EntryPoint {
+    HSQOBJECT key;
+    HSQOBJECT root;
+    HSQOBJECT closure;
+    SQUnsignedInteger rootVersion;
+  };
+  EntryPoint m_updateEntry;
+  EntryPoint m_drawEntry;
+  void initEntryPoint(EntryPoint &entry, const char *name);
+  static void releaseEntryPoint(HSQUIRRELVM vm, EntryPoint &entry);
+  void bindEntryPoint(EntryPoint &entry);
+  bool pushEntryPoint(EntryPoint &entry);
+  void resolveEntryPoints();
+
+  // Compiles through the bytecode cache; pushes the closure on success
+  std::unique_ptr<BytecodeCache> m_bytecodeCache;
+  bool compileSource(HSQUIRRELVM vm, const std::string &source,
+                     const std::string &name);
+
   // Module system
-  std::unordered_map<std::string, HSQOBJECT> m_loadedModules;
+  struct LoadedModule {
+    HSQOBJECT exports;
+    u64 sourceHash = 0; // XXH64 of the source it ran; 0 if unknown
+    u32 order = 0;      // Load order; dependencies finish loading first
+  };
+  std::unordered_map<std::string, LoadedModule> m_loadedModules;
+  u32 m_moduleOrder = 0;
   std::vector<std::string> m_executionStack;
+  Status reloadModule(const std::string &path, const std::string &source);
 
   void registerStandardLibraries();
   void registerArcaneeApi();
@@ -174,11 +396,68 @@ private:
   std::string resolvePath(const std::string &path);
 
   // Watchdog
-  friend void debugHook(HSQUIRRELVM v, SQInteger type, const SQChar *sourcename,
-                        SQInteger line, const SQChar *funcname);
   bool m_watchdogEnabled = false;
   f64 m_watchdogTimeout = 0.5; // Default 500ms
-  f64 m_executionStartTime = 0.0;
+  std::unique_ptr<ScriptWatchdog> m_watchdog;
+  bool m_hangFault = false;
+  f64 watchdogTimeout() const;
+  bool checkWatchdog(const char *entryPoint);
+
+  // Shares the watchdog's interrupt word; declared after it so it stops first
+  ScriptProfiler m_profiler;
+
+  // Cycle collection outside the entry points
+  GcStats m_gcStats;
+  f64 m_gcSecPerObject = 0.0; // Measured; 0 until the first collection
+  u64 m_gcAllocMark = 0;      // Allocation count after the last collection
+  u32 m_gcDeferrals = 0;      // Consecutive over-budget frames
+  bool canCollect() const;
+  bool runCollection(SQInteger maxObjects, bool forced);
+
+  // Cooperative tasks (task.*), resumed by runTasks()
+  TaskScheduler m_tasks;
+
+  // Worker VMs for jobs.*; threads start on the first submit
+  std::unique_ptr<WorkerPool> m_workerPool;
+
+  // Broadphase bodies for collide.*, replaced by every collide.update()
+  physics::CollisionWorld m_collision;
+
+  // sprites.*, particles.*, nav.* and tweens.* state, stepped by
+  // stepServices()
+  render::SpriteStore m_sprites;
+  render::ParticleSystem m_particles;
+  nav::Pathfinder m_pathfinder;
+  anim::TweenSystem m_tweens;
+
+  // API objects snapshots refer to instead of copying; captured at the end of
+  // initialize() so every VM built with the same config agrees on it
+  SnapshotBaseline m_snapshotBaseline;
+
+  // Everything tied to one Squirrel VM. restoreSnapshot() parks the running
+  // VM in one of these while it builds the new one, and swaps it back if
+  // the snapshot does not load.
+  struct DetachedVm {
+    HSQUIRRELVM vm = nullptr;
+    std::unique_ptr<VmAllocator> allocator;
+    std::unique_ptr<BytecodeCache> bytecodeCache;
+    std::unique_ptr<WorkerPool> workerPool; // Registered into the VM
+    EntryPoint updateEntry{};
+    EntryPoint drawEntry{};
+    std::unordered_map<std::string, LoadedModule> loadedModules;
+    u32 moduleOrder = 0;
+    SnapshotBaseline snapshotBaseline;
+    bool memoryFault = false;
+    bool softCapWarned = false;
+    bool hangFault = false;
+    GcStats gcStats;
+    f64 gcSecPerObject = 0.0;
+    u64 gcAllocMark = 0;
+    u32 gcDeferrals = 0;
+  };
+  void swapVm(DetachedVm &other);
+  // Drops the worker pool, then closes the VM and its arena
+  void closeVm(DetachedVm &vm);
 
   std::unique_ptr<ScriptDebugger> m_debugger;
   bool m_terminateRequested = false;
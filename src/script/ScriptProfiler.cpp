@@ -0,0 +1,349 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file ScriptProfiler.cpp
+ */
+
+#include "ScriptProfiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace arcanee::script {
+
+namespace {
+
+void writeJsonString(std::ostream &out, const std::string &s) {
+  out << '"';
+  for (char c : s) {
+    switch (c) {
+    case '"':
+      out << "\\\"";
+      break;
+    case '\\':
+      out << "\\\\";
+      break;
+    case '\n':
+      out << "\\n";
+      break;
+    case '\t':
+      out << "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+        out << buf;
+      } else {
+        out << c;
+      }
+    }
+  }
+  out << '"';
+}
+
+} // namespace
+
+size_t ScriptProfiler::FrameKeyHash::operator()(const FrameKey &k) const {
+  size_t h = std::hash<const void *>()(k.function);
+  h ^= std::hash<const void *>()(k.source) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  h ^= std::hash<SQInteger>()(k.line) + 0x9e3779b9 + (h << 6) + (h >> 2);
+  return h;
+}
+
+size_t ScriptProfiler::StackHash::operator()(const std::vector<u32> &stack) const {
+  // FNV-1a over the frame ids
+  u64 h = 0xcbf29ce484222325ull;
+  for (u32 id : stack) {
+    h ^= id;
+    h *= 0x100000001b3ull;
+  }
+  return static_cast<size_t>(h);
+}
+
+ScriptProfiler::~ScriptProfiler() { stop(); }
+
+f64 ScriptProfiler::now() const {
+  return std::chrono::duration<f64>(std::chrono::steady_clock::now() - m_epoch)
+      .count();
+}
+
+void ScriptProfiler::start(ScriptWatchdog &interrupts, f64 intervalSec) {
+  stop();
+  if (m_stats.samples == 0) {
+    m_epoch = std::chrono::steady_clock::now();
+  }
+  m_intervalSec = intervalSec > 0.0 ? intervalSec : 0.001;
+  m_startTime = now();
+  m_interrupts = &interrupts;
+  m_interrupts->setSampler(onSample, this);
+
+  m_timerRunning = true;
+  m_timer = std::thread([this] { timerLoop(); });
+}
+
+void ScriptProfiler::stop() {
+  if (!m_interrupts)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_timerMutex);
+    m_timerRunning = false;
+  }
+  m_timerCv.notify_one();
+  m_timer.join();
+
+  m_interrupts->setSampler(nullptr, nullptr);
+  m_interrupts = nullptr;
+  m_stats.wallSec += now() - m_startTime;
+}
+
+void ScriptProfiler::reset() {
+  m_functions.clear();
+  m_functionIds.clear();
+  m_frames.clear();
+  m_frameIds.clear();
+  m_frameCache.clear();
+  m_stacks.clear();
+  m_stackCounts.clear();
+  m_stackIds.clear();
+  m_timeline.clear();
+  m_stats = Stats();
+  m_epoch = std::chrono::steady_clock::now();
+  m_startTime = 0.0;
+}
+
+void ScriptProfiler::timerLoop() {
+  auto interval =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<f64>(m_intervalSec));
+  auto next = std::chrono::steady_clock::now() + interval;
+
+  std::unique_lock<std::mutex> lock(m_timerMutex);
+  while (m_timerRunning) {
+    if (m_timerCv.wait_until(lock, next) == std::cv_status::timeout) {
+      m_interrupts->raise(ScriptWatchdog::kSampleBit);
+      // Fixed rate, but never try to catch up after a stall
+      next = std::max(next + interval, std::chrono::steady_clock::now());
+    }
+  }
+}
+
+void ScriptProfiler::onSample(HSQUIRRELVM v, void *user) {
+  static_cast<ScriptProfiler *>(user)->sample(v);
+}
+
+void ScriptProfiler::sample(HSQUIRRELVM v) {
+  auto t0 = std::chrono::steady_clock::now();
+
+  // Level 0 is the innermost call; collect leaf first, then flip
+  m_scratch.clear();
+  SQStackInfos si;
+  SQInteger level = 0;
+  while (level < kMaxDepth && SQ_SUCCEEDED(sq_stackinfos(v, level, &si))) {
+    m_scratch.push_back(internFrame(si));
+    ++level;
+  }
+  if (m_scratch.empty())
+    return;
+  if (level == kMaxDepth && SQ_SUCCEEDED(sq_stackinfos(v, level, &si))) {
+    m_stats.truncatedStacks++;
+  }
+  std::reverse(m_scratch.begin(), m_scratch.end());
+
+  u32 stack = internStack();
+  m_stackCounts[stack]++;
+  m_stats.samples++;
+
+  f64 time = std::chrono::duration<f64>(t0 - m_epoch).count();
+  if (m_timeline.size() < kMaxTimelineSamples) {
+    m_timeline.push_back({time, stack});
+  } else {
+    m_stats.droppedTimeline++;
+  }
+
+  m_stats.samplingSec +=
+      std::chrono::duration<f64>(std::chrono::steady_clock::now() - t0)
+          .count();
+}
+
+u32 ScriptProfiler::internFrame(const SQStackInfos &si) {
+  const SQChar *funcName = si.funcname ? si.funcname : "unknown";
+  const SQChar *source = si.source ? si.source : "unknown";
+
+  // The VM hands out the same string pointers for every sample in a function;
+  // the compares guard against a freed string's address being reused.
+  FrameKey key{funcName, source, si.line};
+  auto cached = m_frameCache.find(key);
+  if (cached != m_frameCache.end()) {
+    const Frame &frame = m_frames[cached->second];
+    const Function &fn = m_functions[frame.function];
+    if (std::strcmp(funcName, fn.name.c_str()) == 0 &&
+        std::strcmp(source, fn.source.c_str()) == 0) {
+      return cached->second;
+    }
+  }
+
+  std::string fnKey = std::string(funcName) + '\0' + source;
+  u32 fnId;
+  auto fnIt = m_functionIds.find(fnKey);
+  if (fnIt != m_functionIds.end()) {
+    fnId = fnIt->second;
+  } else {
+    fnId = static_cast<u32>(m_functions.size());
+    m_functions.push_back({funcName, source});
+    m_functionIds.emplace(fnKey, fnId);
+  }
+
+  std::string frameKey = fnKey + '\0' + std::to_string(si.line);
+  u32 frameId;
+  auto frameIt = m_frameIds.find(frameKey);
+  if (frameIt != m_frameIds.end()) {
+    frameId = frameIt->second;
+  } else {
+    frameId = static_cast<u32>(m_frames.size());
+    m_frames.push_back({fnId, static_cast<int>(si.line)});
+    m_frameIds.emplace(std::move(frameKey), frameId);
+  }
+
+  m_frameCache[key] = frameId;
+  return frameId;
+}
+
+u32 ScriptProfiler::internStack() {
+  auto it = m_stackIds.find(m_scratch);
+  if (it != m_stackIds.end())
+    return it->second;
+
+  u32 id = static_cast<u32>(m_stacks.size());
+  m_stacks.push_back(m_scratch);
+  m_stackCounts.push_back(0);
+  m_stackIds.emplace(m_scratch, id);
+  return id;
+}
+
+std::vector<ScriptProfiler::FunctionStats>
+ScriptProfiler::getFunctionStats() const {
+  std::vector<FunctionStats> result(m_frames.size());
+  for (size_t i = 0; i < m_frames.size(); ++i) {
+    const Function &fn = m_functions[m_frames[i].function];
+    result[i] = {fn.name, fn.source, m_frames[i].line, 0, 0};
+  }
+
+  std::vector<u32> seen(m_frames.size(), UINT32_MAX);
+  for (size_t s = 0; s < m_stacks.size(); ++s) {
+    const auto &stack = m_stacks[s];
+    u64 count = m_stackCounts[s];
+    result[stack.back()].selfSamples += count;
+    // Recursion puts a frame on the stack more than once; count it once
+    for (u32 frame : stack) {
+      if (seen[frame] != s) {
+        seen[frame] = static_cast<u32>(s);
+        result[frame].totalSamples += count;
+      }
+    }
+  }
+
+  result.erase(std::remove_if(result.begin(), result.end(),
+                              [](const FunctionStats &f) {
+                                return f.totalSamples == 0;
+                              }),
+               result.end());
+  std::sort(result.begin(), result.end(),
+            [](const FunctionStats &a, const FunctionStats &b) {
+              if (a.selfSamples != b.selfSamples)
+                return a.selfSamples > b.selfSamples;
+              return a.totalSamples > b.totalSamples;
+            });
+  return result;
+}
+
+void ScriptProfiler::writeCollapsed(std::ostream &out) const {
+  // Frames differ per line; flame graphs want one node per function, so
+  // merge stacks that only differ in line numbers
+  std::unordered_map<std::vector<u32>, u64, StackHash> merged;
+  std::vector<u32> fnStack;
+  for (size_t s = 0; s < m_stacks.size(); ++s) {
+    fnStack.clear();
+    for (u32 frame : m_stacks[s]) {
+      fnStack.push_back(m_frames[frame].function);
+    }
+    merged[fnStack] += m_stackCounts[s];
+  }
+
+  for (const auto &[stack, count] : merged) {
+    for (size_t i = 0; i < stack.size(); ++i) {
+      const Function &fn = m_functions[stack[i]];
+      if (i)
+        out << ';';
+      out << fn.name << " (" << fn.source << ')';
+    }
+    out << ' ' << count << '\n';
+  }
+}
+
+void ScriptProfiler::writeChromeTrace(std::ostream &out) const {
+  // Consecutive samples sharing a function prefix extend the same slices; a
+  // gap longer than a few intervals means the VM was idle in between.
+  const f64 gap = m_intervalSec * 3.0;
+  std::vector<u32> open;
+  std::vector<u32> fnStack;
+  f64 last = 0.0;
+  bool first = true;
+
+  out << "{\"traceEvents\":[";
+  auto event = [&](char phase, u32 fnId, f64 time) {
+    const Function &fn = m_functions[fnId];
+    out << (first ? "\n" : ",\n") << "{\"ph\":\"" << phase << "\",\"name\":";
+    writeJsonString(out, fn.name);
+    out << ",\"cat\":\"script\",\"pid\":1,\"tid\":1,\"ts\":"
+        << static_cast<u64>(time * 1e6);
+    if (phase == 'B') {
+      out << ",\"args\":{\"source\":";
+      writeJsonString(out, fn.source);
+      out << '}';
+    }
+    out << '}';
+    first = false;
+  };
+  auto closeFrom = [&](size_t depth, f64 time) {
+    while (open.size() > depth) {
+      event('E', open.back(), time);
+      open.pop_back();
+    }
+  };
+
+  for (const auto &entry : m_timeline) {
+    if (!open.empty() && entry.time - last > gap) {
+      closeFrom(0, last + m_intervalSec);
+    }
+
+    fnStack.clear();
+    for (u32 frame : m_stacks[entry.stack]) {
+      fnStack.push_back(m_frames[frame].function);
+    }
+
+    size_t common = 0;
+    while (common < open.size() && common < fnStack.size() &&
+           open[common] == fnStack[common]) {
+      ++common;
+    }
+    closeFrom(common, entry.time);
+    for (size_t i = common; i < fnStack.size(); ++i) {
+      event('B', fnStack[i], entry.time);
+      open.push_back(fnStack[i]);
+    }
+    last = entry.time;
+  }
+  closeFrom(0, last + m_intervalSec);
+
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,163 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file ScriptProfiler.h
+ * @brief Sampling profiler for Squirrel scripts.
+ *
+ * @ref specs/Chapter 10 — Workbench UX, Hot Reload, Debugging, and Profiling
+ */
+
+#include "ScriptWatchdog.h"
+#include "common/Types.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <squirrel.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace arcanee::script {
+
+/**
+ * @brief Timer-driven sampler that walks the VM stack at safe points.
+ *
+ * A timer thread raises ScriptWatchdog::kSampleBit every interval; the VM
+ * thread services it at its next backward jump or script call and records
+ * the stack with sq_stackinfos. Samples are therefore biased towards those
+ * safe points, and native calls that run long without re-entering the VM are
+ * attributed to their script caller.
+ *
+ * Everything except the timer runs on the VM thread, so the aggregates need
+ * no locking. The cost of each sample is measured and reported as overhead.
+ */
+class ScriptProfiler {
+public:
+  static constexpr int kMaxDepth = 64;
+  static constexpr size_t kMaxTimelineSamples = 1u << 20;
+
+  struct FunctionStats {
+    std::string function;
+    std::string source;
+    int line;
+    u64 selfSamples;  ///< Samples with this line at the top of the stack
+    u64 totalSamples; ///< Samples with this line anywhere on the stack
+  };
+
+  struct Stats {
+    u64 samples = 0;
+    u64 truncatedStacks = 0;  ///< Stacks deeper than kMaxDepth
+    u64 droppedTimeline = 0;  ///< Samples past kMaxTimelineSamples
+    f64 samplingSec = 0.0;    ///< Time spent inside the sampler
+    f64 wallSec = 0.0;        ///< Time between start() and stop()
+
+    /// Fraction of wall time spent sampling
+    f64 overhead() const { return wallSec > 0.0 ? samplingSec / wallSec : 0.0; }
+  };
+
+  ScriptProfiler() = default;
+  ~ScriptProfiler();
+
+  ScriptProfiler(const ScriptProfiler &) = delete;
+  ScriptProfiler &operator=(const ScriptProfiler &) = delete;
+
+  /**
+   * @brief Start sampling every @p intervalSec through @p interrupts.
+   */
+  void start(ScriptWatchdog &interrupts, f64 intervalSec);
+  void stop();
+  bool isRunning() const { return m_interrupts != nullptr; }
+
+  /**
+   * @brief Drop all samples collected so far.
+   */
+  void reset();
+
+  const Stats &getStats() const { return m_stats; }
+
+  /**
+   * @brief Per function-and-line sample counts, hottest (self) first.
+   */
+  std::vector<FunctionStats> getFunctionStats() const;
+
+  /**
+   * @brief Brendan Gregg collapsed stacks ("a;b;c count"), one line per
+   * unique stack at function granularity.
+   */
+  void writeCollapsed(std::ostream &out) const;
+
+  /**
+   * @brief Chrome trace event JSON (chrome://tracing, Perfetto).
+   */
+  void writeChromeTrace(std::ostream &out) const;
+
+private:
+  struct Function {
+    std::string name;
+    std::string source;
+  };
+  struct Frame {
+    u32 function;
+    int line;
+  };
+  struct TimelineEntry {
+    f64 time;
+    u32 stack;
+  };
+  struct FrameKey {
+    const SQChar *function;
+    const SQChar *source;
+    SQInteger line;
+    bool operator==(const FrameKey &o) const {
+      return function == o.function && source == o.source && line == o.line;
+    }
+  };
+  struct FrameKeyHash {
+    size_t operator()(const FrameKey &k) const;
+  };
+  struct StackHash {
+    size_t operator()(const std::vector<u32> &stack) const;
+  };
+
+  static void onSample(HSQUIRRELVM v, void *user);
+  void sample(HSQUIRRELVM v);
+  u32 internFrame(const SQStackInfos &si);
+  u32 internStack();
+  void timerLoop();
+  f64 now() const;
+
+  // Timer thread
+  ScriptWatchdog *m_interrupts = nullptr;
+  std::thread m_timer;
+  std::mutex m_timerMutex;
+  std::condition_variable m_timerCv;
+  bool m_timerRunning = false;
+  f64 m_intervalSec = 0.001;
+
+  // VM thread
+  std::chrono::steady_clock::time_point m_epoch;
+  f64 m_startTime = 0.0;
+  std::vector<Function> m_functions;
+  std::unordered_map<std::string, u32> m_functionIds;
+  std::vector<Frame> m_frames;
+  std::unordered_map<std::string, u32> m_frameIds;
+  std::unordered_map<FrameKey, u32, FrameKeyHash> m_frameCache;
+  std::vector<std::vector<u32>> m_stacks; // Frame ids, root first
+  std::vector<u64> m_stackCounts;
+  std::unordered_map<std::vector<u32>, u32, StackHash> m_stackIds;
+  std::vector<TimelineEntry> m_timeline;
+  std::vector<u32> m_scratch;
+  Stats m_stats;
+};
+
+} // namespace arcanee::script
@@ -0,0 +1,167 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file ScriptWatchdog.cpp
+ */
+
+#include "ScriptWatchdog.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace arcanee::script {
+
+namespace {
+
+// The interrupt word is shared with the patched VM as a plain volatile
+// integer, so updates go through compiler atomics rather than std::atomic.
+// SQInteger is 32 or 64 bits wide depending on _SQ64.
+void interruptOr(volatile SQInteger *word, SQInteger bits) {
+#ifdef _MSC_VER
+  if constexpr (sizeof(SQInteger) == 8)
+    _InterlockedOr64(reinterpret_cast<volatile __int64 *>(word), bits);
+  else
+    _InterlockedOr(reinterpret_cast<volatile long *>(word),
+                   static_cast<long>(bits));
+#else
+  __atomic_fetch_or(word, bits, __ATOMIC_RELEASE);
+#endif
+}
+
+void interruptAnd(volatile SQInteger *word, SQInteger bits) {
+#ifdef _MSC_VER
+  if constexpr (sizeof(SQInteger) == 8)
+    _InterlockedAnd64(reinterpret_cast<volatile __int64 *>(word), bits);
+  else
+    _InterlockedAnd(reinterpret_cast<volatile long *>(word),
+                    static_cast<long>(bits));
+#else
+  __atomic_fetch_and(word, bits, __ATOMIC_RELEASE);
+#endif
+}
+
+SQInteger interruptLoad(volatile SQInteger *word) {
+#ifdef _MSC_VER
+  return *word;
+#else
+  return __atomic_load_n(word, __ATOMIC_ACQUIRE);
+#endif
+}
+
+} // namespace
+
+ScriptWatchdog::ScriptWatchdog() {
+  m_thread = std::thread([this] { monitorLoop(); });
+}
+
+ScriptWatchdog::~ScriptWatchdog() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running = false;
+  }
+  m_cv.notify_one();
+  m_thread.join();
+}
+
+void ScriptWatchdog::raise(SQInteger bits) { interruptOr(&m_pending, bits); }
+
+void ScriptWatchdog::onHardCap(void *user) {
+  static_cast<ScriptWatchdog *>(user)->raise(kMemoryBit);
+}
+
+void ScriptWatchdog::setSampler(SampleFn fn, void *user) {
+  m_sampler = fn;
+  m_samplerUser = user;
+}
+
+void ScriptWatchdog::enter(f64 timeoutSec) {
+  m_tripped = false;
+  // A sample requested while the VM was idle would be charged to whatever
+  // runs first in this call; a hard cap hit is raised again by the next
+  // allocation if the arena is still over it. A timeout left over from an
+  // earlier call must not fault this one, armed or not.
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    interruptAnd(&m_pending, ~(kTimeoutBit | kSampleBit | kMemoryBit));
+  }
+  if (timeoutSec > 0.0) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_deadline =
+          std::chrono::steady_clock::now() +
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<f64>(timeoutSec));
+      m_armed = true;
+    }
+    m_cv.notify_one();
+  }
+  sq_setthreadinterrupt(&m_pending, onInterrupt, this);
+}
+
+void ScriptWatchdog::leave() {
+  sq_setthreadinterrupt(nullptr, nullptr, nullptr);
+  // No notify: the monitor wakes at the stale deadline and goes back to
+  // sleep. It only trips while armed and under the lock, so the bit cannot
+  // come back once it is cleared here.
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_armed = false;
+  interruptAnd(&m_pending, ~kTimeoutBit);
+}
+
+void ScriptWatchdog::monitorLoop() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (m_running) {
+    if (!m_armed) {
+      m_cv.wait(lock);
+      continue;
+    }
+    if (std::chrono::steady_clock::now() >= m_deadline) {
+      interruptOr(&m_pending, kTimeoutBit);
+      m_armed = false;
+      continue;
+    }
+    m_cv.wait_until(lock, m_deadline);
+  }
+}
+
+SQRESULT ScriptWatchdog::onInterrupt(HSQUIRRELVM v, SQUserPointer user) {
+  auto *self = static_cast<ScriptWatchdog *>(user);
+  SQInteger bits = interruptLoad(&self->m_pending);
+  if (bits & kTimeoutBit) {
+    self->m_tripped = true;
+    return sq_throwerror(v, "Watchdog timeout: Execution time limit exceeded");
+  }
+  if (bits & kMemoryBit) {
+    return sq_throwerror(v, "Out of memory: VM memory hard cap exceeded");
+  }
+  if (bits & kSampleBit) {
+    interruptAnd(&self->m_pending, ~kSampleBit);
+    if (self->m_sampler)
+      self->m_sampler(v, self->m_samplerUser);
+  }
+  return SQ_OK;
+}
+
+ScriptWatchdog::Scope::Scope(ScriptWatchdog *watchdog, f64 timeoutSec) {
+  if (!watchdog)
+    return;
+  m_watchdog = watchdog;
+  if (m_watchdog->m_depth++ == 0) {
+    m_watchdog->enter(timeoutSec);
+  }
+}
+
+ScriptWatchdog::Scope::~Scope() {
+  if (m_watchdog && --m_watchdog->m_depth == 0) {
+    m_watchdog->leave();
+  }
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,121 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file ScriptWatchdog.h
+ * @brief Hang watchdog driven by a monitor thread and the VM interrupt word.
+ *
+ * @ref specs/Chapter 12 §12.4.2
+ *      "If update() does not return within hang_watchdog_ms: Workbench MUST
+ *       interrupt execution if feasible"
+ */
+
+#include "common/Types.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <squirrel.h>
+#include <thread>
+
+namespace arcanee::script {
+
+/**
+ * @brief Deadline monitor that interrupts a running VM without debug hooks.
+ *
+ * A Scope arms a deadline and installs the interrupt word on the calling
+ * thread (sq_setthreadinterrupt, see cmake/patch_squirrel.sh). The VM only
+ * reads that word at backward jumps and script calls; when the monitor
+ * thread sets it past the deadline, the interrupt hook raises a script error
+ * that unwinds the call. The timeout bit stays set until the scope is left,
+ * so a script-level try/catch cannot swallow it.
+ *
+ * The same word carries sample requests for ScriptProfiler: raise(kSampleBit)
+ * from any thread makes the VM thread call the registered sampler at its next
+ * safe point. kMemoryBit, raised by the VM arena past its hard cap, unwinds
+ * the call like a timeout; it stays set until the next scope is entered.
+ */
+class ScriptWatchdog {
+public:
+  static constexpr SQInteger kTimeoutBit = 1 << 0;
+  static constexpr SQInteger kSampleBit = 1 << 1;
+  static constexpr SQInteger kMemoryBit = 1 << 2;
+
+  using SampleFn = void (*)(HSQUIRRELVM v, void *user);
+
+  ScriptWatchdog();
+  ~ScriptWatchdog();
+
+  ScriptWatchdog(const ScriptWatchdog &) = delete;
+  ScriptWatchdog &operator=(const ScriptWatchdog &) = delete;
+
+  /**
+   * @brief RAII guard covering one VM entry point.
+   *
+   * Installs the interrupt word for the call; a positive timeout also arms
+   * the deadline. A null watchdog makes the scope a no-op. Nested scopes keep
+   * the outermost deadline.
+   */
+  class Scope {
+  public:
+    Scope(ScriptWatchdog *watchdog, f64 timeoutSec);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    ScriptWatchdog *m_watchdog = nullptr;
+  };
+
+  /**
+   * @brief True if the last armed scope hit its deadline.
+   */
+  bool hasTripped() const { return m_tripped; }
+
+  /**
+   * @brief Set interrupt bits. Safe to call from any thread.
+   */
+  void raise(SQInteger bits);
+
+  /**
+   * @brief VmAllocator::HardCapFn raising kMemoryBit; @p user is the
+   * watchdog.
+   */
+  static void onHardCap(void *user);
+
+  /**
+   * @brief Register the handler for kSampleBit (VM thread; null clears).
+   */
+  void setSampler(SampleFn fn, void *user);
+
+private:
+  void enter(f64 timeoutSec);
+  void leave();
+  void monitorLoop();
+  static SQRESULT onInterrupt(HSQUIRRELVM v, SQUserPointer user);
+
+  // Written by the monitor/profiler threads, read by the VM thread
+  volatile SQInteger m_pending = 0;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::thread m_thread;
+  bool m_running = true;
+  bool m_armed = false;
+  std::chrono::steady_clock::time_point m_deadline;
+
+  // VM thread only
+  int m_depth = 0;
+  bool m_tripped = false;
+  SampleFn m_sampler = nullptr;
+  void *m_samplerUser = nullptr;
+};
+
+} // namespace arcanee::script
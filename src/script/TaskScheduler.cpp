@@ -0,0 +1,256 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file TaskScheduler.cpp
+ */
+
+#include "TaskScheduler.h"
+#include "BindingHelpers.h"
+#include "common/Log.h"
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace arcanee::script {
+
+namespace {
+
+f64 secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<f64>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+bool sameObject(const HSQOBJECT &a, const HSQOBJECT &b) {
+  return a._type == b._type && a._unVal.pRefCounted == b._unVal.pRefCounted;
+}
+
+// future[key] = value on top; pops the value
+void setField(HSQUIRRELVM vm, const HSQOBJECT &future, const SQChar *key) {
+  sq_pushobject(vm, future);
+  sq_pushstring(vm, key, -1);
+  sq_push(vm, -3);
+  sq_rawset(vm, -3);
+  sq_pop(vm, 2);
+}
+
+} // namespace
+
+void TaskScheduler::add(HSQUIRRELVM thread, const HSQOBJECT &threadObj,
+                        SQInteger nparams, const HSQOBJECT &future,
+                        i32 priority) {
+  Task task;
+  task.id = m_nextId++;
+  task.vm = thread;
+  task.thread = threadObj;
+  task.future = future;
+  sq_resetobject(&task.awaited);
+  task.nparams = nparams;
+  task.priority = priority;
+  task.lastRun = m_clock; // New tasks queue behind ones already waiting
+  m_tasks.push_back(task);
+  m_stats.spawned++;
+}
+
+SQInteger TaskScheduler::suspend(HSQUIRRELVM v, const HSQOBJECT *awaited) {
+  i64 index = m_currentId ? indexOf(m_currentId) : -1;
+  if (index < 0 || m_tasks[index].vm != v) {
+    setLastError(v, "task: yield and await only work inside a task");
+    sq_pushnull(v);
+    return 1;
+  }
+
+  Task &task = m_tasks[index];
+  if (awaited) {
+    if (sameObject(*awaited, task.future)) {
+      setLastError(v, "task.await: a task cannot await itself");
+      sq_pushnull(v);
+      return 1;
+    }
+    task.awaited = *awaited;
+    sq_addref(v, &task.awaited);
+  }
+
+  SQInteger res = sq_suspendvm(v);
+  if (res == SQ_ERROR && awaited) {
+    // e.g. called from inside a metamethod; the error propagates
+    sq_release(v, &task.awaited);
+    sq_resetobject(&task.awaited);
+  }
+  return res;
+}
+
+bool TaskScheduler::cancel(HSQUIRRELVM vm, const HSQOBJECT &future) {
+  for (size_t i = 0; i < m_tasks.size(); ++i) {
+    if (!sameObject(m_tasks[i].future, future))
+      continue;
+    if (m_tasks[i].id == m_currentId) {
+      m_tasks[i].cancelRequested = true;
+    } else {
+      finish(vm, i, Outcome::Cancelled);
+    }
+    return true;
+  }
+  return false;
+}
+
+const HSQOBJECT *TaskScheduler::currentFuture() const {
+  i64 index = m_currentId ? indexOf(m_currentId) : -1;
+  return index < 0 ? nullptr : &m_tasks[index].future;
+}
+
+u32 TaskScheduler::run(HSQUIRRELVM vm, f64 budgetSec) {
+  auto start = std::chrono::steady_clock::now();
+  u32 steps = 0;
+  while (secondsSince(start) < budgetSec) {
+    i64 next = pickNext(vm);
+    if (next < 0)
+      break;
+    step(vm, static_cast<size_t>(next));
+    steps++;
+  }
+  m_stats.steps += steps;
+  m_stats.lastSteps = steps;
+  m_stats.lastSec = secondsSince(start);
+  return steps;
+}
+
+void TaskScheduler::clear(HSQUIRRELVM vm) {
+  for (Task &task : m_tasks) {
+    sq_release(vm, &task.thread);
+    sq_release(vm, &task.future);
+    sq_release(vm, &task.awaited);
+  }
+  m_tasks.clear();
+  m_currentId = 0;
+}
+
+bool TaskScheduler::isPending(HSQUIRRELVM vm, const HSQOBJECT &future) {
+  sq_pushobject(vm, future);
+  sq_pushstring(vm, "status", -1);
+  bool pending = false;
+  if (SQ_SUCCEEDED(sq_rawget(vm, -2))) {
+    const SQChar *s = nullptr;
+    pending = SQ_SUCCEEDED(sq_getstring(vm, -1, &s)) &&
+              std::strcmp(s, "pending") == 0;
+    sq_pop(vm, 1);
+  }
+  sq_pop(vm, 1);
+  return pending;
+}
+
+i64 TaskScheduler::pickNext(HSQUIRRELVM vm) const {
+  i64 best = -1;
+  for (size_t i = 0; i < m_tasks.size(); ++i) {
+    const Task &task = m_tasks[i];
+    if (task.awaited._type != OT_NULL && isPending(vm, task.awaited))
+      continue;
+    if (best < 0 || task.priority > m_tasks[best].priority ||
+        (task.priority == m_tasks[best].priority &&
+         task.lastRun < m_tasks[best].lastRun)) {
+      best = static_cast<i64>(i);
+    }
+  }
+  return best;
+}
+
+void TaskScheduler::step(HSQUIRRELVM vm, size_t index) {
+  Task &task = m_tasks[index];
+  HSQUIRRELVM thread = task.vm;
+  u64 id = task.id;
+  m_currentId = id;
+
+  SQRESULT res;
+  if (!task.started) {
+    task.started = true;
+    res = sq_call(thread, task.nparams, SQTrue, SQFalse);
+  } else {
+    // Becomes the return value of the yield/await that suspended the task
+    if (task.awaited._type != OT_NULL) {
+      sq_pushobject(thread, task.awaited);
+      sq_pushstring(thread, "result", -1);
+      if (SQ_FAILED(sq_rawget(thread, -2)))
+        sq_pushnull(thread);
+      sq_remove(thread, -2);
+      sq_release(thread, &task.awaited);
+      sq_resetobject(&task.awaited);
+    } else {
+      sq_pushnull(thread);
+    }
+    res = sq_wakeupvm(thread, SQTrue, SQTrue, SQFalse, SQFalse);
+  }
+  m_currentId = 0;
+
+  // The task may have spawned or cancelled others; find it again
+  i64 at = indexOf(id);
+  if (at < 0)
+    return;
+  index = static_cast<size_t>(at);
+  m_tasks[index].lastRun = ++m_clock;
+
+  if (SQ_FAILED(res)) {
+    sq_getlasterror(thread);
+    if (SQ_FAILED(sq_tostring(thread, -1)))
+      sq_pushstring(thread, "unknown error", -1);
+    sq_move(vm, thread, -1);
+    sq_settop(thread, 0);
+    const SQChar *msg = "";
+    sq_getstring(vm, -1, &msg);
+    LOG_ERROR("Task failed: %s", msg);
+    finish(vm, index, Outcome::Failed);
+  } else if (sq_getvmstate(thread) == SQ_VMSTATE_SUSPENDED) {
+    sq_pop(thread, 1); // Value passed to suspend()
+    if (m_tasks[index].cancelRequested)
+      finish(vm, index, Outcome::Cancelled);
+  } else if (m_tasks[index].cancelRequested) {
+    sq_settop(thread, 0);
+    finish(vm, index, Outcome::Cancelled);
+  } else {
+    sq_move(vm, thread, -1); // Return value
+    sq_settop(thread, 0);
+    finish(vm, index, Outcome::Done);
+  }
+}
+
+i64 TaskScheduler::indexOf(u64 id) const {
+  for (size_t i = 0; i < m_tasks.size(); ++i) {
+    if (m_tasks[i].id == id)
+      return static_cast<i64>(i);
+  }
+  return -1;
+}
+
+void TaskScheduler::finish(HSQUIRRELVM vm, size_t index, Outcome outcome) {
+  Task task = m_tasks[index];
+  m_tasks.erase(m_tasks.begin() + static_cast<std::ptrdiff_t>(index));
+
+  switch (outcome) {
+  case Outcome::Done:
+    setField(vm, task.future, "result");
+    sq_pushstring(vm, "done", -1);
+    m_stats.completed++;
+    break;
+  case Outcome::Failed:
+    setField(vm, task.future, "error");
+    sq_pushstring(vm, "failed", -1);
+    m_stats.failed++;
+    break;
+  case Outcome::Cancelled:
+    sq_pushstring(vm, "cancelled", -1);
+    m_stats.cancelled++;
+    break;
+  }
+  setField(vm, task.future, "status");
+
+  sq_release(vm, &task.thread);
+  sq_release(vm, &task.future);
+  sq_release(vm, &task.awaited);
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,128 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file TaskScheduler.h
+ * @brief Time-sliced cooperative tasks on Squirrel threads.
+ */
+
+#include "common/Types.h"
+#include <squirrel.h>
+#include <vector>
+
+namespace arcanee::script {
+
+/**
+ * @brief Runs script tasks between update() calls within a time budget.
+ *
+ * Each task is a Squirrel thread. It runs until it yields (task.yield(),
+ * task.await() or the builtin suspend()) and is resumed with sq_wakeupvm on
+ * a later step. run() keeps stepping the highest-priority runnable task,
+ * oldest-resumed first among equals, until the budget is spent; lower
+ * priorities only run when no higher one is runnable.
+ *
+ * Every task has a future: a table with the shared task delegate whose
+ * `status` field is "pending", "done", "failed" or "cancelled", and which
+ * gains `result` or `error` once the task ends. A task awaiting a future is
+ * not runnable until that future settles.
+ *
+ * The budget is wall time, so how far tasks get per frame is not
+ * deterministic.
+ */
+class TaskScheduler {
+public:
+  struct Stats {
+    u64 spawned = 0;
+    u64 completed = 0;
+    u64 failed = 0;
+    u64 cancelled = 0;
+    u64 steps = 0;     ///< Resumes, all runs
+    u32 lastSteps = 0; ///< Resumes in the last run()
+    f64 lastSec = 0.0;
+  };
+
+  TaskScheduler() = default;
+  TaskScheduler(const TaskScheduler &) = delete;
+  TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+  /**
+   * @brief Queue a task.
+   *
+   * @p thread holds, bottom up, the function, `this` and any arguments;
+   * @p nparams counts `this` and the arguments. Takes over the strong refs
+   * on @p threadObj and @p future.
+   */
+  void add(HSQUIRRELVM thread, const HSQOBJECT &threadObj,
+           SQInteger nparams, const HSQOBJECT &future, i32 priority);
+
+  /**
+   * @brief Suspend the calling task (a native's return value).
+   *
+   * With @p awaited, the task stays parked until that future settles and
+   * the native then returns the future's result. Outside a task this sets
+   * the last error and returns null.
+   */
+  SQInteger suspend(HSQUIRRELVM v, const HSQOBJECT *awaited);
+
+  /**
+   * @brief Stop the task behind @p future. A task cancelling itself stops at
+   * its next yield. False if the task already ended.
+   */
+  bool cancel(HSQUIRRELVM vm, const HSQOBJECT &future);
+
+  /// Future of the running task, or null outside a task.
+  const HSQOBJECT *currentFuture() const;
+
+  /**
+   * @brief Resume tasks until @p budgetSec is spent or none can run.
+   * @return Number of resumes.
+   */
+  u32 run(HSQUIRRELVM vm, f64 budgetSec);
+
+  /// Drop every task (their futures stay pending). Call before sq_close.
+  void clear(HSQUIRRELVM vm);
+
+  size_t size() const { return m_tasks.size(); }
+  const Stats &getStats() const { return m_stats; }
+
+  /// True if @p future is still "pending".
+  static bool isPending(HSQUIRRELVM vm, const HSQOBJECT &future);
+
+private:
+  struct Task {
+    u64 id = 0;
+    HSQUIRRELVM vm = nullptr;
+    HSQOBJECT thread;
+    HSQOBJECT future;
+    HSQOBJECT awaited; // Null unless parked in await()
+    SQInteger nparams = 0;
+    i32 priority = 0;
+    u64 lastRun = 0; // Round-robin stamp among equal priorities
+    bool started = false;
+    bool cancelRequested = false;
+  };
+
+  enum class Outcome { Done, Failed, Cancelled };
+
+  i64 pickNext(HSQUIRRELVM vm) const;
+  void step(HSQUIRRELVM vm, size_t index);
+  i64 indexOf(u64 id) const;
+  // Settles the future (the result or error is on top of @p vm) and drops
+  // the task
+  void finish(HSQUIRRELVM vm, size_t index, Outcome outcome);
+
+  std::vector<Task> m_tasks;
+  u64 m_nextId = 1;
+  u64 m_clock = 0;
+  u64 m_currentId = 0; // 0 when no task is running
+  Stats m_stats;
+};
+
+} // namespace arcanee::script
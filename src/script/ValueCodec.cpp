@@ -0,0 +1,351 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file ValueCodec.cpp
+ */
+
+#include "ValueCodec.h"
+#include "api/BufferBinding.h"
+#include "api/MathBinding.h"
+#include <cstring>
+#include <string>
+
+namespace arcanee::script {
+
+namespace {
+
+constexpr int kMaxDepth = 32;
+// Natives only get a few free stack slots; a container level takes up to
+// three (iterator, key, value) plus one for the leaf being converted
+constexpr SQInteger kSlotsPerLevel = 4;
+
+// Save data stores these (SaveData.cpp): only ever append new tags, and bump
+// kSaveFormat when doing so
+enum Tag : u8 {
+  kNull,
+  kFalse,
+  kTrue,
+  kInteger,
+  kFloat,
+  kString,
+  kArray,
+  kTable,
+  kBuffer,
+  kMath,
+};
+
+constexpr MathType kMathTypes[] = {MathType::Vec2, MathType::Vec3,
+                                   MathType::Vec4, MathType::Quat,
+                                   MathType::Mat3};
+
+u32 componentsOf(MathType type) {
+  switch (type) {
+  case MathType::Vec2:
+    return 2;
+  case MathType::Vec3:
+    return 3;
+  case MathType::Vec4:
+  case MathType::Quat:
+    return 4;
+  default:
+    return 9;
+  }
+}
+
+Status dataLoss() {
+  return Status(StatusCode::DataLoss, "encoded value is corrupt");
+}
+
+bool isScalarKey(SQObjectType type) {
+  return type == OT_INTEGER || type == OT_FLOAT || type == OT_STRING ||
+         type == OT_BOOL;
+}
+
+class Encoder {
+public:
+  Encoder(HSQUIRRELVM vm, std::vector<u8> &out, u64 maxBytes)
+      : m_vm(vm), m_out(out), m_w(out), m_maxBytes(maxBytes),
+        m_start(out.size()) {}
+
+  Status value(SQInteger idx, int depth) {
+    if (depth > kMaxDepth) {
+      return Status::InvalidArgument(
+          "cannot send value: nesting too deep (is there a cycle?)");
+    }
+    // Checked per value: the byte count is what grows, not the depth
+    ARC_RETURN_IF_ERROR(reserve(0));
+
+    switch (sq_gettype(m_vm, idx)) {
+    case OT_NULL:
+      m_w.writeU8(kNull);
+      return Status::Ok();
+    case OT_BOOL: {
+      SQBool b = SQFalse;
+      sq_getbool(m_vm, idx, &b);
+      m_w.writeU8(b ? kTrue : kFalse);
+      return Status::Ok();
+    }
+    case OT_INTEGER: {
+      SQInteger i = 0;
+      sq_getinteger(m_vm, idx, &i);
+      m_w.writeU8(kInteger);
+      m_w.writeSigned(i);
+      return Status::Ok();
+    }
+    case OT_FLOAT: {
+      SQFloat f = 0;
+      sq_getfloat(m_vm, idx, &f);
+      m_w.writeU8(kFloat);
+      m_w.writeF64(f);
+      return Status::Ok();
+    }
+    case OT_STRING: {
+      const SQChar *s = nullptr;
+      SQInteger len = 0;
+      sq_getstringandsize(m_vm, idx, &s, &len);
+      ARC_RETURN_IF_ERROR(
+          reserve(static_cast<u64>(len) * sizeof(SQChar)));
+      m_w.writeU8(kString);
+      m_w.writeVarint(static_cast<u64>(len));
+      m_w.writeBytes(s, static_cast<size_t>(len) * sizeof(SQChar));
+      return Status::Ok();
+    }
+    case OT_ARRAY:
+      return container(idx, depth, kArray);
+    case OT_TABLE:
+      return container(idx, depth, kTable);
+    case OT_USERDATA:
+      return userdata(idx);
+    default:
+      return Status::InvalidArgument("cannot send a " + typeName(idx));
+    }
+  }
+
+  // Container headers are written unchecked; this covers the last ones
+  Status finish() const { return reserve(0); }
+
+private:
+  // Fails once the value would pass the budget with @p bytes more
+  Status reserve(u64 bytes) const {
+    const u64 used = m_out.size() - m_start;
+    if (used > m_maxBytes || bytes > m_maxBytes - used) {
+      return Status(StatusCode::ResourceExhausted,
+                    "cannot send value: larger than " +
+                        std::to_string(m_maxBytes) + " bytes");
+    }
+    return Status::Ok();
+  }
+
+  std::string typeName(SQInteger idx) {
+    std::string name = "value";
+    const SQChar *s = nullptr;
+    if (SQ_SUCCEEDED(sq_typeof(m_vm, idx))) {
+      if (SQ_SUCCEEDED(sq_getstring(m_vm, -1, &s)))
+        name = s;
+      sq_pop(m_vm, 1);
+    }
+    return name;
+  }
+
+  Status container(SQInteger idx, int depth, Tag tag) {
+    idx = idx < 0 ? sq_gettop(m_vm) + idx + 1 : idx;
+    if (SQ_FAILED(sq_reservestack(m_vm, kSlotsPerLevel))) {
+      return Status(StatusCode::ResourceExhausted,
+                    "cannot send value: out of stack");
+    }
+    m_w.writeU8(tag);
+    m_w.writeVarint(static_cast<u64>(sq_getsize(m_vm, idx)));
+
+    Status status;
+    sq_pushnull(m_vm);
+    while (status.ok() && SQ_SUCCEEDED(sq_next(m_vm, idx))) {
+      if (tag == kTable) {
+        if (!isScalarKey(sq_gettype(m_vm, -2))) {
+          status = Status::InvalidArgument(
+              "cannot send a table with non-scalar keys");
+        } else {
+          status = value(-2, depth + 1);
+        }
+      }
+      if (status.ok())
+        status = value(-1, depth + 1);
+      sq_pop(m_vm, 2);
+    }
+    sq_pop(m_vm, 1); // iterator
+    return status;
+  }
+
+  Status userdata(SQInteger idx) {
+    BufferView buf;
+    if (getBuffer(m_vm, idx, buf)) {
+      ARC_RETURN_IF_ERROR(reserve(buf.byteSize()));
+      m_w.writeU8(kBuffer);
+      m_w.writeU8(static_cast<u8>(buf.type));
+      m_w.writeVarint(static_cast<u64>(buf.length));
+      m_w.writeBytes(buf.data, buf.byteSize());
+      return Status::Ok();
+    }
+    for (MathType type : kMathTypes) {
+      if (f32 *c = getMath(m_vm, idx, type)) {
+        m_w.writeU8(kMath);
+        m_w.writeU8(static_cast<u8>(type));
+        m_w.writeBytes(c, componentsOf(type) * sizeof(f32));
+        return Status::Ok();
+      }
+    }
+    return Status::InvalidArgument("cannot send a " + typeName(idx));
+  }
+
+  HSQUIRRELVM m_vm;
+  std::vector<u8> &m_out;
+  ByteWriter m_w;
+  u64 m_maxBytes;
+  size_t m_start;
+};
+
+class Decoder {
+public:
+  Decoder(HSQUIRRELVM vm, ByteReader &in) : m_vm(vm), m_r(in) {}
+
+  bool isOutOfStack() const { return m_outOfStack; }
+
+  // Pushes exactly one value on success
+  bool value(int depth) {
+    if (depth > kMaxDepth)
+      return false;
+
+    switch (m_r.readU8()) {
+    case kNull:
+      sq_pushnull(m_vm);
+      break;
+    case kFalse:
+      sq_pushbool(m_vm, SQFalse);
+      break;
+    case kTrue:
+      sq_pushbool(m_vm, SQTrue);
+      break;
+    case kInteger:
+      sq_pushinteger(m_vm, static_cast<SQInteger>(m_r.readSigned()));
+      break;
+    case kFloat:
+      sq_pushfloat(m_vm, static_cast<SQFloat>(m_r.readF64()));
+      break;
+    case kString: {
+      u64 len = m_r.readVarint();
+      if (len > m_r.remaining() / sizeof(SQChar))
+        return false;
+      const u8 *s = m_r.readBytes(static_cast<size_t>(len) * sizeof(SQChar));
+      sq_pushstring(m_vm, reinterpret_cast<const SQChar *>(s),
+                    static_cast<SQInteger>(len));
+      break;
+    }
+    case kArray:
+      return container(false, depth);
+    case kTable:
+      return container(true, depth);
+    case kBuffer:
+      return buffer();
+    case kMath:
+      return math();
+    default:
+      return false;
+    }
+    return m_r.ok();
+  }
+
+private:
+  bool container(bool table, int depth) {
+    u64 count = m_r.readVarint();
+    if (!m_r.ok() || count > m_r.remaining()) // Entries take a byte or more
+      return false;
+    if (SQ_FAILED(sq_reservestack(m_vm, kSlotsPerLevel))) {
+      m_outOfStack = true;
+      return false;
+    }
+
+    if (table)
+      sq_newtableex(m_vm, static_cast<SQInteger>(count));
+    else
+      sq_newarray(m_vm, 0);
+    for (u64 i = 0; i < count; ++i) {
+      if (table) {
+        if (!value(depth + 1) || !value(depth + 1) ||
+            SQ_FAILED(sq_rawset(m_vm, -3))) {
+          return false;
+        }
+      } else {
+        if (!value(depth + 1))
+          return false;
+        sq_arrayappend(m_vm, -2);
+      }
+    }
+    return true;
+  }
+
+  bool buffer() {
+    u8 type = m_r.readU8();
+    u64 length = m_r.readVarint();
+    if (!m_r.ok() || type > static_cast<u8>(BufferType::Byte))
+      return false;
+    size_t elementSize = type == static_cast<u8>(BufferType::Byte) ? 1 : 4;
+    if (length > m_r.remaining() / elementSize)
+      return false;
+    size_t bytes = static_cast<size_t>(length) * elementSize;
+    void *dst = pushBuffer(m_vm, static_cast<BufferType>(type),
+                           static_cast<SQInteger>(length));
+    if (!dst)
+      return false;
+    std::memcpy(dst, m_r.readBytes(bytes), bytes);
+    return true;
+  }
+
+  bool math() {
+    u8 type = m_r.readU8();
+    if (!m_r.ok() || type > static_cast<u8>(MathType::Mat3))
+      return false;
+    size_t bytes = componentsOf(static_cast<MathType>(type)) * sizeof(f32);
+    const u8 *src = m_r.readBytes(bytes);
+    if (!src)
+      return false;
+    std::memcpy(pushMath(m_vm, static_cast<MathType>(type)), src, bytes);
+    return true;
+  }
+
+  HSQUIRRELVM m_vm;
+  ByteReader &m_r;
+  bool m_outOfStack = false;
+};
+
+} // namespace
+
+Status encodeValue(HSQUIRRELVM vm, SQInteger idx, std::vector<u8> &out,
+                   u64 maxBytes) {
+  size_t start = out.size();
+  Encoder encoder(vm, out, maxBytes);
+  Status status = encoder.value(idx, 0);
+  if (status.ok())
+    status = encoder.finish();
+  if (!status.ok())
+    out.resize(start);
+  return status;
+}
+
+Status decodeValue(HSQUIRRELVM vm, ByteReader &in) {
+  SQInteger top = sq_gettop(vm);
+  Decoder decoder(vm, in);
+  if (!decoder.value(0)) {
+    sq_settop(vm, top);
+    if (decoder.isOutOfStack())
+      return Status(StatusCode::ResourceExhausted, "out of stack");
+    return dataLoss();
+  }
+  return Status::Ok();
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,49 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file ValueCodec.h
+ * @brief Copy script values between VMs as bytes.
+ */
+
+#include "common/ByteStream.h"
+#include "common/Status.h"
+#include <squirrel.h>
+#include <vector>
+
+namespace arcanee::script {
+
+/**
+ * @brief Append the value at @p idx to @p out.
+ *
+ * Handles null, bool, integer, float, string, arrays, tables (scalar keys),
+ * typed buffers and math values; nested containers are copied, so shared
+ * references arrive as separate copies. Anything else (functions, classes,
+ * instances, threads) and nesting deeper than 32 levels, which is how
+ * cycles surface, fail with InvalidArgument. Stack space is reserved per
+ * level; if the VM cannot grow its stack this fails with ResourceExhausted.
+ *
+ * Encoding stops with ResourceExhausted as soon as more than @p maxBytes
+ * would be appended, so values that share references (each copy is written
+ * out again) cannot grow @p out much past the budget.
+ */
+Status encodeValue(HSQUIRRELVM vm, SQInteger idx, std::vector<u8> &out,
+                   u64 maxBytes);
+
+/**
+ * @brief Push the next value from @p in onto @p vm.
+ *
+ * Buffers and math values need their bindings registered in @p vm.
+ * Truncated or malformed input fails with DataLoss and pushes nothing; a VM
+ * that cannot grow its stack fails with ResourceExhausted.
+ */
+Status decodeValue(HSQUIRRELVM vm, ByteReader &in);
+
+} // namespace arcanee::script
@@ -0,0 +1,331 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file VmAllocator.cpp
+ */
+
+#include "VmAllocator.h"
+#include "common/Assert.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <squirrel.h>
+
+namespace arcanee::script {
+
+namespace {
+
+constexpr u32 kChunkMagic = 0x41524331; // "ARC1"
+
+thread_local VmAllocator *tl_current = nullptr;
+
+// Process-wide arena used when no VM scope is active. Never destroyed so
+// blocks handed out to a VM outliving static destruction stay valid.
+VmAllocator &fallbackArena() {
+  static VmAllocator *arena = new VmAllocator();
+  return *arena;
+}
+
+std::mutex &fallbackMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+void *alignedAlloc(size_t alignment, size_t size) {
+#ifdef _WIN32
+  return _aligned_malloc(size, alignment);
+#else
+  return std::aligned_alloc(alignment, size);
+#endif
+}
+
+void alignedFree(void *p) {
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+} // namespace
+
+struct VmAllocator::ChunkHeader {
+  u32 magic;
+  u32 classIndex;
+  VmAllocator *owner;
+  ChunkHeader *next;
+  u64 reserved; // Pads the header to a multiple of kGranularity
+};
+
+struct VmAllocator::LargeHeader {
+  VmAllocator *owner;
+  LargeHeader *prev;
+  LargeHeader *next;
+  u64 size;
+};
+
+VmAllocator::VmAllocator() {
+  static_assert(sizeof(ChunkHeader) % kGranularity == 0,
+                "Chunk header must keep blocks 16-byte aligned");
+  static_assert(sizeof(LargeHeader) % kGranularity == 0,
+                "Large header must keep blocks 16-byte aligned");
+}
+
+VmAllocator::~VmAllocator() { releaseAll(); }
+
+void VmAllocator::setCaps(u64 softCapBytes, u64 hardCapBytes) {
+  m_softCap = softCapBytes;
+  m_hardCap = hardCapBytes;
+  m_hardCapHit = m_hardCap != 0 && m_stats.bytesInUse > m_hardCap;
+}
+
+void VmAllocator::setHardCapHandler(HardCapFn fn, void *user) {
+  m_onHardCap = fn;
+  m_onHardCapUser = user;
+}
+
+size_t VmAllocator::classIndex(size_t size) {
+  return size == 0 ? 0 : (size - 1) / kGranularity;
+}
+
+size_t VmAllocator::classSize(size_t index) {
+  return (index + 1) * kGranularity;
+}
+
+void VmAllocator::account(i64 delta) {
+  m_stats.bytesInUse = static_cast<u64>(
+      static_cast<i64>(m_stats.bytesInUse) + delta);
+  if (m_stats.bytesInUse > m_stats.peakBytes) {
+    m_stats.peakBytes = m_stats.bytesInUse;
+  }
+  if (m_hardCap != 0 && m_stats.bytesInUse > m_hardCap) {
+    m_hardCapHit = true;
+    if (delta > 0 && m_onHardCap)
+      m_onHardCap(m_onHardCapUser);
+  }
+}
+
+void *VmAllocator::allocate(size_t size) {
+  m_stats.allocCount++;
+  account(static_cast<i64>(size));
+  if (size <= kMaxSmallSize) {
+    return allocateSmall(classIndex(size));
+  }
+  return allocateLarge(size);
+}
+
+void VmAllocator::deallocate(void *p, size_t size) {
+  if (!p)
+    return;
+  m_stats.freeCount++;
+  account(-static_cast<i64>(size));
+  if (size <= kMaxSmallSize) {
+    freeSmall(p, classIndex(size));
+  } else {
+    freeLarge(p);
+  }
+}
+
+void *VmAllocator::reallocate(void *p, size_t oldSize, size_t newSize) {
+  if (!p) {
+    return allocate(newSize);
+  }
+
+  bool oldSmall = oldSize <= kMaxSmallSize;
+  bool newSmall = newSize <= kMaxSmallSize;
+
+  // Same size class: the block already fits
+  if (oldSmall && newSmall && classIndex(oldSize) == classIndex(newSize)) {
+    account(static_cast<i64>(newSize) - static_cast<i64>(oldSize));
+    return p;
+  }
+
+  // Large to large: let the host realloc and relink the moved header
+  if (!oldSmall && !newSmall) {
+    LargeHeader *h = static_cast<LargeHeader *>(p) - 1;
+    LargeHeader *prev = h->prev;
+    LargeHeader *next = h->next;
+    auto *moved = static_cast<LargeHeader *>(
+        std::realloc(h, sizeof(LargeHeader) + newSize));
+    ARCANEE_ASSERT(moved != nullptr, "VM large block realloc failed");
+    if (prev)
+      prev->next = moved;
+    else
+      m_large = moved;
+    if (next)
+      next->prev = moved;
+    m_stats.reservedBytes += newSize;
+    m_stats.reservedBytes -= moved->size;
+    moved->size = newSize;
+    account(static_cast<i64>(newSize) - static_cast<i64>(oldSize));
+    return moved + 1;
+  }
+
+  void *fresh = allocate(newSize);
+  std::memcpy(fresh, p, oldSize < newSize ? oldSize : newSize);
+  deallocate(p, oldSize);
+  return fresh;
+}
+
+void *VmAllocator::allocateSmall(size_t index) {
+  SizeClass &cls = m_classes[index];
+  if (cls.freeList) {
+    FreeBlock *block = cls.freeList;
+    cls.freeList = block->next;
+    return block;
+  }
+
+  size_t blockSize = classSize(index);
+  if (cls.bumpPtr + blockSize > cls.bumpEnd || !cls.bumpPtr) {
+    auto *chunk =
+        static_cast<ChunkHeader *>(alignedAlloc(kChunkSize, kChunkSize));
+    ARCANEE_ASSERT(chunk != nullptr, "VM chunk allocation failed");
+    chunk->magic = kChunkMagic;
+    chunk->classIndex = static_cast<u32>(index);
+    chunk->owner = this;
+    chunk->next = cls.chunks;
+    chunk->reserved = 0;
+    cls.chunks = chunk;
+    cls.bumpPtr = reinterpret_cast<char *>(chunk) + sizeof(ChunkHeader);
+    cls.bumpEnd = reinterpret_cast<char *>(chunk) + kChunkSize;
+    m_stats.reservedBytes += kChunkSize;
+  }
+
+  void *block = cls.bumpPtr;
+  cls.bumpPtr += blockSize;
+  return block;
+}
+
+void VmAllocator::freeSmall(void *p, size_t index) {
+  auto *block = static_cast<FreeBlock *>(p);
+  block->next = m_classes[index].freeList;
+  m_classes[index].freeList = block;
+}
+
+void *VmAllocator::allocateLarge(size_t size) {
+  auto *h = static_cast<LargeHeader *>(std::malloc(sizeof(LargeHeader) + size));
+  ARCANEE_ASSERT(h != nullptr, "VM large block allocation failed");
+  h->owner = this;
+  h->prev = nullptr;
+  h->next = m_large;
+  h->size = size;
+  if (m_large)
+    m_large->prev = h;
+  m_large = h;
+  m_stats.reservedBytes += sizeof(LargeHeader) + size;
+  return h + 1;
+}
+
+void VmAllocator::freeLarge(void *p) {
+  LargeHeader *h = static_cast<LargeHeader *>(p) - 1;
+  if (h->prev)
+    h->prev->next = h->next;
+  else
+    m_large = h->next;
+  if (h->next)
+    h->next->prev = h->prev;
+  m_stats.reservedBytes -= sizeof(LargeHeader) + h->size;
+  std::free(h);
+}
+
+void VmAllocator::releaseAll() {
+  for (auto &cls : m_classes) {
+    ChunkHeader *chunk = cls.chunks;
+    while (chunk) {
+      ChunkHeader *next = chunk->next;
+      alignedFree(chunk);
+      chunk = next;
+    }
+    cls = SizeClass{};
+  }
+
+  LargeHeader *h = m_large;
+  while (h) {
+    LargeHeader *next = h->next;
+    std::free(h);
+    h = next;
+  }
+  m_large = nullptr;
+
+  m_stats = Stats{};
+  m_hardCapHit = false;
+}
+
+VmAllocator *VmAllocator::ownerOf(void *p, size_t size) {
+  if (size <= kMaxSmallSize) {
+    auto *chunk = reinterpret_cast<ChunkHeader *>(
+        reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(kChunkSize - 1));
+    ARCANEE_ASSERT(chunk->magic == kChunkMagic,
+                   "VM block freed with a size it was not allocated with");
+    return chunk->owner;
+  }
+  return (static_cast<LargeHeader *>(p) - 1)->owner;
+}
+
+VmAllocator *VmAllocator::current() {
+  return tl_current ? tl_current : &fallbackArena();
+}
+
+VmAllocator::Scope::Scope(VmAllocator *allocator) : m_previous(tl_current) {
+  tl_current = allocator;
+}
+
+VmAllocator::Scope::~Scope() { tl_current = m_previous; }
+
+void *VmAllocator::vmMalloc(size_t size) {
+  if (tl_current) {
+    return tl_current->allocate(size);
+  }
+  std::lock_guard<std::mutex> lock(fallbackMutex());
+  return fallbackArena().allocate(size);
+}
+
+void *VmAllocator::vmRealloc(void *p, size_t oldSize, size_t newSize) {
+  // Blocks stay in the arena that first handed them out
+  VmAllocator *owner = p ? ownerOf(p, oldSize) : current();
+  if (owner != &fallbackArena()) {
+    return owner->reallocate(p, oldSize, newSize);
+  }
+  std::lock_guard<std::mutex> lock(fallbackMutex());
+  return owner->reallocate(p, oldSize, newSize);
+}
+
+void VmAllocator::vmFree(void *p, size_t size) {
+  if (!p)
+    return;
+  VmAllocator *owner = ownerOf(p, size);
+  if (owner != &fallbackArena()) {
+    owner->deallocate(p, size);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(fallbackMutex());
+  owner->deallocate(p, size);
+}
+
+} // namespace arcanee::script
+
+// ============================================================================
+// Squirrel memory hooks (squirrel_static is built with
+// SQ_EXCLUDE_DEFAULT_MEMFUNCTIONS, see top-level CMakeLists.txt)
+// ============================================================================
+
+void *sq_vm_malloc(SQUnsignedInteger size) {
+  return arcanee::script::VmAllocator::vmMalloc(static_cast<size_t>(size));
+}
+
+void *sq_vm_realloc(void *p, SQUnsignedInteger oldsize,
+                    SQUnsignedInteger size) {
+  return arcanee::script::VmAllocator::vmRealloc(
+      p, static_cast<size_t>(oldsize), static_cast<size_t>(size));
+}
+
+void sq_vm_free(void *p, SQUnsignedInteger size) {
+  arcanee::script::VmAllocator::vmFree(p, static_cast<size_t>(size));
+}
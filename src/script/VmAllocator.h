@@ -0,0 +1,166 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file VmAllocator.h
+ * @brief Per-VM arena allocator backing Squirrel's sq_vm_* memory hooks.
+ *
+ * @ref specs/Chapter 12 §12.4.3
+ *      "The runtime MUST track VM memory usage"
+ */
+
+#include "common/Types.h"
+#include <cstddef>
+
+namespace arcanee::script {
+
+/**
+ * @brief Size-class pool allocator owned by a single Squirrel VM.
+ *
+ * Squirrel passes the block size to every free/realloc, so small blocks need
+ * no per-block header: they live in 64 KiB aligned chunks whose header names
+ * the owning arena and size class. Blocks above kMaxSmallSize are served by
+ * malloc with a small header and linked into the arena so they can be
+ * released with it.
+ *
+ * Accounting is exact (bytes requested by the VM). Because Squirrel cannot
+ * recover from a failed allocation, the hard cap does not return null: the
+ * allocation succeeds, the arena latches a fault that ScriptEngine checks
+ * after every entry point, and the hard cap handler interrupts the VM so
+ * the script stops at its next loop or call instead of growing until the
+ * entry point returns. Bindings about to make one large allocation ask
+ * fitsHardCap() first and fail that operation instead.
+ *
+ * Not thread-safe: one arena per VM, used from the VM's thread only.
+ */
+class VmAllocator {
+public:
+  static constexpr size_t kChunkSize = 64 * 1024;
+  static constexpr size_t kGranularity = 16;
+  static constexpr size_t kMaxSmallSize = 512;
+  static constexpr size_t kNumClasses = kMaxSmallSize / kGranularity;
+
+  struct Stats {
+    u64 bytesInUse = 0;    ///< Exact bytes currently requested by the VM
+    u64 peakBytes = 0;     ///< High-water mark of bytesInUse
+    u64 reservedBytes = 0; ///< Chunk + large block footprint from the host
+    u64 allocCount = 0;
+    u64 freeCount = 0;
+  };
+
+  VmAllocator();
+  ~VmAllocator();
+
+  VmAllocator(const VmAllocator &) = delete;
+  VmAllocator &operator=(const VmAllocator &) = delete;
+
+  using HardCapFn = void (*)(void *user);
+
+  /**
+   * @brief Configure memory caps in bytes (0 disables a cap).
+   */
+  void setCaps(u64 softCapBytes, u64 hardCapBytes);
+
+  /**
+   * @brief Called on the allocating thread by every allocation that leaves
+   * the arena over the hard cap (null clears). Must not allocate.
+   */
+  void setHardCapHandler(HardCapFn fn, void *user);
+
+  void *allocate(size_t size);
+  void *reallocate(void *p, size_t oldSize, size_t newSize);
+  void deallocate(void *p, size_t size);
+
+  /**
+   * @brief Return every chunk and large block to the host.
+   *
+   * One pass over the chunk and large-block lists: linear in chunks (64 KiB
+   * each) plus large blocks, not in the VM's live objects, which are never
+   * visited. Only valid once the VM using this arena has been closed.
+   */
+  void releaseAll();
+
+  const Stats &getStats() const { return m_stats; }
+  bool isOverSoftCap() const {
+    return m_softCap != 0 && m_stats.bytesInUse > m_softCap;
+  }
+  bool isOverHardCap() const { return m_hardCapHit; }
+  /// True if @p bytes more stay within the hard cap.
+  bool fitsHardCap(u64 bytes) const {
+    return m_hardCap == 0 || (m_stats.bytesInUse <= m_hardCap &&
+                              bytes <= m_hardCap - m_stats.bytesInUse);
+  }
+  u64 getSoftCap() const { return m_softCap; }
+  u64 getHardCap() const { return m_hardCap; }
+
+  /**
+   * @brief Arena receiving allocations on the calling thread.
+   *
+   * Falls back to a process-wide, uncapped arena when no VM scope is active
+   * (e.g. tests driving the VM directly).
+   */
+  static VmAllocator *current();
+
+  /**
+   * @brief RAII guard routing this thread's VM allocations to an arena.
+   */
+  class Scope {
+  public:
+    explicit Scope(VmAllocator *allocator);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    VmAllocator *m_previous;
+  };
+
+  // Entry points for the sq_vm_* hooks
+  static void *vmMalloc(size_t size);
+  static void *vmRealloc(void *p, size_t oldSize, size_t newSize);
+  static void vmFree(void *p, size_t size);
+
+private:
+  struct ChunkHeader;
+  struct LargeHeader;
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  struct SizeClass {
+    FreeBlock *freeList = nullptr;
+    ChunkHeader *chunks = nullptr; // Newest chunk first; bump from its tail
+    char *bumpPtr = nullptr;
+    char *bumpEnd = nullptr;
+  };
+
+  static size_t classIndex(size_t size);
+  static size_t classSize(size_t index);
+  static VmAllocator *ownerOf(void *p, size_t size);
+
+  void *allocateSmall(size_t index);
+  void freeSmall(void *p, size_t index);
+  void *allocateLarge(size_t size);
+  void freeLarge(void *p);
+  void account(i64 delta);
+
+  SizeClass m_classes[kNumClasses];
+  LargeHeader *m_large = nullptr;
+
+  Stats m_stats;
+  u64 m_softCap = 0;
+  u64 m_hardCap = 0;
+  bool m_hardCapHit = false;
+  HardCapFn m_onHardCap = nullptr;
+  void *m_onHardCapUser = nullptr;
+};
+
+} // namespace arcanee::script
@@ -0,0 +1,1343 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file VmSnapshot.cpp
+ *
+ * Blob layout (all little-endian, counts and ids as varints):
+ *   header   magic, format, Squirrel version, session, baseline signature
+ *   strings  count, then (length, bytes) per string
+ *   code     count, then (length, sq_writeclosurecode bytes) per function
+ *   counts   objects, free variable cells
+ *   objects  one record per object, in id order; 0 is the root table and
+ *            1 the const table
+ *   cells    one value per cell
+ *   roots    count, then (name, value) per named root
+ * A value is a tag byte plus payload; objects refer to each other by id and
+ * to the baseline by position.
+ */
+
+#include "VmSnapshot.h"
+#include "common/ByteStream.h"
+#include <chrono>
+#include <cstring>
+#include <unordered_set>
+#include <xxhash.h>
+
+namespace arcanee::script {
+
+namespace {
+
+constexpr u32 kSnapshotMagic = 0x53435241; // "ARCS"
+constexpr u32 kSnapshotFormat = 1;
+
+constexpr u64 kRootId = 0;
+constexpr u64 kConstId = 1;
+
+enum ValueTag : u8 {
+  kNull,
+  kFalse,
+  kTrue,
+  kInteger,
+  kFloat,
+  kString,
+  kUserPointer,
+  kObject,
+  kExtern,
+  kEnd, // Terminates class member and instance field lists
+};
+
+enum class Kind : u8 {
+  Table,
+  Array,
+  Closure,
+  Class,
+  Instance,
+  Userdata,
+  WeakRef
+};
+
+// Class metamethods live outside the member table and are not iterated
+constexpr const SQChar *kMetaMethods[] = {
+    "_add",   "_sub",     "_mul",    "_div",     "_unm",      "_modulo",
+    "_set",   "_get",     "_typeof", "_nexti",   "_cmp",      "_call",
+    "_cloned", "_newslot", "_delslot", "_tostring", "_newmember",
+    "_inherited"};
+
+bool isReference(SQObjectType type) {
+  switch (type) {
+  case OT_TABLE:
+  case OT_ARRAY:
+  case OT_USERDATA:
+  case OT_CLOSURE:
+  case OT_NATIVECLOSURE:
+  case OT_CLASS:
+  case OT_INSTANCE:
+  case OT_WEAKREF:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Type tags and user pointers are addresses: tie blobs to this process
+u64 sessionId() {
+  static const u64 id =
+      static_cast<u64>(
+          std::chrono::steady_clock::now().time_since_epoch().count()) ^
+      static_cast<u64>(reinterpret_cast<uintptr_t>(&kSnapshotMagic));
+  return id;
+}
+
+SQInteger appendBytes(SQUserPointer user, SQUserPointer src, SQInteger size) {
+  auto *out = static_cast<std::vector<u8> *>(user);
+  const u8 *bytes = static_cast<const u8 *>(src);
+  out->insert(out->end(), bytes, bytes + size);
+  return size;
+}
+
+struct ReadCursor {
+  const u8 *data;
+  size_t size;
+  size_t pos;
+};
+
+SQInteger readBytes(SQUserPointer user, SQUserPointer dest, SQInteger size) {
+  auto *cursor = static_cast<ReadCursor *>(user);
+  size_t n = static_cast<size_t>(size);
+  if (n > cursor->size - cursor->pos) {
+    return -1;
+  }
+  std::memcpy(dest, cursor->data + cursor->pos, n);
+  cursor->pos += n;
+  return size;
+}
+
+Status corrupt() {
+  return Status(StatusCode::DataLoss, "snapshot is corrupt");
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+class SnapshotWriter {
+public:
+  SnapshotWriter(HSQUIRRELVM vm, const SnapshotBaseline &baseline)
+      : m_vm(vm), m_baseline(baseline) {}
+
+  Status run(const SnapshotRoots &roots, std::vector<u8> &out,
+             SnapshotStats &stats) {
+    SQInteger top = sq_gettop(m_vm);
+    Status status = walk(roots);
+    sq_settop(m_vm, top); // Error paths may leave values behind
+    if (!status.ok())
+      return status;
+
+    out.clear();
+    ByteWriter w(out);
+    w.writeU32(kSnapshotMagic);
+    w.writeU32(kSnapshotFormat);
+    w.writeU32(SQUIRREL_VERSION_NUMBER);
+    w.writeU64(sessionId());
+    w.writeU64(m_baseline.signature());
+    w.writeVarint(m_stringIds.size());
+    w.writeBytes(m_stringBytes.data(), m_stringBytes.size());
+    w.writeVarint(m_codeIds.size());
+    w.writeBytes(m_codeBytes.data(), m_codeBytes.size());
+    w.writeVarint(m_queue.size());
+    w.writeVarint(m_cellIds.size());
+    w.writeBytes(m_objectBytes.data(), m_objectBytes.size());
+    w.writeBytes(m_cellBytes.data(), m_cellBytes.size());
+    w.writeBytes(m_rootBytes.data(), m_rootBytes.size());
+
+    stats.objects = m_queue.size();
+    stats.closures = m_closures;
+    stats.strings = m_stringIds.size();
+    stats.bytes = out.size();
+    return Status::Ok();
+  }
+
+private:
+  Status walk(const SnapshotRoots &roots) {
+    HSQOBJECT root, consts;
+    sq_pushroottable(m_vm);
+    sq_getstackobj(m_vm, -1, &root);
+    sq_pushconsttable(m_vm);
+    sq_getstackobj(m_vm, -1, &consts);
+    sq_pop(m_vm, 2);
+    idOf(root);   // kRootId
+    idOf(consts); // kConstId
+
+    m_rootsOut.writeVarint(roots.size());
+    for (const auto &[name, obj] : roots) {
+      sq_pushstring(m_vm, name.c_str(), static_cast<SQInteger>(name.size()));
+      value(m_rootsOut, -1);
+      sq_pushobject(m_vm, obj);
+      value(m_rootsOut, -1);
+      sq_pop(m_vm, 2);
+    }
+
+    // The queue grows while we walk it
+    for (size_t i = 0; i < m_queue.size() && m_error.ok(); ++i) {
+      writeObject(m_queue[i]);
+    }
+    return m_error;
+  }
+
+  void fail(const std::string &what) {
+    if (!m_error.ok())
+      return;
+    std::string msg = "cannot snapshot " + what;
+    if (m_slot) {
+      msg += " (in slot '";
+      msg += m_slot;
+      msg += "')";
+    }
+    m_error = Status(StatusCode::InvalidArgument, msg);
+  }
+
+  u64 idOf(const HSQOBJECT &obj) {
+    auto [it, inserted] = m_ids.try_emplace(obj._unVal.pRefCounted,
+                                            static_cast<u64>(m_queue.size()));
+    if (inserted)
+      m_queue.push_back(obj);
+    return it->second;
+  }
+
+  // Remember a string key so errors can say where a value was found
+  void setSlot(SQInteger keyIdx) {
+    m_slot = nullptr;
+    if (sq_gettype(m_vm, keyIdx) == OT_STRING)
+      sq_getstring(m_vm, keyIdx, &m_slot);
+  }
+
+  void value(ByteWriter &w, SQInteger idx) {
+    HSQOBJECT obj;
+    sq_getstackobj(m_vm, idx, &obj);
+
+    switch (obj._type) {
+    case OT_NULL:
+      w.writeU8(kNull);
+      return;
+    case OT_BOOL: {
+      SQBool b = SQFalse;
+      sq_getbool(m_vm, idx, &b);
+      w.writeU8(b ? kTrue : kFalse);
+      return;
+    }
+    case OT_INTEGER:
+      w.writeU8(kInteger);
+      w.writeSigned(obj._unVal.nInteger);
+      return;
+    case OT_FLOAT:
+      w.writeU8(kFloat);
+      w.writeF64(obj._unVal.fFloat);
+      return;
+    case OT_STRING: {
+      auto [it, inserted] = m_stringIds.try_emplace(
+          obj._unVal.pString, static_cast<u64>(m_stringIds.size()));
+      if (inserted) {
+        const SQChar *s = nullptr;
+        SQInteger len = 0;
+        sq_getstringandsize(m_vm, idx, &s, &len);
+        size_t bytes = static_cast<size_t>(len) * sizeof(SQChar);
+        m_stringsOut.writeVarint(bytes);
+        m_stringsOut.writeBytes(s, bytes);
+      }
+      w.writeU8(kString);
+      w.writeVarint(it->second);
+      return;
+    }
+    case OT_USERPOINTER:
+      w.writeU8(kUserPointer);
+      w.writeU64(reinterpret_cast<uintptr_t>(obj._unVal.pUserPointer));
+      return;
+    default:
+      break;
+    }
+
+    if (!isReference(obj._type)) {
+      fail(obj._type == OT_GENERATOR ? "a generator"
+           : obj._type == OT_THREAD  ? "a thread"
+                                     : "an internal VM object");
+      return;
+    }
+
+    i64 ext = m_baseline.find(obj);
+    if (ext >= 0) {
+      w.writeU8(kExtern);
+      w.writeVarint(static_cast<u64>(ext));
+      return;
+    }
+
+    if (obj._type == OT_NATIVECLOSURE) {
+      std::string name = "<anonymous>";
+      if (SQ_SUCCEEDED(sq_getclosurename(m_vm, idx))) {
+        const SQChar *s = nullptr;
+        if (SQ_SUCCEEDED(sq_getstring(m_vm, -1, &s)))
+          name = s;
+        sq_pop(m_vm, 1);
+      }
+      fail("native function '" + name + "' created after startup");
+      return;
+    }
+
+    w.writeU8(kObject);
+    w.writeVarint(idOf(obj));
+  }
+
+  void writeObject(const HSQOBJECT &obj) {
+    sq_pushobject(m_vm, obj);
+    switch (obj._type) {
+    case OT_TABLE:
+      writeTable();
+      break;
+    case OT_ARRAY:
+      writeArray();
+      break;
+    case OT_CLOSURE:
+      writeClosure();
+      break;
+    case OT_CLASS:
+      writeClass();
+      break;
+    case OT_INSTANCE:
+      writeInstance();
+      break;
+    case OT_USERDATA:
+      writeUserdata();
+      break;
+    default: // OT_WEAKREF
+      m_objectsOut.writeU8(static_cast<u8>(Kind::WeakRef));
+      sq_getweakrefval(m_vm, -1);
+      value(m_objectsOut, -1);
+      sq_pop(m_vm, 1);
+      break;
+    }
+    sq_pop(m_vm, 1);
+    m_slot = nullptr;
+  }
+
+  // Each writer below has its object on top of the stack
+  void writeTable() {
+    ByteWriter &w = m_objectsOut;
+    w.writeU8(static_cast<u8>(Kind::Table));
+    sq_getdelegate(m_vm, -1);
+    value(w, -1);
+    sq_pop(m_vm, 1);
+
+    w.writeVarint(static_cast<u64>(sq_getsize(m_vm, -1)));
+    sq_pushnull(m_vm); // iterator
+    while (SQ_SUCCEEDED(sq_next(m_vm, -2))) {
+      setSlot(-2);
+      value(w, -2);
+      value(w, -1);
+      sq_pop(m_vm, 2);
+    }
+    sq_pop(m_vm, 1);
+  }
+
+  void writeArray() {
+    ByteWriter &w = m_objectsOut;
+    w.writeU8(static_cast<u8>(Kind::Array));
+    w.writeVarint(static_cast<u64>(sq_getsize(m_vm, -1)));
+    sq_pushnull(m_vm);
+    while (SQ_SUCCEEDED(sq_next(m_vm, -2))) {
+      value(w, -1);
+      sq_pop(m_vm, 2);
+    }
+    sq_pop(m_vm, 1);
+  }
+
+  void writeClosure() {
+    ByteWriter &w = m_objectsOut;
+    w.writeU8(static_cast<u8>(Kind::Closure));
+    m_closures++;
+
+    auto [code, inserted] = m_codeIds.try_emplace(
+        sq_getclosurecode(m_vm, -1), static_cast<u64>(m_codeIds.size()));
+    if (inserted) {
+      std::vector<u8> blob;
+      if (SQ_FAILED(sq_writeclosurecode(m_vm, -1, appendBytes, &blob))) {
+        fail("function code");
+        return;
+      }
+      m_codesOut.writeVarint(blob.size());
+      m_codesOut.writeBytes(blob.data(), blob.size());
+    }
+    w.writeVarint(code->second);
+
+    SQInteger nparams = 0, nfree = 0;
+    sq_getclosureinfo(m_vm, -1, &nparams, &nfree);
+    w.writeVarint(static_cast<u64>(nfree));
+    for (SQInteger i = 0; i < nfree; ++i) {
+      auto n = static_cast<SQUnsignedInteger>(i);
+      SQUserPointer cell = sq_getfreevariablecell(m_vm, -1, n);
+      if (!cell) {
+        fail("a closure of a running function");
+        return;
+      }
+      auto [it, fresh] =
+          m_cellIds.try_emplace(cell, static_cast<u64>(m_cellIds.size()));
+      if (fresh) {
+        sq_getfreevariable(m_vm, -1, n);
+        value(m_cellsOut, -1);
+        sq_pop(m_vm, 1);
+      }
+      w.writeVarint(it->second);
+    }
+
+    SQInteger ndefaults = sq_getdefaultparamcount(m_vm, -1);
+    w.writeVarint(static_cast<u64>(ndefaults));
+    for (SQInteger i = 0; i < ndefaults; ++i) {
+      sq_getdefaultparam(m_vm, -1, static_cast<SQUnsignedInteger>(i));
+      value(w, -1);
+      sq_pop(m_vm, 1);
+    }
+  }
+
+  void writeClass() {
+    ByteWriter &w = m_objectsOut;
+    w.writeU8(static_cast<u8>(Kind::Class));
+    sq_getbase(m_vm, -1);
+    value(w, -1);
+    sq_pop(m_vm, 1);
+
+    sq_pushnull(m_vm);
+    if (SQ_SUCCEEDED(sq_getattributes(m_vm, -2))) {
+      value(w, -1);
+    } else {
+      w.writeU8(kNull);
+    }
+    sq_pop(m_vm, 1);
+
+    // Members: key, static flag, value, attributes
+    sq_pushnull(m_vm); // iterator
+    while (SQ_SUCCEEDED(sq_next(m_vm, -2))) {
+      // [class, iter, key, value]
+      setSlot(-2);
+      value(w, -2);
+      HSQMEMBERHANDLE handle{};
+      sq_push(m_vm, -2);
+      if (SQ_FAILED(sq_getmemberhandle(m_vm, -5, &handle)))
+        sq_pop(m_vm, 1);
+      w.writeU8(handle._static ? 1 : 0);
+      value(w, -1);
+      sq_push(m_vm, -2);
+      if (SQ_SUCCEEDED(sq_getattributes(m_vm, -5))) {
+        value(w, -1);
+      } else {
+        w.writeU8(kNull);
+      }
+      sq_pop(m_vm, 3);
+    }
+    sq_pop(m_vm, 1);
+
+    for (const SQChar *name : kMetaMethods) {
+      if (SQ_FAILED(sq_getclassmetamethod(m_vm, -1, name)))
+        continue;
+      if (sq_gettype(m_vm, -1) != OT_NULL) {
+        m_slot = name;
+        sq_pushstring(m_vm, name, -1);
+        value(w, -1);
+        sq_pop(m_vm, 1);
+        w.writeU8(1);
+        value(w, -1);
+        w.writeU8(kNull);
+      }
+      sq_pop(m_vm, 1);
+    }
+    w.writeU8(kEnd);
+  }
+
+  void writeInstance() {
+    ByteWriter &w = m_objectsOut;
+    SQUserPointer up = nullptr;
+    sq_getinstanceup(m_vm, -1, &up, nullptr, SQFalse);
+    if (up) {
+      fail("an instance of a native class");
+      return;
+    }
+    w.writeU8(static_cast<u8>(Kind::Instance));
+
+    sq_getclass(m_vm, -1);
+    value(w, -1);
+
+    // Fields are the non-static members of the class
+    sq_pushnull(m_vm);
+    while (SQ_SUCCEEDED(sq_next(m_vm, -2))) {
+      // [instance, class, iter, key, value]
+      HSQMEMBERHANDLE handle{};
+      sq_push(m_vm, -2);
+      if (SQ_FAILED(sq_getmemberhandle(m_vm, -5, &handle))) {
+        sq_pop(m_vm, 1);
+        handle._static = SQTrue;
+      }
+      if (!handle._static) {
+        setSlot(-2);
+        value(w, -2);
+        sq_push(m_vm, -2);
+        if (SQ_SUCCEEDED(sq_rawget(m_vm, -6))) {
+          value(w, -1);
+          sq_pop(m_vm, 1);
+        } else {
+          w.writeU8(kNull);
+        }
+      }
+      sq_pop(m_vm, 2);
+    }
+    sq_pop(m_vm, 2); // iterator, class
+    w.writeU8(kEnd);
+  }
+
+  void writeUserdata() {
+    if (sq_getreleasehook(m_vm, -1)) {
+      fail("userdata that owns native resources");
+      return;
+    }
+    ByteWriter &w = m_objectsOut;
+    w.writeU8(static_cast<u8>(Kind::Userdata));
+
+    SQUserPointer tag = nullptr;
+    sq_gettypetag(m_vm, -1, &tag);
+    w.writeU64(reinterpret_cast<uintptr_t>(tag));
+    sq_getdelegate(m_vm, -1);
+    value(w, -1);
+    sq_pop(m_vm, 1);
+
+    SQUserPointer p = nullptr;
+    sq_getuserdata(m_vm, -1, &p, nullptr);
+    auto size = static_cast<size_t>(sq_getsize(m_vm, -1));
+    w.writeVarint(size);
+    w.writeBytes(p, size);
+  }
+
+  HSQUIRRELVM m_vm;
+  const SnapshotBaseline &m_baseline;
+  Status m_error;
+  const SQChar *m_slot = nullptr;
+  u64 m_closures = 0;
+
+  std::unordered_map<const void *, u64> m_ids;
+  std::vector<HSQOBJECT> m_queue;
+  std::unordered_map<const void *, u64> m_stringIds;
+  std::unordered_map<const void *, u64> m_codeIds;
+  std::unordered_map<const void *, u64> m_cellIds;
+
+  std::vector<u8> m_stringBytes, m_codeBytes, m_objectBytes, m_cellBytes,
+      m_rootBytes;
+  ByteWriter m_stringsOut{m_stringBytes};
+  ByteWriter m_codesOut{m_codeBytes};
+  ByteWriter m_objectsOut{m_objectBytes};
+  ByteWriter m_cellsOut{m_cellBytes};
+  ByteWriter m_rootsOut{m_rootBytes};
+};
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+struct Value {
+  u8 tag = kNull;
+  u64 data = 0;
+};
+
+struct Record {
+  Kind kind = Kind::Table;
+  size_t first = 0; // Range in m_values, layout depends on kind
+  size_t count = 0;
+  size_t cellFirst = 0; // Closure: range in m_cellRefs
+  size_t cellCount = 0;
+  u64 aux = 0;                // Closure: code id; userdata: type tag
+  const u8 *bytes = nullptr;  // Userdata payload
+  size_t size = 0;
+};
+
+// Values per class member: key, static flag, value, attributes
+constexpr size_t kMemberValues = 4;
+
+class SnapshotReader {
+public:
+  SnapshotReader(HSQUIRRELVM vm, const SnapshotBaseline &baseline)
+      : m_vm(vm), m_baseline(baseline) {}
+
+  ~SnapshotReader() {
+    for (auto &obj : m_strings)
+      sq_release(m_vm, &obj);
+    for (auto &obj : m_codes)
+      sq_release(m_vm, &obj);
+    for (auto &obj : m_objects)
+      sq_release(m_vm, &obj);
+  }
+
+  SnapshotReader(const SnapshotReader &) = delete;
+  SnapshotReader &operator=(const SnapshotReader &) = delete;
+
+  Status run(const u8 *data, size_t size, SnapshotRoots &roots,
+             SnapshotStats &stats) {
+    SQInteger top = sq_gettop(m_vm);
+    Status status = build(data, size, roots);
+    sq_settop(m_vm, top); // Error paths may leave values behind
+    if (!status.ok())
+      return status;
+
+    stats.objects = m_records.size();
+    stats.closures = m_closures;
+    stats.strings = m_strings.size();
+    stats.bytes = size;
+    return Status::Ok();
+  }
+
+private:
+  Status build(const u8 *data, size_t size, SnapshotRoots &roots) {
+    ARC_RETURN_IF_ERROR(parse(data, size));
+    ARC_RETURN_IF_ERROR(createShells());
+    ARC_RETURN_IF_ERROR(bindClosures());
+    for (size_t id = 0; id < m_records.size(); ++id) {
+      if (m_records[id].kind == Kind::Class)
+        ARC_RETURN_IF_ERROR(createClass(id));
+    }
+    ARC_RETURN_IF_ERROR(createInstances());
+    ARC_RETURN_IF_ERROR(fill());
+
+    for (size_t i = 0; i < m_rootValues.size(); i += 2) {
+      HSQOBJECT obj;
+      push(m_rootValues[i]);
+      push(m_rootValues[i + 1]);
+      sq_getstackobj(m_vm, -1, &obj);
+      sq_addref(m_vm, &obj);
+      const SQChar *s = nullptr;
+      SQInteger len = 0;
+      sq_getstringandsize(m_vm, -2, &s, &len);
+      roots.emplace_back(std::string(s, static_cast<size_t>(len)), obj);
+      sq_pop(m_vm, 2);
+    }
+    return Status::Ok();
+  }
+
+  // -------------------------------------------------------------- parsing
+
+  bool readValue(ByteReader &r, u8 tag, Value &out) {
+    out.tag = tag;
+    out.data = 0;
+    switch (tag) {
+    case kNull:
+    case kFalse:
+    case kTrue:
+      return true;
+    case kInteger:
+      out.data = static_cast<u64>(r.readSigned());
+      return true;
+    case kFloat:
+    case kUserPointer:
+      out.data = r.readU64();
+      return true;
+    case kString:
+      out.data = r.readVarint();
+      return out.data < m_strings.size();
+    case kObject:
+      out.data = r.readVarint();
+      return out.data < m_records.size();
+    case kExtern:
+      out.data = r.readVarint();
+      return out.data < m_baseline.size();
+    default:
+      return false;
+    }
+  }
+
+  bool readValue(ByteReader &r, Value &out) {
+    return readValue(r, r.readU8(), out);
+  }
+
+  bool appendValue(ByteReader &r) {
+    Value v;
+    if (!readValue(r, v))
+      return false;
+    m_values.push_back(v);
+    return true;
+  }
+
+  Status parse(const u8 *data, size_t size) {
+    ByteReader r(data, size);
+    if (r.readU32() != kSnapshotMagic || r.readU32() != kSnapshotFormat ||
+        r.readU32() != SQUIRREL_VERSION_NUMBER) {
+      return Status(StatusCode::InvalidArgument, "not a VM snapshot");
+    }
+    if (r.readU64() != sessionId()) {
+      return Status(StatusCode::FailedPrecondition,
+                    "snapshot was taken by another process");
+    }
+    if (r.readU64() != m_baseline.signature()) {
+      return Status(StatusCode::FailedPrecondition,
+                    "snapshot was taken with a different script API");
+    }
+
+    // Every count is checked against the bytes left before allocating
+    u64 nstrings = r.readVarint();
+    if (nstrings > r.remaining())
+      return corrupt();
+    m_strings.reserve(nstrings);
+    for (u64 i = 0; i < nstrings; ++i) {
+      u64 len = r.readVarint();
+      const u8 *s = r.readBytes(len);
+      if (!s)
+        return corrupt();
+      HSQOBJECT obj;
+      sq_pushstring(m_vm, reinterpret_cast<const SQChar *>(s),
+                    static_cast<SQInteger>(len / sizeof(SQChar)));
+      sq_getstackobj(m_vm, -1, &obj);
+      sq_addref(m_vm, &obj);
+      sq_pop(m_vm, 1);
+      m_strings.push_back(obj);
+    }
+
+    u64 ncodes = r.readVarint();
+    if (ncodes > r.remaining())
+      return corrupt();
+    for (u64 i = 0; i < ncodes; ++i) {
+      u64 len = r.readVarint();
+      const u8 *code = r.readBytes(len);
+      if (!code)
+        return corrupt();
+      ReadCursor cursor{code, static_cast<size_t>(len), 0};
+      if (SQ_FAILED(sq_readclosure(m_vm, readBytes, &cursor)))
+        return corrupt();
+      HSQOBJECT obj;
+      sq_getstackobj(m_vm, -1, &obj);
+      sq_addref(m_vm, &obj);
+      sq_pop(m_vm, 1);
+      m_codes.push_back(obj);
+    }
+    m_codeUsed.assign(m_codes.size(), false);
+
+    u64 nobjects = r.readVarint();
+    u64 ncells = r.readVarint();
+    if (nobjects < 2 || nobjects > r.remaining() || ncells > r.remaining())
+      return corrupt();
+    m_records.resize(nobjects);
+    for (auto &rec : m_records) {
+      if (!parseRecord(r, rec, ncells))
+        return corrupt();
+    }
+    if (m_records[kRootId].kind != Kind::Table ||
+        m_records[kConstId].kind != Kind::Table) {
+      return corrupt();
+    }
+
+    m_cells.resize(ncells);
+    for (auto &cell : m_cells) {
+      if (!readValue(r, cell.value))
+        return corrupt();
+    }
+
+    u64 nroots = r.readVarint();
+    if (nroots > r.remaining())
+      return corrupt();
+    m_rootValues.resize(nroots * 2);
+    for (u64 i = 0; i < nroots; ++i) {
+      if (!readValue(r, m_rootValues[i * 2]) ||
+          m_rootValues[i * 2].tag != kString ||
+          !readValue(r, m_rootValues[i * 2 + 1])) {
+        return corrupt();
+      }
+    }
+
+    if (!r.ok() || r.remaining() != 0)
+      return corrupt();
+
+    m_objects.resize(nobjects);
+    for (auto &obj : m_objects)
+      sq_resetobject(&obj);
+    m_classState.assign(nobjects, 0);
+    return Status::Ok();
+  }
+
+  bool parseRecord(ByteReader &r, Record &rec, u64 ncells) {
+    rec.kind = static_cast<Kind>(r.readU8());
+    rec.first = m_values.size();
+
+    switch (rec.kind) {
+    case Kind::Table: {
+      if (!appendValue(r)) // delegate
+        return false;
+      u64 n = r.readVarint();
+      if (n > r.remaining())
+        return false;
+      for (u64 i = 0; i < n * 2; ++i) {
+        if (!appendValue(r))
+          return false;
+      }
+      break;
+    }
+    case Kind::Array: {
+      u64 n = r.readVarint();
+      if (n > r.remaining())
+        return false;
+      for (u64 i = 0; i < n; ++i) {
+        if (!appendValue(r))
+          return false;
+      }
+      break;
+    }
+    case Kind::Closure: {
+      rec.aux = r.readVarint();
+      if (rec.aux >= m_codes.size())
+        return false;
+      u64 ncellRefs = r.readVarint();
+      if (ncellRefs > r.remaining())
+        return false;
+      rec.cellFirst = m_cellRefs.size();
+      rec.cellCount = ncellRefs;
+      for (u64 i = 0; i < ncellRefs; ++i) {
+        u64 cell = r.readVarint();
+        if (cell >= ncells)
+          return false;
+        m_cellRefs.push_back(cell);
+      }
+      u64 ndefaults = r.readVarint();
+      if (ndefaults > r.remaining())
+        return false;
+      for (u64 i = 0; i < ndefaults; ++i) {
+        if (!appendValue(r))
+          return false;
+      }
+      break;
+    }
+    case Kind::Class: {
+      if (!appendValue(r) || !appendValue(r)) // base, attributes
+        return false;
+      for (;;) {
+        u8 tag = r.readU8();
+        if (tag == kEnd)
+          break;
+        Value key, flag, val, attrs;
+        if (!readValue(r, tag, key))
+          return false;
+        flag.tag = r.readU8() ? kTrue : kFalse;
+        if (!readValue(r, val) || !readValue(r, attrs))
+          return false;
+        m_values.insert(m_values.end(), {key, flag, val, attrs});
+      }
+      break;
+    }
+    case Kind::Instance: {
+      if (!appendValue(r)) // class
+        return false;
+      for (;;) {
+        u8 tag = r.readU8();
+        if (tag == kEnd)
+          break;
+        Value key;
+        if (!readValue(r, tag, key) || !appendValue(r))
+          return false;
+        m_values.insert(m_values.end() - 1, key);
+      }
+      break;
+    }
+    case Kind::Userdata: {
+      rec.aux = r.readU64();
+      if (!appendValue(r)) // delegate
+        return false;
+      rec.size = r.readVarint();
+      rec.bytes = r.readBytes(rec.size);
+      if (!rec.bytes)
+        return false;
+      break;
+    }
+    case Kind::WeakRef:
+      if (!appendValue(r))
+        return false;
+      break;
+    default:
+      return false;
+    }
+
+    rec.count = m_values.size() - rec.first;
+    return r.ok();
+  }
+
+  // ------------------------------------------------------------- building
+
+  bool ready(const Value &v) const {
+    return v.tag != kObject || !sq_isnull(m_objects[v.data]);
+  }
+
+  // Objects not built yet push null; callers check ready() first
+  void push(const Value &v) {
+    switch (v.tag) {
+    case kFalse:
+    case kTrue:
+      sq_pushbool(m_vm, v.tag == kTrue ? SQTrue : SQFalse);
+      break;
+    case kInteger:
+      sq_pushinteger(m_vm, static_cast<SQInteger>(static_cast<i64>(v.data)));
+      break;
+    case kFloat: {
+      f64 d;
+      std::memcpy(&d, &v.data, sizeof(d));
+      sq_pushfloat(m_vm, static_cast<SQFloat>(d));
+      break;
+    }
+    case kString:
+      sq_pushobject(m_vm, m_strings[v.data]);
+      break;
+    case kUserPointer:
+      sq_pushuserpointer(m_vm,
+                         reinterpret_cast<SQUserPointer>(
+                             static_cast<uintptr_t>(v.data)));
+      break;
+    case kObject:
+      sq_pushobject(m_vm, m_objects[v.data]);
+      break;
+    case kExtern:
+      sq_pushobject(m_vm, m_baseline.at(v.data));
+      break;
+    default:
+      sq_pushnull(m_vm);
+      break;
+    }
+  }
+
+  // Takes the object on top of the stack as object @p id
+  void hold(size_t id) {
+    sq_getstackobj(m_vm, -1, &m_objects[id]);
+    sq_addref(m_vm, &m_objects[id]);
+    sq_pop(m_vm, 1);
+  }
+
+  Kind kindOf(const Value &v) const { return m_records[v.data].kind; }
+
+  // Tables, arrays, closures and userdata: everything classes may refer to
+  Status createShells() {
+    for (size_t id = 0; id < m_records.size(); ++id) {
+      const Record &rec = m_records[id];
+      switch (rec.kind) {
+      case Kind::Table:
+        if (id == kRootId)
+          sq_pushroottable(m_vm);
+        else if (id == kConstId)
+          sq_pushconsttable(m_vm);
+        else
+          sq_newtableex(m_vm, static_cast<SQInteger>((rec.count - 1) / 2));
+        break;
+      case Kind::Array:
+        sq_newarray(m_vm, static_cast<SQInteger>(rec.count));
+        break;
+      case Kind::Closure:
+        sq_pushobject(m_vm, m_codes[rec.aux]);
+        if (m_codeUsed[rec.aux]) {
+          sq_newclosurelike(m_vm, -1);
+          sq_remove(m_vm, -2);
+        }
+        m_codeUsed[rec.aux] = true;
+        m_closures++;
+        break;
+      case Kind::Userdata: {
+        void *p =
+            sq_newuserdata(m_vm, static_cast<SQUnsignedInteger>(rec.size));
+        std::memcpy(p, rec.bytes, rec.size);
+        sq_settypetag(m_vm, -1,
+                      reinterpret_cast<SQUserPointer>(
+                          static_cast<uintptr_t>(rec.aux)));
+        break;
+      }
+      default:
+        continue; // Classes, instances and weak refs come later
+      }
+      hold(id);
+    }
+    return Status::Ok();
+  }
+
+  // Captured variables and default parameters. Values that are not built
+  // yet (classes, instances) are patched in by fill().
+  Status bindClosures() {
+    for (size_t id = 0; id < m_records.size(); ++id) {
+      const Record &rec = m_records[id];
+      if (rec.kind != Kind::Closure)
+        continue;
+
+      sq_pushobject(m_vm, m_objects[id]);
+      for (size_t i = 0; i < rec.cellCount; ++i) {
+        auto n = static_cast<SQUnsignedInteger>(i);
+        Cell &cell = m_cells[m_cellRefs[rec.cellFirst + i]];
+        SQRESULT res;
+        if (cell.owner < 0) {
+          // First closure to capture the cell creates it
+          push(cell.value);
+          res = sq_newfreevariablecell(m_vm, -2, n);
+          cell.owner = static_cast<i64>(id);
+          cell.ownerSlot = n;
+        } else {
+          sq_pushobject(m_vm, m_objects[cell.owner]);
+          res = sq_sharefreevariablecell(m_vm, -2, n, -1, cell.ownerSlot);
+          sq_pop(m_vm, 1);
+        }
+        if (SQ_FAILED(res))
+          return corrupt();
+      }
+
+      for (size_t i = 0; i < rec.count; ++i) {
+        const Value &v = m_values[rec.first + i];
+        push(v);
+        if (!ready(v))
+          m_lateDefaults.push_back({id, i});
+        if (SQ_FAILED(sq_setdefaultparam(
+                m_vm, -2, static_cast<SQUnsignedInteger>(i)))) {
+          return corrupt();
+        }
+      }
+      sq_pop(m_vm, 1);
+    }
+    return Status::Ok();
+  }
+
+  Status createClass(size_t id) {
+    if (m_classState[id] == 2)
+      return Status::Ok();
+    if (m_classState[id] == 1)
+      return corrupt(); // Class inherits from itself
+    m_classState[id] = 1;
+
+    const Record &rec = m_records[id];
+    const Value &base = m_values[rec.first];
+    if (base.tag == kObject) {
+      if (kindOf(base) != Kind::Class)
+        return corrupt();
+      ARC_RETURN_IF_ERROR(createClass(base.data));
+    }
+
+    // Build classes used as member values first; a cycle between two
+    // classes is closed later by fill()
+    for (size_t i = 2; i < rec.count; i += kMemberValues) {
+      const Value &v = m_values[rec.first + i + 2];
+      if (v.tag == kObject && kindOf(v) == Kind::Class &&
+          m_classState[v.data] == 0) {
+        ARC_RETURN_IF_ERROR(createClass(v.data));
+      }
+    }
+
+    bool hasBase = base.tag != kNull;
+    if (hasBase)
+      push(base);
+    if (SQ_FAILED(sq_newclass(m_vm, hasBase ? SQTrue : SQFalse)))
+      return corrupt();
+
+    for (size_t i = 2; i < rec.count; i += kMemberValues) {
+      const Value *m = &m_values[rec.first + i];
+      push(m[0]);
+      push(m[2]);
+      if (!ready(m[2]))
+        m_lateMembers.push_back({id, i});
+      if (SQ_FAILED(sq_newslot(m_vm, -3, m[1].tag == kTrue)))
+        return corrupt();
+    }
+    hold(id);
+    m_classState[id] = 2;
+    return Status::Ok();
+  }
+
+  Status createInstances() {
+    for (size_t id = 0; id < m_records.size(); ++id) {
+      const Record &rec = m_records[id];
+      if (rec.kind != Kind::Instance)
+        continue;
+      const Value &cls = m_values[rec.first];
+      push(cls);
+      if (sq_gettype(m_vm, -1) != OT_CLASS ||
+          SQ_FAILED(sq_createinstance(m_vm, -1))) {
+        return corrupt();
+      }
+      sq_remove(m_vm, -2);
+      hold(id);
+    }
+
+    // Weak refs last: they may point at anything built so far
+    for (size_t id = 0; id < m_records.size(); ++id) {
+      const Record &rec = m_records[id];
+      if (rec.kind != Kind::WeakRef)
+        continue;
+      push(m_values[rec.first]);
+      sq_weakref(m_vm, -1);
+      sq_remove(m_vm, -2);
+      hold(id);
+    }
+    return Status::Ok();
+  }
+
+  Status fill() {
+    for (size_t id = 0; id < m_records.size(); ++id) {
+      const Record &rec = m_records[id];
+      const Value *v = &m_values[rec.first];
+      bool ok = true;
+
+      sq_pushobject(m_vm, m_objects[id]);
+      switch (rec.kind) {
+      case Kind::Table:
+        for (size_t i = 1; ok && i < rec.count; i += 2) {
+          push(v[i]);
+          push(v[i + 1]);
+          ok = SQ_SUCCEEDED(sq_rawset(m_vm, -3));
+        }
+        // After the entries, so a _newslot metamethod never sees them
+        if (ok && v[0].tag != kNull) {
+          push(v[0]);
+          ok = SQ_SUCCEEDED(sq_setdelegate(m_vm, -2));
+        }
+        break;
+      case Kind::Array:
+        for (size_t i = 0; ok && i < rec.count; ++i) {
+          sq_pushinteger(m_vm, static_cast<SQInteger>(i));
+          push(v[i]);
+          ok = SQ_SUCCEEDED(sq_set(m_vm, -3));
+        }
+        break;
+      case Kind::Instance:
+        for (size_t i = 1; ok && i < rec.count; i += 2) {
+          push(v[i]);
+          push(v[i + 1]);
+          ok = SQ_SUCCEEDED(sq_set(m_vm, -3));
+        }
+        break;
+      case Kind::Userdata:
+        if (v[0].tag != kNull) {
+          push(v[0]);
+          ok = SQ_SUCCEEDED(sq_setdelegate(m_vm, -2));
+        }
+        break;
+      case Kind::Class:
+        ok = setAttributes(rec);
+        break;
+      default:
+        break;
+      }
+      sq_pop(m_vm, 1);
+      if (!ok)
+        return corrupt();
+    }
+
+    // Statics can still be set once the class has instances; a field whose
+    // default is an instance keeps null (sq_newslot ignores the refusal)
+    for (const auto &[id, i] : m_lateMembers) {
+      const Value *m = &m_values[m_records[id].first + i];
+      sq_pushobject(m_vm, m_objects[id]);
+      push(m[0]);
+      push(m[2]);
+      sq_newslot(m_vm, -3, m[1].tag == kTrue);
+      sq_pop(m_vm, 1);
+    }
+
+    // Cells bound to null in bindClosures() because the value came later
+    for (const Cell &cell : m_cells) {
+      if (cell.owner < 0 || cell.value.tag != kObject)
+        continue;
+      Kind kind = kindOf(cell.value);
+      if (kind != Kind::Class && kind != Kind::Instance &&
+          kind != Kind::WeakRef) {
+        continue;
+      }
+      sq_pushobject(m_vm, m_objects[cell.owner]);
+      push(cell.value);
+      sq_setfreevariable(m_vm, -2, cell.ownerSlot);
+      sq_pop(m_vm, 1);
+    }
+
+    for (const auto &[id, i] : m_lateDefaults) {
+      sq_pushobject(m_vm, m_objects[id]);
+      push(m_values[m_records[id].first + i]);
+      sq_setdefaultparam(m_vm, -2, static_cast<SQUnsignedInteger>(i));
+      sq_pop(m_vm, 1);
+    }
+    return Status::Ok();
+  }
+
+  // Class on top of the stack
+  bool setAttributes(const Record &rec) {
+    const Value *v = &m_values[rec.first];
+    auto set = [&](const Value *key, const Value &attrs) {
+      if (attrs.tag == kNull)
+        return true;
+      if (key)
+        push(*key);
+      else
+        sq_pushnull(m_vm);
+      push(attrs);
+      if (SQ_FAILED(sq_setattributes(m_vm, -3))) {
+        sq_pop(m_vm, 2);
+        return false;
+      }
+      sq_pop(m_vm, 1); // previous attributes
+      return true;
+    };
+
+    if (!set(nullptr, v[1]))
+      return false;
+    for (size_t i = 2; i < rec.count; i += kMemberValues) {
+      if (!set(&v[i], v[i + 3]))
+        return false;
+    }
+    return true;
+  }
+
+  struct Cell {
+    Value value;
+    i64 owner = -1; // Closure that holds the cell
+    SQUnsignedInteger ownerSlot = 0;
+  };
+
+  struct Late {
+    size_t id;
+    size_t index;
+  };
+
+  HSQUIRRELVM m_vm;
+  const SnapshotBaseline &m_baseline;
+  u64 m_closures = 0;
+
+  std::vector<HSQOBJECT> m_strings;
+  std::vector<HSQOBJECT> m_codes;
+  std::vector<bool> m_codeUsed;
+  std::vector<Record> m_records;
+  std::vector<Value> m_values;
+  std::vector<u64> m_cellRefs;
+  std::vector<Cell> m_cells;
+  std::vector<Value> m_rootValues; // name, value pairs
+  std::vector<HSQOBJECT> m_objects;
+  std::vector<u8> m_classState; // 0 pending, 1 building, 2 built
+  std::vector<Late> m_lateMembers;
+  std::vector<Late> m_lateDefaults;
+};
+
+} // namespace
+
+// ============================================================================
+// Baseline
+// ============================================================================
+
+void SnapshotBaseline::capture(HSQUIRRELVM vm) {
+  release(vm);
+
+  HSQOBJECT root, consts, registry;
+  sq_pushroottable(vm);
+  sq_getstackobj(vm, -1, &root);
+  sq_pushconsttable(vm);
+  sq_getstackobj(vm, -1, &consts);
+  sq_pushregistrytable(vm);
+  sq_getstackobj(vm, -1, &registry);
+  sq_pop(vm, 3);
+
+  // Root and const tables are walked but snapshotted by content
+  std::unordered_set<const void *> seen{root._unVal.pRefCounted,
+                                        consts._unVal.pRefCounted};
+  std::vector<HSQOBJECT> queue{root, consts};
+  std::vector<u32> types;
+
+  auto visit = [&](SQInteger idx) {
+    HSQOBJECT obj;
+    sq_getstackobj(vm, idx, &obj);
+    if (!isReference(obj._type) ||
+        !seen.insert(obj._unVal.pRefCounted).second) {
+      return;
+    }
+    queue.push_back(obj);
+    m_index.emplace(obj._unVal.pRefCounted, static_cast<u32>(size()));
+    m_objects.push_back(obj);
+    sq_addref(vm, &m_objects.back());
+    types.push_back(static_cast<u32>(obj._type));
+  };
+
+  sq_pushobject(vm, registry);
+  visit(-1);
+  sq_pop(vm, 1);
+
+  for (size_t i = 0; i < queue.size(); ++i) {
+    sq_pushobject(vm, queue[i]);
+    SQObjectType type = queue[i]._type;
+    if (type == OT_TABLE || type == OT_USERDATA) {
+      sq_getdelegate(vm, -1);
+      visit(-1);
+      sq_pop(vm, 1);
+    }
+    if (type == OT_TABLE || type == OT_ARRAY || type == OT_CLASS) {
+      sq_pushnull(vm);
+      while (SQ_SUCCEEDED(sq_next(vm, -2))) {
+        // Entries under reference keys iterate in address order
+        if (!isReference(sq_gettype(vm, -2)))
+          visit(-1);
+        sq_pop(vm, 2);
+      }
+      sq_pop(vm, 1);
+    }
+    sq_pop(vm, 1);
+  }
+
+  m_signature =
+      XXH64(types.data(), types.size() * sizeof(u32), m_objects.size());
+}
+
+void SnapshotBaseline::release(HSQUIRRELVM vm) {
+  for (auto &obj : m_objects)
+    sq_release(vm, &obj);
+  m_objects.clear();
+  m_index.clear();
+  m_signature = 0;
+}
+
+i64 SnapshotBaseline::find(const HSQOBJECT &obj) const {
+  if (!isReference(obj._type))
+    return -1;
+  auto it = m_index.find(obj._unVal.pRefCounted);
+  return it == m_index.end() ? -1 : static_cast<i64>(it->second);
+}
+
+// ============================================================================
+// Entry points
+// ============================================================================
+
+Status saveVmSnapshot(HSQUIRRELVM vm, const SnapshotBaseline &baseline,
+                      const SnapshotRoots &roots, std::vector<u8> &out,
+                      SnapshotStats *stats) {
+  auto start = std::chrono::steady_clock::now();
+  SnapshotStats local;
+  Status status = SnapshotWriter(vm, baseline).run(roots, out, local);
+  local.seconds =
+      std::chrono::duration<f64>(std::chrono::steady_clock::now() - start)
+          .count();
+  if (stats)
+    *stats = local;
+  return status;
+}
+
+Status loadVmSnapshot(HSQUIRRELVM vm, const SnapshotBaseline &baseline,
+                      const u8 *data, size_t size, SnapshotRoots &roots,
+                      SnapshotStats *stats) {
+  auto start = std::chrono::steady_clock::now();
+  SnapshotStats local;
+  SnapshotRoots loaded;
+  Status status;
+  {
+    SnapshotReader reader(vm, baseline);
+    status = reader.run(data, size, loaded, local);
+  }
+  if (!status.ok()) {
+    for (auto &[name, obj] : loaded)
+      sq_release(vm, &obj);
+    return status;
+  }
+  roots.insert(roots.end(), loaded.begin(), loaded.end());
+  local.seconds =
+      std::chrono::duration<f64>(std::chrono::steady_clock::now() - start)
+          .count();
+  if (stats)
+    *stats = local;
+  return status;
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,98 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file VmSnapshot.h
+ * @brief Save-state snapshots of the script heap.
+ */
+
+#include "common/Status.h"
+#include "common/Types.h"
+#include <squirrel.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace arcanee::script {
+
+/**
+ * @brief Objects a freshly initialized VM already holds: native functions,
+ * API tables, registry delegates and native classes.
+ *
+ * Captured right after the API is registered, breadth-first from the root,
+ * const and registry tables. Snapshots refer to these by position instead of
+ * copying them, and a VM initialized the same way resolves the positions to
+ * its own objects. The root and const tables are not part of the baseline;
+ * snapshots carry their contents. Anything a script stores into a baseline
+ * object (e.g. a field added to an API table) is not captured.
+ */
+class SnapshotBaseline {
+public:
+  void capture(HSQUIRRELVM vm);
+  void release(HSQUIRRELVM vm);
+
+  size_t size() const { return m_objects.size(); }
+  const HSQOBJECT &at(size_t index) const { return m_objects[index]; }
+
+  /// Position of @p obj, or -1 if it was created after the capture.
+  i64 find(const HSQOBJECT &obj) const;
+
+  /// Changes whenever registration order or content does.
+  u64 signature() const { return m_signature; }
+
+private:
+  std::vector<HSQOBJECT> m_objects; // strong refs
+  std::unordered_map<const void *, u32> m_index;
+  u64 m_signature = 0;
+};
+
+/// Named objects outside the root table, e.g. the require() module cache.
+using SnapshotRoots = std::vector<std::pair<std::string, HSQOBJECT>>;
+
+struct SnapshotStats {
+  u64 objects = 0;  ///< Tables, arrays, closures, classes, instances, ...
+  u64 closures = 0; ///< Script closures (code is stored once per function)
+  u64 strings = 0;  ///< Distinct strings
+  u64 bytes = 0;    ///< Blob size
+  f64 seconds = 0.0;
+};
+
+/**
+ * @brief Serialize everything reachable from the root and const tables and
+ * @p roots into @p out.
+ *
+ * Closures keep their bytecode, captured variables (shared cells stay
+ * shared) and default parameter values; classes keep members, statics and
+ * attributes; instances keep their fields; userdata is copied byte for byte.
+ * Generators, threads and instances of native classes cannot be rebuilt and
+ * make the snapshot fail, as do native functions created after the baseline.
+ * Environments bound with bindenv() are not kept.
+ *
+ * Userdata type tags and native handles are stored as-is, so a snapshot is
+ * only valid in the process that took it. The VM must be idle.
+ */
+Status saveVmSnapshot(HSQUIRRELVM vm, const SnapshotBaseline &baseline,
+                      const SnapshotRoots &roots, std::vector<u8> &out,
+                      SnapshotStats *stats = nullptr);
+
+/**
+ * @brief Rebuild a snapshot in @p vm, which must be freshly initialized with
+ * the same API (matching baseline).
+ *
+ * Root and const table entries are written into the VM's own tables.
+ * @p roots receives the named roots, each holding a strong ref the caller
+ * releases. On failure the VM may be partly written and should be discarded.
+ */
+Status loadVmSnapshot(HSQUIRRELVM vm, const SnapshotBaseline &baseline,
+                      const u8 *data, size_t size, SnapshotRoots &roots,
+                      SnapshotStats *stats = nullptr);
+
+} // namespace arcanee::script
@@ -0,0 +1,394 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file WorkerPool.cpp
+ */
+
+#include "WorkerPool.h"
+#include "ScriptWatchdog.h"
+#include "ValueCodec.h"
+#include "VmAllocator.h"
+#include "api/BufferBinding.h"
+#include "api/MathBinding.h"
+#include "common/Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <sqstdmath.h>
+#include <sqstdstring.h>
+
+namespace arcanee::script {
+
+namespace {
+
+using SourcePtr = std::shared_ptr<const std::string>;
+
+// Last compiler error on this worker thread
+thread_local std::string t_compileError;
+
+void workerPrint(HSQUIRRELVM /*v*/, const SQChar *s, ...) {
+  va_list args;
+  va_start(args, s);
+  char buffer[1024];
+  vsnprintf(buffer, sizeof(buffer), s, args);
+  va_end(args);
+  LOG_INFO("[Worker] %s", buffer);
+}
+
+void workerCompileError(HSQUIRRELVM /*v*/, const SQChar *desc,
+                        const SQChar *source, SQInteger line,
+                        SQInteger column) {
+  char buffer[512];
+  snprintf(buffer, sizeof(buffer), "%s at %s:%lld:%lld", desc, source,
+           static_cast<long long>(line), static_cast<long long>(column));
+  t_compileError = buffer;
+}
+
+// Message of the error raised by the last failed call
+std::string lastError(HSQUIRRELVM vm) {
+  sq_getlasterror(vm);
+  const SQChar *s = nullptr;
+  std::string msg = "unknown error";
+  if (SQ_SUCCEEDED(sq_tostring(vm, -1)) &&
+      SQ_SUCCEEDED(sq_getstring(vm, -1, &s))) {
+    msg = s;
+    sq_pop(vm, 1);
+  }
+  sq_pop(vm, 1);
+  return msg;
+}
+
+// A worker's VM, its arena and the functions of the modules it has loaded
+class WorkerVm {
+public:
+  WorkerVm(u64 memoryCapBytes, ScriptWatchdog *watchdog)
+      : m_memoryCap(memoryCapBytes), m_watchdog(watchdog) {
+    open();
+  }
+  ~WorkerVm() { close(); }
+
+  WorkerVm(const WorkerVm &) = delete;
+  WorkerVm &operator=(const WorkerVm &) = delete;
+
+  // Start over after the memory cap was hit
+  void reset() {
+    close();
+    open();
+  }
+
+  bool isOverHardCap() const { return m_allocator->isOverHardCap(); }
+
+  Status run(const std::string &module, const SourcePtr &source,
+             const std::vector<u8> &args, f64 timeoutSec,
+             std::vector<u8> &result) {
+    VmAllocator::Scope memScope(m_allocator.get());
+    SQInteger top = sq_gettop(m_vm);
+    Status status = call(module, source, args, timeoutSec, result);
+    if (m_watchdog->hasTripped())
+      status = Status(StatusCode::DeadlineExceeded, "job timed out");
+    sq_settop(m_vm, top);
+    return status;
+  }
+
+private:
+  void open() {
+    m_allocator = std::make_unique<VmAllocator>();
+    m_allocator->setCaps(0, m_memoryCap);
+    // Past the cap the job stops at its next loop or call
+    m_allocator->setHardCapHandler(ScriptWatchdog::onHardCap, m_watchdog);
+    VmAllocator::Scope memScope(m_allocator.get());
+
+    m_vm = sq_open(1024);
+    sq_setprintfunc(m_vm, workerPrint, workerPrint);
+    sq_setcompilererrorhandler(m_vm, workerCompileError);
+
+    sq_pushroottable(m_vm);
+    sqstd_register_mathlib(m_vm);
+    sqstd_register_stringlib(m_vm);
+    sq_pop(m_vm, 1);
+    registerBufferBinding(m_vm);
+    registerMathBinding(m_vm);
+  }
+
+  void close() {
+    {
+      VmAllocator::Scope memScope(m_allocator.get());
+      for (auto &entry : m_modules)
+        sq_release(m_vm, &entry.second.fn);
+      m_modules.clear();
+      sq_close(m_vm);
+      m_vm = nullptr;
+    }
+    m_allocator.reset();
+  }
+
+  // Pushes the function @p module returns, loading it on first use and
+  // again when the pool hands out a new source (WorkerPool::reloadSources)
+  Status pushModule(const std::string &module, const SourcePtr &source) {
+    auto it = m_modules.find(module);
+    if (it != m_modules.end()) {
+      if (it->second.source == source) {
+        sq_pushobject(m_vm, it->second.fn);
+        return Status::Ok();
+      }
+      sq_release(m_vm, &it->second.fn);
+      m_modules.erase(it);
+    }
+
+    t_compileError.clear();
+    if (SQ_FAILED(sq_compilebuffer(m_vm, source->c_str(),
+                                   static_cast<SQInteger>(source->size()),
+                                   module.c_str(), SQTrue))) {
+      return Status::InvalidArgument("compile error: " + t_compileError);
+    }
+    sq_pushroottable(m_vm);
+    if (SQ_FAILED(sq_call(m_vm, 1, SQTrue, SQFalse)))
+      return Status::InternalError(lastError(m_vm));
+
+    SQObjectType type = sq_gettype(m_vm, -1);
+    if (type != OT_CLOSURE && type != OT_NATIVECLOSURE) {
+      return Status::InvalidArgument(module + " must return a function");
+    }
+    HSQOBJECT fn;
+    sq_getstackobj(m_vm, -1, &fn);
+    sq_addref(m_vm, &fn);
+    m_modules[module] = {fn, source};
+    return Status::Ok();
+  }
+
+  Status call(const std::string &module, const SourcePtr &source,
+              const std::vector<u8> &args, f64 timeoutSec,
+              std::vector<u8> &result) {
+    // Covers loading the module too, which runs script
+    ScriptWatchdog::Scope watchdogScope(m_watchdog, timeoutSec);
+    ARC_RETURN_IF_ERROR(pushModule(module, source));
+    sq_pushroottable(m_vm);
+
+    // Spread the argument array onto the stack
+    ByteReader reader(args.data(), args.size());
+    ARC_RETURN_IF_ERROR(decodeValue(m_vm, reader));
+    SQInteger count = sq_getsize(m_vm, -1);
+    for (SQInteger i = 0; i < count; ++i) {
+      sq_pushinteger(m_vm, i);
+      sq_rawget(m_vm, -2 - i);
+    }
+    sq_remove(m_vm, -1 - count);
+
+    SQRESULT res = sq_call(m_vm, count + 1, SQTrue, SQFalse);
+    if (SQ_FAILED(res))
+      return Status::InternalError(lastError(m_vm));
+    return encodeValue(m_vm, -1, result, m_memoryCap);
+  }
+
+  u64 m_memoryCap;
+  ScriptWatchdog *m_watchdog;
+  std::unique_ptr<VmAllocator> m_allocator;
+  HSQUIRRELVM m_vm = nullptr;
+  struct Module {
+    HSQOBJECT fn;
+    SourcePtr source; // What fn was compiled from
+  };
+  std::unordered_map<std::string, Module> m_modules;
+};
+
+} // namespace
+
+struct WorkerPool::Worker {
+  std::thread thread;
+  ScriptWatchdog watchdog;
+  SPSCQueue<Job *, kQueueSize> inbox;
+  SPSCQueue<Job *, kQueueSize> outbox;
+  size_t queued = 0; // Owner thread: jobs pushed and not yet collected
+
+  // Sleep only; the queues themselves take no lock
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stopping = false;
+};
+
+WorkerPool::WorkerPool(SourceLoader loader, const WorkerPoolConfig &config)
+    : m_loader(std::move(loader)), m_config(config),
+      m_workerCount(std::clamp<u32>(config.workers, 1,
+                                    WorkerPoolConfig::kMaxWorkers)) {}
+
+WorkerPool::~WorkerPool() { stop(); }
+
+void WorkerPool::start() {
+  if (isRunning())
+    return;
+
+  for (u32 i = 0; i < m_workerCount; ++i) {
+    m_workers.push_back(std::make_unique<Worker>());
+    Worker *worker = m_workers.back().get();
+    worker->thread = std::thread([this, worker]() {
+      WorkerVm vm(m_config.memoryCapBytes, &worker->watchdog);
+      for (;;) {
+        Job *job = nullptr;
+        if (!worker->inbox.pop(job)) {
+          std::unique_lock<std::mutex> lock(worker->mutex);
+          worker->cv.wait(lock, [worker]() {
+            return worker->stopping || !worker->inbox.empty();
+          });
+          if (worker->stopping)
+            return;
+          continue;
+        }
+
+        job->result.status =
+            vm.run(job->module, job->source, job->args,
+                   m_config.jobTimeoutSec, job->result.value);
+        if (vm.isOverHardCap()) {
+          job->result.status = Status(StatusCode::ResourceExhausted,
+                                      "worker memory cap exceeded");
+          job->result.value.clear();
+          vm.reset();
+        }
+        if (!job->result.status.ok())
+          job->result.value.clear();
+
+        worker->outbox.push(job); // Never full: at most kQueueSize in flight
+        {
+          std::lock_guard<std::mutex> lock(m_doneMutex);
+          m_doneCount++;
+        }
+        m_doneCv.notify_one();
+      }
+    });
+  }
+  LOG_INFO("WorkerPool: %u worker VMs", m_workerCount);
+}
+
+void WorkerPool::stop() {
+  for (auto &worker : m_workers) {
+    {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      worker->stopping = true;
+    }
+    worker->watchdog.raise(ScriptWatchdog::kTimeoutBit);
+    worker->cv.notify_one();
+  }
+  for (auto &worker : m_workers) {
+    if (worker->thread.joinable())
+      worker->thread.join();
+    Job *job = nullptr;
+    while (worker->inbox.pop(job))
+      delete job;
+    while (worker->outbox.pop(job))
+      delete job;
+  }
+  m_workers.clear();
+  m_finished.clear();
+  m_sources.clear();
+  m_nextOut = m_nextId; // Ids stay unique across restarts
+}
+
+StatusOr<u64> WorkerPool::submit(const std::string &module,
+                                 std::vector<u8> args) {
+  start();
+  Worker &worker = *m_workers[m_nextId % m_workers.size()];
+  if (worker.queued >= kQueueSize - 1) {
+    // Make room if results are waiting in the outbox
+    collectFrom(worker);
+    if (worker.queued >= kQueueSize - 1)
+      return Status(StatusCode::ResourceExhausted,
+                    "too many jobs in flight");
+  }
+
+  auto source = m_sources.find(module);
+  if (source == m_sources.end()) {
+    StatusOr<std::string> text = m_loader(module);
+    if (!text.ok())
+      return text.status();
+    source = m_sources
+                 .emplace(module, std::make_shared<const std::string>(
+                                      std::move(text).value()))
+                 .first;
+  }
+
+  auto job = std::make_unique<Job>();
+  job->id = m_nextId;
+  job->module = module;
+  job->source = source->second;
+  job->args = std::move(args);
+  job->result.id = job->id;
+
+  worker.inbox.push(job.release());
+  worker.queued++;
+  {
+    // Pairs with the predicate check so the wakeup cannot be missed
+    std::lock_guard<std::mutex> lock(worker.mutex);
+  }
+  worker.cv.notify_one();
+  return m_nextId++;
+}
+
+void WorkerPool::reloadSources() {
+  for (auto it = m_sources.begin(); it != m_sources.end();) {
+    StatusOr<std::string> text = m_loader(it->first);
+    if (!text.ok()) {
+      it = m_sources.erase(it); // The next submit reports the error
+      continue;
+    }
+    if (text.value() != *it->second)
+      it->second = std::make_shared<const std::string>(
+          std::move(text).value());
+    ++it;
+  }
+}
+
+bool WorkerPool::poll(JobResult &out) {
+  collect();
+  auto it = m_finished.find(m_nextOut);
+  if (it == m_finished.end())
+    return false;
+  out = std::move(it->second);
+  m_finished.erase(it);
+  m_nextOut++;
+  return true;
+}
+
+bool WorkerPool::wait(JobResult &out, f64 timeoutSec) {
+  const auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<f64>(timeoutSec));
+  while (pending() > 0) {
+    u64 seen;
+    {
+      std::lock_guard<std::mutex> lock(m_doneMutex);
+      seen = m_doneCount;
+    }
+    if (poll(out))
+      return true;
+    std::unique_lock<std::mutex> lock(m_doneMutex);
+    if (!m_doneCv.wait_until(lock, deadline, [this, seen]() {
+          return m_doneCount != seen;
+        })) {
+      return false;
+    }
+  }
+  return false;
+}
+
+void WorkerPool::collect() {
+  for (auto &worker : m_workers)
+    collectFrom(*worker);
+}
+
+void WorkerPool::collectFrom(Worker &worker) {
+  Job *job = nullptr;
+  while (worker.outbox.pop(job)) {
+    std::unique_ptr<Job> owned(job);
+    worker.queued--;
+    m_finished.emplace(job->id, std::move(job->result));
+  }
+}
+
+} // namespace arcanee::script
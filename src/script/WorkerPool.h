@@ -0,0 +1,148 @@
+#pragma once
+
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * @file WorkerPool.h
+ * @brief Isolated worker VMs running script jobs on other cores.
+ */
+
+#include "common/SPSCQueue.h"
+#include "common/Status.h"
+#include "common/Types.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace arcanee::script {
+
+struct WorkerPoolConfig {
+  static constexpr u32 kDefaultWorkers = 2;
+  static constexpr u32 kMaxWorkers = 4;
+
+  /// Clamped to [1, kMaxWorkers]. Never taken from the host's core count:
+  /// it decides which worker (and module state) each job sees.
+  u32 workers = kDefaultWorkers;
+  u64 memoryCapBytes = 32ull * 1024 * 1024; ///< Per worker VM
+  f64 jobTimeoutSec = 5.0;                  ///< Hang watchdog per job
+};
+
+struct JobResult {
+  u64 id = 0;
+  Status status;         ///< Compile, runtime or encoding error
+  std::vector<u8> value; ///< encodeValue() of what the job returned
+};
+
+/**
+ * @brief Pool of worker threads, each owning a Squirrel VM and allocator.
+ *
+ * A job names a module; the module's main chunk must return a function,
+ * which a worker compiles once and then calls with the job's arguments.
+ * Worker VMs only get the math/string std libs and the buf.* and math.*
+ * bindings: no gfx, audio, input, files or access to the main VM. Arguments
+ * and results cross as ValueCodec bytes.
+ *
+ * Jobs and results travel through per-worker lock-free SPSC queues; the
+ * mutexes only put idle threads to sleep. Job N always goes to worker
+ * N % workerCount() and results are handed out strictly in submission
+ * order, so what a cart observes does not depend on thread timing or on
+ * the machine (module state kept between jobs included).
+ *
+ * Not thread-safe: submit/poll/wait/stop from one thread.
+ */
+class WorkerPool {
+public:
+  /// Returns the source of a module; called on the submitting thread.
+  using SourceLoader =
+      std::function<StatusOr<std::string>(const std::string &module)>;
+
+  WorkerPool(SourceLoader loader, const WorkerPoolConfig &config);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  /// Spawn the workers; submit() does this on first use.
+  void start();
+
+  /// Abort running jobs and drop pending ones and their results.
+  void stop();
+
+  bool isRunning() const { return !m_workers.empty(); }
+  u32 workerCount() const { return m_workerCount; }
+
+  /// Budget for encoded arguments and results: no more than a worker holds.
+  u64 maxValueBytes() const { return m_config.memoryCapBytes; }
+
+  /**
+   * @brief Queue a call of @p module's function.
+   * @param args encodeValue() of an array holding the arguments.
+   * @return Job id; ids are consecutive from 1.
+   */
+  StatusOr<u64> submit(const std::string &module, std::vector<u8> args);
+
+  /**
+   * @brief Re-read the modules jobs have used. Workers recompile a module
+   * whose text changed on its next job, so its module state starts over.
+   */
+  void reloadSources();
+
+  /// Next result in submission order, if it has finished.
+  bool poll(JobResult &out);
+
+  /// Block until the next result in submission order is ready, for at most
+  /// @p timeoutSec. False if no job is pending or the time ran out.
+  bool wait(JobResult &out, f64 timeoutSec);
+
+  /// Submitted jobs whose results have not been returned yet.
+  size_t pending() const {
+    return static_cast<size_t>(m_nextId - m_nextOut);
+  }
+
+private:
+  static constexpr size_t kQueueSize = 64;
+
+  struct Job {
+    u64 id = 0;
+    std::string module;
+    std::shared_ptr<const std::string> source;
+    std::vector<u8> args;
+    JobResult result;
+  };
+
+  struct Worker;
+
+  void collect();
+  void collectFrom(Worker &worker);
+
+  SourceLoader m_loader;
+  WorkerPoolConfig m_config;
+  u32 m_workerCount = 1;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+
+  u64 m_nextId = 1;  // Next job id to hand out
+  u64 m_nextOut = 1; // Next job id whose result poll() returns
+  std::map<u64, JobResult> m_finished; // Reorder buffer
+  std::unordered_map<std::string, std::shared_ptr<const std::string>>
+      m_sources;
+
+  // Workers signal finished jobs so wait() can sleep
+  std::mutex m_doneMutex;
+  std::condition_variable m_doneCv;
+  u64 m_doneCount = 0;
+};
+
+} // namespace arcanee::script
@@ -11,7 +11,10 @@
 #include "AudioBinding.h"
 #include "audio/AudioManager.h"
 #include "common/Types.h"
+#include "script/BindingUtils.h"
+#include "script/api/BufferBinding.h"
 #include "vfs/Vfs.h"
+#include <algorithm>
 #include <sqstdaux.h>
 #include <sqstdio.h>
 #include <vector>
@@ -28,268 +31,204 @@ static arcanee::vfs::IVfs *g_audioVfs = nullptr;
 void setAudioVfs(arcanee::vfs::IVfs *vfs) { g_audioVfs = vfs; }
 
 // ===== Module Functions =====
-static SQInteger audio_loadModule(HSQUIRRELVM vm) {
-  const SQChar *path = nullptr;
-  if (SQ_FAILED(sq_getstring(vm, 2, &path))) {
-    return sq_throwerror(vm, "Invalid path argument");
-  }
-
+static SQInteger audio_loadModule(HSQUIRRELVM vm, const SQChar *path) {
   if (!g_audioVfs || !getAudioManager()) {
-    return sq_throwerror(vm, "Audio system not initialized");
+    setLastError(vm, "audio.loadModule: audio system not initialized");
+    return 0;
   }
 
   // Load file via VFS
   auto dataOpt = g_audioVfs->readBytes(path);
   if (!dataOpt) {
-    sq_pushinteger(vm, 0); // Return 0 on failure
-    return 1;
+    return 0; // Return 0 on failure
   }
   const auto &buffer = *dataOpt;
 
   // Load into AudioManager
-  u32 modHandle = getAudioManager()->loadModule(buffer.data(), buffer.size());
-  sq_pushinteger(vm, static_cast<SQInteger>(modHandle));
-  return 1;
+  return getAudioManager()->loadModule(buffer.data(), buffer.size());
 }
 
-static SQInteger audio_freeModule(HSQUIRRELVM vm) {
-  SQInteger handle;
-  sq_getinteger(vm, 2, &handle);
+static void audio_freeModule(SQInteger handle) {
   if (auto *mgr = getAudioManager()) {
     mgr->freeModule(static_cast<u32>(handle));
   }
-  return 0;
 }
 
-static SQInteger audio_playModule(HSQUIRRELVM vm) {
-  SQInteger handle;
-  SQBool loop = SQTrue;
-  sq_getinteger(vm, 2, &handle);
-  if (sq_gettop(vm) >= 3) {
-    sq_getbool(vm, 3, &loop);
-  }
+static void audio_playModule(SQInteger handle, std::optional<bool> loop) {
   if (auto *mgr = getAudioManager()) {
-    mgr->playModule(static_cast<u32>(handle), loop == SQTrue);
+    mgr->playModule(static_cast<u32>(handle), loop.value_or(true));
   }
-  return 0;
 }
 
-static SQInteger audio_stopModule(HSQUIRRELVM /*vm*/) {
+static void audio_stopModule() {
   if (auto *mgr = getAudioManager()) {
     mgr->stopModule();
   }
-  return 0;
 }
 
-static SQInteger audio_pauseModule(HSQUIRRELVM /*vm*/) {
+static void audio_pauseModule() {
   if (auto *mgr = getAudioManager()) {
     mgr->pauseModule();
   }
-  return 0;
 }
 
-static SQInteger audio_resumeModule(HSQUIRRELVM /*vm*/) {
+static void audio_resumeModule() {
   if (auto *mgr = getAudioManager()) {
     mgr->resumeModule();
   }
-  return 0;
 }
 
-static SQInteger audio_setModuleVolume(HSQUIRRELVM vm) {
-  SQFloat volume;
-  sq_getfloat(vm, 2, &volume);
+static void audio_setModuleVolume(SQFloat volume) {
   if (auto *mgr = getAudioManager()) {
     mgr->setModuleVolume(volume);
   }
-  return 0;
 }
 
-static SQInteger audio_isModulePlaying(HSQUIRRELVM vm) {
-  if (auto *mgr = getAudioManager()) {
-    sq_pushbool(vm, mgr->isModulePlaying() ? SQTrue : SQFalse);
-  } else {
-    sq_pushbool(vm, SQFalse);
-  }
-  return 1;
+static bool audio_isModulePlaying() {
+  auto *mgr = getAudioManager();
+  return mgr && mgr->isModulePlaying();
 }
 
 // ===== Sound Functions =====
-static SQInteger audio_loadSound(HSQUIRRELVM vm) {
-  const SQChar *path = nullptr;
-  if (SQ_FAILED(sq_getstring(vm, 2, &path))) {
-    return sq_throwerror(vm, "Invalid path argument");
-  }
-
+static SQInteger audio_loadSound(HSQUIRRELVM vm, const SQChar *path) {
   if (!g_audioVfs || !getAudioManager()) {
-    return sq_throwerror(vm, "Audio system not initialized");
+    setLastError(vm, "audio.loadSound: audio system not initialized");
+    return 0;
   }
 
   auto dataOpt = g_audioVfs->readBytes(path);
   if (!dataOpt) {
-    sq_pushinteger(vm, 0); // Return 0 on failure
-    return 1;
+    return 0; // Return 0 on failure
   }
   const auto &buffer = *dataOpt;
 
   // Assuming 44100/2 for raw loading default as discussed
-  u32 sndHandle =
-      getAudioManager()->loadSound(buffer.data(), buffer.size(), 44100, 2);
-  sq_pushinteger(vm, static_cast<SQInteger>(sndHandle));
+  return getAudioManager()->loadSound(buffer.data(), buffer.size(), 44100, 2);
+}
+
+// audio.loadSoundFromBuffer(buf [, sampleRate [, channels]]): interleaved
+// samples from a Float32Buffer in [-1, 1] or packed PCM16 in a ByteBuffer,
+// e.g. for procedurally generated sounds. Hand-written: takes a buffer.
+static SQInteger audio_loadSoundFromBuffer(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 2 || top > 4)
+    return bindingArityError(vm, 1, 3);
+
+  BufferView buf;
+  if (!getBuffer(vm, 2, buf) || buf.type == BufferType::Int32 ||
+      buf.byteSize() % 2 != 0)
+    return bindingTypeError(vm, 1, "a Float32Buffer or PCM16 ByteBuffer");
+
+  SQInteger sampleRate = 44100;
+  SQInteger channels = 2;
+  if (top >= 3 && SQ_FAILED(sq_getinteger(vm, 3, &sampleRate)))
+    return bindingTypeError(vm, 2, "a number");
+  if (top >= 4 && SQ_FAILED(sq_getinteger(vm, 4, &channels)))
+    return bindingTypeError(vm, 3, "a number");
+  if (sampleRate <= 0 || (channels != 1 && channels != 2)) {
+    setLastError(vm, "audio.loadSoundFromBuffer: invalid format");
+    sq_pushinteger(vm, 0);
+    return 1;
+  }
+
+  auto *mgr = getAudioManager();
+  if (!mgr) {
+    setLastError(vm, "audio.loadSoundFromBuffer: audio system not initialized");
+    sq_pushinteger(vm, 0);
+    return 1;
+  }
+
+  const u8 *pcm = buf.bytes();
+  size_t size = buf.byteSize();
+  std::vector<i16> converted;
+  if (buf.type == BufferType::Float32) {
+    converted.resize(static_cast<size_t>(buf.length));
+    for (size_t i = 0; i < converted.size(); ++i) {
+      f32 v = std::clamp(buf.floats()[i], -1.0f, 1.0f);
+      converted[i] = static_cast<i16>(v * 32767.0f);
+    }
+    pcm = reinterpret_cast<const u8 *>(converted.data());
+    size = converted.size() * sizeof(i16);
+  }
+  sq_pushinteger(vm, mgr->loadSound(pcm, size, static_cast<u32>(sampleRate),
+                                    static_cast<u32>(channels)));
   return 1;
 }
 
-static SQInteger audio_freeSound(HSQUIRRELVM vm) {
-  SQInteger handle;
-  sq_getinteger(vm, 2, &handle);
+static void audio_freeSound(SQInteger handle) {
   if (auto *mgr = getAudioManager()) {
     mgr->freeSound(static_cast<u32>(handle));
   }
-  return 0;
 }
 
-static SQInteger audio_playSound(HSQUIRRELVM vm) {
-  SQInteger handle;
-  SQFloat volume = 1.0f, pan = 0.0f;
-  SQBool loop = SQFalse;
-
-  sq_getinteger(vm, 2, &handle);
-  if (sq_gettop(vm) >= 3)
-    sq_getfloat(vm, 3, &volume);
-  if (sq_gettop(vm) >= 4)
-    sq_getfloat(vm, 4, &pan);
-  if (sq_gettop(vm) >= 5)
-    sq_getbool(vm, 5, &loop);
-
+static SQInteger audio_playSound(SQInteger handle,
+                                 std::optional<SQFloat> volume,
+                                 std::optional<SQFloat> pan,
+                                 std::optional<bool> loop) {
   if (auto *mgr = getAudioManager()) {
-    i32 voice =
-        mgr->playSound(static_cast<u32>(handle), volume, pan, loop == SQTrue);
-    sq_pushinteger(vm, voice);
-  } else {
-    sq_pushinteger(vm, -1);
+    return mgr->playSound(static_cast<u32>(handle), volume.value_or(1.0f),
+                          pan.value_or(0.0f), loop.value_or(false));
   }
-  return 1;
+  return -1;
 }
 
-static SQInteger audio_stopVoice(HSQUIRRELVM vm) {
-  SQInteger voice;
-  sq_getinteger(vm, 2, &voice);
+static void audio_stopVoice(SQInteger voice) {
   if (auto *mgr = getAudioManager()) {
     mgr->stopVoice(static_cast<u32>(voice));
   }
-  return 0;
 }
 
-static SQInteger audio_stopAllSounds(HSQUIRRELVM /*vm*/) {
+static void audio_stopAllSounds() {
   if (auto *mgr = getAudioManager()) {
     mgr->stopAllSounds();
   }
-  return 0;
 }
 
 // ===== Master Control =====
-static SQInteger audio_setMasterVolume(HSQUIRRELVM vm) {
-  SQFloat volume;
-  sq_getfloat(vm, 2, &volume);
+static void audio_setMasterVolume(SQFloat volume) {
   if (auto *mgr = getAudioManager()) {
     mgr->setMasterVolume(volume);
   }
-  return 0;
 }
 
-static SQInteger audio_getMasterVolume(HSQUIRRELVM vm) {
-  if (auto *mgr = getAudioManager()) {
-    sq_pushfloat(vm, mgr->getMasterVolume());
-  } else {
-    sq_pushfloat(vm, 1.0f);
-  }
-  return 1;
+static SQFloat audio_getMasterVolume() {
+  auto *mgr = getAudioManager();
+  return mgr ? mgr->getMasterVolume() : 1.0f;
 }
 
-static SQInteger audio_getActiveVoiceCount(HSQUIRRELVM vm) {
-  if (auto *mgr = getAudioManager()) {
-    sq_pushinteger(vm, static_cast<SQInteger>(mgr->getActiveVoiceCount()));
-  } else {
-    sq_pushinteger(vm, 0);
-  }
-  return 1;
+static SQInteger audio_getActiveVoiceCount() {
+  auto *mgr = getAudioManager();
+  return mgr ? static_cast<SQInteger>(mgr->getActiveVoiceCount()) : 0;
 }
 
 // ===== Registration =====
+static constexpr NativeFunction kAudioFunctions[] = {
+    // Module functions
+    {"loadModule", NativeCall<audio_loadModule>},
+    {"freeModule", NativeCall<audio_freeModule>},
+    {"playModule", NativeCall<audio_playModule>},
+    {"stopModule", NativeCall<audio_stopModule>},
+    {"pauseModule", NativeCall<audio_pauseModule>},
+    {"resumeModule", NativeCall<audio_resumeModule>},
+    {"setModuleVolume", NativeCall<audio_setModuleVolume>},
+    {"isModulePlaying", NativeCall<audio_isModulePlaying>},
+
+    // Sound functions
+    {"loadSound", NativeCall<audio_loadSound>},
+    {"loadSoundFromBuffer", audio_loadSoundFromBuffer},
+    {"freeSound", NativeCall<audio_freeSound>},
+    {"playSound", NativeCall<audio_playSound>},
+    {"stopVoice", NativeCall<audio_stopVoice>},
+    {"stopAllSounds", NativeCall<audio_stopAllSounds>},
+
+    // Master control
+    {"setMasterVolume", NativeCall<audio_setMasterVolume>},
+    {"getMasterVolume", NativeCall<audio_getMasterVolume>},
+    {"getActiveVoiceCount", NativeCall<audio_getActiveVoiceCount>},
+};
+
 void registerAudioBinding(HSQUIRRELVM vm) {
-  sq_pushroottable(vm);
-  sq_pushstring(vm, "audio", -1);
-  sq_newtable(vm);
-
-  // Module functions
-  sq_pushstring(vm, "loadModule", -1);
-  sq_newclosure(vm, audio_loadModule, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "freeModule", -1);
-  sq_newclosure(vm, audio_freeModule, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "playModule", -1);
-  sq_newclosure(vm, audio_playModule, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "stopModule", -1);
-  sq_newclosure(vm, audio_stopModule, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "pauseModule", -1);
-  sq_newclosure(vm, audio_pauseModule, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "resumeModule", -1);
-  sq_newclosure(vm, audio_resumeModule, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "setModuleVolume", -1);
-  sq_newclosure(vm, audio_setModuleVolume, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "isModulePlaying", -1);
-  sq_newclosure(vm, audio_isModulePlaying, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Sound functions
-  sq_pushstring(vm, "loadSound", -1);
-  sq_newclosure(vm, audio_loadSound, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "freeSound", -1);
-  sq_newclosure(vm, audio_freeSound, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "playSound", -1);
-  sq_newclosure(vm, audio_playSound, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "stopVoice", -1);
-  sq_newclosure(vm, audio_stopVoice, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "stopAllSounds", -1);
-  sq_newclosure(vm, audio_stopAllSounds, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Master control
-  sq_pushstring(vm, "setMasterVolume", -1);
-  sq_newclosure(vm, audio_setMasterVolume, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "getMasterVolume", -1);
-  sq_newclosure(vm, audio_getMasterVolume, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "getActiveVoiceCount", -1);
-  sq_newclosure(vm, audio_getActiveVoiceCount, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Add audio table to root
-  sq_newslot(vm, -3, SQFalse);
-  sq_pop(vm, 1);
+  BindTable(vm, "audio", kAudioFunctions);
 }
 
 } // namespace arcanee::script
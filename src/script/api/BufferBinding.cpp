@@ -0,0 +1,381 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file BufferBinding.cpp
+ * @brief Typed numeric buffers (buf.*) shared between scripts and natives.
+ *
+ * A buffer is a single userdata: a small header followed by the elements, so
+ * the storage is counted against the VM memory caps and natives read it in
+ * place. All three element types share one delegate table, kept in the VM
+ * registry, which provides indexing, foreach and the bulk methods.
+ */
+
+#include "BufferBinding.h"
+#include "script/BindingUtils.h"
+#include "script/VmAllocator.h"
+#include <algorithm>
+#include <cstring>
+
+namespace arcanee::script {
+
+namespace {
+
+// Address identifies buffer userdata (sq_settypetag)
+const int kBufferTag = 0;
+SQUserPointer bufferTag() {
+  return const_cast<SQUserPointer>(static_cast<const void *>(&kBufferTag));
+}
+
+constexpr const SQChar *kDelegateKey = "arcanee.buffer";
+constexpr SQInteger kMaxLength = SQInteger(1) << 28;
+constexpr const SQChar *kOutOfMemory =
+    "Out of memory: buffer would exceed the VM memory hard cap";
+
+struct BufferHeader {
+  BufferType type;
+  SQInteger length;
+};
+constexpr size_t kDataOffset = (sizeof(BufferHeader) + 15) & ~size_t(15);
+
+const char *typeName(BufferType type) {
+  switch (type) {
+  case BufferType::Float32:
+    return "Float32Buffer";
+  case BufferType::Int32:
+    return "Int32Buffer";
+  default:
+    return "ByteBuffer";
+  }
+}
+
+void pushElement(HSQUIRRELVM vm, const BufferView &buf, SQInteger i) {
+  switch (buf.type) {
+  case BufferType::Float32:
+    sq_pushfloat(vm, buf.floats()[i]);
+    break;
+  case BufferType::Int32:
+    sq_pushinteger(vm, buf.ints()[i]);
+    break;
+  default:
+    sq_pushinteger(vm, buf.bytes()[i]);
+    break;
+  }
+}
+
+// Byte stores wrap like a Uint8Array
+bool readElement(HSQUIRRELVM vm, SQInteger idx, const BufferView &buf,
+                 SQInteger i) {
+  if (buf.type == BufferType::Float32) {
+    SQFloat v;
+    if (SQ_FAILED(sq_getfloat(vm, idx, &v)))
+      return false;
+    buf.floats()[i] = v;
+    return true;
+  }
+  SQInteger v;
+  if (SQ_FAILED(sq_getinteger(vm, idx, &v)))
+    return false;
+  if (buf.type == BufferType::Int32)
+    buf.ints()[i] = static_cast<i32>(v);
+  else
+    buf.bytes()[i] = static_cast<u8>(v);
+  return true;
+}
+
+// Array-style index: negative counts from the end, result clamped to [0, len]
+SQInteger clampIndex(SQInteger i, SQInteger length) {
+  if (i < 0)
+    i += length;
+  return std::clamp<SQInteger>(i, 0, length);
+}
+
+bool optionalIndex(HSQUIRRELVM vm, SQInteger idx, SQInteger fallback,
+                   SQInteger &out) {
+  if (sq_gettop(vm) < idx || sq_gettype(vm, idx) == OT_NULL) {
+    out = fallback;
+    return true;
+  }
+  return SQ_SUCCEEDED(sq_getinteger(vm, idx, &out));
+}
+
+// ===== Metamethods =====
+
+SQInteger buf_get(HSQUIRRELVM vm) {
+  BufferView buf;
+  getBuffer(vm, 1, buf);
+  if (sq_gettype(vm, 2) != OT_INTEGER) {
+    // Clean "not found" so unknown member lookups report normally
+    sq_pushnull(vm);
+    return sq_throwobject(vm);
+  }
+  SQInteger i;
+  sq_getinteger(vm, 2, &i);
+  if (i < 0 || i >= buf.length)
+    return sq_throwerror(vm, "the index doesn't exist");
+  pushElement(vm, buf, i);
+  return 1;
+}
+
+SQInteger buf_set(HSQUIRRELVM vm) {
+  BufferView buf;
+  getBuffer(vm, 1, buf);
+  if (sq_gettype(vm, 2) != OT_INTEGER)
+    return sq_throwerror(vm, "buffer index must be an integer");
+  SQInteger i;
+  sq_getinteger(vm, 2, &i);
+  if (i < 0 || i >= buf.length)
+    return sq_throwerror(vm, "the index doesn't exist");
+  if (!readElement(vm, 3, buf, i))
+    return sq_throwerror(vm, "buffer value must be a number");
+  return 0;
+}
+
+SQInteger buf_nexti(HSQUIRRELVM vm) {
+  BufferView buf;
+  getBuffer(vm, 1, buf);
+  SQInteger next = 0;
+  if (sq_gettype(vm, 2) != OT_NULL) {
+    sq_getinteger(vm, 2, &next);
+    ++next;
+  }
+  if (next < buf.length)
+    sq_pushinteger(vm, next);
+  else
+    sq_pushnull(vm);
+  return 1;
+}
+
+SQInteger buf_typeof(HSQUIRRELVM vm) {
+  BufferView buf;
+  getBuffer(vm, 1, buf);
+  sq_pushstring(vm, typeName(buf.type), -1);
+  return 1;
+}
+
+// ===== Methods =====
+
+SQInteger buf_len(HSQUIRRELVM vm) {
+  BufferView buf;
+  getBuffer(vm, 1, buf);
+  sq_pushinteger(vm, buf.length);
+  return 1;
+}
+
+// fill(value [, start [, end]]) -> this
+SQInteger buf_fill(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 2 || top > 4)
+    return bindingArityError(vm, 1, 3);
+
+  BufferView buf;
+  getBuffer(vm, 1, buf);
+  SQInteger start, end;
+  if (!optionalIndex(vm, 3, 0, start))
+    return bindingTypeError(vm, 2, "a number");
+  if (!optionalIndex(vm, 4, buf.length, end))
+    return bindingTypeError(vm, 3, "a number");
+  start = clampIndex(start, buf.length);
+  end = clampIndex(end, buf.length);
+  sq_push(vm, 1);
+  if (start >= end)
+    return 1;
+
+  // Convert once into element 'start', then replicate
+  if (!readElement(vm, 2, buf, start))
+    return bindingTypeError(vm, 1, "a number");
+  switch (buf.type) {
+  case BufferType::Float32:
+    std::fill(buf.floats() + start + 1, buf.floats() + end,
+              buf.floats()[start]);
+    break;
+  case BufferType::Int32:
+    std::fill(buf.ints() + start + 1, buf.ints() + end, buf.ints()[start]);
+    break;
+  default:
+    std::memset(buf.bytes() + start, buf.bytes()[start],
+                static_cast<size_t>(end - start));
+    break;
+  }
+  return 1;
+}
+
+// slice(start [, end]) -> new buffer holding a copy of [start, end)
+SQInteger buf_slice(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 2 || top > 3)
+    return bindingArityError(vm, 1, 2);
+
+  BufferView buf;
+  getBuffer(vm, 1, buf);
+  SQInteger start, end;
+  if (!optionalIndex(vm, 2, 0, start))
+    return bindingTypeError(vm, 1, "a number");
+  if (!optionalIndex(vm, 3, buf.length, end))
+    return bindingTypeError(vm, 2, "a number");
+  start = clampIndex(start, buf.length);
+  end = std::max(start, clampIndex(end, buf.length));
+
+  void *dst = pushBuffer(vm, buf.type, end - start);
+  if (!dst)
+    return sq_throwerror(vm, kOutOfMemory);
+  std::memcpy(dst, buf.bytes() + start * buf.elementSize(),
+              static_cast<size_t>(end - start) * buf.elementSize());
+  return 1;
+}
+
+// copyFrom(src [, offset]) -> this: src is a buffer of the same type or an
+// array of numbers; copies as many elements as fit starting at offset
+SQInteger buf_copyFrom(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 2 || top > 3)
+    return bindingArityError(vm, 1, 2);
+
+  BufferView buf;
+  getBuffer(vm, 1, buf);
+  SQInteger offset;
+  if (!optionalIndex(vm, 3, 0, offset))
+    return bindingTypeError(vm, 2, "a number");
+  offset = clampIndex(offset, buf.length);
+  SQInteger room = buf.length - offset;
+
+  BufferView src;
+  if (getBuffer(vm, 2, src)) {
+    if (src.type != buf.type)
+      return bindingTypeError(vm, 1, typeName(buf.type));
+    SQInteger n = std::min(room, src.length);
+    std::memmove(buf.bytes() + offset * buf.elementSize(), src.data,
+                 static_cast<size_t>(n) * buf.elementSize());
+    sq_push(vm, 1);
+    return 1;
+  }
+
+  if (sq_gettype(vm, 2) != OT_ARRAY)
+    return bindingTypeError(vm, 1, "a buffer or an array of numbers");
+  SQInteger n = std::min(room, sq_getsize(vm, 2));
+  for (SQInteger i = 0; i < n; ++i) {
+    sq_pushinteger(vm, i);
+    sq_rawget(vm, 2);
+    bool ok = readElement(vm, -1, buf, offset + i);
+    sq_pop(vm, 1);
+    if (!ok)
+      return bindingTypeError(vm, 1, "a buffer or an array of numbers");
+  }
+  sq_push(vm, 1);
+  return 1;
+}
+
+const NativeFunction kDelegateFunctions[] = {
+    {"_get", buf_get},       {"_set", buf_set},   {"_nexti", buf_nexti},
+    {"_typeof", buf_typeof}, {"len", buf_len},    {"fill", buf_fill},
+    {"slice", buf_slice},    {"copyFrom", buf_copyFrom},
+};
+
+// ===== Constructors =====
+
+// buf.float32(length | array), buf.int32(...), buf.bytes(...)
+template <BufferType Type> SQInteger buf_new(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+
+  SQInteger length;
+  bool fromArray = sq_gettype(vm, 2) == OT_ARRAY;
+  if (fromArray) {
+    length = sq_getsize(vm, 2);
+  } else if (SQ_FAILED(sq_getinteger(vm, 2, &length))) {
+    return bindingTypeError(vm, 1, "a length or an array of numbers");
+  }
+
+  if (!pushBuffer(vm, Type, length)) {
+    if (length >= 0 && length <= kMaxLength)
+      return sq_throwerror(vm, kOutOfMemory);
+    setLastError(vm, "buf: length must be between 0 and " +
+                         std::to_string(kMaxLength));
+    sq_pushnull(vm);
+    return 1;
+  }
+
+  if (fromArray) {
+    BufferView buf;
+    getBuffer(vm, -1, buf);
+    for (SQInteger i = 0; i < length; ++i) {
+      sq_pushinteger(vm, i);
+      sq_rawget(vm, 2);
+      bool ok = readElement(vm, -1, buf, i);
+      sq_pop(vm, 1);
+      if (!ok) {
+        sq_pop(vm, 1);
+        return bindingTypeError(vm, 1, "a length or an array of numbers");
+      }
+    }
+  }
+  return 1;
+}
+
+constexpr NativeFunction kBufFunctions[] = {
+    {"float32", buf_new<BufferType::Float32>},
+    {"int32", buf_new<BufferType::Int32>},
+    {"bytes", buf_new<BufferType::Byte>},
+};
+
+} // namespace
+
+bool getBuffer(HSQUIRRELVM vm, SQInteger idx, BufferView &out) {
+  SQUserPointer p = nullptr, tag = nullptr;
+  if (sq_gettype(vm, idx) != OT_USERDATA ||
+      SQ_FAILED(sq_getuserdata(vm, idx, &p, &tag)) || tag != bufferTag()) {
+    return false;
+  }
+  auto *header = static_cast<BufferHeader *>(p);
+  out.type = header->type;
+  out.length = header->length;
+  out.data = static_cast<u8 *>(p) + kDataOffset;
+  return true;
+}
+
+void *pushBuffer(HSQUIRRELVM vm, BufferType type, SQInteger length) {
+  if (length < 0 || length > kMaxLength)
+    return nullptr;
+
+  size_t elementSize = (type == BufferType::Byte) ? 1 : 4;
+  size_t dataSize = static_cast<size_t>(length) * elementSize;
+  // Fail here rather than let one call take the VM far past its hard cap
+  if (!VmAllocator::current()->fitsHardCap(kDataOffset + dataSize))
+    return nullptr;
+  auto *p = static_cast<u8 *>(sq_newuserdata(vm, kDataOffset + dataSize));
+  // Header padding included: the heap hash reads userdata bytes verbatim
+  std::memset(p, 0, kDataOffset + dataSize);
+  auto *header = reinterpret_cast<BufferHeader *>(p);
+  header->type = type;
+  header->length = length;
+  sq_settypetag(vm, -1, bufferTag());
+
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kDelegateKey, -1);
+  if (SQ_SUCCEEDED(sq_rawget(vm, -2))) {
+    sq_setdelegate(vm, -3);
+  }
+  sq_pop(vm, 1); // registry
+  return p + kDataOffset;
+}
+
+void registerBufferBinding(HSQUIRRELVM vm) {
+  // Shared delegate, looked up from the registry by pushBuffer
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kDelegateKey, -1);
+  sq_newtable(vm);
+  for (const auto &fn : kDelegateFunctions) {
+    sq_pushstring(vm, fn.name, -1);
+    sq_newclosure(vm, fn.func, 0);
+    sq_setnativeclosurename(vm, -1,
+                            (std::string("buffer.") + fn.name).c_str());
+    sq_newslot(vm, -3, SQFalse);
+  }
+  sq_newslot(vm, -3, SQFalse);
+  sq_pop(vm, 1); // registry
+
+  BindTable(vm, "buf", kBufFunctions);
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "common/Types.h"
+#include <cstddef>
+#include <squirrel.h>
+
+namespace arcanee::script {
+
+/**
+ * @brief Element type of a typed buffer.
+ */
+enum class BufferType : u8 { Float32, Int32, Byte };
+
+/**
+ * @brief Native view of a script-owned typed buffer.
+ *
+ * The storage lives inside the userdata, so the view stays valid while the
+ * buffer is referenced from the VM stack (i.e. for the duration of a native
+ * call that received it as an argument).
+ */
+struct BufferView {
+  BufferType type = BufferType::Byte;
+  void *data = nullptr;
+  SQInteger length = 0; // Elements, not bytes
+
+  size_t elementSize() const { return type == BufferType::Byte ? 1 : 4; }
+  size_t byteSize() const {
+    return static_cast<size_t>(length) * elementSize();
+  }
+
+  f32 *floats() const { return static_cast<f32 *>(data); }
+  i32 *ints() const { return static_cast<i32 *>(data); }
+  u8 *bytes() const { return static_cast<u8 *>(data); }
+};
+
+/**
+ * @brief Register the buf.* constructors (Float32Buffer, Int32Buffer,
+ * ByteBuffer) and their shared delegate.
+ */
+void registerBufferBinding(HSQUIRRELVM vm);
+
+/**
+ * @brief Read the typed buffer at @p idx. False if it is not one.
+ */
+bool getBuffer(HSQUIRRELVM vm, SQInteger idx, BufferView &out);
+
+/**
+ * @brief Create a zeroed buffer and push it. Returns its storage, or null
+ * (nothing pushed) if the length is out of range or the buffer would take
+ * the VM past its memory hard cap.
+ */
+void *pushBuffer(HSQUIRRELVM vm, BufferType type, SQInteger length);
+
+} // namespace arcanee::script
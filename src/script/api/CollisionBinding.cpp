@@ -0,0 +1,214 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file CollisionBinding.cpp
+ * @brief Broadphase collision queries (collide.*) on top of CollisionWorld.
+ */
+
+#include "CollisionBinding.h"
+#include "physics/CollisionWorld.h"
+#include "script/BindingUtils.h"
+#include "script/api/BufferBinding.h"
+#include <cstring>
+#include <vector>
+
+namespace arcanee::script {
+
+using physics::CollisionWorld;
+
+namespace {
+
+constexpr const SQChar *kWorldKey = "arcanee.collide";
+
+CollisionWorld *worldOf(HSQUIRRELVM vm) {
+  SQUserPointer p = nullptr;
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kWorldKey, -1);
+  if (SQ_SUCCEEDED(sq_rawget(vm, -2))) {
+    sq_getuserpointer(vm, -1, &p);
+    sq_pop(vm, 1);
+  }
+  sq_pop(vm, 1);
+  return static_cast<CollisionWorld *>(p);
+}
+
+// Float32Buffer contents in place, or an array of numbers copied into the
+// binding arena. Null if neither.
+const f32 *readFloats(HSQUIRRELVM vm, SQInteger idx, SQInteger &count) {
+  BufferView buf;
+  if (getBuffer(vm, idx, buf)) {
+    count = buf.length;
+    return buf.type == BufferType::Float32 ? buf.floats() : nullptr;
+  }
+  if (sq_gettype(vm, idx) != OT_ARRAY)
+    return nullptr;
+
+  count = sq_getsize(vm, idx);
+  f32 *out = bindingArena().allocArray<f32>(static_cast<size_t>(count));
+  for (SQInteger i = 0; i < count; ++i) {
+    SQFloat v;
+    sq_pushinteger(vm, i);
+    sq_rawget(vm, idx);
+    bool ok = SQ_SUCCEEDED(sq_getfloat(vm, -1, &v));
+    sq_pop(vm, 1);
+    if (!ok)
+      return nullptr;
+    out[i] = static_cast<f32>(v);
+  }
+  return out;
+}
+
+// Int32Buffer or array of integers with exactly @p count entries
+const u32 *readBits(HSQUIRRELVM vm, SQInteger idx, SQInteger count) {
+  BufferView buf;
+  if (getBuffer(vm, idx, buf)) {
+    if (buf.type != BufferType::Int32 || buf.length != count)
+      return nullptr;
+    return reinterpret_cast<const u32 *>(buf.ints());
+  }
+  if (sq_gettype(vm, idx) != OT_ARRAY || sq_getsize(vm, idx) != count)
+    return nullptr;
+
+  u32 *out = bindingArena().allocArray<u32>(static_cast<size_t>(count));
+  for (SQInteger i = 0; i < count; ++i) {
+    SQInteger v;
+    sq_pushinteger(vm, i);
+    sq_rawget(vm, idx);
+    bool ok = SQ_SUCCEEDED(sq_getinteger(vm, -1, &v));
+    sq_pop(vm, 1);
+    if (!ok)
+      return nullptr;
+    out[i] = static_cast<u32>(v);
+  }
+  return out;
+}
+
+// Pushes an Int32Buffer copy of @p ids
+void pushIds(HSQUIRRELVM vm, const std::vector<u32> &ids) {
+  void *data =
+      pushBuffer(vm, BufferType::Int32, static_cast<SQInteger>(ids.size()));
+  if (!data) {
+    sq_pushnull(vm);
+    return;
+  }
+  if (!ids.empty())
+    std::memcpy(data, ids.data(), ids.size() * sizeof(u32));
+}
+
+// ===== collide.* =====
+
+// collide.update(rects [, layers [, masks]]) -> body count
+SQInteger collide_update(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 2 || top > 4)
+    return bindingArityError(vm, 1, 3);
+
+  FrameArena::Scope scratch(bindingArena());
+  SQInteger n = 0;
+  const f32 *rects = readFloats(vm, 2, n);
+  if (!rects || n % 4 != 0) {
+    return bindingTypeError(
+        vm, 1, "a Float32Buffer or array of x, y, w, h per body");
+  }
+  SQInteger count = n / 4;
+
+  static constexpr const char *kBitsExpected =
+      "an Int32Buffer or array with one entry per body";
+  const u32 *layers = nullptr;
+  const u32 *masks = nullptr;
+  if (top >= 3 && sq_gettype(vm, 3) != OT_NULL &&
+      !(layers = readBits(vm, 3, count))) {
+    return bindingTypeError(vm, 2, kBitsExpected);
+  }
+  if (top >= 4 && sq_gettype(vm, 4) != OT_NULL &&
+      !(masks = readBits(vm, 4, count))) {
+    return bindingTypeError(vm, 3, kBitsExpected);
+  }
+
+  CollisionWorld *world = worldOf(vm);
+  if (world)
+    world->update(rects, static_cast<u32>(count), layers, masks);
+  sq_pushinteger(vm, count);
+  return 1;
+}
+
+// collide.pairs() -> Int32Buffer of a, b ids per colliding pair
+SQInteger collide_pairs(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 1)
+    return bindingArityError(vm, 0, 0);
+  CollisionWorld *world = worldOf(vm);
+  if (!world) {
+    sq_pushnull(vm);
+    return 1;
+  }
+  pushIds(vm, world->findPairs());
+  return 1;
+}
+
+// collide.query(x, y, w, h [, mask]) -> Int32Buffer of body ids
+SQInteger collide_query(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 5 || top > 6)
+    return bindingArityError(vm, 4, 5);
+
+  SQFloat box[4];
+  for (SQInteger i = 0; i < 4; ++i) {
+    if (SQ_FAILED(sq_getfloat(vm, 2 + i, &box[i])))
+      return bindingTypeError(vm, 1 + i, "a number");
+  }
+  SQInteger mask = static_cast<SQInteger>(CollisionWorld::kAllLayers);
+  if (top == 6 && SQ_FAILED(sq_getinteger(vm, 6, &mask)))
+    return bindingTypeError(vm, 5, "an integer");
+
+  CollisionWorld *world = worldOf(vm);
+  if (!world) {
+    sq_pushnull(vm);
+    return 1;
+  }
+  pushIds(vm, world->query(box[0], box[1], box[2], box[3],
+                           static_cast<u32>(mask)));
+  return 1;
+}
+
+// collide.setCellSize(size)
+SQInteger collide_setCellSize(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  SQFloat size;
+  if (SQ_FAILED(sq_getfloat(vm, 2, &size)) || !(size > 0))
+    return bindingTypeError(vm, 1, "a positive number");
+  if (CollisionWorld *world = worldOf(vm))
+    world->setCellSize(static_cast<f32>(size));
+  return 0;
+}
+
+// collide.count() -> bodies in the last update, active or not
+SQInteger collide_count(HSQUIRRELVM vm) {
+  CollisionWorld *world = worldOf(vm);
+  sq_pushinteger(vm, world ? static_cast<SQInteger>(world->size()) : 0);
+  return 1;
+}
+
+constexpr NativeFunction kCollideFunctions[] = {
+    {"update", collide_update},
+    {"pairs", collide_pairs},
+    {"query", collide_query},
+    {"setCellSize", collide_setCellSize},
+    {"count", collide_count},
+};
+
+} // namespace
+
+void registerCollisionBinding(HSQUIRRELVM vm, CollisionWorld *world) {
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kWorldKey, -1);
+  sq_pushuserpointer(vm, world);
+  sq_newslot(vm, -3, SQFalse);
+  sq_pop(vm, 1);
+
+  BindTable(vm, "collide", kCollideFunctions);
+}
+
+} // namespace arcanee::script
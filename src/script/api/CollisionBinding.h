@@ -0,0 +1,21 @@
+#pragma once
+
+#include <squirrel.h>
+
+namespace arcanee::physics {
+class CollisionWorld;
+}
+
+namespace arcanee::script {
+
+/**
+ * @brief Register the collide.* functions (update, pairs, query,
+ * setCellSize, count), all driving @p world.
+ *
+ * Scripts hand over every body each tick as x, y, w, h per body (a
+ * Float32Buffer or an array); a body's id is its index. pairs() and query()
+ * return Int32Buffers of ids.
+ */
+void registerCollisionBinding(HSQUIRRELVM vm, physics::CollisionWorld *world);
+
+} // namespace arcanee::script
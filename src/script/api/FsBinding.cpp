@@ -2,7 +2,9 @@
 #include "common/Log.h"
 #include "script/BindingUtils.h"
 #include "script/ScriptEngine.h"
+#include "script/api/BufferBinding.h"
 #include "vfs/Vfs.h"
+#include <cstring>
 
 namespace arcanee::script::api {
 
@@ -68,6 +70,49 @@ SQInteger fs_write(HSQUIRRELVM vm) {
   return 1;
 }
 
+// Whole file into a ByteBuffer; no per-byte script values
+SQInteger fs_readBuffer(HSQUIRRELVM vm) {
+  const SQChar *path;
+  if (SQ_FAILED(GetArg(vm, 2, path)))
+    return sq_throwerror(vm, "Invalid argument: expected string path");
+
+  auto *vfs = GetVfs(vm);
+  if (!vfs)
+    return sq_throwerror(vm, "VFS not initialized");
+
+  auto content = vfs->readBytes(path);
+  if (!content)
+    return sq_throwerror(vm, "File not found or read error");
+
+  void *data = pushBuffer(vm, BufferType::Byte,
+                          static_cast<SQInteger>(content->size()));
+  if (!data)
+    return sq_throwerror(vm, "File too large for a buffer");
+  if (!content->empty())
+    std::memcpy(data, content->data(), content->size());
+  return 1;
+}
+
+// Raw contents of any typed buffer (little-endian elements)
+SQInteger fs_writeBuffer(HSQUIRRELVM vm) {
+  const SQChar *path;
+  BufferView buf;
+  if (SQ_FAILED(GetArg(vm, 2, path)))
+    return sq_throwerror(vm, "Invalid path: expected string");
+  if (!getBuffer(vm, 3, buf))
+    return sq_throwerror(vm, "Invalid content: expected buffer");
+
+  auto *vfs = GetVfs(vm);
+  if (!vfs)
+    return sq_throwerror(vm, "VFS not initialized");
+
+  std::vector<u8> bytes(buf.bytes(), buf.bytes() + buf.byteSize());
+  sq_pushbool(vm, vfs->writeBytes(path, bytes) == vfs::VfsError::None
+                      ? SQTrue
+                      : SQFalse);
+  return 1;
+}
+
 void RegisterFsBinding(HSQUIRRELVM vm) {
   sq_pushroottable(vm);
   sq_pushstring(vm, "fs", -1);
@@ -76,6 +121,8 @@ void RegisterFsBinding(HSQUIRRELVM vm) {
   BindFunction(vm, "exists", fs_exists);
   BindFunction(vm, "read", fs_read);
   BindFunction(vm, "write", fs_write);
+  BindFunction(vm, "readBuffer", fs_readBuffer);
+  BindFunction(vm, "writeBuffer", fs_writeBuffer);
 
   sq_newslot(vm, -3, SQTrue); // fs table into root
   sq_pop(vm, 1);              // pop root
@@ -11,7 +11,10 @@
 #include "GfxBinding.h"
 #include "common/Log.h"
 #include "render/Canvas2D.h"
+#include "script/BindingUtils.h"
+#include "script/api/BufferBinding.h"
 #include <sqstdaux.h>
+#include <sqstdblob.h>
 #include <vector>
 
 namespace arcanee::script {
@@ -38,177 +41,119 @@ static u32 resolveColor(SQInteger colorIdx) {
       colorIdx); // Fallback to raw value (or should we clamp?)
 }
 
-// ===== Clearing =====
-static SQInteger gfx_clear(HSQUIRRELVM vm) {
-  SQInteger color = 0x00000000;
-  if (sq_gettop(vm) >= 2) {
-    sq_getinteger(vm, 2, &color);
-  }
+render::Canvas2D *getGfxCanvas() { return g_canvas; }
+u32 resolveGfxColor(SQInteger color) { return resolveColor(color); }
 
+// ===== Clearing =====
+static void gfx_clear(std::optional<SQInteger> color) {
   if (!g_canvas) {
     // Should not happen if Runtime is correct, but safe guard.
   } else {
-    g_canvas->clear(resolveColor(color));
+    g_canvas->clear(resolveColor(color.value_or(0x00000000)));
   }
-  return 0;
 }
 
 // ===== State Stack =====
-static SQInteger gfx_save(HSQUIRRELVM /*vm*/) {
+static void gfx_save() {
   if (g_canvas)
     g_canvas->save();
-  return 0;
 }
 
-static SQInteger gfx_restore(HSQUIRRELVM /*vm*/) {
+static void gfx_restore() {
   if (g_canvas)
     g_canvas->restore();
-  return 0;
 }
 
 // ===== Transforms =====
-static SQInteger gfx_resetTransform(HSQUIRRELVM /*vm*/) {
+static void gfx_resetTransform() {
   if (g_canvas)
     g_canvas->resetTransform();
-  return 0;
 }
 
-static SQInteger gfx_translate(HSQUIRRELVM vm) {
-  SQFloat x, y;
-  sq_getfloat(vm, 2, &x);
-  sq_getfloat(vm, 3, &y);
+static void gfx_translate(SQFloat x, SQFloat y) {
   if (g_canvas)
     g_canvas->translate(x, y);
-  return 0;
 }
 
-static SQInteger gfx_rotate(HSQUIRRELVM vm) {
-  SQFloat rad;
-  sq_getfloat(vm, 2, &rad);
+static void gfx_rotate(SQFloat rad) {
   if (g_canvas)
     g_canvas->rotate(rad);
-  return 0;
 }
 
-static SQInteger gfx_scale(HSQUIRRELVM vm) {
-  SQFloat sx, sy;
-  sq_getfloat(vm, 2, &sx);
-  sq_getfloat(vm, 3, &sy);
+static void gfx_scale(SQFloat sx, SQFloat sy) {
   if (g_canvas)
     g_canvas->scale(sx, sy);
-  return 0;
 }
 
 // ===== Styles =====
-static SQInteger gfx_setFillColor(HSQUIRRELVM vm) {
-  SQInteger color;
-  sq_getinteger(vm, 2, &color);
+static void gfx_setFillColor(SQInteger color) {
   if (g_canvas)
     g_canvas->setFillColor(resolveColor(color));
-  return 0;
 }
 
-static SQInteger gfx_setStrokeColor(HSQUIRRELVM vm) {
-  SQInteger color;
-  sq_getinteger(vm, 2, &color);
+static void gfx_setStrokeColor(SQInteger color) {
   if (g_canvas)
     g_canvas->setStrokeColor(resolveColor(color));
-  return 0;
 }
 
-static SQInteger gfx_setLineWidth(HSQUIRRELVM vm) {
-  SQFloat width;
-  sq_getfloat(vm, 2, &width);
+static void gfx_setLineWidth(SQFloat width) {
   if (g_canvas)
     g_canvas->setLineWidth(width);
-  return 0;
 }
 
-static SQInteger gfx_setGlobalAlpha(HSQUIRRELVM vm) {
-  SQFloat alpha;
-  sq_getfloat(vm, 2, &alpha);
+static void gfx_setGlobalAlpha(SQFloat alpha) {
   if (g_canvas)
     g_canvas->setGlobalAlpha(alpha);
-  return 0;
 }
 
 // ===== Paths =====
-static SQInteger gfx_beginPath(HSQUIRRELVM /*vm*/) {
+static void gfx_beginPath() {
   if (g_canvas)
     g_canvas->beginPath();
-  return 0;
 }
 
-static SQInteger gfx_closePath(HSQUIRRELVM /*vm*/) {
+static void gfx_closePath() {
   if (g_canvas)
     g_canvas->closePath();
-  return 0;
 }
 
-static SQInteger gfx_moveTo(HSQUIRRELVM vm) {
-  SQFloat x, y;
-  sq_getfloat(vm, 2, &x);
-  sq_getfloat(vm, 3, &y);
+static void gfx_moveTo(SQFloat x, SQFloat y) {
   if (g_canvas)
     g_canvas->moveTo(x, y);
-  return 0;
 }
 
-static SQInteger gfx_lineTo(HSQUIRRELVM vm) {
-  SQFloat x, y;
-  sq_getfloat(vm, 2, &x);
-  sq_getfloat(vm, 3, &y);
+static void gfx_lineTo(SQFloat x, SQFloat y) {
   if (g_canvas)
     g_canvas->lineTo(x, y);
-  return 0;
 }
 
-static SQInteger gfx_rect(HSQUIRRELVM vm) {
-  SQFloat x, y, w, h;
-  sq_getfloat(vm, 2, &x);
-  sq_getfloat(vm, 3, &y);
-  sq_getfloat(vm, 4, &w);
-  sq_getfloat(vm, 5, &h);
+static void gfx_rect(SQFloat x, SQFloat y, SQFloat w, SQFloat h) {
   if (g_canvas)
     g_canvas->rect(x, y, w, h);
-  return 0;
 }
 
 // ===== Drawing =====
-static SQInteger gfx_fill(HSQUIRRELVM /*vm*/) {
+static void gfx_fill() {
   if (g_canvas)
     g_canvas->fill();
-  return 0;
 }
 
-static SQInteger gfx_stroke(HSQUIRRELVM /*vm*/) {
+static void gfx_stroke() {
   if (g_canvas)
     g_canvas->stroke();
-  return 0;
 }
 
-static SQInteger gfx_fillRect(HSQUIRRELVM vm) {
-  SQFloat x, y, w, h;
-  sq_getfloat(vm, 2, &x);
-  sq_getfloat(vm, 3, &y);
-  sq_getfloat(vm, 4, &w);
-  sq_getfloat(vm, 5, &h);
+static void gfx_fillRect(SQFloat x, SQFloat y, SQFloat w, SQFloat h) {
   if (g_canvas)
     g_canvas->fillRect(x, y, w, h);
-  return 0;
 }
 
-static SQInteger gfx_strokeRect(HSQUIRRELVM vm) {
-  SQFloat x, y, w, h;
-  sq_getfloat(vm, 2, &x);
-  sq_getfloat(vm, 3, &y);
-  sq_getfloat(vm, 4, &w);
-  sq_getfloat(vm, 5, &h);
+static void gfx_strokeRect(SQFloat x, SQFloat y, SQFloat w, SQFloat h) {
   if (g_canvas)
     g_canvas->strokeRect(x, y, w, h);
-  return 0;
 }
 
+// Returns an array, so stays hand-written
 static SQInteger gfx_getTargetSize(HSQUIRRELVM vm) {
   sq_newarray(vm, 0); // Create new array
 
@@ -227,303 +172,350 @@ static SQInteger gfx_getTargetSize(HSQUIRRELVM vm) {
   return 1;
 }
 
-// ===== Images =====
-static SQInteger gfx_loadImage(HSQUIRRELVM vm) {
-  const SQChar *path = nullptr;
-  sq_getstring(vm, 2, &path);
-  if (g_canvas && path) {
-    u32 handle = g_canvas->loadImage(path);
-    sq_pushinteger(vm, handle);
+// ===== Batches =====
+// One VM->native transition per batch. Inputs are typed buffers (read in
+// place), flat arrays of numbers, or blobs of packed little-endian records;
+// hand-written because they walk containers. Copies live in the binding
+// arena (scoped to the call), so per-frame batches don't touch the heap.
+
+static constexpr const char *kBatchExpected =
+    "a Float32Buffer, an array of numbers or a blob";
+
+using SpriteInstance = render::Canvas2D::SpriteInstance;
+static_assert(sizeof(SpriteInstance) == 12,
+              "drawSprites blob records are {i32 image, f32 x, f32 y}");
+
+// Reads array element i of the array at idx (absolute) as a number
+static bool arrayNumber(HSQUIRRELVM vm, SQInteger idx, SQInteger i,
+                        SQFloat &out) {
+  sq_pushinteger(vm, i);
+  if (SQ_FAILED(sq_rawget(vm, idx)))
+    return false;
+  bool ok = SQ_SUCCEEDED(sq_getfloat(vm, -1, &out));
+  sq_pop(vm, 1);
+  return ok;
+}
+
+static bool arrayInteger(HSQUIRRELVM vm, SQInteger idx, SQInteger i,
+                         SQInteger &out) {
+  sq_pushinteger(vm, i);
+  if (SQ_FAILED(sq_rawget(vm, idx)))
+    return false;
+  bool ok = SQ_SUCCEEDED(sq_getinteger(vm, -1, &out));
+  sq_pop(vm, 1);
+  return ok;
+}
+
+// Float32Buffer or blob contents in place, or numbers copied out of an array
+// into the binding arena. Null if the argument is none of these or an element
+// is not a number.
+static const f32 *readFloats(HSQUIRRELVM vm, SQInteger idx, SQInteger &count) {
+  BufferView buf;
+  if (getBuffer(vm, idx, buf)) {
+    if (buf.type != BufferType::Float32)
+      return nullptr;
+    count = buf.length;
+    return buf.floats();
+  }
+
+  SQObjectType type = sq_gettype(vm, idx);
+  if (type == OT_INSTANCE) {
+    SQUserPointer data = nullptr;
+    if (SQ_FAILED(sqstd_getblob(vm, idx, &data)))
+      return nullptr;
+    count = sqstd_getblobsize(vm, idx) / static_cast<SQInteger>(sizeof(f32));
+    return static_cast<const f32 *>(data);
+  }
+  if (type != OT_ARRAY)
+    return nullptr;
+
+  count = sq_getsize(vm, idx);
+  f32 *floats = bindingArena().allocArray<f32>(static_cast<size_t>(count));
+  for (SQInteger i = 0; i < count; ++i) {
+    SQFloat v;
+    if (!arrayNumber(vm, idx, i, v))
+      return nullptr;
+    floats[i] = v;
+  }
+  return floats;
+}
+
+// gfx.fillRects(rects [, colors]): rects is x,y,w,h per rect; colors (array
+// or Int32Buffer) holds one palette index/ARGB per rect, else the current
+// fill color is used
+static SQInteger gfx_fillRects(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 2 || top > 3)
+    return bindingArityError(vm, 1, 2);
+
+  FrameArena::Scope scratch(bindingArena());
+  SQInteger n = 0;
+  const f32 *rects = readFloats(vm, 2, n);
+  if (!rects)
+    return bindingTypeError(vm, 1, kBatchExpected);
+  if (n % 4 != 0)
+    return bindingTypeError(vm, 1, "a multiple of 4 numbers (x, y, w, h)");
+  u32 count = static_cast<u32>(n / 4);
+
+  static constexpr const char *kColorsExpected =
+      "an array or Int32Buffer with one color per rect";
+  const u32 *colors = nullptr;
+  BufferView colorBuf;
+  if (top == 3 && getBuffer(vm, 3, colorBuf)) {
+    if (colorBuf.type != BufferType::Int32 || colorBuf.length != n / 4)
+      return bindingTypeError(vm, 2, kColorsExpected);
+    u32 *resolved = bindingArena().allocArray<u32>(count);
+    for (u32 i = 0; i < count; ++i) {
+      resolved[i] = resolveColor(colorBuf.ints()[i]);
+    }
+    colors = resolved;
+  } else if (top == 3 && sq_gettype(vm, 3) != OT_NULL) {
+    if (sq_gettype(vm, 3) != OT_ARRAY || sq_getsize(vm, 3) != n / 4)
+      return bindingTypeError(vm, 2, kColorsExpected);
+    u32 *resolved = bindingArena().allocArray<u32>(count);
+    for (u32 i = 0; i < count; ++i) {
+      SQInteger color;
+      if (!arrayInteger(vm, 3, i, color))
+        return bindingTypeError(vm, 2, kColorsExpected);
+      resolved[i] = resolveColor(color);
+    }
+    colors = resolved;
+  }
+
+  if (g_canvas)
+    g_canvas->fillRects(rects, count, colors);
+  return 0;
+}
+
+// gfx.lines(segments): x0,y0,x1,y1 per segment, current stroke style
+static SQInteger gfx_lines(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+
+  FrameArena::Scope scratch(bindingArena());
+  SQInteger n = 0;
+  const f32 *segments = readFloats(vm, 2, n);
+  if (!segments)
+    return bindingTypeError(vm, 1, kBatchExpected);
+  if (n % 4 != 0)
+    return bindingTypeError(vm, 1, "a multiple of 4 numbers (x0, y0, x1, y1)");
+
+  if (g_canvas)
+    g_canvas->strokeLines(segments, static_cast<u32>(n / 4));
+  return 0;
+}
+
+// gfx.drawSprites(sprites): image,x,y per sprite as an array or
+// Float32Buffer, or 12-byte {i32 image, f32 x, f32 y} records in a ByteBuffer
+// or blob
+static SQInteger gfx_drawSprites(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+
+  FrameArena::Scope scratch(bindingArena());
+  const SpriteInstance *sprites = nullptr;
+  SQInteger count = 0;
+  SQObjectType type = sq_gettype(vm, 2);
+  BufferView buf;
+  if (getBuffer(vm, 2, buf)) {
+    if (buf.type == BufferType::Float32) {
+      if (buf.length % 3 != 0)
+        return bindingTypeError(vm, 1, "a multiple of 3 numbers (image, x, y)");
+      count = buf.length / 3;
+      SpriteInstance *copy =
+          bindingArena().allocArray<SpriteInstance>(static_cast<size_t>(count));
+      const f32 *src = buf.floats();
+      for (SQInteger i = 0; i < count; ++i, src += 3) {
+        // Converting NaN or an out-of-range float is undefined
+        if (!(src[0] >= 0.0f && src[0] < 4294967296.0f))
+          return bindingTypeError(vm, 1, "image ids from 0 to 4294967295");
+        copy[i] = {static_cast<u32>(src[0]), src[1], src[2]};
+      }
+      sprites = copy;
+    } else if (buf.type == BufferType::Byte &&
+               buf.length % static_cast<SQInteger>(sizeof(SpriteInstance)) ==
+                   0) {
+      sprites = static_cast<const SpriteInstance *>(buf.data);
+      count = buf.length / static_cast<SQInteger>(sizeof(SpriteInstance));
+    } else {
+      return bindingTypeError(vm, 1, "a ByteBuffer of 12-byte sprite records");
+    }
+  } else if (type == OT_INSTANCE) {
+    SQUserPointer data = nullptr;
+    if (SQ_FAILED(sqstd_getblob(vm, 2, &data)))
+      return bindingTypeError(vm, 1, kBatchExpected);
+    SQInteger size = sqstd_getblobsize(vm, 2);
+    if (size % static_cast<SQInteger>(sizeof(SpriteInstance)) != 0)
+      return bindingTypeError(vm, 1, "a blob of 12-byte sprite records");
+    sprites = static_cast<const SpriteInstance *>(data);
+    count = size / static_cast<SQInteger>(sizeof(SpriteInstance));
+  } else if (type == OT_ARRAY) {
+    SQInteger n = sq_getsize(vm, 2);
+    if (n % 3 != 0)
+      return bindingTypeError(vm, 1, "a multiple of 3 numbers (image, x, y)");
+    count = n / 3;
+    SpriteInstance *copy =
+        bindingArena().allocArray<SpriteInstance>(static_cast<size_t>(count));
+    for (SQInteger i = 0; i < count; ++i) {
+      SQInteger image;
+      SQFloat x, y;
+      if (!arrayInteger(vm, 2, i * 3, image) ||
+          !arrayNumber(vm, 2, i * 3 + 1, x) ||
+          !arrayNumber(vm, 2, i * 3 + 2, y)) {
+        return bindingTypeError(vm, 1, kBatchExpected);
+      }
+      copy[i] = {static_cast<u32>(image), x, y};
+    }
+    sprites = copy;
   } else {
-    sq_pushinteger(vm, 0);
+    return bindingTypeError(vm, 1, kBatchExpected);
   }
-  return 1;
+
+  if (g_canvas)
+    g_canvas->drawImages(sprites, static_cast<u32>(count));
+  return 0;
+}
+
+// ===== Images =====
+static SQInteger gfx_loadImage(const SQChar *path) {
+  return g_canvas ? g_canvas->loadImage(path) : 0;
 }
 
-static SQInteger gfx_freeImage(HSQUIRRELVM vm) {
-  SQInteger handle;
-  sq_getinteger(vm, 2, &handle);
+static void gfx_freeImage(SQInteger handle) {
   if (g_canvas)
     g_canvas->freeImage(static_cast<u32>(handle));
-  return 0;
 }
 
-static SQInteger gfx_drawImage(HSQUIRRELVM vm) {
-  SQInteger handle;
-  SQFloat x, y;
-  sq_getinteger(vm, 2, &handle);
-  sq_getfloat(vm, 3, &x);
-  sq_getfloat(vm, 4, &y);
+static void gfx_drawImage(SQInteger handle, SQFloat x, SQFloat y) {
   if (g_canvas)
     g_canvas->drawImage(static_cast<u32>(handle), x, y);
-  return 0;
 }
 
-// ===== Text =====
-static SQInteger gfx_loadFont(HSQUIRRELVM vm) {
-  const SQChar *path = nullptr;
-  SQInteger size;
-  sq_getstring(vm, 2, &path);
-  sq_getinteger(vm, 3, &size);
-  if (g_canvas && path) {
-    u32 handle = g_canvas->loadFont(path, static_cast<i32>(size));
-    sq_pushinteger(vm, handle);
-  } else {
-    sq_pushinteger(vm, 0);
+static void gfx_drawImageRect(SQInteger handle, SQInteger sx, SQInteger sy,
+                              SQInteger sw, SQInteger sh, SQFloat dx,
+                              SQFloat dy, SQFloat dw, SQFloat dh) {
+  if (g_canvas) {
+    g_canvas->drawImageRect(static_cast<u32>(handle), static_cast<i32>(sx),
+                            static_cast<i32>(sy), static_cast<i32>(sw),
+                            static_cast<i32>(sh), dx, dy, dw, dh);
   }
-  return 1;
 }
 
-static SQInteger gfx_freeFont(HSQUIRRELVM vm) {
-  SQInteger handle;
-  sq_getinteger(vm, 2, &handle);
+// ===== Text =====
+static SQInteger gfx_loadFont(const SQChar *path, SQInteger size) {
+  return g_canvas ? g_canvas->loadFont(path, static_cast<i32>(size)) : 0;
+}
+
+static void gfx_freeFont(SQInteger handle) {
   if (g_canvas)
     g_canvas->freeFont(static_cast<u32>(handle));
-  return 0;
 }
 
-static SQInteger gfx_setFont(HSQUIRRELVM vm) {
-  SQInteger handle;
-  sq_getinteger(vm, 2, &handle);
+static void gfx_setFont(SQInteger handle) {
   if (g_canvas)
     g_canvas->setFont(static_cast<u32>(handle));
-  return 0;
 }
 
-static SQInteger gfx_fillText(HSQUIRRELVM vm) {
-  const SQChar *text = nullptr;
-  SQFloat x, y;
-  sq_getstring(vm, 2, &text);
-  sq_getfloat(vm, 3, &x);
-  sq_getfloat(vm, 4, &y);
-  if (g_canvas && text)
+static void gfx_fillText(const SQChar *text, SQFloat x, SQFloat y) {
+  if (g_canvas)
     g_canvas->fillText(text, x, y);
-  return 0;
 }
 
 // ===== Gradients =====
-static SQInteger gfx_createLinearGradient(HSQUIRRELVM vm) {
-  SQFloat x1, y1, x2, y2;
-  sq_getfloat(vm, 2, &x1);
-  sq_getfloat(vm, 3, &y1);
-  sq_getfloat(vm, 4, &x2);
-  sq_getfloat(vm, 5, &y2);
-  if (g_canvas) {
-    u32 handle = g_canvas->createLinearGradient(x1, y1, x2, y2);
-    sq_pushinteger(vm, handle);
-  } else {
-    sq_pushinteger(vm, 0);
-  }
-  return 1;
+static SQInteger gfx_createLinearGradient(SQFloat x1, SQFloat y1, SQFloat x2,
+                                          SQFloat y2) {
+  return g_canvas ? g_canvas->createLinearGradient(x1, y1, x2, y2) : 0;
 }
 
-static SQInteger gfx_createRadialGradient(HSQUIRRELVM vm) {
-  SQFloat cx, cy, r;
-  sq_getfloat(vm, 2, &cx);
-  sq_getfloat(vm, 3, &cy);
-  sq_getfloat(vm, 4, &r);
-  if (g_canvas) {
-    u32 handle = g_canvas->createRadialGradient(cx, cy, r);
-    sq_pushinteger(vm, handle);
-  } else {
-    sq_pushinteger(vm, 0);
-  }
-  return 1;
+static SQInteger gfx_createRadialGradient(SQFloat cx, SQFloat cy, SQFloat r) {
+  return g_canvas ? g_canvas->createRadialGradient(cx, cy, r) : 0;
 }
 
-static SQInteger gfx_freePaint(HSQUIRRELVM vm) {
-  SQInteger handle;
-  sq_getinteger(vm, 2, &handle);
+static void gfx_freePaint(SQInteger handle) {
   if (g_canvas)
     g_canvas->freePaint(static_cast<u32>(handle));
-  return 0;
 }
 
-static SQInteger gfx_setFillPaint(HSQUIRRELVM vm) {
-  SQInteger handle;
-  sq_getinteger(vm, 2, &handle);
+static void gfx_setFillPaint(SQInteger handle) {
   if (g_canvas)
     g_canvas->setFillPaint(static_cast<u32>(handle));
-  return 0;
 }
 
-static SQInteger gfx_setStrokePaint(HSQUIRRELVM vm) {
-  SQInteger handle;
-  sq_getinteger(vm, 2, &handle);
+static void gfx_setStrokePaint(SQInteger handle) {
   if (g_canvas)
     g_canvas->setStrokePaint(static_cast<u32>(handle));
-  return 0;
 }
 
 // ===== Blend Modes =====
-static SQInteger gfx_setBlend(HSQUIRRELVM vm) {
-  const SQChar *mode = nullptr;
-  sq_getstring(vm, 2, &mode);
-  if (g_canvas && mode) {
-    SQBool result = g_canvas->setBlend(mode) ? SQTrue : SQFalse;
-    sq_pushbool(vm, result);
-  } else {
-    sq_pushbool(vm, SQFalse);
-  }
-  return 1;
+static bool gfx_setBlend(const SQChar *mode) {
+  return g_canvas && g_canvas->setBlend(mode);
 }
 
 // ===== Registration =====
+static constexpr NativeFunction kGfxFunctions[] = {
+    // Clearing
+    {"clear", NativeCall<gfx_clear>},
+
+    // State stack
+    {"save", NativeCall<gfx_save>},
+    {"restore", NativeCall<gfx_restore>},
+
+    // Transforms
+    {"resetTransform", NativeCall<gfx_resetTransform>},
+    {"translate", NativeCall<gfx_translate>},
+    {"rotate", NativeCall<gfx_rotate>},
+    {"scale", NativeCall<gfx_scale>},
+
+    // Styles
+    {"setFillColor", NativeCall<gfx_setFillColor>},
+    {"setStrokeColor", NativeCall<gfx_setStrokeColor>},
+    {"setLineWidth", NativeCall<gfx_setLineWidth>},
+    {"setGlobalAlpha", NativeCall<gfx_setGlobalAlpha>},
+
+    // Paths
+    {"beginPath", NativeCall<gfx_beginPath>},
+    {"closePath", NativeCall<gfx_closePath>},
+    {"moveTo", NativeCall<gfx_moveTo>},
+    {"lineTo", NativeCall<gfx_lineTo>},
+    {"rect", NativeCall<gfx_rect>},
+
+    // Drawing
+    {"fill", NativeCall<gfx_fill>},
+    {"stroke", NativeCall<gfx_stroke>},
+    {"fillRect", NativeCall<gfx_fillRect>},
+    {"strokeRect", NativeCall<gfx_strokeRect>},
+    {"getTargetSize", gfx_getTargetSize},
+
+    // Batches
+    {"fillRects", gfx_fillRects},
+    {"lines", gfx_lines},
+    {"drawSprites", gfx_drawSprites},
+
+    // Images
+    {"loadImage", NativeCall<gfx_loadImage>},
+    {"freeImage", NativeCall<gfx_freeImage>},
+    {"drawImage", NativeCall<gfx_drawImage>},
+    {"drawImageRect", NativeCall<gfx_drawImageRect>},
+
+    // Text
+    {"loadFont", NativeCall<gfx_loadFont>},
+    {"freeFont", NativeCall<gfx_freeFont>},
+    {"setFont", NativeCall<gfx_setFont>},
+    {"fillText", NativeCall<gfx_fillText>},
+
+    // Gradients
+    {"createLinearGradient", NativeCall<gfx_createLinearGradient>},
+    {"createRadialGradient", NativeCall<gfx_createRadialGradient>},
+    {"freePaint", NativeCall<gfx_freePaint>},
+    {"setFillPaint", NativeCall<gfx_setFillPaint>},
+    {"setStrokePaint", NativeCall<gfx_setStrokePaint>},
+
+    // Blend modes
+    {"setBlend", NativeCall<gfx_setBlend>},
+};
+
 void registerGfxBinding(HSQUIRRELVM vm) {
-  // Create gfx table
-  sq_pushroottable(vm);
-  sq_pushstring(vm, "gfx", -1);
-  sq_newtable(vm);
-
-  // Clearing
-  sq_pushstring(vm, "clear", -1);
-  sq_newclosure(vm, gfx_clear, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // State stack
-  sq_pushstring(vm, "save", -1);
-  sq_newclosure(vm, gfx_save, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "restore", -1);
-  sq_newclosure(vm, gfx_restore, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Transforms
-  sq_pushstring(vm, "resetTransform", -1);
-  sq_newclosure(vm, gfx_resetTransform, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "translate", -1);
-  sq_newclosure(vm, gfx_translate, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "rotate", -1);
-  sq_newclosure(vm, gfx_rotate, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "scale", -1);
-  sq_newclosure(vm, gfx_scale, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Styles
-  sq_pushstring(vm, "setFillColor", -1);
-  sq_newclosure(vm, gfx_setFillColor, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "setStrokeColor", -1);
-  sq_newclosure(vm, gfx_setStrokeColor, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "setLineWidth", -1);
-  sq_newclosure(vm, gfx_setLineWidth, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "setGlobalAlpha", -1);
-  sq_newclosure(vm, gfx_setGlobalAlpha, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Paths
-  sq_pushstring(vm, "beginPath", -1);
-  sq_newclosure(vm, gfx_beginPath, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "closePath", -1);
-  sq_newclosure(vm, gfx_closePath, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "moveTo", -1);
-  sq_newclosure(vm, gfx_moveTo, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "lineTo", -1);
-  sq_newclosure(vm, gfx_lineTo, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "rect", -1);
-  sq_newclosure(vm, gfx_rect, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Drawing
-  sq_pushstring(vm, "fill", -1);
-  sq_newclosure(vm, gfx_fill, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "stroke", -1);
-  sq_newclosure(vm, gfx_stroke, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "fillRect", -1);
-  sq_newclosure(vm, gfx_fillRect, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "strokeRect", -1);
-  sq_newclosure(vm, gfx_strokeRect, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "getTargetSize", -1);
-  sq_newclosure(vm, gfx_getTargetSize, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Images
-  sq_pushstring(vm, "loadImage", -1);
-  sq_newclosure(vm, gfx_loadImage, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "freeImage", -1);
-  sq_newclosure(vm, gfx_freeImage, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "drawImage", -1);
-  sq_newclosure(vm, gfx_drawImage, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Text
-  sq_pushstring(vm, "loadFont", -1);
-  sq_newclosure(vm, gfx_loadFont, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "freeFont", -1);
-  sq_newclosure(vm, gfx_freeFont, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "setFont", -1);
-  sq_newclosure(vm, gfx_setFont, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "fillText", -1);
-  sq_newclosure(vm, gfx_fillText, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Gradients
-  sq_pushstring(vm, "createLinearGradient", -1);
-  sq_newclosure(vm, gfx_createLinearGradient, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "createRadialGradient", -1);
-  sq_newclosure(vm, gfx_createRadialGradient, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "freePaint", -1);
-  sq_newclosure(vm, gfx_freePaint, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "setFillPaint", -1);
-  sq_newclosure(vm, gfx_setFillPaint, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  sq_pushstring(vm, "setStrokePaint", -1);
-  sq_newclosure(vm, gfx_setStrokePaint, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Blend modes
-  sq_pushstring(vm, "setBlend", -1);
-  sq_newclosure(vm, gfx_setBlend, 0);
-  sq_newslot(vm, -3, SQFalse);
-
-  // Add gfx table to root
-  sq_newslot(vm, -3, SQFalse);
-  sq_pop(vm, 1);
+  BindTable(vm, "gfx", kGfxFunctions);
 }
 
 } // namespace arcanee::script
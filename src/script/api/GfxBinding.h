@@ -14,6 +14,11 @@ namespace arcanee::script {
 void setGfxCanvas(render::Canvas2D *canvas);
 void setGfxPalette(const std::vector<u32> *palette);
 
+// For other natives drawing on the same canvas (null when headless)
+render::Canvas2D *getGfxCanvas();
+// Palette index or raw ARGB, as gfx.* color arguments are resolved
+u32 resolveGfxColor(SQInteger color);
+
 /**
  * @brief Register the gfx.* table for 2D canvas API.
  * @ref specs/Chapter 6 §6.3
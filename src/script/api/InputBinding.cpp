@@ -2,6 +2,7 @@
 #include "app/Runtime.h"
 #include "common/Log.h"
 #include "input/InputManager.h"
+#include "script/BindingUtils.h"
 
 namespace arcanee::script {
 
@@ -16,101 +17,52 @@ static input::InputManager *getInputManager() {
 }
 
 // inp.btn(scancode)
-static SQInteger inp_btn(HSQUIRRELVM vm) {
-  SQInteger scancode;
-  if (SQ_FAILED(sq_getinteger(vm, 2, &scancode)))
-    return sq_throwerror(vm, "Invalid argument");
-
-  if (auto *mgr = getInputManager()) {
-    sq_pushbool(vm, mgr->isKeyDown((int)scancode) ? SQTrue : SQFalse);
-    return 1;
-  }
-  sq_pushbool(vm, SQFalse);
-  return 1;
+static bool inp_btn(SQInteger scancode) {
+  auto *mgr = getInputManager();
+  return mgr && mgr->isKeyDown((int)scancode);
 }
 
 // inp.btnp(scancode)
-static SQInteger inp_btnp(HSQUIRRELVM vm) {
-  SQInteger scancode;
-  if (SQ_FAILED(sq_getinteger(vm, 2, &scancode)))
-    return sq_throwerror(vm, "Invalid argument");
-
-  if (auto *mgr = getInputManager()) {
-    sq_pushbool(vm, mgr->isKeyPressed((int)scancode) ? SQTrue : SQFalse);
-    return 1;
-  }
-  sq_pushbool(vm, SQFalse);
-  return 1;
+static bool inp_btnp(SQInteger scancode) {
+  auto *mgr = getInputManager();
+  return mgr && mgr->isKeyPressed((int)scancode);
 }
 
 // inp.mouse_x()
-static SQInteger inp_mouse_x(HSQUIRRELVM vm) {
-  if (auto *mgr = getInputManager()) {
-    sq_pushinteger(vm, mgr->getCurrentSnapshot().mouse.x);
-    return 1;
-  }
-  sq_pushinteger(vm, -1);
-  return 1;
+static SQInteger inp_mouse_x() {
+  auto *mgr = getInputManager();
+  return mgr ? mgr->getCurrentSnapshot().mouse.x : -1;
 }
 
 // inp.mouse_y()
-static SQInteger inp_mouse_y(HSQUIRRELVM vm) {
-  if (auto *mgr = getInputManager()) {
-    sq_pushinteger(vm, mgr->getCurrentSnapshot().mouse.y);
-    return 1;
-  }
-  sq_pushinteger(vm, -1);
-  return 1;
+static SQInteger inp_mouse_y() {
+  auto *mgr = getInputManager();
+  return mgr ? mgr->getCurrentSnapshot().mouse.y : -1;
 }
 
 // inp.mouse_btn(btn)
-static SQInteger inp_mouse_btn(HSQUIRRELVM vm) {
-  SQInteger btn;
-  if (SQ_FAILED(sq_getinteger(vm, 2, &btn)))
-    return sq_throwerror(vm, "Invalid argument");
-
-  if (auto *mgr = getInputManager()) {
-    sq_pushbool(vm, mgr->isMouseButtonDown((int)btn) ? SQTrue : SQFalse);
-    return 1;
-  }
-  sq_pushbool(vm, SQFalse);
-  return 1;
+static bool inp_mouse_btn(SQInteger btn) {
+  auto *mgr = getInputManager();
+  return mgr && mgr->isMouseButtonDown((int)btn);
 }
 
 // inp.mouse_btnp(btn)
-static SQInteger inp_mouse_btnp(HSQUIRRELVM vm) {
-  SQInteger btn;
-  if (SQ_FAILED(sq_getinteger(vm, 2, &btn)))
-    return sq_throwerror(vm, "Invalid argument");
-
-  if (auto *mgr = getInputManager()) {
-    sq_pushbool(vm, mgr->isMouseButtonPressed((int)btn) ? SQTrue : SQFalse);
-    return 1;
-  }
-  sq_pushbool(vm, SQFalse);
-  return 1;
+static bool inp_mouse_btnp(SQInteger btn) {
+  auto *mgr = getInputManager();
+  return mgr && mgr->isMouseButtonPressed((int)btn);
 }
 
-void registerInputBinding(HSQUIRRELVM vm) {
-  sq_pushroottable(vm);
-  sq_pushstring(vm, "inp", -1);
-  sq_newtable(vm);
-
-  auto registerFunc = [&](const char *name, SQFUNCTION func) {
-    sq_pushstring(vm, name, -1);
-    sq_newclosure(vm, func, 0);
-    sq_newslot(vm, -3, SQFalse);
-  };
+static constexpr NativeFunction kInputFunctions[] = {
+    {"btn", NativeCall<inp_btn>},
+    {"btnp", NativeCall<inp_btnp>},
+    {"mouse_x", NativeCall<inp_mouse_x>},
+    {"mouse_y", NativeCall<inp_mouse_y>},
+    {"mouse_btn", NativeCall<inp_mouse_btn>},
+    {"mouse_btnp", NativeCall<inp_mouse_btnp>},
+};
 
-  registerFunc("btn", inp_btn);
-  registerFunc("btnp", inp_btnp);
-  registerFunc("mouse_x", inp_mouse_x);
-  registerFunc("mouse_y", inp_mouse_y);
-  registerFunc("mouse_btn", inp_mouse_btn);
-  registerFunc("mouse_btnp", inp_mouse_btnp);
-
-  sq_newslot(vm, -3, SQFalse);
-  sq_pop(vm, 1); // root
+void registerInputBinding(HSQUIRRELVM vm) {
+  BindTable(vm, "inp", kInputFunctions);
 }
 
 } // namespace arcanee::script
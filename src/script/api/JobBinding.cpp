@@ -0,0 +1,217 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file JobBinding.cpp
+ * @brief Parallel script jobs (jobs.*) on top of WorkerPool.
+ *
+ * Arguments and results are copied through ValueCodec, so only plain data
+ * (numbers, strings, arrays, tables, buffers, math values) crosses between
+ * the cart VM and the workers.
+ */
+
+#include "JobBinding.h"
+#include "common/ByteStream.h"
+#include "common/Log.h"
+#include "script/BindingUtils.h"
+#include "script/ValueCodec.h"
+#include "script/WorkerPool.h"
+#include <string>
+#include <vector>
+
+namespace arcanee::script {
+
+namespace {
+
+constexpr const SQChar *kPoolKey = "arcanee.jobs";
+
+// Longest a single native wait blocks before control returns to the VM
+constexpr f64 kWaitSliceSec = 0.01;
+
+// jobs.wait() loops in script so the hang watchdog, which only interrupts
+// at backward jumps and script calls, can stop a cart waiting on slow jobs
+constexpr const SQChar kWaitSource[] =
+    "return function(pendingfn, slicefn) {"
+    "  return function() {"
+    "    while (pendingfn() > 0) {"
+    "      local r = slicefn();"
+    "      if (r != null) return r;"
+    "    }"
+    "    return null;"
+    "  }"
+    "}";
+
+WorkerPool *poolOf(HSQUIRRELVM vm) {
+  SQUserPointer p = nullptr;
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kPoolKey, -1);
+  if (SQ_SUCCEEDED(sq_rawget(vm, -2))) {
+    sq_getuserpointer(vm, -1, &p);
+    sq_pop(vm, 1);
+  }
+  sq_pop(vm, 1);
+  return static_cast<WorkerPool *>(p);
+}
+
+void setSlot(HSQUIRRELVM vm, const SQChar *key) {
+  sq_pushstring(vm, key, -1);
+  sq_push(vm, -2);
+  sq_remove(vm, -3);
+  sq_rawset(vm, -3);
+}
+
+// Pushes {id, ok, result} or {id, ok, error}
+void pushResult(HSQUIRRELVM vm, const JobResult &job) {
+  sq_newtable(vm);
+  sq_pushinteger(vm, static_cast<SQInteger>(job.id));
+  setSlot(vm, "id");
+
+  Status status = job.status;
+  if (status.ok()) {
+    ByteReader reader(job.value.data(), job.value.size());
+    status = decodeValue(vm, reader);
+    if (status.ok())
+      setSlot(vm, "result");
+  }
+  sq_pushbool(vm, status.ok() ? SQTrue : SQFalse);
+  setSlot(vm, "ok");
+  if (!status.ok()) {
+    sq_pushstring(vm, status.message().c_str(), -1);
+    setSlot(vm, "error");
+  }
+}
+
+// ===== jobs.* =====
+
+// jobs.submit(module, args...) -> job id, or null
+SQInteger jobs_submit(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 2) {
+    setLastError(vm, "jobs.submit: expected a module path");
+    sq_pushnull(vm);
+    return 1;
+  }
+  const SQChar *module = nullptr;
+  if (SQ_FAILED(sq_getstring(vm, 2, &module)))
+    return bindingTypeError(vm, 1, "a string");
+
+  WorkerPool *pool = poolOf(vm);
+  if (!pool) {
+    setLastError(vm, "jobs.submit: worker pool is not initialized");
+    sq_pushnull(vm);
+    return 1;
+  }
+
+  // The arguments travel as one array
+  sq_newarray(vm, 0);
+  for (SQInteger i = 3; i <= top; ++i) {
+    sq_push(vm, i);
+    sq_arrayappend(vm, -2);
+  }
+  std::vector<u8> args;
+  Status status = encodeValue(vm, -1, args, pool->maxValueBytes());
+  sq_pop(vm, 1);
+
+  StatusOr<u64> id = status.ok() ? pool->submit(module, std::move(args))
+                                 : StatusOr<u64>(status);
+  if (!id.ok()) {
+    setLastError(vm, "jobs.submit: " + id.status().message());
+    sq_pushnull(vm);
+    return 1;
+  }
+  sq_pushinteger(vm, static_cast<SQInteger>(id.value()));
+  return 1;
+}
+
+// jobs.poll() -> next result in submission order, or null if not ready
+SQInteger jobs_poll(HSQUIRRELVM vm) {
+  WorkerPool *pool = poolOf(vm);
+  JobResult result;
+  if (pool && pool->poll(result))
+    pushResult(vm, result);
+  else
+    sq_pushnull(vm);
+  return 1;
+}
+
+// Waits one slice for the next result; null if it is not ready yet
+SQInteger jobs_waitSlice(HSQUIRRELVM vm) {
+  WorkerPool *pool = poolOf(vm);
+  JobResult result;
+  if (pool && pool->wait(result, kWaitSliceSec))
+    pushResult(vm, result);
+  else
+    sq_pushnull(vm);
+  return 1;
+}
+
+// jobs.pending() -> jobs whose results have not been taken yet
+SQInteger jobs_pending(HSQUIRRELVM vm) {
+  WorkerPool *pool = poolOf(vm);
+  sq_pushinteger(vm, pool ? static_cast<SQInteger>(pool->pending()) : 0);
+  return 1;
+}
+
+// jobs.workers() -> number of worker VMs
+SQInteger jobs_workers(HSQUIRRELVM vm) {
+  WorkerPool *pool = poolOf(vm);
+  sq_pushinteger(vm, pool ? static_cast<SQInteger>(pool->workerCount()) : 0);
+  return 1;
+}
+
+constexpr NativeFunction kJobFunctions[] = {
+    {"submit", jobs_submit},
+    {"poll", jobs_poll},
+    {"pending", jobs_pending},
+    {"workers", jobs_workers},
+};
+
+// Adds jobs.wait() -> next result in submission order; null if none is
+// pending
+void bindWait(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  sq_pushroottable(vm);
+  sq_pushstring(vm, "jobs", -1);
+  bool ok = SQ_SUCCEEDED(sq_rawget(vm, -2));
+  if (ok) {
+    sq_pushstring(vm, "wait", -1);
+    ok = SQ_SUCCEEDED(sq_compilebuffer(
+        vm, kWaitSource, sizeof(kWaitSource) - 1, "jobs.wait", SQFalse));
+  }
+  if (ok) {
+    sq_pushroottable(vm);
+    ok = SQ_SUCCEEDED(sq_call(vm, 1, SQTrue, SQFalse));
+  }
+  if (ok) {
+    sq_pushroottable(vm);
+    sq_newclosure(vm, jobs_pending, 0);
+    sq_setnativeclosurename(vm, -1, "jobs.pending");
+    sq_newclosure(vm, jobs_waitSlice, 0);
+    sq_setnativeclosurename(vm, -1, "jobs.wait");
+    ok = SQ_SUCCEEDED(sq_call(vm, 3, SQTrue, SQFalse));
+  }
+  if (ok) {
+    sq_remove(vm, -2); // factory
+    sq_remove(vm, -2); // compiled chunk
+    sq_newslot(vm, -3, SQFalse);
+  } else {
+    LOG_ERROR("jobs: failed to build jobs.wait");
+  }
+  sq_settop(vm, top);
+}
+
+} // namespace
+
+void registerJobBinding(HSQUIRRELVM vm, WorkerPool *pool) {
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kPoolKey, -1);
+  sq_pushuserpointer(vm, pool);
+  sq_newslot(vm, -3, SQFalse);
+  sq_pop(vm, 1);
+
+  BindTable(vm, "jobs", kJobFunctions);
+  bindWait(vm);
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <squirrel.h>
+
+namespace arcanee::script {
+
+class WorkerPool;
+
+/**
+ * @brief Register the jobs.* functions (submit, poll, wait, pending,
+ * workers), all driving @p pool.
+ *
+ * jobs.submit(module, args...) runs the function @p module returns on a
+ * worker VM and returns a job id. Results come back from jobs.poll() or
+ * jobs.wait() as {id, ok, result | error}, in submission order.
+ */
+void registerJobBinding(HSQUIRRELVM vm, WorkerPool *pool);
+
+} // namespace arcanee::script
@@ -0,0 +1,170 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file JsonBinding.cpp
+ * @brief JSON documents (json.*) on top of JsonCodec.
+ *
+ * Level and dialog data is parsed natively instead of character by
+ * character in script.
+ */
+
+#include "JsonBinding.h"
+#include "script/BindingUtils.h"
+#include "script/JsonCodec.h"
+#include "script/ScriptEngine.h"
+#include "script/api/BufferBinding.h"
+#include "vfs/Vfs.h"
+#include <cstdio>
+#include <cstring>
+#include <sqstdblob.h>
+#include <string>
+
+namespace arcanee::script {
+
+namespace {
+
+constexpr SQInteger kMaxIndent = 16;
+
+// Pushes the parsed document, or null with the last error set
+SQInteger pushParsed(HSQUIRRELVM vm, const char *fn, const char *text,
+                     size_t size) {
+  Status status = parseJson(vm, text, size);
+  if (!status.ok()) {
+    setLastError(vm, std::string(fn) + ": " + status.message());
+    sq_pushnull(vm);
+  }
+  return 1;
+}
+
+// Applies the fields of the table at @p idx (absolute) over @p options.
+// Sets @p bad to the offending key on failure.
+bool readOptions(HSQUIRRELVM vm, SQInteger idx, JsonWriteOptions &options,
+                 const SQChar *&bad) {
+  bad = "";
+  if (sq_gettype(vm, idx) != OT_TABLE)
+    return false;
+
+  sq_pushnull(vm);
+  while (SQ_SUCCEEDED(sq_next(vm, idx))) {
+    const SQChar *key = "";
+    bool ok = SQ_SUCCEEDED(sq_getstring(vm, -2, &key));
+    if (!ok) {
+      key = "";
+    } else if (std::strcmp(key, "indent") == 0) {
+      SQInteger n = 0;
+      ok = SQ_SUCCEEDED(sq_getinteger(vm, -1, &n)) && n >= 0 &&
+           n <= kMaxIndent;
+      options.indent = static_cast<u32>(n);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      bad = key;
+      sq_pop(vm, 3); // Key, value, iterator
+      return false;
+    }
+    sq_pop(vm, 2);
+  }
+  sq_pop(vm, 1);
+  return true;
+}
+
+// ===== json.* =====
+
+// json.parse(text) -> value; text is a string, ByteBuffer or blob. Null, with
+// the last error set, if the text is not JSON
+SQInteger json_parse(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+
+  const SQChar *s = nullptr;
+  SQInteger len = 0;
+  BufferView buf;
+  SQUserPointer blob = nullptr;
+  if (SQ_SUCCEEDED(sq_getstringandsize(vm, 2, &s, &len)))
+    return pushParsed(vm, "json.parse", s, static_cast<size_t>(len));
+  if (getBuffer(vm, 2, buf) && buf.type == BufferType::Byte) {
+    return pushParsed(vm, "json.parse",
+                      reinterpret_cast<const char *>(buf.bytes()),
+                      buf.byteSize());
+  }
+  if (sq_gettype(vm, 2) == OT_INSTANCE &&
+      SQ_SUCCEEDED(sqstd_getblob(vm, 2, &blob))) {
+    return pushParsed(vm, "json.parse", static_cast<const char *>(blob),
+                      static_cast<size_t>(sqstd_getblobsize(vm, 2)));
+  }
+  return bindingTypeError(vm, 1, "a string, ByteBuffer or blob");
+}
+
+// json.stringify(value [, settings]) -> string, or null
+SQInteger json_stringify(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 2 || top > 3)
+    return bindingArityError(vm, 1, 2);
+
+  JsonWriteOptions options;
+  const SQChar *bad = "";
+  if (top == 3 && sq_gettype(vm, 3) != OT_NULL &&
+      !readOptions(vm, 3, options, bad)) {
+    char expected[128];
+    if (*bad) {
+      snprintf(expected, sizeof(expected),
+               "a settings table (bad or unknown field '%s')", bad);
+    } else {
+      snprintf(expected, sizeof(expected), "a settings table");
+    }
+    return bindingTypeError(vm, 2, expected);
+  }
+
+  std::string text;
+  Status status = writeJson(vm, 2, options, text);
+  if (!status.ok()) {
+    setLastError(vm, "json.stringify: " + status.message());
+    sq_pushnull(vm);
+    return 1;
+  }
+  sq_pushstring(vm, text.data(), static_cast<SQInteger>(text.size()));
+  return 1;
+}
+
+// json.load(path) -> value of the JSON file, or null
+SQInteger json_load(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  const SQChar *path = nullptr;
+  if (SQ_FAILED(sq_getstring(vm, 2, &path)))
+    return bindingTypeError(vm, 1, "a path string");
+
+  auto *engine = static_cast<ScriptEngine *>(sq_getforeignptr(vm));
+  vfs::IVfs *vfs = engine ? engine->getVfs() : nullptr;
+  if (!vfs) {
+    setLastError(vm, "json.load: VFS not initialized");
+    sq_pushnull(vm);
+    return 1;
+  }
+  auto bytes = vfs->readBytes(path);
+  if (!bytes) {
+    setLastError(vm, std::string("json.load: cannot read ") + path);
+    sq_pushnull(vm);
+    return 1;
+  }
+  return pushParsed(vm, "json.load",
+                    reinterpret_cast<const char *>(bytes->data()),
+                    bytes->size());
+}
+
+constexpr NativeFunction kJsonFunctions[] = {
+    {"parse", json_parse},
+    {"stringify", json_stringify},
+    {"load", json_load},
+};
+
+} // namespace
+
+void registerJsonBinding(HSQUIRRELVM vm) {
+  BindTable(vm, "json", kJsonFunctions);
+}
+
+} // namespace arcanee::script
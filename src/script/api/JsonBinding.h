@@ -0,0 +1,15 @@
+#pragma once
+
+#include <squirrel.h>
+
+namespace arcanee::script {
+
+/**
+ * @brief Register the json.* functions (parse, stringify, load).
+ *
+ * Documents become tables and arrays in one native pass; load parses a VFS
+ * file in place, without first making it a script string.
+ */
+void registerJsonBinding(HSQUIRRELVM vm);
+
+} // namespace arcanee::script
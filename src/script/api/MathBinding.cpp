@@ -0,0 +1,992 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file MathBinding.cpp
+ * @brief Native vec2/vec3/vec4/quat/mat3 value types (math.*).
+ *
+ * Values are small userdata with a per-type delegate, so `a + b` is one
+ * native call and one refcounted allocation instead of a table or class
+ * instance for the GC to trace. The *In methods update the receiver and
+ * allocate nothing; the math.* bulk functions run over Float32Buffers.
+ */
+
+#include "MathBinding.h"
+#include "script/BindingUtils.h"
+#include "script/api/BufferBinding.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+namespace arcanee::script {
+
+namespace {
+
+constexpr int kTypeCount = 5;
+constexpr u32 kDims[kTypeCount] = {2, 3, 4, 4, 9};
+constexpr const SQChar *kTypeNames[kTypeCount] = {"vec2", "vec3", "vec4",
+                                                  "quat", "mat3"};
+constexpr const SQChar *kDelegateKeys[kTypeCount] = {
+    "arcanee.vec2", "arcanee.vec3", "arcanee.vec4", "arcanee.quat",
+    "arcanee.mat3"};
+
+// Address of each entry identifies the userdata type (sq_settypetag)
+const int kTags[kTypeCount] = {};
+
+constexpr int typeIndex(MathType type) { return static_cast<int>(type); }
+constexpr u32 dimOf(MathType type) { return kDims[typeIndex(type)]; }
+
+SQUserPointer tagOf(MathType type) {
+  return const_cast<SQUserPointer>(
+      static_cast<const void *>(&kTags[typeIndex(type)]));
+}
+
+// New value sharing the delegate of the same-typed value at likeIdx; avoids
+// the registry lookup pushMath needs
+f32 *pushLike(HSQUIRRELVM vm, MathType type, SQInteger likeIdx) {
+  auto *p = static_cast<f32 *>(sq_newuserdata(vm, dimOf(type) * sizeof(f32)));
+  sq_settypetag(vm, -1, tagOf(type));
+  sq_getdelegate(vm, likeIdx);
+  sq_setdelegate(vm, -2);
+  return p;
+}
+
+bool getNumber(HSQUIRRELVM vm, SQInteger idx, f32 &out) {
+  SQFloat v;
+  if (SQ_FAILED(sq_getfloat(vm, idx, &v)))
+    return false;
+  out = v;
+  return true;
+}
+
+// Component for .x/.y/.z/.w (vectors and quat only) or [i]; -1 if neither
+SQInteger componentIndex(HSQUIRRELVM vm, MathType type) {
+  u32 dim = dimOf(type);
+  if (sq_gettype(vm, 2) == OT_INTEGER) {
+    SQInteger i;
+    sq_getinteger(vm, 2, &i);
+    return (i >= 0 && i < static_cast<SQInteger>(dim)) ? i : -1;
+  }
+  if (type == MathType::Mat3 || sq_gettype(vm, 2) != OT_STRING)
+    return -1;
+  const SQChar *s;
+  sq_getstring(vm, 2, &s);
+  if (s[0] == 0 || s[1] != 0)
+    return -1;
+  SQInteger i = s[0] == 'x' ? 0 : s[0] == 'y' ? 1 : s[0] == 'z' ? 2
+              : s[0] == 'w' ? 3 : -1;
+  return i < static_cast<SQInteger>(dim) ? i : -1;
+}
+
+SQInteger badThis(HSQUIRRELVM vm, MathType type) {
+  return sq_throwerror(
+      vm, (std::string("this must be a ") + kTypeNames[typeIndex(type)])
+              .c_str());
+}
+
+SQInteger badOperand(HSQUIRRELVM vm, MathType type, const char *expected) {
+  return sq_throwerror(vm, (std::string(kTypeNames[typeIndex(type)]) +
+                            " operator expects " + expected)
+                               .c_str());
+}
+
+// ===== Kernels =====
+
+void mat3Mul(const f32 *a, const f32 *b, f32 *out) {
+  f32 r[9];
+  for (int row = 0; row < 3; ++row) {
+    for (int col = 0; col < 3; ++col) {
+      r[row * 3 + col] = a[row * 3] * b[col] + a[row * 3 + 1] * b[3 + col] +
+                         a[row * 3 + 2] * b[6 + col];
+    }
+  }
+  std::memcpy(out, r, sizeof(r));
+}
+
+void mat3Identity(f32 *m) {
+  static constexpr f32 kIdentity[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  std::memcpy(m, kIdentity, sizeof(kIdentity));
+}
+
+f32 mat3Det(const f32 *m) {
+  return m[0] * (m[4] * m[8] - m[5] * m[7]) -
+         m[1] * (m[3] * m[8] - m[5] * m[6]) +
+         m[2] * (m[3] * m[7] - m[4] * m[6]);
+}
+
+// v' = v + w*t + q.xyz x t, with t = 2 * (q.xyz x v)
+void quatRotate(const f32 *q, const f32 *v, f32 *out) {
+  f32 tx = 2.0f * (q[1] * v[2] - q[2] * v[1]);
+  f32 ty = 2.0f * (q[2] * v[0] - q[0] * v[2]);
+  f32 tz = 2.0f * (q[0] * v[1] - q[1] * v[0]);
+  f32 x = v[0] + q[3] * tx + (q[1] * tz - q[2] * ty);
+  f32 y = v[1] + q[3] * ty + (q[2] * tx - q[0] * tz);
+  f32 z = v[2] + q[3] * tz + (q[0] * ty - q[1] * tx);
+  out[0] = x;
+  out[1] = y;
+  out[2] = z;
+}
+
+void quatMul(const f32 *a, const f32 *b, f32 *out) {
+  f32 x = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1];
+  f32 y = a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0];
+  f32 z = a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3];
+  f32 w = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2];
+  out[0] = x;
+  out[1] = y;
+  out[2] = z;
+  out[3] = w;
+}
+
+f32 dot(const f32 *a, const f32 *b, u32 n) {
+  f32 d = 0.0f;
+  for (u32 i = 0; i < n; ++i)
+    d += a[i] * b[i];
+  return d;
+}
+
+void normalize(f32 *v, u32 n) {
+  f32 len = std::sqrt(dot(v, v, n));
+  if (len > 0.0f) {
+    for (u32 i = 0; i < n; ++i)
+      v[i] /= len;
+  }
+}
+
+// ===== Shared by every type =====
+
+template <MathType T> SQInteger math_get(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  SQInteger i = a ? componentIndex(vm, T) : -1;
+  if (i < 0) {
+    // Clean "not found" so unknown member lookups report normally
+    sq_pushnull(vm);
+    return sq_throwobject(vm);
+  }
+  sq_pushfloat(vm, a[i]);
+  return 1;
+}
+
+template <MathType T> SQInteger math_set(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  SQInteger i = componentIndex(vm, T);
+  if (i < 0)
+    return sq_throwerror(vm, "the index doesn't exist");
+  if (!getNumber(vm, 3, a[i]))
+    return sq_throwerror(vm, "component value must be a number");
+  return 0;
+}
+
+template <MathType T> SQInteger math_typeof(HSQUIRRELVM vm) {
+  sq_pushstring(vm, kTypeNames[typeIndex(T)], -1);
+  return 1;
+}
+
+template <MathType T> SQInteger math_tostring(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  std::string s = kTypeNames[typeIndex(T)];
+  s += '(';
+  for (u32 i = 0; i < dimOf(T); ++i) {
+    char num[32];
+    std::snprintf(num, sizeof(num), i ? ", %g" : "%g",
+                  static_cast<double>(a[i]));
+    s += num;
+  }
+  s += ')';
+  sq_pushstring(vm, s.c_str(), -1);
+  return 1;
+}
+
+template <MathType T> SQInteger math_copy(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  std::memcpy(pushLike(vm, T, 1), a, dimOf(T) * sizeof(f32));
+  return 1;
+}
+
+// Components from args [first, top]: none (leave as is), one value of the
+// same type, or exactly dim numbers
+template <MathType T>
+SQInteger readComponents(HSQUIRRELVM vm, SQInteger first, f32 *out) {
+  constexpr SQInteger dim = dimOf(T);
+  SQInteger count = sq_gettop(vm) - first + 1;
+  if (count == 0)
+    return 0;
+  if (count == 1) {
+    if (f32 *src = getMath(vm, first, T)) {
+      std::memcpy(out, src, dim * sizeof(f32));
+      return 0;
+    }
+  }
+  if (count != dim)
+    return bindingArityError(vm, dim, dim);
+  f32 tmp[9];
+  for (SQInteger i = 0; i < dim; ++i) {
+    if (!getNumber(vm, first + i, tmp[i]))
+      return bindingTypeError(vm, first + i - 1, "a number");
+  }
+  std::memcpy(out, tmp, dim * sizeof(f32));
+  return 0;
+}
+
+// set(...) -> this, with the same arguments as the constructor
+template <MathType T> SQInteger math_set_all(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  if (sq_gettop(vm) == 1)
+    return bindingArityError(vm, 1, dimOf(T));
+  if (SQInteger res = readComponents<T>(vm, 2, a))
+    return res;
+  sq_push(vm, 1);
+  return 1;
+}
+
+// ===== Vectors (and quat where the maths is the same) =====
+
+template <MathType T, bool Add> SQInteger vec_addsub(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  f32 *b = getMath(vm, 2, T);
+  if (!a)
+    return badThis(vm, T);
+  if (!b)
+    return badOperand(vm, T, kTypeNames[typeIndex(T)]);
+  f32 *r = pushLike(vm, T, 1);
+  for (u32 i = 0; i < dimOf(T); ++i)
+    r[i] = Add ? a[i] + b[i] : a[i] - b[i];
+  return 1;
+}
+
+// v * number or v * v (componentwise); same for /
+template <MathType T, bool Mul> SQInteger vec_muldiv(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  f32 s = 0.0f;
+  f32 *b = getMath(vm, 2, T);
+  if (!b && !getNumber(vm, 2, s))
+    return badOperand(vm, T, "a number or the same type");
+  f32 *r = pushLike(vm, T, 1);
+  for (u32 i = 0; i < dimOf(T); ++i) {
+    f32 rhs = b ? b[i] : s;
+    r[i] = Mul ? a[i] * rhs : a[i] / rhs;
+  }
+  return 1;
+}
+
+template <MathType T> SQInteger vec_unm(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  f32 *r = pushLike(vm, T, 1);
+  for (u32 i = 0; i < dimOf(T); ++i)
+    r[i] = -a[i];
+  return 1;
+}
+
+template <MathType T> SQInteger vec_len(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  sq_pushfloat(vm, std::sqrt(dot(a, a, dimOf(T))));
+  return 1;
+}
+
+template <MathType T> SQInteger vec_lenSq(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  sq_pushfloat(vm, dot(a, a, dimOf(T)));
+  return 1;
+}
+
+template <MathType T> SQInteger vec_dot(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  f32 *b = getMath(vm, 2, T);
+  if (!b)
+    return bindingTypeError(vm, 1, kTypeNames[typeIndex(T)]);
+  sq_pushfloat(vm, dot(a, b, dimOf(T)));
+  return 1;
+}
+
+template <MathType T> SQInteger vec_dist(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  f32 *b = getMath(vm, 2, T);
+  if (!b)
+    return bindingTypeError(vm, 1, kTypeNames[typeIndex(T)]);
+  f32 d = 0.0f;
+  for (u32 i = 0; i < dimOf(T); ++i)
+    d += (a[i] - b[i]) * (a[i] - b[i]);
+  sq_pushfloat(vm, std::sqrt(d));
+  return 1;
+}
+
+// Zero-length input stays zero
+template <MathType T> SQInteger vec_normalized(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  f32 *r = pushLike(vm, T, 1);
+  std::memcpy(r, a, dimOf(T) * sizeof(f32));
+  normalize(r, dimOf(T));
+  return 1;
+}
+
+template <MathType T> SQInteger vec_normalize(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  normalize(a, dimOf(T));
+  sq_push(vm, 1);
+  return 1;
+}
+
+template <MathType T> SQInteger vec_lerp(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  if (sq_gettop(vm) != 3)
+    return bindingArityError(vm, 2, 2);
+  f32 *b = getMath(vm, 2, T);
+  f32 t;
+  if (!b)
+    return bindingTypeError(vm, 1, kTypeNames[typeIndex(T)]);
+  if (!getNumber(vm, 3, t))
+    return bindingTypeError(vm, 2, "a number");
+  f32 *r = pushLike(vm, T, 1);
+  for (u32 i = 0; i < dimOf(T); ++i)
+    r[i] = a[i] + (b[i] - a[i]) * t;
+  return 1;
+}
+
+// addIn(v) / subIn(v) -> this
+template <MathType T, bool Add> SQInteger vec_addsubIn(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  f32 *b = getMath(vm, 2, T);
+  if (!b)
+    return bindingTypeError(vm, 1, kTypeNames[typeIndex(T)]);
+  for (u32 i = 0; i < dimOf(T); ++i)
+    a[i] = Add ? a[i] + b[i] : a[i] - b[i];
+  sq_push(vm, 1);
+  return 1;
+}
+
+// mulIn(number | v) -> this
+template <MathType T> SQInteger vec_mulIn(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  f32 s = 0.0f;
+  f32 *b = getMath(vm, 2, T);
+  if (!b && !getNumber(vm, 2, s))
+    return bindingTypeError(vm, 1, "a number or the same type");
+  for (u32 i = 0; i < dimOf(T); ++i)
+    a[i] *= b ? b[i] : s;
+  sq_push(vm, 1);
+  return 1;
+}
+
+// addScaledIn(v, s) -> this; this += v * s
+template <MathType T> SQInteger vec_addScaledIn(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, T);
+  if (!a)
+    return badThis(vm, T);
+  if (sq_gettop(vm) != 3)
+    return bindingArityError(vm, 2, 2);
+  f32 *b = getMath(vm, 2, T);
+  f32 s;
+  if (!b)
+    return bindingTypeError(vm, 1, kTypeNames[typeIndex(T)]);
+  if (!getNumber(vm, 3, s))
+    return bindingTypeError(vm, 2, "a number");
+  for (u32 i = 0; i < dimOf(T); ++i)
+    a[i] += b[i] * s;
+  sq_push(vm, 1);
+  return 1;
+}
+
+SQInteger vec3_cross(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, MathType::Vec3);
+  if (!a)
+    return badThis(vm, MathType::Vec3);
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  f32 *b = getMath(vm, 2, MathType::Vec3);
+  if (!b)
+    return bindingTypeError(vm, 1, "vec3");
+  f32 *r = pushLike(vm, MathType::Vec3, 1);
+  r[0] = a[1] * b[2] - a[2] * b[1];
+  r[1] = a[2] * b[0] - a[0] * b[2];
+  r[2] = a[0] * b[1] - a[1] * b[0];
+  return 1;
+}
+
+template <MathType T>
+constexpr NativeFunction kVecFunctions[] = {
+    {"_get", math_get<T>},
+    {"_set", math_set<T>},
+    {"_typeof", math_typeof<T>},
+    {"_tostring", math_tostring<T>},
+    {"_add", vec_addsub<T, true>},
+    {"_sub", vec_addsub<T, false>},
+    {"_mul", vec_muldiv<T, true>},
+    {"_div", vec_muldiv<T, false>},
+    {"_unm", vec_unm<T>},
+    {"copy", math_copy<T>},
+    {"set", math_set_all<T>},
+    {"len", vec_len<T>},
+    {"lenSq", vec_lenSq<T>},
+    {"dot", vec_dot<T>},
+    {"dist", vec_dist<T>},
+    {"normalized", vec_normalized<T>},
+    {"normalize", vec_normalize<T>},
+    {"lerp", vec_lerp<T>},
+    {"addIn", vec_addsubIn<T, true>},
+    {"subIn", vec_addsubIn<T, false>},
+    {"mulIn", vec_mulIn<T>},
+    {"addScaledIn", vec_addScaledIn<T>},
+};
+
+constexpr NativeFunction kVec3Extra[] = {
+    {"cross", vec3_cross},
+};
+
+// ===== Quaternions =====
+
+// q * q (compose, right applied first) or q * vec3 (rotate)
+SQInteger quat_mul(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, MathType::Quat);
+  if (!a)
+    return badThis(vm, MathType::Quat);
+  if (f32 *b = getMath(vm, 2, MathType::Quat)) {
+    quatMul(a, b, pushLike(vm, MathType::Quat, 1));
+    return 1;
+  }
+  if (f32 *v = getMath(vm, 2, MathType::Vec3)) {
+    quatRotate(a, v, pushLike(vm, MathType::Vec3, 2));
+    return 1;
+  }
+  return badOperand(vm, MathType::Quat, "a quat or vec3");
+}
+
+SQInteger quat_rotate(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  if (!getMath(vm, 2, MathType::Vec3))
+    return bindingTypeError(vm, 1, "vec3");
+  return quat_mul(vm);
+}
+
+// mulIn(q) -> this; this = this * q
+SQInteger quat_mulIn(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, MathType::Quat);
+  if (!a)
+    return badThis(vm, MathType::Quat);
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  f32 *b = getMath(vm, 2, MathType::Quat);
+  if (!b)
+    return bindingTypeError(vm, 1, "quat");
+  quatMul(a, b, a);
+  sq_push(vm, 1);
+  return 1;
+}
+
+SQInteger quat_conjugate(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, MathType::Quat);
+  if (!a)
+    return badThis(vm, MathType::Quat);
+  f32 *r = pushLike(vm, MathType::Quat, 1);
+  r[0] = -a[0];
+  r[1] = -a[1];
+  r[2] = -a[2];
+  r[3] = a[3];
+  return 1;
+}
+
+// Shortest-path spherical interpolation; falls back to nlerp when the
+// inputs are nearly parallel
+SQInteger quat_slerp(HSQUIRRELVM vm) {
+  f32 *a = getMath(vm, 1, MathType::Quat);
+  if (!a)
+    return badThis(vm, MathType::Quat);
+  if (sq_gettop(vm) != 3)
+    return bindingArityError(vm, 2, 2);
+  f32 *b = getMath(vm, 2, MathType::Quat);
+  f32 t;
+  if (!b)
+    return bindingTypeError(vm, 1, "quat");
+  if (!getNumber(vm, 3, t))
+    return bindingTypeError(vm, 2, "a number");
+
+  f32 cosTheta = dot(a, b, 4);
+  f32 sign = 1.0f;
+  if (cosTheta < 0.0f) {
+    cosTheta = -cosTheta;
+    sign = -1.0f;
+  }
+  f32 wa = 1.0f - t;
+  f32 wb = t;
+  if (cosTheta < 0.9995f) {
+    f32 theta = std::acos(cosTheta);
+    f32 sinTheta = std::sin(theta);
+    wa = std::sin((1.0f - t) * theta) / sinTheta;
+    wb = std::sin(t * theta) / sinTheta;
+  }
+  f32 *r = pushLike(vm, MathType::Quat, 1);
+  for (int i = 0; i < 4; ++i)
+    r[i] = wa * a[i] + sign * wb * b[i];
+  normalize(r, 4);
+  return 1;
+}
+
+constexpr NativeFunction kQuatFunctions[] = {
+    {"_get", math_get<MathType::Quat>},
+    {"_set", math_set<MathType::Quat>},
+    {"_typeof", math_typeof<MathType::Quat>},
+    {"_tostring", math_tostring<MathType::Quat>},
+    {"_mul", quat_mul},
+    {"copy", math_copy<MathType::Quat>},
+    {"set", math_set_all<MathType::Quat>},
+    {"len", vec_len<MathType::Quat>},
+    {"dot", vec_dot<MathType::Quat>},
+    {"normalized", vec_normalized<MathType::Quat>},
+    {"normalize", vec_normalize<MathType::Quat>},
+    {"conjugate", quat_conjugate},
+    {"slerp", quat_slerp},
+    {"rotate", quat_rotate},
+    {"mulIn", quat_mulIn},
+};
+
+// ===== mat3 =====
+
+// m * m, m * vec2 (as a point), m * vec3, or m * number
+SQInteger mat3_mul(HSQUIRRELVM vm) {
+  f32 *m = getMath(vm, 1, MathType::Mat3);
+  if (!m)
+    return badThis(vm, MathType::Mat3);
+  if (f32 *b = getMath(vm, 2, MathType::Mat3)) {
+    mat3Mul(m, b, pushLike(vm, MathType::Mat3, 1));
+    return 1;
+  }
+  if (f32 *p = getMath(vm, 2, MathType::Vec2)) {
+    f32 *r = pushLike(vm, MathType::Vec2, 2);
+    f32 x = p[0], y = p[1];
+    r[0] = m[0] * x + m[1] * y + m[2];
+    r[1] = m[3] * x + m[4] * y + m[5];
+    return 1;
+  }
+  if (f32 *v = getMath(vm, 2, MathType::Vec3)) {
+    f32 *r = pushLike(vm, MathType::Vec3, 2);
+    for (int row = 0; row < 3; ++row)
+      r[row] = dot(m + row * 3, v, 3);
+    return 1;
+  }
+  f32 s;
+  if (getNumber(vm, 2, s)) {
+    f32 *r = pushLike(vm, MathType::Mat3, 1);
+    for (int i = 0; i < 9; ++i)
+      r[i] = m[i] * s;
+    return 1;
+  }
+  return badOperand(vm, MathType::Mat3, "a mat3, vec2, vec3 or number");
+}
+
+SQInteger mat3_transformPoint(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  if (!getMath(vm, 2, MathType::Vec2))
+    return bindingTypeError(vm, 1, "vec2");
+  return mat3_mul(vm);
+}
+
+// mulIn(m) -> this; this = this * m
+SQInteger mat3_mulIn(HSQUIRRELVM vm) {
+  f32 *m = getMath(vm, 1, MathType::Mat3);
+  if (!m)
+    return badThis(vm, MathType::Mat3);
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  f32 *b = getMath(vm, 2, MathType::Mat3);
+  if (!b)
+    return bindingTypeError(vm, 1, "mat3");
+  mat3Mul(m, b, m);
+  sq_push(vm, 1);
+  return 1;
+}
+
+SQInteger mat3_identity(HSQUIRRELVM vm) {
+  f32 *m = getMath(vm, 1, MathType::Mat3);
+  if (!m)
+    return badThis(vm, MathType::Mat3);
+  mat3Identity(m);
+  sq_push(vm, 1);
+  return 1;
+}
+
+// translate/rotate/scale post-multiply, like the gfx transform stack:
+// the new operation applies to points first
+
+SQInteger mat3_translate(HSQUIRRELVM vm) {
+  f32 *m = getMath(vm, 1, MathType::Mat3);
+  if (!m)
+    return badThis(vm, MathType::Mat3);
+  if (sq_gettop(vm) != 3)
+    return bindingArityError(vm, 2, 2);
+  f32 tx, ty;
+  if (!getNumber(vm, 2, tx))
+    return bindingTypeError(vm, 1, "a number");
+  if (!getNumber(vm, 3, ty))
+    return bindingTypeError(vm, 2, "a number");
+  for (int row = 0; row < 3; ++row)
+    m[row * 3 + 2] += m[row * 3] * tx + m[row * 3 + 1] * ty;
+  sq_push(vm, 1);
+  return 1;
+}
+
+SQInteger mat3_rotate(HSQUIRRELVM vm) {
+  f32 *m = getMath(vm, 1, MathType::Mat3);
+  if (!m)
+    return badThis(vm, MathType::Mat3);
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  f32 angle;
+  if (!getNumber(vm, 2, angle))
+    return bindingTypeError(vm, 1, "a number");
+  f32 c = std::cos(angle), s = std::sin(angle);
+  for (int row = 0; row < 3; ++row) {
+    f32 a = m[row * 3], b = m[row * 3 + 1];
+    m[row * 3] = a * c + b * s;
+    m[row * 3 + 1] = b * c - a * s;
+  }
+  sq_push(vm, 1);
+  return 1;
+}
+
+// scale(s) or scale(sx, sy)
+SQInteger mat3_scale(HSQUIRRELVM vm) {
+  f32 *m = getMath(vm, 1, MathType::Mat3);
+  if (!m)
+    return badThis(vm, MathType::Mat3);
+  SQInteger top = sq_gettop(vm);
+  if (top < 2 || top > 3)
+    return bindingArityError(vm, 1, 2);
+  f32 sx, sy;
+  if (!getNumber(vm, 2, sx))
+    return bindingTypeError(vm, 1, "a number");
+  sy = sx;
+  if (top == 3 && !getNumber(vm, 3, sy))
+    return bindingTypeError(vm, 2, "a number");
+  for (int row = 0; row < 3; ++row) {
+    m[row * 3] *= sx;
+    m[row * 3 + 1] *= sy;
+  }
+  sq_push(vm, 1);
+  return 1;
+}
+
+SQInteger mat3_det(HSQUIRRELVM vm) {
+  f32 *m = getMath(vm, 1, MathType::Mat3);
+  if (!m)
+    return badThis(vm, MathType::Mat3);
+  sq_pushfloat(vm, mat3Det(m));
+  return 1;
+}
+
+SQInteger mat3_transpose(HSQUIRRELVM vm) {
+  f32 *m = getMath(vm, 1, MathType::Mat3);
+  if (!m)
+    return badThis(vm, MathType::Mat3);
+  f32 *r = pushLike(vm, MathType::Mat3, 1);
+  for (int row = 0; row < 3; ++row) {
+    for (int col = 0; col < 3; ++col)
+      r[col * 3 + row] = m[row * 3 + col];
+  }
+  return 1;
+}
+
+// null (and sys.getLastError) for a singular matrix
+SQInteger mat3_inverse(HSQUIRRELVM vm) {
+  f32 *m = getMath(vm, 1, MathType::Mat3);
+  if (!m)
+    return badThis(vm, MathType::Mat3);
+  f32 det = mat3Det(m);
+  if (det == 0.0f || !std::isfinite(det)) {
+    setLastError(vm, "mat3.inverse: matrix is singular");
+    sq_pushnull(vm);
+    return 1;
+  }
+  f32 inv = 1.0f / det;
+  f32 *r = pushLike(vm, MathType::Mat3, 1);
+  r[0] = (m[4] * m[8] - m[5] * m[7]) * inv;
+  r[1] = (m[2] * m[7] - m[1] * m[8]) * inv;
+  r[2] = (m[1] * m[5] - m[2] * m[4]) * inv;
+  r[3] = (m[5] * m[6] - m[3] * m[8]) * inv;
+  r[4] = (m[0] * m[8] - m[2] * m[6]) * inv;
+  r[5] = (m[2] * m[3] - m[0] * m[5]) * inv;
+  r[6] = (m[3] * m[7] - m[4] * m[6]) * inv;
+  r[7] = (m[1] * m[6] - m[0] * m[7]) * inv;
+  r[8] = (m[0] * m[4] - m[1] * m[3]) * inv;
+  return 1;
+}
+
+constexpr NativeFunction kMat3Functions[] = {
+    {"_get", math_get<MathType::Mat3>},
+    {"_set", math_set<MathType::Mat3>},
+    {"_typeof", math_typeof<MathType::Mat3>},
+    {"_tostring", math_tostring<MathType::Mat3>},
+    {"_mul", mat3_mul},
+    {"copy", math_copy<MathType::Mat3>},
+    {"set", math_set_all<MathType::Mat3>},
+    {"identity", mat3_identity},
+    {"translate", mat3_translate},
+    {"rotate", mat3_rotate},
+    {"scale", mat3_scale},
+    {"mulIn", mat3_mulIn},
+    {"det", mat3_det},
+    {"transpose", mat3_transpose},
+    {"inverse", mat3_inverse},
+    {"transformPoint", mat3_transformPoint},
+};
+
+// ===== Constructors =====
+
+// math.vec2(), math.vec2(x, y), math.vec2(v) (copy); likewise vec3/vec4
+template <MathType T> SQInteger math_new(HSQUIRRELVM vm) {
+  f32 tmp[9] = {};
+  if (T == MathType::Quat)
+    tmp[3] = 1.0f;
+  else if (T == MathType::Mat3)
+    mat3Identity(tmp);
+  if (SQInteger res = readComponents<T>(vm, 2, tmp))
+    return res;
+  std::memcpy(pushMath(vm, T), tmp, dimOf(T) * sizeof(f32));
+  return 1;
+}
+
+// math.quatAxisAngle(axis: vec3, radians)
+SQInteger math_quatAxisAngle(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 3)
+    return bindingArityError(vm, 2, 2);
+  f32 *axis = getMath(vm, 2, MathType::Vec3);
+  f32 angle;
+  if (!axis)
+    return bindingTypeError(vm, 1, "vec3");
+  if (!getNumber(vm, 3, angle))
+    return bindingTypeError(vm, 2, "a number");
+  f32 n[3] = {axis[0], axis[1], axis[2]};
+  normalize(n, 3);
+  f32 s = std::sin(angle * 0.5f);
+  f32 *q = pushMath(vm, MathType::Quat);
+  q[0] = n[0] * s;
+  q[1] = n[1] * s;
+  q[2] = n[2] * s;
+  q[3] = std::cos(angle * 0.5f);
+  return 1;
+}
+
+// ===== Bulk operations over Float32Buffers =====
+// Plain loops over contiguous floats; the compiler vectorizes these.
+
+bool getFloats(HSQUIRRELVM vm, SQInteger idx, BufferView &out) {
+  return getBuffer(vm, idx, out) && out.type == BufferType::Float32;
+}
+
+// math.addScaled(dst, src, s) -> dst; dst[i] += src[i] * s
+SQInteger math_addScaled(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 4)
+    return bindingArityError(vm, 3, 3);
+  BufferView dst, src;
+  f32 s;
+  if (!getFloats(vm, 2, dst))
+    return bindingTypeError(vm, 1, "a Float32Buffer");
+  if (!getFloats(vm, 3, src) || src.length != dst.length)
+    return bindingTypeError(vm, 2, "a Float32Buffer of the same length");
+  if (!getNumber(vm, 4, s))
+    return bindingTypeError(vm, 3, "a number");
+
+  f32 *d = dst.floats();
+  const f32 *v = src.floats();
+  for (SQInteger i = 0; i < dst.length; ++i)
+    d[i] += v[i] * s;
+  sq_push(vm, 2);
+  return 1;
+}
+
+// Shared argument handling for (transform, points [, out]); out defaults to
+// points and must have the same length
+bool readBulkTarget(HSQUIRRELVM vm, SQInteger stride, BufferView &in,
+                    BufferView &out, SQInteger &res) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 3 || top > 4) {
+    res = bindingArityError(vm, 2, 3);
+    return false;
+  }
+  if (!getFloats(vm, 3, in) || in.length % stride != 0) {
+    res = bindingTypeError(vm, 2,
+                           stride == 2 ? "a Float32Buffer of x,y pairs"
+                                       : "a Float32Buffer of x,y,z triples");
+    return false;
+  }
+  out = in;
+  if (top == 4 && (!getFloats(vm, 4, out) || out.length != in.length)) {
+    res = bindingTypeError(vm, 3, "a Float32Buffer of the same length");
+    return false;
+  }
+  return true;
+}
+
+// math.transformPoints(m: mat3, points [, out]) -> out
+SQInteger math_transformPoints(HSQUIRRELVM vm) {
+  f32 *m = getMath(vm, 2, MathType::Mat3);
+  BufferView in, out;
+  SQInteger res;
+  if (!readBulkTarget(vm, 2, in, out, res))
+    return res;
+  if (!m)
+    return bindingTypeError(vm, 1, "mat3");
+
+  const f32 a = m[0], b = m[1], c = m[2], d = m[3], e = m[4], f = m[5];
+  const f32 *src = in.floats();
+  f32 *dst = out.floats();
+  for (SQInteger i = 0; i < in.length; i += 2) {
+    f32 x = src[i], y = src[i + 1];
+    dst[i] = a * x + b * y + c;
+    dst[i + 1] = d * x + e * y + f;
+  }
+  sq_push(vm, sq_gettop(vm) == 4 ? 4 : 3);
+  return 1;
+}
+
+// math.rotateVectors(q: quat, vectors [, out]) -> out
+SQInteger math_rotateVectors(HSQUIRRELVM vm) {
+  f32 *q = getMath(vm, 2, MathType::Quat);
+  BufferView in, out;
+  SQInteger res;
+  if (!readBulkTarget(vm, 3, in, out, res))
+    return res;
+  if (!q)
+    return bindingTypeError(vm, 1, "quat");
+
+  // Rotation matrix once, then 9 multiply-adds per vector
+  f32 x = q[0], y = q[1], z = q[2], w = q[3];
+  const f32 r[9] = {1 - 2 * (y * y + z * z), 2 * (x * y - w * z),
+                    2 * (x * z + w * y),     2 * (x * y + w * z),
+                    1 - 2 * (x * x + z * z), 2 * (y * z - w * x),
+                    2 * (x * z - w * y),     2 * (y * z + w * x),
+                    1 - 2 * (x * x + y * y)};
+  const f32 *src = in.floats();
+  f32 *dst = out.floats();
+  for (SQInteger i = 0; i < in.length; i += 3) {
+    f32 vx = src[i], vy = src[i + 1], vz = src[i + 2];
+    dst[i] = r[0] * vx + r[1] * vy + r[2] * vz;
+    dst[i + 1] = r[3] * vx + r[4] * vy + r[5] * vz;
+    dst[i + 2] = r[6] * vx + r[7] * vy + r[8] * vz;
+  }
+  sq_push(vm, sq_gettop(vm) == 4 ? 4 : 3);
+  return 1;
+}
+
+constexpr NativeFunction kMathFunctions[] = {
+    {"vec2", math_new<MathType::Vec2>},
+    {"vec3", math_new<MathType::Vec3>},
+    {"vec4", math_new<MathType::Vec4>},
+    {"quat", math_new<MathType::Quat>},
+    {"mat3", math_new<MathType::Mat3>},
+    {"quatAxisAngle", math_quatAxisAngle},
+
+    // Bulk
+    {"addScaled", math_addScaled},
+    {"transformPoints", math_transformPoints},
+    {"rotateVectors", math_rotateVectors},
+};
+
+// Adds functions to the table on top of the stack, named "<type>.<fn>"
+void addMethods(HSQUIRRELVM vm, MathType type, const NativeFunction *functions,
+                size_t count) {
+  std::string qualified = kTypeNames[typeIndex(type)];
+  qualified += '.';
+  const size_t prefix = qualified.size();
+  for (size_t i = 0; i < count; ++i) {
+    qualified.resize(prefix);
+    qualified += functions[i].name;
+    sq_pushstring(vm, functions[i].name, -1);
+    sq_newclosure(vm, functions[i].func, 0);
+    sq_setnativeclosurename(vm, -1, qualified.c_str());
+    sq_newslot(vm, -3, SQFalse);
+  }
+}
+
+template <size_t N>
+void registerDelegate(HSQUIRRELVM vm, MathType type,
+                      const NativeFunction (&functions)[N],
+                      const NativeFunction *extra = nullptr,
+                      size_t extraCount = 0) {
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kDelegateKeys[typeIndex(type)], -1);
+  sq_newtable(vm);
+  addMethods(vm, type, functions, N);
+  addMethods(vm, type, extra, extraCount);
+  sq_newslot(vm, -3, SQFalse);
+  sq_pop(vm, 1); // registry
+}
+
+} // namespace
+
+f32 *getMath(HSQUIRRELVM vm, SQInteger idx, MathType type) {
+  SQUserPointer p = nullptr, tag = nullptr;
+  if (sq_gettype(vm, idx) != OT_USERDATA ||
+      SQ_FAILED(sq_getuserdata(vm, idx, &p, &tag)) || tag != tagOf(type)) {
+    return nullptr;
+  }
+  return static_cast<f32 *>(p);
+}
+
+f32 *pushMath(HSQUIRRELVM vm, MathType type) {
+  auto *p = static_cast<f32 *>(sq_newuserdata(vm, dimOf(type) * sizeof(f32)));
+  std::memset(p, 0, dimOf(type) * sizeof(f32));
+  sq_settypetag(vm, -1, tagOf(type));
+
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kDelegateKeys[typeIndex(type)], -1);
+  if (SQ_SUCCEEDED(sq_rawget(vm, -2))) {
+    sq_setdelegate(vm, -3);
+  }
+  sq_pop(vm, 1); // registry
+  return p;
+}
+
+void registerMathBinding(HSQUIRRELVM vm) {
+  registerDelegate(vm, MathType::Vec2, kVecFunctions<MathType::Vec2>);
+  registerDelegate(vm, MathType::Vec3, kVecFunctions<MathType::Vec3>,
+                   kVec3Extra, std::size(kVec3Extra));
+  registerDelegate(vm, MathType::Vec4, kVecFunctions<MathType::Vec4>);
+  registerDelegate(vm, MathType::Quat, kQuatFunctions);
+  registerDelegate(vm, MathType::Mat3, kMat3Functions);
+
+  BindTable(vm, "math", kMathFunctions);
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "common/Types.h"
+#include <squirrel.h>
+
+namespace arcanee::script {
+
+/**
+ * @brief Native math value types exposed to scripts.
+ *
+ * Each value is a userdata holding packed f32 components: vectors and quat
+ * as x,y,z,w; mat3 as 9 floats, row-major, acting on column vectors.
+ */
+enum class MathType : u8 { Vec2, Vec3, Vec4, Quat, Mat3 };
+
+/**
+ * @brief Register the math.* constructors, the bulk buffer operations and the
+ * per-type delegates (operators, fields and methods).
+ */
+void registerMathBinding(HSQUIRRELVM vm);
+
+/**
+ * @brief Components of the math value at @p idx, or null if it is not a
+ * value of @p type.
+ */
+f32 *getMath(HSQUIRRELVM vm, SQInteger idx, MathType type);
+
+/**
+ * @brief Create a zeroed math value and push it. Returns its components.
+ */
+f32 *pushMath(HSQUIRRELVM vm, MathType type);
+
+} // namespace arcanee::script
@@ -0,0 +1,340 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file NavBinding.cpp
+ * @brief Grid pathfinding (nav.*) on top of Pathfinder.
+ */
+
+#include "NavBinding.h"
+#include "nav/Pathfinder.h"
+#include "script/BindingUtils.h"
+#include "script/api/BufferBinding.h"
+#include <algorithm>
+#include <vector>
+
+namespace arcanee::script {
+
+using nav::NavGrid;
+using nav::Pathfinder;
+
+namespace {
+
+constexpr const SQChar *kPathfinderKey = "arcanee.nav";
+
+Pathfinder *pathfinderOf(HSQUIRRELVM vm) {
+  SQUserPointer p = nullptr;
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kPathfinderKey, -1);
+  if (SQ_SUCCEEDED(sq_rawget(vm, -2))) {
+    sq_getuserpointer(vm, -1, &p);
+    sq_pop(vm, 1);
+  }
+  sq_pop(vm, 1);
+  return static_cast<Pathfinder *>(p);
+}
+
+// Reads the x, y pair at @p idx, @p idx + 1 as a cell index of the grid
+bool getCell(HSQUIRRELVM vm, const NavGrid &grid, SQInteger idx, u32 &cell) {
+  SQInteger x, y;
+  if (SQ_FAILED(sq_getinteger(vm, idx, &x)) ||
+      SQ_FAILED(sq_getinteger(vm, idx + 1, &y)) || x < 0 || y < 0 ||
+      !grid.contains(static_cast<u32>(x), static_cast<u32>(y))) {
+    return false;
+  }
+  cell = grid.index(static_cast<u32>(x), static_cast<u32>(y));
+  return true;
+}
+
+// Pushes a path as an Int32Buffer of x, y pairs
+void pushPath(HSQUIRRELVM vm, const NavGrid &grid,
+              const std::vector<u32> &path) {
+  void *data = pushBuffer(vm, BufferType::Int32,
+                          static_cast<SQInteger>(path.size() * 2));
+  if (!data) {
+    sq_pushnull(vm);
+    return;
+  }
+  i32 *xy = static_cast<i32 *>(data);
+  for (size_t i = 0; i < path.size(); ++i) {
+    xy[2 * i] = static_cast<i32>(path[i] % grid.width());
+    xy[2 * i + 1] = static_cast<i32>(path[i] / grid.width());
+  }
+}
+
+void setSlot(HSQUIRRELVM vm, const SQChar *key) {
+  sq_pushstring(vm, key, -1);
+  sq_push(vm, -2);
+  sq_remove(vm, -3);
+  sq_rawset(vm, -3);
+}
+
+// ===== nav.* =====
+
+// nav.setGrid(w, h [, costs]) -> true; drops every request
+SQInteger nav_setGrid(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 3 || top > 4)
+    return bindingArityError(vm, 2, 3);
+  SQInteger w, h;
+  if (SQ_FAILED(sq_getinteger(vm, 2, &w)) || w <= 0)
+    return bindingTypeError(vm, 1, "a positive integer");
+  if (SQ_FAILED(sq_getinteger(vm, 3, &h)) || h <= 0)
+    return bindingTypeError(vm, 2, "a positive integer");
+  const SQInteger maxCells = NavGrid::kMaxCells;
+  if (w > maxCells || h > maxCells || w * h > maxCells) {
+    setLastError(vm, "nav.setGrid: grid is larger than 1048576 cells");
+    sq_pushnull(vm);
+    return 1;
+  }
+  const SQInteger cells = w * h;
+
+  static constexpr const char *kCostsExpected =
+      "a ByteBuffer or array with one cost (0-255) per cell";
+  FrameArena::Scope scratch(bindingArena());
+  const u8 *costs = nullptr;
+  BufferView buf;
+  if (top == 4 && getBuffer(vm, 4, buf)) {
+    if (buf.type != BufferType::Byte || buf.length != cells)
+      return bindingTypeError(vm, 3, kCostsExpected);
+    costs = buf.bytes();
+  } else if (top == 4 && sq_gettype(vm, 4) != OT_NULL) {
+    if (sq_gettype(vm, 4) != OT_ARRAY || sq_getsize(vm, 4) != cells)
+      return bindingTypeError(vm, 3, kCostsExpected);
+    u8 *copy = bindingArena().allocArray<u8>(static_cast<size_t>(cells));
+    for (SQInteger i = 0; i < cells; ++i) {
+      SQInteger c = -1;
+      sq_pushinteger(vm, i);
+      sq_rawget(vm, 4);
+      sq_getinteger(vm, -1, &c);
+      sq_pop(vm, 1);
+      if (c < 0 || c > 255)
+        return bindingTypeError(vm, 3, kCostsExpected);
+      copy[i] = static_cast<u8>(c);
+    }
+    costs = copy;
+  }
+
+  Pathfinder *pf = pathfinderOf(vm);
+  if (pf && pf->resetGrid(static_cast<u32>(w), static_cast<u32>(h)) &&
+      costs) {
+    pf->grid().setCosts(costs);
+  }
+  sq_pushbool(vm, pf ? SQTrue : SQFalse);
+  return 1;
+}
+
+// nav.setCost(x, y, cost)
+SQInteger nav_setCost(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 4)
+    return bindingArityError(vm, 3, 3);
+  Pathfinder *pf = pathfinderOf(vm);
+  if (!pf)
+    return 0;
+  u32 cell;
+  if (!getCell(vm, pf->grid(), 2, cell))
+    return bindingTypeError(vm, 1, "a cell on the grid");
+  SQInteger cost;
+  if (SQ_FAILED(sq_getinteger(vm, 4, &cost)) || cost < 0 || cost > 255)
+    return bindingTypeError(vm, 3, "a cost from 0 to 255");
+  pf->grid().setCost(cell % pf->grid().width(), cell / pf->grid().width(),
+                     static_cast<u8>(cost));
+  return 0;
+}
+
+// nav.getCost(x, y) -> cost; 0 (blocked) off the grid
+SQInteger nav_getCost(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 3)
+    return bindingArityError(vm, 2, 2);
+  Pathfinder *pf = pathfinderOf(vm);
+  u32 cell;
+  SQInteger cost = 0;
+  if (pf && getCell(vm, pf->grid(), 2, cell))
+    cost = pf->grid().cost(cell);
+  sq_pushinteger(vm, cost);
+  return 1;
+}
+
+// nav.setDiagonal(enable)
+SQInteger nav_setDiagonal(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  SQBool enable;
+  if (SQ_FAILED(sq_getbool(vm, 2, &enable)))
+    return bindingTypeError(vm, 1, "a bool");
+  if (Pathfinder *pf = pathfinderOf(vm))
+    pf->grid().setDiagonal(enable != SQFalse);
+  return 0;
+}
+
+// nav.find(sx, sy, gx, gy) -> Int32Buffer of x, y pairs, or null
+SQInteger nav_find(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 5)
+    return bindingArityError(vm, 4, 4);
+  Pathfinder *pf = pathfinderOf(vm);
+  if (!pf) {
+    sq_pushnull(vm);
+    return 1;
+  }
+  u32 start, goal;
+  if (!getCell(vm, pf->grid(), 2, start))
+    return bindingTypeError(vm, 1, "a cell on the grid");
+  if (!getCell(vm, pf->grid(), 4, goal))
+    return bindingTypeError(vm, 3, "a cell on the grid");
+
+  std::vector<u32> path;
+  u32 cost;
+  if (pf->findPath(start, goal, path, cost))
+    pushPath(vm, pf->grid(), path);
+  else
+    sq_pushnull(vm);
+  return 1;
+}
+
+// nav.request(sx, sy, gx, gy) -> request id
+SQInteger nav_request(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 5)
+    return bindingArityError(vm, 4, 4);
+  Pathfinder *pf = pathfinderOf(vm);
+  if (!pf) {
+    sq_pushnull(vm);
+    return 1;
+  }
+  u32 start, goal;
+  if (!getCell(vm, pf->grid(), 2, start))
+    return bindingTypeError(vm, 1, "a cell on the grid");
+  if (!getCell(vm, pf->grid(), 4, goal))
+    return bindingTypeError(vm, 3, "a cell on the grid");
+  sq_pushinteger(vm, static_cast<SQInteger>(pf->request(start, goal)));
+  return 1;
+}
+
+// nav.poll(id) -> {found, path, cost} once finished, else null
+SQInteger nav_poll(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  SQInteger id;
+  if (SQ_FAILED(sq_getinteger(vm, 2, &id)))
+    return bindingTypeError(vm, 1, "a request id");
+  Pathfinder *pf = pathfinderOf(vm);
+  std::vector<u32> path;
+  u32 cost = 0;
+  Pathfinder::Status status =
+      pf ? pf->poll(static_cast<u32>(id), path, cost)
+         : Pathfinder::Status::Unknown;
+  if (status != Pathfinder::Status::Found &&
+      status != Pathfinder::Status::NoPath) {
+    sq_pushnull(vm);
+    return 1;
+  }
+
+  bool found = status == Pathfinder::Status::Found;
+  sq_newtable(vm);
+  sq_pushbool(vm, found ? SQTrue : SQFalse);
+  setSlot(vm, "found");
+  if (found)
+    pushPath(vm, pf->grid(), path);
+  else
+    sq_pushnull(vm);
+  setSlot(vm, "path");
+  sq_pushfloat(vm, static_cast<SQFloat>(cost) /
+                       static_cast<SQFloat>(NavGrid::kStraightStep));
+  setSlot(vm, "cost");
+  return 1;
+}
+
+// nav.cancel(id) -> bool
+SQInteger nav_cancel(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  SQInteger id;
+  if (SQ_FAILED(sq_getinteger(vm, 2, &id)))
+    return bindingTypeError(vm, 1, "a request id");
+  Pathfinder *pf = pathfinderOf(vm);
+  bool cancelled = pf && pf->cancel(static_cast<u32>(id));
+  sq_pushbool(vm, cancelled ? SQTrue : SQFalse);
+  return 1;
+}
+
+// nav.pending() -> requests still searching
+SQInteger nav_pending(HSQUIRRELVM vm) {
+  Pathfinder *pf = pathfinderOf(vm);
+  sq_pushinteger(vm, pf ? static_cast<SQInteger>(pf->pending()) : 0);
+  return 1;
+}
+
+// nav.setBudget(nodes) -> node expansions spent on requests per tick
+SQInteger nav_setBudget(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  SQInteger nodes;
+  if (SQ_FAILED(sq_getinteger(vm, 2, &nodes)) || nodes < 1)
+    return bindingTypeError(vm, 1, "a positive integer");
+  const SQInteger maxNodes = NavGrid::kMaxCells;
+  if (Pathfinder *pf = pathfinderOf(vm))
+    pf->setStepBudget(static_cast<u32>(std::min(nodes, maxNodes)));
+  return 0;
+}
+
+// nav.flowField(gx, gy [, dist]) -> ByteBuffer of flow codes, or null
+SQInteger nav_flowField(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 3 || top > 4)
+    return bindingArityError(vm, 2, 3);
+  Pathfinder *pf = pathfinderOf(vm);
+  if (!pf) {
+    sq_pushnull(vm);
+    return 1;
+  }
+  u32 goal;
+  if (!getCell(vm, pf->grid(), 2, goal))
+    return bindingTypeError(vm, 1, "a cell on the grid");
+  const SQInteger cells = pf->grid().cellCount();
+  BufferView dist;
+  if (top == 4 && (!getBuffer(vm, 4, dist) ||
+                   dist.type != BufferType::Int32 || dist.length != cells)) {
+    return bindingTypeError(vm, 3, "an Int32Buffer with one entry per cell");
+  }
+
+  u8 *dirs = static_cast<u8 *>(pushBuffer(vm, BufferType::Byte, cells));
+  if (!dirs) {
+    sq_pushnull(vm);
+    return 1;
+  }
+  // Unreachable cells come out as -1 in the Int32Buffer
+  u32 *distOut = top == 4 ? reinterpret_cast<u32 *>(dist.ints()) : nullptr;
+  if (!pf->flowField(goal, dirs, distOut)) {
+    sq_pop(vm, 1);
+    sq_pushnull(vm);
+  }
+  return 1;
+}
+
+constexpr NativeFunction kNavFunctions[] = {
+    {"setGrid", nav_setGrid},
+    {"setCost", nav_setCost},
+    {"getCost", nav_getCost},
+    {"setDiagonal", nav_setDiagonal},
+    {"find", nav_find},
+    {"request", nav_request},
+    {"poll", nav_poll},
+    {"cancel", nav_cancel},
+    {"pending", nav_pending},
+    {"setBudget", nav_setBudget},
+    {"flowField", nav_flowField},
+};
+
+} // namespace
+
+void registerNavBinding(HSQUIRRELVM vm, nav::Pathfinder *pathfinder) {
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kPathfinderKey, -1);
+  sq_pushuserpointer(vm, pathfinder);
+  sq_newslot(vm, -3, SQFalse);
+  sq_pop(vm, 1);
+
+  BindTable(vm, "nav", kNavFunctions);
+}
+
+} // namespace arcanee::script
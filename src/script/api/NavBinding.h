@@ -0,0 +1,21 @@
+#pragma once
+
+#include <squirrel.h>
+
+namespace arcanee::nav {
+class Pathfinder;
+}
+
+namespace arcanee::script {
+
+/**
+ * @brief Register the nav.* functions (setGrid, setCost, getCost,
+ * setDiagonal, find, request, poll, cancel, pending, setBudget, flowField),
+ * all driving @p pathfinder.
+ *
+ * Paths come back as Int32Buffers of x, y pairs from start to goal; queued
+ * requests advance after each update() within the node budget.
+ */
+void registerNavBinding(HSQUIRRELVM vm, nav::Pathfinder *pathfinder);
+
+} // namespace arcanee::script
@@ -0,0 +1,290 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file NoiseBinding.cpp
+ * @brief Procedural noise and bulk random fills (noise.*).
+ *
+ * Stateless: every call takes its settings and seed, so a cartridge gets the
+ * same terrain from the same seed on every run.
+ */
+
+#include "NoiseBinding.h"
+#include "procgen/BulkRandom.h"
+#include "procgen/Noise.h"
+#include "script/BindingUtils.h"
+#include "script/api/BufferBinding.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace arcanee::script {
+
+using procgen::NoiseParams;
+using procgen::NoiseType;
+
+namespace {
+
+constexpr const SQChar *kNoiseTypes[] = {"value", "perlin", "simplex",
+                                         "cellular"};
+
+bool readType(HSQUIRRELVM vm, SQInteger idx, NoiseType &out) {
+  const SQChar *name = nullptr;
+  if (SQ_FAILED(sq_getstring(vm, idx, &name)))
+    return false;
+  for (size_t i = 0; i < sizeof(kNoiseTypes) / sizeof(kNoiseTypes[0]); ++i) {
+    if (std::strcmp(kNoiseTypes[i], name) == 0) {
+      out = static_cast<NoiseType>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool readFloat(HSQUIRRELVM vm, SQInteger idx, f32 &out) {
+  SQFloat v;
+  if (SQ_FAILED(sq_getfloat(vm, idx, &v)))
+    return false;
+  out = static_cast<f32>(v);
+  return true;
+}
+
+// Applies the fields of the table at @p idx (absolute) over @p params.
+// Sets @p bad to the offending key on failure.
+bool readParams(HSQUIRRELVM vm, SQInteger idx, NoiseParams &params,
+                const SQChar *&bad) {
+  bad = "";
+  if (sq_gettype(vm, idx) != OT_TABLE)
+    return false;
+
+  sq_pushnull(vm);
+  while (SQ_SUCCEEDED(sq_next(vm, idx))) {
+    const SQChar *key = "";
+    bool ok = SQ_SUCCEEDED(sq_getstring(vm, -2, &key));
+    SQInteger n = 0;
+    if (!ok) {
+      key = "";
+    } else if (std::strcmp(key, "type") == 0) {
+      ok = readType(vm, -1, params.type);
+    } else if (std::strcmp(key, "seed") == 0) {
+      ok = SQ_SUCCEEDED(sq_getinteger(vm, -1, &n));
+      params.seed = static_cast<u32>(n);
+    } else if (std::strcmp(key, "octaves") == 0) {
+      ok = SQ_SUCCEEDED(sq_getinteger(vm, -1, &n)) && n >= 1 &&
+           n <= procgen::kMaxOctaves;
+      params.octaves = static_cast<u32>(n);
+    } else if (std::strcmp(key, "frequency") == 0) {
+      ok = readFloat(vm, -1, params.frequency);
+    } else if (std::strcmp(key, "lacunarity") == 0) {
+      ok = readFloat(vm, -1, params.lacunarity);
+    } else if (std::strcmp(key, "gain") == 0) {
+      ok = readFloat(vm, -1, params.gain);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      bad = key;
+      sq_pop(vm, 3); // Key, value, iterator
+      return false;
+    }
+    sq_pop(vm, 2);
+  }
+  sq_pop(vm, 1);
+  return true;
+}
+
+// Reads optional settings at @p idx; absent or null keeps the defaults
+SQInteger readOptionalParams(HSQUIRRELVM vm, SQInteger idx,
+                             NoiseParams &params) {
+  if (sq_gettop(vm) < idx || sq_gettype(vm, idx) == OT_NULL)
+    return 0;
+  const SQChar *bad;
+  if (readParams(vm, idx, params, bad))
+    return 0;
+  char expected[128];
+  if (*bad) {
+    snprintf(expected, sizeof(expected),
+             "a settings table (bad or unknown field '%s')", bad);
+  } else {
+    snprintf(expected, sizeof(expected), "a settings table");
+  }
+  return bindingTypeError(vm, idx - 1, expected);
+}
+
+// ===== noise.* =====
+
+// noise.sample(x, y [, settings]) -> float
+SQInteger noise_sample(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 3 || top > 4)
+    return bindingArityError(vm, 2, 3);
+  f32 x, y;
+  if (!readFloat(vm, 2, x))
+    return bindingTypeError(vm, 1, "a number");
+  if (!readFloat(vm, 3, y))
+    return bindingTypeError(vm, 2, "a number");
+  NoiseParams params;
+  if (SQInteger err = readOptionalParams(vm, 4, params))
+    return err;
+  sq_pushfloat(vm, static_cast<SQFloat>(procgen::sampleNoise(params, x, y)));
+  return 1;
+}
+
+// noise.fill(out, w, h [, settings [, x, y]]) -> out; sample (x + i, y + j)
+// goes to out[j * w + i]
+SQInteger noise_fill(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 4 || top == 6 || top > 7)
+    return bindingArityError(vm, 3, 6);
+  BufferView out;
+  if (!getBuffer(vm, 2, out) || out.type != BufferType::Float32)
+    return bindingTypeError(vm, 1, "a Float32Buffer");
+  SQInteger w, h;
+  if (SQ_FAILED(sq_getinteger(vm, 3, &w)) || w < 0)
+    return bindingTypeError(vm, 2, "a non-negative integer");
+  if (SQ_FAILED(sq_getinteger(vm, 4, &h)) || h < 0)
+    return bindingTypeError(vm, 3, "a non-negative integer");
+  if (w != 0 && h > out.length / w) {
+    setLastError(vm, "noise.fill: buffer is smaller than w * h");
+    sq_pushnull(vm);
+    return 1;
+  }
+  NoiseParams params;
+  if (SQInteger err = readOptionalParams(vm, 5, params))
+    return err;
+  f32 x = 0.0f, y = 0.0f;
+  if (top == 7 && !readFloat(vm, 6, x))
+    return bindingTypeError(vm, 5, "a number");
+  if (top == 7 && !readFloat(vm, 7, y))
+    return bindingTypeError(vm, 6, "a number");
+
+  procgen::fillNoise(params, x, y, static_cast<u32>(w), static_cast<u32>(h),
+                     out.floats());
+  sq_push(vm, 2);
+  return 1;
+}
+
+// noise.classify(values, thresholds, out) -> out; out[i] = thresholds <=
+// values[i], for ascending thresholds
+SQInteger noise_classify(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 4)
+    return bindingArityError(vm, 3, 3);
+  BufferView values;
+  if (!getBuffer(vm, 2, values) || values.type != BufferType::Float32)
+    return bindingTypeError(vm, 1, "a Float32Buffer");
+
+  static constexpr const char *kThresholdsExpected =
+      "an ascending array or Float32Buffer of numbers";
+  FrameArena::Scope scratch(bindingArena());
+  const f32 *thresholds = nullptr;
+  SQInteger count = 0;
+  BufferView buf;
+  if (getBuffer(vm, 3, buf)) {
+    if (buf.type != BufferType::Float32)
+      return bindingTypeError(vm, 2, kThresholdsExpected);
+    thresholds = buf.floats();
+    count = buf.length;
+  } else if (sq_gettype(vm, 3) == OT_ARRAY) {
+    count = sq_getsize(vm, 3);
+    f32 *copy = bindingArena().allocArray<f32>(static_cast<size_t>(count));
+    for (SQInteger i = 0; i < count; ++i) {
+      sq_pushinteger(vm, i);
+      sq_rawget(vm, 3);
+      bool ok = readFloat(vm, -1, copy[i]);
+      sq_pop(vm, 1);
+      if (!ok)
+        return bindingTypeError(vm, 2, kThresholdsExpected);
+    }
+    thresholds = copy;
+  } else {
+    return bindingTypeError(vm, 2, kThresholdsExpected);
+  }
+  for (SQInteger i = 1; i < count; ++i) {
+    if (!(thresholds[i - 1] <= thresholds[i]))
+      return bindingTypeError(vm, 2, kThresholdsExpected);
+  }
+
+  BufferView out;
+  if (!getBuffer(vm, 4, out) || out.type == BufferType::Float32 ||
+      out.length < values.length) {
+    return bindingTypeError(
+        vm, 3, "a ByteBuffer or Int32Buffer at least as long as values");
+  }
+  if (out.type == BufferType::Byte && count > 255) {
+    setLastError(vm, "noise.classify: more than 255 thresholds for a "
+                     "ByteBuffer");
+    sq_pushnull(vm);
+    return 1;
+  }
+
+  const u32 n = static_cast<u32>(values.length);
+  if (out.type == BufferType::Byte) {
+    procgen::classify(values.floats(), n, thresholds, static_cast<u32>(count),
+                      out.bytes());
+  } else {
+    procgen::classify(values.floats(), n, thresholds, static_cast<u32>(count),
+                      out.ints());
+  }
+  sq_push(vm, 4);
+  return 1;
+}
+
+// noise.random(out, seed [, lo, hi]) -> out; Float32Buffer in [lo, hi)
+// (default [0, 1)), Int32Buffer in [lo, hi] (default [0, 2^31 - 1]),
+// ByteBuffer with raw bytes
+SQInteger noise_random(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top != 3 && top != 5)
+    return bindingArityError(vm, 2, 4);
+  BufferView out;
+  if (!getBuffer(vm, 2, out))
+    return bindingTypeError(vm, 1, "a typed buffer");
+  SQInteger seed;
+  if (SQ_FAILED(sq_getinteger(vm, 3, &seed)))
+    return bindingTypeError(vm, 2, "an integer");
+
+  procgen::Xorshift128PlusX4 rng(static_cast<u64>(seed));
+  const size_t n = static_cast<size_t>(out.length);
+  if (out.type == BufferType::Float32) {
+    f32 lo = 0.0f, hi = 1.0f;
+    if (top == 5 && !readFloat(vm, 4, lo))
+      return bindingTypeError(vm, 3, "a number");
+    if (top == 5 && !readFloat(vm, 5, hi))
+      return bindingTypeError(vm, 4, "a number");
+    rng.fillFloat(out.floats(), n, lo, hi);
+  } else if (out.type == BufferType::Int32) {
+    SQInteger lo = 0, hi = 0x7FFFFFFF;
+    if (top == 5 && (SQ_FAILED(sq_getinteger(vm, 4, &lo)) || lo < INT32_MIN ||
+                     lo > INT32_MAX)) {
+      return bindingTypeError(vm, 3, "a 32-bit integer");
+    }
+    if (top == 5 && (SQ_FAILED(sq_getinteger(vm, 5, &hi)) || hi < INT32_MIN ||
+                     hi > INT32_MAX)) {
+      return bindingTypeError(vm, 4, "a 32-bit integer");
+    }
+    rng.fillInt(out.ints(), n, static_cast<i32>(lo), static_cast<i32>(hi));
+  } else {
+    if (top == 5)
+      return bindingTypeError(vm, 1, "a Float32Buffer or Int32Buffer when "
+                                     "a range is given");
+    rng.fillBytes(out.bytes(), n);
+  }
+  sq_push(vm, 2);
+  return 1;
+}
+
+constexpr NativeFunction kNoiseFunctions[] = {
+    {"sample", noise_sample},
+    {"fill", noise_fill},
+    {"classify", noise_classify},
+    {"random", noise_random},
+};
+
+} // namespace
+
+void registerNoiseBinding(HSQUIRRELVM vm) {
+  BindTable(vm, "noise", kNoiseFunctions);
+}
+
+} // namespace arcanee::script
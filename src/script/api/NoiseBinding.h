@@ -0,0 +1,15 @@
+#pragma once
+
+#include <squirrel.h>
+
+namespace arcanee::script {
+
+/**
+ * @brief Register the noise.* functions (sample, fill, classify, random).
+ *
+ * fill and random write whole typed buffers in one call; classify turns a
+ * noise buffer into tile indices. Everything is deterministic from the seed.
+ */
+void registerNoiseBinding(HSQUIRRELVM vm);
+
+} // namespace arcanee::script
@@ -0,0 +1,329 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file ParticleBinding.cpp
+ * @brief Native particle emitters (particles.*) on top of ParticleSystem.
+ *
+ * Scripts only touch emitters: settings tables in, counts out. Particles
+ * themselves are simulated and drawn without entering the VM.
+ */
+
+#include "ParticleBinding.h"
+#include "GfxBinding.h"
+#include "render/Canvas2D.h"
+#include "render/ParticleSystem.h"
+#include "script/BindingUtils.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace arcanee::script {
+
+using render::EmitterParams;
+using render::ParticleSystem;
+
+namespace {
+
+constexpr const SQChar *kParticlesKey = "arcanee.particles";
+
+ParticleSystem *particlesOf(HSQUIRRELVM vm) {
+  SQUserPointer p = nullptr;
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kParticlesKey, -1);
+  if (SQ_SUCCEEDED(sq_rawget(vm, -2))) {
+    sq_getuserpointer(vm, -1, &p);
+    sq_pop(vm, 1);
+  }
+  sq_pop(vm, 1);
+  return static_cast<ParticleSystem *>(p);
+}
+
+// ===== Settings tables =====
+
+enum class FieldKind : u8 { Float, Color, Count };
+
+struct ParamField {
+  const SQChar *name;
+  size_t offset;
+  FieldKind kind;
+};
+
+#define PARAM_FIELD(name, kind)                                                \
+  { #name, offsetof(EmitterParams, name), FieldKind::kind }
+
+constexpr ParamField kParamFields[] = {
+    PARAM_FIELD(x, Float),          PARAM_FIELD(y, Float),
+    PARAM_FIELD(w, Float),          PARAM_FIELD(h, Float),
+    PARAM_FIELD(rate, Float),       PARAM_FIELD(lifeMin, Float),
+    PARAM_FIELD(lifeMax, Float),    PARAM_FIELD(speedMin, Float),
+    PARAM_FIELD(speedMax, Float),   PARAM_FIELD(angle, Float),
+    PARAM_FIELD(spread, Float),     PARAM_FIELD(gravityX, Float),
+    PARAM_FIELD(gravityY, Float),   PARAM_FIELD(drag, Float),
+    PARAM_FIELD(sizeStart, Float),  PARAM_FIELD(sizeEnd, Float),
+    PARAM_FIELD(colorStart, Color), PARAM_FIELD(colorEnd, Color),
+    PARAM_FIELD(maxParticles, Count),
+};
+
+#undef PARAM_FIELD
+
+// Applies the fields of the table at @p idx (absolute) over @p params.
+// Sets @p bad to the offending key on failure.
+bool readParams(HSQUIRRELVM vm, SQInteger idx, EmitterParams &params,
+                const SQChar *&bad) {
+  bad = "";
+  if (sq_gettype(vm, idx) != OT_TABLE)
+    return false;
+
+  u8 *base = reinterpret_cast<u8 *>(&params);
+  sq_pushnull(vm);
+  while (SQ_SUCCEEDED(sq_next(vm, idx))) {
+    const SQChar *key = nullptr;
+    const ParamField *field = nullptr;
+    if (SQ_SUCCEEDED(sq_getstring(vm, -2, &key))) {
+      for (const auto &f : kParamFields) {
+        if (std::strcmp(f.name, key) == 0)
+          field = &f;
+      }
+    }
+
+    bool ok = field != nullptr;
+    if (ok && field->kind == FieldKind::Float) {
+      SQFloat v;
+      ok = SQ_SUCCEEDED(sq_getfloat(vm, -1, &v));
+      if (ok)
+        *reinterpret_cast<f32 *>(base + field->offset) = static_cast<f32>(v);
+    } else if (ok) {
+      SQInteger v;
+      ok = SQ_SUCCEEDED(sq_getinteger(vm, -1, &v)) &&
+           (field->kind == FieldKind::Color || v >= 0);
+      if (ok) {
+        *reinterpret_cast<u32 *>(base + field->offset) =
+            field->kind == FieldKind::Color ? resolveGfxColor(v)
+                                            : static_cast<u32>(v);
+      }
+    }
+    if (!ok) {
+      bad = key ? key : "";
+      sq_pop(vm, 3); // Key, value, iterator
+      return false;
+    }
+    sq_pop(vm, 2);
+  }
+  sq_pop(vm, 1);
+  return true;
+}
+
+SQInteger settingsError(HSQUIRRELVM vm, SQInteger arg, const SQChar *bad) {
+  char expected[128];
+  if (*bad) {
+    snprintf(expected, sizeof(expected),
+             "a settings table (bad or unknown field '%s')", bad);
+  } else {
+    snprintf(expected, sizeof(expected), "a settings table");
+  }
+  return bindingTypeError(vm, arg, expected);
+}
+
+bool getHandle(HSQUIRRELVM vm, SQInteger idx, u32 &out) {
+  SQInteger v;
+  if (SQ_FAILED(sq_getinteger(vm, idx, &v)) || v <= 0)
+    return false;
+  out = static_cast<u32>(v);
+  return true;
+}
+
+// Draws one emitter on the gfx canvas through the rect batch
+u32 drawEmitter(ParticleSystem &particles, u32 handle) {
+  render::Canvas2D *canvas = getGfxCanvas();
+  u32 count = particles.count(handle);
+  if (!canvas || count == 0)
+    return 0;
+
+  FrameArena::Scope scratch(bindingArena());
+  f32 *rects = bindingArena().allocArray<f32>(4 * static_cast<size_t>(count));
+  u32 *colors = bindingArena().allocArray<u32>(count);
+  count = particles.writeInstances(handle, rects, colors);
+  canvas->fillRects(rects, count, colors);
+  return count;
+}
+
+// ===== particles.* =====
+
+// particles.emitter(settings [, seed]) -> handle
+SQInteger particles_emitter(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 2 || top > 3)
+    return bindingArityError(vm, 1, 2);
+
+  EmitterParams params;
+  const SQChar *bad;
+  if (!readParams(vm, 2, params, bad))
+    return settingsError(vm, 1, bad);
+  SQInteger seed = 0;
+  if (top == 3 && SQ_FAILED(sq_getinteger(vm, 3, &seed)))
+    return bindingTypeError(vm, 2, "an integer");
+
+  ParticleSystem *particles = particlesOf(vm);
+  if (!particles) {
+    sq_pushnull(vm);
+    return 1;
+  }
+  sq_pushinteger(vm, static_cast<SQInteger>(particles->createEmitter(
+                         params, static_cast<u64>(seed))));
+  return 1;
+}
+
+// particles.set(handle, settings) -> bool; only the given fields change
+SQInteger particles_set(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 3)
+    return bindingArityError(vm, 2, 2);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "an emitter handle");
+
+  ParticleSystem *particles = particlesOf(vm);
+  const EmitterParams *current =
+      particles ? particles->getParams(handle) : nullptr;
+  if (!current) {
+    sq_pushbool(vm, SQFalse);
+    return 1;
+  }
+  EmitterParams params = *current;
+  const SQChar *bad;
+  if (!readParams(vm, 3, params, bad))
+    return settingsError(vm, 2, bad);
+  sq_pushbool(vm, particles->setParams(handle, params) ? SQTrue : SQFalse);
+  return 1;
+}
+
+// particles.get(handle) -> settings table, or null
+SQInteger particles_get(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "an emitter handle");
+
+  ParticleSystem *particles = particlesOf(vm);
+  const EmitterParams *params =
+      particles ? particles->getParams(handle) : nullptr;
+  if (!params) {
+    sq_pushnull(vm);
+    return 1;
+  }
+  const u8 *base = reinterpret_cast<const u8 *>(params);
+  sq_newtable(vm);
+  for (const auto &f : kParamFields) {
+    sq_pushstring(vm, f.name, -1);
+    if (f.kind == FieldKind::Float) {
+      sq_pushfloat(vm, *reinterpret_cast<const f32 *>(base + f.offset));
+    } else {
+      sq_pushinteger(vm, static_cast<SQInteger>(
+                             *reinterpret_cast<const u32 *>(base + f.offset)));
+    }
+    sq_newslot(vm, -3, SQFalse);
+  }
+  return 1;
+}
+
+// particles.burst(handle, count) -> particles spawned
+SQInteger particles_burst(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 3)
+    return bindingArityError(vm, 2, 2);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "an emitter handle");
+  SQInteger count;
+  if (SQ_FAILED(sq_getinteger(vm, 3, &count)) || count < 0)
+    return bindingTypeError(vm, 2, "a non-negative integer");
+
+  ParticleSystem *particles = particlesOf(vm);
+  u32 clamped = static_cast<u32>(std::min<SQInteger>(
+      count, ParticleSystem::kMaxParticlesPerEmitter));
+  sq_pushinteger(vm, particles ? static_cast<SQInteger>(
+                                     particles->burst(handle, clamped))
+                               : 0);
+  return 1;
+}
+
+// particles.draw([handle]) -> particles drawn; every emitter when omitted
+SQInteger particles_draw(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top > 2)
+    return bindingArityError(vm, 0, 1);
+  u32 handle = 0;
+  if (top == 2 && !getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "an emitter handle");
+
+  ParticleSystem *particles = particlesOf(vm);
+  u32 drawn = 0;
+  if (particles && handle != 0) {
+    drawn = drawEmitter(*particles, handle);
+  } else if (particles) {
+    for (u32 h : particles->handles())
+      drawn += drawEmitter(*particles, h);
+  }
+  sq_pushinteger(vm, static_cast<SQInteger>(drawn));
+  return 1;
+}
+
+// particles.free(handle) -> bool
+SQInteger particles_free(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "an emitter handle");
+  ParticleSystem *particles = particlesOf(vm);
+  bool freed = particles && particles->destroyEmitter(handle);
+  sq_pushbool(vm, freed ? SQTrue : SQFalse);
+  return 1;
+}
+
+// particles.count([handle]) -> live particles, of all emitters when omitted
+SQInteger particles_count(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top > 2)
+    return bindingArityError(vm, 0, 1);
+  u32 handle = 0;
+  if (top == 2 && !getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "an emitter handle");
+  ParticleSystem *particles = particlesOf(vm);
+  u32 n = !particles    ? 0
+          : handle != 0 ? particles->count(handle)
+                        : particles->totalCount();
+  sq_pushinteger(vm, static_cast<SQInteger>(n));
+  return 1;
+}
+
+// particles.clear() -> frees every emitter
+SQInteger particles_clear(HSQUIRRELVM vm) {
+  if (ParticleSystem *particles = particlesOf(vm))
+    particles->clear();
+  return 0;
+}
+
+constexpr NativeFunction kParticleFunctions[] = {
+    {"emitter", particles_emitter}, {"set", particles_set},
+    {"get", particles_get},         {"burst", particles_burst},
+    {"draw", particles_draw},       {"free", particles_free},
+    {"count", particles_count},     {"clear", particles_clear},
+};
+
+} // namespace
+
+void registerParticleBinding(HSQUIRRELVM vm,
+                             render::ParticleSystem *particles) {
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kParticlesKey, -1);
+  sq_pushuserpointer(vm, particles);
+  sq_newslot(vm, -3, SQFalse);
+  sq_pop(vm, 1);
+
+  BindTable(vm, "particles", kParticleFunctions);
+}
+
+} // namespace arcanee::script
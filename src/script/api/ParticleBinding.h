@@ -0,0 +1,21 @@
+#pragma once
+
+#include <squirrel.h>
+
+namespace arcanee::render {
+class ParticleSystem;
+}
+
+namespace arcanee::script {
+
+/**
+ * @brief Register the particles.* functions (emitter, set, get, burst, draw,
+ * free, count, clear), all driving @p particles.
+ *
+ * Emitters are configured from a settings table and simulated natively on
+ * the fixed tick; particles.draw() batches an emitter onto the gfx canvas.
+ */
+void registerParticleBinding(HSQUIRRELVM vm,
+                             render::ParticleSystem *particles);
+
+} // namespace arcanee::script
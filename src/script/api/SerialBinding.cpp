@@ -0,0 +1,148 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file SerialBinding.cpp
+ * @brief Binary save data (serial.*) on top of SaveData.
+ *
+ * Replaces hand-built text saves: a whole state table goes to bytes and back
+ * natively, without string concatenation or parsing in the VM.
+ */
+
+#include "SerialBinding.h"
+#include "script/BindingUtils.h"
+#include "script/SaveData.h"
+#include "script/api/BufferBinding.h"
+#include <cstdio>
+#include <cstring>
+#include <sqstdblob.h>
+#include <string>
+#include <vector>
+
+namespace arcanee::script {
+
+namespace {
+
+constexpr int kDefaultLevel = 3;
+constexpr int kMaxLevel = 19;
+
+// Applies the fields of the table at @p idx (absolute) over @p options.
+// Sets @p bad to the offending key on failure.
+bool readOptions(HSQUIRRELVM vm, SQInteger idx, SaveOptions &options,
+                 const SQChar *&bad) {
+  bad = "";
+  if (sq_gettype(vm, idx) != OT_TABLE)
+    return false;
+
+  bool compress = false;
+  int level = kDefaultLevel;
+  sq_pushnull(vm);
+  while (SQ_SUCCEEDED(sq_next(vm, idx))) {
+    const SQChar *key = "";
+    bool ok = SQ_SUCCEEDED(sq_getstring(vm, -2, &key));
+    if (!ok) {
+      key = "";
+    } else if (std::strcmp(key, "compress") == 0) {
+      SQBool b;
+      ok = SQ_SUCCEEDED(sq_getbool(vm, -1, &b));
+      compress = b != SQFalse;
+    } else if (std::strcmp(key, "level") == 0) {
+      SQInteger n = 0;
+      ok = SQ_SUCCEEDED(sq_getinteger(vm, -1, &n)) && n >= 1 &&
+           n <= kMaxLevel;
+      level = static_cast<int>(n);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      bad = key;
+      sq_pop(vm, 3); // Key, value, iterator
+      return false;
+    }
+    sq_pop(vm, 2);
+  }
+  sq_pop(vm, 1);
+  options.compressionLevel = compress ? level : 0;
+  return true;
+}
+
+// ===== serial.* =====
+
+// serial.encode(value [, settings]) -> ByteBuffer, or null
+SQInteger serial_encode(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 2 || top > 3)
+    return bindingArityError(vm, 1, 2);
+
+  SaveOptions options;
+  const SQChar *bad = "";
+  if (top == 3 && sq_gettype(vm, 3) != OT_NULL &&
+      !readOptions(vm, 3, options, bad)) {
+    char expected[128];
+    if (*bad) {
+      snprintf(expected, sizeof(expected),
+               "a settings table (bad or unknown field '%s')", bad);
+    } else {
+      snprintf(expected, sizeof(expected), "a settings table");
+    }
+    return bindingTypeError(vm, 2, expected);
+  }
+
+  std::vector<u8> bytes;
+  Status status = encodeSaveData(vm, 2, options, bytes);
+  void *dst = status.ok() ? pushBuffer(vm, BufferType::Byte,
+                                       static_cast<SQInteger>(bytes.size()))
+                          : nullptr;
+  if (!dst) {
+    setLastError(vm, "serial.encode: " +
+                         (status.ok() ? std::string("value is too large")
+                                      : status.message()));
+    sq_pushnull(vm);
+    return 1;
+  }
+  std::memcpy(dst, bytes.data(), bytes.size());
+  return 1;
+}
+
+// serial.decode(bytes) -> the encoded value; null (and the last error set)
+// if the data is corrupt or from a newer version
+SQInteger serial_decode(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+
+  const u8 *data = nullptr;
+  size_t size = 0;
+  BufferView buf;
+  SQUserPointer blob = nullptr;
+  if (getBuffer(vm, 2, buf) && buf.type == BufferType::Byte) {
+    data = buf.bytes();
+    size = buf.byteSize();
+  } else if (sq_gettype(vm, 2) == OT_INSTANCE &&
+             SQ_SUCCEEDED(sqstd_getblob(vm, 2, &blob))) {
+    data = static_cast<const u8 *>(blob);
+    size = static_cast<size_t>(sqstd_getblobsize(vm, 2));
+  } else {
+    return bindingTypeError(vm, 1, "a ByteBuffer or blob");
+  }
+
+  Status status = decodeSaveData(vm, data, size);
+  if (!status.ok()) {
+    setLastError(vm, "serial.decode: " + status.message());
+    sq_pushnull(vm);
+  }
+  return 1;
+}
+
+constexpr NativeFunction kSerialFunctions[] = {
+    {"encode", serial_encode},
+    {"decode", serial_decode},
+};
+
+} // namespace
+
+void registerSerialBinding(HSQUIRRELVM vm) {
+  BindTable(vm, "serial", kSerialFunctions);
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <squirrel.h>
+
+namespace arcanee::script {
+
+/**
+ * @brief Register the serial.* functions (encode, decode).
+ *
+ * encode turns plain data into a versioned, optionally zstd-compressed
+ * ByteBuffer for fs.writeBuffer; decode reads one back in a single call.
+ */
+void registerSerialBinding(HSQUIRRELVM vm);
+
+} // namespace arcanee::script
@@ -0,0 +1,432 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file SpriteBinding.cpp
+ * @brief Native sprites (sprites.*) on top of SpriteStore.
+ *
+ * Scripts keep handles and game logic; positions, velocities and animation
+ * frames live in the store and are stepped and drawn without the VM.
+ */
+
+#include "SpriteBinding.h"
+#include "GfxBinding.h"
+#include "render/Canvas2D.h"
+#include "render/SpriteStore.h"
+#include "script/BindingUtils.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace arcanee::script {
+
+using render::SpriteSheet;
+using render::SpriteState;
+using render::SpriteStore;
+
+namespace {
+
+constexpr const SQChar *kSpritesKey = "arcanee.sprites";
+
+SpriteStore *spritesOf(HSQUIRRELVM vm) {
+  SQUserPointer p = nullptr;
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kSpritesKey, -1);
+  if (SQ_SUCCEEDED(sq_rawget(vm, -2))) {
+    sq_getuserpointer(vm, -1, &p);
+    sq_pop(vm, 1);
+  }
+  sq_pop(vm, 1);
+  return static_cast<SpriteStore *>(p);
+}
+
+// ===== Settings tables =====
+
+enum class FieldKind : u8 { Float, Int, Count, Bool };
+
+struct Field {
+  const SQChar *name;
+  size_t offset;
+  FieldKind kind;
+};
+
+#define SHEET_FIELD(name, kind)                                                \
+  { #name, offsetof(SpriteSheet, name), FieldKind::kind }
+#define SPRITE_FIELD(name, kind)                                               \
+  { #name, offsetof(SpriteState, name), FieldKind::kind }
+
+constexpr Field kSheetFields[] = {
+    SHEET_FIELD(image, Count),     SHEET_FIELD(frameW, Count),
+    SHEET_FIELD(frameH, Count),    SHEET_FIELD(columns, Count),
+    SHEET_FIELD(originX, Float),   SHEET_FIELD(originY, Float),
+};
+
+constexpr Field kSpriteFields[] = {
+    SPRITE_FIELD(sheet, Count), SPRITE_FIELD(x, Float),
+    SPRITE_FIELD(y, Float),     SPRITE_FIELD(vx, Float),
+    SPRITE_FIELD(vy, Float),    SPRITE_FIELD(ax, Float),
+    SPRITE_FIELD(ay, Float),    SPRITE_FIELD(layer, Int),
+    SPRITE_FIELD(frame, Count), SPRITE_FIELD(scale, Float),
+    SPRITE_FIELD(alpha, Float), SPRITE_FIELD(visible, Bool),
+};
+
+#undef SHEET_FIELD
+#undef SPRITE_FIELD
+
+// Applies the fields of the table at @p idx (absolute) over @p base, whose
+// layout @p fields describes. Sets @p bad to the offending key on failure.
+template <size_t N>
+bool readFields(HSQUIRRELVM vm, SQInteger idx, const Field (&fields)[N],
+                void *base, const SQChar *&bad) {
+  bad = "";
+  if (sq_gettype(vm, idx) != OT_TABLE)
+    return false;
+
+  u8 *bytes = static_cast<u8 *>(base);
+  sq_pushnull(vm);
+  while (SQ_SUCCEEDED(sq_next(vm, idx))) {
+    const SQChar *key = nullptr;
+    const Field *field = nullptr;
+    if (SQ_SUCCEEDED(sq_getstring(vm, -2, &key))) {
+      for (const auto &f : fields) {
+        if (std::strcmp(f.name, key) == 0)
+          field = &f;
+      }
+    }
+
+    bool ok = field != nullptr;
+    u8 *dst = ok ? bytes + field->offset : nullptr;
+    if (ok && field->kind == FieldKind::Float) {
+      SQFloat v;
+      ok = SQ_SUCCEEDED(sq_getfloat(vm, -1, &v));
+      if (ok)
+        *reinterpret_cast<f32 *>(dst) = static_cast<f32>(v);
+    } else if (ok && field->kind == FieldKind::Bool) {
+      SQBool v;
+      ok = SQ_SUCCEEDED(sq_getbool(vm, -1, &v));
+      if (ok)
+        *reinterpret_cast<bool *>(dst) = v != SQFalse;
+    } else if (ok) {
+      SQInteger v;
+      ok = SQ_SUCCEEDED(sq_getinteger(vm, -1, &v)) &&
+           (field->kind == FieldKind::Int || v >= 0);
+      if (ok && field->kind == FieldKind::Int)
+        *reinterpret_cast<i32 *>(dst) = static_cast<i32>(v);
+      else if (ok)
+        *reinterpret_cast<u32 *>(dst) = static_cast<u32>(v);
+    }
+    if (!ok) {
+      bad = key ? key : "";
+      sq_pop(vm, 3); // Key, value, iterator
+      return false;
+    }
+    sq_pop(vm, 2);
+  }
+  sq_pop(vm, 1);
+  return true;
+}
+
+SQInteger settingsError(HSQUIRRELVM vm, SQInteger arg, const SQChar *bad) {
+  char expected[128];
+  if (*bad) {
+    snprintf(expected, sizeof(expected),
+             "a settings table (bad or unknown field '%s')", bad);
+  } else {
+    snprintf(expected, sizeof(expected), "a settings table");
+  }
+  return bindingTypeError(vm, arg, expected);
+}
+
+bool getHandle(HSQUIRRELVM vm, SQInteger idx, u32 &out) {
+  SQInteger v;
+  if (SQ_FAILED(sq_getinteger(vm, idx, &v)) || v <= 0 || v > 0xFFFFFFFF)
+    return false;
+  out = static_cast<u32>(v);
+  return true;
+}
+
+bool getNumbers(HSQUIRRELVM vm, SQInteger idx, f32 &a, f32 &b) {
+  SQFloat x, y;
+  if (SQ_FAILED(sq_getfloat(vm, idx, &x)) ||
+      SQ_FAILED(sq_getfloat(vm, idx + 1, &y))) {
+    return false;
+  }
+  a = static_cast<f32>(x);
+  b = static_cast<f32>(y);
+  return true;
+}
+
+// ===== sprites.* =====
+
+// sprites.sheet(settings) -> sheet id, or null; columns default to as many
+// frames as fit across the image
+SQInteger sprites_sheet(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  SpriteSheet sheet;
+  sheet.columns = 0;
+  const SQChar *bad;
+  if (!readFields(vm, 2, kSheetFields, &sheet, bad))
+    return settingsError(vm, 1, bad);
+  if (sheet.frameW == 0 || sheet.frameH == 0)
+    return bindingTypeError(vm, 1, "a settings table with frameW and frameH");
+
+  if (sheet.columns == 0) {
+    render::Canvas2D *canvas = getGfxCanvas();
+    u32 w = 0, h = 0;
+    if (!canvas || !canvas->getImageSize(sheet.image, w, h)) {
+      setLastError(vm, "sprites.sheet: unknown image; give columns");
+      sq_pushnull(vm);
+      return 1;
+    }
+    sheet.columns = w / sheet.frameW;
+  }
+
+  SpriteStore *sprites = spritesOf(vm);
+  u32 id = sprites ? sprites->defineSheet(sheet) : 0;
+  if (id == 0)
+    sq_pushnull(vm);
+  else
+    sq_pushinteger(vm, static_cast<SQInteger>(id));
+  return 1;
+}
+
+// sprites.create(settings) -> handle, or null
+SQInteger sprites_create(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  SpriteState state;
+  const SQChar *bad;
+  if (!readFields(vm, 2, kSpriteFields, &state, bad))
+    return settingsError(vm, 1, bad);
+
+  SpriteStore *sprites = spritesOf(vm);
+  if (!sprites || !sprites->getSheet(state.sheet))
+    return settingsError(vm, 1, "sheet");
+  u32 handle = sprites->create(state);
+  if (handle == 0) {
+    setLastError(vm, "sprites.create: too many sprites");
+    sq_pushnull(vm);
+    return 1;
+  }
+  sq_pushinteger(vm, static_cast<SQInteger>(handle));
+  return 1;
+}
+
+// sprites.set(handle, settings) -> bool; only the given fields change
+SQInteger sprites_set(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 3)
+    return bindingArityError(vm, 2, 2);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "a sprite handle");
+
+  SpriteStore *sprites = spritesOf(vm);
+  SpriteState state;
+  if (!sprites || !sprites->getState(handle, state)) {
+    sq_pushbool(vm, SQFalse);
+    return 1;
+  }
+  const SQChar *bad;
+  if (!readFields(vm, 3, kSpriteFields, &state, bad))
+    return settingsError(vm, 2, bad);
+  if (!sprites->getSheet(state.sheet))
+    return settingsError(vm, 2, "sheet");
+  sq_pushbool(vm, sprites->setState(handle, state) ? SQTrue : SQFalse);
+  return 1;
+}
+
+// sprites.get(handle) -> settings table plus playing, or null
+SQInteger sprites_get(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "a sprite handle");
+
+  SpriteStore *sprites = spritesOf(vm);
+  SpriteState state;
+  if (!sprites || !sprites->getState(handle, state)) {
+    sq_pushnull(vm);
+    return 1;
+  }
+  const u8 *base = reinterpret_cast<const u8 *>(&state);
+  sq_newtable(vm);
+  for (const auto &f : kSpriteFields) {
+    sq_pushstring(vm, f.name, -1);
+    const u8 *src = base + f.offset;
+    switch (f.kind) {
+    case FieldKind::Float:
+      sq_pushfloat(vm, *reinterpret_cast<const f32 *>(src));
+      break;
+    case FieldKind::Int:
+      sq_pushinteger(vm, *reinterpret_cast<const i32 *>(src));
+      break;
+    case FieldKind::Count:
+      sq_pushinteger(vm, static_cast<SQInteger>(
+                             *reinterpret_cast<const u32 *>(src)));
+      break;
+    case FieldKind::Bool:
+      sq_pushbool(vm, *reinterpret_cast<const bool *>(src) ? SQTrue : SQFalse);
+      break;
+    }
+    sq_newslot(vm, -3, SQFalse);
+  }
+  sq_pushstring(vm, "playing", -1);
+  sq_pushbool(vm, sprites->playing(handle) ? SQTrue : SQFalse);
+  sq_newslot(vm, -3, SQFalse);
+  return 1;
+}
+
+// sprites.setPos(handle, x, y) -> bool
+SQInteger sprites_setPos(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 4)
+    return bindingArityError(vm, 3, 3);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "a sprite handle");
+  f32 x, y;
+  if (!getNumbers(vm, 3, x, y))
+    return bindingTypeError(vm, 2, "a number");
+  SpriteStore *sprites = spritesOf(vm);
+  bool ok = sprites && sprites->setPosition(handle, x, y);
+  sq_pushbool(vm, ok ? SQTrue : SQFalse);
+  return 1;
+}
+
+// sprites.setVel(handle, vx, vy) -> bool
+SQInteger sprites_setVel(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 4)
+    return bindingArityError(vm, 3, 3);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "a sprite handle");
+  f32 vx, vy;
+  if (!getNumbers(vm, 3, vx, vy))
+    return bindingTypeError(vm, 2, "a number");
+  SpriteStore *sprites = spritesOf(vm);
+  bool ok = sprites && sprites->setVelocity(handle, vx, vy);
+  sq_pushbool(vm, ok ? SQTrue : SQFalse);
+  return 1;
+}
+
+// sprites.play(handle, first, count, fps [, loop = true]) -> bool
+SQInteger sprites_play(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 5 || top > 6)
+    return bindingArityError(vm, 4, 5);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "a sprite handle");
+  SQInteger first, count;
+  if (SQ_FAILED(sq_getinteger(vm, 3, &first)) || first < 0)
+    return bindingTypeError(vm, 2, "a non-negative integer");
+  if (SQ_FAILED(sq_getinteger(vm, 4, &count)) || count < 1)
+    return bindingTypeError(vm, 3, "a positive integer");
+  SQFloat fps;
+  if (SQ_FAILED(sq_getfloat(vm, 5, &fps)) || fps < 0)
+    return bindingTypeError(vm, 4, "a non-negative number");
+  SQBool loop = SQTrue;
+  if (top == 6 && SQ_FAILED(sq_getbool(vm, 6, &loop)))
+    return bindingTypeError(vm, 5, "a bool");
+
+  SpriteStore *sprites = spritesOf(vm);
+  bool ok = sprites && sprites->play(handle, static_cast<u32>(first),
+                                     static_cast<u32>(count),
+                                     static_cast<f32>(fps), loop != SQFalse);
+  sq_pushbool(vm, ok ? SQTrue : SQFalse);
+  return 1;
+}
+
+// sprites.playing(handle) -> bool
+SQInteger sprites_playing(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "a sprite handle");
+  SpriteStore *sprites = spritesOf(vm);
+  sq_pushbool(vm, sprites && sprites->playing(handle) ? SQTrue : SQFalse);
+  return 1;
+}
+
+// sprites.alive(handle) -> bool; false once freed, even if the slot is reused
+SQInteger sprites_alive(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "a sprite handle");
+  SpriteStore *sprites = spritesOf(vm);
+  sq_pushbool(vm, sprites && sprites->alive(handle) ? SQTrue : SQFalse);
+  return 1;
+}
+
+// sprites.free(handle) -> bool
+SQInteger sprites_free(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "a sprite handle");
+  SpriteStore *sprites = spritesOf(vm);
+  bool freed = sprites && sprites->destroy(handle);
+  sq_pushbool(vm, freed ? SQTrue : SQFalse);
+  return 1;
+}
+
+// sprites.count() -> live sprites
+SQInteger sprites_count(HSQUIRRELVM vm) {
+  SpriteStore *sprites = spritesOf(vm);
+  sq_pushinteger(vm, sprites ? static_cast<SQInteger>(sprites->count()) : 0);
+  return 1;
+}
+
+// sprites.clear() -> frees every sprite and sheet
+SQInteger sprites_clear(HSQUIRRELVM vm) {
+  if (SpriteStore *sprites = spritesOf(vm))
+    sprites->clear();
+  return 0;
+}
+
+// sprites.draw() -> sprites drawn, in one batch on the gfx canvas
+SQInteger sprites_draw(HSQUIRRELVM vm) {
+  SpriteStore *sprites = spritesOf(vm);
+  render::Canvas2D *canvas = getGfxCanvas();
+  u32 drawn = 0;
+  if (sprites && canvas && sprites->count() > 0) {
+    FrameArena::Scope scratch(bindingArena());
+    auto *rects =
+        bindingArena().allocArray<render::Canvas2D::ImageRect>(
+            sprites->count());
+    drawn = sprites->writeDrawList(rects);
+    canvas->drawImageRects(rects, drawn);
+  }
+  sq_pushinteger(vm, static_cast<SQInteger>(drawn));
+  return 1;
+}
+
+constexpr NativeFunction kSpriteFunctions[] = {
+    {"sheet", sprites_sheet},     {"create", sprites_create},
+    {"set", sprites_set},         {"get", sprites_get},
+    {"setPos", sprites_setPos},   {"setVel", sprites_setVel},
+    {"play", sprites_play},       {"playing", sprites_playing},
+    {"alive", sprites_alive},     {"free", sprites_free},
+    {"count", sprites_count},     {"clear", sprites_clear},
+    {"draw", sprites_draw},
+};
+
+} // namespace
+
+void registerSpriteBinding(HSQUIRRELVM vm, render::SpriteStore *sprites) {
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kSpritesKey, -1);
+  sq_pushuserpointer(vm, sprites);
+  sq_newslot(vm, -3, SQFalse);
+  sq_pop(vm, 1);
+
+  BindTable(vm, "sprites", kSpriteFunctions);
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <squirrel.h>
+
+namespace arcanee::render {
+class SpriteStore;
+}
+
+namespace arcanee::script {
+
+/**
+ * @brief Register the sprites.* functions (sheet, create, set, get, setPos,
+ * setVel, play, playing, alive, free, count, clear, draw), all driving
+ * @p sprites.
+ *
+ * Sprites move and animate natively on the fixed tick; sprites.draw()
+ * renders all of them in one batch, sorted by layer and image.
+ */
+void registerSpriteBinding(HSQUIRRELVM vm, render::SpriteStore *sprites);
+
+} // namespace arcanee::script
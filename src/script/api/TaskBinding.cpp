@@ -0,0 +1,280 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file TaskBinding.cpp
+ * @brief Cooperative script tasks (task.*) on top of TaskScheduler.
+ *
+ * Futures are plain tables (status, result, error) sharing one delegate, so
+ * a settled future is ordinary script data: it survives snapshots and the
+ * heap hash sees it like any other table.
+ */
+
+#include "TaskBinding.h"
+#include "common/Log.h"
+#include "script/BindingUtils.h"
+#include "script/TaskScheduler.h"
+#include <string>
+
+namespace arcanee::script {
+
+namespace {
+
+constexpr const SQChar *kSchedulerKey = "arcanee.tasks";
+constexpr const SQChar *kFutureKey = "arcanee.task";
+constexpr const SQChar *kDriverKey = "arcanee.task.driver";
+constexpr SQInteger kTaskStackSize = 256;
+
+// Steps a generator task: one resume per scheduler step, awaiting any
+// future the generator yields
+constexpr const SQChar kDriverSource[] =
+    "return function(yieldfn, awaitfn) {"
+    "  return function(g) {"
+    "    while (true) {"
+    "      local v = resume g;"
+    "      if (g.getstatus() == \"dead\") return v;"
+    "      if (typeof v == \"Task\") awaitfn(v); else yieldfn();"
+    "    }"
+    "  }"
+    "}";
+
+// Pushes registry[key]
+bool pushRegistryValue(HSQUIRRELVM vm, const SQChar *key) {
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, key, -1);
+  if (SQ_FAILED(sq_rawget(vm, -2))) {
+    sq_pop(vm, 1);
+    return false;
+  }
+  sq_remove(vm, -2);
+  return true;
+}
+
+TaskScheduler *schedulerOf(HSQUIRRELVM vm) {
+  SQUserPointer p = nullptr;
+  if (pushRegistryValue(vm, kSchedulerKey)) {
+    sq_getuserpointer(vm, -1, &p);
+    sq_pop(vm, 1);
+  }
+  return static_cast<TaskScheduler *>(p);
+}
+
+bool isFuture(HSQUIRRELVM vm, SQInteger idx) {
+  if (sq_gettype(vm, idx) != OT_TABLE)
+    return false;
+  HSQOBJECT delegate, expected;
+  sq_getdelegate(vm, idx);
+  sq_getstackobj(vm, -1, &delegate);
+  bool ok = pushRegistryValue(vm, kFutureKey);
+  if (ok) {
+    sq_getstackobj(vm, -1, &expected);
+    ok = delegate._type == OT_TABLE &&
+         delegate._unVal.pTable == expected._unVal.pTable;
+    sq_pop(vm, 1);
+  }
+  sq_pop(vm, 1);
+  return ok;
+}
+
+// Pushes future[key], or null
+void pushField(HSQUIRRELVM vm, SQInteger idx, const SQChar *key) {
+  sq_push(vm, idx);
+  sq_pushstring(vm, key, -1);
+  if (SQ_FAILED(sq_rawget(vm, -2)))
+    sq_pushnull(vm);
+  sq_remove(vm, -2);
+}
+
+// ===== task.* =====
+
+// task.spawn(fn | generator [, priority]) -> future
+SQInteger task_spawn(HSQUIRRELVM vm) {
+  SQInteger top = sq_gettop(vm);
+  if (top < 2 || top > 3)
+    return bindingArityError(vm, 1, 2);
+
+  SQObjectType type = sq_gettype(vm, 2);
+  bool generator = type == OT_GENERATOR;
+  if (!generator && type != OT_CLOSURE && type != OT_NATIVECLOSURE)
+    return bindingTypeError(vm, 1, "a function or a generator");
+
+  SQInteger priority = 0;
+  if (top == 3 && SQ_FAILED(sq_getinteger(vm, 3, &priority)))
+    return bindingTypeError(vm, 2, "an integer");
+
+  TaskScheduler *scheduler = schedulerOf(vm);
+  if (!scheduler || (generator && !pushRegistryValue(vm, kDriverKey))) {
+    setLastError(vm, "task.spawn: task support is not initialized");
+    sq_pushnull(vm);
+    return 1;
+  }
+  SQInteger fn = generator ? sq_gettop(vm) : 2;
+
+  HSQUIRRELVM thread = sq_newthread(vm, kTaskStackSize);
+  HSQOBJECT threadObj;
+  sq_getstackobj(vm, -1, &threadObj);
+  sq_addref(vm, &threadObj);
+  sq_pop(vm, 1);
+  sq_setforeignptr(thread, sq_getforeignptr(vm));
+
+  // Stack of the new thread: fn, this [, generator]
+  sq_move(thread, vm, fn);
+  sq_pushroottable(thread);
+  if (generator) {
+    sq_move(thread, vm, 2);
+    sq_pop(vm, 1); // driver
+  }
+
+  sq_newtable(vm);
+  sq_pushstring(vm, "status", -1);
+  sq_pushstring(vm, "pending", -1);
+  sq_rawset(vm, -3);
+  pushRegistryValue(vm, kFutureKey);
+  sq_setdelegate(vm, -2);
+  HSQOBJECT future;
+  sq_getstackobj(vm, -1, &future);
+  sq_addref(vm, &future);
+
+  scheduler->add(thread, threadObj, generator ? 2 : 1, future,
+                 static_cast<i32>(priority));
+  return 1;
+}
+
+// task.yield(): give up the rest of this step
+SQInteger task_yield(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 1)
+    return bindingArityError(vm, 0, 0);
+  TaskScheduler *scheduler = schedulerOf(vm);
+  if (!scheduler) {
+    sq_pushnull(vm);
+    return 1;
+  }
+  return scheduler->suspend(vm, nullptr);
+}
+
+// task.await(future) -> its result (null if it failed or was cancelled)
+SQInteger task_await(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  if (!isFuture(vm, 2))
+    return bindingTypeError(vm, 1, "a task future");
+
+  HSQOBJECT future;
+  sq_getstackobj(vm, 2, &future);
+  TaskScheduler *scheduler = schedulerOf(vm);
+  if (!scheduler || !TaskScheduler::isPending(vm, future)) {
+    pushField(vm, 2, "result");
+    return 1;
+  }
+  return scheduler->suspend(vm, &future);
+}
+
+// task.current() -> future of the running task, or null
+SQInteger task_current(HSQUIRRELVM vm) {
+  TaskScheduler *scheduler = schedulerOf(vm);
+  const HSQOBJECT *future = scheduler ? scheduler->currentFuture() : nullptr;
+  if (future)
+    sq_pushobject(vm, *future);
+  else
+    sq_pushnull(vm);
+  return 1;
+}
+
+// task.count() -> tasks not yet finished
+SQInteger task_count(HSQUIRRELVM vm) {
+  TaskScheduler *scheduler = schedulerOf(vm);
+  sq_pushinteger(vm,
+                 scheduler ? static_cast<SQInteger>(scheduler->size()) : 0);
+  return 1;
+}
+
+constexpr NativeFunction kTaskFunctions[] = {
+    {"spawn", task_spawn}, {"yield", task_yield}, {"await", task_await},
+    {"current", task_current}, {"count", task_count},
+};
+
+// ===== Future delegate =====
+
+SQInteger future_typeof(HSQUIRRELVM vm) {
+  sq_pushstring(vm, "Task", -1);
+  return 1;
+}
+
+// future.done() -> true once the task finished, failed or was cancelled
+SQInteger future_done(HSQUIRRELVM vm) {
+  HSQOBJECT future;
+  sq_getstackobj(vm, 1, &future);
+  sq_pushbool(vm, TaskScheduler::isPending(vm, future) ? SQFalse : SQTrue);
+  return 1;
+}
+
+// future.cancel() -> false if the task had already ended
+SQInteger future_cancel(HSQUIRRELVM vm) {
+  HSQOBJECT future;
+  sq_getstackobj(vm, 1, &future);
+  TaskScheduler *scheduler = schedulerOf(vm);
+  bool cancelled = scheduler && scheduler->cancel(vm, future);
+  sq_pushbool(vm, cancelled ? SQTrue : SQFalse);
+  return 1;
+}
+
+constexpr NativeFunction kFutureFunctions[] = {
+    {"_typeof", future_typeof},
+    {"done", future_done},
+    {"cancel", future_cancel},
+};
+
+void pushNamedClosure(HSQUIRRELVM vm, SQFUNCTION fn, const SQChar *name) {
+  sq_newclosure(vm, fn, 0);
+  sq_setnativeclosurename(vm, -1, name);
+}
+
+} // namespace
+
+void registerTaskBinding(HSQUIRRELVM vm, TaskScheduler *scheduler) {
+  sq_pushregistrytable(vm);
+
+  sq_pushstring(vm, kSchedulerKey, -1);
+  sq_pushuserpointer(vm, scheduler);
+  sq_newslot(vm, -3, SQFalse);
+
+  sq_pushstring(vm, kFutureKey, -1);
+  sq_newtable(vm);
+  for (const auto &fn : kFutureFunctions) {
+    sq_pushstring(vm, fn.name, -1);
+    pushNamedClosure(vm, fn.func,
+                     (std::string("Task.") + fn.name).c_str());
+    sq_newslot(vm, -3, SQFalse);
+  }
+  sq_newslot(vm, -3, SQFalse);
+
+  // driver = factory(yield, await); without it generators cannot be spawned
+  SQInteger top = sq_gettop(vm);
+  sq_pushstring(vm, kDriverKey, -1);
+  bool ok = SQ_SUCCEEDED(sq_compilebuffer(
+      vm, kDriverSource, sizeof(kDriverSource) - 1, "task.driver", SQFalse));
+  if (ok) {
+    sq_pushroottable(vm);
+    ok = SQ_SUCCEEDED(sq_call(vm, 1, SQTrue, SQFalse));
+  }
+  if (ok) {
+    sq_pushroottable(vm);
+    pushNamedClosure(vm, task_yield, "task.yield");
+    pushNamedClosure(vm, task_await, "task.await");
+    ok = SQ_SUCCEEDED(sq_call(vm, 3, SQTrue, SQFalse));
+  }
+  if (ok) {
+    sq_remove(vm, -2); // factory
+    sq_remove(vm, -2); // compiled chunk
+    sq_newslot(vm, -3, SQFalse);
+  } else {
+    LOG_ERROR("task: failed to build the generator driver");
+  }
+  sq_settop(vm, top);
+  sq_pop(vm, 1); // registry
+
+  BindTable(vm, "task", kTaskFunctions);
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <squirrel.h>
+
+namespace arcanee::script {
+
+class TaskScheduler;
+
+/**
+ * @brief Register the task.* functions (spawn, yield, await, current, count)
+ * and the future delegate, all driving @p scheduler.
+ *
+ * task.spawn(fn | generator [, priority]) returns a future. A function runs
+ * on its own thread and pauses with task.yield() or task.await(future); a
+ * generator is resumed once per step, and yielding a future awaits it.
+ */
+void registerTaskBinding(HSQUIRRELVM vm, TaskScheduler *scheduler);
+
+} // namespace arcanee::script
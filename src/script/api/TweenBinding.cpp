@@ -0,0 +1,444 @@
+/**
+ * ARCANEE - Modern Fantasy Console
+ * Copyright (C) 2025 Michele Fabbri
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ *
+ * @file TweenBinding.cpp
+ * @brief Native tweens (tweens.*) on top of TweenSystem.
+ *
+ * Scripts describe a tween once; its curve is evaluated and written into a
+ * Float32Buffer slot or a sprite property every tick without the VM.
+ */
+
+#include "TweenBinding.h"
+#include "anim/TweenSystem.h"
+#include "render/SpriteStore.h"
+#include "script/BindingUtils.h"
+#include "script/api/BufferBinding.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace arcanee::script {
+
+using anim::Ease;
+using anim::TweenSpec;
+using anim::TweenSystem;
+using anim::TweenTarget;
+using render::SpriteProperty;
+using render::SpriteStore;
+
+namespace {
+
+constexpr const SQChar *kTweensKey = "arcanee.tweens";
+constexpr const SQChar *kSpritesKey = "arcanee.tweens.sprites";
+// Handle -> [buffer, onDone], for tweens that hold either
+constexpr const SQChar *kHooksKey = "arcanee.tweens.hooks";
+
+struct EaseName {
+  const SQChar *name;
+  Ease ease;
+};
+
+constexpr EaseName kEases[] = {
+    {"linear", Ease::Linear},         {"quadIn", Ease::QuadIn},
+    {"quadOut", Ease::QuadOut},       {"quadInOut", Ease::QuadInOut},
+    {"cubicIn", Ease::CubicIn},       {"cubicOut", Ease::CubicOut},
+    {"cubicInOut", Ease::CubicInOut}, {"sineIn", Ease::SineIn},
+    {"sineOut", Ease::SineOut},       {"sineInOut", Ease::SineInOut},
+    {"expoIn", Ease::ExpoIn},         {"expoOut", Ease::ExpoOut},
+    {"expoInOut", Ease::ExpoInOut},   {"backIn", Ease::BackIn},
+    {"backOut", Ease::BackOut},       {"backInOut", Ease::BackInOut},
+    {"elasticOut", Ease::ElasticOut}, {"bounceOut", Ease::BounceOut},
+};
+
+struct PropertyName {
+  const SQChar *name;
+  SpriteProperty property;
+};
+
+constexpr PropertyName kProperties[] = {
+    {"x", SpriteProperty::X},
+    {"y", SpriteProperty::Y},
+    {"scale", SpriteProperty::Scale},
+    {"alpha", SpriteProperty::Alpha},
+};
+
+void *registryPointer(HSQUIRRELVM vm, const SQChar *key) {
+  SQUserPointer p = nullptr;
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, key, -1);
+  if (SQ_SUCCEEDED(sq_rawget(vm, -2))) {
+    sq_getuserpointer(vm, -1, &p);
+    sq_pop(vm, 1);
+  }
+  sq_pop(vm, 1);
+  return p;
+}
+
+TweenSystem *tweensOf(HSQUIRRELVM vm) {
+  return static_cast<TweenSystem *>(registryPointer(vm, kTweensKey));
+}
+
+SpriteStore *spritesOf(HSQUIRRELVM vm) {
+  return static_cast<SpriteStore *>(registryPointer(vm, kSpritesKey));
+}
+
+// Pushes the hooks table
+void pushHooks(HSQUIRRELVM vm) {
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kHooksKey, -1);
+  sq_rawget(vm, -2);
+  sq_remove(vm, -2);
+}
+
+void dropHook(HSQUIRRELVM vm, u32 handle) {
+  pushHooks(vm);
+  sq_pushinteger(vm, static_cast<SQInteger>(handle));
+  sq_rawdeleteslot(vm, -2, SQFalse);
+  sq_pop(vm, 1);
+}
+
+// ===== Settings tables =====
+
+struct Request {
+  TweenTarget target;
+  TweenSpec spec;
+  HSQOBJECT buffer; // Null unless the target is a buffer slot
+  HSQOBJECT onDone; // Null if none
+};
+
+// Reads the settings table at @p idx (absolute). The objects in @p out are
+// borrowed from the table. Sets @p bad to the offending key on failure.
+bool readRequest(HSQUIRRELVM vm, SQInteger idx, SpriteStore *sprites,
+                 Request &out, const SQChar *&bad) {
+  bad = "";
+  if (sq_gettype(vm, idx) != OT_TABLE)
+    return false;
+
+  sq_resetobject(&out.buffer);
+  sq_resetobject(&out.onDone);
+  BufferView view;
+  SQInteger index = 0;
+  bool hasFrom = false, hasTo = false;
+
+  sq_pushnull(vm);
+  while (SQ_SUCCEEDED(sq_next(vm, idx))) {
+    const SQChar *key = "";
+    SQInteger n = 0;
+    SQFloat f = 0;
+    SQBool b = SQFalse;
+    const SQChar *s = nullptr;
+    bool ok = SQ_SUCCEEDED(sq_getstring(vm, -2, &key));
+    if (!ok) {
+      key = "";
+    } else if (std::strcmp(key, "buffer") == 0) {
+      ok = getBuffer(vm, -1, view) && view.type == BufferType::Float32;
+      sq_getstackobj(vm, -1, &out.buffer);
+    } else if (std::strcmp(key, "index") == 0) {
+      ok = SQ_SUCCEEDED(sq_getinteger(vm, -1, &index)) && index >= 0;
+    } else if (std::strcmp(key, "sprite") == 0) {
+      ok = SQ_SUCCEEDED(sq_getinteger(vm, -1, &n)) && n > 0 &&
+           n <= 0xFFFFFFFF;
+      out.target.sprite = static_cast<u32>(n);
+    } else if (std::strcmp(key, "property") == 0) {
+      ok = false;
+      if (SQ_SUCCEEDED(sq_getstring(vm, -1, &s))) {
+        for (const auto &p : kProperties) {
+          if (std::strcmp(p.name, s) == 0) {
+            out.target.property = p.property;
+            ok = true;
+          }
+        }
+      }
+    } else if (std::strcmp(key, "from") == 0) {
+      ok = hasFrom = SQ_SUCCEEDED(sq_getfloat(vm, -1, &f));
+      out.spec.from = static_cast<f32>(f);
+    } else if (std::strcmp(key, "to") == 0) {
+      ok = hasTo = SQ_SUCCEEDED(sq_getfloat(vm, -1, &f));
+      out.spec.to = static_cast<f32>(f);
+    } else if (std::strcmp(key, "duration") == 0) {
+      ok = SQ_SUCCEEDED(sq_getfloat(vm, -1, &f)) && f >= 0;
+      out.spec.duration = static_cast<f32>(f);
+    } else if (std::strcmp(key, "delay") == 0) {
+      ok = SQ_SUCCEEDED(sq_getfloat(vm, -1, &f)) && f >= 0;
+      out.spec.delay = static_cast<f32>(f);
+    } else if (std::strcmp(key, "ease") == 0) {
+      ok = false;
+      if (SQ_SUCCEEDED(sq_getstring(vm, -1, &s))) {
+        for (const auto &e : kEases) {
+          if (std::strcmp(e.name, s) == 0) {
+            out.spec.ease = e.ease;
+            ok = true;
+          }
+        }
+      }
+    } else if (std::strcmp(key, "repeat") == 0) {
+      ok = SQ_SUCCEEDED(sq_getinteger(vm, -1, &n)) && n >= -1 &&
+           n <= 0x7FFFFFFF;
+      out.spec.repeat = static_cast<i32>(n);
+    } else if (std::strcmp(key, "yoyo") == 0) {
+      ok = SQ_SUCCEEDED(sq_getbool(vm, -1, &b));
+      out.spec.yoyo = b != SQFalse;
+    } else if (std::strcmp(key, "onDone") == 0) {
+      SQObjectType type = sq_gettype(vm, -1);
+      ok = type == OT_CLOSURE || type == OT_NATIVECLOSURE;
+      sq_getstackobj(vm, -1, &out.onDone);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      bad = key;
+      sq_pop(vm, 3); // Key, value, iterator
+      return false;
+    }
+    sq_pop(vm, 2);
+  }
+  sq_pop(vm, 1);
+
+  // Exactly one target, and something to tween to
+  const bool hasBuffer = view.data != nullptr;
+  if (hasBuffer == (out.target.sprite != 0)) {
+    bad = hasBuffer ? "sprite" : "buffer";
+    return false;
+  }
+  if (hasBuffer && index >= view.length) {
+    bad = "index";
+    return false;
+  }
+  if (!hasBuffer && (!sprites || !sprites->alive(out.target.sprite))) {
+    bad = "sprite";
+    return false;
+  }
+  if (!hasTo) {
+    bad = "to";
+    return false;
+  }
+  if (hasBuffer)
+    out.target.value = view.floats() + index;
+  out.spec.fromCurrent = !hasFrom;
+  return true;
+}
+
+SQInteger settingsError(HSQUIRRELVM vm, SQInteger arg, const SQChar *bad) {
+  char expected[128];
+  if (*bad) {
+    snprintf(expected, sizeof(expected),
+             "a settings table (bad or unknown field '%s')", bad);
+  } else {
+    snprintf(expected, sizeof(expected), "a settings table");
+  }
+  return bindingTypeError(vm, arg, expected);
+}
+
+bool getHandle(HSQUIRRELVM vm, SQInteger idx, u32 &out) {
+  SQInteger v;
+  if (SQ_FAILED(sq_getinteger(vm, idx, &v)) || v <= 0 || v > 0xFFFFFFFF)
+    return false;
+  out = static_cast<u32>(v);
+  return true;
+}
+
+bool sameTarget(const TweenTarget &a, const TweenTarget &b) {
+  if (a.value || b.value)
+    return a.value == b.value;
+  return a.sprite == b.sprite && a.property == b.property;
+}
+
+// Starts @p req and keeps what it holds alive. 0 if the system is full.
+u32 startRequest(HSQUIRRELVM vm, TweenSystem &tweens, const Request &req) {
+  u32 handle = tweens.start(req.target, req.spec);
+  if (handle == 0 || (sq_isnull(req.buffer) && sq_isnull(req.onDone)))
+    return handle;
+
+  pushHooks(vm);
+  sq_pushinteger(vm, static_cast<SQInteger>(handle));
+  sq_newarray(vm, 0);
+  sq_pushobject(vm, req.buffer);
+  sq_arrayappend(vm, -2);
+  sq_pushobject(vm, req.onDone);
+  sq_arrayappend(vm, -2);
+  sq_rawset(vm, -3);
+  sq_pop(vm, 1);
+  return handle;
+}
+
+// ===== tweens.* =====
+
+// tweens.start(settings) -> handle, or null
+SQInteger tweens_start(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  TweenSystem *tweens = tweensOf(vm);
+  Request req;
+  const SQChar *bad;
+  if (!readRequest(vm, 2, spritesOf(vm), req, bad))
+    return settingsError(vm, 1, bad);
+
+  u32 handle = tweens ? startRequest(vm, *tweens, req) : 0;
+  if (handle == 0) {
+    setLastError(vm, "tweens.start: too many tweens");
+    sq_pushnull(vm);
+    return 1;
+  }
+  sq_pushinteger(vm, static_cast<SQInteger>(handle));
+  return 1;
+}
+
+// tweens.sequence(steps) -> array of handles, or null. Each step starts when
+// the one before ends; a step without from continues from the previous
+// step's to on the same target, else from the target's value
+SQInteger tweens_sequence(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  if (sq_gettype(vm, 2) != OT_ARRAY || sq_getsize(vm, 2) == 0)
+    return bindingTypeError(vm, 1, "a non-empty array of settings tables");
+
+  SpriteStore *sprites = spritesOf(vm);
+  const SQInteger n = sq_getsize(vm, 2);
+  std::vector<Request> steps(static_cast<size_t>(n));
+  f32 offset = 0.0f;
+  for (SQInteger i = 0; i < n; ++i) {
+    Request &req = steps[static_cast<size_t>(i)];
+    const SQChar *bad;
+    sq_pushinteger(vm, i);
+    sq_rawget(vm, 2);
+    bool ok = readRequest(vm, sq_gettop(vm), sprites, req, bad);
+    sq_pop(vm, 1);
+    if (ok && req.spec.repeat < 0 && i + 1 < n) {
+      bad = "repeat";
+      ok = false;
+    }
+    if (!ok)
+      return settingsError(vm, 1, bad);
+
+    const Request *prev = i > 0 ? &steps[static_cast<size_t>(i - 1)] : nullptr;
+    if (req.spec.fromCurrent && prev && sameTarget(prev->target, req.target)) {
+      // Its start value is known; reading the target would race the write
+      // that ends the previous step on the same tick
+      req.spec.from = prev->spec.to;
+      req.spec.fromCurrent = false;
+    }
+    req.spec.delay += offset;
+    offset = req.spec.delay +
+             req.spec.duration * static_cast<f32>(req.spec.repeat + 1);
+  }
+
+  TweenSystem *tweens = tweensOf(vm);
+  if (!tweens || tweens->count() + n > TweenSystem::kMaxTweens) {
+    setLastError(vm, "tweens.sequence: too many tweens");
+    sq_pushnull(vm);
+    return 1;
+  }
+  sq_newarray(vm, 0);
+  for (const Request &req : steps) {
+    sq_pushinteger(vm, static_cast<SQInteger>(startRequest(vm, *tweens, req)));
+    sq_arrayappend(vm, -2);
+  }
+  return 1;
+}
+
+// tweens.cancel(handle) -> bool; onDone is not called
+SQInteger tweens_cancel(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "a tween handle");
+  TweenSystem *tweens = tweensOf(vm);
+  bool cancelled = tweens && tweens->cancel(handle);
+  if (cancelled)
+    dropHook(vm, handle);
+  sq_pushbool(vm, cancelled ? SQTrue : SQFalse);
+  return 1;
+}
+
+// tweens.alive(handle) -> bool; false once finished or cancelled
+SQInteger tweens_alive(HSQUIRRELVM vm) {
+  if (sq_gettop(vm) != 2)
+    return bindingArityError(vm, 1, 1);
+  u32 handle;
+  if (!getHandle(vm, 2, handle))
+    return bindingTypeError(vm, 1, "a tween handle");
+  TweenSystem *tweens = tweensOf(vm);
+  sq_pushbool(vm, tweens && tweens->alive(handle) ? SQTrue : SQFalse);
+  return 1;
+}
+
+// tweens.count() -> running tweens, delayed ones included
+SQInteger tweens_count(HSQUIRRELVM vm) {
+  TweenSystem *tweens = tweensOf(vm);
+  sq_pushinteger(vm, tweens ? static_cast<SQInteger>(tweens->count()) : 0);
+  return 1;
+}
+
+// tweens.clear() -> cancels every tween
+SQInteger tweens_clear(HSQUIRRELVM vm) {
+  if (TweenSystem *tweens = tweensOf(vm))
+    tweens->clear();
+  pushHooks(vm);
+  sq_clear(vm, -1);
+  sq_pop(vm, 1);
+  return 0;
+}
+
+constexpr NativeFunction kTweenFunctions[] = {
+    {"start", tweens_start}, {"sequence", tweens_sequence},
+    {"cancel", tweens_cancel}, {"alive", tweens_alive},
+    {"count", tweens_count}, {"clear", tweens_clear},
+};
+
+} // namespace
+
+void registerTweenBinding(HSQUIRRELVM vm, anim::TweenSystem *tweens,
+                          render::SpriteStore *sprites) {
+  sq_pushregistrytable(vm);
+  sq_pushstring(vm, kTweensKey, -1);
+  sq_pushuserpointer(vm, tweens);
+  sq_newslot(vm, -3, SQFalse);
+  sq_pushstring(vm, kSpritesKey, -1);
+  sq_pushuserpointer(vm, sprites);
+  sq_newslot(vm, -3, SQFalse);
+  sq_pushstring(vm, kHooksKey, -1);
+  sq_newtable(vm);
+  sq_newslot(vm, -3, SQFalse);
+  sq_pop(vm, 1);
+
+  BindTable(vm, "tweens", kTweenFunctions);
+}
+
+void finishTweens(HSQUIRRELVM vm) {
+  TweenSystem *tweens = tweensOf(vm);
+  if (!tweens || tweens->finished().empty())
+    return;
+
+  // Callbacks may start, cancel or clear tweens
+  std::vector<TweenSystem::Finished> done;
+  done.swap(tweens->finished());
+
+  pushHooks(vm);
+  for (const auto &f : done) {
+    sq_pushinteger(vm, static_cast<SQInteger>(f.handle));
+    sq_rawdeleteslot(vm, -2, SQTrue);
+    if (f.completed && sq_gettype(vm, -1) != OT_NULL) {
+      sq_pushinteger(vm, 1);
+      sq_rawget(vm, -2);
+      if (sq_gettype(vm, -1) != OT_NULL) {
+        sq_pushroottable(vm);
+        sq_pushinteger(vm, static_cast<SQInteger>(f.handle));
+        sq_call(vm, 2, SQFalse, SQTrue); // Errors are reported, not fatal
+      }
+      sq_pop(vm, 1);
+    }
+    sq_pop(vm, 1);
+  }
+  sq_pop(vm, 1);
+
+  // Hand the storage back unless a callback queued more
+  if (tweens->finished().empty()) {
+    done.clear();
+    done.swap(tweens->finished());
+  }
+}
+
+} // namespace arcanee::script
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <squirrel.h>
+
+namespace arcanee::anim {
+class TweenSystem;
+}
+
+namespace arcanee::render {
+class SpriteStore;
+}
+
+namespace arcanee::script {
+
+/**
+ * @brief Register the tweens.* functions (start, sequence, cancel, alive,
+ * count, clear), all driving @p tweens. Sprite targets are handles of
+ * @p sprites.
+ *
+ * Tweens are evaluated natively on the fixed tick; script only runs when
+ * one is started and, through finishTweens(), when one with an onDone
+ * callback completes.
+ */
+void registerTweenBinding(HSQUIRRELVM vm, anim::TweenSystem *tweens,
+                          render::SpriteStore *sprites);
+
+/**
+ * @brief Drain the tweens' finished queue: drop what each ended tween held
+ * (its buffer, its callback) and call onDone(handle) for those that
+ * completed. Call with the VM idle, after TweenSystem::step().
+ */
+void finishTweens(HSQUIRRELVM vm);
+
+} // namespace arcanee::script
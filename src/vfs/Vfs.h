@@ -187,6 +187,9 @@ public:
 // VFS Configuration
 // ============================================================================
 
+/// Default bytes a cartridge may keep in save:/.
+constexpr u64 kDefaultSaveQuotaBytes = 50 * 1024 * 1024;
+
 /**
  * @brief VFS initialization configuration.
  */
@@ -196,7 +199,7 @@ struct VfsConfig {
   std::string saveRootPath;  ///< Base directory for save:/ mounts
   std::string tempRootPath;  ///< Base directory for temp:/ mounts
   bool saveEnabled = true;   ///< Allow writes to save:/
-  u64 saveQuotaBytes = 50 * 1024 * 1024;  ///< 50 MB default
+  u64 saveQuotaBytes = kDefaultSaveQuotaBytes; ///< 50 MB default
   u64 tempQuotaBytes = 100 * 1024 * 1024; ///< 100 MB default
 };
 
@@ -0,0 +1,112 @@
+/**
+ * @file ScriptTestVm.h
+ * @brief Bare Squirrel VM shared by the binding tests.
+ */
+#pragma once
+
+#include "script/BindingHelpers.h"
+#include "script/BindingUtils.h"
+#include <string>
+
+namespace arcanee::script::test {
+
+/**
+ * @brief Owns a VM with t.getLastError() bound; each test registers the
+ * bindings it exercises. Scripts store their outcome in the root slot
+ * "result". Fixtures derive from it next to ::testing::Test.
+ */
+class ScriptTestVm {
+public:
+  explicit ScriptTestVm(SQInteger stackSize = 1024) { open(stackSize); }
+  ~ScriptTestVm() { sq_close(m_vm); }
+
+  ScriptTestVm(const ScriptTestVm &) = delete;
+  ScriptTestVm &operator=(const ScriptTestVm &) = delete;
+
+  HSQUIRRELVM vm() const { return m_vm; }
+
+  /// Replace the VM with a fresh one; bindings must be registered again.
+  void reopen(SQInteger stackSize) {
+    sq_close(m_vm);
+    open(stackSize);
+  }
+
+  /// Compile and run @p code against the root table.
+  bool run(const std::string &code) {
+    if (SQ_FAILED(sq_compilebuffer(m_vm, code.c_str(),
+                                   static_cast<SQInteger>(code.size()),
+                                   "test", SQTrue))) {
+      return false;
+    }
+    sq_pushroottable(m_vm);
+    SQRESULT res = sq_call(m_vm, 1, SQFalse, SQTrue);
+    sq_pop(m_vm, 1);
+    return SQ_SUCCEEDED(res);
+  }
+
+  SQObjectType resultType() {
+    SQInteger top = sq_gettop(m_vm);
+    SQObjectType type = pushResult() ? sq_gettype(m_vm, -1) : OT_NULL;
+    sq_settop(m_vm, top);
+    return type;
+  }
+
+  SQInteger resultInt() {
+    SQInteger v = 0;
+    SQInteger top = sq_gettop(m_vm);
+    if (pushResult())
+      sq_getinteger(m_vm, -1, &v);
+    sq_settop(m_vm, top);
+    return v;
+  }
+
+  SQFloat resultFloat() {
+    SQFloat v = 0;
+    SQInteger top = sq_gettop(m_vm);
+    if (pushResult())
+      sq_getfloat(m_vm, -1, &v);
+    sq_settop(m_vm, top);
+    return v;
+  }
+
+  /// "result" converted with tostring(), or "" if it is missing.
+  std::string resultString() {
+    const SQChar *s = nullptr;
+    std::string str;
+    SQInteger top = sq_gettop(m_vm);
+    if (pushResult() && SQ_SUCCEEDED(sq_tostring(m_vm, -1)) &&
+        SQ_SUCCEEDED(sq_getstring(m_vm, -1, &s))) {
+      str = s;
+    }
+    sq_settop(m_vm, top);
+    return str;
+  }
+
+  /// The message of t.getLastError(), or "" if none is set.
+  std::string lastError() {
+    if (!run("::result <- t.getLastError();") || resultType() != OT_STRING)
+      return "";
+    return resultString();
+  }
+
+protected:
+  HSQUIRRELVM m_vm = nullptr;
+
+private:
+  static constexpr NativeFunction kFunctions[] = {
+      {"getLastError", sys_getLastError},
+  };
+
+  void open(SQInteger stackSize) {
+    m_vm = sq_open(stackSize);
+    BindTable(m_vm, "t", kFunctions);
+  }
+
+  bool pushResult() {
+    sq_pushroottable(m_vm);
+    sq_pushstring(m_vm, "result", -1);
+    return SQ_SUCCEEDED(sq_get(m_vm, -2));
+  }
+};
+
+} // namespace arcanee::script::test
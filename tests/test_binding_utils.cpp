@@ -0,0 +1,97 @@
+#include "ScriptTestVm.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace arcanee::script;
+
+namespace {
+
+SQFloat g_sum = 0;
+std::string g_text;
+
+void t_add4(SQFloat a, SQFloat b, SQFloat c, SQFloat d) {
+  g_sum = a + b + c + d;
+}
+
+SQInteger t_twice(SQInteger v) { return v * 2; }
+
+bool t_not(bool b) { return !b; }
+
+const SQChar *t_echo(const SQChar *s) { return s; }
+
+SQFloat t_opt(SQFloat base, std::optional<SQFloat> scale) {
+  return base * scale.value_or(10.0f);
+}
+
+void t_vm(HSQUIRRELVM vm, const SQChar *s) {
+  g_text = s;
+  setLastError(vm, "t.vm called");
+}
+
+constexpr NativeFunction kTestFunctions[] = {
+    {"add4", NativeCall<t_add4>}, {"twice", NativeCall<t_twice>},
+    {"not", NativeCall<t_not>},   {"echo", NativeCall<t_echo>},
+    {"opt", NativeCall<t_opt>},   {"vm", NativeCall<t_vm>},
+    {"getLastError", sys_getLastError},
+};
+
+// Replaces the shared "t" table, so it carries getLastError too
+class BindingUtilsTest : public ::testing::Test, protected test::ScriptTestVm {
+protected:
+  void SetUp() override { BindTable(m_vm, "t", kTestFunctions); }
+};
+
+} // namespace
+
+TEST_F(BindingUtilsTest, ConvertsArgumentsAndReturns) {
+  ASSERT_TRUE(run("t.add4(1, 2.5, 3, 4);"));
+  EXPECT_FLOAT_EQ(g_sum, 10.5f);
+
+  ASSERT_TRUE(run("::result <- t.twice(21);"));
+  EXPECT_EQ(resultInt(), 42);
+
+  ASSERT_TRUE(run("::result <- t.not(false) ? 1 : 0;"));
+  EXPECT_EQ(resultInt(), 1);
+
+  ASSERT_TRUE(run("::result <- t.echo(\"abc\") == \"abc\" ? 1 : 0;"));
+  EXPECT_EQ(resultInt(), 1);
+}
+
+TEST_F(BindingUtilsTest, OptionalTrailingArguments) {
+  ASSERT_TRUE(run("::result <- t.opt(2).tointeger();"));
+  EXPECT_EQ(resultInt(), 20);
+  ASSERT_TRUE(run("::result <- t.opt(2, 3).tointeger();"));
+  EXPECT_EQ(resultInt(), 6);
+  ASSERT_TRUE(run("::result <- t.opt(2, null).tointeger();"));
+  EXPECT_EQ(resultInt(), 20);
+}
+
+TEST_F(BindingUtilsTest, InjectsCallingVm) {
+  ASSERT_TRUE(run("t.vm(\"hello\");"));
+  EXPECT_EQ(g_text, "hello");
+  EXPECT_EQ(lastError(), "t.vm called");
+}
+
+TEST_F(BindingUtilsTest, ArityMismatchSetsLastErrorAndReturnsNull) {
+  g_sum = -1;
+  ASSERT_TRUE(run("::result <- t.add4(1, 2, 3);"));
+  EXPECT_EQ(resultType(), OT_NULL);
+  EXPECT_FLOAT_EQ(g_sum, -1.0f); // Not called
+  EXPECT_EQ(lastError(), "t.add4: Expected 4 arguments, got 3");
+
+  ASSERT_TRUE(run("::result <- t.opt(1, 2, 3);"));
+  EXPECT_EQ(lastError(), "t.opt: Expected 1 to 2 arguments, got 3");
+}
+
+TEST_F(BindingUtilsTest, TypeMismatchSetsLastErrorAndReturnsNull) {
+  ASSERT_TRUE(run("::result <- t.twice(\"x\");"));
+  EXPECT_EQ(resultType(), OT_NULL);
+  EXPECT_EQ(lastError(), "t.twice: arg 1 must be a number");
+
+  ASSERT_TRUE(run("::result <- t.opt(1, \"x\");"));
+  EXPECT_EQ(lastError(), "t.opt: arg 2 must be a number");
+
+  ASSERT_TRUE(run("::result <- t.not(1);"));
+  EXPECT_EQ(lastError(), "t.not: arg 1 must be a boolean");
+}
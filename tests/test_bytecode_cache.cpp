@@ -0,0 +1,79 @@
+#include "script/BytecodeCache.h"
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace arcanee::script;
+namespace fs = std::filesystem;
+
+#ifndef _WIN32
+
+namespace {
+
+class BytecodeCacheDirTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    m_root = fs::temp_directory_path() /
+             ("arcanee_bc_test_" + std::to_string(::getpid()));
+    fs::remove_all(m_root);
+    fs::create_directories(m_root);
+  }
+
+  void TearDown() override { fs::remove_all(m_root); }
+
+  static unsigned modeOf(const fs::path &p) {
+    struct stat st;
+    return ::lstat(p.c_str(), &st) == 0 ? st.st_mode & 0777 : 0;
+  }
+
+  fs::path m_root;
+};
+
+} // namespace
+
+TEST_F(BytecodeCacheDirTest, CreatesPrivateDirectories) {
+  fs::path dir = m_root / "cache" / "bytecode" / "cart";
+  BytecodeCache cache(dir.string(), true);
+
+  ASSERT_TRUE(cache.isEnabled());
+  EXPECT_EQ(modeOf(m_root / "cache"), 0700u);
+  EXPECT_EQ(modeOf(m_root / "cache" / "bytecode"), 0700u);
+  EXPECT_EQ(modeOf(dir), 0700u);
+}
+
+TEST_F(BytecodeCacheDirTest, TightensOwnSharedDirectory) {
+  fs::path dir = m_root / "shared";
+  fs::create_directories(dir);
+  ::chmod(dir.c_str(), 0777);
+
+  BytecodeCache cache(dir.string(), true);
+  EXPECT_TRUE(cache.isEnabled());
+  EXPECT_EQ(modeOf(dir), 0700u);
+}
+
+TEST_F(BytecodeCacheDirTest, RefusesSymlinkedDirectory) {
+  fs::create_directories(m_root / "target");
+  fs::create_directory_symlink(m_root / "target", m_root / "link");
+
+  BytecodeCache cache((m_root / "link").string(), true);
+  EXPECT_FALSE(cache.isEnabled());
+}
+
+TEST_F(BytecodeCacheDirTest, RefusesDirectoryOfAnotherUser) {
+  if (::geteuid() != 0) {
+    GTEST_SKIP() << "needs root to hand a directory to another user";
+  }
+  fs::path dir = m_root / "foreign";
+  fs::create_directories(dir);
+  ASSERT_EQ(::chown(dir.c_str(), 65534, 65534), 0);
+
+  BytecodeCache cache(dir.string(), true);
+  EXPECT_FALSE(cache.isEnabled());
+}
+
+#endif
@@ -0,0 +1,170 @@
+#include "ScriptTestVm.h"
+#include "common/Random.h"
+#include "physics/CollisionWorld.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/CollisionBinding.h"
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <limits>
+#include <string>
+#include <vector>
+
+using arcanee::f32;
+using arcanee::u32;
+using arcanee::physics::CollisionWorld;
+
+namespace {
+
+struct Bodies {
+  std::vector<f32> rects;
+  std::vector<u32> layers;
+  std::vector<u32> masks;
+
+  void add(f32 x, f32 y, f32 w, f32 h, u32 layer = 1, u32 mask = ~0u) {
+    rects.insert(rects.end(), {x, y, w, h});
+    layers.push_back(layer);
+    masks.push_back(mask);
+  }
+  u32 count() const { return static_cast<u32>(layers.size()); }
+};
+
+// Random boxes from tiny to several cells wide, a few huge ones included
+Bodies randomBodies(u32 n, arcanee::u64 seed) {
+  arcanee::Xorshift128Plus rng(seed);
+  Bodies b;
+  for (u32 i = 0; i < n; ++i) {
+    f32 x = static_cast<f32>(rng.randFloat() * 2000.0 - 1000.0);
+    f32 y = static_cast<f32>(rng.randFloat() * 2000.0 - 1000.0);
+    f32 w = static_cast<f32>(rng.randFloat() * 150.0);
+    f32 h = static_cast<f32>(rng.randFloat() * 150.0);
+    if (i % 97 == 0) {
+      w *= 20.0f;
+      h *= 20.0f;
+    }
+    b.add(x, y, w, h, 1u << rng.randRange(0, 3),
+          static_cast<u32>(rng.randRange(1, 15)));
+  }
+  return b;
+}
+
+bool boxesOverlap(const f32 *a, const f32 *b) {
+  return a[0] < b[0] + b[2] && b[0] < a[0] + a[2] && a[1] < b[1] + b[3] &&
+         b[1] < a[1] + a[3];
+}
+
+std::vector<u32> bruteForcePairs(const Bodies &b) {
+  std::vector<u32> pairs;
+  for (u32 i = 0; i < b.count(); ++i) {
+    for (u32 j = i + 1; j < b.count(); ++j) {
+      if (boxesOverlap(&b.rects[4 * i], &b.rects[4 * j]) &&
+          (b.layers[i] & b.masks[j]) && (b.layers[j] & b.masks[i])) {
+        pairs.push_back(i);
+        pairs.push_back(j);
+      }
+    }
+  }
+  return pairs;
+}
+
+} // namespace
+
+TEST(CollisionWorldTest, PairsMatchBruteForce) {
+  for (f32 cellSize : {16.0f, 64.0f, 200.0f}) {
+    Bodies b = randomBodies(600, 7);
+    CollisionWorld world(cellSize);
+    world.update(b.rects.data(), b.count(), b.layers.data(), b.masks.data());
+    if (cellSize < 100.0f) { // Only then do the huge boxes span > 16 cells
+      EXPECT_GT(world.getStats().oversized, 0u);
+    }
+    EXPECT_EQ(world.findPairs(), bruteForcePairs(b)) << cellSize;
+  }
+}
+
+TEST(CollisionWorldTest, LayerMasksMustAcceptEachOther) {
+  Bodies b;
+  b.add(0, 0, 10, 10, 0x1, 0x2);
+  b.add(5, 5, 10, 10, 0x2, 0x1); // Accepts 0 and is accepted
+  b.add(5, 0, 10, 10, 0x2, 0x4); // 0 accepts it, it does not accept 0
+  b.add(10, 0, 10, 10);          // Only touches 0's edge
+
+  CollisionWorld world;
+  world.update(b.rects.data(), b.count(), b.layers.data(), b.masks.data());
+  std::vector<u32> expected = {0, 1, 1, 3};
+  EXPECT_EQ(world.findPairs(), expected);
+}
+
+TEST(CollisionWorldTest, InactiveBodiesAreSkipped) {
+  const f32 nan = std::numeric_limits<f32>::quiet_NaN();
+  Bodies b;
+  b.add(0, 0, 10, 10);
+  b.add(2, 2, -1, 4);
+  b.add(nan, 0, 10, 10);
+  b.add(1, 1, 2, 2);
+
+  CollisionWorld world;
+  world.update(b.rects.data(), b.count());
+  EXPECT_EQ(world.size(), 4u);
+  EXPECT_EQ(world.findPairs(), (std::vector<u32>{0, 3}));
+  EXPECT_EQ(world.query(-100, -100, 200, 200),
+            (std::vector<u32>{0, 3}));
+}
+
+TEST(CollisionWorldTest, QueryMatchesBruteForce) {
+  Bodies b = randomBodies(400, 11);
+  CollisionWorld world(32.0f);
+  world.update(b.rects.data(), b.count(), b.layers.data(), b.masks.data());
+
+  arcanee::Xorshift128Plus rng(3);
+  for (int q = 0; q < 50; ++q) {
+    f32 box[4] = {static_cast<f32>(rng.randFloat() * 2000.0 - 1000.0),
+                  static_cast<f32>(rng.randFloat() * 2000.0 - 1000.0),
+                  static_cast<f32>(rng.randFloat() * (q < 45 ? 100 : 3000)),
+                  static_cast<f32>(rng.randFloat() * (q < 45 ? 100 : 3000))};
+    u32 mask = static_cast<u32>(rng.randRange(1, 15));
+    std::vector<u32> expected;
+    for (u32 i = 0; i < b.count(); ++i) {
+      if (boxesOverlap(&b.rects[4 * i], box) && (b.layers[i] & mask))
+        expected.push_back(i);
+    }
+    EXPECT_EQ(world.query(box[0], box[1], box[2], box[3], mask), expected);
+  }
+}
+
+TEST(CollisionWorldTest, ResultsDoNotDependOnCellSize) {
+  Bodies b = randomBodies(300, 21);
+  CollisionWorld a(24.0f);
+  CollisionWorld c(100.0f);
+  a.update(b.rects.data(), b.count(), b.layers.data(), b.masks.data());
+  c.update(b.rects.data(), b.count(), b.layers.data(), b.masks.data());
+  EXPECT_EQ(a.findPairs(), c.findPairs());
+  EXPECT_EQ(a.query(-50, -50, 300, 300), c.query(-50, -50, 300, 300));
+
+  a.clear();
+  EXPECT_EQ(a.size(), 0u);
+  EXPECT_TRUE(a.findPairs().empty());
+}
+
+TEST(CollisionBindingTest, ScriptsUpdateFromBuffersAndArrays) {
+  using namespace arcanee::script;
+  CollisionWorld world;
+  test::ScriptTestVm script;
+  registerBufferBinding(script.vm());
+  registerCollisionBinding(script.vm(), &world);
+
+  const std::string code =
+      "local r = buf.float32(12);"
+      "foreach (i, v in [0, 0, 10, 10, 5, 5, 10, 10, 50, 50, 4, 4])"
+      "  r[i] = v;"
+      "assert(collide.update(r) == 3);"
+      "local p = collide.pairs();"
+      "assert(p.len() == 2 && p[0] == 0 && p[1] == 1);"
+      "collide.update([0, 0, 10, 10, 5, 5, 10, 10], [1, 2], [1, 1]);"
+      "assert(collide.pairs().len() == 0);"
+      "local q = collide.query(4, 4, 2, 2, 2);"
+      "assert(q.len() == 1 && q[0] == 1);"
+      "assert(collide.count() == 2);"
+      "assert(collide.update([0, 0, 1]) == null);"
+      "assert(t.getLastError().find(\"collide.update\") != null);";
+  EXPECT_TRUE(script.run(code));
+}
@@ -0,0 +1,260 @@
+#include "ScriptTestVm.h"
+#include "common/FrameArena.h"
+#include "render/Canvas2D.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/GfxBinding.h"
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <new>
+#include <string>
+#include <vector>
+
+// Count every global operator new so tests can assert a code path is
+// allocation-free. Replacing them affects the whole binary, so this file is
+// built as its own test executable (see CMakeLists.txt).
+static std::atomic<unsigned long> g_heapAllocations{0};
+
+namespace {
+
+void *countedAlloc(std::size_t size) noexcept {
+  g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+void *countedAlloc(std::size_t size, std::align_val_t align) noexcept {
+  g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+  const std::size_t a = static_cast<std::size_t>(align);
+#ifdef _MSC_VER
+  return _aligned_malloc(size ? size : 1, a);
+#else
+  // aligned_alloc wants a multiple of the alignment
+  return std::aligned_alloc(a, size ? (size + a - 1) / a * a : a);
+#endif
+}
+
+void alignedFree(void *p) noexcept {
+#ifdef _MSC_VER
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+void *orThrow(void *p) {
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+} // namespace
+
+void *operator new(std::size_t size) { return orThrow(countedAlloc(size)); }
+void *operator new[](std::size_t size) { return orThrow(countedAlloc(size)); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return countedAlloc(size);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return countedAlloc(size);
+}
+void *operator new(std::size_t size, std::align_val_t align) {
+  return orThrow(countedAlloc(size, align));
+}
+void *operator new[](std::size_t size, std::align_val_t align) {
+  return orThrow(countedAlloc(size, align));
+}
+void *operator new(std::size_t size, std::align_val_t align,
+                   const std::nothrow_t &) noexcept {
+  return countedAlloc(size, align);
+}
+void *operator new[](std::size_t size, std::align_val_t align,
+                     const std::nothrow_t &) noexcept {
+  return countedAlloc(size, align);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void *p, std::align_val_t) noexcept {
+  alignedFree(p);
+}
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  alignedFree(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  alignedFree(p);
+}
+void operator delete(void *p, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  alignedFree(p);
+}
+void operator delete[](void *p, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  alignedFree(p);
+}
+
+using arcanee::FrameArena;
+
+TEST(FrameArenaTest, ScopesRewindAndAlignmentHolds) {
+  FrameArena arena(1024);
+  char *c = arena.allocArray<char>(3);
+  ASSERT_NE(c, nullptr);
+  {
+    FrameArena::Scope scope(arena);
+    double *d = arena.allocArray<double>(4);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(d) % alignof(double), 0u);
+    EXPECT_GE(arena.getStats().used, 3 + 4 * sizeof(double));
+  }
+  EXPECT_EQ(arena.getStats().used, 3u);
+
+  std::string_view s = arena.copyString("blend");
+  EXPECT_EQ(s, "blend");
+  EXPECT_EQ(s.data()[s.size()], '\0');
+}
+
+TEST(FrameArenaTest, OverflowIsFoldedIntoOneBlockOnReset) {
+  FrameArena arena(256);
+  for (int i = 0; i < 10; ++i)
+    arena.allocate(200);
+  EXPECT_GT(arena.getStats().heapAllocations, 1u);
+
+  arena.reset();
+  arcanee::u64 blocks = arena.getStats().heapAllocations;
+  arcanee::u64 capacity = arena.getStats().capacity;
+
+  // The same frame again fits without new blocks
+  for (int frame = 0; frame < 3; ++frame) {
+    for (int i = 0; i < 10; ++i)
+      arena.allocate(200);
+    arena.reset();
+  }
+  EXPECT_EQ(arena.getStats().heapAllocations, blocks);
+  EXPECT_EQ(arena.getStats().capacity, capacity);
+  EXPECT_EQ(arena.getStats().used, 0u);
+}
+
+TEST(FrameArenaTest, SteadyStateBindingFramesAddNoAllocations) {
+  using namespace arcanee::script;
+  // A CPU target, so the batches reach ThorVG like they do in a frame. ThorVG
+  // allocates its shapes and pictures, so a binding frame is measured
+  // against the same canvas calls made directly.
+  arcanee::render::Canvas2D canvas;
+  ASSERT_TRUE(canvas.initializeOffscreen(64, 64));
+  const auto svgPath =
+      std::filesystem::temp_directory_path() / "arcanee_frame_arena.svg";
+  {
+    std::ofstream svg(svgPath);
+    svg << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"4\" "
+           "height=\"4\"><rect width=\"4\" height=\"4\"/></svg>";
+  }
+  const arcanee::u32 image = canvas.loadImage(svgPath.string().c_str());
+  std::filesystem::remove(svgPath);
+  ASSERT_NE(image, 0u);
+
+  setGfxCanvas(&canvas);
+  test::ScriptTestVm script;
+  HSQUIRRELVM vm = script.vm();
+  registerBufferBinding(vm);
+  registerGfxBinding(vm);
+
+  // Inputs are built once; frame() only makes binding calls that copy
+  // arrays into scratch memory
+  const std::string code =
+      "rects <- []; colors <- []; sprites <- [];"
+      "for (local i = 0; i < 200; i++) {"
+      "  rects.extend([i, i, 4, 4]); colors.append(0xFF000000 | i);"
+      "  sprites.extend([" + std::to_string(image) + ", i * 2.0, i * 3.0]);"
+      "}"
+      "function frame() {"
+      "  gfx.fillRects(rects, colors); gfx.lines(rects);"
+      "  gfx.drawSprites(sprites); assert(gfx.setBlend(\"multiply\"));"
+      "}";
+  ASSERT_TRUE(script.run(code));
+
+  std::vector<float> rects;
+  std::vector<arcanee::u32> colors;
+  std::vector<arcanee::render::Canvas2D::SpriteInstance> sprites;
+  for (int i = 0; i < 200; ++i) {
+    const float f = static_cast<float>(i);
+    rects.insert(rects.end(), {f, f, 4.0f, 4.0f});
+    colors.push_back(0xFF000000u | static_cast<arcanee::u32>(i));
+    sprites.push_back({image, f * 2.0f, f * 3.0f});
+  }
+
+  auto directFrame = [&]() {
+    canvas.beginFrame();
+    canvas.fillRects(rects.data(), 200, colors.data());
+    canvas.strokeLines(rects.data(), 200);
+    canvas.drawImages(sprites.data(), 200);
+    return canvas.setBlend("multiply");
+  };
+  auto bindingFrame = [&]() {
+    canvas.beginFrame();
+    bindingArena().reset();
+    sq_pushroottable(vm);
+    sq_pushstring(vm, "frame", -1);
+    sq_get(vm, -2);
+    sq_pushroottable(vm);
+    bool ok = SQ_SUCCEEDED(sq_call(vm, 1, SQFalse, SQFalse));
+    sq_settop(vm, 0);
+    return ok;
+  };
+  auto allocationsOf = [](auto &frame) {
+    unsigned long before = g_heapAllocations.load();
+    for (int i = 0; i < 10; ++i)
+      EXPECT_TRUE(frame());
+    return g_heapAllocations.load() - before;
+  };
+
+  // Warm-up grows the arenas, the VM pools and ThorVG's paint lists
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(directFrame());
+    ASSERT_TRUE(bindingFrame());
+  }
+  const unsigned long direct = allocationsOf(directFrame);
+  EXPECT_GT(direct, 0u); // The batches did reach the target
+  EXPECT_EQ(allocationsOf(bindingFrame), direct);
+  EXPECT_EQ(bindingArena().getStats().used, 0u); // Each call gave it back
+
+  canvas.beginFrame();
+  setGfxCanvas(nullptr);
+}
+
+TEST(FrameArenaTest, CanvasScratchCallsDoNotAllocate) {
+  arcanee::render::Canvas2D canvas;
+  arcanee::u32 paint = canvas.createLinearGradient(0, 0, 64, 0);
+  ASSERT_NE(paint, 0u);
+  const float offsets[] = {0.0f, 0.25f, 0.5f, 1.0f};
+  const arcanee::u32 colors[] = {0xFF000000u, 0xFF0000FFu, 0xFF00FF00u,
+                                 0xFFFF0000u};
+
+  // Stops are staged in the canvas arena, then copied by ThorVG
+  ASSERT_TRUE(canvas.paintSetStops(paint, offsets, colors, 4));
+  unsigned long before = g_heapAllocations.load();
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(canvas.paintSetStops(paint, offsets, colors, 4));
+    EXPECT_TRUE(canvas.setBlend(i % 2 ? "multiply" : "screen"));
+  }
+  EXPECT_FALSE(canvas.setBlend("xor"));
+  EXPECT_EQ(g_heapAllocations.load() - before, 0u);
+  canvas.freePaint(paint);
+}
+
+TEST(FrameArenaTest, BlendModesParseWithoutCopies) {
+  arcanee::render::BlendMode mode = arcanee::render::BlendMode::Normal;
+  unsigned long before = g_heapAllocations.load();
+  EXPECT_TRUE(arcanee::render::Canvas2D::parseBlendMode("screen", mode));
+  EXPECT_FALSE(arcanee::render::Canvas2D::parseBlendMode("xor", mode));
+  EXPECT_EQ(g_heapAllocations.load() - before, 0u);
+  EXPECT_EQ(mode, arcanee::render::BlendMode::Screen);
+}
@@ -0,0 +1,98 @@
+#include "ScriptTestVm.h"
+#include "script/HeapHash.h"
+#include "script/api/BufferBinding.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace arcanee::script;
+
+namespace {
+
+class HeapHashTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    registerBufferBinding(m_a.vm());
+    registerBufferBinding(m_b.vm());
+  }
+
+  test::ScriptTestVm m_a;
+  test::ScriptTestVm m_b;
+};
+
+const char *kWorld = "player <- {x = 1.5, y = 2, name = \"p1\", tags = [1, 2]};"
+                     "enemies <- [];"
+                     "for (local i = 0; i < 50; i++)"
+                     "  enemies.append({hp = i, target = player});"
+                     "function update(dt) { player.x += dt; }";
+
+} // namespace
+
+TEST_F(HeapHashTest, SameStateHashesEqualAcrossVms) {
+  ASSERT_TRUE(m_a.run(kWorld));
+  ASSERT_TRUE(m_b.run(kWorld));
+
+  HeapHashStats stats;
+  arcanee::u64 a = hashVmHeap(m_a.vm(), &stats);
+  EXPECT_NE(a, 0u);
+  EXPECT_EQ(a, hashVmHeap(m_b.vm()));
+  EXPECT_EQ(a, hashVmHeap(m_a.vm())); // Hashing does not disturb the heap
+  EXPECT_GT(stats.objects, 50u);
+
+  ASSERT_TRUE(m_a.run("update(0.25);"));
+  ASSERT_TRUE(m_b.run("update(0.25);"));
+  EXPECT_EQ(hashVmHeap(m_a.vm()), hashVmHeap(m_b.vm()));
+}
+
+TEST_F(HeapHashTest, NestedChangeIsDetected) {
+  ASSERT_TRUE(m_a.run(kWorld));
+  ASSERT_TRUE(m_b.run(kWorld));
+  ASSERT_TRUE(m_b.run("enemies[37].hp = 38;"));
+  EXPECT_NE(hashVmHeap(m_a.vm()), hashVmHeap(m_b.vm()));
+
+  // Float bits count: 0.1 + 0.2 != 0.3
+  ASSERT_TRUE(m_a.run("player.tags.append(0.1 + 0.2);"));
+  ASSERT_TRUE(m_b.run("enemies[37].hp = 37; player.tags.append(0.3);"));
+  EXPECT_NE(hashVmHeap(m_a.vm()), hashVmHeap(m_b.vm()));
+}
+
+TEST_F(HeapHashTest, SharingAndCyclesAreStructural) {
+  // Same values, but b holds two distinct tables where a shares one
+  ASSERT_TRUE(m_a.run("local t = {v = 1}; root <- [t, t];"
+                      "cyc <- {}; cyc.self <- cyc;"));
+  ASSERT_TRUE(m_b.run("root <- [{v = 1}, {v = 1}];"
+                      "cyc <- {}; cyc.self <- cyc;"));
+  EXPECT_NE(hashVmHeap(m_a.vm()), hashVmHeap(m_b.vm()));
+
+  ASSERT_TRUE(m_b.run("local t = {v = 1}; root <- [t, t];"));
+  EXPECT_EQ(hashVmHeap(m_a.vm()), hashVmHeap(m_b.vm()));
+}
+
+TEST_F(HeapHashTest, BufferContentsAndCapturesAreHashed) {
+  const char *src = "data <- buf.float32(64);"
+                    "local n = 3; bump <- function() { return n; };";
+  ASSERT_TRUE(m_a.run(src));
+  ASSERT_TRUE(m_b.run(src));
+  EXPECT_EQ(hashVmHeap(m_a.vm()), hashVmHeap(m_b.vm()));
+
+  ASSERT_TRUE(m_b.run("data[63] = 1;"));
+  EXPECT_NE(hashVmHeap(m_a.vm()), hashVmHeap(m_b.vm()));
+
+  ASSERT_TRUE(m_b.run("data[63] = 0; local n = 4;"
+                      "bump <- function() { return n; };"));
+  EXPECT_NE(hashVmHeap(m_a.vm()), hashVmHeap(m_b.vm()));
+}
+
+TEST_F(HeapHashTest, InsertionHistoryDoesNotMatter) {
+  // Same contents; b gets its keys in another order, through a rehash and
+  // with deleted slots, so sq_next walks the two tables differently
+  ASSERT_TRUE(m_a.run("t <- {}; t.a <- 1; t.b <- {v = 1}; t.c <- [2];"
+                      "t.d <- \"s\"; t[7] <- 0.5; t[true] <- null;"));
+  ASSERT_TRUE(m_b.run("t <- {}; for (local i = 0; i < 100; i++) t[-i] <- i;"
+                      "t[true] <- null; t.d <- \"s\"; t[7] <- 0.5;"
+                      "t.c <- [2]; t.b <- {v = 1}; t.a <- 1;"
+                      "for (local i = 0; i < 100; i++) delete t[-i];"));
+  EXPECT_EQ(hashVmHeap(m_a.vm()), hashVmHeap(m_b.vm()));
+
+  ASSERT_TRUE(m_b.run("t.b.v = 2;"));
+  EXPECT_NE(hashVmHeap(m_a.vm()), hashVmHeap(m_b.vm()));
+}
@@ -0,0 +1,98 @@
+#include "ScriptTestVm.h"
+#include "script/JsonCodec.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/JsonBinding.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace arcanee::script;
+
+namespace {
+
+class JsonTest : public ::testing::Test, protected test::ScriptTestVm {
+protected:
+  void SetUp() override {
+    registerBufferBinding(m_vm);
+    registerJsonBinding(m_vm);
+  }
+
+  // Error message of parsing @p text, or "" if it parses
+  std::string parseError(const std::string &text) {
+    SQInteger top = sq_gettop(m_vm);
+    arcanee::Status status = parseJson(m_vm, text.data(), text.size());
+    EXPECT_EQ(sq_gettop(m_vm), top + (status.ok() ? 1 : 0));
+    sq_settop(m_vm, top);
+    return status.message();
+  }
+};
+
+} // namespace
+
+TEST_F(JsonTest, ParsesDocuments) {
+  EXPECT_TRUE(run(
+      "local d = json.parse(\"{\\\"name\\\": \\\"Ada\\\", \\\"hp\\\": 12,"
+      "  \\\"speed\\\": 1.5, \\\"big\\\": 1e3, \\\"ok\\\": true,"
+      "  \\\"none\\\": null, \\\"tags\\\": [\\\"a\\\", [], {}]}\");"
+      "assert(d.name == \"Ada\" && d.hp == 12 && typeof d.hp == \"integer\");"
+      "assert(d.speed == 1.5 && typeof d.big == \"float\" && d.big == 1000);"
+      "assert(d.ok == true && (\"none\" in d) && d.none == null);"
+      "assert(d.tags.len() == 3 && d.tags[0] == \"a\");"
+      "assert(d.tags[1].len() == 0 && typeof d.tags[2] == \"table\");"));
+}
+
+TEST_F(JsonTest, DecodesEscapes) {
+  // The long runs go through the sixteen-byte scan
+  EXPECT_TRUE(run(
+      "local s = json.parse(\"\\\"a fairly long plain prefix, then \\\\\\\""
+      "quoted\\\\\\\" \\\\\\\\ \\\\n \\\\u00e9 \\\\ud83d\\\\ude00 done\\\"\");"
+      "assert(s == \"a fairly long plain prefix, then \\\"quoted\\\" \\\\ \\n"
+      " \\xc3\\xa9 \\xf0\\x9f\\x98\\x80 done\");"));
+}
+
+TEST_F(JsonTest, ReportsWhereParsingFailed) {
+  EXPECT_EQ(parseError("[1, 2]"), "");
+  EXPECT_EQ(parseError("{\n  \"a\": [1,]\n}"),
+            "json: unexpected character at line 2, column 11");
+  EXPECT_NE(parseError("[01]"), "");
+  EXPECT_NE(parseError("[1.]"), "");
+  EXPECT_NE(parseError("\"abc"), "");
+  EXPECT_NE(parseError("\"tab\there\""), "");
+  EXPECT_NE(parseError("\"\\ud800\""), "");
+  EXPECT_NE(parseError("[1] 2"), "");
+  EXPECT_NE(parseError("1e999"), "");
+  EXPECT_NE(parseError(std::string(600, '[') + std::string(600, ']')), "");
+}
+
+TEST_F(JsonTest, StringifyRoundTrips) {
+  EXPECT_TRUE(run(
+      "local v = {name = \"line\\nbreak \\\"q\\\"\", n = -7, f = 2.0,"
+      "  list = [1, 0.25, false, null, {}], nested = {deep = [[]]},"
+      "  ints = buf.int32(3)};"
+      "v.ints[2] = 9;"
+      "foreach (settings in [null, {indent = 2}]) {"
+      "  local text = json.stringify(v, settings);"
+      "  local w = json.parse(text);"
+      "  assert(w.name == v.name && w.n == -7);"
+      "  assert(w.f == 2.0 && typeof w.f == \"float\");"
+      "  assert(w.list.len() == 5 && w.list[1] == 0.25 && w.list[3] == null);"
+      "  assert(w.nested.deep[0].len() == 0);"
+      "  assert(w.ints.len() == 3 && w.ints[2] == 9);"
+      "}"
+      "assert(json.stringify([1, \"a\"]) == \"[1,\\\"a\\\"]\");"
+      "assert(json.stringify({a = [1]}, {indent = 2}) =="
+      "       \"{\\n  \\\"a\\\": [\\n    1\\n  ]\\n}\");"));
+}
+
+TEST_F(JsonTest, BindingReportsErrors) {
+  EXPECT_TRUE(run(
+      "assert(json.parse(\"{\\\"a\\\":}\") == null);"
+      "assert(t.getLastError().find(\"line 1, column 6\") != null);"
+      "local b = buf.bytes(2); b[0] = 91; b[1] = 93;"
+      "assert(json.parse(b).len() == 0);"
+      "assert(json.stringify({f = function() {}}) == null);"
+      "assert(t.getLastError().find(\"function\") != null);"
+      "assert(json.stringify({[1] = 2}) == null);"
+      "assert(json.stringify(1, {tabs = 1}) == null);"
+      "assert(t.getLastError().find(\"'tabs'\") != null);"
+      "assert(json.load(\"cart:/data.json\") == null);"));
+}
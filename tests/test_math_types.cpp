@@ -0,0 +1,94 @@
+#include "ScriptTestVm.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/MathBinding.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace arcanee::script;
+
+namespace {
+
+class MathTypesTest : public ::testing::Test, protected test::ScriptTestVm {
+protected:
+  void SetUp() override {
+    registerBufferBinding(m_vm);
+    registerMathBinding(m_vm);
+  }
+};
+
+} // namespace
+
+TEST_F(MathTypesTest, VectorOperatorsAndFields) {
+  ASSERT_TRUE(run("local a = math.vec2(1, 2), b = math.vec2(3, 4);"
+                  "local c = (a + b) * 2 - b / 2; c.y += 1;"
+                  "::result <- c.tostring() + typeof c;"));
+  EXPECT_EQ(resultString(), "vec2(6.5, 11)vec2");
+
+  ASSERT_TRUE(run("local v = -math.vec3(3, 0, 4);"
+                  "::result <- v.len() + v[2] + v.normalized().z;"));
+  EXPECT_FLOAT_EQ(resultFloat(), 5.0f - 4.0f - 0.8f);
+
+  ASSERT_TRUE(run("::result <- math.vec3(1, 0, 0).cross(math.vec3(0, 1, 0))"
+                  ".tostring();"));
+  EXPECT_EQ(resultString(), "vec3(0, 0, 1)");
+}
+
+TEST_F(MathTypesTest, InPlaceMethodsReturnReceiver) {
+  ASSERT_TRUE(run("local p = math.vec2(1, 1); local q = p;"
+                  "p.addScaledIn(math.vec2(2, 4), 0.5).mulIn(2);"
+                  "::result <- q.tostring();"));
+  EXPECT_EQ(resultString(), "vec2(4, 6)");
+}
+
+TEST_F(MathTypesTest, MisuseIsReported) {
+  // Operators throw; methods return null and set the last error
+  EXPECT_FALSE(run("local x = math.vec2(1, 2) + math.vec3(1, 2, 3);"));
+  EXPECT_FALSE(run("local x = math.vec2(1, 2).z;"));
+  ASSERT_TRUE(run("local r = math.vec2(1, 2).dot(5);"
+                  "::result <- (r == null ? \"null:\" : \"\") + "
+                  "t.getLastError();"));
+  EXPECT_EQ(resultString(), "null:vec2.dot: arg 1 must be vec2");
+}
+
+TEST_F(MathTypesTest, QuatRotatesAndComposes) {
+  ASSERT_TRUE(run("local z = math.vec3(0, 0, 1);"
+                  "local q = math.quatAxisAngle(z, 1.5707963);"
+                  "local v = q * math.vec3(1, 0, 0);"
+                  "local w = (q * q).rotate(math.vec3(1, 0, 0));"
+                  "::result <- v.y * 10 + w.x;"));
+  EXPECT_NEAR(resultFloat(), 10.0f - 1.0f, 1e-5f);
+
+  ASSERT_TRUE(run("local a = math.quat(), b = math.quatAxisAngle("
+                  "math.vec3(0, 1, 0), 1.0);"
+                  "::result <- a.slerp(b, 0.5).dot(math.quatAxisAngle("
+                  "math.vec3(0, 1, 0), 0.5));"));
+  EXPECT_NEAR(resultFloat(), 1.0f, 1e-5f);
+}
+
+TEST_F(MathTypesTest, Mat3TransformsPoints) {
+  ASSERT_TRUE(run("local m = math.mat3().translate(10, 0).scale(2);"
+                  "local p = m * math.vec2(1, 1);"
+                  "local back = m.inverse() * p;"
+                  "::result <- p.tostring() + back.tostring();"));
+  EXPECT_EQ(resultString(), "vec2(12, 2)vec2(1, 1)");
+
+  ASSERT_TRUE(run("::result <- math.mat3().scale(0).inverse() == null"
+                  " ? t.getLastError() : \"\";"));
+  EXPECT_EQ(resultString(), "mat3.inverse: matrix is singular");
+}
+
+TEST_F(MathTypesTest, BulkOperationsOverBuffers) {
+  ASSERT_TRUE(run("local pos = buf.float32([0, 0, 1, 1]);"
+                  "math.addScaled(pos, buf.float32([1, 2, 3, 4]), 0.5);"
+                  "math.transformPoints(math.mat3().translate(1, 0), pos);"
+                  "::result <- pos[0] + pos[1] * 10 + pos[2] * 100 +"
+                  " pos[3] * 1000;"));
+  EXPECT_FLOAT_EQ(resultFloat(), 1.5f + 10.0f + 350.0f + 3000.0f);
+
+  ASSERT_TRUE(run("local z = math.vec3(0, 0, 1);"
+                  "local q = math.quatAxisAngle(z, 3.1415927);"
+                  "local out = math.rotateVectors(q, buf.float32([1, 0, 0]),"
+                  " buf.float32(3));"
+                  "::result <- out[0];"));
+  EXPECT_NEAR(resultFloat(), -1.0f, 1e-5f);
+}
@@ -0,0 +1,196 @@
+#include "ScriptTestVm.h"
+#include "common/Random.h"
+#include "nav/Pathfinder.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/NavBinding.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using arcanee::u32;
+using arcanee::u8;
+using arcanee::nav::NavGrid;
+using arcanee::nav::Pathfinder;
+
+namespace {
+
+// Weighted costs with roughly a fifth of the cells walled off
+void randomizeGrid(Pathfinder &pf, u32 w, u32 h, arcanee::u64 seed) {
+  arcanee::Xorshift128Plus rng(seed);
+  pf.resetGrid(w, h);
+  std::vector<u8> costs(w * h);
+  for (u8 &c : costs)
+    c = rng.randRange(0, 9) < 2 ? 0 : static_cast<u8>(rng.randRange(1, 5));
+  pf.grid().setCosts(costs.data());
+}
+
+// Walks a path and sums its step costs, checking every step is legal
+u32 walkCost(const NavGrid &grid, const std::vector<u32> &path) {
+  u32 cost = 0;
+  for (size_t i = 1; i < path.size(); ++i) {
+    int dx = static_cast<int>(path[i] % grid.width()) -
+             static_cast<int>(path[i - 1] % grid.width());
+    int dy = static_cast<int>(path[i] / grid.width()) -
+             static_cast<int>(path[i - 1] / grid.width());
+    EXPECT_TRUE(dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1 && (dx || dy));
+    EXPECT_NE(grid.cost(path[i]), NavGrid::kBlocked);
+    cost += grid.cost(path[i]) * (dx && dy ? 14 : 10);
+  }
+  return cost;
+}
+
+} // namespace
+
+TEST(PathfinderTest, StraightAndDiagonalCosts) {
+  Pathfinder pf;
+  ASSERT_TRUE(pf.resetGrid(8, 8));
+  std::vector<u32> path;
+  u32 cost = 0;
+  ASSERT_TRUE(pf.findPath(pf.grid().index(0, 0), pf.grid().index(5, 0), path,
+                          cost));
+  EXPECT_EQ(cost, 50u);
+  EXPECT_EQ(path.size(), 6u);
+
+  ASSERT_TRUE(pf.findPath(pf.grid().index(0, 0), pf.grid().index(3, 3), path,
+                          cost));
+  EXPECT_EQ(cost, 42u);
+
+  pf.grid().setDiagonal(false);
+  ASSERT_TRUE(pf.findPath(pf.grid().index(0, 0), pf.grid().index(3, 3), path,
+                          cost));
+  EXPECT_EQ(cost, 60u);
+}
+
+TEST(PathfinderTest, DiagonalsDoNotCutCorners) {
+  Pathfinder pf;
+  pf.resetGrid(2, 2);
+  pf.grid().setCost(1, 0, NavGrid::kBlocked);
+  std::vector<u32> path;
+  u32 cost = 0;
+  ASSERT_TRUE(pf.findPath(0, 3, path, cost));
+  EXPECT_EQ(path, (std::vector<u32>{0, 2, 3}));
+  EXPECT_EQ(cost, 20u);
+
+  pf.grid().setCost(0, 1, NavGrid::kBlocked);
+  EXPECT_FALSE(pf.findPath(0, 3, path, cost));
+  EXPECT_FALSE(pf.findPath(0, 1, path, cost)); // Blocked goal
+}
+
+TEST(PathfinderTest, AStarMatchesFlowFieldDistances) {
+  for (arcanee::u64 seed = 1; seed <= 4; ++seed) {
+    Pathfinder pf;
+    randomizeGrid(pf, 64, 48, seed);
+    pf.grid().setDiagonal(seed % 2 == 0);
+    u32 goal = pf.grid().index(40, 30);
+    pf.grid().setCost(40, 30, 1);
+
+    std::vector<u8> dirs(pf.grid().cellCount());
+    std::vector<u32> dist(pf.grid().cellCount());
+    ASSERT_TRUE(pf.flowField(goal, dirs.data(), dist.data()));
+
+    arcanee::Xorshift128Plus rng(seed * 7);
+    for (int i = 0; i < 40; ++i) {
+      u32 start = static_cast<u32>(rng.randRange(0, 64 * 48 - 1));
+      std::vector<u32> path;
+      u32 cost = 0;
+      bool found = pf.findPath(start, goal, path, cost);
+      EXPECT_EQ(found, dist[start] != Pathfinder::kUnreachable);
+      if (!found)
+        continue;
+      EXPECT_EQ(cost, dist[start]);
+      EXPECT_EQ(walkCost(pf.grid(), path), cost);
+      EXPECT_EQ(path.front(), start);
+      EXPECT_EQ(path.back(), goal);
+    }
+  }
+}
+
+TEST(PathfinderTest, FlowFieldStepsLeadToTheGoal) {
+  Pathfinder pf;
+  randomizeGrid(pf, 40, 40, 99);
+  u32 goal = pf.grid().index(5, 35);
+  pf.grid().setCost(5, 35, 1);
+  std::vector<u8> dirs(pf.grid().cellCount());
+  std::vector<u32> dist(pf.grid().cellCount());
+  ASSERT_TRUE(pf.flowField(goal, dirs.data(), dist.data()));
+
+  for (u32 cell = 0; cell < pf.grid().cellCount(); ++cell) {
+    if (dist[cell] == Pathfinder::kUnreachable || cell == goal) {
+      EXPECT_EQ(dirs[cell], 0u);
+      continue;
+    }
+    std::vector<u32> walk = {cell};
+    while (walk.back() != goal && walk.size() < 4000) {
+      u8 code = dirs[walk.back()];
+      ASSERT_NE(code, 0u);
+      u32 x = walk.back() % 40 + Pathfinder::kDirX[code - 1];
+      u32 y = walk.back() / 40 + Pathfinder::kDirY[code - 1];
+      walk.push_back(pf.grid().index(x, y));
+    }
+    EXPECT_EQ(walkCost(pf.grid(), walk), dist[cell]);
+  }
+}
+
+TEST(PathfinderTest, RequestsSpreadOverTicksAndMatchFindPath) {
+  Pathfinder pf;
+  randomizeGrid(pf, 128, 128, 5);
+  pf.grid().setCost(0, 0, 1);
+  pf.grid().setCost(127, 127, 1);
+  std::vector<u32> expected;
+  u32 expectedCost = 0;
+  bool reachable = pf.findPath(0, 128 * 128 - 1, expected, expectedCost);
+
+  pf.setStepBudget(100);
+  u32 a = pf.request(0, 128 * 128 - 1);
+  u32 b = pf.request(0, 1);
+  std::vector<u32> path;
+  u32 cost = 0;
+  int ticks = 0;
+  Pathfinder::Status status = Pathfinder::Status::Pending;
+  while (status == Pathfinder::Status::Pending && ticks < 10000) {
+    pf.step();
+    ++ticks;
+    EXPECT_LE(pf.getStats().expansions, 100u);
+    status = pf.poll(a, path, cost);
+  }
+  EXPECT_GT(ticks, 1);
+  ASSERT_EQ(status, reachable ? Pathfinder::Status::Found
+                              : Pathfinder::Status::NoPath);
+  if (reachable) {
+    EXPECT_EQ(path, expected);
+    EXPECT_EQ(cost, expectedCost);
+  }
+  EXPECT_EQ(pf.poll(a, path, cost), Pathfinder::Status::Unknown);
+
+  EXPECT_TRUE(pf.cancel(b));
+  EXPECT_EQ(pf.pending(), 0u);
+}
+
+TEST(NavBindingTest, ScriptsFindPathsAndFlowFields) {
+  using namespace arcanee::script;
+  Pathfinder pf;
+  test::ScriptTestVm script;
+  registerBufferBinding(script.vm());
+  registerNavBinding(script.vm(), &pf);
+
+  EXPECT_TRUE(script.run(
+      "assert(nav.setGrid(4, 3, [1, 0, 1, 1,"
+      "                          1, 0, 1, 1,"
+      "                          1, 1, 1, 1]));"
+      "local p = nav.find(0, 0, 2, 0);"
+      "assert(p.len() == 14 && p[12] == 2 && p[13] == 0);" // Around the wall
+      "assert(nav.find(0, 0, 1, 0) == null);"
+      "id <- nav.request(0, 0, 3, 0);"
+      "assert(nav.poll(id) == null && nav.pending() == 1);"));
+  pf.step(); // The runtime does this after update()
+  EXPECT_TRUE(script.run(
+      "local r = nav.poll(id);"
+      "assert(r.found && r.path[r.path.len() - 2] == 3);"
+      "assert(r.cost > 6.3 && r.cost < 6.5);"
+      "local dist = buf.int32(12);"
+      "local flow = nav.flowField(3, 2, dist);"
+      "assert(flow.len() == 12 && flow[11] == 0 && flow[10] == 1);"
+      "assert(dist[1] == -1 && dist[10] == 10);"
+      "assert(nav.setGrid(0, 3) == null);"
+      "assert(t.getLastError().find(\"nav.setGrid\") != null);"));
+}
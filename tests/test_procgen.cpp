@@ -0,0 +1,196 @@
+#include "ScriptTestVm.h"
+#include "common/Random.h"
+#include "procgen/BulkRandom.h"
+#include "procgen/Noise.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/NoiseBinding.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using arcanee::f32;
+using arcanee::i32;
+using arcanee::u32;
+using arcanee::u64;
+using arcanee::u8;
+using arcanee::Xorshift128Plus;
+using arcanee::procgen::NoiseParams;
+using arcanee::procgen::NoiseType;
+using arcanee::procgen::Xorshift128PlusX4;
+
+namespace {
+
+constexpr NoiseType kAllTypes[] = {NoiseType::Value, NoiseType::Perlin,
+                                   NoiseType::Simplex, NoiseType::Cellular};
+
+bool sameBits(f32 a, f32 b) { return std::memcmp(&a, &b, sizeof(f32)) == 0; }
+
+} // namespace
+
+TEST(BulkRandomTest, JumpAdvancesTwoToTheSixtyFour) {
+  Xorshift128Plus rng(42);
+  rng.jump();
+  // Reference value from the characteristic polynomial of the generator
+  EXPECT_EQ(rng.next(), 0xbda2109d627d7e1eULL);
+
+  // Jumping commutes with stepping
+  Xorshift128Plus a(7), b(7);
+  a.next();
+  a.jump();
+  b.jump();
+  b.next();
+  EXPECT_EQ(a.next(), b.next());
+}
+
+TEST(BulkRandomTest, LanesAreJumpedScalarStreams) {
+  Xorshift128PlusX4 bulk(99);
+  std::vector<u64> out(4 * 37);
+  bulk.fill(out.data(), out.size());
+
+  for (u32 lane = 0; lane < 4; ++lane) {
+    Xorshift128Plus rng(99);
+    for (u32 k = 0; k < lane; ++k)
+      rng.jump();
+    for (size_t t = 0; t < 37; ++t)
+      ASSERT_EQ(out[t * 4 + lane], rng.next()) << "lane " << lane;
+  }
+}
+
+TEST(BulkRandomTest, SplitFillsMatchOneFill) {
+  Xorshift128PlusX4 whole(5);
+  std::vector<u64> expected(103);
+  whole.fill(expected.data(), expected.size());
+
+  Xorshift128PlusX4 split(5);
+  std::vector<u64> got(expected.size());
+  size_t pos = 0;
+  for (size_t n : {3, 1, 10, 2, 87}) {
+    split.fill(got.data() + pos, n);
+    pos += n;
+  }
+  EXPECT_EQ(got, expected);
+}
+
+TEST(BulkRandomTest, RangesAreRespected) {
+  Xorshift128PlusX4 rng(3);
+  std::vector<i32> ints(10000);
+  rng.fillInt(ints.data(), ints.size(), -3, 3);
+  bool seen[7] = {};
+  for (i32 v : ints) {
+    ASSERT_GE(v, -3);
+    ASSERT_LE(v, 3);
+    seen[v + 3] = true;
+  }
+  for (bool s : seen)
+    EXPECT_TRUE(s);
+
+  std::vector<f32> floats(10000);
+  rng.fillFloat(floats.data(), floats.size(), 2.0f, 4.0f);
+  for (f32 v : floats) {
+    ASSERT_GE(v, 2.0f);
+    ASSERT_LT(v, 4.0f);
+  }
+}
+
+TEST(NoiseTest, FillMatchesSampleBitForBit) {
+  // Odd width: both the four-wide and the scalar path are exercised
+  const u32 w = 37, h = 11;
+  const f32 x0 = -20.25f, y0 = 3.5f;
+  for (NoiseType type : kAllTypes) {
+    NoiseParams p;
+    p.type = type;
+    p.seed = 1234;
+    p.frequency = 0.173f;
+    p.octaves = 3;
+    std::vector<f32> out(w * h);
+    arcanee::procgen::fillNoise(p, x0, y0, w, h, out.data());
+    for (u32 j = 0; j < h; ++j) {
+      for (u32 i = 0; i < w; ++i) {
+        f32 s = arcanee::procgen::sampleNoise(p, x0 + static_cast<f32>(i),
+                                              y0 + static_cast<f32>(j));
+        ASSERT_TRUE(sameBits(out[j * w + i], s))
+            << "type " << static_cast<int>(type) << " at " << i << ", " << j;
+      }
+    }
+  }
+}
+
+TEST(NoiseTest, RangesAndSeeds) {
+  const u32 n = 128;
+  for (NoiseType type : kAllTypes) {
+    NoiseParams p;
+    p.type = type;
+    p.frequency = 0.11f;
+    std::vector<f32> a(n * n), b(n * n);
+    arcanee::procgen::fillNoise(p, 0.0f, 0.0f, n, n, a.data());
+    p.seed = 1;
+    arcanee::procgen::fillNoise(p, 0.0f, 0.0f, n, n, b.data());
+
+    f32 lo = type == NoiseType::Cellular ? 0.0f : -1.0f;
+    f32 mn = 2.0f, mx = -2.0f;
+    for (f32 v : a) {
+      mn = std::min(mn, v);
+      mx = std::max(mx, v);
+    }
+    EXPECT_GE(mn, lo);
+    EXPECT_LE(mx, 1.0f);
+    EXPECT_GT(mx - mn, 0.5f) << "type " << static_cast<int>(type);
+    EXPECT_NE(a, b) << "type " << static_cast<int>(type);
+  }
+}
+
+TEST(NoiseTest, NoiseIsContinuous) {
+  for (NoiseType type : kAllTypes) {
+    NoiseParams p;
+    p.type = type;
+    p.frequency = 1.0f;
+    f32 prev = arcanee::procgen::sampleNoise(p, 0.0f, 0.3f);
+    for (u32 i = 1; i <= 1000; ++i) {
+      f32 x = static_cast<f32>(i) * 0.001f;
+      f32 v = arcanee::procgen::sampleNoise(p, x, 0.3f);
+      ASSERT_LT(std::fabs(v - prev), 0.05f)
+          << "type " << static_cast<int>(type) << " at " << x;
+      prev = v;
+    }
+  }
+}
+
+TEST(NoiseTest, ClassifyCountsThresholds) {
+  const f32 values[] = {-1.0f, -0.2f, 0.0f, 0.3f, 0.9f};
+  const f32 thresholds[] = {-0.5f, 0.0f, 0.5f};
+  u8 bytes[5];
+  i32 ints[5];
+  arcanee::procgen::classify(values, 5, thresholds, 3, bytes);
+  arcanee::procgen::classify(values, 5, thresholds, 3, ints);
+  const u8 expected[] = {0, 1, 2, 2, 3};
+  for (u32 i = 0; i < 5; ++i) {
+    EXPECT_EQ(bytes[i], expected[i]);
+    EXPECT_EQ(ints[i], expected[i]);
+  }
+}
+
+TEST(NoiseBindingTest, ScriptsFillBuffers) {
+  using namespace arcanee::script;
+  test::ScriptTestVm script;
+  registerBufferBinding(script.vm());
+  registerNoiseBinding(script.vm());
+
+  const std::string code =
+      "local s = {type = \"simplex\", seed = 9, frequency = 0.1, octaves = 2};"
+      "local f = buf.float32(6 * 4);"
+      "assert(noise.fill(f, 6, 4, s, 10, 20) == f);"
+      "assert(f[2 * 6 + 3] == noise.sample(13, 22, s));"
+      "local tiles = noise.classify(f, [-0.2, 0.2], buf.bytes(24));"
+      "for (local i = 0; i < 24; ++i) assert(tiles[i] <= 2);"
+      "local r = noise.random(buf.int32(100), 4, 1, 6);"
+      "for (local i = 0; i < 100; ++i)"
+      "  assert(r[i] >= 1 && r[i] <= 6);"
+      "assert(noise.random(buf.int32(100), 4, 1, 6)[57] == r[57]);"
+      "assert(noise.fill(f, 7, 4) == null);"
+      "assert(noise.sample(0, 0, {shape = 1}) == null);"
+      "assert(t.getLastError().find(\"'shape'\") != null);";
+  EXPECT_TRUE(script.run(code));
+}
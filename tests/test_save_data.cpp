@@ -0,0 +1,157 @@
+#include "ScriptTestVm.h"
+#include "common/ByteStream.h"
+#include "script/SaveData.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/SerialBinding.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace arcanee::script;
+using arcanee::StatusCode;
+using arcanee::u8;
+
+namespace {
+
+// A save-like state: nested tables, arrays, strings and a buffer
+constexpr const char *kMakeState =
+    "state <- {name = \"hero\", level = 12, hp = 0.75, alive = true,"
+    "  none = null, inventory = [], map = buf.int32(256)};"
+    "for (local i = 0; i < 200; ++i)"
+    "  state.inventory.append({id = i, qty = i % 7, tag = \"item\" + i});"
+    "for (local i = 0; i < 256; ++i) state.map[i] = i * 3;";
+
+class SaveDataTest : public ::testing::Test, protected test::ScriptTestVm {
+protected:
+  void SetUp() override {
+    registerBufferBinding(m_vm);
+    registerSerialBinding(m_vm);
+    ASSERT_TRUE(run(kMakeState));
+  }
+
+  std::vector<u8> encodeState(int level = 0) {
+    sq_pushroottable(m_vm);
+    sq_pushstring(m_vm, "state", -1);
+    sq_get(m_vm, -2);
+    SaveOptions options;
+    options.compressionLevel = level;
+    std::vector<u8> out;
+    EXPECT_TRUE(encodeSaveData(m_vm, -1, options, out).ok());
+    sq_pop(m_vm, 2);
+    return out;
+  }
+
+  StatusCode decode(const std::vector<u8> &bytes) {
+    SQInteger top = sq_gettop(m_vm);
+    arcanee::Status status = decodeSaveData(m_vm, bytes.data(), bytes.size());
+    EXPECT_EQ(sq_gettop(m_vm), top + (status.ok() ? 1 : 0));
+    sq_settop(m_vm, top);
+    return status.code();
+  }
+};
+
+} // namespace
+
+TEST_F(SaveDataTest, ScriptsRoundTripState) {
+  EXPECT_TRUE(run(
+      "foreach (settings in [null, {compress = true}, "
+      "                      {compress = true, level = 19}]) {"
+      "  local s = serial.decode(serial.encode(state, settings));"
+      "  assert(s.name == \"hero\" && s.level == 12 && s.hp == 0.75);"
+      "  assert(s.alive && (\"none\" in s) && s.none == null);"
+      "  assert(s.inventory.len() == 200);"
+      "  assert(s.inventory[123].tag == \"item123\");"
+      "  assert(s.inventory[123].qty == 4);"
+      "  assert(typeof s.map == \"Int32Buffer\" && s.map[255] == 765);"
+      "}"));
+}
+
+TEST_F(SaveDataTest, CompressionShrinksRepetitiveState) {
+  std::vector<u8> stored = encodeState();
+  std::vector<u8> packed = encodeState(3);
+  EXPECT_LT(packed.size() * 2, stored.size());
+  EXPECT_EQ(decode(stored), StatusCode::Ok);
+  EXPECT_EQ(decode(packed), StatusCode::Ok);
+}
+
+TEST_F(SaveDataTest, DamageIsDetected) {
+  for (int level : {0, 3}) {
+    std::vector<u8> bytes = encodeState(level);
+
+    std::vector<u8> flipped = bytes;
+    flipped[flipped.size() / 2] ^= 0x10;
+    EXPECT_EQ(decode(flipped), StatusCode::DataLoss) << "level " << level;
+
+    std::vector<u8> truncated(bytes.begin(), bytes.end() - 1);
+    EXPECT_EQ(decode(truncated), StatusCode::DataLoss) << "level " << level;
+
+    std::vector<u8> extended = bytes;
+    extended.push_back(0);
+    EXPECT_EQ(decode(extended), StatusCode::DataLoss) << "level " << level;
+  }
+  EXPECT_EQ(decode({}), StatusCode::DataLoss);
+}
+
+TEST_F(SaveDataTest, SizeFieldIsBoundedBeforeAllocating) {
+  // Re-serialize a blob with another size field, keeping everything else
+  auto withSize = [](const std::vector<u8> &blob, arcanee::u64 size) {
+    arcanee::ByteReader r(blob.data(), blob.size());
+    arcanee::u32 magic = r.readU32();
+    arcanee::u32 format = r.readU32();
+    u8 flags = r.readU8();
+    r.readVarint();
+    arcanee::u64 checksum = r.readU64();
+    size_t rest = r.remaining();
+    const u8 *payload = r.readBytes(rest);
+
+    std::vector<u8> out;
+    arcanee::ByteWriter w(out);
+    w.writeU32(magic);
+    w.writeU32(format);
+    w.writeU8(flags);
+    w.writeVarint(size);
+    w.writeU64(checksum);
+    w.writeBytes(payload, rest);
+    return out;
+  };
+
+  for (int level : {0, 3}) {
+    std::vector<u8> bytes = encodeState(level);
+    EXPECT_EQ(decode(withSize(bytes, kMaxSaveValueBytes + 1)),
+              StatusCode::DataLoss);
+    // Within the quota, but not what the zstd frame holds
+    EXPECT_EQ(decode(withSize(bytes, kMaxSaveValueBytes)),
+              StatusCode::DataLoss);
+  }
+}
+
+TEST_F(SaveDataTest, SharedReferencesStopAtTheQuota) {
+  // 2^30 leaf copies: encoding must give up near the quota, not at the end
+  ASSERT_TRUE(run("local a = [];"
+                  "for (local i = 0; i < 30; ++i) a = [a, a];"
+                  "dag <- a;"));
+  sq_pushroottable(m_vm);
+  sq_pushstring(m_vm, "dag", -1);
+  ASSERT_TRUE(SQ_SUCCEEDED(sq_get(m_vm, -2)));
+  std::vector<u8> out;
+  EXPECT_EQ(encodeSaveData(m_vm, -1, SaveOptions(), out).code(),
+            StatusCode::ResourceExhausted);
+  sq_pop(m_vm, 2);
+}
+
+TEST_F(SaveDataTest, NewerFormatsAreRejected) {
+  std::vector<u8> bytes = encodeState();
+  bytes[4] = 2; // Format, after the magic
+  EXPECT_EQ(decode(bytes), StatusCode::FailedPrecondition);
+}
+
+TEST_F(SaveDataTest, BindingReportsErrors) {
+  EXPECT_TRUE(run(
+      "assert(serial.encode({f = function() {}}) == null);"
+      "assert(t.getLastError().find(\"serial.encode\") != null);"
+      "assert(serial.encode(state, {compress = true, level = 30}) == null);"
+      "assert(t.getLastError().find(\"'level'\") != null);"
+      "assert(serial.decode(buf.bytes(8)) == null);"
+      "assert(t.getLastError().find(\"corrupt\") != null);"
+      "assert(serial.decode(buf.int32(8)) == null);"));
+}
@@ -1,8 +1,12 @@
 #include "platform/Window.h" // Needed? Maybe mock or allow null window if possible
 #include "script/ScriptEngine.h"
+#include "script/ScriptWatchdog.h"
 #include "vfs/Vfs.h"
+#include <fstream>
 #include <gtest/gtest.h>
 #include <memory>
+#include <sstream>
+#include <thread>
 
 using namespace arcanee;
 
@@ -129,3 +133,277 @@ TEST_F(ScriptSafetyTest, GetLastErrorWorks) {
 
   // I should fix that to use ARC_BIND_CHECK / checkArity(vm, 0).
 }
+
+TEST_F(ScriptSafetyTest, WatchdogInterruptsInfiniteLoop) {
+  {
+    std::ofstream out("/tmp/arcanee_test_cart/hang.nut");
+    out << "local n = 0;\n"
+           "while (true) { try { n++; } catch (e) { } }\n";
+  }
+
+  m_scriptEngine->setWatchdog(true, 0.05);
+  EXPECT_FALSE(m_scriptEngine->executeScript("cart:/hang.nut"));
+  EXPECT_TRUE(m_scriptEngine->hasHangFault());
+}
+
+TEST_F(ScriptSafetyTest, WatchdogInterruptsRunawayRecursion) {
+  {
+    std::ofstream out("/tmp/arcanee_test_cart/recurse.nut");
+    out << "function spin(n) { if (n > 100) return 0; return spin(n + 1) + "
+           "spin(n + 1); }\n"
+           "spin(0);\n";
+  }
+
+  m_scriptEngine->setWatchdog(true, 0.05);
+  EXPECT_FALSE(m_scriptEngine->executeScript("cart:/recurse.nut"));
+  EXPECT_TRUE(m_scriptEngine->hasHangFault());
+}
+
+TEST_F(ScriptSafetyTest, LateWatchdogTripDoesNotFaultNextCall) {
+  script::ScriptWatchdog watchdog;
+  {
+    // The deadline passes after the script returned, before the scope ends
+    script::ScriptWatchdog::Scope scope(&watchdog, 0.02);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  }
+
+  // An unarmed call, as the debugger makes, runs to completion
+  script::ScriptWatchdog::Scope scope(&watchdog, 0.0);
+  EXPECT_TRUE(runScript("local n = 0; for (local i = 0; i < 1000; i++) n++;"));
+  EXPECT_FALSE(watchdog.hasTripped());
+}
+
+TEST_F(ScriptSafetyTest, HardCapStopsOversizedAllocationInOneCall) {
+  constexpr u64 kCap = 16 * 1024 * 1024;
+  m_scriptEngine->shutdown();
+  script::ScriptEngine::ScriptConfig config;
+  config.memorySoftCapBytes = kCap / 2;
+  config.memoryHardCapBytes = kCap;
+  ASSERT_TRUE(m_scriptEngine->initialize(m_vfs.get(), config));
+  {
+    std::ofstream out("/tmp/arcanee_test_cart/huge.nut");
+    out << "huge <- buf.float32(1 << 26);\n"; // 256 MiB in one call
+  }
+
+  EXPECT_FALSE(m_scriptEngine->executeScript("cart:/huge.nut"));
+  EXPECT_LT(m_scriptEngine->getAllocator()->getStats().peakBytes, kCap);
+}
+
+TEST_F(ScriptSafetyTest, HardCapStopsRunawayAllocationLoop) {
+  constexpr u64 kCap = 16 * 1024 * 1024;
+  m_scriptEngine->shutdown();
+  script::ScriptEngine::ScriptConfig config;
+  config.memorySoftCapBytes = kCap / 2;
+  config.memoryHardCapBytes = kCap;
+  ASSERT_TRUE(m_scriptEngine->initialize(m_vfs.get(), config));
+  {
+    // The catch cannot swallow the cap: the next loop jump raises it again
+    std::ofstream out("/tmp/arcanee_test_cart/grow.nut");
+    out << "local keep = [];\n"
+           "while (true) {\n"
+           "  try { keep.append(array(256, 0)); } catch (e) { }\n"
+           "}\n";
+  }
+
+  m_scriptEngine->setWatchdog(true, 60.0); // Stopped by the cap, not by time
+  EXPECT_FALSE(m_scriptEngine->executeScript("cart:/grow.nut"));
+  EXPECT_TRUE(m_scriptEngine->hasMemoryFault());
+  EXPECT_FALSE(m_scriptEngine->hasHangFault());
+  // At most the iteration that crossed the cap, plus the keep array growing
+  EXPECT_LT(m_scriptEngine->getAllocator()->getStats().peakBytes,
+            kCap + 1024 * 1024);
+}
+
+TEST_F(ScriptSafetyTest, ProfilerSamplesHotFunction) {
+  {
+    std::ofstream out("/tmp/arcanee_test_cart/hot.nut");
+    out << "function hot() { local s = 0; for (local i = 0; i < 5000000; i++) "
+           "s += i % 7; return s; }\n"
+           "hot();\n";
+  }
+
+  m_scriptEngine->startProfiler(0.0005);
+  EXPECT_TRUE(m_scriptEngine->executeScript("cart:/hot.nut"));
+  m_scriptEngine->stopProfiler();
+
+  const auto &profiler = m_scriptEngine->getProfiler();
+  EXPECT_GT(profiler.getStats().samples, 0u);
+
+  auto functions = profiler.getFunctionStats();
+  ASSERT_FALSE(functions.empty());
+  EXPECT_EQ(functions.front().function, "hot");
+
+  std::ostringstream collapsed;
+  profiler.writeCollapsed(collapsed);
+  EXPECT_NE(collapsed.str().find(";hot (cart:/hot.nut)"), std::string::npos);
+
+  std::ostringstream trace;
+  profiler.writeChromeTrace(trace);
+  EXPECT_NE(trace.str().find("\"name\":\"hot\""), std::string::npos);
+}
+
+TEST_F(ScriptSafetyTest, IdleGcCollectsCyclesWithinBudget) {
+  {
+    std::ofstream out("/tmp/arcanee_test_cart/cycles.nut");
+    out << "for (local i = 0; i < 10000; i++) { local a = {}; "
+           "local b = {other = a}; a.other <- b; }\n";
+  }
+  ASSERT_TRUE(m_scriptEngine->executeScript("cart:/cycles.nut"));
+
+  // No time left this frame: deferred, nothing collected
+  EXPECT_FALSE(m_scriptEngine->collectIdleGarbage(0.0));
+  EXPECT_EQ(m_scriptEngine->getGcStats().deferred, 1u);
+  EXPECT_EQ(m_scriptEngine->getGcStats().collections, 0u);
+
+  ASSERT_TRUE(m_scriptEngine->collectIdleGarbage(1.0));
+  const auto &gc = m_scriptEngine->getGcStats();
+  EXPECT_EQ(gc.collections, 1u);
+  EXPECT_GE(gc.lastFreed, 20000u);
+  EXPECT_GT(gc.trackedObjects, 0u);
+  EXPECT_GT(gc.heapBytes, 0u);
+
+  // Nothing allocated since: no work to do
+  EXPECT_FALSE(m_scriptEngine->collectIdleGarbage(1.0));
+  EXPECT_EQ(m_scriptEngine->getGcStats().collections, 1u);
+}
+
+TEST_F(ScriptSafetyTest, FailedSnapshotRestoreKeepsRunningVm) {
+  {
+    std::ofstream out("/tmp/arcanee_test_cart/snap.nut");
+    out << "score <- 42;\n"
+           "function update(dt) { score++; }\n";
+  }
+  ASSERT_TRUE(m_scriptEngine->executeScript("cart:/snap.nut"));
+  std::vector<u8> blob;
+  ASSERT_TRUE(m_scriptEngine->saveSnapshot(blob).ok());
+
+  auto score = [this]() {
+    HSQUIRRELVM vm = m_scriptEngine->getVm();
+    SQInteger value = -1;
+    sq_pushroottable(vm);
+    sq_pushstring(vm, "score", -1);
+    if (SQ_SUCCEEDED(sq_get(vm, -2)))
+      sq_getinteger(vm, -1, &value);
+    sq_settop(vm, 0);
+    return value;
+  };
+
+  ASSERT_TRUE(m_scriptEngine->callUpdate(1.0 / 60.0));
+  HSQUIRRELVM before = m_scriptEngine->getVm();
+
+  // Truncated blobs and blobs from another process (session id after the
+  // magic, format and version words) leave the running game as it was
+  std::vector<u8> bad(blob.begin(), blob.begin() + blob.size() / 2);
+  EXPECT_FALSE(m_scriptEngine->restoreSnapshot(bad.data(), bad.size()).ok());
+  bad = blob;
+  bad[12] ^= 0xff;
+  EXPECT_FALSE(m_scriptEngine->restoreSnapshot(bad.data(), bad.size()).ok());
+  EXPECT_EQ(m_scriptEngine->getVm(), before);
+  EXPECT_EQ(score(), 43);
+  ASSERT_TRUE(m_scriptEngine->callUpdate(1.0 / 60.0));
+  EXPECT_EQ(score(), 44);
+
+  // A good one replaces it
+  ASSERT_TRUE(m_scriptEngine->restoreSnapshot(blob.data(), blob.size()).ok());
+  EXPECT_EQ(score(), 42);
+  ASSERT_TRUE(m_scriptEngine->callUpdate(1.0 / 60.0));
+  EXPECT_EQ(score(), 43);
+}
+
+TEST_F(ScriptSafetyTest, SnapshotRefusedWhileNativeStoresHoldState) {
+  std::vector<u8> blob;
+  auto refused = [&](const std::string &code) {
+    EXPECT_TRUE(runScript(code)) << code;
+    Status status = m_scriptEngine->saveSnapshot(blob);
+    return status.code() == StatusCode::FailedPrecondition;
+  };
+
+  // None of these stores is part of the blob, and a restore empties them
+  EXPECT_TRUE(refused("::sheet <- sprites.sheet({image = 1, frameW = 8,"
+                      "                          frameH = 8, columns = 1});"));
+  EXPECT_TRUE(refused("sprites.create({sheet = ::sheet});"));
+  EXPECT_FALSE(refused("sprites.clear();"));
+  EXPECT_TRUE(refused("::e <- particles.emitter({});"));
+  EXPECT_FALSE(refused("particles.free(::e);"));
+  EXPECT_TRUE(refused("nav.setGrid(4, 4); ::r <- nav.request(0, 0, 3, 3);"));
+  EXPECT_FALSE(refused("nav.cancel(::r);"));
+  EXPECT_TRUE(refused("collide.update([0, 0, 4, 4]);"));
+}
+
+TEST_F(ScriptSafetyTest, EntryPointFollowsRootSlotWrites) {
+  {
+    std::ofstream out("/tmp/arcanee_test_cart/entry.nut");
+    out << "score <- 0;\n"
+           "function second(dt) { score += 10; }\n"
+           "function update(dt) { score++; ::update = second; }\n";
+  }
+  ASSERT_TRUE(m_scriptEngine->executeScript("cart:/entry.nut"));
+  auto score = [this]() {
+    HSQUIRRELVM vm = m_scriptEngine->getVm();
+    SQInteger value = -1;
+    sq_pushroottable(vm);
+    sq_pushstring(vm, "score", -1);
+    if (SQ_SUCCEEDED(sq_get(vm, -2)))
+      sq_getinteger(vm, -1, &value);
+    sq_settop(vm, 0);
+    return value;
+  };
+
+  // Reassigned from inside update(), from the host, then removed
+  ASSERT_TRUE(m_scriptEngine->callUpdate(1.0 / 60.0));
+  ASSERT_TRUE(m_scriptEngine->callUpdate(1.0 / 60.0));
+  EXPECT_EQ(score(), 11);
+  ASSERT_TRUE(runScript("::update = function(dt) { score += 100; }"));
+  ASSERT_TRUE(m_scriptEngine->callUpdate(1.0 / 60.0));
+  EXPECT_EQ(score(), 111);
+  ASSERT_TRUE(runScript("delete ::update;"));
+  EXPECT_FALSE(m_scriptEngine->callUpdate(1.0 / 60.0));
+  EXPECT_EQ(score(), 111);
+}
+
+TEST_F(ScriptSafetyTest, ReloadRebindsChangedModulesInPlace) {
+  auto writeModule = [](int version, const std::string &extra) {
+    std::ofstream out("/tmp/arcanee_test_cart/reload_mod.nut");
+    out << "class Enemy { function speed() { return " << version
+        << "; } }\n"
+           "return { Enemy = Enemy, count = 0,\n"
+           "  tick = function() { this.count++; return "
+        << version << "; }" << extra << " };\n";
+  };
+  writeModule(1, "");
+  ASSERT_TRUE(runScript("::M <- require(\"reload_mod.nut\");"
+                        "::e <- M.Enemy(); M.count = 5;"));
+
+  // Only required files reload in place; the Runtime restarts for others
+  EXPECT_TRUE(m_scriptEngine->isModuleLoaded("cart:/reload_mod.nut"));
+  EXPECT_FALSE(m_scriptEngine->isModuleLoaded("cart:/main.nut"));
+
+  // Unchanged: nothing re-runs
+  script::ScriptEngine::ReloadStats stats;
+  EXPECT_TRUE(m_scriptEngine->reloadModules(&stats).ok());
+  EXPECT_EQ(stats.checked, 1u);
+  EXPECT_EQ(stats.reloaded, 0u);
+
+  // New code, old data, same objects
+  writeModule(2, ", extra = 7");
+  EXPECT_TRUE(m_scriptEngine->reloadModules(&stats).ok());
+  EXPECT_EQ(stats.reloaded, 1u);
+  EXPECT_TRUE(runScript("assert(M.tick() == 2 && M.count == 6);"
+                        "assert(e.speed() == 2 && M.extra == 7);"
+                        "assert(require(\"reload_mod.nut\") == M);"));
+
+  // A module that does not compile keeps its old exports
+  {
+    std::ofstream out("/tmp/arcanee_test_cart/reload_mod.nut");
+    out << "return { tick = function() { ";
+  }
+  EXPECT_FALSE(m_scriptEngine->reloadModules(&stats).ok());
+  EXPECT_EQ(stats.failed, 1u);
+  EXPECT_TRUE(runScript("assert(M.tick() == 2);"));
+
+  // onReload migrates the data itself
+  writeModule(3, ", onReload = function(old) { count = old.count * 10; }");
+  EXPECT_TRUE(m_scriptEngine->reloadModules(&stats).ok());
+  EXPECT_TRUE(runScript("assert(M.count == 70 && M.tick() == 3);"
+                        "assert(e.speed() == 3);"));
+}
@@ -0,0 +1,262 @@
+#include "ScriptTestVm.h"
+#include "render/SpriteStore.h"
+#include "script/api/SpriteBinding.h"
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <vector>
+
+using arcanee::f32;
+using arcanee::u32;
+using arcanee::render::Canvas2D;
+using arcanee::render::SpriteSheet;
+using arcanee::render::SpriteState;
+using arcanee::render::SpriteStore;
+
+namespace {
+
+u32 defineGrid(SpriteStore &store, u32 image = 1) {
+  SpriteSheet sheet;
+  sheet.image = image;
+  sheet.frameW = 16;
+  sheet.frameH = 8;
+  sheet.columns = 4;
+  sheet.originX = 8.0f;
+  sheet.originY = 4.0f;
+  return store.defineSheet(sheet);
+}
+
+SpriteState at(u32 sheet, f32 x, f32 y, arcanee::i32 layer = 0) {
+  SpriteState s;
+  s.sheet = sheet;
+  s.x = x;
+  s.y = y;
+  s.layer = layer;
+  return s;
+}
+
+std::vector<Canvas2D::ImageRect> drawList(SpriteStore &store) {
+  std::vector<Canvas2D::ImageRect> rects(store.count());
+  rects.resize(store.writeDrawList(rects.data()));
+  return rects;
+}
+
+} // namespace
+
+TEST(SpriteStoreTest, HandlesOutliveTheirSlot) {
+  SpriteStore store;
+  EXPECT_EQ(store.defineSheet(SpriteSheet{}), 0u);
+  u32 sheet = defineGrid(store);
+  ASSERT_NE(sheet, 0u);
+  EXPECT_EQ(store.create(at(sheet + 1, 0, 0)), 0u);
+
+  u32 a = store.create(at(sheet, 1, 2));
+  ASSERT_NE(a, 0u);
+  EXPECT_TRUE(store.destroy(a));
+  EXPECT_FALSE(store.alive(a));
+  EXPECT_FALSE(store.destroy(a));
+
+  // The slot is reused under a new generation
+  u32 b = store.create(at(sheet, 3, 4));
+  EXPECT_NE(a, b);
+  EXPECT_TRUE(store.alive(b));
+  EXPECT_FALSE(store.setPosition(a, 0, 0));
+  SpriteState s;
+  ASSERT_TRUE(store.getState(b, s));
+  EXPECT_EQ(s.x, 3.0f);
+}
+
+TEST(SpriteStoreTest, ClearNeverReissuesHandles) {
+  SpriteStore store;
+  u32 sheet = defineGrid(store);
+  u32 a = store.create(at(sheet, 1, 2));
+  ASSERT_NE(a, 0u);
+  store.clear();
+  EXPECT_EQ(store.count(), 0u);
+  EXPECT_EQ(store.sheetCount(), 0u);
+  EXPECT_EQ(store.getSheet(sheet), nullptr);
+
+  // Same slot, fresh generation; the old sheet id stays unknown
+  EXPECT_EQ(store.create(at(sheet, 0, 0)), 0u);
+  u32 newSheet = defineGrid(store);
+  EXPECT_NE(newSheet, sheet);
+  u32 b = store.create(at(newSheet, 3, 4));
+  ASSERT_NE(b, 0u);
+  EXPECT_NE(b, a);
+  EXPECT_FALSE(store.alive(a));
+  EXPECT_TRUE(store.alive(b));
+  EXPECT_EQ(drawList(store).size(), 1u);
+}
+
+TEST(SpriteStoreTest, HandlesSurviveManyReuses) {
+  SpriteStore store;
+  u32 sheet = defineGrid(store);
+  u32 first = store.create(at(sheet, 0, 0));
+  ASSERT_NE(first, 0u);
+
+  // Far more cycles than one slot has generations
+  std::set<u32> issued{first};
+  store.destroy(first);
+  for (int i = 0; i < 10000; ++i) {
+    u32 h = store.create(at(sheet, 0, 0));
+    ASSERT_NE(h, 0u);
+    EXPECT_TRUE(issued.insert(h).second);
+    EXPECT_FALSE(store.alive(first));
+    store.destroy(h);
+  }
+}
+
+TEST(SpriteStoreTest, RemovalKeepsOtherSprites) {
+  SpriteStore store;
+  u32 sheet = defineGrid(store);
+  std::vector<u32> handles;
+  for (u32 i = 0; i < 10; ++i)
+    handles.push_back(store.create(at(sheet, static_cast<f32>(i), 0)));
+  for (u32 i = 0; i < 10; i += 3)
+    ASSERT_TRUE(store.destroy(handles[i]));
+  EXPECT_EQ(store.count(), 6u);
+
+  for (u32 i = 0; i < 10; ++i) {
+    SpriteState s;
+    bool live = i % 3 != 0;
+    ASSERT_EQ(store.getState(handles[i], s), live);
+    if (live) {
+      EXPECT_EQ(s.x, static_cast<f32>(i));
+    }
+  }
+}
+
+TEST(SpriteStoreTest, StepIntegratesMotion) {
+  SpriteStore store;
+  u32 sheet = defineGrid(store);
+  SpriteState s = at(sheet, 10, 20);
+  s.vx = 4.0f;
+  s.ay = 2.0f;
+  u32 h = store.create(s);
+  store.step(0.5f);
+  store.step(0.5f);
+
+  ASSERT_TRUE(store.getState(h, s));
+  EXPECT_FLOAT_EQ(s.x, 14.0f);
+  EXPECT_FLOAT_EQ(s.vy, 2.0f);
+  // Semi-implicit Euler: moves with the updated velocity, (1 + 2) * 0.5
+  EXPECT_FLOAT_EQ(s.y, 21.5f);
+}
+
+TEST(SpriteStoreTest, AnimationsLoopOrStop) {
+  SpriteStore store;
+  u32 sheet = defineGrid(store);
+  u32 looped = store.create(at(sheet, 0, 0));
+  u32 once = store.create(at(sheet, 0, 0));
+  ASSERT_TRUE(store.play(looped, 4, 3, 10.0f, true));
+  ASSERT_TRUE(store.play(once, 4, 3, 10.0f, false));
+
+  const u32 expectedLoop[] = {4, 5, 6, 4, 5, 6, 4};
+  const u32 expectedOnce[] = {4, 5, 6, 6, 6, 6, 6};
+  for (u32 t = 0; t < 7; ++t) {
+    SpriteState a, b;
+    store.getState(looped, a);
+    store.getState(once, b);
+    EXPECT_EQ(a.frame, expectedLoop[t]) << "tick " << t;
+    EXPECT_EQ(b.frame, expectedOnce[t]) << "tick " << t;
+    store.step(0.1f + 1.0e-4f);
+  }
+  EXPECT_TRUE(store.playing(looped));
+  EXPECT_FALSE(store.playing(once));
+
+  // Setting a frame stops the animation
+  SpriteState s;
+  store.getState(looped, s);
+  s.frame = 0;
+  store.setState(looped, s);
+  EXPECT_FALSE(store.playing(looped));
+}
+
+TEST(SpriteStoreTest, DrawListIsSortedAndCut) {
+  SpriteStore store;
+  u32 sheetA = defineGrid(store, 7);
+  u32 sheetB = defineGrid(store, 3);
+  u32 top = store.create(at(sheetA, 100, 50, 2));
+  SpriteState s = at(sheetA, 10, 20, 1);
+  s.frame = 6; // Column 2, row 1
+  u32 a = store.create(s);
+  u32 b = store.create(at(sheetB, 30, 40, 1));
+  s = at(sheetB, 0, 0, 0);
+  s.visible = false;
+  store.create(s);
+
+  auto rects = drawList(store);
+  ASSERT_EQ(rects.size(), 3u);
+  // Layer 1 first, image 3 before image 7, then layer 2
+  EXPECT_EQ(rects[0].image, 3u);
+  EXPECT_EQ(rects[0].dx, 22.0f);
+  EXPECT_EQ(rects[1].image, 7u);
+  EXPECT_EQ(rects[1].sx, 32);
+  EXPECT_EQ(rects[1].sy, 8);
+  EXPECT_EQ(rects[1].sw, 16);
+  EXPECT_EQ(rects[1].sh, 8);
+  EXPECT_EQ(rects[1].dx, 2.0f);
+  EXPECT_EQ(rects[1].dy, 16.0f);
+  EXPECT_EQ(rects[2].dx, 92.0f);
+
+  // Layer changes re-sort
+  store.getState(top, s);
+  s.layer = -1;
+  store.setState(top, s);
+  store.destroy(a);
+  store.destroy(b);
+  rects = drawList(store);
+  ASSERT_EQ(rects.size(), 1u);
+  EXPECT_EQ(rects[0].dx, 92.0f);
+}
+
+TEST(SpriteStoreTest, ScaleAndAlphaReachTheDrawList) {
+  SpriteStore store;
+  u32 sheet = defineGrid(store);
+  u32 h = store.create(at(sheet, 100, 50));
+  ASSERT_TRUE(store.setProperty(h, arcanee::render::SpriteProperty::Scale,
+                                2.0f));
+  ASSERT_TRUE(store.setProperty(h, arcanee::render::SpriteProperty::Alpha,
+                                0.25f));
+
+  auto rects = drawList(store);
+  ASSERT_EQ(rects.size(), 1u);
+  // Scaled about the origin (8, 4)
+  EXPECT_EQ(rects[0].dx, 84.0f);
+  EXPECT_EQ(rects[0].dy, 42.0f);
+  EXPECT_EQ(rects[0].dw, 32.0f);
+  EXPECT_EQ(rects[0].dh, 16.0f);
+  EXPECT_EQ(rects[0].alpha, 0.25f);
+
+  // Fully transparent sprites are not drawn
+  store.setProperty(h, arcanee::render::SpriteProperty::Alpha, 0.0f);
+  EXPECT_TRUE(drawList(store).empty());
+}
+
+TEST(SpriteBindingTest, ScriptsDriveSprites) {
+  using namespace arcanee::script;
+  SpriteStore store;
+  test::ScriptTestVm script;
+  registerSpriteBinding(script.vm(), &store);
+
+  const std::string code =
+      "local sheet = sprites.sheet({image = 1, frameW = 16, frameH = 16,"
+      "                             columns = 8});"
+      "local h = sprites.create({sheet = sheet, x = 5, vx = 10, layer = -2});"
+      "assert(sprites.count() == 1);"
+      "assert(sprites.setVel(h, 0, 3));"
+      "assert(sprites.play(h, 2, 4, 12));"
+      "local s = sprites.get(h);"
+      "assert(s.x == 5 && s.vy == 3 && s.layer == -2 && s.frame == 2);"
+      "assert(s.playing && s.visible);"
+      "assert(sprites.set(h, {visible = false}));"
+      "assert(!sprites.get(h).visible && sprites.get(h).x == 5);"
+      "assert(sprites.draw() == 0);"
+      "assert(sprites.create({sheet = sheet, speed = 1}) == null);"
+      "assert(t.getLastError().find(\"'speed'\") != null);"
+      "assert(sprites.create({sheet = 99}) == null);"
+      "assert(sprites.free(h) && !sprites.alive(h) && !sprites.free(h));"
+      "assert(sprites.get(h) == null);";
+  EXPECT_TRUE(script.run(code));
+  EXPECT_EQ(store.count(), 0u);
+}
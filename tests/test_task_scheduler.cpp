@@ -0,0 +1,153 @@
+#include "ScriptTestVm.h"
+#include "script/TaskScheduler.h"
+#include "script/api/TaskBinding.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace arcanee::script;
+
+namespace {
+
+class TaskSchedulerTest : public ::testing::Test,
+                          protected test::ScriptTestVm {
+protected:
+  void SetUp() override { registerTaskBinding(m_vm, &m_tasks); }
+
+  void TearDown() override { m_tasks.clear(m_vm); }
+
+  TaskScheduler m_tasks;
+};
+
+} // namespace
+
+TEST_F(TaskSchedulerTest, FunctionTaskRunsAcrossYields) {
+  ASSERT_TRUE(run("log <- [];"
+                  "f <- task.spawn(function() {"
+                  "  log.append(1); task.yield(); log.append(2); return 42;"
+                  "});"
+                  "::result <- log.len() + \" \" + f.status;"));
+  // Nothing runs until the scheduler does
+  EXPECT_EQ(resultString(), "0 pending");
+
+  EXPECT_EQ(m_tasks.run(m_vm, 1.0), 2u);
+  EXPECT_EQ(m_tasks.size(), 0u);
+  ASSERT_TRUE(run("::result <- f.status + \" \" + f.result + \" \" + "
+                  "log.len() + \" \" + f.done() + \" \" + typeof f;"));
+  EXPECT_EQ(resultString(), "done 42 2 true Task");
+}
+
+TEST_F(TaskSchedulerTest, BudgetSlicesLongWork) {
+  ASSERT_TRUE(run("steps <- 0;"
+                  "task.spawn(function() {"
+                  "  while (true) {"
+                  "    for (local i = 0; i < 1000; i++) {}"
+                  "    steps++; task.yield();"
+                  "  }"
+                  "});"));
+  arcanee::u32 resumed = m_tasks.run(m_vm, 0.002);
+  EXPECT_GT(resumed, 0u);
+  EXPECT_LT(m_tasks.getStats().lastSec, 0.1);
+  EXPECT_EQ(m_tasks.size(), 1u);
+
+  ASSERT_TRUE(run("::result <- steps;"));
+  EXPECT_EQ(resultString(), std::to_string(resumed));
+}
+
+TEST_F(TaskSchedulerTest, HigherPriorityRunsFirst) {
+  ASSERT_TRUE(run("log <- \"\";"
+                  "local work = function(tag) {"
+                  "  return function() {"
+                  "    for (local i = 0; i < 3; i++) { log += tag; "
+                  "task.yield(); }"
+                  "  }"
+                  "};"
+                  "task.spawn(work(\"l\"));"
+                  "task.spawn(work(\"h\"), 5);"
+                  "task.spawn(work(\"m\"), 1);"));
+  m_tasks.run(m_vm, 1.0);
+  ASSERT_TRUE(run("::result <- log;"));
+  EXPECT_EQ(resultString(), "hhhmmmlll");
+}
+
+TEST_F(TaskSchedulerTest, EqualPrioritiesTakeTurns) {
+  ASSERT_TRUE(run("log <- \"\";"
+                  "local work = function(tag) {"
+                  "  return function() {"
+                  "    for (local i = 0; i < 2; i++) { log += tag; "
+                  "task.yield(); }"
+                  "  }"
+                  "};"
+                  "task.spawn(work(\"a\"));"
+                  "task.spawn(work(\"b\"));"));
+  m_tasks.run(m_vm, 1.0);
+  ASSERT_TRUE(run("::result <- log;"));
+  EXPECT_EQ(resultString(), "abab");
+}
+
+TEST_F(TaskSchedulerTest, AwaitReturnsResultOrNull) {
+  ASSERT_TRUE(run("slow <- task.spawn(function() {"
+                  "  task.yield(); task.yield(); return 20;"
+                  "});"
+                  "bad <- task.spawn(function() { throw \"boom\"; });"
+                  "sum <- task.spawn(function() {"
+                  "  local a = task.await(slow);"
+                  "  local b = task.await(bad);"
+                  "  return a + 1 + (b == null ? 0 : 100);"
+                  "}, 10);"));
+  m_tasks.run(m_vm, 1.0);
+  ASSERT_TRUE(run("::result <- sum.result + \" \" + bad.status + \" \" + "
+                  "bad.error;"));
+  EXPECT_EQ(resultString(), "21 failed boom");
+  EXPECT_EQ(m_tasks.getStats().failed, 1u);
+}
+
+TEST_F(TaskSchedulerTest, GeneratorTasksStepAndAwait) {
+  ASSERT_TRUE(run("log <- [];"
+                  "function gen(n) {"
+                  "  for (local i = 0; i < n; i++) { log.append(i); yield; }"
+                  "  yield task.spawn(function() { return 7; });"
+                  "  return \"end\";"
+                  "}"
+                  "g <- task.spawn(gen(3));"));
+  m_tasks.run(m_vm, 1.0);
+  ASSERT_TRUE(run("::result <- g.result + \" \" + log.len();"));
+  EXPECT_EQ(resultString(), "end 3");
+}
+
+TEST_F(TaskSchedulerTest, CancelStopsTaskAndReleasesAwaiters) {
+  ASSERT_TRUE(run("forever <- task.spawn(function() {"
+                  "  while (true) task.yield();"
+                  "});"
+                  "waiter <- task.spawn(function() {"
+                  "  return task.await(forever) == null ? \"null\" : \"x\";"
+                  "});"));
+  m_tasks.run(m_vm, 0.001);
+  EXPECT_EQ(m_tasks.size(), 2u);
+
+  ASSERT_TRUE(run("::result <- forever.cancel() + \" \" + forever.cancel();"));
+  EXPECT_EQ(resultString(), "true false");
+  m_tasks.run(m_vm, 1.0);
+  EXPECT_EQ(m_tasks.size(), 0u);
+  ASSERT_TRUE(run("::result <- forever.status + \" \" + waiter.result;"));
+  EXPECT_EQ(resultString(), "cancelled null");
+}
+
+TEST_F(TaskSchedulerTest, MisuseIsReported) {
+  // Outside a task nothing is suspended
+  ASSERT_TRUE(run("::result <- task.yield() + \" \" + t.getLastError();"));
+  EXPECT_EQ(resultString(),
+            "null task: yield and await only work inside a task");
+
+  ASSERT_TRUE(run("::result <- task.spawn(5);"));
+  EXPECT_EQ(resultString(), "null");
+  ASSERT_TRUE(run("::result <- t.getLastError();"));
+  EXPECT_EQ(resultString(),
+            "task.spawn: arg 1 must be a function or a generator");
+
+  ASSERT_TRUE(run("self <- task.spawn(function() {"
+                  "  return task.await(task.current()) == null;"
+                  "});"));
+  m_tasks.run(m_vm, 1.0);
+  ASSERT_TRUE(run("::result <- self.result;"));
+  EXPECT_EQ(resultString(), "true");
+}
@@ -0,0 +1,237 @@
+#include "ScriptTestVm.h"
+#include "anim/TweenSystem.h"
+#include "render/SpriteStore.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/SpriteBinding.h"
+#include "script/api/TweenBinding.h"
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+
+using arcanee::f32;
+using arcanee::u32;
+using arcanee::anim::Ease;
+using arcanee::anim::TweenSpec;
+using arcanee::anim::TweenSystem;
+using arcanee::anim::TweenTarget;
+using arcanee::render::SpriteProperty;
+using arcanee::render::SpriteSheet;
+using arcanee::render::SpriteState;
+using arcanee::render::SpriteStore;
+
+namespace {
+
+TweenSpec linear(f32 from, f32 to, f32 duration) {
+  TweenSpec spec;
+  spec.from = from;
+  spec.to = to;
+  spec.duration = duration;
+  return spec;
+}
+
+TweenTarget floatTarget(f32 *value) {
+  TweenTarget target;
+  target.value = value;
+  return target;
+}
+
+} // namespace
+
+TEST(TweenTest, EasesStartAtZeroAndEndAtOne) {
+  for (int e = 0; e <= static_cast<int>(Ease::BounceOut); ++e) {
+    Ease ease = static_cast<Ease>(e);
+    EXPECT_NEAR(arcanee::anim::evaluateEase(ease, 0.0f), 0.0f, 1e-3f) << e;
+    EXPECT_NEAR(arcanee::anim::evaluateEase(ease, 1.0f), 1.0f, 1e-3f) << e;
+  }
+  EXPECT_FLOAT_EQ(arcanee::anim::evaluateEase(Ease::QuadIn, 0.5f), 0.25f);
+  EXPECT_FLOAT_EQ(arcanee::anim::evaluateEase(Ease::CubicInOut, 0.5f), 0.5f);
+  // Back overshoots below zero early on
+  EXPECT_LT(arcanee::anim::evaluateEase(Ease::BackIn, 0.2f), 0.0f);
+}
+
+TEST(TweenTest, DelayRunAndFinish) {
+  TweenSystem tweens;
+  f32 value = -1.0f;
+  TweenSpec spec = linear(0.0f, 10.0f, 1.0f);
+  spec.delay = 0.5f;
+  u32 h = tweens.start(floatTarget(&value), spec);
+  ASSERT_NE(h, 0u);
+
+  tweens.step(0.25f, nullptr);
+  EXPECT_EQ(value, -1.0f); // Still delayed
+  tweens.step(0.5f, nullptr);
+  EXPECT_FLOAT_EQ(value, 2.5f);
+  EXPECT_TRUE(tweens.finished().empty());
+
+  tweens.step(1.0f, nullptr);
+  EXPECT_FLOAT_EQ(value, 10.0f);
+  EXPECT_FALSE(tweens.alive(h));
+  EXPECT_EQ(tweens.count(), 0u);
+  ASSERT_EQ(tweens.finished().size(), 1u);
+  EXPECT_EQ(tweens.finished()[0].handle, h);
+  EXPECT_TRUE(tweens.finished()[0].completed);
+}
+
+TEST(TweenTest, RepeatAndYoyo) {
+  TweenSystem tweens;
+  f32 repeated = 0.0f, yoyo = 0.0f, forever = 0.0f;
+  TweenSpec spec = linear(0.0f, 4.0f, 1.0f);
+  spec.repeat = 1;
+  tweens.start(floatTarget(&repeated), spec);
+  spec.yoyo = true;
+  tweens.start(floatTarget(&yoyo), spec);
+  spec.repeat = -1;
+  u32 endless = tweens.start(floatTarget(&forever), spec);
+
+  tweens.step(1.25f, nullptr);
+  EXPECT_FLOAT_EQ(repeated, 1.0f); // Second run from the start
+  EXPECT_FLOAT_EQ(yoyo, 3.0f);     // Second run back toward from
+  tweens.step(1.0f, nullptr);
+  EXPECT_FLOAT_EQ(repeated, 4.0f);
+  EXPECT_FLOAT_EQ(yoyo, 0.0f);
+  EXPECT_EQ(tweens.count(), 1u);
+
+  // Endless tweens keep going
+  for (int i = 0; i < 100; ++i)
+    tweens.step(0.5f, nullptr);
+  EXPECT_TRUE(tweens.alive(endless));
+  EXPECT_FLOAT_EQ(forever, 1.0f); // 52.25 s: a yoyo period of 2 s, at 0.25
+}
+
+TEST(TweenTest, SpriteTargetsAndLostSprites) {
+  SpriteStore sprites;
+  SpriteSheet sheet;
+  sheet.frameW = sheet.frameH = 8;
+  SpriteState state;
+  state.sheet = sprites.defineSheet(sheet);
+  state.x = 6.0f;
+  u32 sprite = sprites.create(state);
+
+  TweenSystem tweens;
+  TweenTarget target;
+  target.sprite = sprite;
+  TweenSpec spec = linear(0.0f, 10.0f, 2.0f);
+  spec.fromCurrent = true;
+  u32 moving = tweens.start(target, spec);
+  target.property = SpriteProperty::Alpha;
+  u32 fading = tweens.start(target, linear(1.0f, 0.0f, 4.0f));
+
+  tweens.step(1.0f, &sprites);
+  f32 x = 0.0f, alpha = 0.0f;
+  sprites.getProperty(sprite, SpriteProperty::X, x);
+  sprites.getProperty(sprite, SpriteProperty::Alpha, alpha);
+  EXPECT_FLOAT_EQ(x, 8.0f); // From its position at the start
+  EXPECT_FLOAT_EQ(alpha, 0.75f);
+
+  // A freed sprite ends its tweens without completing them
+  sprites.destroy(sprite);
+  tweens.step(1.0f, &sprites);
+  EXPECT_FALSE(tweens.alive(moving));
+  EXPECT_FALSE(tweens.alive(fading));
+  ASSERT_EQ(tweens.finished().size(), 2u);
+  EXPECT_FALSE(tweens.finished()[0].completed);
+  EXPECT_FALSE(tweens.finished()[1].completed);
+}
+
+TEST(TweenTest, CancelledHandlesStayDead) {
+  TweenSystem tweens;
+  f32 a = 0.0f, b = 0.0f;
+  EXPECT_EQ(tweens.start(TweenTarget(), linear(0, 1, 1)), 0u);
+  u32 first = tweens.start(floatTarget(&a), linear(0, 1, 1));
+  u32 second = tweens.start(floatTarget(&b), linear(0, 8, 1));
+  EXPECT_TRUE(tweens.cancel(first));
+  EXPECT_FALSE(tweens.cancel(first));
+
+  // The slot is reused under a new generation
+  u32 third = tweens.start(floatTarget(&a), linear(0, 2, 1));
+  EXPECT_NE(third, first);
+  EXPECT_FALSE(tweens.alive(first));
+  tweens.step(0.5f, nullptr);
+  EXPECT_FLOAT_EQ(a, 1.0f);
+  EXPECT_FLOAT_EQ(b, 4.0f);
+  EXPECT_TRUE(tweens.alive(second));
+  EXPECT_TRUE(tweens.finished().empty());
+}
+
+TEST(TweenTest, ClearNeverReissuesHandles) {
+  TweenSystem tweens;
+  f32 a = 0.0f;
+  u32 first = tweens.start(floatTarget(&a), linear(0, 1, 1));
+  tweens.clear();
+  EXPECT_EQ(tweens.count(), 0u);
+  EXPECT_FALSE(tweens.alive(first));
+
+  u32 second = tweens.start(floatTarget(&a), linear(0, 2, 1));
+  EXPECT_NE(second, first);
+  EXPECT_FALSE(tweens.alive(first));
+  EXPECT_FALSE(tweens.cancel(first));
+  EXPECT_TRUE(tweens.alive(second));
+}
+
+TEST(TweenTest, HandlesSurviveManyReuses) {
+  TweenSystem tweens;
+  f32 a = 0.0f;
+  u32 first = tweens.start(floatTarget(&a), linear(0, 1, 1));
+  std::set<u32> issued{first};
+  tweens.cancel(first);
+
+  // Far more cycles than one slot has generations
+  for (int i = 0; i < 10000; ++i) {
+    u32 h = tweens.start(floatTarget(&a), linear(0, 1, 1));
+    ASSERT_NE(h, 0u);
+    EXPECT_TRUE(issued.insert(h).second);
+    EXPECT_FALSE(tweens.alive(first));
+    tweens.cancel(h);
+  }
+}
+
+TEST(TweenBindingTest, ScriptsStartTweensAndGetCallbacks) {
+  using namespace arcanee::script;
+  SpriteStore sprites;
+  TweenSystem tweens;
+  test::ScriptTestVm script;
+  HSQUIRRELVM vm = script.vm();
+  registerBufferBinding(vm);
+  registerSpriteBinding(vm, &sprites);
+  registerTweenBinding(vm, &tweens, &sprites);
+
+  EXPECT_TRUE(script.run(
+      "::done <- [];"
+      "::values <- buf.float32(2);"
+      "local sheet = sprites.sheet({image = 1, frameW = 8, frameH = 8,"
+      "                             columns = 1});"
+      "::hero <- sprites.create({sheet = sheet, x = 2});"
+      "::fade <- tweens.start({buffer = values, index = 1, from = 1, to = 0,"
+      "  duration = 1, ease = \"quadOut\","
+      "  onDone = function(h) { done.append(h); }});"
+      "::steps <- tweens.sequence(["
+      "  {sprite = hero, property = \"x\", to = 10, duration = 1},"
+      "  {sprite = hero, property = \"x\", to = 0, duration = 1,"
+      "   onDone = function(h) { done.append(h); }}]);"
+      "assert(steps.len() == 2 && tweens.count() == 3);"
+      "assert(tweens.start({buffer = values, to = 1, speed = 2}) == null);"
+      "assert(t.getLastError().find(\"'speed'\") != null);"
+      "assert(tweens.start({buffer = values, index = 2, to = 1}) == null);"
+      "assert(tweens.start({sprite = hero, to = 1, ease = \"wobble\"})"
+      "       == null);"
+      "local cancelled = tweens.start({buffer = values, to = 5,"
+      "  duration = 1, onDone = function(h) { done.append(-1); }});"
+      "assert(tweens.cancel(cancelled) && !tweens.alive(cancelled));"));
+
+  tweens.step(1.0f, &sprites);
+  finishTweens(vm);
+  EXPECT_TRUE(
+      script.run("assert(done.len() == 1 && done[0] == fade);"
+                 "assert(values[1] == 0 && sprites.get(hero).x == 10);"));
+
+  tweens.step(0.5f, &sprites);
+  finishTweens(vm);
+  EXPECT_TRUE(
+      script.run("assert(done.len() == 1 && sprites.get(hero).x == 5);"));
+  tweens.step(0.5f, &sprites);
+  finishTweens(vm);
+  EXPECT_TRUE(
+      script.run("assert(done.len() == 2 && done[1] == steps[1]);"
+                 "assert(sprites.get(hero).x == 0 && tweens.count() == 0);"
+                 "tweens.clear();"));
+}
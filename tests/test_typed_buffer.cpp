@@ -0,0 +1,117 @@
+#include "ScriptTestVm.h"
+#include "script/api/BufferBinding.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace arcanee::script;
+
+namespace {
+
+// Sums any buffer from native code, reading the storage in place
+SQInteger t_sum(HSQUIRRELVM vm) {
+  BufferView buf;
+  if (!getBuffer(vm, 2, buf))
+    return bindingTypeError(vm, 1, "a buffer");
+  SQFloat sum = 0;
+  for (SQInteger i = 0; i < buf.length; ++i) {
+    switch (buf.type) {
+    case BufferType::Float32:
+      sum += buf.floats()[i];
+      break;
+    case BufferType::Int32:
+      sum += static_cast<SQFloat>(buf.ints()[i]);
+      break;
+    default:
+      sum += buf.bytes()[i];
+      break;
+    }
+  }
+  sq_pushfloat(vm, sum);
+  return 1;
+}
+
+// Native producer: 0, 1, 2, ... as Int32
+SQInteger t_iota(HSQUIRRELVM vm) {
+  SQInteger n;
+  sq_getinteger(vm, 2, &n);
+  auto *data =
+      static_cast<arcanee::i32 *>(pushBuffer(vm, BufferType::Int32, n));
+  for (SQInteger i = 0; i < n; ++i)
+    data[i] = static_cast<arcanee::i32>(i);
+  return 1;
+}
+
+constexpr NativeFunction kTestFunctions[] = {
+    {"sum", t_sum},
+    {"iota", t_iota},
+    {"getLastError", sys_getLastError},
+};
+
+// Replaces the shared "t" table, so it carries getLastError too
+class TypedBufferTest : public ::testing::Test, protected test::ScriptTestVm {
+protected:
+  void SetUp() override {
+    registerBufferBinding(m_vm);
+    BindTable(m_vm, "t", kTestFunctions);
+  }
+};
+
+} // namespace
+
+TEST_F(TypedBufferTest, IndexedAccessConvertsToElementType) {
+  ASSERT_TRUE(run("local b = buf.float32(4); b[1] = 2.5; b[3] = 1;"
+                  "::result <- b[0] + b[1] + b[3];"));
+  EXPECT_FLOAT_EQ(resultFloat(), 3.5f);
+
+  ASSERT_TRUE(run("local b = buf.int32(2); b[0] = 7.9; ::result <- b[0];"));
+  EXPECT_FLOAT_EQ(resultFloat(), 7.0f);
+
+  // Byte stores wrap
+  ASSERT_TRUE(run("local b = buf.bytes(1); b[0] = 257; ::result <- b[0];"));
+  EXPECT_FLOAT_EQ(resultFloat(), 1.0f);
+}
+
+TEST_F(TypedBufferTest, OutOfRangeIndexIsAnError) {
+  EXPECT_FALSE(run("local b = buf.int32(2); b[2] = 1;"));
+  EXPECT_FALSE(run("local b = buf.int32(2); local x = b[-1];"));
+  EXPECT_FALSE(run("local b = buf.int32(2); b[0] = \"x\";"));
+}
+
+TEST_F(TypedBufferTest, TypeofLenAndForeach) {
+  ASSERT_TRUE(run("::result <- typeof buf.float32(0) + typeof buf.int32(0) +"
+                  " typeof buf.bytes(0);"));
+  EXPECT_EQ(resultString(), "Float32BufferInt32BufferByteBuffer");
+
+  ASSERT_TRUE(run("local b = buf.int32([1, 2, 3, 4]); local s = 0;"
+                  "foreach (i, v in b) s += i * v;"
+                  "::result <- (s + b.len()).tofloat();"));
+  EXPECT_FLOAT_EQ(resultFloat(), 24.0f); // 0+2+6+12 + 4
+}
+
+TEST_F(TypedBufferTest, FillSliceAndCopyFrom) {
+  ASSERT_TRUE(run("local b = buf.float32(6).fill(2).fill(5, 4);"
+                  "::result <- t.sum(b);"));
+  EXPECT_FLOAT_EQ(resultFloat(), 18.0f); // 2*4 + 5*2
+
+  // Slices are copies
+  ASSERT_TRUE(run("local b = buf.int32([1, 2, 3, 4, 5]);"
+                  "local s = b.slice(1, -1); s[0] = 100;"
+                  " ::result <- t.sum(s) + b[1] * 1000;"));
+  EXPECT_FLOAT_EQ(resultFloat(), 2107.0f); // 100+3+4 + 2000
+
+  ASSERT_TRUE(run("local b = buf.bytes(4).copyFrom([9, 9, 9], 2);"
+                  "b.copyFrom(buf.bytes([1]));"
+                  "::result <- t.sum(b);"));
+  EXPECT_FLOAT_EQ(resultFloat(), 19.0f); // 1,0,9,9
+}
+
+TEST_F(TypedBufferTest, NativesShareStorageWithScripts) {
+  ASSERT_TRUE(run("local b = t.iota(100); b[0] = 1000;"
+                  "::result <- t.sum(b);"));
+  EXPECT_FLOAT_EQ(resultFloat(), 5950.0f); // 4950 + 1000
+
+  // A mismatched copy is rejected without touching the target
+  ASSERT_TRUE(run("local b = buf.int32([3]); b.copyFrom(buf.float32([1]));"
+                  "::result <- t.getLastError();"));
+  EXPECT_EQ(resultString(), "buffer.copyFrom: arg 1 must be Int32Buffer");
+}
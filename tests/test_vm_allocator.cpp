@@ -0,0 +1,131 @@
+#include "script/VmAllocator.h"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace arcanee::script;
+
+TEST(VmAllocatorTest, TracksExactBytes) {
+  VmAllocator arena;
+
+  void *a = arena.allocate(24);
+  void *b = arena.allocate(1000); // Large block
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_EQ(arena.getStats().bytesInUse, 1024u);
+
+  arena.deallocate(a, 24);
+  EXPECT_EQ(arena.getStats().bytesInUse, 1000u);
+  arena.deallocate(b, 1000);
+  EXPECT_EQ(arena.getStats().bytesInUse, 0u);
+  EXPECT_EQ(arena.getStats().peakBytes, 1024u);
+}
+
+TEST(VmAllocatorTest, ReusesFreedBlocks) {
+  VmAllocator arena;
+
+  void *a = arena.allocate(40);
+  arena.deallocate(a, 40);
+  void *b = arena.allocate(48); // Same 16-byte size class
+  EXPECT_EQ(a, b);
+  arena.deallocate(b, 48);
+}
+
+TEST(VmAllocatorTest, ReallocPreservesContents) {
+  VmAllocator arena;
+
+  auto *p = static_cast<unsigned char *>(arena.allocate(16));
+  for (int i = 0; i < 16; ++i)
+    p[i] = static_cast<unsigned char>(i);
+
+  // Small -> small (different class) -> large -> large
+  p = static_cast<unsigned char *>(arena.reallocate(p, 16, 200));
+  p = static_cast<unsigned char *>(arena.reallocate(p, 200, 4096));
+  p = static_cast<unsigned char *>(arena.reallocate(p, 4096, 16384));
+  for (int i = 0; i < 16; ++i)
+    EXPECT_EQ(p[i], i);
+  EXPECT_EQ(arena.getStats().bytesInUse, 16384u);
+
+  arena.deallocate(p, 16384);
+  EXPECT_EQ(arena.getStats().bytesInUse, 0u);
+}
+
+TEST(VmAllocatorTest, HooksRouteToScopedArena) {
+  VmAllocator arena;
+  void *p = nullptr;
+  {
+    VmAllocator::Scope scope(&arena);
+    EXPECT_EQ(VmAllocator::current(), &arena);
+    p = VmAllocator::vmMalloc(64);
+  }
+  EXPECT_NE(VmAllocator::current(), &arena);
+  EXPECT_EQ(arena.getStats().bytesInUse, 64u);
+
+  // Freed outside the scope: still returned to its owner
+  VmAllocator::vmFree(p, 64);
+  EXPECT_EQ(arena.getStats().bytesInUse, 0u);
+}
+
+TEST(VmAllocatorTest, CapsAreReported) {
+  VmAllocator arena;
+  arena.setCaps(1024, 4096);
+
+  void *a = arena.allocate(512);
+  EXPECT_FALSE(arena.isOverSoftCap());
+  void *b = arena.allocate(1024);
+  EXPECT_TRUE(arena.isOverSoftCap());
+  EXPECT_FALSE(arena.isOverHardCap());
+
+  void *c = arena.allocate(8192);
+  ASSERT_NE(c, nullptr); // Hard cap never returns null
+  EXPECT_TRUE(arena.isOverHardCap());
+
+  // The hard cap fault stays latched even after memory is freed
+  arena.deallocate(c, 8192);
+  EXPECT_TRUE(arena.isOverHardCap());
+
+  arena.deallocate(a, 512);
+  arena.deallocate(b, 1024);
+  EXPECT_FALSE(arena.isOverSoftCap());
+}
+
+TEST(VmAllocatorTest, HardCapHandlerFiresWhileOverCap) {
+  VmAllocator arena;
+  arena.setCaps(0, 4096);
+  int calls = 0;
+  arena.setHardCapHandler([](void *user) { ++*static_cast<int *>(user); },
+                          &calls);
+
+  EXPECT_TRUE(arena.fitsHardCap(4096));
+  EXPECT_FALSE(arena.fitsHardCap(4097));
+
+  void *a = arena.allocate(4000);
+  EXPECT_EQ(calls, 0);
+  EXPECT_FALSE(arena.fitsHardCap(512));
+
+  void *b = arena.allocate(512); // Crosses the cap
+  EXPECT_EQ(calls, 1);
+  void *c = arena.allocate(16); // Still over: raised again
+  EXPECT_EQ(calls, 2);
+
+  arena.deallocate(c, 16); // Frees never raise
+  arena.deallocate(b, 512);
+  EXPECT_EQ(calls, 2);
+  void *d = arena.allocate(16); // Back under the cap
+  EXPECT_EQ(calls, 2);
+
+  arena.deallocate(d, 16);
+  arena.deallocate(a, 4000);
+}
+
+TEST(VmAllocatorTest, ReleaseAllDropsEverything) {
+  VmAllocator arena;
+  std::vector<void *> blocks;
+  for (int i = 0; i < 10000; ++i)
+    blocks.push_back(arena.allocate(static_cast<size_t>(8 + (i % 700))));
+  EXPECT_GT(arena.getStats().reservedBytes, 0u);
+
+  arena.releaseAll();
+  EXPECT_EQ(arena.getStats().bytesInUse, 0u);
+  EXPECT_EQ(arena.getStats().reservedBytes, 0u);
+}
@@ -0,0 +1,165 @@
+#include "ScriptTestVm.h"
+#include "script/VmSnapshot.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/MathBinding.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace arcanee::script;
+
+namespace {
+
+// Saves from m_a and restores into m_b; both are set up identically so their
+// baselines match
+class VmSnapshotTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    registerApi(m_a.vm(), m_baseA);
+    registerApi(m_b.vm(), m_baseB);
+  }
+
+  void TearDown() override {
+    m_baseA.release(m_a.vm());
+    m_baseB.release(m_b.vm());
+  }
+
+  static void registerApi(HSQUIRRELVM vm, SnapshotBaseline &baseline) {
+    registerBufferBinding(vm);
+    registerMathBinding(vm);
+    baseline.capture(vm);
+  }
+
+  // Snapshot m_a into m_b
+  void transfer() {
+    std::vector<arcanee::u8> blob;
+    SnapshotRoots roots;
+    ASSERT_TRUE(saveVmSnapshot(m_a.vm(), m_baseA, roots, blob).ok());
+    arcanee::Status status =
+        loadVmSnapshot(m_b.vm(), m_baseB, blob.data(), blob.size(), roots);
+    ASSERT_TRUE(status.ok()) << status.toString();
+  }
+
+  SnapshotBaseline m_baseA;
+  SnapshotBaseline m_baseB;
+  test::ScriptTestVm m_a;
+  test::ScriptTestVm m_b;
+};
+
+} // namespace
+
+TEST_F(VmSnapshotTest, DataSharingAndCyclesSurvive) {
+  ASSERT_TRUE(m_a.run("player <- {x = 1.5, name = \"p1\", tags = [1, 2]};"
+                      "player.self <- player;"
+                      "party <- [player, player, null, true, -7];"
+                      "const LIMIT = 3;"));
+  transfer();
+
+  ASSERT_TRUE(m_b.run("party[0].x += 1;"
+                      "::result <- player.name + \" \" + party[1].x + "
+                      "\" \" + player.self.tags[1] + \" \" + "
+                      "(player.self == player) + \" \" + party[4];"));
+  EXPECT_EQ(m_b.resultString(), "p1 2.5 2 true -7");
+}
+
+TEST_F(VmSnapshotTest, ClosuresKeepSharedStateAndDefaults) {
+  ASSERT_TRUE(m_a.run("local n = 10;"
+                      "inc <- function(by = 2) { n += by; return n; };"
+                      "get <- function() { return n; };"
+                      "inc();"));
+  transfer();
+
+  // Both closures still see one counter
+  ASSERT_TRUE(m_b.run("inc(); inc(5); ::result <- get().tostring();"));
+  EXPECT_EQ(m_b.resultString(), "19");
+  ASSERT_TRUE(m_a.run("::result <- get().tostring();"));
+  EXPECT_EQ(m_a.resultString(), "12"); // The source VM is untouched
+}
+
+TEST_F(VmSnapshotTest, ClassesAndInstancesSurvive) {
+  ASSERT_TRUE(m_a.run("class Base { hp = 10; static count = 0;"
+                      "  constructor(h) { hp = h; Base.count++; }"
+                      "  function _add(o) { return Base(hp + o.hp); }"
+                      "  function _tostring() { return \"hp\" + hp; } }"
+                      "class Hero extends Base { name = \"h\";"
+                      "  function heal() { hp += 5; return this; } }"
+                      "hero <- Hero(3); hero.name = \"ann\";"
+                      "other <- Base(4);"));
+  transfer();
+
+  ASSERT_TRUE(m_b.run("local sum = hero.heal() + other;"
+                      "::result <- hero.name + \" \" + sum + \" \" + "
+                      "Base.count + \" \" + (hero instanceof Base) + "
+                      "\" \" + (Hero(1).getclass() == Hero);"));
+  EXPECT_EQ(m_b.resultString(), "ann hp12 3 true true");
+}
+
+TEST_F(VmSnapshotTest, BuffersAndMathValuesSurvive) {
+  ASSERT_TRUE(m_a.run("pos <- math.vec3(1, 2, 3);"
+                      "samples <- buf.float32(4); samples[2] = 0.5;"));
+  transfer();
+
+  ASSERT_TRUE(m_b.run("pos += math.vec3(1, 1, 1);"
+                      "::result <- pos.tostring() + \" \" + "
+                      "samples[2] + \" \" + samples.len();"));
+  EXPECT_EQ(m_b.resultString(), "vec3(2, 3, 4) 0.5 4");
+}
+
+TEST_F(VmSnapshotTest, NamedRootsRoundTrip) {
+  ASSERT_TRUE(m_a.run("::result <- {v = 42};"));
+  HSQOBJECT module;
+  sq_pushroottable(m_a.vm());
+  sq_pushstring(m_a.vm(), "result", -1);
+  ASSERT_TRUE(SQ_SUCCEEDED(sq_rawdeleteslot(m_a.vm(), -2, SQTrue)));
+  sq_getstackobj(m_a.vm(), -1, &module);
+  sq_addref(m_a.vm(), &module);
+  sq_settop(m_a.vm(), 0);
+
+  std::vector<arcanee::u8> blob;
+  SnapshotRoots roots = {{"mod.nut", module}};
+  ASSERT_TRUE(saveVmSnapshot(m_a.vm(), m_baseA, roots, blob).ok());
+  sq_release(m_a.vm(), &module);
+
+  SnapshotRoots restored;
+  ASSERT_TRUE(loadVmSnapshot(m_b.vm(), m_baseB, blob.data(), blob.size(),
+                             restored)
+                  .ok());
+  ASSERT_EQ(restored.size(), 1u);
+  EXPECT_EQ(restored[0].first, "mod.nut");
+  sq_pushobject(m_b.vm(), restored[0].second);
+  sq_pushstring(m_b.vm(), "v", -1);
+  ASSERT_TRUE(SQ_SUCCEEDED(sq_get(m_b.vm(), -2)));
+  SQInteger v = 0;
+  sq_getinteger(m_b.vm(), -1, &v);
+  EXPECT_EQ(v, 42);
+  sq_settop(m_b.vm(), 0);
+  sq_release(m_b.vm(), &restored[0].second);
+}
+
+TEST_F(VmSnapshotTest, UnsupportedStateIsRejected) {
+  ASSERT_TRUE(m_a.run("function gen() { yield 1; }"
+                      "state <- {g = gen()};"));
+  std::vector<arcanee::u8> blob;
+  arcanee::Status status = saveVmSnapshot(m_a.vm(), m_baseA, {}, blob);
+  EXPECT_EQ(status.code(), arcanee::StatusCode::InvalidArgument);
+  EXPECT_NE(status.message().find("'g'"), std::string::npos);
+}
+
+TEST_F(VmSnapshotTest, MismatchedOrCorruptBlobsAreRejected) {
+  ASSERT_TRUE(m_a.run("data <- [1, 2, 3];"));
+  std::vector<arcanee::u8> blob;
+  ASSERT_TRUE(saveVmSnapshot(m_a.vm(), m_baseA, {}, blob).ok());
+
+  // A VM with a different API cannot resolve the baseline positions
+  SnapshotBaseline bare;
+  HSQUIRRELVM vm = sq_open(1024);
+  bare.capture(vm);
+  SnapshotRoots roots;
+  EXPECT_FALSE(loadVmSnapshot(vm, bare, blob.data(), blob.size(), roots).ok());
+  bare.release(vm);
+  sq_close(vm);
+
+  blob.resize(blob.size() / 2);
+  EXPECT_FALSE(
+      loadVmSnapshot(m_b.vm(), m_baseB, blob.data(), blob.size(), roots).ok());
+}
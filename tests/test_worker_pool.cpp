@@ -0,0 +1,289 @@
+#include "ScriptTestVm.h"
+#include "script/ScriptWatchdog.h"
+#include "script/ValueCodec.h"
+#include "script/WorkerPool.h"
+#include "script/api/BufferBinding.h"
+#include "script/api/JobBinding.h"
+#include "script/api/MathBinding.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace arcanee::script;
+
+namespace {
+
+constexpr arcanee::u64 kBudget = 1024 * 1024;
+
+// Drives jobs.* from a cart-like VM; job modules come from m_modules
+class WorkerPoolTest : public ::testing::Test, protected test::ScriptTestVm {
+protected:
+  void SetUp() override {
+    registerBufferBinding(m_vm);
+    registerMathBinding(m_vm);
+  }
+
+  void TearDown() override { m_pool.reset(); }
+
+  void startPool(arcanee::u32 workers, arcanee::f64 timeoutSec = 5.0,
+                 arcanee::u64 memoryCap = 32ull * 1024 * 1024) {
+    WorkerPoolConfig config;
+    config.workers = workers;
+    config.jobTimeoutSec = timeoutSec;
+    config.memoryCapBytes = memoryCap;
+    m_pool = std::make_unique<WorkerPool>(
+        [this](const std::string &module)
+            -> arcanee::StatusOr<std::string> {
+          auto it = m_modules.find(module);
+          if (it == m_modules.end())
+            return arcanee::Status::NotFound("no module " + module);
+          return it->second;
+        },
+        config);
+    registerJobBinding(m_vm, m_pool.get());
+  }
+
+  std::map<std::string, std::string> m_modules;
+  std::unique_ptr<WorkerPool> m_pool;
+};
+
+} // namespace
+
+TEST_F(WorkerPoolTest, CodecRoundTripsPlainData) {
+  ASSERT_TRUE(run("local b = buf.int32(3); b[1] = -300;"
+                  "value <- {n = null, f = false, i = -5, x = 0.25,"
+                  "  s = \"hi\", list = [1, [2, \"deep\"]], 7 = \"seven\","
+                  "  buf = b, v = math.vec2(3, 4)};"));
+  sq_pushroottable(m_vm);
+  sq_pushstring(m_vm, "value", -1);
+  ASSERT_TRUE(SQ_SUCCEEDED(sq_get(m_vm, -2)));
+  std::vector<arcanee::u8> bytes;
+  ASSERT_TRUE(encodeValue(m_vm, -1, bytes, kBudget).ok());
+  sq_settop(m_vm, 0);
+
+  sq_pushroottable(m_vm);
+  sq_pushstring(m_vm, "copy", -1);
+  arcanee::ByteReader reader(bytes.data(), bytes.size());
+  ASSERT_TRUE(decodeValue(m_vm, reader).ok());
+  sq_newslot(m_vm, -3, SQFalse);
+  sq_settop(m_vm, 0);
+
+  ASSERT_TRUE(run("::result <- (copy != value) + \" \" + copy.n + \" \" + "
+                  "copy.f + \" \" + copy.i + \" \" + copy.x + \" \" + "
+                  "copy.s + \" \" + copy.list[1][1] + \" \" + copy[7] + "
+                  "\" \" + copy.buf[1] + \" \" + copy.v.len();"));
+  EXPECT_EQ(resultString(), "true null false -5 0.25 hi deep seven -300 5");
+
+  // Truncated input pushes nothing
+  arcanee::ByteReader cut(bytes.data(), bytes.size() / 2);
+  EXPECT_EQ(decodeValue(m_vm, cut).code(), arcanee::StatusCode::DataLoss);
+  EXPECT_EQ(sq_gettop(m_vm), 0);
+}
+
+TEST_F(WorkerPoolTest, CodecReservesStackPerLevel) {
+  // A VM with a tiny stack: every level has to reserve its own slots
+  reopen(16);
+  ASSERT_TRUE(run("deep <- [0]; local a = deep;"
+                  "for (local i = 1; i < 32; ++i) {"
+                  "  local b = [i]; a.append(b); a = b; }"));
+  sq_pushroottable(m_vm);
+  sq_pushstring(m_vm, "deep", -1);
+  ASSERT_TRUE(SQ_SUCCEEDED(sq_get(m_vm, -2)));
+  std::vector<arcanee::u8> bytes;
+  ASSERT_TRUE(encodeValue(m_vm, -1, bytes, kBudget).ok());
+  sq_settop(m_vm, 0);
+
+  sq_pushroottable(m_vm);
+  sq_pushstring(m_vm, "copy", -1);
+  arcanee::ByteReader reader(bytes.data(), bytes.size());
+  ASSERT_TRUE(decodeValue(m_vm, reader).ok());
+  sq_newslot(m_vm, -3, SQFalse);
+  sq_settop(m_vm, 0);
+
+  ASSERT_TRUE(run("local a = copy, n = 0;"
+                  "while (a.len() > 1) { a = a[1]; ++n; }"
+                  "::result <- n + \" \" + a[0];"));
+  EXPECT_EQ(resultString(), "31 31");
+}
+
+TEST_F(WorkerPoolTest, CodecRejectsCodeAndCycles) {
+  std::vector<arcanee::u8> bytes;
+  ASSERT_TRUE(run("fn <- [function() {}]; loop <- []; loop.append(loop);"));
+  for (const char *name : {"fn", "loop"}) {
+    sq_pushroottable(m_vm);
+    sq_pushstring(m_vm, name, -1);
+    ASSERT_TRUE(SQ_SUCCEEDED(sq_get(m_vm, -2)));
+    EXPECT_EQ(encodeValue(m_vm, -1, bytes, kBudget).code(),
+              arcanee::StatusCode::InvalidArgument)
+        << name;
+    EXPECT_TRUE(bytes.empty());
+    sq_settop(m_vm, 0);
+  }
+}
+
+TEST_F(WorkerPoolTest, ResultsArriveInSubmissionOrder) {
+  m_modules["sum.nut"] = "return function(list, scale) {"
+                         "  local s = 0;"
+                         "  foreach (v in list) s += v;"
+                         "  return {sum = s * scale, n = list.len()};"
+                         "}";
+  m_modules["slow.nut"] = "return function(n) {"
+                          "  local x = 0;"
+                          "  for (local i = 0; i < n; i++) x++;"
+                          "  return x;"
+                          "}";
+  startPool(3);
+
+  // The slow job goes first; faster ones behind it must wait their turn
+  ASSERT_TRUE(run("ids <- [jobs.submit(\"slow.nut\", 2000000)];"
+                  "for (local i = 1; i <= 5; i++)"
+                  "  ids.append(jobs.submit(\"sum.nut\", [i, i], 10));"
+                  "out <- \"\";"
+                  "for (local r = jobs.wait(); r != null; r = jobs.wait())"
+                  "  out += r.id + \":\" + (typeof r.result == \"table\" ?"
+                  "  r.result.sum : r.result) + \" \";"
+                  "::result <- ids.len() + \" \" + out + jobs.pending();"));
+  EXPECT_EQ(resultString(), "6 1:2000000 2:20 3:40 4:60 5:80 6:100 0");
+}
+
+TEST_F(WorkerPoolTest, WorkersKeepModuleStateDeterministically) {
+  m_modules["count.nut"] = "local n = 0;"
+                           "return function() { return ++n; }";
+  startPool(2);
+
+  // Job N runs on worker N % 2, so each worker's counter sees every other job
+  ASSERT_TRUE(run("for (local i = 0; i < 6; i++) jobs.submit(\"count.nut\");"
+                  "out <- \"\";"
+                  "for (local r = jobs.wait(); r != null; r = jobs.wait())"
+                  "  out += r.result;"
+                  "::result <- out + \" \" + jobs.workers();"));
+  EXPECT_EQ(resultString(), "112233 2");
+}
+
+TEST_F(WorkerPoolTest, ReloadedSourcesStartOver) {
+  m_modules["count.nut"] = "local n = 0;"
+                           "return function() { return ++n; }";
+  startPool(1);
+  const std::string twice = "jobs.submit(\"count.nut\");"
+                            "jobs.submit(\"count.nut\");"
+                            "::result <- jobs.wait().result + \" \" + "
+                            "jobs.wait().result;";
+
+  ASSERT_TRUE(run(twice));
+  EXPECT_EQ(resultString(), "1 2");
+
+  // Unchanged text keeps the module state
+  m_pool->reloadSources();
+  ASSERT_TRUE(run(twice));
+  EXPECT_EQ(resultString(), "3 4");
+
+  m_modules["count.nut"] = "local n = 100;"
+                           "return function() { return ++n; }";
+  m_pool->reloadSources();
+  ASSERT_TRUE(run(twice));
+  EXPECT_EQ(resultString(), "101 102");
+}
+
+TEST(WorkerPoolConfigTest, WorkerCountIsFixedPerCart) {
+  auto countFor = [](const WorkerPoolConfig &config) {
+    WorkerPool pool(
+        [](const std::string &) -> arcanee::StatusOr<std::string> {
+          return std::string();
+        },
+        config);
+    return pool.workerCount();
+  };
+
+  // The same on every machine, whatever its core count
+  WorkerPoolConfig config;
+  EXPECT_EQ(countFor(config), WorkerPoolConfig::kDefaultWorkers);
+  config.workers = 0;
+  EXPECT_EQ(countFor(config), 1u);
+  config.workers = 3;
+  EXPECT_EQ(countFor(config), 3u);
+  config.workers = 64;
+  EXPECT_EQ(countFor(config), WorkerPoolConfig::kMaxWorkers);
+}
+
+TEST_F(WorkerPoolTest, FailuresAreReported) {
+  m_modules["throw.nut"] = "return function() { throw \"boom\"; }";
+  m_modules["value.nut"] = "return 5;";
+  m_modules["io.nut"] = "return function() { return gfx; }";
+  m_modules["fn.nut"] = "return function() { return function() {}; }";
+  startPool(1);
+
+  ASSERT_TRUE(run("::result <- jobs.submit(\"missing.nut\") + \" \" + "
+                  "t.getLastError();"));
+  EXPECT_EQ(resultString(), "null jobs.submit: no module missing.nut");
+  ASSERT_TRUE(run("::result <- jobs.submit(\"throw.nut\", function() {});"));
+  EXPECT_EQ(resultString(), "null");
+
+  ASSERT_TRUE(run("foreach (m in [\"throw.nut\", \"value.nut\", \"io.nut\","
+                  "  \"fn.nut\"]) jobs.submit(m);"
+                  "out <- [];"
+                  "for (local r = jobs.wait(); r != null; r = jobs.wait())"
+                  "  out.append(r.ok + \" \" + r.error);"
+                  "::result <- out[0] + \"|\" + out[1] + \"|\" + out[2] + "
+                  "\"|\" + out[3];"));
+  EXPECT_EQ(resultString(),
+            "false boom|false value.nut must return a function|"
+            "false the index 'gfx' does not exist|"
+            "false cannot send a function");
+}
+
+TEST_F(WorkerPoolTest, ValuesStopAtTheByteBudget) {
+  m_modules["dag.nut"] = "return function() {"
+                         "  local a = [];"
+                         "  for (local i = 0; i < 30; ++i) a = [a, a];"
+                         "  return a;"
+                         "}";
+  startPool(1, 5.0, 4ull * 1024 * 1024);
+
+  ASSERT_TRUE(run("local a = [];"
+                  "for (local i = 0; i < 30; ++i) a = [a, a];"
+                  "::result <- jobs.submit(\"dag.nut\", a) + \" \" + "
+                  "t.getLastError();"));
+  EXPECT_EQ(resultString(), "null jobs.submit: cannot send value: larger "
+                            "than 4194304 bytes");
+  ASSERT_TRUE(run("jobs.submit(\"dag.nut\");"
+                  "::result <- jobs.wait().error;"));
+  EXPECT_EQ(resultString(), "cannot send value: larger than 4194304 bytes");
+}
+
+TEST_F(WorkerPoolTest, HungAndRunawayJobsAreStopped) {
+  m_modules["hang.nut"] = "return function() { while (true) {} }";
+  m_modules["grow.nut"] = "return function() {"
+                          "  local a = [];"
+                          "  for (local i = 0; i < 200000; i++)"
+                          "    a.append(\"x\" + i);"
+                          "  return a.len();"
+                          "}";
+  m_modules["ok.nut"] = "return function() { return \"alive\"; }";
+  startPool(1, 0.2, 4ull * 1024 * 1024);
+
+  ASSERT_TRUE(run("jobs.submit(\"hang.nut\"); jobs.submit(\"ok.nut\");"
+                  "::result <- jobs.wait().error + \" \" + "
+                  "jobs.wait().result;"));
+  EXPECT_EQ(resultString(), "job timed out alive");
+
+  // The worker VM is rebuilt after hitting its cap
+  ASSERT_TRUE(run("jobs.submit(\"grow.nut\"); jobs.submit(\"ok.nut\");"
+                  "::result <- jobs.wait().error + \" \" + "
+                  "jobs.wait().result;"));
+  EXPECT_EQ(resultString(), "worker memory cap exceeded alive");
+}
+
+TEST_F(WorkerPoolTest, WaitingYieldsToTheWatchdog) {
+  m_modules["hang.nut"] = "return function() { while (true) {} }";
+  startPool(1, 5.0);
+
+  // The cart's budget runs out long before the job's own timeout
+  ScriptWatchdog watchdog;
+  {
+    ScriptWatchdog::Scope scope(&watchdog, 0.1);
+    EXPECT_FALSE(run("jobs.submit(\"hang.nut\"); jobs.wait();"));
+  }
+  EXPECT_TRUE(watchdog.hasTripped());
+  EXPECT_EQ(m_pool->pending(), 1u);
+}